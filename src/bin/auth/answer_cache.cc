@@ -0,0 +1,416 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/answer_cache.h>
+
+#include <util/buffer.h>
+
+#include <dns/message.h>
+#include <dns/question.h>
+
+#include <boost/functional/hash.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cassert>
+
+using namespace std;
+using namespace isc::dns;
+using namespace isc::util;
+using isc::util::thread::Mutex;
+
+namespace isc {
+namespace auth {
+
+namespace {
+// Header field offsets in a wire-format DNS message
+const size_t HEADER_FLAGS_POS = 2;
+const size_t HEADER_LEN = 12;
+
+// The flags copied from the query to the response (see
+// Message::makeResponse())
+const uint16_t QUERY_FLAGS = (Message::HEADERFLAG_RD | Message::HEADERFLAG_CD);
+
+// Rough per-entry overhead of the containers, added to the memory usage
+// estimate
+const size_t ENTRY_OVERHEAD = 64;
+
+// num_shards_ and max_entries_ are changed by setMaxEntries() while other
+// threads may read them without holding any lock.  C++03 has no atomic
+// types, so the accesses go through these, which also act as full memory
+// barriers.
+inline size_t
+loadShared(const size_t& var) {
+    return (__sync_fetch_and_add(const_cast<size_t*>(&var), 0));
+}
+
+inline void
+storeShared(size_t& var, size_t value) {
+    __sync_synchronize();
+    var = value;
+    __sync_synchronize();
+}
+}
+
+const size_t AnswerCache::MIN_SHARDED_ENTRIES;
+const size_t AnswerCache::NUM_SHARDS;
+const size_t AnswerCache::NONE;
+
+AnswerCache::AnswerCache(size_t max_entries) :
+    shards_(new Shard[NUM_SHARDS]), num_shards_(1), max_entries_(0)
+{
+    setMaxEntries(max_entries);
+}
+
+bool
+AnswerCache::isEnabled() const {
+    return (loadShared(max_entries_) > 0);
+}
+
+void
+AnswerCache::setMaxEntries(size_t max_entries) {
+    // Lock all shards, so no other thread uses the cache while we
+    // redistribute the responses.
+    boost::scoped_ptr<Mutex::Locker> lockers[NUM_SHARDS];
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        lockers[i].reset(new Mutex::Locker(shards_[i].mutex));
+    }
+
+    const size_t num_shards = (max_entries >= MIN_SHARDED_ENTRIES) ?
+        NUM_SHARDS : 1;
+    // The name index of the old shards are kept here until the end, as
+    // the old slots refer to their entries.
+    vector<NameIndex> old_names(NUM_SHARDS);
+    vector<Slot> old_slots;
+    try {
+        // Take the responses out, starting from the clock hand of each
+        // shard, so the order of the next sweep is kept if they end up in
+        // the same shard.
+        for (size_t i = 0; i < num_shards_; ++i) {
+            const Shard& shard = shards_[i];
+            for (size_t j = 0; j < shard.slots.size(); ++j) {
+                const Slot& slot =
+                    shard.slots[(shard.hand + j) % shard.slots.size()];
+                if (!slot.key.empty()) {
+                    old_slots.push_back(slot);
+                }
+            }
+        }
+        for (size_t i = 0; i < NUM_SHARDS; ++i) {
+            old_names[i].swap(shards_[i].names);
+            const size_t capacity = (i >= num_shards) ? 0 :
+                (max_entries + num_shards - 1 - i) / num_shards;
+            shards_[i].init(capacity);
+        }
+        storeShared(num_shards_, num_shards);
+        storeShared(max_entries_, max_entries);
+
+        for (size_t i = 0; i < old_slots.size(); ++i) {
+            Slot& slot = old_slots[i];
+            Shard& shard = shards_[slot.hash % num_shards];
+            if (shard.slots.empty()) {
+                ++shard.evictions;
+                continue;
+            }
+            shard.link(shard.allocate(), slot.key, slot.hash,
+                       slot.name->first, slot.data, slot.referenced);
+        }
+    } catch (...) {
+        // We may have lost some responses already; drop all to keep the
+        // shards consistent.
+        for (size_t i = 0; i < NUM_SHARDS; ++i) {
+            shards_[i].clear();
+        }
+        throw;
+    }
+}
+
+size_t
+AnswerCache::getMaxEntries() const {
+    return (loadShared(max_entries_));
+}
+
+void
+AnswerCache::makeKey(const Question& question, bool edns, bool dnssec_ok,
+                     uint16_t size_limit, string& key)
+{
+    const Name& qname = question.getName();
+    const size_t name_len = qname.getLength();
+
+    key.clear();
+    key.reserve(name_len + 7);
+    // Label length octets are never in the range of upper case letters,
+    // so we can simply convert the whole wire data.
+    for (size_t i = 0; i < name_len; ++i) {
+        const char c = qname.at(i);
+        key.push_back((c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c);
+    }
+    const uint16_t qtype = question.getType().getCode();
+    const uint16_t qclass = question.getClass().getCode();
+    key.push_back(qtype >> 8);
+    key.push_back(qtype & 0xff);
+    key.push_back(qclass >> 8);
+    key.push_back(qclass & 0xff);
+    key.push_back((edns ? 1 : 0) | (dnssec_ok ? 2 : 0));
+    key.push_back(size_limit >> 8);
+    key.push_back(size_limit & 0xff);
+}
+
+bool
+AnswerCache::lookup(const string& key, const Message& response,
+                    OutputBuffer& buffer)
+{
+    const size_t hash = boost::hash_value(key);
+    while (true) {
+        const size_t num_shards = loadShared(num_shards_);
+        Shard& shard = shards_[hash % num_shards];
+        Mutex::Locker locker(shard.mutex);
+        if (num_shards != num_shards_) {
+            continue;           // resized before we got the lock, try again
+        }
+
+        const size_t index = shard.find(key, hash);
+        if (index == NONE) {
+            ++shard.misses;
+            return (false);
+        }
+        ++shard.hits;
+        Slot& slot = shard.slots[index];
+        slot.referenced = true;
+
+        const vector<uint8_t>& data = slot.data;
+        const size_t start = buffer.getLength();
+        buffer.writeData(&data[0], data.size());
+
+        // Patch the header and the question name for this query.
+        buffer.writeUint16At(response.getQid(), start);
+        uint16_t flags = (data[HEADER_FLAGS_POS] << 8) |
+            data[HEADER_FLAGS_POS + 1];
+        flags &= ~QUERY_FLAGS;
+        if (response.getHeaderFlag(Message::HEADERFLAG_RD)) {
+            flags |= Message::HEADERFLAG_RD;
+        }
+        if (response.getHeaderFlag(Message::HEADERFLAG_CD)) {
+            flags |= Message::HEADERFLAG_CD;
+        }
+        buffer.writeUint16At(flags, start + HEADER_FLAGS_POS);
+        // The key matched, so the name has the same length as the cached
+        // one, which is never compressed in the question section.
+        const Name& qname = (*response.beginQuestion())->getName();
+        for (size_t i = 0; i < qname.getLength(); ++i) {
+            buffer.writeUint8At(qname.at(i), start + HEADER_LEN + i);
+        }
+        return (true);
+    }
+}
+
+void
+AnswerCache::insert(const string& key, const Name& qname,
+                    const RRClass& qclass, const void* data, size_t length)
+{
+    assert(length >= HEADER_LEN + qname.getLength());
+
+    const size_t hash = boost::hash_value(key);
+    // Prepare the copies before locking.
+    string key_copy(key);
+    vector<uint8_t> data_copy(static_cast<const uint8_t*>(data),
+                              static_cast<const uint8_t*>(data) + length);
+    const NameKey name(qclass, qname);
+    while (true) {
+        const size_t num_shards = loadShared(num_shards_);
+        Shard& shard = shards_[hash % num_shards];
+        Mutex::Locker locker(shard.mutex);
+        if (num_shards != num_shards_) {
+            continue;
+        }
+
+        if (shard.slots.empty()) {
+            return;
+        }
+        size_t index = shard.find(key, hash);
+        if (index != NONE) {
+            shard.release(index);
+        }
+        index = shard.allocate();
+        shard.link(index, key_copy, hash, name, data_copy, false);
+        return;
+    }
+}
+
+void
+AnswerCache::invalidate(const Name& origin, const RRClass& rrclass) {
+    const NameKey origin_key(rrclass, origin);
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        Shard& shard = shards_[i];
+        Mutex::Locker locker(shard.mutex);
+
+        NameIndex::iterator it = shard.names.lower_bound(origin_key);
+        while (it != shard.names.end() && it->first.first == rrclass) {
+            const NameComparisonResult::NameRelation relation =
+                it->first.second.compare(origin).getRelation();
+            if (relation != NameComparisonResult::EQUAL &&
+                relation != NameComparisonResult::SUBDOMAIN) {
+                break;
+            }
+            shard.release((it++)->second);
+        }
+    }
+}
+
+void
+AnswerCache::clear() {
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        Mutex::Locker locker(shards_[i].mutex);
+        shards_[i].clear();
+    }
+}
+
+AnswerCache::Statistics
+AnswerCache::getStatistics() const {
+    Statistics stats = { 0, 0, 0, 0, 0 };
+    for (size_t i = 0; i < NUM_SHARDS; ++i) {
+        const Shard& shard = shards_[i];
+        Mutex::Locker locker(shard.mutex);
+        stats.hits += shard.hits;
+        stats.misses += shard.misses;
+        stats.evictions += shard.evictions;
+        stats.entries += shard.size;
+        stats.memory += shard.memory;
+    }
+    return (stats);
+}
+
+size_t
+AnswerCache::entryMemory(const string& key, const NameKey& name,
+                         size_t length)
+{
+    return (ENTRY_OVERHEAD + key.size() + name.second.getLength() + length);
+}
+
+AnswerCache::Shard::Shard() :
+    hand(0), size(0), free(NONE), memory(0), hits(0), misses(0),
+    evictions(0)
+{}
+
+void
+AnswerCache::Shard::init(size_t capacity) {
+    vector<Slot>(capacity).swap(slots);
+    size_t num_buckets = 1;
+    while (num_buckets < capacity) {
+        num_buckets <<= 1;
+    }
+    buckets.assign(num_buckets, NONE);
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].next = (i + 1 < capacity) ? i + 1 : NONE;
+    }
+    names.clear();
+    hand = 0;
+    size = 0;
+    free = (capacity > 0) ? 0 : NONE;
+    memory = 0;
+}
+
+void
+AnswerCache::Shard::clear() {
+    for (size_t i = 0; i < slots.size(); ++i) {
+        string().swap(slots[i].key);
+        vector<uint8_t>().swap(slots[i].data);
+        slots[i].referenced = false;
+        slots[i].next = (i + 1 < slots.size()) ? i + 1 : NONE;
+    }
+    buckets.assign(buckets.size(), NONE);
+    names.clear();
+    hand = 0;
+    size = 0;
+    free = slots.empty() ? NONE : 0;
+    memory = 0;
+}
+
+size_t
+AnswerCache::Shard::bucketIndex(size_t hash) const {
+    return (hash / NUM_SHARDS & (buckets.size() - 1));
+}
+
+size_t
+AnswerCache::Shard::find(const string& key, size_t hash) const {
+    if (slots.empty()) {
+        return (NONE);
+    }
+    for (size_t index = buckets[bucketIndex(hash)]; index != NONE;
+         index = slots[index].next) {
+        const Slot& slot = slots[index];
+        if (slot.hash == hash && slot.key == key) {
+            return (index);
+        }
+    }
+    return (NONE);
+}
+
+void
+AnswerCache::Shard::link(size_t index, string& key, size_t hash,
+                         const NameKey& name, vector<uint8_t>& data,
+                         bool referenced)
+{
+    Slot& slot = slots[index];
+    // This is the only thing that can throw, so do it first.
+    slot.name = names.insert(NameIndex::value_type(name, index));
+    slot.key.swap(key);
+    slot.hash = hash;
+    slot.data.swap(data);
+    slot.referenced = referenced;
+    free = slot.next;
+    const size_t bucket = bucketIndex(hash);
+    slot.next = buckets[bucket];
+    buckets[bucket] = index;
+    ++size;
+    memory += entryMemory(slot.key, name, slot.data.size());
+}
+
+void
+AnswerCache::Shard::release(size_t index) {
+    Slot& slot = slots[index];
+    size_t* link = &buckets[bucketIndex(slot.hash)];
+    while (*link != index) {
+        link = &slots[*link].next;
+    }
+    *link = slot.next;
+    memory -= entryMemory(slot.key, slot.name->first, slot.data.size());
+    names.erase(slot.name);
+    string().swap(slot.key);
+    vector<uint8_t>().swap(slot.data);
+    slot.referenced = false;
+    slot.next = free;
+    free = index;
+    --size;
+}
+
+size_t
+AnswerCache::Shard::allocate() {
+    if (free != NONE) {
+        return (free);
+    }
+    // All slots are in use; run the clock hand until an unreferenced entry
+    // is found.
+    while (slots[hand].referenced) {
+        slots[hand].referenced = false;
+        hand = (hand + 1) % slots.size();
+    }
+    const size_t index = hand;
+    hand = (hand + 1) % slots.size();
+    release(index);
+    ++evictions;
+    return (index);
+}
+
+} // namespace auth
+} // namespace isc
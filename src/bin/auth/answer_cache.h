@@ -0,0 +1,256 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef AUTH_ANSWER_CACHE_H
+#define AUTH_ANSWER_CACHE_H 1
+
+#include <util/threads/sync.h>
+
+#include <dns/name.h>
+#include <dns/rrclass.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace util {
+class OutputBuffer;
+}
+
+namespace dns {
+class Message;
+class Question;
+}
+
+namespace auth {
+
+/// \brief A cache of rendered responses to normal queries.
+///
+/// For popular questions, building the answer with \c Query::process() and
+/// rendering it with name compression every time is most of the cost of
+/// answering.  This cache keeps the final wire-format response for
+/// a question (including the EDNS and the size limit used for rendering,
+/// both of which affect the response), so a later query for the same
+/// question can be answered by copying the data and patching the header.
+///
+/// The cache doesn't know anything about the zone data the responses
+/// were built from.  Its user must call \c invalidate() whenever zone data
+/// are replaced; all cached responses for names at or below the zone origin
+/// are then dropped.  This is conservative (e.g. a reload of a parent zone
+/// also drops the responses from its child zones) but always safe.
+///
+/// The number of cached responses is limited; when the limit is reached,
+/// a response that wasn't used recently is evicted (see below).  A limit
+/// of 0 disables the cache.
+///
+/// All public methods are thread safe.  To keep concurrent lookups from
+/// waiting for each other, a cache of \c MIN_SHARDED_ENTRIES or more
+/// entries is split into \c NUM_SHARDS shards by the hash of the key, each
+/// with its own lock and its own part of the limit, and the response to
+/// evict is chosen by the CLOCK algorithm as in \c isc::cache::CacheTable,
+/// so a lookup doesn't reorder any list.  The responses of each shard are
+/// also indexed by the question name, so \c invalidate() only visits the
+/// responses of the zone.
+class AnswerCache : boost::noncopyable {
+public:
+    /// \brief Statistics of the cache.
+    struct Statistics {
+        uint64_t hits;          ///< Number of successful lookups
+        uint64_t misses;        ///< Number of failed lookups
+        uint64_t evictions;     ///< Number of responses evicted by the limit
+        size_t entries;         ///< Number of currently cached responses
+        size_t memory;          ///< Approximate memory use in bytes
+    };
+
+    /// \brief Constructor.
+    ///
+    /// \param max_entries The maximum number of cached responses.
+    /// \throw None
+    explicit AnswerCache(size_t max_entries = 0);
+
+    /// \brief Return whether the cache is enabled (i.e. the limit isn't 0).
+    ///
+    /// \throw None
+    bool isEnabled() const;
+
+    /// \brief Set the maximum number of cached responses.
+    ///
+    /// If there are more cached responses than the new limit, some are
+    /// evicted, preferring the ones that weren't used recently.  Setting it
+    /// to 0 disables the cache.
+    ///
+    /// As it reorganizes the whole cache, it's expected to be called only
+    /// on configuration changes.
+    ///
+    /// \throw std::bad_alloc Memory allocation fails.
+    void setMaxEntries(size_t max_entries);
+
+    /// \brief Return the maximum number of cached responses.
+    ///
+    /// \throw None
+    size_t getMaxEntries() const;
+
+    /// \brief Build the cache key of a response.
+    ///
+    /// The key consists of the question (with the owner name converted to
+    /// lower case) and all the parameters of the request that the response
+    /// depends on.
+    ///
+    /// \param question The question of the query.
+    /// \param edns Whether the query has EDNS (and so does the response).
+    /// \param dnssec_ok Whether the query has the DO bit set.
+    /// \param size_limit The maximum size of the response.
+    /// \param key Set to the key on return.
+    /// \throw std::bad_alloc Memory allocation fails.
+    static void makeKey(const isc::dns::Question& question, bool edns,
+                        bool dnssec_ok, uint16_t size_limit,
+                        std::string& key);
+
+    /// \brief Look up a cached response.
+    ///
+    /// On success, the response is appended to \c buffer, with the query ID,
+    /// the RD and CD flags and the question name taken from \c response,
+    /// which is the response to the query under construction (i.e. the
+    /// query after \c Message::makeResponse()).  This way the question name
+    /// is returned in the same case as in the query, as it would be if the
+    /// response had been rendered for the query.
+    ///
+    /// \param key The key built by \c makeKey() for the query.
+    /// \param response The response message to the query.
+    /// \param buffer The buffer to append the response to.
+    /// \return true if the response was found; false otherwise.
+    /// \throw std::bad_alloc Memory allocation fails.
+    bool lookup(const std::string& key, const isc::dns::Message& response,
+                isc::util::OutputBuffer& buffer);
+
+    /// \brief Cache a rendered response.
+    ///
+    /// It does nothing if the cache is disabled.  If a response is already
+    /// cached for the key, it's replaced.
+    ///
+    /// \param key The key built by \c makeKey() for the query.
+    /// \param qname The question name (used for invalidation).
+    /// \param qclass The question class (used for invalidation).
+    /// \param data The rendered response.
+    /// \param length The length of \c data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    void insert(const std::string& key, const isc::dns::Name& qname,
+                const isc::dns::RRClass& qclass, const void* data,
+                size_t length);
+
+    /// \brief Drop the cached responses of a zone.
+    ///
+    /// All responses for names at or below \c origin of class \c rrclass are
+    /// dropped.  Passing the root name drops all responses of the class.
+    ///
+    /// \throw None
+    void invalidate(const isc::dns::Name& origin,
+                    const isc::dns::RRClass& rrclass);
+
+    /// \brief Drop all cached responses.
+    ///
+    /// \throw None
+    void clear();
+
+    /// \brief Return the statistics of the cache.
+    ///
+    /// \throw None
+    Statistics getStatistics() const;
+
+private:
+    static const size_t MIN_SHARDED_ENTRIES = 1024;
+    static const size_t NUM_SHARDS = 16;
+    static const size_t NONE = static_cast<size_t>(-1);
+
+    // The cached responses of a shard ordered by the class and the
+    // question name.  As the names are in the DNSSEC order, the names at or
+    // below a zone origin are consecutive.  Mapped to the slot index.
+    typedef std::pair<isc::dns::RRClass, isc::dns::Name> NameKey;
+    typedef std::multimap<NameKey, size_t> NameIndex;
+
+    struct Slot {
+        Slot() : hash(0), referenced(false), next(NONE) {}
+
+        // The key is empty if the slot is unused.
+        std::string key;
+        size_t hash;
+        std::vector<uint8_t> data;
+        NameIndex::iterator name;
+        bool referenced;
+        // The next slot in the same bucket, or in the free list.
+        size_t next;
+    };
+
+    // A part of the cache with its own lock.  Just like the
+    // isc::cache::CacheTable, the slots are allocated in advance and the
+    // entry to evict is chosen by the CLOCK algorithm, so a lookup only
+    // sets the "referenced" flag of the slot.
+    struct Shard {
+        Shard();
+        // Drop all entries and reallocate the slots.
+        void init(size_t capacity);
+        // Drop all entries, keeping the slots.
+        void clear();
+        size_t find(const std::string& key, size_t hash) const;
+        size_t bucketIndex(size_t hash) const;
+        // Fill the free slot at index with the given response (the key
+        // and the data are swapped in) and link it.
+        void link(size_t index, std::string& key, size_t hash,
+                  const NameKey& name, std::vector<uint8_t>& data,
+                  bool referenced);
+        // Unlink the slot and put it in the free list.
+        void release(size_t index);
+        // Return a free slot, evicting an entry if needed.
+        size_t allocate();
+
+        mutable isc::util::thread::Mutex mutex;
+        std::vector<Slot> slots;
+        std::vector<size_t> buckets;
+        NameIndex names;
+        size_t hand;
+        size_t size;
+        size_t free;
+        size_t memory;
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+    };
+
+    static size_t entryMemory(const std::string& key, const NameKey& name,
+                              size_t length);
+
+    // The shard of a key is selected by its hash modulo num_shards_, which
+    // is only changed in setMaxEntries() with all shards locked.  It and
+    // max_entries_ are also read without a lock, so they are only accessed
+    // through the atomic helpers in answer_cache.cc, except under the lock.
+    boost::scoped_array<Shard> shards_;
+    size_t num_shards_;
+    size_t max_entries_;
+};
+
+} // namespace auth
+} // namespace isc
+
+#endif // AUTH_ANSWER_CACHE_H
+
+// Local Variables:
+// mode: c++
+// End:
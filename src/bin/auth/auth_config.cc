@@ -137,6 +137,107 @@ private:
     size_t timeout_;
 };
 
+/// \brief Configuration for the size of the answer cache
+class AnswerCacheSizeConfig : public AuthConfigParser {
+public:
+    AnswerCacheSizeConfig(AuthSrv& server) : server_(server), size_(0)
+    {}
+
+    virtual void build(ConstElementPtr config) {
+        if (config->intValue() >= 0) {
+            size_ = config->intValue();
+        } else {
+            isc_throw(AuthConfigError,
+                      "answer_cache_size must be 0 or higher");
+        }
+    }
+
+    virtual void commit() {
+        server_.setAnswerCacheSize(size_);
+    }
+private:
+    AuthSrv& server_;
+    size_t size_;
+};
+
+// A sanity limit of worker_threads; it's unlikely to be useful to have
+// more threads than this in practice.
+const int64_t MAX_WORKER_THREADS = 1024;
+
+/// \brief Configuration for the number of query worker threads
+///
+/// Like \c ListenAddressConfig, this reopens the listening sockets, which
+/// can fail, so the change is applied in build() and reverted on
+/// destruction unless it's committed.
+class WorkerThreadsConfig : public AuthConfigParser {
+public:
+    WorkerThreadsConfig(AuthSrv& server) :
+        server_(server), old_worker_threads_(server.getWorkerThreads()),
+        rollback_(false)
+    {}
+    ~WorkerThreadsConfig() {
+        if (rollback_) {
+            server_.setWorkerThreads(old_worker_threads_);
+        }
+    }
+
+    virtual void build(ConstElementPtr config) {
+        const int64_t worker_threads = config->intValue();
+        if (worker_threads < 0 || worker_threads > MAX_WORKER_THREADS) {
+            isc_throw(AuthConfigError, "worker_threads must be between 0 "
+                      "and " << MAX_WORKER_THREADS);
+        }
+        server_.setWorkerThreads(worker_threads);
+        rollback_ = true;
+    }
+
+    virtual void commit() {
+        rollback_ = false;
+    }
+private:
+    AuthSrv& server_;
+    const size_t old_worker_threads_;
+    bool rollback_;
+};
+
+// recvmmsg() won't take more than this (UIO_MAXIOV on Linux) anyway.
+const int64_t MAX_UDP_BATCH_SIZE = 1024;
+
+/// \brief Configuration for the batch size of UDP servers
+///
+/// This also reopens the listening sockets, so it works the same way as
+/// \c WorkerThreadsConfig.
+class UDPBatchSizeConfig : public AuthConfigParser {
+public:
+    UDPBatchSizeConfig(AuthSrv& server) :
+        server_(server), old_batch_size_(server.getUDPBatchSize()),
+        rollback_(false)
+    {}
+    ~UDPBatchSizeConfig() {
+        if (rollback_) {
+            server_.setUDPBatchSize(old_batch_size_);
+        }
+    }
+
+    virtual void build(ConstElementPtr config) {
+        const int64_t batch_size = config->intValue();
+        if (batch_size < 1 || batch_size > MAX_UDP_BATCH_SIZE) {
+            isc_throw(AuthConfigError, "udp_batch_size must be between 1 "
+                      "and " << MAX_UDP_BATCH_SIZE);
+        }
+        server_.setUDPBatchSize(batch_size);
+        rollback_ = true;
+    }
+
+    virtual void commit() {
+        rollback_ = false;
+    }
+private:
+    AuthSrv& server_;
+    const size_t old_batch_size_;
+    bool rollback_;
+};
+
 } // end of unnamed namespace
 
 AuthConfigParser*
@@ -170,6 +271,12 @@ createAuthConfigParser(AuthSrv& server, const std::string& config_id) {
         return (new VersionConfig());
     } else if (config_id == "tcp_recv_timeout") {
         return (new TCPRecvTimeoutConfig(server));
+    } else if (config_id == "worker_threads") {
+        return (new WorkerThreadsConfig(server));
+    } else if (config_id == "answer_cache_size") {
+        return (new AnswerCacheSizeConfig(server));
+    } else if (config_id == "udp_batch_size") {
+        return (new UDPBatchSizeConfig(server));
     } else {
         isc_throw(AuthConfigError, "Unknown configuration identifier: " <<
                   config_id);
@@ -42,11 +42,15 @@
 
 #include <asiodns/dns_service.h>
 
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
 #include <datasrc/exceptions.h>
 #include <datasrc/client_list.h>
 
 #include <xfr/xfrout_client.h>
 
+#include <auth/answer_cache.h>
 #include <auth/common.h>
 #include <auth/auth_config.h>
 #include <auth/auth_srv.h>
@@ -56,17 +60,24 @@
 #include <auth/datasrc_clients_mgr.h>
 
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
 
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <vector>
 #include <memory>
 
 #include <sys/types.h>
 #include <netinet/in.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -84,6 +95,8 @@ using namespace isc::xfr;
 using namespace isc::asiolink;
 using namespace isc::asiodns;
 using namespace isc::server_common::portconfig;
+using isc::util::thread::Mutex;
+using isc::util::thread::Thread;
 using isc::auth::statistics::Counters;
 using isc::auth::statistics::MessageAttributes;
 
@@ -233,6 +246,46 @@ private:
 };
 }
 
+namespace {
+// The per-thread state used for building responses.
+//
+// The renderer and the query object keep some internal resources between
+// queries for efficiency, so they cannot be shared by multiple threads.
+// The main thread and each of the worker threads (see
+// AuthSrv::setWorkerThreads()) have their own instance of this structure.
+//
+// The query counters are per thread as well, so the threads don't contend
+// for them.  The lock is only contended while the main thread collects the
+// counters for statistics.
+struct RequestContext : boost::noncopyable {
+    MessageRenderer renderer;
+    auth::Query query;
+    std::string cache_key;      // the answer cache key of the query
+    Counters counters;
+    Mutex counters_mutex;       // protects counters
+};
+
+// Reflect the header of a response taken from the answer cache in
+// the response message and the statistics attributes, as rendering the
+// response would do.
+void
+setCachedResponseAttributes(const OutputBuffer& buffer, size_t start,
+                            Message& message, MessageAttributes& stats_attrs)
+{
+    InputBuffer header(static_cast<const uint8_t*>(buffer.getData()) + start,
+                       buffer.getLength() - start);
+    header.setPosition(2);
+    const uint16_t flags = header.readUint16();
+    message.setRcode(Rcode(flags & 0x000f));
+    stats_attrs.setResponseTruncated((flags & Message::HEADERFLAG_TC) != 0);
+    header.setPosition(6);
+    stats_attrs.setResponseAnswerCount(header.readUint16());
+}
+
+class AuthWorker;
+typedef boost::shared_ptr<AuthWorker> AuthWorkerPtr;
+}
+
 class AuthSrvImpl {
 private:
     // prohibit copy
@@ -243,24 +296,57 @@ public:
                 BaseSocketSessionForwarder& ddns_forwarder);
     ~AuthSrvImpl();
 
+    /// \brief The body of \c AuthSrv::processMessage().
+    ///
+    /// \c context is the state of the thread calling this method; the
+    /// other parameters are the same as those of
+    /// \c AuthSrv::processMessage().
+    void processMessage(const IOMessage& io_message, Message& message,
+                        OutputBuffer& buffer, DNSServer* server,
+                        RequestContext& context);
     bool processNormalQuery(const IOMessage& io_message,
                             ConstEDNSPtr remote_edns, Message& message,
                             OutputBuffer& buffer,
                             auto_ptr<TSIGContext> tsig_context,
-                            MessageAttributes& stats_attrs);
+                            MessageAttributes& stats_attrs,
+                            RequestContext& context);
     bool processXfrQuery(const IOMessage& io_message, Message& message,
                          OutputBuffer& buffer,
                          auto_ptr<TSIGContext> tsig_context,
-                         MessageAttributes& stats_attrs);
+                         MessageAttributes& stats_attrs,
+                         RequestContext& context);
     bool processNotify(const IOMessage& io_message, Message& message,
                        OutputBuffer& buffer,
                        auto_ptr<TSIGContext> tsig_context,
-                       MessageAttributes& stats_attrs);
+                       MessageAttributes& stats_attrs,
+                       RequestContext& context);
     bool processUpdate(const IOMessage& io_message);
 
+    /// \brief Replace the worker threads with \c worker_threads_ new ones.
+    ///
+    /// The new workers don't have any servers and are not started yet.
+    void resetWorkers();
+
+    /// \brief Stop and remove all worker threads.
+    ///
+    /// Their query counters are kept in \c retired_counters_.
+    void clearWorkers();
+
+    /// \brief Add the query counters of a thread to \c counters.
+    void addCounters(RequestContext& context, Counters& counters) {
+        Mutex::Locker locker(context.counters_mutex);
+        counters.add(context.counters);
+    }
+
+    /// \brief Start all (new) worker threads.
+    ///
+    /// If there are no listening sockets, the workers are removed instead.
+    void startWorkers();
+
     IOService io_service_;
 
-    MessageRenderer renderer_;
+    /// The request context of the main thread
+    RequestContext main_context_;
     /// Currently non-configurable, but will be.
     static const uint16_t DEFAULT_LOCAL_UDPSIZE = 4096;
 
@@ -268,8 +354,17 @@ public:
     ModuleCCSession* config_session_;
     AbstractSession* xfrin_session_;
 
-    /// Query counters for statistics
-    Counters counters_;
+    /// Query counters of the worker threads that have been stopped.
+    /// The counters of the running threads are in their RequestContext.
+    Counters retired_counters_;
+
+    /// Rendered responses to normal queries.  This must be placed before
+    /// datasrc_clients_mgr_, which refers to it.
+    AnswerCache answer_cache_;
+
+    /// Serializes the use of the xfrin session and the DDNS forwarder,
+    /// which can happen from worker threads as well as the main thread
+    Mutex control_mutex_;
 
     /// Addresses we listen on
     AddressList listen_addresses_;
@@ -277,6 +372,19 @@ public:
     /// The TSIG keyring
     const boost::shared_ptr<TSIGKeyRing>* keyring_;
 
+    /// The lock protecting *keyring_ (NULL if it's not replaced while
+    /// the workers are running)
+    Mutex* keyring_mutex_;
+
+    /// Return a copy of the current keyring, safe against its replacement
+    boost::shared_ptr<const TSIGKeyRing> getKeyRing() const {
+        if (keyring_mutex_ == NULL) {
+            return (*keyring_);
+        }
+        Mutex::Locker locker(*keyring_mutex_);
+        return (*keyring_);
+    }
+
     /// The data source client list manager
     auth::DataSrcClientsMgr datasrc_clients_mgr_;
 
@@ -296,40 +404,58 @@ public:
     /// This method is expected to be called by processMessage()
     ///
     /// \param server The DNSServer as passed to processMessage()
+    /// \param context The context as passed to processMessage()
     /// \param message The response as constructed by processMessage()
     /// \param stats_attrs Object to store message attributes in for use
     ///                    with statistics
     /// \param done If true, it indicates there is a response.
     ///             this value will be passed to server->resume(bool)
     void resumeServer(isc::asiodns::DNSServer* server,
+                      RequestContext& context,
                       isc::dns::Message& message,
                       MessageAttributes& stats_attrs,
                       const bool done);
 
     /// Are we currently subscribed to the SegmentReader group?
     bool readers_group_subscribed_;
+
+    /// The configured number of query worker threads
+    size_t worker_threads_;
+
+    /// The configured batch size of the UDP servers
+    size_t udp_batch_size_;
+
+    /// The running worker threads (empty if worker_threads_ is 0)
+    std::vector<AuthWorkerPtr> workers_;
 private:
     bool xfrout_connected_;
     AbstractXfroutClient& xfrout_client_;
-
-    auth::Query query_;
 };
 
 AuthSrvImpl::AuthSrvImpl(AbstractXfroutClient& xfrout_client,
                          BaseSocketSessionForwarder& ddns_forwarder) :
     config_session_(NULL),
     xfrin_session_(NULL),
-    counters_(),
+    retired_counters_(),
     keyring_(NULL),
+    keyring_mutex_(NULL),
     datasrc_clients_mgr_(io_service_),
     ddns_base_forwarder_(ddns_forwarder),
     ddns_forwarder_(NULL),
     readers_group_subscribed_(false),
+    worker_threads_(0),
+    udp_batch_size_(1),
     xfrout_connected_(false),
     xfrout_client_(xfrout_client)
-{}
+{
+    datasrc_clients_mgr_.setZoneUpdatedCallback(
+        boost::bind(&AnswerCache::invalidate, &answer_cache_, _1, _2));
+}
 
 AuthSrvImpl::~AuthSrvImpl() {
+    // Stop the workers first; they may still be referring to us.
+    workers_.clear();
+
     if (xfrout_connected_) {
         xfrout_client_.disconnect();
         xfrout_connected_ = false;
@@ -338,10 +464,13 @@ AuthSrvImpl::~AuthSrvImpl() {
 
 // This is a derived class of \c DNSLookup, to serve as a
 // callback in the asiolink module.  It calls
-// AuthSrv::processMessage() on a single DNS message.
+// AuthSrvImpl::processMessage() on a single DNS message with the request
+// context of the thread that runs the lookup.
 class MessageLookup : public DNSLookup {
 public:
-    MessageLookup(AuthSrv* srv) : server_(srv) {}
+    MessageLookup(AuthSrvImpl* srv, RequestContext* context) :
+        server_(srv), context_(context)
+    {}
     virtual void operator()(const IOMessage& io_message,
                             MessagePtr message,
                             MessagePtr, // Not used here
@@ -353,10 +482,12 @@ public:
         // This is not done in processMessage itself (which would be
         // equivalent), to allow tests to inspect the message handling.
         MessageHolder message_holder(*message);
-        server_->processMessage(io_message, *message, *buffer, server);
+        server_->processMessage(io_message, *message, *buffer, server,
+                                *context_);
     }
 private:
-    AuthSrv* server_;
+    AuthSrvImpl* server_;
+    RequestContext* context_;
 };
 
 // This is a derived class of \c DNSAnswer, to serve as a callback in the
@@ -375,12 +506,166 @@ public:
     {}
 };
 
+namespace {
+// A thread processing incoming UDP queries.
+//
+// Each worker has its own IOService and DNSService, so the UDP servers
+// (and their Message and OutputBuffer objects) added to it are used only
+// by this thread, and its own RequestContext for building responses.
+// The thread is started by start() and is stopped and joined on
+// destruction, at which point all its servers are also closed.
+class AuthWorker : boost::noncopyable {
+public:
+    AuthWorker(AuthSrvImpl* server) :
+        lookup_(server, &context_),
+        answer_(NULL),
+        dns_service_(io_service_, &lookup_, &answer_)
+    {}
+
+    ~AuthWorker() {
+        stop();
+        dns_service_.clearServers();
+    }
+
+    void start() {
+        thread_.reset(new Thread(boost::bind(&AuthWorker::run, this)));
+    }
+
+    // Stop the thread and wait for it to finish, if it's running.
+    void stop() {
+        if (thread_) {
+            io_service_.stop();
+            thread_->wait();
+            thread_.reset();
+        }
+    }
+
+    DNSService& getDNSService() { return (dns_service_); }
+    RequestContext& getContext() { return (context_); }
+
+private:
+    void run() {
+        try {
+            io_service_.run();
+        } catch (const std::exception& ex) {
+            // The main thread would terminate the whole server in this
+            // case; we do the same for consistency.
+            LOG_FATAL(auth_logger, AUTH_WORKER_FAILED).arg(ex.what());
+            abort();
+        }
+    }
+
+    IOService io_service_;
+    RequestContext context_;
+    MessageLookup lookup_;
+    MessageAnswer answer_;
+    DNSService dns_service_;
+    boost::scoped_ptr<Thread> thread_;
+};
+
+// A DNSServiceBase wrapper used to install the listening sockets when
+// worker threads are used.
+//
+// UDP sockets are served by the workers: each worker gets a UDP server
+// of its own on a duplicate of the descriptor, so they all read from the
+// same socket and the kernel distributes incoming queries among them.
+// TCP sockets stay in the main service.
+class WorkersDNSService : public DNSServiceBase {
+public:
+    WorkersDNSService(DNSServiceBase& main_service,
+                      const std::vector<AuthWorkerPtr>& workers) :
+        main_service_(main_service), workers_(workers)
+    {
+        assert(!workers_.empty());
+    }
+
+    virtual void addServerTCPFromFD(int fd, int af) {
+        main_service_.addServerTCPFromFD(fd, af);
+    }
+
+    virtual void addServerUDPFromFD(int fd, int af,
+                                    ServerFlag options = SERVER_DEFAULT)
+    {
+        // The first worker takes over the given descriptor, and the others
+        // use their own duplicates (each server closes its own one).
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            const int worker_fd = (i == 0) ? fd : dup(fd);
+            if (worker_fd < 0) {
+                isc_throw(isc::Unexpected, "failed to duplicate UDP socket "
+                          "for a worker thread: " << strerror(errno));
+            }
+            workers_[i]->getDNSService().addServerUDPFromFD(worker_fd, af,
+                                                            options);
+        }
+    }
+
+    virtual void clearServers() {
+        main_service_.clearServers();
+        BOOST_FOREACH(const AuthWorkerPtr& worker, workers_) {
+            worker->getDNSService().clearServers();
+        }
+    }
+
+    virtual void setTCPRecvTimeout(size_t timeout) {
+        main_service_.setTCPRecvTimeout(timeout);
+    }
+
+    virtual void setUDPBatchSize(size_t batch_size) {
+        main_service_.setUDPBatchSize(batch_size);
+        BOOST_FOREACH(const AuthWorkerPtr& worker, workers_) {
+            worker->getDNSService().setUDPBatchSize(batch_size);
+        }
+    }
+
+    virtual IOService& getIOService() {
+        return (main_service_.getIOService());
+    }
+
+private:
+    DNSServiceBase& main_service_;
+    const std::vector<AuthWorkerPtr>& workers_;
+};
+}
+
+void
+AuthSrvImpl::resetWorkers() {
+    // Destroy the old ones first so their sockets are closed before new
+    // ones are opened.
+    clearWorkers();
+    for (size_t i = 0; i < worker_threads_; ++i) {
+        workers_.push_back(AuthWorkerPtr(new AuthWorker(this)));
+    }
+}
+
+void
+AuthSrvImpl::clearWorkers() {
+    BOOST_FOREACH(const AuthWorkerPtr& worker, workers_) {
+        worker->stop();
+        retired_counters_.add(worker->getContext().counters);
+    }
+    workers_.clear();
+}
+
+void
+AuthSrvImpl::startWorkers() {
+    // Without any sockets the IOService of a worker has nothing to wait
+    // for, and as ASIO is built without thread support, its run() would
+    // spin instead of blocking.  Such workers would be useless anyway.
+    if (listen_addresses_.empty()) {
+        clearWorkers();
+        return;
+    }
+    BOOST_FOREACH(const AuthWorkerPtr& worker, workers_) {
+        worker->start();
+    }
+}
+
 AuthSrv::AuthSrv(isc::xfr::AbstractXfroutClient& xfrout_client,
                  isc::util::io::BaseSocketSessionForwarder& ddns_forwarder) :
     dnss_(NULL)
 {
     impl_ = new AuthSrvImpl(xfrout_client, ddns_forwarder);
-    dns_lookup_ = new MessageLookup(this);
+    dns_lookup_ = new MessageLookup(impl_, &impl_->main_context_);
     dns_answer_ = new MessageAnswer(this);
 }
 
@@ -478,6 +763,15 @@ AuthSrv::getConfigSession() const {
 void
 AuthSrv::processMessage(const IOMessage& io_message, Message& message,
                         OutputBuffer& buffer, DNSServer* server)
+{
+    impl_->processMessage(io_message, message, buffer, server,
+                          impl_->main_context_);
+}
+
+void
+AuthSrvImpl::processMessage(const IOMessage& io_message, Message& message,
+                            OutputBuffer& buffer, DNSServer* server,
+                            RequestContext& context)
 {
     InputBuffer request_buffer(io_message.getData(), io_message.getDataSize());
     MessageAttributes stats_attrs;
@@ -495,13 +789,13 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
         // Ignore all responses.
         if (message.getHeaderFlag(Message::HEADERFLAG_QR)) {
             LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_RECEIVED);
-            impl_->resumeServer(server, message, stats_attrs, false);
+            resumeServer(server, context, message, stats_attrs, false);
             return;
         }
     } catch (const isc::Exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_HEADER_PARSE_FAIL)
                   .arg(ex.what());
-        impl_->resumeServer(server, message, stats_attrs, false);
+        resumeServer(server, context, message, stats_attrs, false);
         return;
     }
 
@@ -518,16 +812,16 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
     } catch (const DNSProtocolError& error) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_PACKET_PROTOCOL_FAILURE)
                   .arg(error.getRcode().toText()).arg(error.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, error.getRcode(),
+        makeErrorMessage(context.renderer, message, buffer, error.getRcode(),
                          stats_attrs);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        resumeServer(server, context, message, stats_attrs, true);
         return;
     } catch (const isc::Exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_PACKET_PARSE_FAILED)
                   .arg(ex.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        resumeServer(server, context, message, stats_attrs, true);
         return;
     } // other exceptions will be handled at a higher layer.
 
@@ -542,21 +836,23 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
     TSIGError tsig_error(TSIGError::NOERROR());
 
     // Do we do TSIG?
-    // The keyring can be null if we're in test
-    if (impl_->keyring_ != NULL && tsig_record != NULL) {
+    // The keyring can be null if we're in test.  We hold our own reference
+    // to it as it can be replaced by another thread at any time.
+    if (keyring_ != NULL && tsig_record != NULL) {
+        const boost::shared_ptr<const TSIGKeyRing> keyring(getKeyRing());
         tsig_context.reset(new TSIGContext(tsig_record->getName(),
                                            tsig_record->getRdata().
                                                 getAlgorithm(),
-                                           **impl_->keyring_));
+                                           *keyring));
         tsig_error = tsig_context->verify(tsig_record, io_message.getData(),
                                           io_message.getDataSize());
         stats_attrs.setRequestTSIG(true, tsig_error != TSIGError::NOERROR());
     }
 
     if (tsig_error != TSIGError::NOERROR()) {
-        makeErrorMessage(impl_->renderer_, message, buffer,
+        makeErrorMessage(context.renderer, message, buffer,
                          tsig_error.toRcode(), stats_attrs, tsig_context);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        resumeServer(server, context, message, stats_attrs, true);
         return;
     }
 
@@ -571,53 +867,54 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
 
         // note: This can only be reliable after TSIG check succeeds.
         if (opcode == Opcode::NOTIFY()) {
-            send_answer = impl_->processNotify(io_message, message, buffer,
-                                               tsig_context, stats_attrs);
+            send_answer = processNotify(io_message, message, buffer,
+                                        tsig_context, stats_attrs, context);
         } else if (opcode == Opcode::UPDATE()) {
-            if (impl_->ddns_forwarder_) {
-                send_answer = impl_->processUpdate(io_message);
+            Mutex::Locker locker(control_mutex_);
+            if (ddns_forwarder_) {
+                send_answer = processUpdate(io_message);
             } else {
-                makeErrorMessage(impl_->renderer_, message, buffer,
+                makeErrorMessage(context.renderer, message, buffer,
                                  Rcode::NOTIMP(), stats_attrs, tsig_context);
             }
         } else if (opcode != Opcode::QUERY()) {
             const IOEndpoint& remote_ep = io_message.getRemoteEndpoint();
             LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_UNSUPPORTED_OPCODE)
                 .arg(message.getOpcode().toText()).arg(remote_ep);
-            makeErrorMessage(impl_->renderer_, message, buffer,
+            makeErrorMessage(context.renderer, message, buffer,
                              Rcode::NOTIMP(), stats_attrs, tsig_context);
         } else if (message.getRRCount(Message::SECTION_QUESTION) != 1) {
-            makeErrorMessage(impl_->renderer_, message, buffer,
+            makeErrorMessage(context.renderer, message, buffer,
                              Rcode::FORMERR(), stats_attrs, tsig_context);
         } else {
             ConstQuestionPtr question = *message.beginQuestion();
             const RRType& qtype = question->getType();
             if (qtype == RRType::AXFR()) {
-                send_answer = impl_->processXfrQuery(io_message, message,
-                                                     buffer, tsig_context,
-                                                     stats_attrs);
+                send_answer = processXfrQuery(io_message, message,
+                                              buffer, tsig_context,
+                                              stats_attrs, context);
             } else if (qtype == RRType::IXFR()) {
-                send_answer = impl_->processXfrQuery(io_message, message,
-                                                     buffer, tsig_context,
-                                                     stats_attrs);
+                send_answer = processXfrQuery(io_message, message,
+                                              buffer, tsig_context,
+                                              stats_attrs, context);
             } else {
-                send_answer = impl_->processNormalQuery(io_message, edns,
-                                                        message, buffer,
-                                                        tsig_context,
-                                                        stats_attrs);
+                send_answer = processNormalQuery(io_message, edns,
+                                                 message, buffer,
+                                                 tsig_context,
+                                                 stats_attrs, context);
             }
         }
     } catch (const std::exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_FAILURE)
                   .arg(ex.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
     } catch (...) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_FAILURE_UNKNOWN);
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
     }
-    impl_->resumeServer(server, message, stats_attrs, send_answer);
+    resumeServer(server, context, message, stats_attrs, send_answer);
 }
 
 bool
@@ -625,7 +922,8 @@ AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
                                 ConstEDNSPtr remote_edns, Message& message,
                                 OutputBuffer& buffer,
                                 auto_ptr<TSIGContext> tsig_context,
-                                MessageAttributes& stats_attrs)
+                                MessageAttributes& stats_attrs,
+                                RequestContext& context)
 {
     const bool dnssec_ok = remote_edns && remote_edns->getDNSSECAwareness();
     const uint16_t remote_bufsize = remote_edns ? remote_edns->getUDPSize() :
@@ -642,57 +940,95 @@ AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
         message.setEDNS(local_edns);
     }
 
+    const bool udp_buffer =
+        (io_message.getSocket().getProtocol() == IPPROTO_UDP);
+    const uint16_t size_limit = udp_buffer ? remote_bufsize : 65535;
+    const ConstQuestionPtr question = *message.beginQuestion();
+
+    // TSIG signed responses are specific to the query, so they are never
+    // cached.
+    const bool use_cache =
+        tsig_context.get() == NULL && answer_cache_.isEnabled();
+    if (use_cache) {
+        AnswerCache::makeKey(*question, remote_edns, dnssec_ok, size_limit,
+                             context.cache_key);
+        const size_t start = buffer.getLength();
+        if (answer_cache_.lookup(context.cache_key, message, buffer)) {
+            setCachedResponseAttributes(buffer, start, message, stats_attrs);
+            stats_attrs.setResponseTSIG(false);
+            LOG_DEBUG(auth_logger, DBG_AUTH_MESSAGES,
+                      AUTH_SEND_CACHED_RESPONSE)
+                .arg(buffer.getLength() - start).arg(question->getName())
+                .arg(question->getClass()).arg(question->getType());
+            return (true);
+        }
+    }
+
     // Get access to data source client list through the holder and keep
     // the holder until the processing and rendering is done to avoid
     // race with any other thread(s) such as the background loader.
     auth::DataSrcClientsMgr::Holder datasrc_holder(datasrc_clients_mgr_);
 
     try {
-        const ConstQuestionPtr question = *message.beginQuestion();
         const boost::shared_ptr<datasrc::ClientList>
             list(datasrc_holder.findClientList(question->getClass()));
         if (list) {
             const RRType& qtype = question->getType();
             const Name& qname = question->getName();
-            query_.process(*list, qname, qtype, message, dnssec_ok);
+            context.query.process(*list, qname, qtype, message, dnssec_ok);
         } else {
-            makeErrorMessage(renderer_, message, buffer, Rcode::REFUSED(),
+            makeErrorMessage(context.renderer, message, buffer, Rcode::REFUSED(),
                              stats_attrs);
             return (true);
         }
     } catch (const isc::Exception& ex) {
         LOG_ERROR(auth_logger, AUTH_PROCESS_FAIL).arg(ex.what());
-        makeErrorMessage(renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
         return (true);
     }
 
-    RendererHolder holder(renderer_, &buffer, stats_attrs);
-    const bool udp_buffer =
-        (io_message.getSocket().getProtocol() == IPPROTO_UDP);
-    renderer_.setLengthLimit(udp_buffer ? remote_bufsize : 65535);
-    message.toWire(renderer_, tsig_context.get());
+    const size_t start = buffer.getLength();
+    {
+        RendererHolder holder(context.renderer, &buffer, stats_attrs);
+        context.renderer.setLengthLimit(size_limit);
+        message.toWire(context.renderer, tsig_context.get());
+    }
     stats_attrs.setResponseTSIG(tsig_context.get() != NULL);
 
+    // Only positive and negative answers are worth caching.  We still hold
+    // the data source holder, so the response can't be cached after the
+    // cache is invalidated for a newer version of the zone (which happens
+    // only once all holders that can see the older version are gone).
+    const Rcode& rcode = message.getRcode();
+    if (use_cache && (rcode == Rcode::NOERROR() || rcode == Rcode::NXDOMAIN()))
+    {
+        answer_cache_.insert(context.cache_key, question->getName(),
+                             question->getClass(),
+                             static_cast<const uint8_t*>(buffer.getData()) +
+                             start, buffer.getLength() - start);
+    }
+
     LOG_DEBUG(auth_logger, DBG_AUTH_MESSAGES, AUTH_SEND_NORMAL_RESPONSE)
-              .arg(renderer_.getLength()).arg(message);
+              .arg(buffer.getLength() - start).arg(message);
     return (true);
     // The message can contain some data from the locked resource. But outside
     // this method, we touch only the RCode of it, so it should be safe.
 
-    // Lock on datasrc_clients_mgr_ acquired by datasrc_holder is
-    // released here upon its deletion.
+    // The read-side region of datasrc_clients_mgr_ entered by
+    // datasrc_holder is left here upon its deletion.
 }
 
 bool
 AuthSrvImpl::processXfrQuery(const IOMessage& io_message, Message& message,
                              OutputBuffer& buffer,
                              auto_ptr<TSIGContext> tsig_context,
-                             MessageAttributes& stats_attrs)
+                             MessageAttributes& stats_attrs,
+                             RequestContext& context)
 {
     if (io_message.getSocket().getProtocol() == IPPROTO_UDP) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_AXFR_UDP);
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(context.renderer, message, buffer, Rcode::FORMERR(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -718,7 +1054,7 @@ AuthSrvImpl::processXfrQuery(const IOMessage& io_message, Message& message,
 
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_AXFR_PROBLEM)
                   .arg(err.what());
-        makeErrorMessage(renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(context.renderer, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -730,7 +1066,8 @@ bool
 AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
                            OutputBuffer& buffer,
                            std::auto_ptr<TSIGContext> tsig_context,
-                           MessageAttributes& stats_attrs)
+                           MessageAttributes& stats_attrs,
+                           RequestContext& context)
 {
     const IOEndpoint& remote_ep = io_message.getRemoteEndpoint(); // for logs
 
@@ -739,7 +1076,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (message.getRRCount(Message::SECTION_QUESTION) != 1) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_NOTIFY_QUESTIONS)
                   .arg(message.getRRCount(Message::SECTION_QUESTION));
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(context.renderer, message, buffer, Rcode::FORMERR(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -747,7 +1084,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (question->getType() != RRType::SOA()) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_NOTIFY_RRTYPE)
                   .arg(question->getType().toText());
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(context.renderer, message, buffer, Rcode::FORMERR(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -769,7 +1106,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (!is_auth) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RECEIVED_NOTIFY_NOTAUTH)
             .arg(question->getName()).arg(question->getClass()).arg(remote_ep);
-        makeErrorMessage(renderer_, message, buffer, Rcode::NOTAUTH(),
+        makeErrorMessage(context.renderer, message, buffer, Rcode::NOTAUTH(),
                          stats_attrs, tsig_context);
         return (true);
     }
@@ -777,6 +1114,10 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RECEIVED_NOTIFY)
         .arg(question->getName()).arg(question->getClass()).arg(remote_ep);
 
+    // The xfrin session can't be used by multiple threads at the same time.
+    // NOTIFY is rare enough that simply serializing it is acceptable.
+    Mutex::Locker locker(control_mutex_);
+
     // xfrin_session_ should have been set and never be replaced except in
     // tests; otherwise it's an internal bug.  assert() may be too strong,
     // but processMessage() will catch all exceptions, so there's no better
@@ -829,8 +1170,8 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     message.setHeaderFlag(Message::HEADERFLAG_AA);
     message.setRcode(Rcode::NOERROR());
 
-    RendererHolder holder(renderer_, &buffer, stats_attrs);
-    message.toWire(renderer_, tsig_context.get());
+    RendererHolder holder(context.renderer, &buffer, stats_attrs);
+    message.toWire(context.renderer, tsig_context.get());
     stats_attrs.setResponseTSIG(tsig_context.get() != NULL);
     return (true);
 }
@@ -846,10 +1187,13 @@ AuthSrvImpl::processUpdate(const IOMessage& io_message)
 }
 
 void
-AuthSrvImpl::resumeServer(DNSServer* server, Message& message,
-                          MessageAttributes& stats_attrs,
+AuthSrvImpl::resumeServer(DNSServer* server, RequestContext& context,
+                          Message& message, MessageAttributes& stats_attrs,
                           const bool done) {
-    counters_.inc(stats_attrs, message, done);
+    {
+        Mutex::Locker locker(context.counters_mutex);
+        context.counters.inc(stats_attrs, message, done);
+    }
     server->resume(done);
 }
 
@@ -869,7 +1213,14 @@ AuthSrv::updateConfig(ConstElementPtr new_config) {
 }
 
 ConstElementPtr AuthSrv::getStatistics() const {
-    return (impl_->counters_.get());
+    Counters counters;
+    counters.add(impl_->retired_counters_);
+    impl_->addCounters(impl_->main_context_, counters);
+    BOOST_FOREACH(const AuthWorkerPtr& worker, impl_->workers_) {
+        impl_->addCounters(worker->getContext(), counters);
+    }
+    counters.setAnswerCacheStatistics(impl_->answer_cache_.getStatistics());
+    return (counters.get());
 }
 
 const AddressList&
@@ -877,12 +1228,98 @@ AuthSrv::getListenAddresses() const {
     return (impl_->listen_addresses_);
 }
 
+namespace {
+// Reopen the current listening sockets so that changes in the setup of
+// the UDP servers take effect.
+void
+reinstallListenAddresses(AuthSrv& server) {
+    // A copy of the addresses is needed as the original is updated
+    // in setListenAddresses().
+    const AddressList addresses(server.getListenAddresses());
+    server.setListenAddresses(addresses);
+}
+}
+
 void
 AuthSrv::setListenAddresses(const AddressList& addresses) {
+    // The UDP servers of the worker threads can't be safely touched while
+    // the threads are running, so we always start over with a new set of
+    // workers (it's only done on reconfiguration).
+    impl_->resetWorkers();
+
     // For UDP servers we specify the "SYNC_OK" option because in our usage
     // it can act in the synchronous mode.
-    installListenAddresses(addresses, impl_->listen_addresses_, *dnss_,
-                           DNSService::SERVER_SYNC_OK);
+    if (impl_->workers_.empty()) {
+        dnss_->setUDPBatchSize(impl_->udp_batch_size_);
+        installListenAddresses(addresses, impl_->listen_addresses_, *dnss_,
+                               DNSService::SERVER_SYNC_OK);
+        return;
+    }
+    WorkersDNSService workers_service(*dnss_, impl_->workers_);
+    workers_service.setUDPBatchSize(impl_->udp_batch_size_);
+    try {
+        installListenAddresses(addresses, impl_->listen_addresses_,
+                               workers_service, DNSService::SERVER_SYNC_OK);
+    } catch (...) {
+        // installListenAddresses() may have restored the old addresses.
+        impl_->startWorkers();
+        throw;
+    }
+    impl_->startWorkers();
+}
+
+void
+AuthSrv::setWorkerThreads(size_t worker_threads) {
+    if (worker_threads == impl_->worker_threads_) {
+        return;
+    }
+    LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_WORKER_THREADS).
+        arg(worker_threads);
+    impl_->worker_threads_ = worker_threads;
+    if (dnss_ != NULL) {
+        // Reopen the current sockets so they are served by the new workers.
+        reinstallListenAddresses(*this);
+    }
+}
+
+size_t
+AuthSrv::getWorkerThreads() const {
+    return (impl_->worker_threads_);
+}
+
+size_t
+AuthSrv::getRunningWorkerThreads() const {
+    return (impl_->workers_.size());
+}
+
+void
+AuthSrv::setUDPBatchSize(size_t batch_size) {
+    if (batch_size == 0) {
+        isc_throw(isc::InvalidParameter, "UDP batch size must not be 0");
+    }
+    if (batch_size == impl_->udp_batch_size_) {
+        return;
+    }
+    impl_->udp_batch_size_ = batch_size;
+    if (dnss_ != NULL) {
+        // The batch size is applied only to new UDP servers.
+        reinstallListenAddresses(*this);
+    }
+}
+
+size_t
+AuthSrv::getUDPBatchSize() const {
+    return (impl_->udp_batch_size_);
+}
+
+void
+AuthSrv::setAnswerCacheSize(size_t max_entries) {
+    impl_->answer_cache_.setMaxEntries(max_entries);
+}
+
+size_t
+AuthSrv::getAnswerCacheSize() const {
+    return (impl_->answer_cache_.getMaxEntries());
 }
 
 void
@@ -891,13 +1328,17 @@ AuthSrv::setDNSService(isc::asiodns::DNSServiceBase& dnss) {
 }
 
 void
-AuthSrv::setTSIGKeyRing(const boost::shared_ptr<TSIGKeyRing>* keyring) {
+AuthSrv::setTSIGKeyRing(const boost::shared_ptr<TSIGKeyRing>* keyring,
+                        Mutex* mutex)
+{
     impl_->keyring_ = keyring;
+    impl_->keyring_mutex_ = mutex;
 }
 
 void
 AuthSrv::createDDNSForwarder() {
     LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_START_DDNS_FORWARDER);
+    Mutex::Locker locker(impl_->control_mutex_);
     impl_->ddns_forwarder_.reset(
         new SocketSessionForwarderHolder("update",
                                          impl_->ddns_base_forwarder_));
@@ -905,6 +1346,7 @@ AuthSrv::createDDNSForwarder() {
 
 void
 AuthSrv::destroyDDNSForwarder() {
+    Mutex::Locker locker(impl_->control_mutex_);
     if (impl_->ddns_forwarder_) {
         LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_STOP_DDNS_FORWARDER);
         impl_->ddns_forwarder_.reset();
@@ -928,7 +1370,7 @@ hasMappedSegment(auth::DataSrcClientsMgr& mgr) {
         const std::vector<DataSourceStatus>& states(list->getStatus());
         BOOST_FOREACH(const datasrc::DataSourceStatus& status, states) {
             if (status.getSegmentState() != datasrc::SEGMENT_UNUSED &&
-                status.getSegmentType() == "mapped")
+                status.getSegmentType() != "local")
                 // We use some segment and it's not a local one, so it
                 // must be remote.
                 return true;
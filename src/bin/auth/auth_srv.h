@@ -35,6 +35,7 @@
 
 #include <asiolink/asiolink.h>
 #include <server_common/portconfig.h>
+#include <util/threads/sync.h>
 
 #include <auth/statistics.h>
 #include <auth/datasrc_clients_mgr.h>
@@ -234,14 +235,91 @@ public:
     /// \brief Assign an ASIO DNS Service queue to this Auth object
     void setDNSService(isc::asiodns::DNSServiceBase& dnss);
 
+    /// \brief Set the number of threads processing UDP queries.
+    ///
+    /// If \c worker_threads is 0 (the default), all queries are processed
+    /// in the thread running the \c IOService of this object.  Otherwise
+    /// that many separate threads are started, each reading queries from
+    /// every listening UDP socket and building responses with its own
+    /// \c Message, \c MessageRenderer and \c OutputBuffer.  TCP queries
+    /// and other events are still handled in the main thread.
+    ///
+    /// If the listening addresses have already been set, the sockets are
+    /// reopened so that they are served by the new set of threads.  In that
+    /// case this method can throw any exception that
+    /// \c setListenAddresses() can throw.
+    ///
+    /// \note Access to the data source client lists is still serialized
+    /// through the lock of \c DataSrcClientsMgr, so worker threads mainly
+    /// help with parsing and rendering.
+    ///
+    /// \param worker_threads The number of worker threads.
+    void setWorkerThreads(size_t worker_threads);
+
+    /// \brief Return the number of threads processing UDP queries.
+    ///
+    /// \throw None
+    size_t getWorkerThreads() const;
+
+    /// \brief Return the number of worker threads currently running.
+    ///
+    /// This is usually the same as \c getWorkerThreads(), but no threads
+    /// are run while there are no listening addresses.
+    ///
+    /// \throw None
+    size_t getRunningWorkerThreads() const;
+
+    /// \brief Set the batch size of the UDP servers.
+    ///
+    /// This is the maximum number of queries each UDP server receives and
+    /// answers at once (see \c DNSServiceBase::setUDPBatchSize()).  Like
+    /// \c setWorkerThreads(), if the listening addresses have already been
+    /// set, the sockets are reopened for the change to take effect, and
+    /// exceptions from \c setListenAddresses() are propagated.
+    ///
+    /// \param batch_size The batch size.  The default is 1.
+    /// \throw isc::InvalidParameter batch_size is 0
+    void setUDPBatchSize(size_t batch_size);
+
+    /// \brief Return the batch size of the UDP servers.
+    ///
+    /// \throw None
+    size_t getUDPBatchSize() const;
+
+    /// \brief Set the maximum number of responses in the answer cache.
+    ///
+    /// The answer cache keeps rendered responses to normal queries (except
+    /// TSIG signed ones) so they can be reused for later queries with the
+    /// same question and EDNS parameters.  Cached responses are dropped
+    /// whenever the data of their zone are reloaded.  0 disables the cache
+    /// (which is the default).
+    ///
+    /// \param max_entries The maximum number of cached responses.
+    /// \throw None
+    void setAnswerCacheSize(size_t max_entries);
+
+    /// \brief Return the maximum number of responses in the answer cache.
+    ///
+    /// \throw None
+    size_t getAnswerCacheSize() const;
+
     /// \brief Sets the keyring used for verifying and signing
     ///
     /// The parameter is pointer to shared pointer, because the automatic
     /// reloading routines of tsig keys replace the actual keyring object.
     /// It is expected the pointer will point to some statically-allocated
     /// object, it doesn't take ownership of it.
+    ///
+    /// If the keyring can be replaced while worker threads are running
+    /// (see \c setWorkerThreads()), \c mutex must be the lock held while
+    /// replacing it.  Each signed query then copies the shared pointer
+    /// under that lock and uses the copy.
+    ///
+    /// \param keyring Pointer to the shared pointer to the keyring.
+    /// \param mutex The lock protecting \c *keyring, if any.
     void setTSIGKeyRing(const boost::shared_ptr<isc::dns::TSIGKeyRing>*
-                        keyring);
+                        keyring,
+                        isc::util::thread::Mutex* mutex = NULL);
 
     /// \brief Create the internal forwarder for DDNS update messages
     ///
@@ -17,10 +17,12 @@
 
 #include <util/threads/thread.h>
 #include <util/threads/sync.h>
+#include <util/threads/rcu.h>
 
 #include <log/logger_support.h>
 #include <log/log_dbglevels.h>
 
+#include <dns/name.h>
 #include <dns/rrclass.h>
 
 #include <cc/data.h>
@@ -40,6 +42,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/foreach.hpp>
 
 #include <exception>
@@ -89,6 +92,18 @@ enum CommandID {
 /// \brief Callback to be called when the command is completed.
 typedef boost::function<void ()> FinishedCallback;
 
+/// \brief Callback to be called when zone data may have been replaced.
+///
+/// The parameters are the origin and RR class of the zone.  If the origin
+/// is the root name, the data of any zone of the class may have been
+/// replaced.  The callback is called in the builder thread with the lock
+/// on the data source clients held, so it must be quick and exception free.
+/// It's called only after all readers that could see the old data have
+/// finished, so anything built from the zone data after the call is
+/// guaranteed to be based on the new data.
+typedef boost::function<void (const dns::Name&, const dns::RRClass&)>
+ZoneUpdatedCallback;
+
 /// \brief The data type passed from DataSrcClientsMgr to
 ///     DataSrcClientsBuilder.
 ///
@@ -120,6 +135,78 @@ struct Command {
     FinishedCallback callback;
 };
 
+/// \brief Return whether the client lists can be used by multiple threads
+///     at the same time.
+///
+/// Only the in-memory caches are safe for concurrent lookups.  Other data
+/// source clients (which are used for zones that are not cached) are
+/// generally not, so lists containing any of them are not either.
+inline bool
+isThreadSafe(const std::map<dns::RRClass,
+             boost::shared_ptr<datasrc::ConfigurableClientList> >& lists)
+{
+    typedef std::map<dns::RRClass,
+                     boost::shared_ptr<datasrc::ConfigurableClientList> >
+        ClientListsMap;
+    for (ClientListsMap::const_iterator it = lists.begin();
+         it != lists.end(); ++it) {
+        BOOST_FOREACH(const datasrc::ConfigurableClientList::DataSourceInfo&
+                      info, it->second->getDataSources()) {
+            if (info.data_src_client_ != NULL) {
+                return (false);
+            }
+        }
+    }
+    return (true);
+}
+
+/// \brief The client lists as seen by the readers.
+///
+/// Along with the lists, it keeps whether they are thread safe (see
+/// \c isThreadSafe()), which is computed once when they are published, so
+/// the readers don't have to walk the data sources on every query.
+///
+/// Both are published together with RCU by switching \c current between
+/// two versions.  After each \c publish() the writer must wait for a grace
+/// period (\c RCU::synchronize()), so no reader can see the version that
+/// will be overwritten by the next call.
+struct PublishedClientLists {
+    typedef std::map<dns::RRClass,
+                     boost::shared_ptr<datasrc::ConfigurableClientList> >
+        ClientListsMap;
+
+    /// \brief A published version of the lists.
+    struct Version {
+        Version() : lists(NULL), thread_safe(true) {}
+        const ClientListsMap* lists;
+        bool thread_safe;
+    };
+
+    /// \brief Constructor.
+    ///
+    /// It publishes the given lists.
+    PublishedClientLists(const ClientListsMap* lists) :
+        current(NULL)
+    {
+        publish(lists);
+    }
+
+    /// \brief Make the given lists visible to the readers.
+    ///
+    /// This must be called with the lock of the lists held.
+    void publish(const ClientListsMap* lists) {
+        Version* const version =
+            (current == &versions[0]) ? &versions[1] : &versions[0];
+        version->lists = lists;
+        version->thread_safe = isThreadSafe(*lists);
+        util::thread::RCU::assign(current,
+                                  static_cast<const Version*>(version));
+    }
+
+    Version versions[2];
+    const Version* volatile current;
+};
+
 } // namespace datasrc_clientmgr_internal
 
 /// \brief Frontend to the manager object for data source clients.
@@ -176,16 +263,33 @@ public:
     /// causing a race condition with other threads that can possibly use
     /// the same manager throughout the lifetime of the holder object.
     ///
-    /// This also means the holder object is expected to have a short lifetime.
-    /// The application shouldn't try to keep it unnecessarily long.
-    /// It's normally expected to create the holder object on the stack
+    /// The holder doesn't take any lock as long as the client lists are
+    /// safe to be used by multiple threads (see \c isThreadSafe(); this is
+    /// known when the lists are published, see \c PublishedClientLists): it
+    /// marks an RCU read-side region, and the builder thread never destroys
+    /// (or modifies in place) anything a holder can see until all holders
+    /// that existed when the data were replaced are gone.  Otherwise the
+    /// holders serialize the use of the lists by a lock.
+    ///
+    /// This also means the holder object is expected to have a short lifetime,
+    /// as it delays the builder.  The application shouldn't try to keep it
+    /// unnecessarily long, and must not create another holder while it has
+    /// one.  It's normally expected to create the holder object on the stack
     /// of a small scope and automatically let it be destroyed at the end
     /// of the scope.
     class Holder {
     public:
         Holder(DataSrcClientsMgrBase& mgr) :
-            mgr_(mgr), locker_(mgr_.map_mutex_)
-        {}
+            reader_(mgr.rcu_),
+            published_(util::thread::RCU::dereference(
+                           mgr.published_lists_.current)),
+            clients_map_(published_->lists)
+        {
+            if (!published_->thread_safe) {
+                locker_.reset(new typename MutexType::Locker(
+                                  mgr.unsafe_clients_mutex_));
+            }
+        }
 
         /// \brief Find a data source client list of a specified RR class.
         ///
@@ -206,8 +310,8 @@ public:
             const dns::RRClass& rrclass)
         {
             const ClientListsMap::const_iterator
-                it = mgr_.clients_map_->find(rrclass);
-            if (it == mgr_.clients_map_->end()) {
+                it = clients_map_->find(rrclass);
+            if (it == clients_map_->end()) {
                 return (boost::shared_ptr<datasrc::ConfigurableClientList>());
             } else {
                 return (it->second);
@@ -224,16 +328,18 @@ public:
         /// \throw std::bad_alloc for problems allocating the result.
         std::vector<dns::RRClass> getClasses() const {
             std::vector<dns::RRClass> result;
-            for (ClientListsMap::const_iterator it =
-                 mgr_.clients_map_->begin(); it != mgr_.clients_map_->end();
-                 ++it) {
+            for (ClientListsMap::const_iterator it = clients_map_->begin();
+                 it != clients_map_->end(); ++it) {
                 result.push_back(it->first);
             }
             return (result);
         }
     private:
-        DataSrcClientsMgrBase& mgr_;
-        typename MutexType::Locker locker_;
+        util::thread::RCU::ReadLocker reader_;
+        const datasrc_clientmgr_internal::PublishedClientLists::Version* const
+            published_;
+        const ClientListsMap* const clients_map_;
+        boost::scoped_ptr<typename MutexType::Locker> locker_;
     };
 
     /// \brief Constructor.
@@ -252,8 +358,10 @@ public:
         clients_map_(new ClientListsMap),
         fd_guard_(new FDGuard(this)),
         read_fd_(-1), write_fd_(-1),
+        published_lists_(clients_map_.get()),
         builder_(&command_queue_, &callback_queue_, &cond_, &queue_mutex_,
-                 &clients_map_, &map_mutex_, createFds()),
+                 &clients_map_, &map_mutex_, createFds(),
+                 &zone_updated_callback_, &rcu_, &published_lists_),
         builder_thread_(boost::bind(&BuilderType::run, &builder_)),
         wakeup_socket_(service, read_fd_)
     {
@@ -337,7 +445,12 @@ public:
     /// newer tests must not use this.
     void setDataSrcClientLists(datasrc::ClientListMapPtr new_lists) {
         typename MutexType::Locker locker(map_mutex_);
-        clients_map_ = new_lists;
+        new_lists.swap(clients_map_);
+        published_lists_.publish(clients_map_.get());
+        // The old lists are released when new_lists goes out of scope,
+        // which must be after all holders that can see them are gone.
+        // This also has to be done before the next publish().
+        rcu_.synchronize();
     }
 
     /// \brief Instruct internal thread to (re)load a zone
@@ -400,6 +513,22 @@ public:
         sendCommand(datasrc_clientmgr_internal::LOADZONE, args, callback);
     }
 
+    /// \brief Set a callback to be called when zone data are replaced.
+    ///
+    /// It's called whenever the data of a zone may have been replaced,
+    /// either by loading the zone or by reconfiguring the data sources.
+    /// Users that keep anything derived from the zone data (such as
+    /// rendered answers) can use it to drop such data.  See
+    /// \c ZoneUpdatedCallback for the restrictions on the callback.
+    ///
+    /// \param callback The callback.  It can be empty to disable it.
+    void setZoneUpdatedCallback(
+        const datasrc_clientmgr_internal::ZoneUpdatedCallback& callback)
+    {
+        typename MutexType::Locker locker(map_mutex_);
+        zone_updated_callback_ = callback;
+    }
+
     void segmentInfoUpdate(const data::ConstElementPtr& args,
                            const datasrc_clientmgr_internal::FinishedCallback&
                            callback =
@@ -508,6 +637,13 @@ private:
     boost::scoped_ptr<FDGuard> fd_guard_; // A guard to close the fds.
     int read_fd_, write_fd_;    // Descriptors for wakeup
     MutexType map_mutex_;       // mutex to protect the clients map
+                                // and zone_updated_callback_ from writers
+    datasrc_clientmgr_internal::ZoneUpdatedCallback zone_updated_callback_;
+    util::thread::RCU rcu_;     // protects published_lists_ from readers
+    // The map in clients_map_, as seen by the holders
+    datasrc_clientmgr_internal::PublishedClientLists published_lists_;
+    MutexType unsafe_clients_mutex_; // serializes holders of lists that
+                                     // aren't thread safe
 
     BuilderType builder_;
     ThreadType builder_thread_; // for safety this should be placed last
@@ -562,11 +698,17 @@ public:
                               CondVarType* cond, MutexType* queue_mutex,
                               datasrc::ClientListMapPtr* clients_map,
                               MutexType* map_mutex,
-                              int wake_fd
+                              int wake_fd,
+                              const ZoneUpdatedCallback*
+                              zone_updated_callback = NULL,
+                              util::thread::RCU* rcu = NULL,
+                              PublishedClientLists* published_lists = NULL
         ) :
         command_queue_(command_queue), callback_queue_(callback_queue),
         cond_(cond), queue_mutex_(queue_mutex),
-        clients_map_(clients_map), map_mutex_(map_mutex), wake_fd_(wake_fd)
+        clients_map_(clients_map), map_mutex_(map_mutex), wake_fd_(wake_fd),
+        zone_updated_callback_(zone_updated_callback), rcu_(rcu),
+        published_lists_(published_lists)
     {}
 
     /// \brief The main loop.
@@ -587,6 +729,39 @@ private:
     // implementation really does nothing.
     void doNoop() {}
 
+    // Tell the manager's user that the data of the given zone (or all
+    // zones of the class if origin is the root) may have been replaced.
+    // This must be called with map_mutex_ held.
+    void zoneUpdated(const dns::Name& origin, const dns::RRClass& rrclass) {
+        if (zone_updated_callback_ != NULL && *zone_updated_callback_) {
+            (*zone_updated_callback_)(origin, rrclass);
+        }
+    }
+
+    // Make the current clients_map_ visible to the readers.  This must be
+    // called with map_mutex_ held.
+    void publishClientLists() {
+        if (published_lists_ != NULL) {
+            published_lists_->publish(clients_map_->get());
+        }
+    }
+
+    // Wait until all readers that could see the data replaced so far have
+    // finished.  After this, the old data can be destroyed.
+    void synchronize() {
+        if (rcu_ != NULL) {
+            rcu_->synchronize();
+        }
+    }
+
+    // Same as zoneUpdated(), for all zones of all classes in the map.
+    void zonesUpdated(const ClientListsMap& lists) {
+        for (typename ClientListsMap::const_iterator it = lists.begin();
+             it != lists.end(); ++it) {
+            zoneUpdated(dns::Name::ROOT_NAME(), it->first);
+        }
+    }
+
     void doReconfigure(const data::ConstElementPtr& config) {
         if (config) {
             LOG_INFO(auth_logger,
@@ -602,6 +777,14 @@ private:
                 {
                     typename MutexType::Locker locker(*map_mutex_);
                     new_clients_map.swap(*clients_map_);
+                    publishClientLists();
+                    // The queries can still see the old lists until the
+                    // grace period ends.  The readers don't take the lock,
+                    // so it's safe to wait with it held.
+                    synchronize();
+                    // Zones of both the old and new classes are affected.
+                    zonesUpdated(**clients_map_);
+                    zonesUpdated(*new_clients_map);
                 } // lock is released by leaving scope
                 LOG_INFO(auth_logger,
                          AUTH_DATASRC_CLIENTS_BUILDER_RECONFIGURE_SUCCESS);
@@ -635,6 +818,11 @@ private:
             const isc::data::ConstElementPtr& segment_params =
                 arg->get("segment-params");
             typename MutexType::Locker locker(*map_mutex_);
+            // The segment is remapped in place, so we need to keep the
+            // readers out while doing it.
+            boost::scoped_ptr<util::thread::RCU::ExclusiveLocker> exclusive(
+                rcu_ != NULL ? new util::thread::RCU::ExclusiveLocker(*rcu_) :
+                NULL);
             const boost::shared_ptr<isc::datasrc::ConfigurableClientList>&
                 list = (**clients_map_)[rrclass];
             if (!list) {
@@ -651,6 +839,7 @@ private:
                     .arg(rrclass).arg(name);
                 std::terminate();
             }
+            zoneUpdated(dns::Name::ROOT_NAME(), rrclass);
         } catch (const isc::dns::InvalidRRClass& irce) {
             LOG_FATAL(auth_logger,
                       AUTH_DATASRC_CLIENTS_BUILDER_SEGMENT_BAD_CLASS)
@@ -667,7 +856,8 @@ private:
     void doLoadZone(const isc::data::ConstElementPtr& arg);
     boost::shared_ptr<datasrc::memory::ZoneWriter> getZoneWriter(
         datasrc::ConfigurableClientList& client_list,
-        const dns::RRClass& rrclass, const dns::Name& origin);
+        const dns::RRClass& rrclass, const dns::Name& origin,
+        bool& zone_exists);
 
     // The following are shared with the manager
     std::list<Command>* command_queue_;
@@ -677,6 +867,9 @@ private:
     datasrc::ClientListMapPtr* clients_map_;
     MutexType* map_mutex_;
     int wake_fd_;
+    const ZoneUpdatedCallback* zone_updated_callback_; // may be NULL
+    util::thread::RCU* rcu_;                           // may be NULL
+    PublishedClientLists* published_lists_;            // may be NULL
 };
 
 // Shortcut typedef for normal use
@@ -823,8 +1016,9 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::doLoadZone(
     assert(client_list);
 
     try {
+        bool zone_exists = false;
         boost::shared_ptr<datasrc::memory::ZoneWriter> zwriter =
-            getZoneWriter(*client_list, rrclass, origin);
+            getZoneWriter(*client_list, rrclass, origin, zone_exists);
         if (!zwriter) {
             return;
         }
@@ -832,7 +1026,18 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::doLoadZone(
         zwriter->load(); // this can take time but doesn't cause a race
         {   // install() can cause a race and must be in a critical section
             typename MutexType::Locker locker(*map_mutex_);
+            // Replacing the data of an existing zone is a simple pointer
+            // swap in the zone table, which the readers can see at any
+            // time.  But adding a new zone modifies the table in place,
+            // which needs to keep them out.
+            boost::scoped_ptr<util::thread::RCU::ExclusiveLocker> exclusive(
+                !zone_exists && rcu_ != NULL ?
+                new util::thread::RCU::ExclusiveLocker(*rcu_) : NULL);
             zwriter->install();
+            exclusive.reset();
+            // The old zone data are destroyed in cleanup() below.
+            synchronize();
+            zoneUpdated(origin, rrclass);
         }
         LOG_DEBUG(auth_logger, DBG_AUTH_OPS,
                   AUTH_DATASRC_CLIENTS_BUILDER_LOAD_ZONE)
@@ -859,15 +1064,29 @@ template <typename MutexType, typename CondVarType>
 boost::shared_ptr<datasrc::memory::ZoneWriter>
 DataSrcClientsBuilderBase<MutexType, CondVarType>::getZoneWriter(
     datasrc::ConfigurableClientList& client_list,
-    const dns::RRClass& rrclass, const dns::Name& origin)
+    const dns::RRClass& rrclass, const dns::Name& origin,
+    bool& zone_exists)
 {
     // getCachedZoneWriter() could get access to an underlying data source
     // that can cause a race condition with the main thread using that data
-    // source for lookup.  So we need to protect the access here.
+    // source for lookup.  So we need to protect the access here, and keep
+    // the readers out (which don't take the lock) if there's any such
+    // data source.
     datasrc::ConfigurableClientList::ZoneWriterPair writerpair;
     {
         typename MutexType::Locker locker(*map_mutex_);
+        boost::scoped_ptr<util::thread::RCU::ExclusiveLocker> exclusive(
+            rcu_ != NULL && !isThreadSafe(**clients_map_) ?
+            new util::thread::RCU::ExclusiveLocker(*rcu_) : NULL);
+        zone_exists = client_list.find(origin, true, false).exact_match_;
         writerpair = client_list.getCachedZoneWriter(origin, false);
+        if (writerpair.first ==
+            datasrc::ConfigurableClientList::ZONE_NOT_CACHED) {
+            // There's nothing to reload, but the zone in the underlying
+            // data source may have been updated (which is usually why
+            // we are called).
+            zoneUpdated(origin, rrclass);
+        }
     }
 
     switch (writerpair.first) {
@@ -224,7 +224,8 @@ main(int argc, char* argv[]) {
 
         LOG_DEBUG(auth_logger, DBG_AUTH_START, AUTH_LOAD_TSIG);
         isc::server_common::initKeyring(*config_session);
-        auth_server->setTSIGKeyRing(&isc::server_common::keyring);
+        auth_server->setTSIGKeyRing(&isc::server_common::keyring,
+                                    &isc::server_common::keyring_mutex);
 
         // Start the data source configuration.  We pass first_time and
         // config_session for the hack described in datasrcConfigHandler.
@@ -15,6 +15,8 @@
 #ifndef STATISTICS_H
 #define STATISTICS_H 1
 
+#include <auth/answer_cache.h>
+
 #include <cc/data.h>
 
 #include <dns/message.h>
@@ -75,6 +77,8 @@ private:
         BIT_ATTRIBUTES_TYPES
     };
     std::bitset<BIT_ATTRIBUTES_TYPES> bit_attributes_;
+    // number of answer RRs of a response not built in a Message
+    boost::optional<unsigned int> res_answer_count_;
 public:
     /// \brief The constructor.
     ///
@@ -251,6 +255,28 @@ public:
     void setResponseTSIG(const bool signed_tsig) {
         bit_attributes_[RES_TSIG_SIGNED] = signed_tsig;
     }
+
+    /// \brief Return the number of answer RRs set by
+    /// \c setResponseAnswerCount().
+    ///
+    /// \return the number of answer RRs wrapped with boost::optional; it's
+    ///         converted to false if it hasn't been set.
+    /// \throw None
+    const boost::optional<unsigned int>& getResponseAnswerCount() const {
+        return (res_answer_count_);
+    }
+
+    /// \brief Set the number of answer RRs of the response.
+    ///
+    /// This is only necessary if the response isn't built in the response
+    /// \c Message, i.e., it's taken from the answer cache.  If this is set,
+    /// it's used instead of the answer count of the response \c Message.
+    ///
+    /// \param answer_count The number of answer RRs of the response
+    /// \throw None
+    void setResponseAnswerCount(const unsigned int answer_count) {
+        res_answer_count_ = answer_count;
+    }
 };
 
 /// \brief Set of DNS message counters.
@@ -308,6 +334,24 @@ public:
     void inc(const MessageAttributes& msgattrs,
              const isc::dns::Message& response, const bool done);
 
+    /// \brief Add the counters of another object to this one.
+    ///
+    /// This is used to combine the counters maintained separately by
+    /// multiple threads.
+    ///
+    /// \param other The counters to be added.
+    /// \throw None
+    void add(const Counters& other);
+
+    /// \brief Set the answer cache counters.
+    ///
+    /// The answer cache maintains its own statistics; this copies them
+    /// to the corresponding items so they are included in \c get().
+    ///
+    /// \param stats The statistics of the answer cache.
+    /// \throw None
+    void setAnswerCacheStatistics(const AnswerCache::Statistics& stats);
+
     /// \brief Get statistics counters.
     ///
     /// This method is mostly exception free. But it may still throw a
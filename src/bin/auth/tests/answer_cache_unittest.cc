@@ -0,0 +1,285 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/answer_cache.h>
+
+#include <util/buffer.h>
+
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/name.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rdataclass.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <cstring>
+#include <string>
+
+using namespace isc::dns;
+using namespace isc::util;
+using isc::auth::AnswerCache;
+using boost::lexical_cast;
+using std::string;
+
+namespace {
+
+class AnswerCacheTest : public ::testing::Test {
+protected:
+    AnswerCacheTest() :
+        cache(10), query(Message::RENDER), response_buffer(0),
+        answer_buffer(0)
+    {}
+
+    // Render a response for the given question into response_buffer
+    // and cache it.
+    void insert(const Name& qname, const RRClass& qclass = RRClass::IN(),
+                bool dnssec_ok = false)
+    {
+        Message response(Message::RENDER);
+        response.setQid(0);
+        response.setOpcode(Opcode::QUERY());
+        response.setRcode(Rcode::NOERROR());
+        response.setHeaderFlag(Message::HEADERFLAG_QR);
+        response.setHeaderFlag(Message::HEADERFLAG_AA);
+        response.addQuestion(Question(qname, qclass, RRType::A()));
+        // CNAME is used as its RDATA doesn't depend on the class.
+        RRsetPtr rrset(new RRset(qname, qclass, RRType::CNAME(),
+                                 RRTTL(3600)));
+        rrset->addRdata(rdata::generic::CNAME("cname.example.org."));
+        response.addRRset(Message::SECTION_ANSWER, rrset);
+
+        response_buffer.clear();
+        MessageRenderer renderer;
+        renderer.setBuffer(&response_buffer);
+        response.toWire(renderer);
+        renderer.setBuffer(NULL);
+
+        AnswerCache::makeKey(Question(qname, qclass, RRType::A()), false,
+                             dnssec_ok, 512, key);
+        cache.insert(key, qname, qclass, response_buffer.getData(),
+                     response_buffer.getLength());
+    }
+
+    // Prepare the response to a query of the given name and try to find it
+    // in the cache.
+    bool lookup(const Name& qname, const RRClass& qclass = RRClass::IN(),
+                bool dnssec_ok = false)
+    {
+        query.clear(Message::RENDER);
+        query.setQid(0x1035);
+        query.setHeaderFlag(Message::HEADERFLAG_RD);
+        query.addQuestion(Question(qname, qclass, RRType::A()));
+        AnswerCache::makeKey(**query.beginQuestion(), false, dnssec_ok, 512,
+                             key);
+        answer_buffer.clear();
+        return (cache.lookup(key, query, answer_buffer));
+    }
+
+    AnswerCache cache;
+    Message query;
+    string key;
+    OutputBuffer response_buffer;
+    OutputBuffer answer_buffer;
+};
+
+TEST_F(AnswerCacheTest, makeKey) {
+    string key1, key2;
+
+    // The case of the name doesn't matter.
+    AnswerCache::makeKey(Question(Name("www.example.com"), RRClass::IN(),
+                                  RRType::A()), true, false, 4096, key1);
+    AnswerCache::makeKey(Question(Name("WWW.Example.COM"), RRClass::IN(),
+                                  RRType::A()), true, false, 4096, key2);
+    EXPECT_EQ(key1, key2);
+
+    // But any other parameters do.
+    AnswerCache::makeKey(Question(Name("www.example.com"), RRClass::IN(),
+                                  RRType::AAAA()), true, false, 4096, key2);
+    EXPECT_NE(key1, key2);
+    AnswerCache::makeKey(Question(Name("www.example.com"), RRClass::CH(),
+                                  RRType::A()), true, false, 4096, key2);
+    EXPECT_NE(key1, key2);
+    AnswerCache::makeKey(Question(Name("www.example.com"), RRClass::IN(),
+                                  RRType::A()), false, false, 4096, key2);
+    EXPECT_NE(key1, key2);
+    AnswerCache::makeKey(Question(Name("www.example.com"), RRClass::IN(),
+                                  RRType::A()), true, true, 4096, key2);
+    EXPECT_NE(key1, key2);
+    AnswerCache::makeKey(Question(Name("www.example.com"), RRClass::IN(),
+                                  RRType::A()), true, false, 512, key2);
+    EXPECT_NE(key1, key2);
+}
+
+TEST_F(AnswerCacheTest, lookup) {
+    EXPECT_FALSE(lookup(Name("www.example.com")));
+
+    insert(Name("www.example.com"));
+    ASSERT_TRUE(lookup(Name("WWW.Example.COM")));
+    ASSERT_EQ(response_buffer.getLength(), answer_buffer.getLength());
+
+    // The response is patched for the query: the ID, RD flag and the case
+    // of the question name come from the query.
+    InputBuffer ib(answer_buffer.getData(), answer_buffer.getLength());
+    Message parsed(Message::PARSE);
+    parsed.fromWire(ib);
+    EXPECT_EQ(0x1035, parsed.getQid());
+    EXPECT_TRUE(parsed.getHeaderFlag(Message::HEADERFLAG_QR));
+    EXPECT_TRUE(parsed.getHeaderFlag(Message::HEADERFLAG_AA));
+    EXPECT_TRUE(parsed.getHeaderFlag(Message::HEADERFLAG_RD));
+    EXPECT_EQ(Rcode::NOERROR(), parsed.getRcode());
+    EXPECT_EQ(1, parsed.getRRCount(Message::SECTION_ANSWER));
+    EXPECT_EQ("WWW.Example.COM.",
+              (*parsed.beginQuestion())->getName().toText());
+
+    // The data following the question section is kept intact.
+    const size_t rest = 12 + Name("www.example.com").getLength() + 4;
+    EXPECT_EQ(0, memcmp(static_cast<const uint8_t*>(
+                            response_buffer.getData()) + rest,
+                        static_cast<const uint8_t*>(
+                            answer_buffer.getData()) + rest,
+                        response_buffer.getLength() - rest));
+
+    // Different parameters don't match.
+    EXPECT_FALSE(lookup(Name("www.example.com"), RRClass::CH()));
+    EXPECT_FALSE(lookup(Name("www.example.com"), RRClass::IN(), true));
+
+    const AnswerCache::Statistics stats = cache.getStatistics();
+    EXPECT_EQ(1, stats.hits);
+    EXPECT_EQ(3, stats.misses);
+    EXPECT_EQ(0, stats.evictions);
+    EXPECT_EQ(1, stats.entries);
+    EXPECT_LT(response_buffer.getLength(), stats.memory);
+}
+
+TEST_F(AnswerCacheTest, replace) {
+    insert(Name("www.example.com"));
+    const size_t memory = cache.getStatistics().memory;
+    insert(Name("www.example.com"));
+    EXPECT_EQ(1, cache.getStatistics().entries);
+    EXPECT_EQ(memory, cache.getStatistics().memory);
+}
+
+TEST_F(AnswerCacheTest, evict) {
+    cache.setMaxEntries(2);
+    insert(Name("a.example.com"));
+    insert(Name("b.example.com"));
+    // Make "a" more recently used than "b", so "b" is evicted.
+    EXPECT_TRUE(lookup(Name("a.example.com")));
+    insert(Name("c.example.com"));
+    EXPECT_TRUE(lookup(Name("a.example.com")));
+    EXPECT_FALSE(lookup(Name("b.example.com")));
+    EXPECT_TRUE(lookup(Name("c.example.com")));
+    EXPECT_EQ(1, cache.getStatistics().evictions);
+
+    // Shrinking the cache evicts more.
+    cache.setMaxEntries(1);
+    EXPECT_EQ(1, cache.getStatistics().entries);
+    EXPECT_EQ(2, cache.getStatistics().evictions);
+    EXPECT_TRUE(lookup(Name("c.example.com")));
+}
+
+TEST_F(AnswerCacheTest, disable) {
+    cache.setMaxEntries(0);
+    EXPECT_FALSE(cache.isEnabled());
+    insert(Name("www.example.com"));
+    EXPECT_FALSE(lookup(Name("www.example.com")));
+    EXPECT_EQ(0, cache.getStatistics().entries);
+    EXPECT_EQ(0, cache.getStatistics().memory);
+
+    cache.setMaxEntries(10);
+    EXPECT_TRUE(cache.isEnabled());
+    insert(Name("www.example.com"));
+    EXPECT_TRUE(lookup(Name("www.example.com")));
+}
+
+TEST_F(AnswerCacheTest, invalidate) {
+    insert(Name("example.com"));
+    insert(Name("www.example.com"));
+    insert(Name("www.example.org"));
+    insert(Name("www.example.com"), RRClass::CH());
+
+    // Only the names at or below the origin of the same class are dropped.
+    cache.invalidate(Name("Example.COM"), RRClass::IN());
+    EXPECT_FALSE(lookup(Name("example.com")));
+    EXPECT_FALSE(lookup(Name("www.example.com")));
+    EXPECT_TRUE(lookup(Name("www.example.org")));
+    EXPECT_TRUE(lookup(Name("www.example.com"), RRClass::CH()));
+    // This is not an eviction.
+    EXPECT_EQ(0, cache.getStatistics().evictions);
+
+    // The root drops everything of the class.
+    cache.invalidate(Name::ROOT_NAME(), RRClass::IN());
+    EXPECT_FALSE(lookup(Name("www.example.org")));
+    EXPECT_TRUE(lookup(Name("www.example.com"), RRClass::CH()));
+
+    // Names that sort right after the zone but are not in it are kept.
+    insert(Name("example.com"));
+    insert(Name("a.example.com"));
+    insert(Name("example-a.com"));
+    insert(Name("com"));
+    cache.invalidate(Name("example.com"), RRClass::IN());
+    EXPECT_FALSE(lookup(Name("example.com")));
+    EXPECT_FALSE(lookup(Name("a.example.com")));
+    EXPECT_TRUE(lookup(Name("example-a.com")));
+    EXPECT_TRUE(lookup(Name("com")));
+
+    cache.clear();
+    EXPECT_FALSE(lookup(Name("www.example.com"), RRClass::CH()));
+    EXPECT_EQ(0, cache.getStatistics().entries);
+    EXPECT_EQ(0, cache.getStatistics().memory);
+}
+
+// A large cache is split into shards; it should still behave as one.
+TEST_F(AnswerCacheTest, sharded) {
+    const size_t num_names = 2000;
+    cache.setMaxEntries(num_names);
+    for (size_t i = 0; i < num_names; ++i) {
+        insert(Name(lexical_cast<string>(i) + ".example.com"));
+    }
+    insert(Name("www.example.org"));
+    // The limit holds for the whole cache, even though the shards don't
+    // get exactly the same number of responses.
+    const size_t entries = cache.getStatistics().entries;
+    EXPECT_GE(num_names, entries);
+    EXPECT_EQ(num_names + 1, entries + cache.getStatistics().evictions);
+
+    cache.invalidate(Name("example.com"), RRClass::IN());
+    EXPECT_EQ(1, cache.getStatistics().entries);
+    EXPECT_TRUE(lookup(Name("www.example.org")));
+    for (size_t i = 0; i < num_names; i += 100) {
+        EXPECT_FALSE(lookup(Name(lexical_cast<string>(i) + ".example.com")));
+    }
+
+    // Responses are kept when the cache is resized.
+    insert(Name("www.example.com"));
+    cache.setMaxEntries(10);
+    EXPECT_EQ(2, cache.getStatistics().entries);
+    EXPECT_TRUE(lookup(Name("www.example.org")));
+    EXPECT_TRUE(lookup(Name("www.example.com")));
+    cache.setMaxEntries(num_names);
+    EXPECT_EQ(2, cache.getStatistics().entries);
+    EXPECT_TRUE(lookup(Name("www.example.org")));
+    EXPECT_TRUE(lookup(Name("www.example.com")));
+}
+
+}
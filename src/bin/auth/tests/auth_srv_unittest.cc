@@ -133,6 +133,17 @@ protected:
                               &dnsserv);
     }
 
+    // Check the TSIG error of the response in response_obuffer
+    void checkTSIGError(uint16_t expected_error) const {
+        InputBuffer ib(response_obuffer->getData(),
+                       response_obuffer->getLength());
+        Message m(Message::PARSE);
+        m.fromWire(ib);
+        const TSIGRecord* tsig = m.getTSIGRecord();
+        ASSERT_TRUE(tsig != NULL);
+        EXPECT_EQ(expected_error, tsig->getRdata().getError());
+    }
+
     // Helper for checking Rcode statistic counters;
     // Checks for one specific Rcode statistics counter value
     void checkRcodeCounter(const std::string& rcode_name,
@@ -1051,6 +1062,43 @@ TEST_F(AuthSrvTest, TSIGSigned) {
     checkStatisticsCounters(stats_after, expect);
 }
 
+// A keyring protected by a lock can be replaced between queries, and each
+// query uses the keyring current at that time.
+TEST_F(AuthSrvTest, TSIGWithKeyringMutex) {
+    const TSIGKey key("key:c2VjcmV0Cg==:hmac-sha1");
+    boost::shared_ptr<TSIGKeyRing> keyring(new TSIGKeyRing);
+    isc::util::thread::Mutex keyring_mutex;
+    server.setTSIGKeyRing(&keyring, &keyring_mutex);
+
+    // The key is unknown at first.
+    TSIGContext context(key);
+    UnitTestUtil::createRequestMessage(request_message, opcode, default_qid,
+                                       Name("version.bind"), RRClass::CH(),
+                                       RRType::TXT());
+    createRequestPacket(request_message, IPPROTO_UDP, &context);
+    processMessage();
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    checkTSIGError(TSIGError::BAD_KEY_CODE);
+
+    // Replace the keyring the way the configuration update does, with one
+    // having a key of the same name but a different secret.
+    {
+        boost::shared_ptr<TSIGKeyRing> new_keyring(new TSIGKeyRing);
+        new_keyring->add(TSIGKey("key:QkFECg==:hmac-sha1"));
+        isc::util::thread::Mutex::Locker locker(keyring_mutex);
+        keyring.swap(new_keyring);
+    }
+    TSIGContext context2(key);
+    UnitTestUtil::createRequestMessage(request_message, opcode, default_qid,
+                                       Name("version.bind"), RRClass::CH(),
+                                       RRType::TXT());
+    createRequestPacket(request_message, IPPROTO_UDP, &context2);
+    response_obuffer->clear();
+    processMessage();
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    checkTSIGError(TSIGError::BAD_SIG_CODE);
+}
+
 // Same test emulating the UDPServer class behavior (defined in libasiolink).
 // This is not a good test in that it assumes internal implementation details
 // of UDPServer, but we've encountered a regression due to the introduction
@@ -1276,6 +1324,44 @@ TEST_F(AuthSrvTest, queryWithInMemoryClientDNSSEC) {
                 opcode.getCode(), QR_FLAG | AA_FLAG, 1, 2, 3, 3);
 }
 
+TEST_F(AuthSrvTest, queryWithAnswerCache) {
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+    EXPECT_EQ(0, server.getAnswerCacheSize()); // disabled by default
+    server.setAnswerCacheSize(10);
+    EXPECT_EQ(10, server.getAnswerCacheSize());
+
+    // The first query is answered from the zone data, and the response is
+    // cached.
+    createDataFromFile("nsec3query_nodnssec_fromWire.wire");
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    const std::vector<uint8_t> first_response(
+        static_cast<const uint8_t*>(response_obuffer->getData()),
+        static_cast<const uint8_t*>(response_obuffer->getData()) +
+        response_obuffer->getLength());
+
+    // The same query is answered from the cache with the same response.
+    response_obuffer->clear();
+    parse_message->clear(Message::PARSE);
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    matchWireData(&first_response[0], first_response.size(),
+                  response_obuffer->getData(), response_obuffer->getLength());
+
+    // Both responses are counted the same way.
+    const ConstElementPtr stats = server.getStatistics()->
+        get("zones")->get("_SERVER_");
+    EXPECT_EQ(2, stats->get("responses")->intValue());
+    EXPECT_EQ(2, stats->get("qrysuccess")->intValue());
+    EXPECT_EQ(2, stats->get("rcode")->get("noerror")->intValue());
+    EXPECT_EQ(1, stats->get("answer_cache")->get("hits")->intValue());
+    EXPECT_EQ(1, stats->get("answer_cache")->get("misses")->intValue());
+    EXPECT_EQ(1, stats->get("answer_cache")->get("entries")->intValue());
+    EXPECT_LT(0, stats->get("answer_cache")->get("memory")->intValue());
+}
+
 TEST_F(AuthSrvTest, chQueryWithInMemoryClient) {
     // Set up the in-memory
     updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
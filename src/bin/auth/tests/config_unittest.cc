@@ -155,4 +155,69 @@ TEST_F(AuthConfigTest, tcpRecvTimeoutConfig) {
                  AuthConfigError);
 }
 
+// Try setting the answer cache size through config
+TEST_F(AuthConfigTest, answerCacheSizeConfig) {
+    configureAuthServer(server, Element::fromJSON(
+    "{ \"answer_cache_size\": 1000 }"));
+    EXPECT_EQ(1000, server.getAnswerCacheSize());
+    configureAuthServer(server, Element::fromJSON(
+    "{ \"answer_cache_size\": 0 }"));
+    EXPECT_EQ(0, server.getAnswerCacheSize());
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"answer_cache_size\": -1 }")),
+                 AuthConfigError);
+}
+
+// Try setting the UDP batch size through config
+TEST_F(AuthConfigTest, udpBatchSizeConfig) {
+    EXPECT_EQ(1, server.getUDPBatchSize());
+    configureAuthServer(server, Element::fromJSON(
+    "{ \"udp_batch_size\": 32 }"));
+    EXPECT_EQ(32, server.getUDPBatchSize());
+    EXPECT_EQ(32, dnss_.getUDPBatchSize());
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"udp_batch_size\": 0 }")),
+                 AuthConfigError);
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"udp_batch_size\": 1025 }")),
+                 AuthConfigError);
+    EXPECT_EQ(32, server.getUDPBatchSize());
+}
+
+// Try setting the number of worker threads through config
+TEST_F(AuthConfigTest, workerThreadsConfig) {
+    EXPECT_EQ(0, server.getWorkerThreads());
+    configureAuthServer(server, Element::fromJSON(
+    "{ \"worker_threads\": 2 }"));
+    EXPECT_EQ(2, server.getWorkerThreads());
+    configureAuthServer(server, Element::fromJSON(
+    "{ \"worker_threads\": 0 }"));
+    EXPECT_EQ(0, server.getWorkerThreads());
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"worker_threads\": -1 }")),
+                 AuthConfigError);
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"worker_threads\": 1025 }")),
+                 AuthConfigError);
+    EXPECT_EQ(0, server.getWorkerThreads());
+}
+
+// Worker threads are not run while there are no listening sockets
+TEST_F(AuthConfigTest, workerThreadsWithoutAddresses) {
+    EXPECT_TRUE(server.getListenAddresses().empty());
+    configureAuthServer(server, Element::fromJSON(
+    "{ \"worker_threads\": 2 }"));
+    EXPECT_EQ(2, server.getWorkerThreads());
+    EXPECT_EQ(0, server.getRunningWorkerThreads());
+
+    // Clearing the (already empty) addresses doesn't start them either.
+    server.setListenAddresses(isc::server_common::portconfig::AddressList());
+    EXPECT_EQ(2, server.getWorkerThreads());
+    EXPECT_EQ(0, server.getRunningWorkerThreads());
+
+    configureAuthServer(server, Element::fromJSON(
+    "{ \"listen_on\": [] }"));
+    EXPECT_EQ(0, server.getRunningWorkerThreads());
+}
+
 }
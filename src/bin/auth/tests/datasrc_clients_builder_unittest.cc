@@ -34,6 +34,7 @@
 
 #include <gtest/gtest.h>
 
+#include <boost/bind.hpp>
 #include <boost/function.hpp>
 
 #include <sys/types.h>
@@ -42,6 +43,8 @@
 #include <cstdlib>
 #include <string>
 #include <sstream>
+#include <utility>
+#include <vector>
 #include <cerrno>
 #include <unistd.h>
 
@@ -517,6 +520,64 @@ TEST_F(DataSrcClientsBuilderTest,
                  TestDataSrcClientsBuilder::InternalCommandError);
 }
 
+// Record the parameters of the zone updated callback
+typedef std::vector<std::pair<Name, RRClass> > ZoneUpdates;
+void
+recordZoneUpdate(ZoneUpdates* updates, const Name& origin,
+                 const RRClass& rrclass)
+{
+    updates->push_back(std::make_pair(origin, rrclass));
+}
+
+TEST_F(DataSrcClientsBuilderTest, zoneUpdatedCallback) {
+    ZoneUpdates updates;
+    const ZoneUpdatedCallback callback(boost::bind(recordZoneUpdate,
+                                                   &updates, _1, _2));
+    TestDataSrcClientsBuilder cb_builder(&command_queue, &callback_queue,
+                                         &cond, &queue_mutex, &clients_map,
+                                         &map_mutex, write_end, &callback);
+    configureZones();
+
+    // Loading a zone notifies the zone.
+    EXPECT_TRUE(cb_builder.handleCommand(
+                    Command(LOADZONE, Element::fromJSON(
+                                "{\"class\": \"IN\","
+                                " \"origin\": \"test1.example\"}"),
+                            FinishedCallback())));
+    ASSERT_EQ(1, updates.size());
+    EXPECT_EQ(Name("test1.example"), updates[0].first);
+    EXPECT_EQ(rrclass, updates[0].second);
+
+    // A failed load doesn't, as the old version of the zone is kept.
+    updates.clear();
+    ASSERT_EQ(0, std::system(INSTALL_PROG " -c " TEST_DATA_DIR
+                             "/test1-broken.zone.in "
+                             TEST_DATA_BUILDDIR "/test1.zone.copied"));
+    EXPECT_THROW(cb_builder.handleCommand(
+                     Command(LOADZONE, Element::fromJSON(
+                                 "{\"class\": \"IN\","
+                                 " \"origin\": \"test1.example\"}"),
+                             FinishedCallback())),
+                 TestDataSrcClientsBuilder::InternalCommandError);
+    EXPECT_TRUE(updates.empty());
+
+    // Reconfiguration affects all zones of both the old (IN) and new (CH)
+    // classes.
+    EXPECT_TRUE(cb_builder.handleCommand(
+                    Command(RECONFIGURE, Element::fromJSON(
+                                "{\"CH\": [{"
+                                "   \"type\": \"MasterFiles\","
+                                "   \"params\": {},"
+                                "   \"cache-enable\": true"
+                                "}]}"),
+                            FinishedCallback())));
+    ASSERT_EQ(2, updates.size());
+    EXPECT_EQ(Name::ROOT_NAME(), updates[0].first);
+    EXPECT_EQ(RRClass::CH(), updates[0].second);
+    EXPECT_EQ(Name::ROOT_NAME(), updates[1].first);
+    EXPECT_EQ(RRClass::IN(), updates[1].second);
+}
+
 TEST_F(DataSrcClientsBuilderTest, loadBrokenZone) {
     configureZones();
 
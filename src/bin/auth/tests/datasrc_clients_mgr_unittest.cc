@@ -34,6 +34,8 @@ using namespace isc::auth;
 using namespace isc::auth::datasrc_clientmgr_internal;
 
 namespace {
+typedef boost::shared_ptr<ConfigurableClientList> ListPtr;
+
 void
 shutdownCheck() {
     // Check for common points on shutdown.  The manager should have acquired
@@ -157,12 +159,11 @@ TEST(DataSrcClientsMgrTest, holder) {
         EXPECT_FALSE(holder.findClientList(RRClass::IN()));
         EXPECT_FALSE(holder.findClientList(RRClass::CH()));
         EXPECT_TRUE(holder.getClasses().empty());
-        // map should be protected here
-        EXPECT_EQ(1, FakeDataSrcClientsBuilder::map_mutex->lock_count);
-        EXPECT_EQ(0, FakeDataSrcClientsBuilder::map_mutex->unlock_count);
+        // The readers don't take the map lock; the map is protected by
+        // the RCU.
+        EXPECT_EQ(0, FakeDataSrcClientsBuilder::map_mutex->lock_count);
     }
-    // map lock has been released
-    EXPECT_EQ(1, FakeDataSrcClientsBuilder::map_mutex->unlock_count);
+    EXPECT_EQ(0, FakeDataSrcClientsBuilder::map_mutex->unlock_count);
 
     // Put something in, that should become visible.
     ConstElementPtr reconfigure_arg = Element::fromJSON(
@@ -192,11 +193,47 @@ TEST(DataSrcClientsMgrTest, holder) {
         EXPECT_FALSE(holder.findClientList(RRClass::CH()));
         EXPECT_EQ(RRClass::IN(), holder.getClasses()[0]);
     }
+    // The in-memory only lists are thread safe, so the holders never lock.
+    EXPECT_EQ(0, FakeDataSrcClientsBuilder::map_mutex->lock_count);
+}
+
+TEST(DataSrcClientsMgrTest, setDataSrcClientLists) {
+    TestDataSrcClientsMgr mgr;
+
+    ClientListMapPtr lists(new std::map<RRClass, ListPtr>);
+    lists->insert(std::pair<RRClass, ListPtr>(
+                      RRClass::CH(),
+                      ListPtr(new ConfigurableClientList(RRClass::CH()))));
+    mgr.setDataSrcClientLists(lists);
+    // The new lists are visible to the readers
+    TestDataSrcClientsMgr::Holder holder(mgr);
+    EXPECT_FALSE(holder.findClientList(RRClass::IN()));
+    EXPECT_EQ(lists->find(RRClass::CH())->second,
+              holder.findClientList(RRClass::CH()));
+}
 
-    // Duplicate lock acquisition is prohibited (only test mgr can detect
-    // this reliably, so this test may not be that useful)
-    TestDataSrcClientsMgr::Holder holder1(mgr);
-    EXPECT_THROW(TestDataSrcClientsMgr::Holder holder2(mgr), isc::Unexpected);
+TEST(DataSrcClientsMgrTest, isThreadSafe) {
+    std::map<RRClass, ListPtr> lists;
+    // Empty lists are trivially safe.
+    EXPECT_TRUE(isThreadSafe(lists));
+
+    // In-memory only data sources are safe.
+    ListPtr list(new ConfigurableClientList(RRClass::IN()));
+    list->configure(Element::fromJSON(
+                        "[{\"type\": \"MasterFiles\", \"params\": {},"
+                        "  \"cache-enable\": true}]"), true);
+    lists[RRClass::IN()] = list;
+    EXPECT_TRUE(isThreadSafe(lists));
+
+    // But others aren't.
+    list.reset(new ConfigurableClientList(RRClass::CH()));
+    list->configure(Element::fromJSON(
+                        "[{\"type\": \"sqlite3\","
+                        "  \"params\": {\"database_file\": \"" +
+                        std::string(TEST_DATA_DIR "/example.sqlite3") +
+                        "\"}, \"cache-enable\": false}]"), true);
+    lists[RRClass::CH()] = list;
+    EXPECT_FALSE(isThreadSafe(lists));
 }
 
 TEST(DataSrcClientsMgrTest, reload) {
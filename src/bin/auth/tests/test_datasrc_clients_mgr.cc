@@ -91,6 +91,7 @@ TestDataSrcClientsMgrBase::reconfigureHook() {
     assert(command_queue_.front().id == RECONFIGURE);
     try {
         clients_map_ = configureDataSource(command_queue_.front().params);
+        published_lists_.publish(clients_map_.get());
     } catch (...) {}
 }
 
@@ -162,7 +162,9 @@ public:
         TestCondVar* cond,
         TestMutex* queue_mutex,
         isc::datasrc::ClientListMapPtr* clients_map,
-        TestMutex* map_mutex, int wakeup_fd)
+        TestMutex* map_mutex, int wakeup_fd,
+        const ZoneUpdatedCallback* = NULL, util::thread::RCU* = NULL,
+        PublishedClientLists* = NULL)
     {
         FakeDataSrcClientsBuilder::started = false;
         FakeDataSrcClientsBuilder::command_queue = command_queue;
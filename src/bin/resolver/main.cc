@@ -245,6 +245,14 @@ main(int argc, char* argv[]) {
 
         LOG_INFO(resolver_logger, RESOLVER_STARTED);
         io_service.run();
+
+        // The worker threads use the cache, so they must be stopped before
+        // it's destroyed (and before the snapshot is taken).
+        resolver->stopWorkers();
+        resolver->logStatistics();
+
+        // Keep the cache for the next time we start.
+        resolver->saveCacheSnapshot();
     } catch (const std::exception& ex) {
         LOG_FATAL(resolver_logger, RESOLVER_FAILED).arg(ex.what());
         ret = 1;
@@ -17,19 +17,32 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include <netinet/in.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <vector>
 #include <cassert>
-
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/foreach.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 #include <exceptions/exceptions.h>
 
 #include <acl/dns.h>
 #include <acl/loader.h>
 
+#include <asio/io_service.hpp>
+
 #include <asiodns/asiodns.h>
 #include <asiolink/asiolink.h>
 
@@ -38,6 +51,7 @@
 #include <exceptions/exceptions.h>
 
 #include <util/buffer.h>
+#include <util/threads/thread.h>
 
 #include <dns/opcode.h>
 #include <dns/rcode.h>
@@ -49,6 +63,8 @@
 #include <dns/message.h>
 #include <dns/messagerenderer.h>
 
+#include <cache/message_cache.h>
+
 #include <server_common/client.h>
 #include <server_common/portconfig.h>
 
@@ -69,6 +85,30 @@ using namespace isc::asiodns;
 using namespace isc::asiolink;
 using namespace isc::server_common;
 using namespace isc::server_common::portconfig;
+using isc::util::thread::Thread;
+
+namespace {
+class ResolverWorker;
+typedef boost::shared_ptr<ResolverWorker> ResolverWorkerPtr;
+
+// A sanity limit of worker_threads; it's unlikely to be useful to have
+// more threads than this in practice.
+const int64_t MAX_WORKER_THREADS = 1024;
+
+// The part of the configuration that the resolution of queries depends on.
+// Each worker thread gets a copy of its own (see ResolverWorker), so the
+// workers don't share anything that configuration updates in the main
+// thread change.
+struct QuerySettings {
+    AddressList upstream;
+    AddressList upstream_root;
+    int query_timeout;
+    int client_timeout;
+    int lookup_timeout;
+    unsigned retries;
+    boost::shared_ptr<const RequestACL> query_acl;
+};
+}
 
 class ResolverImpl {
 private:
@@ -82,6 +122,11 @@ public:
         client_timeout_(4000),
         lookup_timeout_(30000),
         retries_(3),
+        cache_snapshot_interval_(0),
+        worker_threads_(0),
+        prefetch_percent_(isc::cache::MessageCache::DEFAULT_PREFETCH_PERCENT),
+        prefetch_hits_(isc::cache::MessageCache::DEFAULT_PREFETCH_HITS),
+        coalesced_count_(0),
         // we apply "reject all" (implicit default of the loader) ACL by
         // default:
         query_acl_(acl::dns::getRequestLoader().load(Element::fromJSON("[]"))),
@@ -89,6 +134,9 @@ public:
     {}
 
     ~ResolverImpl() {
+        // The workers use the settings of this object, so they are stopped
+        // first.
+        workers_.clear();
         queryShutdown();
     }
 
@@ -106,6 +154,7 @@ public:
                                         client_timeout_,
                                         lookup_timeout_,
                                         retries_);
+        configureWorkers();
     }
 
     void queryShutdown() {
@@ -115,6 +164,7 @@ public:
         if (rec_query_) {
             LOG_DEBUG(resolver_logger, RESOLVER_DBG_INIT,
                       RESOLVER_QUERY_SHUTDOWN);
+            coalesced_count_ += rec_query_->getCoalescedCount();
             delete rec_query_;
             rec_query_ = NULL;
         }
@@ -155,12 +205,38 @@ public:
     void resolve(const isc::dns::QuestionPtr& question,
         const isc::resolve::ResolverInterface::CallbackPtr& callback);
 
+    // Process a message received by the main thread; see
+    // Resolver::processMessage().
+    void processMessage(const IOMessage& io_message,
+                        MessagePtr query_message,
+                        MessagePtr answer_message,
+                        OutputBufferPtr buffer,
+                        DNSServer* server)
+    {
+        processMessage(io_message, query_message, answer_message, buffer,
+                       server, rec_query_, !upstream_.empty(), *query_acl_);
+    }
+
+    // Process a message with the given RecursiveQuery and settings; the
+    // worker threads use their own.
+    void processMessage(const IOMessage& io_message,
+                        MessagePtr query_message,
+                        MessagePtr answer_message,
+                        OutputBufferPtr buffer,
+                        DNSServer* server,
+                        RecursiveQuery* rec_query,
+                        bool forwarding,
+                        const RequestACL& query_acl);
+
     enum NormalQueryResult { RECURSION, DROPPED, ERROR };
     NormalQueryResult processNormalQuery(const IOMessage& io_message,
                                          MessagePtr query_message,
                                          MessagePtr answer_message,
                                          OutputBufferPtr buffer,
-                                         DNSServer* server);
+                                         DNSServer* server,
+                                         RecursiveQuery* rec_query,
+                                         bool forwarding,
+                                         const RequestACL& query_acl);
 
     const RequestACL& getQueryACL() const {
         return (*query_acl_);
@@ -168,8 +244,36 @@ public:
 
     void setQueryACL(boost::shared_ptr<const RequestACL> new_acl) {
         query_acl_ = new_acl;
+        configureWorkers();
     }
 
+    /// Return a copy of the current query settings.
+    QuerySettings getQuerySettings() const;
+
+    /// \brief Replace the worker threads with \c worker_threads_ new ones.
+    ///
+    /// The new workers are not started; this is done by startWorkers()
+    /// once their UDP servers have been added.
+    void resetWorkers(isc::cache::ResolverCache* cache);
+
+    /// \brief Start the threads of the workers.
+    ///
+    /// If there are no listening sockets, the workers are removed instead.
+    void startWorkers();
+
+    /// \brief Give the current query settings to the workers.
+    void configureWorkers();
+
+    /// \brief Set the prefetch policy of the cache.
+    ///
+    /// The running workers are paused meanwhile, as the cache doesn't
+    /// allow the policy to be changed while other threads use it.
+    void setPrefetchPolicy(isc::cache::ResolverCache& cache);
+
+    /// \brief Return the number of coalesced questions of the main
+    /// thread and of the workers that have been stopped.
+    uint64_t getCoalescedCount() const;
+
     /// Currently non-configurable, but will be.
     static const uint16_t DEFAULT_LOCAL_UDPSIZE = 4096;
 
@@ -192,6 +296,25 @@ public:
     /// Number of retries after timeout
     unsigned retries_;
 
+    /// File the cache snapshot is written to and loaded from
+    std::string cache_snapshot_file_;
+    /// Seconds between periodic cache snapshots, 0 if disabled
+    int cache_snapshot_interval_;
+    /// Timer for periodic cache snapshots
+    boost::scoped_ptr<IntervalTimer> cache_snapshot_timer_;
+
+    /// Number of threads resolving UDP queries (0 if done in the main one)
+    size_t worker_threads_;
+    /// The running worker threads (empty if worker_threads_ is 0)
+    std::vector<ResolverWorkerPtr> workers_;
+
+    /// Part of the TTL, in percent, in which popular messages are refreshed
+    uint32_t prefetch_percent_;
+    /// Number of lookups a message must have had to be refreshed
+    uint32_t prefetch_hits_;
+    /// Coalesced questions of the RecursiveQuery objects already destroyed
+    uint64_t coalesced_count_;
+
 private:
     /// ACL on incoming queries
     boost::shared_ptr<const RequestACL> query_acl_;
@@ -338,6 +461,286 @@ public:
     }
 };
 
+namespace {
+// A thread resolving incoming UDP queries.
+//
+// Each worker has its own IOService and DNSService for its UDP servers,
+// and its own RecursiveQuery and NameserverAddressStore, so the queries it
+// sends upstream and their state are used only by this thread; only the
+// cache is shared with the other threads.  The worker also has its own
+// copy of the query settings.  When they change, the thread is paused
+// while the copy and the RecursiveQuery are replaced (ASIO is built
+// without thread support, so handlers can't be posted to the thread);
+// its servers and running queries are kept.
+//
+// The thread is started by start() and is stopped and joined on
+// destruction, at which point all its servers are also closed.
+class ResolverWorker : boost::noncopyable {
+public:
+    ResolverWorker(ResolverImpl* impl, isc::cache::ResolverCache& cache,
+                   const QuerySettings& settings) :
+        impl_(impl), cache_(cache)
+    {
+        // Operations referring to "this" must be done in the constructor
+        // body (see Resolver::Resolver()).
+        lookup_.reset(new Lookup(*this));
+        dns_service_.reset(new DNSService(io_service_, lookup_.get(),
+                                          &answer_));
+        // The NSAS doesn't keep the resolver alive by itself.
+        nsas_resolver_.reset(new NSASResolver(*this));
+        nsas_.reset(new isc::nsas::NameserverAddressStore(nsas_resolver_));
+        setup(settings);
+    }
+
+    ~ResolverWorker() {
+        pause();
+        dns_service_->clearServers();
+        impl_->coalesced_count_ += rec_query_->getCoalescedCount();
+    }
+
+    void start() {
+        thread_.reset(new Thread(boost::bind(&ResolverWorker::run, this)));
+    }
+
+    // Stop the thread, if it's running, so that what it uses can be
+    // changed from the main thread.  Returns whether it was running, in
+    // which case it should be restarted by start().
+    bool pause() {
+        if (!thread_) {
+            return (false);
+        }
+        io_service_.stop();
+        thread_->wait();
+        thread_.reset();
+        io_service_.get_io_service().reset();
+        return (true);
+    }
+
+    // Replace the query settings.
+    void configure(const QuerySettings& settings) {
+        const bool running = pause();
+        setup(settings);
+        if (running) {
+            start();
+        }
+    }
+
+    DNSService& getDNSService() { return (*dns_service_); }
+
+private:
+    // Processes the queries received by the worker.
+    class Lookup : public DNSLookup {
+    public:
+        Lookup(ResolverWorker& worker) : worker_(worker) {}
+        virtual void operator()(const IOMessage& io_message,
+                                MessagePtr query_message,
+                                MessagePtr answer_message,
+                                OutputBufferPtr buffer,
+                                DNSServer* server) const
+        {
+            worker_.impl_->processMessage(io_message, query_message,
+                                          answer_message, buffer, server,
+                                          worker_.rec_query_.get(),
+                                          !worker_.settings_.upstream.empty(),
+                                          *worker_.settings_.query_acl);
+        }
+    private:
+        ResolverWorker& worker_;
+    };
+
+    // Lets the NSAS of the worker look up the addresses of nameservers
+    // with the RecursiveQuery of the worker.
+    class NSASResolver : public isc::resolve::ResolverInterface {
+    public:
+        NSASResolver(ResolverWorker& worker) : worker_(worker) {}
+        virtual void resolve(const QuestionPtr& question,
+                             const CallbackPtr& callback)
+        {
+            worker_.rec_query_->resolve(question, callback);
+        }
+    private:
+        ResolverWorker& worker_;
+    };
+
+    void setup(const QuerySettings& settings) {
+        settings_ = settings;
+        if (rec_query_) {
+            impl_->coalesced_count_ += rec_query_->getCoalescedCount();
+        }
+        rec_query_.reset(new RecursiveQuery(*dns_service_, *nsas_, cache_,
+                                            settings_.upstream,
+                                            settings_.upstream_root,
+                                            settings_.query_timeout,
+                                            settings_.client_timeout,
+                                            settings_.lookup_timeout,
+                                            settings_.retries));
+    }
+
+    void run() {
+        try {
+            io_service_.run();
+        } catch (const std::exception& ex) {
+            // The main thread would terminate the whole server in this
+            // case; we do the same for consistency.
+            LOG_FATAL(resolver_logger, RESOLVER_WORKER_FAILED).arg(ex.what());
+            abort();
+        }
+    }
+
+    ResolverImpl* const impl_;
+    isc::cache::ResolverCache& cache_;
+    IOService io_service_;
+    MessageAnswer answer_;
+    boost::scoped_ptr<Lookup> lookup_;
+    boost::scoped_ptr<DNSService> dns_service_;
+    boost::shared_ptr<NSASResolver> nsas_resolver_;
+    boost::scoped_ptr<isc::nsas::NameserverAddressStore> nsas_;
+    QuerySettings settings_;
+    boost::scoped_ptr<RecursiveQuery> rec_query_;
+    boost::scoped_ptr<Thread> thread_;
+};
+
+// A DNSServiceBase wrapper used to install the listening sockets when
+// worker threads are used.
+//
+// UDP sockets are served by the workers: each worker gets a UDP server
+// of its own on a duplicate of the descriptor, so they all read from the
+// same socket and the kernel distributes incoming queries among them.
+// TCP sockets stay in the main service.
+class WorkersDNSService : public DNSServiceBase {
+public:
+    WorkersDNSService(DNSServiceBase& main_service,
+                      const std::vector<ResolverWorkerPtr>& workers) :
+        main_service_(main_service), workers_(workers)
+    {
+        assert(!workers_.empty());
+    }
+
+    virtual void addServerTCPFromFD(int fd, int af) {
+        main_service_.addServerTCPFromFD(fd, af);
+    }
+
+    virtual void addServerUDPFromFD(int fd, int af,
+                                    ServerFlag options = SERVER_DEFAULT)
+    {
+        // The first worker takes over the given descriptor, and the others
+        // use their own duplicates (each server closes its own one).
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            const int worker_fd = (i == 0) ? fd : dup(fd);
+            if (worker_fd < 0) {
+                isc_throw(isc::Unexpected, "failed to duplicate UDP socket "
+                          "for a worker thread: " << strerror(errno));
+            }
+            workers_[i]->getDNSService().addServerUDPFromFD(worker_fd, af,
+                                                            options);
+        }
+    }
+
+    virtual void clearServers() {
+        main_service_.clearServers();
+        BOOST_FOREACH(const ResolverWorkerPtr& worker, workers_) {
+            worker->getDNSService().clearServers();
+        }
+    }
+
+    virtual void setTCPRecvTimeout(size_t timeout) {
+        main_service_.setTCPRecvTimeout(timeout);
+    }
+
+    virtual void setUDPBatchSize(size_t batch_size) {
+        main_service_.setUDPBatchSize(batch_size);
+        BOOST_FOREACH(const ResolverWorkerPtr& worker, workers_) {
+            worker->getDNSService().setUDPBatchSize(batch_size);
+        }
+    }
+
+    virtual IOService& getIOService() {
+        return (main_service_.getIOService());
+    }
+
+private:
+    DNSServiceBase& main_service_;
+    const std::vector<ResolverWorkerPtr>& workers_;
+};
+}
+
+QuerySettings
+ResolverImpl::getQuerySettings() const {
+    QuerySettings settings;
+    settings.upstream = upstream_;
+    settings.upstream_root = upstream_root_;
+    settings.query_timeout = query_timeout_;
+    settings.client_timeout = client_timeout_;
+    settings.lookup_timeout = lookup_timeout_;
+    settings.retries = retries_;
+    settings.query_acl = query_acl_;
+    return (settings);
+}
+
+void
+ResolverImpl::resetWorkers(isc::cache::ResolverCache* cache) {
+    // Destroy the old ones first so their sockets are closed before new
+    // ones are opened.
+    workers_.clear();
+    if (worker_threads_ == 0) {
+        return;
+    }
+    if (cache == NULL) {
+        isc_throw(isc::InvalidOperation,
+                  "worker threads can't be started without a cache");
+    }
+    const QuerySettings settings(getQuerySettings());
+    for (size_t i = 0; i < worker_threads_; ++i) {
+        workers_.push_back(ResolverWorkerPtr(
+                               new ResolverWorker(this, *cache, settings)));
+    }
+}
+
+void
+ResolverImpl::startWorkers() {
+    // Without any sockets the IOService of a worker has nothing to wait
+    // for, and as ASIO is built without thread support, its run() would
+    // spin instead of blocking.  Such workers would be useless anyway.
+    if (listen_.empty()) {
+        workers_.clear();
+        return;
+    }
+    BOOST_FOREACH(const ResolverWorkerPtr& worker, workers_) {
+        worker->start();
+    }
+}
+
+void
+ResolverImpl::configureWorkers() {
+    if (workers_.empty()) {
+        return;
+    }
+    const QuerySettings settings(getQuerySettings());
+    BOOST_FOREACH(const ResolverWorkerPtr& worker, workers_) {
+        worker->configure(settings);
+    }
+}
+
+void
+ResolverImpl::setPrefetchPolicy(isc::cache::ResolverCache& cache) {
+    std::vector<ResolverWorkerPtr> paused;
+    BOOST_FOREACH(const ResolverWorkerPtr& worker, workers_) {
+        if (worker->pause()) {
+            paused.push_back(worker);
+        }
+    }
+    cache.setPrefetchPolicy(prefetch_percent_, prefetch_hits_);
+    BOOST_FOREACH(const ResolverWorkerPtr& worker, paused) {
+        worker->start();
+    }
+}
+
+uint64_t
+ResolverImpl::getCoalescedCount() const {
+    return (coalesced_count_ +
+            (rec_query_ != NULL ? rec_query_->getCoalescedCount() : 0));
+}
+
 Resolver::Resolver() :
     impl_(new ResolverImpl()),
     dnss_(NULL),
@@ -373,6 +776,7 @@ void
 Resolver::setCache(isc::cache::ResolverCache& cache)
 {
     cache_ = &cache;
+    impl_->setPrefetchPolicy(cache);
 }
 
 
@@ -400,6 +804,20 @@ Resolver::processMessage(const IOMessage& io_message,
                          MessagePtr answer_message,
                          OutputBufferPtr buffer,
                          DNSServer* server)
+{
+    impl_->processMessage(io_message, query_message, answer_message, buffer,
+                          server);
+}
+
+void
+ResolverImpl::processMessage(const IOMessage& io_message,
+                             MessagePtr query_message,
+                             MessagePtr answer_message,
+                             OutputBufferPtr buffer,
+                             DNSServer* server,
+                             RecursiveQuery* rec_query,
+                             bool forwarding,
+                             const RequestACL& query_acl)
 {
     InputBuffer request_buffer(io_message.getData(), io_message.getDataSize());
     // First, check the header part.  If we fail even for the base header,
@@ -475,14 +893,15 @@ Resolver::processMessage(const IOMessage& io_message,
         makeErrorMessage(query_message, answer_message, buffer,
                          Rcode::FORMERR());
     } else {
-        const ResolverImpl::NormalQueryResult result =
-            impl_->processNormalQuery(io_message, query_message,
-                                      answer_message, buffer, server);
-        if (result == ResolverImpl::RECURSION) {
+        const NormalQueryResult result =
+            processNormalQuery(io_message, query_message, answer_message,
+                               buffer, server, rec_query, forwarding,
+                               query_acl);
+        if (result == RECURSION) {
             // The RecursiveQuery object will post the "resume" event to the
             // DNSServer when an answer arrives, so we don't have to do it now.
             return;
-        } else if (result == ResolverImpl::DROPPED) {
+        } else if (result == DROPPED) {
             send_answer = false;
         }
     }
@@ -502,7 +921,10 @@ ResolverImpl::processNormalQuery(const IOMessage& io_message,
                                  MessagePtr query_message,
                                  MessagePtr answer_message,
                                  OutputBufferPtr buffer,
-                                 DNSServer* server)
+                                 DNSServer* server,
+                                 RecursiveQuery* rec_query,
+                                 bool forwarding,
+                                 const RequestACL& query_acl)
 {
     const ConstQuestionPtr question = *query_message->beginQuestion();
     const RRType qtype = question->getType();
@@ -512,9 +934,9 @@ ResolverImpl::processNormalQuery(const IOMessage& io_message,
     // Apply query ACL
     const Client client(io_message);
     const BasicAction query_action(
-        getQueryACL().execute(acl::dns::RequestContext(
-                                  client.getRequestSourceIPAddress(),
-                                  query_message->getTSIGRecord())));
+        query_acl.execute(acl::dns::RequestContext(
+                              client.getRequestSourceIPAddress(),
+                              query_message->getTSIGRecord())));
     if (query_action == isc::acl::REJECT) {
         LOG_INFO(resolver_logger, RESOLVER_QUERY_REJECTED)
             .arg(question->getName()).arg(qtype).arg(qclass).arg(client);
@@ -560,14 +982,14 @@ ResolverImpl::processNormalQuery(const IOMessage& io_message,
     }
 
     // Everything is okay.  Start resolver.
-    if (upstream_.empty()) {
+    if (!forwarding) {
         // Processing normal query
         LOG_DEBUG(resolver_logger, RESOLVER_DBG_IO, RESOLVER_NORMAL_QUERY);
-        rec_query_->resolve(*question, answer_message, buffer, server);
+        rec_query->resolve(*question, answer_message, buffer, server);
     } else {
         // Processing forward query
         LOG_DEBUG(resolver_logger, RESOLVER_DBG_IO, RESOLVER_FORWARD_QUERY);
-        rec_query_->forward(query_message, answer_message, buffer, server);
+        rec_query->forward(query_message, answer_message, buffer, server);
     }
 
     return (RECURSION);
@@ -598,6 +1020,55 @@ Resolver::updateConfig(ConstElementPtr config, bool startup) {
         int ctimeout = impl_->client_timeout_;
         int ltimeout = impl_->lookup_timeout_;
         unsigned retries = impl_->retries_;
+        const ConstElementPtr snapshotFileE(
+            config->get("cache_snapshot_file"));
+        const ConstElementPtr snapshotIntervalE(
+            config->get("cache_snapshot_interval"));
+        std::string snapshot_file = impl_->cache_snapshot_file_;
+        int snapshot_interval = impl_->cache_snapshot_interval_;
+        const ConstElementPtr workerThreadsE(config->get("worker_threads"));
+        int64_t worker_threads = impl_->worker_threads_;
+        if (workerThreadsE) {
+            worker_threads = workerThreadsE->intValue();
+            if (worker_threads < 0 || worker_threads > MAX_WORKER_THREADS) {
+                LOG_ERROR(resolver_logger, RESOLVER_BAD_WORKER_THREADS)
+                          .arg(worker_threads);
+                isc_throw(BadValue, "Invalid number of worker threads");
+            }
+        }
+        const ConstElementPtr prefetchPercentE(
+            config->get("prefetch_percent"));
+        const ConstElementPtr prefetchHitsE(config->get("prefetch_hits"));
+        int64_t prefetch_percent = impl_->prefetch_percent_;
+        int64_t prefetch_hits = impl_->prefetch_hits_;
+        if (prefetchPercentE) {
+            prefetch_percent = prefetchPercentE->intValue();
+            if (prefetch_percent < 0 || prefetch_percent > 100) {
+                LOG_ERROR(resolver_logger, RESOLVER_BAD_PREFETCH_PERCENT)
+                          .arg(prefetch_percent);
+                isc_throw(BadValue, "Invalid prefetch percent");
+            }
+        }
+        if (prefetchHitsE) {
+            prefetch_hits = prefetchHitsE->intValue();
+            if (prefetch_hits < 0 || prefetch_hits > 0xffffffff) {
+                LOG_ERROR(resolver_logger, RESOLVER_BAD_PREFETCH_HITS)
+                          .arg(prefetch_hits);
+                isc_throw(BadValue, "Invalid prefetch hits");
+            }
+        }
+        if (snapshotFileE) {
+            snapshot_file = snapshotFileE->stringValue();
+        }
+        if (snapshotIntervalE) {
+            snapshot_interval = snapshotIntervalE->intValue();
+            if (snapshot_interval < 0) {
+                LOG_ERROR(resolver_logger,
+                          RESOLVER_NEGATIVE_SNAPSHOT_INTERVAL)
+                          .arg(snapshot_interval);
+                isc_throw(BadValue, "Negative cache snapshot interval");
+            }
+        }
         ConstElementPtr qtimeoutE(config->get("timeout_query")),
                         ctimeoutE(config->get("timeout_client")),
                         ltimeoutE(config->get("timeout_lookup")),
@@ -651,6 +1122,12 @@ Resolver::updateConfig(ConstElementPtr config, bool startup) {
             setListenAddresses(listenAddresses);
             need_query_restart = true;
         }
+        if (workerThreadsE) {
+            // This reopens the sockets as well; on startup there are none
+            // yet, and the workers are started with the listen addresses
+            // below.
+            setWorkerThreads(worker_threads);
+        }
         if (forwardAddressesE) {
             setForwardAddresses(forwardAddresses);
             need_query_restart = true;
@@ -666,6 +1143,16 @@ Resolver::updateConfig(ConstElementPtr config, bool startup) {
         if (query_acl) {
             setQueryACL(query_acl);
         }
+        if (prefetchPercentE || prefetchHitsE) {
+            setPrefetchPolicy(prefetch_percent, prefetch_hits);
+        }
+        if (snapshotFileE || snapshotIntervalE) {
+            setCacheSnapshot(snapshot_file, snapshot_interval);
+            // Fill the cache before we start answering queries.
+            if (startup && cache_ != NULL) {
+                loadCacheSnapshot();
+            }
+        }
         if (startup && listenAddressesE) {
             setListenAddresses(listenAddresses);
             need_query_restart = true;
@@ -714,7 +1201,98 @@ Resolver::getRootAddresses() const {
 
 void
 Resolver::setListenAddresses(const AddressList& addresses) {
-    installListenAddresses(addresses, impl_->listen_, *dnss_);
+    // The UDP servers of the worker threads can't be safely touched while
+    // the threads are running, so we always start over with a new set of
+    // workers (it's only done on reconfiguration).
+    impl_->resetWorkers(cache_);
+
+    if (impl_->workers_.empty()) {
+        installListenAddresses(addresses, impl_->listen_, *dnss_);
+        return;
+    }
+    WorkersDNSService workers_service(*dnss_, impl_->workers_);
+    try {
+        installListenAddresses(addresses, impl_->listen_, workers_service);
+    } catch (...) {
+        // installListenAddresses() may have restored the old addresses.
+        impl_->startWorkers();
+        throw;
+    }
+    impl_->startWorkers();
+}
+
+namespace {
+// Reopen the current listening sockets so that changes in the setup of
+// the UDP servers take effect.
+void
+reinstallListenAddresses(Resolver& resolver) {
+    // A copy of the addresses is needed as the original is updated
+    // in setListenAddresses().
+    const AddressList addresses(resolver.getListenAddresses());
+    resolver.setListenAddresses(addresses);
+}
+}
+
+void
+Resolver::setWorkerThreads(size_t worker_threads) {
+    if (worker_threads == impl_->worker_threads_) {
+        return;
+    }
+    LOG_DEBUG(resolver_logger, RESOLVER_DBG_CONFIG, RESOLVER_WORKER_THREADS)
+              .arg(worker_threads);
+    impl_->worker_threads_ = worker_threads;
+    if (dnss_ != NULL) {
+        // Reopen the current sockets so they are served by the new workers.
+        reinstallListenAddresses(*this);
+    }
+}
+
+size_t
+Resolver::getWorkerThreads() const {
+    return (impl_->worker_threads_);
+}
+
+void
+Resolver::setPrefetchPolicy(uint32_t percent, uint32_t hits) {
+    if (percent > 100) {
+        isc_throw(InvalidParameter, "prefetch percent out of range: " <<
+                  percent);
+    }
+    LOG_DEBUG(resolver_logger, RESOLVER_DBG_CONFIG, RESOLVER_PREFETCH_POLICY)
+              .arg(percent).arg(hits);
+    impl_->prefetch_percent_ = percent;
+    impl_->prefetch_hits_ = hits;
+    if (cache_ != NULL) {
+        impl_->setPrefetchPolicy(*cache_);
+    }
+}
+
+uint32_t
+Resolver::getPrefetchPercent() const {
+    return (impl_->prefetch_percent_);
+}
+
+uint32_t
+Resolver::getPrefetchHits() const {
+    return (impl_->prefetch_hits_);
+}
+
+uint64_t
+Resolver::getCoalescedCount() const {
+    return (impl_->getCoalescedCount());
+}
+
+void
+Resolver::logStatistics() const {
+    LOG_INFO(resolver_logger, RESOLVER_QUERY_STATISTICS)
+             .arg(cache_ != NULL ? cache_->getPrefetchCount() : 0)
+             .arg(cache_ != NULL ? cache_->getPrefetchSuccessCount() : 0)
+             .arg(getCoalescedCount());
+}
+
+void
+Resolver::stopWorkers() {
+    impl_->workers_.clear();
 }
 
 void
@@ -769,3 +1347,119 @@ Resolver::setQueryACL(boost::shared_ptr<const RequestACL> new_acl) {
     LOG_INFO(resolver_logger, RESOLVER_SET_QUERY_ACL);
     impl_->setQueryACL(new_acl);
 }
+
+void
+Resolver::setCacheSnapshot(const std::string& file, int interval) {
+    if (interval < 0) {
+        isc_throw(InvalidParameter, "negative cache snapshot interval: " <<
+                  interval);
+    }
+
+    impl_->cache_snapshot_file_ = file;
+    impl_->cache_snapshot_interval_ = interval;
+    if (file.empty() || interval == 0 || dnss_ == NULL) {
+        impl_->cache_snapshot_timer_.reset();
+        return;
+    }
+    if (!impl_->cache_snapshot_timer_) {
+        impl_->cache_snapshot_timer_.reset(
+            new IntervalTimer(dnss_->getIOService()));
+    }
+    impl_->cache_snapshot_timer_->setup(
+        boost::bind(&Resolver::saveCacheSnapshot, this), interval * 1000);
+}
+
+const std::string&
+Resolver::getCacheSnapshotFile() const {
+    return (impl_->cache_snapshot_file_);
+}
+
+int
+Resolver::getCacheSnapshotInterval() const {
+    return (impl_->cache_snapshot_interval_);
+}
+
+namespace {
+long
+millisecondsSince(const boost::posix_time::ptime& start) {
+    return ((boost::posix_time::microsec_clock::universal_time() - start).
+            total_milliseconds());
+}
+}
+
+size_t
+Resolver::loadCacheSnapshot() {
+    const std::string& file = impl_->cache_snapshot_file_;
+    if (file.empty() || cache_ == NULL) {
+        return (0);
+    }
+
+    const boost::posix_time::ptime start =
+        boost::posix_time::microsec_clock::universal_time();
+    std::ifstream ifs(file.c_str(), std::ios::binary);
+    if (!ifs) {
+        LOG_DEBUG(resolver_logger, RESOLVER_DBG_INIT,
+                  RESOLVER_CACHE_SNAPSHOT_NONE).arg(file);
+        return (0);
+    }
+    const std::vector<char> data((std::istreambuf_iterator<char>(ifs)),
+                                 std::istreambuf_iterator<char>());
+    if (ifs.bad()) {
+        LOG_WARN(resolver_logger, RESOLVER_CACHE_SNAPSHOT_LOAD_FAILED)
+                 .arg(file).arg(strerror(errno));
+        return (0);
+    }
+
+    try {
+        InputBuffer buffer(data.empty() ? NULL : &data[0], data.size());
+        const size_t count = cache_->load(buffer);
+        LOG_INFO(resolver_logger, RESOLVER_CACHE_SNAPSHOT_LOADED)
+                 .arg(count).arg(data.size()).arg(file)
+                 .arg(millisecondsSince(start));
+        return (count);
+    } catch (const isc::Exception& ex) {
+        LOG_WARN(resolver_logger, RESOLVER_CACHE_SNAPSHOT_LOAD_FAILED)
+                 .arg(file).arg(ex.what());
+        return (0);
+    }
+}
+
+size_t
+Resolver::saveCacheSnapshot() {
+    const std::string& file = impl_->cache_snapshot_file_;
+    if (file.empty() || cache_ == NULL) {
+        return (0);
+    }
+
+    const boost::posix_time::ptime start =
+        boost::posix_time::microsec_clock::universal_time();
+    OutputBuffer buffer(0);
+    const size_t count = cache_->dump(buffer);
+
+    const std::string tmp_file = file + ".tmp";
+    {
+        std::ofstream ofs(tmp_file.c_str(),
+                          std::ios::binary | std::ios::trunc);
+        ofs.write(static_cast<const char*>(buffer.getData()),
+                  buffer.getLength());
+        ofs.close();
+        if (!ofs) {
+            LOG_ERROR(resolver_logger, RESOLVER_CACHE_SNAPSHOT_SAVE_FAILED)
+                      .arg(tmp_file).arg(strerror(errno));
+            std::remove(tmp_file.c_str());
+            return (0);
+        }
+    }
+    if (std::rename(tmp_file.c_str(), file.c_str()) != 0) {
+        LOG_ERROR(resolver_logger, RESOLVER_CACHE_SNAPSHOT_SAVE_FAILED)
+                  .arg(file).arg(strerror(errno));
+        std::remove(tmp_file.c_str());
+        return (0);
+    }
+
+    LOG_DEBUG(resolver_logger, RESOLVER_DBG_INIT,
+              RESOLVER_CACHE_SNAPSHOT_SAVED)
+              .arg(count).arg(buffer.getLength()).arg(file)
+              .arg(millisecondsSince(start));
+    return (count);
+}
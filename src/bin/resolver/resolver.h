@@ -177,6 +177,76 @@ public:
         uint16_t> >& addresses);
     std::vector<std::pair<std::string, uint16_t> > getListenAddresses() const;
 
+    /// \brief Set the number of threads resolving UDP queries.
+    ///
+    /// If \c worker_threads is 0 (the default), all queries are resolved
+    /// in the thread running the \c IOService of this object.  Otherwise
+    /// that many separate threads are started, each reading queries from
+    /// every listening UDP socket.  Each of them has its own \c IOService,
+    /// \c RecursiveQuery and \c NameserverAddressStore, so the upstream
+    /// queries and their state are local to the thread; only the cache
+    /// (see \c setCache()) is shared.  TCP queries and other events are
+    /// still handled in the main thread.
+    ///
+    /// If the listening addresses have already been set, the sockets are
+    /// reopened so that they are served by the new set of threads.  In that
+    /// case this method can throw any exception that
+    /// \c setListenAddresses() can throw.  A cache must be set before
+    /// any worker thread is started.
+    ///
+    /// \note Each thread learns the addresses of the nameservers by
+    /// itself, and identical questions are only combined within a thread
+    /// (see \c RecursiveQuery::resolve()).
+    ///
+    /// \param worker_threads The number of worker threads.
+    void setWorkerThreads(size_t worker_threads);
+
+    /// \brief Return the number of threads resolving UDP queries.
+    ///
+    /// \throw None
+    size_t getWorkerThreads() const;
+
+    /// \brief Stop the worker threads.
+    ///
+    /// The threads are stopped and joined, and their UDP servers are
+    /// closed, so they no longer use the cache.  This is meant to be
+    /// called on shutdown, before the cache is destroyed.  New threads
+    /// are started when the listening addresses or the number of threads
+    /// are set again.
+    void stopWorkers();
+
+    /// \brief Set when popular cached answers are refreshed.
+    ///
+    /// This is given to \c ResolverCache::setPrefetchPolicy() of the
+    /// cache, now or when it's set by \c setCache().  Running worker
+    /// threads are paused while the policy of the cache is changed.
+    ///
+    /// \exception InvalidParameter \c percent is larger than 100
+    ///
+    /// \param percent The part of the TTL, in percent, in which answers
+    /// are refreshed, or 0 to disable refreshes.
+    /// \param hits The number of lookups an answer must have had to be
+    /// refreshed.
+    void setPrefetchPolicy(uint32_t percent, uint32_t hits);
+
+    /// \brief Get the part of the TTL in which answers are refreshed.
+    uint32_t getPrefetchPercent() const;
+
+    /// \brief Get the number of lookups needed to refresh an answer.
+    uint32_t getPrefetchHits() const;
+
+    /// \brief Return the number of questions that waited for the answer
+    /// of an identical running query.
+    ///
+    /// The questions of the worker threads are only included once the
+    /// threads have been stopped or reconfigured.
+    uint64_t getCoalescedCount() const;
+
+    /// \brief Log the numbers of refreshed answers and coalesced questions.
+    ///
+    /// This is meant to be called on shutdown, after \c stopWorkers().
+    void logStatistics() const;
+
     /**
      * \short Set options related to timeouts.
      *
@@ -253,6 +323,42 @@ public:
     void setQueryACL(boost::shared_ptr<const isc::acl::dns::RequestACL>
                      new_acl);
 
+    /// \brief Set where and how often the cache snapshot is written.
+    ///
+    /// If \c file is not empty, \c saveCacheSnapshot() writes the cache
+    /// to it, and if \c interval is positive, it is also called every
+    /// \c interval seconds (once a DNS service is set).
+    ///
+    /// \exception InvalidParameter \c interval is negative
+    ///
+    /// \param file The file name of the snapshot, or empty to disable it.
+    /// \param interval The number of seconds between periodic snapshots,
+    /// or 0 to write it only when asked to.
+    void setCacheSnapshot(const std::string& file, int interval);
+
+    /// \brief Get the file name of the cache snapshot.
+    const std::string& getCacheSnapshotFile() const;
+
+    /// \brief Get the number of seconds between periodic cache snapshots.
+    int getCacheSnapshotInterval() const;
+
+    /// \brief Load the cache snapshot file into the cache.
+    ///
+    /// Failure to read the file is logged, but not otherwise reported;
+    /// the resolver can work with whatever is in the cache.
+    ///
+    /// \return The number of cache entries loaded.
+    size_t loadCacheSnapshot();
+
+    /// \brief Write the cache to the cache snapshot file.
+    ///
+    /// The snapshot is written to a temporary file first and then renamed,
+    /// so the file always contains a complete snapshot.  Failure is logged,
+    /// but not otherwise reported.
+    ///
+    /// \return The number of cache entries written.
+    size_t saveCacheSnapshot();
+
 private:
     ResolverImpl* impl_;
     isc::asiodns::DNSServiceBase* dnss_;
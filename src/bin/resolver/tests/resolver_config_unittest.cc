@@ -20,6 +20,7 @@
 #include <netdb.h>
 
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <string>
 
@@ -42,6 +43,11 @@
 
 #include <acl/acl.h>
 
+#include <cache/resolver_cache.h>
+
+#include <dns/rdataclass.h>
+#include <dns/rrset.h>
+
 #include <server_common/client.h>
 
 #include <resolver/resolver.h>
@@ -410,6 +416,154 @@ TEST_F(ResolverConfig, invalidTimeoutsConfig) {
         "}", "Negative number of retries");
 }
 
+TEST_F(ResolverConfig, cacheSnapshotConfig) {
+    // Disabled by default
+    EXPECT_EQ("", server.getCacheSnapshotFile());
+    EXPECT_EQ(0, server.getCacheSnapshotInterval());
+
+    // A positive interval would start a timer, which needs a real
+    // DNS service.
+    ConstElementPtr config = Element::fromJSON("{"
+        "\"cache_snapshot_file\": \"/tmp/resolver.cache\","
+        "\"cache_snapshot_interval\": 0"
+        "}");
+    ConstElementPtr result(server.updateConfig(config));
+    EXPECT_EQ(result->toWire(), isc::config::createAnswer()->toWire());
+    EXPECT_EQ("/tmp/resolver.cache", server.getCacheSnapshotFile());
+    EXPECT_EQ(0, server.getCacheSnapshotInterval());
+
+    EXPECT_THROW(server.setCacheSnapshot("/tmp/resolver.cache", -1),
+                 isc::InvalidParameter);
+}
+
+TEST_F(ResolverConfig, invalidCacheSnapshotConfig) {
+    invalidTest("{"
+        "\"cache_snapshot_file\": 1"
+        "}", "Wrong cache snapshot file type");
+    invalidTest("{"
+        "\"cache_snapshot_interval\": \"error\""
+        "}", "Wrong cache snapshot interval type");
+    invalidTest("{"
+        "\"cache_snapshot_interval\": -1"
+        "}", "Negative cache snapshot interval");
+}
+
+TEST_F(ResolverConfig, cacheSnapshotSaveLoad) {
+    const string file(TEST_DATA_BUILDDIR "/resolver_cache.snapshot");
+    remove(file.c_str());
+    isc::cache::ResolverCache cache;
+    server.setCache(cache);
+
+    // Nothing is written or loaded without a file.
+    EXPECT_EQ(0, server.saveCacheSnapshot());
+    EXPECT_EQ(0, server.loadCacheSnapshot());
+
+    server.setCacheSnapshot(file, 0);
+    // A missing snapshot is not an error, the cache is just left empty.
+    EXPECT_EQ(0, server.loadCacheSnapshot());
+
+    isc::dns::RRsetPtr rrset(new isc::dns::RRset(
+                                 isc::dns::Name("example.com"),
+                                 isc::dns::RRClass::IN(),
+                                 isc::dns::RRType::A(),
+                                 isc::dns::RRTTL(3600)));
+    rrset->addRdata(isc::dns::rdata::in::A("192.0.2.1"));
+    cache.update(rrset);
+    EXPECT_EQ(1, server.saveCacheSnapshot());
+
+    isc::cache::ResolverCache new_cache;
+    server.setCache(new_cache);
+    EXPECT_EQ(1, server.loadCacheSnapshot());
+    EXPECT_TRUE(new_cache.lookup(isc::dns::Name("example.com"),
+                                 isc::dns::RRType::A(),
+                                 isc::dns::RRClass::IN()));
+    remove(file.c_str());
+}
+
+TEST_F(ResolverConfig, workerThreadsConfig) {
+    // The worker threads share the cache of the resolver.
+    isc::cache::ResolverCache cache;
+    server.setCache(cache);
+
+    EXPECT_EQ(0, server.getWorkerThreads());
+    ConstElementPtr result(server.updateConfig(
+                               Element::fromJSON("{\"worker_threads\": 2}")));
+    EXPECT_EQ(result->toWire(), isc::config::createAnswer()->toWire());
+    EXPECT_EQ(2, server.getWorkerThreads());
+
+    result = server.updateConfig(
+        Element::fromJSON("{\"worker_threads\": 0}"));
+    EXPECT_EQ(result->toWire(), isc::config::createAnswer()->toWire());
+    EXPECT_EQ(0, server.getWorkerThreads());
+}
+
+TEST_F(ResolverConfig, invalidWorkerThreadsConfig) {
+    invalidTest("{"
+        "\"worker_threads\": \"error\""
+        "}", "Wrong worker threads type");
+    invalidTest("{"
+        "\"worker_threads\": -1"
+        "}", "Negative number of worker threads");
+    invalidTest("{"
+        "\"worker_threads\": 1025"
+        "}", "Too many worker threads");
+    EXPECT_EQ(0, server.getWorkerThreads());
+
+    // Worker threads can't be started without a cache.
+    EXPECT_THROW(server.setWorkerThreads(1), isc::InvalidOperation);
+}
+
+TEST_F(ResolverConfig, prefetchConfig) {
+    EXPECT_EQ(isc::cache::MessageCache::DEFAULT_PREFETCH_PERCENT,
+              server.getPrefetchPercent());
+    EXPECT_EQ(isc::cache::MessageCache::DEFAULT_PREFETCH_HITS,
+              server.getPrefetchHits());
+
+    // The policy can be set before the cache and with worker threads
+    // running.
+    ConstElementPtr result(server.updateConfig(
+                               Element::fromJSON("{\"prefetch_percent\": 20,"
+                                                 " \"prefetch_hits\": 5}")));
+    EXPECT_EQ(result->toWire(), isc::config::createAnswer()->toWire());
+    EXPECT_EQ(20, server.getPrefetchPercent());
+    EXPECT_EQ(5, server.getPrefetchHits());
+
+    isc::cache::ResolverCache cache;
+    server.setCache(cache);
+    server.setWorkerThreads(2);
+    result = server.updateConfig(
+        Element::fromJSON("{\"prefetch_percent\": 0}"));
+    EXPECT_EQ(result->toWire(), isc::config::createAnswer()->toWire());
+    EXPECT_EQ(0, server.getPrefetchPercent());
+    EXPECT_EQ(5, server.getPrefetchHits());
+    server.stopWorkers();
+
+    // Nothing has been resolved.
+    EXPECT_EQ(0, server.getCoalescedCount());
+    server.logStatistics();
+}
+
+TEST_F(ResolverConfig, invalidPrefetchConfig) {
+    invalidTest("{"
+        "\"prefetch_percent\": \"error\""
+        "}", "Wrong prefetch percent type");
+    invalidTest("{"
+        "\"prefetch_percent\": -1"
+        "}", "Negative prefetch percent");
+    invalidTest("{"
+        "\"prefetch_percent\": 101"
+        "}", "Too large prefetch percent");
+    invalidTest("{"
+        "\"prefetch_hits\": -1"
+        "}", "Negative prefetch hits");
+    EXPECT_EQ(isc::cache::MessageCache::DEFAULT_PREFETCH_PERCENT,
+              server.getPrefetchPercent());
+    EXPECT_EQ(isc::cache::MessageCache::DEFAULT_PREFETCH_HITS,
+              server.getPrefetchHits());
+
+    EXPECT_THROW(server.setPrefetchPolicy(101, 2), isc::InvalidParameter);
+}
+
 TEST_F(ResolverConfig, defaultQueryACL) {
     // If no configuration is loaded, the default ACL should reject everything.
     EXPECT_EQ(REJECT, server.getQueryACL().execute(createRequest("192.0.2.1")));
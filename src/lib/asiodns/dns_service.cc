@@ -40,7 +40,7 @@ public:
     DNSServiceImpl(IOService& io_service,
                    DNSLookup* lookup, DNSAnswer* answer) :
             io_service_(io_service), lookup_(lookup),
-            answer_(answer), tcp_recv_timeout_(5000)
+            answer_(answer), tcp_recv_timeout_(5000), udp_batch_size_(1)
     {}
 
     IOService& io_service_;
@@ -53,6 +53,7 @@ public:
     DNSLookup* lookup_;
     DNSAnswer* answer_;
     size_t tcp_recv_timeout_;
+    size_t udp_batch_size_;
 
     template<class Ptr, class Server> void addServerFromFD(int fd, int af) {
         Ptr server(new Server(io_service_.get_io_service(), fd, af,
@@ -65,7 +66,7 @@ public:
     void addSyncUDPServerFromFD(int fd, int af) {
         SyncUDPServerPtr server(SyncUDPServer::create(
                                     io_service_.get_io_service(), fd, af,
-                                    lookup_));
+                                    lookup_, udp_batch_size_));
         startServer(server);
     }
 
@@ -128,5 +129,13 @@ DNSService::setTCPRecvTimeout(size_t timeout) {
     impl_->setTCPRecvTimeout(timeout);
 }
 
+void
+DNSService::setUDPBatchSize(size_t batch_size) {
+    if (batch_size == 0) {
+        isc_throw(isc::InvalidParameter, "UDP batch size must not be 0");
+    }
+    impl_->udp_batch_size_ = batch_size;
+}
+
 } // namespace asiodns
 } // namespace isc
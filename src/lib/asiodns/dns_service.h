@@ -99,6 +99,18 @@ public:
     /// \param timeout The timeout in milliseconds
     virtual void setTCPRecvTimeout(size_t timeout) = 0;
 
+    /// \brief Set the batch size of synchronous UDP servers
+    ///
+    /// This is the maximum number of queries that a UDP server created
+    /// with the \c SERVER_SYNC_OK option receives and answers at once
+    /// (see \c SyncUDPServer).  It only affects servers which are created
+    /// after this call; existing servers need to be recreated (e.g., by
+    /// clearServers() and adding them again) to use the new value.
+    ///
+    /// \param batch_size The batch size.  The default is 1 (no batching).
+    /// \throw isc::InvalidParameter batch_size is 0
+    virtual void setUDPBatchSize(size_t batch_size) = 0;
+
     virtual asiolink::IOService& getIOService() = 0;
 };
 
@@ -201,6 +213,8 @@ public:
     virtual asiolink::IOService& getIOService() { return (io_service_);}
 
     virtual void setTCPRecvTimeout(size_t timeout);
+
+    virtual void setUDPBatchSize(size_t batch_size);
 private:
     DNSServiceImpl* impl_;
     asiolink::IOService& io_service_;
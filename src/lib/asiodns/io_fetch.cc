@@ -43,6 +43,7 @@
 
 #include <util/buffer.h>
 #include <util/random/qid_gen.h>
+#include <util/threads/sync.h>
 
 #include <asiodns/logger.h>
 
@@ -63,6 +64,19 @@ const int DBG_IMPORTANT = DBGLVL_TRACE_BASIC;
 const int DBG_COMMON = DBGLVL_TRACE_DETAIL;
 const int DBG_ALL = DBGLVL_TRACE_DETAIL + 20;
 
+namespace {
+// The QID generator is a singleton that isn't thread safe, but fetches can
+// be started from several threads (e.g. the worker threads of the
+// resolver), so its use is serialized here.
+isc::util::thread::Mutex qid_mutex;
+
+uint16_t
+generateQid() {
+    isc::util::thread::Mutex::Locker locker(qid_mutex);
+    return (QidGenerator::getInstance().generateQid());
+}
+}
+
 /// \brief IOFetch Data
 ///
 /// The data for IOFetch is held in a separate struct pointed to by a shared_ptr
@@ -150,7 +164,7 @@ struct IOFetchData {
         packet(false),
         origin(ASIODNS_UNKNOWN_ORIGIN),
         staging(),
-        qid(QidGenerator::getInstance().generateQid())
+        qid(generateQid())
     {}
 
     // Checks if the response we received was ok;
@@ -27,28 +27,80 @@
 #include <boost/bind.hpp>
 
 #include <cassert>
+#include <cstring>
+#include <vector>
 
 #include <sys/types.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>             // for some IPC/network system calls
 #include <errno.h>
 
 using namespace std;
 using namespace isc::asiolink;
 
+// The batch mode requires both system calls.
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+#define SYNC_UDP_BATCH 1
+#endif
+
 namespace isc {
 namespace asiodns {
 
+#ifdef SYNC_UDP_BATCH
+struct SyncUDPServer::BatchState {
+    BatchState(size_t batch_size) :
+        size(batch_size), data(batch_size * MAX_LENGTH), addrs(batch_size),
+        recv_iovs(batch_size), send_iovs(batch_size),
+        recv_msgs(batch_size), send_msgs(batch_size),
+        output_buffers(batch_size)
+    {
+        memset(&recv_msgs[0], 0, sizeof(recv_msgs[0]) * size);
+        memset(&send_msgs[0], 0, sizeof(send_msgs[0]) * size);
+        for (size_t i = 0; i < size; ++i) {
+            recv_iovs[i].iov_base = &data[i * MAX_LENGTH];
+            recv_iovs[i].iov_len = MAX_LENGTH;
+            recv_msgs[i].msg_hdr.msg_iov = &recv_iovs[i];
+            recv_msgs[i].msg_hdr.msg_iovlen = 1;
+            recv_msgs[i].msg_hdr.msg_name = &addrs[i];
+            send_msgs[i].msg_hdr.msg_iov = &send_iovs[i];
+            send_msgs[i].msg_hdr.msg_iovlen = 1;
+            output_buffers[i].reset(new isc::util::OutputBuffer(0));
+        }
+    }
+
+    // The maximum number of queries in a batch
+    const size_t size;
+    // Received queries, MAX_LENGTH bytes per query
+    std::vector<uint8_t> data;
+    // Sender addresses of the received queries
+    std::vector<struct sockaddr_storage> addrs;
+    // Parameters for recvmmsg() and sendmmsg()
+    std::vector<struct iovec> recv_iovs;
+    std::vector<struct iovec> send_iovs;
+    std::vector<struct mmsghdr> recv_msgs;
+    std::vector<struct mmsghdr> send_msgs;
+    // Answers to the received queries
+    std::vector<isc::util::OutputBufferPtr> output_buffers;
+};
+#else
+struct SyncUDPServer::BatchState {
+    BatchState(size_t) {}
+};
+#endif
+
 SyncUDPServerPtr
 SyncUDPServer::create(asio::io_service& io_service, const int fd,
-                      const int af, DNSLookup* lookup)
+                      const int af, DNSLookup* lookup, size_t batch_size)
 {
-    return (SyncUDPServerPtr(new SyncUDPServer(io_service, fd, af, lookup)));
+    return (SyncUDPServerPtr(new SyncUDPServer(io_service, fd, af, lookup,
+                                               batch_size)));
 }
 
 SyncUDPServer::SyncUDPServer(asio::io_service& io_service, const int fd,
-                             const int af, DNSLookup* lookup) :
+                             const int af, DNSLookup* lookup,
+                             size_t batch_size) :
     output_buffer_(new isc::util::OutputBuffer(0)),
     query_(new isc::dns::Message(isc::dns::Message::PARSE)),
     udp_endpoint_(sender_), lookup_callback_(lookup),
@@ -62,6 +114,15 @@ SyncUDPServer::SyncUDPServer(asio::io_service& io_service, const int fd,
         isc_throw(InvalidParameter, "null lookup callback given to "
                   "SyncUDPServer");
     }
+    if (batch_size == 0) {
+        isc_throw(InvalidParameter, "batch size of SyncUDPServer must not "
+                  "be 0");
+    }
+#ifdef SYNC_UDP_BATCH
+    if (batch_size > 1) {
+        batch_.reset(new BatchState(batch_size));
+    }
+#endif
     LOG_DEBUG(logger, DBGLVL_TRACE_BASIC, ASIODNS_FD_ADD_UDP).arg(fd);
     try {
         socket_.reset(new asio::ip::udp::socket(io_service));
@@ -75,6 +136,8 @@ SyncUDPServer::SyncUDPServer(asio::io_service& io_service, const int fd,
     udp_socket_.reset(new UDPSocket<DummyIOCallback>(*socket_));
 }
 
+SyncUDPServer::~SyncUDPServer() {}
+
 void
 SyncUDPServer::scheduleRead() {
     socket_->async_receive_from(
@@ -82,14 +145,14 @@ SyncUDPServer::scheduleRead() {
         boost::bind(&SyncUDPServer::handleRead, shared_from_this(), _1, _2));
 }
 
-void
-SyncUDPServer::handleRead(const asio::error_code& ec, const size_t length) {
+bool
+SyncUDPServer::checkReadError(const asio::error_code& ec) {
     if (stopped_) {
         // stopped_ can be set to true only after the socket object is closed.
         // checking this would also detect premature destruction of 'this'
         // object.
         assert(socket_ && !socket_->is_open());
-        return;
+        return (false);
     }
     if (ec) {
         using namespace asio::error;
@@ -97,41 +160,55 @@ SyncUDPServer::handleRead(const asio::error_code& ec, const size_t length) {
 
         // See TCPServer::operator() for details on error handling.
         if (err_val == operation_aborted || err_val == bad_descriptor) {
-            return;
+            return (false);
         }
         if (err_val != would_block && err_val != try_again &&
             err_val != interrupted) {
             LOG_ERROR(logger, ASIODNS_UDP_SYNC_RECEIVE_FAIL).arg(ec.message());
         }
     }
-    if (ec || length == 0) {
-        scheduleRead();
-        return;
-    }
-    // OK, we have a real packet of data. Let's dig into it!
+    return (true);
+}
 
+bool
+SyncUDPServer::processQuery(const uint8_t* data, size_t length,
+                            const isc::util::OutputBufferPtr& buffer)
+{
     // Make sure the buffers are fresh.  Note that we don't touch query_
     // because it's supposed to be cleared in lookup_callback_.  We should
     // eventually even remove this member variable (and remove it from
     // the lookup_callback_ interface, but until then, any callback
     // implementation should be careful that it's the responsibility of
     // the callback implementation.  See also #2239).
-    output_buffer_->clear();
+    buffer->clear();
 
     // Mark that we don't have an answer yet.
     done_ = false;
     resume_called_ = false;
 
     // Call the actual lookup
-    const IOMessage message(data_, length, *udp_socket_, udp_endpoint_);
-    (*lookup_callback_)(message, query_, answer_, output_buffer_, this);
+    const IOMessage message(data, length, *udp_socket_, udp_endpoint_);
+    (*lookup_callback_)(message, query_, answer_, buffer, this);
 
     if (!resume_called_) {
         isc_throw(isc::Unexpected,
                   "No resume called from the lookup callback");
     }
 
-    if (done_) {
+    return (done_);
+}
+
+void
+SyncUDPServer::handleRead(const asio::error_code& ec, const size_t length) {
+    if (!checkReadError(ec)) {
+        return;
+    }
+    if (ec || length == 0) {
+        scheduleRead();
+        return;
+    }
+    // OK, we have a real packet of data. Let's dig into it!
+    if (processQuery(data_, length, output_buffer_)) {
         // Good, there's an answer.
         socket_->send_to(asio::const_buffers_1(output_buffer_->getData(),
                                                output_buffer_->getLength()),
@@ -146,11 +223,114 @@ SyncUDPServer::handleRead(const asio::error_code& ec, const size_t length) {
     scheduleRead();
 }
 
+void
+SyncUDPServer::scheduleBatchRead() {
+    // We only wait for the socket to become readable here; the data are
+    // read in handleBatchRead().
+    socket_->async_receive(
+        asio::null_buffers(),
+        boost::bind(&SyncUDPServer::handleBatchRead, shared_from_this(),
+                    _1));
+}
+
+#ifdef SYNC_UDP_BATCH
+void
+SyncUDPServer::handleBatchRead(const asio::error_code& ec) {
+    if (!checkReadError(ec)) {
+        return;
+    }
+    if (ec) {
+        scheduleBatchRead();
+        return;
+    }
+
+    BatchState& batch = *batch_;
+    for (size_t i = 0; i < batch.size; ++i) {
+        batch.recv_msgs[i].msg_hdr.msg_namelen = sizeof(batch.addrs[i]);
+        batch.recv_msgs[i].msg_hdr.msg_flags = 0;
+    }
+    // Someone else (e.g., another server sharing the socket) may have read
+    // the data already, so we shouldn't block here.
+    const int received = recvmmsg(socket_->native(), &batch.recv_msgs[0],
+                                  batch.size, MSG_DONTWAIT, NULL);
+    if (received < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            LOG_ERROR(logger, ASIODNS_UDP_SYNC_RECEIVE_FAIL).
+                arg(strerror(errno));
+        }
+        scheduleBatchRead();
+        return;
+    }
+
+    size_t answers = 0;
+    for (int i = 0; i < received; ++i) {
+        const struct msghdr& hdr = batch.recv_msgs[i].msg_hdr;
+        if (batch.recv_msgs[i].msg_len == 0 ||
+            hdr.msg_namelen > sender_.capacity()) {
+            continue;
+        }
+        memcpy(sender_.data(), &batch.addrs[i], hdr.msg_namelen);
+        sender_.resize(hdr.msg_namelen);
+
+        const isc::util::OutputBufferPtr& buffer = batch.output_buffers[i];
+        const bool done = processQuery(&batch.data[i * MAX_LENGTH],
+                                       batch.recv_msgs[i].msg_len, buffer);
+        if (stopped_) {
+            // The callback stopped us; the socket is already closed.
+            return;
+        }
+        if (done) {
+            batch.send_iovs[answers].iov_base =
+                const_cast<void*>(buffer->getData());
+            batch.send_iovs[answers].iov_len = buffer->getLength();
+            batch.send_msgs[answers].msg_hdr.msg_name = &batch.addrs[i];
+            batch.send_msgs[answers].msg_hdr.msg_namelen = hdr.msg_namelen;
+            ++answers;
+        }
+    }
+
+    // sendmmsg() fails only if the first message can't be sent.  In that
+    // case we log it and go on with the rest.
+    size_t sent = 0;
+    while (sent < answers) {
+        const int ret = sendmmsg(socket_->native(), &batch.send_msgs[sent],
+                                 answers - sent, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const struct msghdr& hdr = batch.send_msgs[sent].msg_hdr;
+            asio::ip::udp::endpoint failed_ep;
+            memcpy(failed_ep.data(), hdr.msg_name, hdr.msg_namelen);
+            failed_ep.resize(hdr.msg_namelen);
+            LOG_ERROR(logger, ASIODNS_UDP_SYNC_SEND_FAIL).
+                arg(failed_ep.address().to_string()).arg(strerror(errno));
+            ++sent;
+        } else {
+            sent += ret;
+        }
+    }
+
+    // And wait for the next batch.
+    scheduleBatchRead();
+}
+#else
+void
+SyncUDPServer::handleBatchRead(const asio::error_code&) {
+    // This should never be called as batch_ is never set.
+    assert(false);
+}
+#endif
+
 void
 SyncUDPServer::operator()(asio::error_code, size_t) {
     // To start the server, we just schedule reading of data when they
     // arrive.
-    scheduleRead();
+    if (batch_) {
+        scheduleBatchRead();
+    } else {
+        scheduleRead();
+    }
 }
 
 /// Stop the UDPServer
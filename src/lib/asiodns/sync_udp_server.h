@@ -54,6 +54,16 @@ typedef boost::shared_ptr<SyncUDPServer> SyncUDPServerPtr;
 /// accidentally destroyed while waiting for events.  To enforce this style
 /// of creation, a static factory method is provided, and the constructor is
 /// hidden as a private.
+///
+/// If a batch size larger than 1 is given on creation and the system
+/// supports the \c recvmmsg() and \c sendmmsg() system calls, the server
+/// receives up to that many queries with a single \c recvmmsg() call
+/// once the socket is readable, calls the lookup callback for each of
+/// them, and then sends all the answers with a single \c sendmmsg() call.
+/// This reduces the system call overhead under high query rates.  Since
+/// the answers are sent together, each query in a batch is given its own
+/// output buffer.  Otherwise, the server receives and answers one query at
+/// a time.
 class SyncUDPServer : public DNSServer,
                       public boost::enable_shared_from_this<SyncUDPServer>,
                       boost::noncopyable
@@ -63,7 +73,7 @@ private:
     ///
     /// This is hidden as private (see the class description).
     SyncUDPServer(asio::io_service& io_service, const int fd, const int af,
-                  DNSLookup* lookup);
+                  DNSLookup* lookup, size_t batch_size);
 
 public:
     /// \brief Factory of SyncUDPServer object in the form of shared_ptr.
@@ -82,13 +92,21 @@ public:
     /// \param af address family, either AF_INET or AF_INET6
     /// \param lookup the callbackprovider for DNS lookup events (must not be
     ///        NULL)
+    /// \param batch_size the maximum number of queries received and
+    ///        answered at once (see the class description).  If the system
+    ///        doesn't support batched I/O, it's effectively 1.
     ///
     /// \throw isc::InvalidParameter if af is neither AF_INET nor AF_INET6
     /// \throw isc::InvalidParameter lookup is NULL
+    /// \throw isc::InvalidParameter batch_size is 0
     /// \throw isc::asiolink::IOError when a low-level error happens, like the
     ///     fd is not a valid descriptor.
     static SyncUDPServerPtr create(asio::io_service& io_service, const int fd,
-                                   const int af, DNSLookup* lookup);
+                                   const int af, DNSLookup* lookup,
+                                   size_t batch_size = 1);
+
+    /// \brief Destructor.
+    virtual ~SyncUDPServer();
 
     /// \brief Start the SyncUDPServer.
     ///
@@ -176,6 +194,10 @@ private:
     // Placeholder for error code object.  It will be passed to ASIO library
     // to have it set in case of error.
     asio::error_code ec_;
+    // Buffers and system call parameters used in the batch mode.  NULL
+    // unless the batch mode is used.
+    struct BatchState;
+    boost::scoped_ptr<BatchState> batch_;
 
     // Auxiliary functions
 
@@ -185,6 +207,18 @@ private:
     // Callback from the socket's read call (called when there's an error or
     // when a new packet comes).
     void handleRead(const asio::error_code& ec, const size_t length);
+    // Common error handling of handleRead() and handleBatchRead().  Returns
+    // true if the server should keep reading.
+    bool checkReadError(const asio::error_code& ec);
+    // Batch mode versions of scheduleRead() and handleRead().  The latter is
+    // called when the socket becomes readable.
+    void scheduleBatchRead();
+    void handleBatchRead(const asio::error_code& ec);
+    // Call the lookup callback for a query that has been received in data
+    // from the sender_ and return true if there's an answer to be sent in
+    // buffer.
+    bool processQuery(const uint8_t* data, size_t length,
+                      const isc::util::OutputBufferPtr& buffer);
 };
 
 } // namespace asiodns
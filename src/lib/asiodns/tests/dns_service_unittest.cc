@@ -21,10 +21,13 @@
 #include <asiolink/asiolink.h>
 #include <asiodns/asiodns.h>
 
+#include <boost/bind.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include <csignal>
+#include <set>
+#include <vector>
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -71,6 +74,23 @@ public:
     IOService& io_service_;
 };
 
+// A lookup callback that answers each query with a copy of it.  It records
+// the output buffer used for each query; a synchronous server in the batch
+// mode uses a separate buffer for each query of a batch, so the number of
+// different buffers tells how many queries were handled together.
+class EchoLookup : public DNSLookup {
+public:
+    void operator()(const IOMessage& io_message, isc::dns::MessagePtr,
+                    isc::dns::MessagePtr, isc::util::OutputBufferPtr buffer,
+                    DNSServer* server) const
+    {
+        buffers_.push_back(buffer.get());
+        buffer->writeData(io_message.getData(), io_message.getDataSize());
+        server->resume(true);
+    }
+    mutable std::vector<const isc::util::OutputBuffer*> buffers_;
+};
+
 // A test fixture to check creation of UDP servers from a socket FD, changing
 // options.
 class UDPDNSServiceTest : public::testing::Test {
@@ -81,6 +101,7 @@ protected:
     UDPDNSServiceTest() :
         first_buffer_(NULL), second_buffer_(NULL),
         lookup(&first_buffer_, &second_buffer_, io_service),
+        answers_(0), expected_answers_(0),
         dns_service(io_service, &lookup, NULL),
         client_socket(io_service.get_io_service(), asio::ip::udp::v6()),
         server_ep(asio::ip::address::from_string(TEST_IPV6_ADDR),
@@ -106,6 +127,27 @@ protected:
         client_socket.send_to(asio::buffer(data, sizeof(data)), server_ep);
         client_socket.close();
 
+        runIOService();
+    }
+
+    // Send the given number of queries at once, then run the service until
+    // all of them are answered (or it times out).  Returns the number of
+    // answers received.
+    size_t runServiceForAnswers(size_t count) {
+        io_service_is_time_out = false;
+        for (size_t i = 0; i < count; ++i) {
+            client_socket.send_to(asio::buffer(data, sizeof(data)),
+                                  server_ep);
+        }
+        answers_ = 0;
+        expected_answers_ = count;
+        scheduleReceive();
+        runIOService();
+        client_socket.close();
+        return (answers_);
+    }
+
+    void runIOService() {
         // set a signal-based alarm to prevent the test from hanging up
         // due to a bug.
         void (*prev_handler)(int) =
@@ -131,6 +173,24 @@ protected:
         return (!io_service_is_time_out);
     }
 
+    void scheduleReceive() {
+        client_socket.async_receive_from(
+            asio::buffer(answer_data, sizeof(answer_data)), answer_ep,
+            boost::bind(&UDPDNSServiceTest::handleAnswer, this, _1, _2));
+    }
+
+    void handleAnswer(const asio::error_code& ec, size_t length) {
+        if (!ec && length == sizeof(data) &&
+            memcmp(answer_data, data, sizeof(data)) == 0) {
+            ++answers_;
+        }
+        if (!ec && answers_ < expected_answers_) {
+            scheduleReceive();
+        } else {
+            io_service.stop();
+        }
+    }
+
     isc::util::OutputBuffer* first_buffer_;
     isc::util::OutputBuffer* second_buffer_;
     IOService io_service;
@@ -140,6 +200,10 @@ private:
     asio::ip::udp::socket client_socket;
     const asio::ip::udp::endpoint server_ep;
     char data[4];
+    char answer_data[sizeof(data) + 1];
+    asio::ip::udp::endpoint answer_ep;
+    size_t answers_;
+    size_t expected_answers_;
 
     // To access them in signal handle function, the following
     // variables have to be static.
@@ -221,6 +285,36 @@ TEST_F(UDPDNSServiceTest, syncUDPServerFromFD) {
     EXPECT_EQ(first_buffer_, second_buffer_);
 }
 
+TEST_F(UDPDNSServiceTest, syncUDPServerBatch) {
+    // All queries queued on the socket are answered.  As they are all there
+    // before the server starts, they should be received in a single batch
+    // if batched I/O is available, each with its own output buffer;
+    // otherwise they are handled one by one with the same buffer.
+    const size_t num_queries = 5;
+    EchoLookup echo_lookup;
+    DNSService service(io_service, &echo_lookup, NULL);
+    service.setUDPBatchSize(8);
+    service.addServerUDPFromFD(getSocketFD(AF_INET6, TEST_IPV6_ADDR,
+                                           TEST_SERVER_PORT),
+                               AF_INET6, DNSService::SERVER_SYNC_OK);
+    EXPECT_EQ(num_queries, runServiceForAnswers(num_queries));
+    EXPECT_TRUE(serverStopSucceed());
+    service.clearServers();
+
+    ASSERT_EQ(num_queries, echo_lookup.buffers_.size());
+    const std::set<const isc::util::OutputBuffer*> buffers(
+        echo_lookup.buffers_.begin(), echo_lookup.buffers_.end());
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+    EXPECT_EQ(num_queries, buffers.size());
+#else
+    EXPECT_EQ(1, buffers.size());
+#endif
+}
+
+TEST_F(UDPDNSServiceTest, invalidUDPBatchSize) {
+    EXPECT_THROW(dns_service.setUDPBatchSize(0), isc::InvalidParameter);
+}
+
 TEST_F(UDPDNSServiceTest, addUDPServerFromFDWithUnknownOption) {
     // Use of undefined/incompatible options should result in an exception.
     EXPECT_THROW(dns_service.addServerUDPFromFD(
@@ -13,6 +13,8 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <sstream>
+#include <dns/labelsequence.h>
+#include <dns/name_internal.h>
 #include "cache_entry_key.h"
 
 using namespace std;
@@ -37,6 +39,30 @@ genCacheEntryName(const std::string& namestr, const uint16_t type) {
     return (keystr);
 }
 
+CacheEntryKey::CacheEntryKey(const isc::dns::Name& name,
+                             const isc::dns::RRType& type,
+                             const isc::dns::RRClass& rrclass)
+{
+    size_t name_len;
+    const uint8_t* name_data =
+        isc::dns::LabelSequence(name).getData(&name_len);
+    isc::dns::name::internal::downcase(name_data, data_, name_len);
+    const uint16_t type_code = type.getCode();
+    const uint16_t class_code = rrclass.getCode();
+    data_[name_len] = type_code >> 8;
+    data_[name_len + 1] = type_code & 0xff;
+    data_[name_len + 2] = class_code >> 8;
+    data_[name_len + 3] = class_code & 0xff;
+    length_ = name_len + 4;
+
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length_; ++i) {
+        hash = (hash ^ data_[i]) * 1099511628211ULL;
+    }
+    hash_ = static_cast<size_t>(hash ^ (hash >> 32));
+}
+
 } // namespace cache
 } // namespace isc
 
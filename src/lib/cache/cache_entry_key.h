@@ -16,7 +16,9 @@
 #define CACHE_ENTRY_KEY_H
 
 #include <string>
+#include <cstring>
 #include <dns/name.h>
+#include <dns/rrclass.h>
 #include <dns/rrtype.h>
 
 namespace isc {
@@ -47,6 +49,54 @@ genCacheEntryName(const isc::dns::Name& name, const isc::dns::RRType& type);
 const std::string
 genCacheEntryName(const std::string& namestr, const uint16_t type);
 
+/// \brief The key of message/rrset entries in the cache tables.
+///
+/// It consists of the wire format of the name converted to lower case,
+/// followed by the type and class codes, so that two keys are equal if
+/// and only if the names are equal ignoring case and the types and
+/// classes are the same.  A hash value of the key is computed on
+/// construction.
+///
+/// The data is held in the object itself, so constructing a key never
+/// allocates memory; it's intended to be constructed on the stack for
+/// each lookup.
+class CacheEntryKey {
+public:
+    /// \brief Constructor
+    ///
+    /// \param name The name of the entry
+    /// \param type The RR type of the entry
+    /// \param rrclass The RR class of the entry
+    CacheEntryKey(const isc::dns::Name& name, const isc::dns::RRType& type,
+                  const isc::dns::RRClass& rrclass);
+
+    /// \brief Return the key data.
+    const uint8_t* getData() const {
+        return (data_);
+    }
+
+    /// \brief Return the length of the key data in bytes.
+    size_t getLength() const {
+        return (length_);
+    }
+
+    /// \brief Return the hash value of the key.
+    size_t getHash() const {
+        return (hash_);
+    }
+
+    /// \brief Compare two keys.
+    bool operator==(const CacheEntryKey& other) const {
+        return (hash_ == other.hash_ && length_ == other.length_ &&
+                std::memcmp(data_, other.data_, length_) == 0);
+    }
+
+private:
+    uint8_t data_[isc::dns::Name::MAX_WIRE + 4];
+    size_t length_;
+    size_t hash_;
+};
+
 } // namespace cache
 } // namespace isc
 
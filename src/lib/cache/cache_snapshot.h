@@ -0,0 +1,106 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef CACHE_SNAPSHOT_H
+#define CACHE_SNAPSHOT_H
+
+#include <exceptions/exceptions.h>
+#include <util/buffer.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <ctime>
+
+#include <stdint.h>
+
+namespace isc {
+namespace cache {
+
+/// \brief Cache Snapshot Format
+///
+/// A snapshot of the resolver cache is a sequence of big-endian fields,
+/// written and read with \c isc::util::OutputBuffer and
+/// \c isc::util::InputBuffer:
+///
+/// \code
+/// snapshot      = magic(32) version(16) class-count(16) *class-section
+/// class-section = class(16) length(32) rrsets negative-soas messages
+/// rrsets        = count(32) *rrset-entry     ; also negative-soas
+/// rrset-entry   = expire(64) trust(8) name type(16)
+///                 rdata-count(16) *rdata sig-count(16) *rdata
+/// rdata         = length(16) wire-data
+/// messages      = count(32) *message-entry
+/// message-entry = expire(64) qname qtype(16) flags(8)
+///                 answer(16) authority(16) additional(16) *rrset-ref
+/// rrset-ref     = name type(16) negative-soa(8)
+/// \endcode
+///
+/// Names are in uncompressed wire format, and expiration times are
+/// absolute (seconds since the epoch), so the snapshot can be loaded at
+/// any later time; entries that have expired by then are skipped.  The
+/// length of a class section allows sections of classes the loading
+/// cache doesn't have to be skipped.
+
+/// \brief A cache snapshot is broken or of an unknown version.
+class CacheSnapshotError : public isc::Exception {
+public:
+    CacheSnapshotError(const char* file, size_t line, const char* what) :
+        isc::Exception(file, line, what)
+    {}
+};
+
+/// \brief The first four bytes of a snapshot ("B10C").
+const uint32_t CACHE_SNAPSHOT_MAGIC = 0x42313043;
+
+/// \brief The version of the snapshot format.
+const uint16_t CACHE_SNAPSHOT_VERSION = 1;
+
+/// \brief Write an absolute time to a snapshot.
+inline void
+writeSnapshotTime(isc::util::OutputBuffer& buffer, time_t t) {
+    const uint64_t value = static_cast<uint64_t>(t);
+    buffer.writeUint32(static_cast<uint32_t>(value >> 32));
+    buffer.writeUint32(static_cast<uint32_t>(value));
+}
+
+/// \brief Read an absolute time from a snapshot.
+inline time_t
+readSnapshotTime(isc::util::InputBuffer& buffer) {
+    uint64_t value = buffer.readUint32();
+    value = (value << 32) | buffer.readUint32();
+    return (static_cast<time_t>(value));
+}
+
+/// \brief Predicate matching cache entries that expire by a given time.
+///
+/// \c T is a message or rrset entry type.
+template <typename T>
+class ExpiredBefore {
+public:
+    explicit ExpiredBefore(time_t now) : now_(now) {}
+    bool operator()(const boost::shared_ptr<T>& entry) const {
+        return (entry->getExpireTime() <= now_);
+    }
+private:
+    time_t now_;
+};
+
+} // namespace cache
+} // namespace isc
+
+#endif // CACHE_SNAPSHOT_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,334 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef CACHE_TABLE_H
+#define CACHE_TABLE_H
+
+#include <cache/cache_entry_key.h>
+#include <util/threads/sync.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace isc {
+namespace cache {
+
+/// \brief Table of cache entries with bounded size
+///
+/// This is the storage of the message and rrset caches: a hash table of
+/// entries (of type \c T, held by shared pointers) indexed by
+/// \c CacheEntryKey, holding at most a given number of entries.
+///
+/// The table is split into a number of shards, each with its own lock,
+/// so that threads using different entries rarely wait for each other.
+/// When a shard is full, an entry is evicted by the CLOCK (second chance)
+/// algorithm: the entries of the shard are in a fixed circular array, and
+/// each of them has a "referenced" flag that is set when the entry is
+/// looked up.  On eviction a "hand" sweeps the array, clearing the flags
+/// that are set, and the first entry whose flag is already clear is
+/// evicted.  This approximates LRU, but a lookup only sets a flag instead
+/// of reordering a list.
+///
+/// Small tables are not split, so the order of eviction only depends on
+/// the order of operations; this makes the behavior predictable for
+/// tests.
+template <typename T>
+class CacheTable : boost::noncopyable {
+public:
+    /// \brief Shared pointer to an entry
+    typedef boost::shared_ptr<T> EntryPtr;
+
+    /// \brief Constructor
+    ///
+    /// \param capacity The maximum number of entries in the table.
+    explicit CacheTable(size_t capacity) :
+        num_shards_(capacity >= MIN_SHARDED_CAPACITY ? NUM_SHARDS : 1),
+        shards_(new Shard[num_shards_])
+    {
+        const size_t shard_capacity = (capacity + num_shards_ - 1) /
+            num_shards_;
+        for (size_t i = 0; i < num_shards_; ++i) {
+            shards_[i].init(shard_capacity);
+        }
+    }
+
+    /// \brief Get the entry of the given key.
+    ///
+    /// \return The entry, or NULL if there's no entry of the key.
+    EntryPtr get(const CacheEntryKey& key) {
+        Shard& shard = getShard(key);
+        isc::util::thread::Mutex::Locker locker(shard.mutex);
+        const size_t index = shard.find(key, bucketIndex(shard, key));
+        if (index == NONE) {
+            return (EntryPtr());
+        }
+        Slot& slot = shard.slots[index];
+        slot.referenced = true;
+        return (slot.entry);
+    }
+
+    /// \brief Get the entry of the given key and apply an operation to it.
+    ///
+    /// This is the same as the other version, except that \c op is called
+    /// with the entry (if found) while the table is locked, so it can
+    /// update the entry without a lock of its own.  \c op must not use
+    /// the table.
+    template <typename Op>
+    EntryPtr get(const CacheEntryKey& key, Op& op) {
+        Shard& shard = getShard(key);
+        isc::util::thread::Mutex::Locker locker(shard.mutex);
+        const size_t index = shard.find(key, bucketIndex(shard, key));
+        if (index == NONE) {
+            return (EntryPtr());
+        }
+        Slot& slot = shard.slots[index];
+        slot.referenced = true;
+        op(*slot.entry);
+        return (slot.entry);
+    }
+
+    /// \brief Add an entry to the table.
+    ///
+    /// If there's an entry of the same key, it's replaced by the new one.
+    /// Otherwise, if the table is full, another entry is evicted.
+    ///
+    /// \param replaced If not NULL, it's set to the entry that was
+    /// replaced, or to NULL if there wasn't one.  Evicted entries are not
+    /// reported.
+    void add(const CacheEntryKey& key, const EntryPtr& entry,
+             EntryPtr* replaced = NULL)
+    {
+        Shard& shard = getShard(key);
+        // Declared before the locker, so the old entry is destroyed after
+        // the lock is released.
+        EntryPtr old_entry;
+        isc::util::thread::Mutex::Locker locker(shard.mutex);
+        if (shard.slots.empty()) {
+            return;
+        }
+        const size_t bucket = bucketIndex(shard, key);
+        size_t index = shard.find(key, bucket);
+        if (index != NONE) {
+            shard.slots[index].entry.swap(old_entry);
+            shard.slots[index].entry = entry;
+            if (replaced != NULL) {
+                *replaced = old_entry;
+            }
+            return;
+        }
+        if (replaced != NULL) {
+            replaced->reset();
+        }
+
+        if (shard.free != NONE) {
+            index = shard.free;
+            shard.free = shard.slots[index].next;
+        } else {
+            index = shard.evict(old_entry);
+        }
+        Slot& slot = shard.slots[index];
+        slot.key.assign(key.getData(), key.getData() + key.getLength());
+        slot.hash = key.getHash();
+        slot.entry = entry;
+        slot.referenced = false;
+        slot.next = shard.buckets[bucket];
+        shard.buckets[bucket] = index;
+        ++shard.size;
+    }
+
+    /// \brief Remove the entry of the given key.
+    ///
+    /// \return true if there was an entry of the key, false otherwise.
+    bool remove(const CacheEntryKey& key) {
+        Shard& shard = getShard(key);
+        EntryPtr old_entry;
+        isc::util::thread::Mutex::Locker locker(shard.mutex);
+        if (shard.slots.empty()) {
+            return (false);
+        }
+        const size_t index = shard.find(key, bucketIndex(shard, key));
+        if (index == NONE) {
+            return (false);
+        }
+        shard.release(index, old_entry);
+        return (true);
+    }
+
+    /// \brief Return the number of entries in the table.
+    size_t size() const {
+        size_t result = 0;
+        for (size_t i = 0; i < num_shards_; ++i) {
+            isc::util::thread::Mutex::Locker locker(shards_[i].mutex);
+            result += shards_[i].size;
+        }
+        return (result);
+    }
+
+    /// \brief Get all entries in the table.
+    ///
+    /// The entries are appended to \c entries in no particular order.
+    /// Their "referenced" flags are not changed.
+    void getEntries(std::vector<EntryPtr>& entries) const {
+        for (size_t i = 0; i < num_shards_; ++i) {
+            const Shard& shard = shards_[i];
+            isc::util::thread::Mutex::Locker locker(shard.mutex);
+            entries.reserve(entries.size() + shard.size);
+            for (size_t j = 0; j < shard.slots.size(); ++j) {
+                if (shard.slots[j].entry) {
+                    entries.push_back(shard.slots[j].entry);
+                }
+            }
+        }
+    }
+
+    /// \brief Remove all entries from the table.
+    void clear() {
+        for (size_t i = 0; i < num_shards_; ++i) {
+            std::vector<EntryPtr> old_entries;
+            isc::util::thread::Mutex::Locker locker(shards_[i].mutex);
+            shards_[i].clear(old_entries);
+        }
+    }
+
+private:
+    static const size_t MIN_SHARDED_CAPACITY = 1024;
+    static const size_t NUM_SHARDS = 16;
+    static const size_t NONE = static_cast<size_t>(-1);
+
+    struct Slot {
+        Slot() : hash(0), referenced(false), next(NONE) {}
+
+        std::vector<uint8_t> key;
+        size_t hash;
+        EntryPtr entry;
+        bool referenced;
+        // The next slot in the same bucket, or in the free list.
+        size_t next;
+    };
+
+    // A part of the table with its own lock.  The slots are allocated
+    // on construction; the unused ones are linked in a free list.
+    struct Shard {
+        Shard() : hand(0), size(0), free(NONE) {}
+
+        void init(size_t capacity) {
+            slots.resize(capacity);
+            size_t num_buckets = 1;
+            while (num_buckets < capacity) {
+                num_buckets <<= 1;
+            }
+            buckets.assign(num_buckets, NONE);
+            for (size_t i = 0; i < capacity; ++i) {
+                slots[i].next = (i + 1 < capacity) ? i + 1 : NONE;
+            }
+            free = capacity > 0 ? 0 : NONE;
+        }
+
+        size_t find(const CacheEntryKey& key, size_t bucket) const {
+            for (size_t index = buckets[bucket]; index != NONE;
+                 index = slots[index].next) {
+                const Slot& slot = slots[index];
+                if (slot.hash == key.getHash() &&
+                    slot.key.size() == key.getLength() &&
+                    std::memcmp(&slot.key[0], key.getData(),
+                                key.getLength()) == 0) {
+                    return (index);
+                }
+            }
+            return (NONE);
+        }
+
+        // Unlink the slot from its bucket and put it in the free list.
+        // The entry is moved to old_entry.
+        void release(size_t index, EntryPtr& old_entry) {
+            Slot& slot = slots[index];
+            size_t* link = &buckets[slot.hash / NUM_SHARDS &
+                                    (buckets.size() - 1)];
+            while (*link != index) {
+                link = &slots[*link].next;
+            }
+            *link = slot.next;
+            slot.entry.swap(old_entry);
+            slot.next = free;
+            free = index;
+            --size;
+        }
+
+        // Run the clock hand until an unreferenced entry is found, and
+        // make its slot free for reuse.  All slots must be in use.
+        size_t evict(EntryPtr& old_entry) {
+            while (slots[hand].referenced) {
+                slots[hand].referenced = false;
+                hand = (hand + 1) % slots.size();
+            }
+            const size_t index = hand;
+            hand = (hand + 1) % slots.size();
+            release(index, old_entry);
+            free = slots[index].next;
+            return (index);
+        }
+
+        void clear(std::vector<EntryPtr>& old_entries) {
+            old_entries.reserve(size);
+            for (size_t i = 0; i < slots.size(); ++i) {
+                if (slots[i].entry) {
+                    old_entries.push_back(EntryPtr());
+                    old_entries.back().swap(slots[i].entry);
+                }
+                slots[i].referenced = false;
+            }
+            init(slots.size());
+            hand = 0;
+            size = 0;
+        }
+
+        mutable isc::util::thread::Mutex mutex;
+        std::vector<Slot> slots;
+        std::vector<size_t> buckets;
+        size_t hand;
+        size_t size;
+        size_t free;
+    };
+
+    Shard& getShard(const CacheEntryKey& key) {
+        return (shards_[key.getHash() % num_shards_]);
+    }
+
+    static size_t bucketIndex(const Shard& shard, const CacheEntryKey& key) {
+        return (key.getHash() / NUM_SHARDS & (shard.buckets.size() - 1));
+    }
+
+    const size_t num_shards_;
+    boost::scoped_array<Shard> shards_;
+};
+
+template <typename T>
+const size_t CacheTable<T>::MIN_SHARDED_CAPACITY;
+template <typename T>
+const size_t CacheTable<T>::NUM_SHARDS;
+template <typename T>
+const size_t CacheTable<T>::NONE;
+
+} // namespace cache
+} // namespace isc
+
+#endif // CACHE_TABLE_H
+
+// Local Variables:
+// mode: c++
+// End:
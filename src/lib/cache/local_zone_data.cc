@@ -18,28 +18,44 @@
 #include "rrset_copy.h"
 #include "logger.h"
 
+#include <memory>
+
 using namespace std;
 using namespace isc::dns;
+using isc::util::thread::Mutex;
+using isc::util::thread::RCU;
 
 namespace isc {
 namespace cache {
 
-typedef pair<std::string, RRsetPtr> RRsetMapPair;
-typedef map<std::string, RRsetPtr>::iterator RRsetMapIterator;
+LocalZoneData::LocalZoneData(uint16_t) :
+    rrsets_map_(new RRsetMap)
+{}
+
+LocalZoneData::~LocalZoneData() {
+    delete rrsets_map_;
+}
 
 isc::dns::RRsetPtr
 LocalZoneData::lookup(const isc::dns::Name& name,
                       const isc::dns::RRType& type)
 {
     string key = genCacheEntryName(name, type);
-    RRsetMapIterator iter = rrsets_map_.find(key);
-    if (iter == rrsets_map_.end()) {
+    RRsetPtr rrset_ptr;
+    {
+        RCU::ReadLocker reader(rcu_);
+        const RRsetMap* rrsets_map = RCU::dereference(rrsets_map_);
+        const RRsetMap::const_iterator iter = rrsets_map->find(key);
+        if (iter != rrsets_map->end()) {
+            rrset_ptr = iter->second;
+        }
+    }
+    if (!rrset_ptr) {
         LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_LOCALZONE_UNKNOWN).arg(key);
-        return (RRsetPtr());
     } else {
         LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_LOCALZONE_FOUND).arg(key);
-        return (iter->second);
     }
+    return (rrset_ptr);
 }
 
 void
@@ -52,7 +68,16 @@ LocalZoneData::update(const isc::dns::AbstractRRset& rrset) {
 
     rrsetCopy(rrset, *rrset_copy);
     RRsetPtr rrset_ptr(rrset_copy);
-    rrsets_map_[key] = rrset_ptr;
+
+    // Publish an updated copy of the map, and destroy the old one once no
+    // lookup can be using it any more.
+    Mutex::Locker locker(update_mutex_);
+    RRsetMap* old_map = rrsets_map_;
+    std::auto_ptr<RRsetMap> new_map(new RRsetMap(*old_map));
+    (*new_map)[key] = rrset_ptr;
+    RCU::assign(rrsets_map_, new_map.release());
+    rcu_.synchronize();
+    delete old_map;
 }
 
 } // namespace cache
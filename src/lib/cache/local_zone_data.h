@@ -17,8 +17,11 @@
 
 #include <map>
 #include <string>
+#include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
 #include <dns/rrset.h>
+#include <util/threads/rcu.h>
+#include <util/threads/sync.h>
 
 namespace isc {
 namespace cache {
@@ -27,14 +30,23 @@ namespace cache {
 /// The object of LocalZoneData represents the data of one
 /// local zone. It provides the interface for lookup the rrsets
 /// in the zone.
-class LocalZoneData {
+///
+/// Lookups can be done from several threads at the same time, and
+/// concurrently with updates.  The rrsets are kept in a map that is
+/// replaced as a whole on update and protected by RCU, so lookups don't
+/// take a lock; this makes updates expensive, but they are only expected
+/// at startup (e.g. for priming the root zone).
+class LocalZoneData : boost::noncopyable {
 public:
     /// \brief Constructor.
     ///
     /// The passed parameter is expected to be an RR class value, but is not
     /// currently unused.  And this library will be quite likely to
     /// deprecated anyway, so we don't touch it heavily.
-    LocalZoneData(uint16_t) {}
+    LocalZoneData(uint16_t);
+
+    /// \brief Destructor.
+    ~LocalZoneData();
 
     /// \brief Look up one rrset.
     ///
@@ -54,7 +66,11 @@ public:
     void update(const isc::dns::AbstractRRset& rrset);
 
 private:
-    std::map<std::string, isc::dns::RRsetPtr> rrsets_map_; // RRsets of the zone
+    typedef std::map<std::string, isc::dns::RRsetPtr> RRsetMap;
+
+    isc::util::thread::RCU rcu_;     // protects rrsets_map_ from lookups
+    isc::util::thread::Mutex update_mutex_; // serializes the updates
+    RRsetMap* volatile rrsets_map_;  // RRsets of the zone
 };
 
 typedef boost::shared_ptr<LocalZoneData> LocalZoneDataPtr;
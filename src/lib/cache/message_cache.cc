@@ -15,19 +15,19 @@
 
 #include <config.h>
 
-#include <nsas/nsas_entry_compare.h>
-#include <nsas/hash_table.h>
-#include <nsas/hash_deleter.h>
 #include "message_cache.h"
 #include "message_utility.h"
 #include "cache_entry_key.h"
+#include "cache_snapshot.h"
 #include "logger.h"
+#include <algorithm>
+#include <vector>
 
 namespace isc {
 namespace cache {
 
-using namespace isc::nsas;
 using namespace isc::dns;
+using namespace isc::util;
 using namespace std;
 using namespace MessageUtility;
 
@@ -37,46 +37,93 @@ MessageCache::MessageCache(const RRsetCachePtr& rrset_cache,
     message_class_(message_class),
     rrset_cache_(rrset_cache),
     negative_soa_cache_(negative_soa_cache),
-    message_table_(new NsasEntryCompare<MessageEntry>, cache_size),
-    message_lru_((3 * cache_size),
-                  new HashDeleter<MessageEntry>(message_table_))
+    message_table_(3 * cache_size),
+    prefetch_percent_(DEFAULT_PREFETCH_PERCENT),
+    prefetch_hits_(DEFAULT_PREFETCH_HITS),
+    prefetch_count_(0),
+    prefetch_success_count_(0)
 {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_MESSAGES_INIT).arg(cache_size).
         arg(RRClass(message_class));
 }
 
+const uint32_t MessageCache::DEFAULT_PREFETCH_PERCENT;
+const uint32_t MessageCache::DEFAULT_PREFETCH_HITS;
+
 MessageCache::~MessageCache() {
-    // Destroy all the message entries in the cache.
-    message_lru_.clear();
     LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_MESSAGES_DEINIT);
 }
 
+namespace {
+// Counts a lookup of a message entry with the table locked.
+class HitCounter {
+public:
+    HitCounter(time_t time_now, uint32_t prefetch_percent,
+               uint32_t prefetch_hits) :
+        time_now_(time_now), prefetch_percent_(prefetch_percent),
+        prefetch_hits_(prefetch_hits), prefetch_(false)
+    {}
+    void operator()(MessageEntry& entry) {
+        prefetch_ = entry.countHit(time_now_, prefetch_percent_,
+                                   prefetch_hits_);
+    }
+    bool prefetch() const {
+        return (prefetch_);
+    }
+private:
+    const time_t time_now_;
+    const uint32_t prefetch_percent_;
+    const uint32_t prefetch_hits_;
+    bool prefetch_;
+};
+}
+
 bool
 MessageCache::lookup(const isc::dns::Name& qname,
                      const isc::dns::RRType& qtype,
-                     isc::dns::Message& response)
+                     isc::dns::Message& response,
+                     bool* prefetch)
 {
-    std::string entry_name = genCacheEntryName(qname, qtype);
-    HashKey entry_key = HashKey(entry_name, RRClass(message_class_));
-    MessageEntryPtr msg_entry = message_table_.get(entry_key);
+    if (prefetch != NULL) {
+        *prefetch = false;
+    }
+    const time_t time_now = time(NULL);
+    const CacheEntryKey entry_key(qname, qtype, RRClass(message_class_));
+    // Only ask for a refresh if the caller can start it, or it would
+    // never happen.
+    HitCounter counter(time_now, prefetch != NULL ? prefetch_percent_ : 0,
+                       prefetch_hits_);
+    MessageEntryPtr msg_entry = message_table_.get(entry_key, counter);
     if(msg_entry) {
         // Check whether the message entry has expired.
-       if (msg_entry->getExpireTime() > time(NULL)) {
+       if (msg_entry->getExpireTime() > time_now) {
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_FOUND).
-                arg(entry_name);
-            message_lru_.touch(msg_entry);
-            return (msg_entry->genMessage(time(NULL), response));
+                arg(genCacheEntryName(qname, qtype));
+            if (!msg_entry->genMessage(time_now, response)) {
+                // The caller will resolve the query anyway.
+                return (false);
+            }
+            if (counter.prefetch()) {
+                LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_PREFETCH).
+                    arg(genCacheEntryName(qname, qtype)).
+                    arg(msg_entry->getExpireTime() - time_now).
+                    arg(msg_entry->getHitCount());
+                isc::util::thread::Mutex::Locker locker(counter_mutex_);
+                ++prefetch_count_;
+                *prefetch = true;
+            }
+            return (true);
         } else {
-            // message entry expires, remove it from hash table and lru list.
+            // message entry expires, remove it from the table.
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_EXPIRED).
-                arg(entry_name);
+                arg(genCacheEntryName(qname, qtype));
             message_table_.remove(entry_key);
-            message_lru_.remove(msg_entry);
             return (false);
        }
     }
 
-    LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_UNKNOWN).arg(entry_name);
+    LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_UNKNOWN).
+        arg(genCacheEntryName(qname, qtype));
     return (false);
 }
 
@@ -94,27 +141,78 @@ MessageCache::update(const Message& msg) {
     LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_UPDATE).
         arg((*iter)->getName()).arg((*iter)->getType()).
         arg((*iter)->getClass());
-    std::string entry_name = genCacheEntryName((*iter)->getName(),
-                                               (*iter)->getType());
-    HashKey entry_key = HashKey(entry_name, RRClass(message_class_));
-
-    // The simplest way to update is removing the old message entry directly.
-    // We have find the existed message entry, since we need to delete it
-    // from lru list too.
-    // TODO, but there should be a better way, since we here have to remove and
-    // add the message entry, maybe there is one way to touch it once.
-    MessageEntryPtr old_msg_entry = message_table_.get(entry_key);
-    if (old_msg_entry) {
-        LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_REMOVE).
-            arg((*iter)->getName()).arg((*iter)->getType()).
-            arg((*iter)->getClass());
-        message_lru_.remove(old_msg_entry);
-    }
+    const CacheEntryKey entry_key((*iter)->getName(), (*iter)->getType(),
+                                  RRClass(message_class_));
 
+    // The old message entry, if any, is simply replaced with the new one.
     MessageEntryPtr msg_entry(new MessageEntry(msg, rrset_cache_,
                                                negative_soa_cache_));
-    message_lru_.add(msg_entry);
-    return (message_table_.add(msg_entry, entry_key, true));
+    MessageEntryPtr old_entry;
+    message_table_.add(entry_key, msg_entry, &old_entry);
+    if (old_entry && old_entry->isPrefetching() &&
+        old_entry->getExpireTime() > time(NULL)) {
+        isc::util::thread::Mutex::Locker locker(counter_mutex_);
+        ++prefetch_success_count_;
+    }
+    return (true);
+}
+
+void
+MessageCache::setPrefetchPolicy(uint32_t percent, uint32_t hits) {
+    prefetch_percent_ = std::min(percent, static_cast<uint32_t>(100));
+    prefetch_hits_ = hits;
+}
+
+uint64_t
+MessageCache::getPrefetchCount() const {
+    isc::util::thread::Mutex::Locker locker(counter_mutex_);
+    return (prefetch_count_);
+}
+
+uint64_t
+MessageCache::getPrefetchSuccessCount() const {
+    isc::util::thread::Mutex::Locker locker(counter_mutex_);
+    return (prefetch_success_count_);
+}
+
+size_t
+MessageCache::dump(OutputBuffer& buffer) const {
+    vector<MessageEntryPtr> entries;
+    message_table_.getEntries(entries);
+    entries.erase(remove_if(entries.begin(), entries.end(),
+                            ExpiredBefore<MessageEntry>(time(NULL))),
+                  entries.end());
+
+    buffer.writeUint32(entries.size());
+    for (vector<MessageEntryPtr>::const_iterator it = entries.begin();
+         it != entries.end(); ++it) {
+        (*it)->dump(buffer);
+    }
+    return (entries.size());
+}
+
+size_t
+MessageCache::load(InputBuffer& buffer) {
+    const time_t now = time(NULL);
+    size_t loaded = 0;
+    try {
+        const uint32_t count = buffer.readUint32();
+        for (uint32_t i = 0; i < count; ++i) {
+            MessageEntryPtr msg_entry(new MessageEntry(buffer,
+                                                       RRClass(message_class_),
+                                                       rrset_cache_,
+                                                       negative_soa_cache_));
+            if (msg_entry->getExpireTime() <= now) {
+                continue;
+            }
+            message_table_.add(msg_entry->getKey(), msg_entry);
+            ++loaded;
+        }
+    } catch (const isc::Exception& ex) {
+        isc_throw(CacheSnapshotError, "broken message cache snapshot: " <<
+                  ex.what());
+    }
+    return (loaded);
 }
 
 } // namespace cache
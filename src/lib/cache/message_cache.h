@@ -18,9 +18,10 @@
 #include <string>
 #include <boost/shared_ptr.hpp>
 #include <dns/message.h>
+#include <util/buffer.h>
+#include <util/threads/sync.h>
 #include "message_entry.h"
-#include <nsas/hash_table.h>
-#include <util/lru_list.h>
+#include "cache_table.h"
 #include "rrset_cache.h"
 
 namespace isc {
@@ -30,8 +31,8 @@ namespace cache {
 /// The object of MessageCache represents the cache for class-specific
 /// messages.
 ///
-/// \todo The message cache class should provide the interfaces for
-///       loading, dumping and resizing.
+/// \todo The message cache class should provide the interface for
+///       resizing.
 class MessageCache {
 // Noncopyable
 private:
@@ -52,37 +53,104 @@ public:
     virtual ~MessageCache();
 
     /// \brief Look up message in cache.
+    ///
+    /// If \c prefetch is not NULL, it's set to true when the found message
+    /// is popular and about to expire (see \c setPrefetchPolicy()), and
+    /// the caller should refresh it by resolving the query again and
+    /// updating the cache with the result.  This happens only once for
+    /// each cached message, so the caller doesn't need to track the
+    /// refreshes it has started.
+    ///
     /// \param qname Name of the domain for which the message is being sought.
     /// \param qtype Type of the RR for which the message is being sought.
     /// \param message generated response message if the message entry
     ///        can be found.
+    /// \param prefetch If not NULL, set to whether the message should be
+    ///        refreshed.
     ///
     /// \return return true if the message can be found in cache, or else,
     /// return false.
     //TODO Maybe some user just want to get the message_entry.
     bool lookup(const isc::dns::Name& qname,
                 const isc::dns::RRType& qtype,
-                isc::dns::Message& message);
+                isc::dns::Message& message,
+                bool* prefetch = NULL);
 
     /// \brief Update the message in the cache with the new one.
     /// If the message doesn't exist in the cache, it will be added
     /// directly.
     bool update(const isc::dns::Message& msg);
-protected:
-    /// \brief Get the hash key for the message entry in the cache.
-    /// \param name query name of the message.
-    /// \param type query type of the message.
-    /// \return return the hash key.
-    isc::nsas::HashKey getEntryHashKey(const isc::dns::Name& name,
-                                       const isc::dns::RRType& type) const;
+
+    /// \name Prefetch Interfaces
+    ///
+    /// Popular messages are refreshed shortly before they expire, so that
+    /// their clients don't all miss the cache and wait for the answer when
+    /// they expire.
+    //@{
+    /// \brief The default part of the TTL, in percent, in which messages
+    ///        are refreshed.
+    static const uint32_t DEFAULT_PREFETCH_PERCENT = 10;
+
+    /// \brief The default number of lookups a message must have had to be
+    ///        refreshed.
+    static const uint32_t DEFAULT_PREFETCH_HITS = 2;
+
+    /// \brief Set when messages are refreshed.
+    ///
+    /// A message is refreshed if it's looked up in the last \c percent
+    /// percent of its TTL and has been looked up \c hits times (including
+    /// that lookup) since it was cached.  This must not be called while
+    /// other threads use the cache.
+    ///
+    /// \param percent The part of the TTL in percent, 0 to disable
+    ///        refreshes.  Values above 100 are treated as 100.
+    /// \param hits The number of lookups.
+    void setPrefetchPolicy(uint32_t percent, uint32_t hits);
+
+    /// \brief Get the number of refreshes requested by \c lookup().
+    uint64_t getPrefetchCount() const;
+
+    /// \brief Get the number of refreshes that were cached before the
+    ///        old message expired.
+    ///
+    /// Without the refresh, each of these would have made the clients of
+    /// the message miss the cache.
+    uint64_t getPrefetchSuccessCount() const;
+    //@}
+
+    /// \brief Write the unexpired message entries to a cache snapshot.
+    ///
+    /// Only the message entries are written; the rrsets they refer to
+    /// must be dumped from the rrset caches.  See cache_snapshot.h for
+    /// the format.
+    ///
+    /// \param buffer The buffer the entries are appended to.
+    /// \return The number of entries written.
+    size_t dump(isc::util::OutputBuffer& buffer) const;
+
+    /// \brief Load message entries from a cache snapshot.
+    ///
+    /// Entries that have expired are skipped.
+    ///
+    /// \throw CacheSnapshotError The snapshot is broken.
+    ///
+    /// \param buffer The buffer positioned at the data written by \c dump().
+    /// \return The number of entries loaded.
+    size_t load(isc::util::InputBuffer& buffer);
 
     // Make these variants be protected for easy unittest.
 protected:
     uint16_t message_class_; // The class of the message cache.
     RRsetCachePtr rrset_cache_;
     RRsetCachePtr negative_soa_cache_;
-    isc::nsas::HashTable<MessageEntry> message_table_;
-    isc::util::LruList<MessageEntry> message_lru_;
+    CacheTable<MessageEntry> message_table_;
+
+private:
+    uint32_t prefetch_percent_;
+    uint32_t prefetch_hits_;
+    mutable isc::util::thread::Mutex counter_mutex_;
+    uint64_t prefetch_count_;
+    uint64_t prefetch_success_count_;
 };
 
 typedef boost::shared_ptr<MessageCache> MessageCachePtr;
@@ -16,14 +16,14 @@
 
 #include <limits>
 #include <dns/message.h>
-#include <nsas/nsas_entry.h>
 #include "message_entry.h"
 #include "message_utility.h"
 #include "rrset_cache.h"
+#include "cache_snapshot.h"
 #include "logger.h"
 
 using namespace isc::dns;
-using namespace isc::nsas;
+using namespace isc::util;
 using namespace std;
 
 // Put file scope functions in unnamed namespace.
@@ -81,11 +81,69 @@ MessageEntry::MessageEntry(const isc::dns::Message& msg,
     rrset_cache_(rrset_cache),
     negative_soa_cache_(negative_soa_cache),
     headerflag_aa_(false),
-    headerflag_tc_(false)
+    headerflag_tc_(false),
+    hit_count_(0),
+    prefetching_(false)
 {
     initMessageEntry(msg);
-    entry_name_ = genCacheEntryName(query_name_, query_type_);
-    hash_key_ptr_ = new HashKey(entry_name_, RRClass(query_class_));
+}
+
+MessageEntry::MessageEntry(InputBuffer& buffer, const RRClass& message_class,
+                           const RRsetCachePtr& rrset_cache,
+                           const RRsetCachePtr& negative_soa_cache):
+    rrset_cache_(rrset_cache),
+    negative_soa_cache_(negative_soa_cache),
+    query_count_(1),
+    hit_count_(0),
+    prefetching_(false)
+{
+    expire_time_ = readSnapshotTime(buffer);
+    const time_t time_now = time(NULL);
+    ttl_ = expire_time_ > time_now ? expire_time_ - time_now : 0;
+    query_name_ = Name(buffer).toText();
+    query_type_ = buffer.readUint16();
+    query_class_ = message_class.getCode();
+    const uint8_t flags = buffer.readUint8();
+    headerflag_aa_ = (flags & 0x01) != 0;
+    headerflag_tc_ = (flags & 0x02) != 0;
+    answer_count_ = buffer.readUint16();
+    authority_count_ = buffer.readUint16();
+    additional_count_ = buffer.readUint16();
+
+    const size_t rrset_count = answer_count_ + authority_count_ +
+        additional_count_;
+    rrsets_.reserve(rrset_count);
+    for (size_t i = 0; i < rrset_count; ++i) {
+        const Name name(buffer);
+        const RRType type(buffer.readUint16());
+        RRsetCache* cache = buffer.readUint8() != 0 ?
+            negative_soa_cache_.get() : rrset_cache_.get();
+        rrsets_.push_back(RRsetRef(name, type, cache));
+    }
+}
+
+CacheEntryKey
+MessageEntry::getKey() const {
+    return (CacheEntryKey(Name(query_name_), RRType(query_type_),
+                          RRClass(query_class_)));
+}
+
+void
+MessageEntry::dump(OutputBuffer& buffer) const {
+    writeSnapshotTime(buffer, expire_time_);
+    Name(query_name_).toWire(buffer);
+    buffer.writeUint16(query_type_);
+    buffer.writeUint8((headerflag_aa_ ? 0x01 : 0) |
+                      (headerflag_tc_ ? 0x02 : 0));
+    buffer.writeUint16(answer_count_);
+    buffer.writeUint16(authority_count_);
+    buffer.writeUint16(additional_count_);
+    for (vector<RRsetRef>::const_iterator it = rrsets_.begin();
+         it != rrsets_.end(); ++it) {
+        it->name_.toWire(buffer);
+        buffer.writeUint16(it->type_.getCode());
+        buffer.writeUint8(it->cache_ == negative_soa_cache_.get() ? 1 : 0);
+    }
 }
 
 bool
@@ -143,7 +201,7 @@ MessageEntry::genMessage(const time_t& time_now,
         vector<RRsetEntryPtr> rrset_entry_vec;
         if (false == getRRsetEntries(rrset_entry_vec, time_now)) {
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_ENTRY_MISSING_RRSET).
-                arg(entry_name_);
+                arg(genCacheEntryName(query_name_, query_type_));
             return (false);
         }
 
@@ -339,8 +397,29 @@ MessageEntry::initMessageEntry(const isc::dns::Message& msg) {
         }
     }
 
+    ttl_ = min_ttl;
     expire_time_ = time(NULL) + min_ttl;
 }
 
+bool
+MessageEntry::countHit(time_t time_now, uint32_t prefetch_percent,
+                       uint32_t prefetch_hits)
+{
+    if (hit_count_ < MAX_UINT32) {
+        ++hit_count_;
+    }
+    if (prefetching_ || prefetch_percent == 0 ||
+        hit_count_ < prefetch_hits || expire_time_ <= time_now) {
+        return (false);
+    }
+    // Compare in 64 bits, the TTL may be up to a week.
+    const uint64_t remaining = expire_time_ - time_now;
+    if (remaining * 100 > static_cast<uint64_t>(ttl_) * prefetch_percent) {
+        return (false);
+    }
+    prefetching_ = true;
+    return (true);
+}
+
 } // namespace cache
 } // namespace isc
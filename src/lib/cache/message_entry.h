@@ -18,7 +18,7 @@
 #include <vector>
 #include <dns/message.h>
 #include <dns/rrset.h>
-#include <nsas/nsas_entry.h>
+#include <util/buffer.h>
 #include "rrset_cache.h"
 #include "rrset_entry.h"
 
@@ -31,7 +31,7 @@ class RRsetEntry;
 ///
 /// The object of MessageEntry represents one response message
 /// answered to the resolver client.
-class MessageEntry : public isc::nsas::NsasEntry<MessageEntry> {
+class MessageEntry {
 // Noncopyable
 private:
     MessageEntry(const MessageEntry& source);
@@ -74,7 +74,24 @@ public:
                  const RRsetCachePtr& rrset_cache,
                  const RRsetCachePtr& negative_soa_cache);
 
-    ~MessageEntry() { delete hash_key_ptr_; };
+    /// \brief Initialize the message entry object from a cache snapshot.
+    ///
+    /// This reads one entry written by \c dump().  The referred rrsets
+    /// are not looked up or added to the rrset caches; they are expected
+    /// to be loaded from the snapshot separately.
+    ///
+    /// \throw isc::Exception (or a derived class) The snapshot is broken.
+    ///
+    /// \param buffer The buffer positioned at the entry.
+    /// \param message_class The class of the message.
+    /// \param rrset_cache See the other constructor.
+    /// \param negative_soa_cache See the other constructor.
+    MessageEntry(isc::util::InputBuffer& buffer,
+                 const isc::dns::RRClass& message_class,
+                 const RRsetCachePtr& rrset_cache,
+                 const RRsetCachePtr& negative_soa_cache);
+
+    ~MessageEntry() {}
 
     /// \brief generate one dns message according
     ///        the rrsets information of the message.
@@ -87,12 +104,15 @@ public:
     ///         from the cached information, or else, return false.
     bool genMessage(const time_t& time_now, isc::dns::Message& response);
 
-    /// \brief Get the hash key of the message entry.
+    /// \brief Write the message entry to a cache snapshot.
     ///
-    /// \return return hash key
-    virtual isc::nsas::HashKey hashKey() const {
-        return (*hash_key_ptr_);
-    }
+    /// See cache_snapshot.h for the format.
+    ///
+    /// \param buffer The buffer the entry is appended to.
+    void dump(isc::util::OutputBuffer& buffer) const;
+
+    /// \brief Get the key of the message entry in the message cache.
+    CacheEntryKey getKey() const;
 
     /// \brief Get expire time of the message entry.
     /// \return return the expire time of message entry.
@@ -100,6 +120,45 @@ public:
         return (expire_time_);
     }
 
+    /// \brief Get the TTL the message entry was cached with.
+    ///
+    /// For an entry loaded from a cache snapshot, this is the TTL that
+    /// was left when it was loaded.
+    uint32_t getTTL() const {
+        return (ttl_);
+    }
+
+    /// \brief Get the number of lookups of the message entry.
+    uint32_t getHitCount() const {
+        return (hit_count_);
+    }
+
+    /// \brief Return whether a refresh of the entry has been started.
+    bool isPrefetching() const {
+        return (prefetching_);
+    }
+
+    /// \brief Count a lookup of the message entry, and decide whether to
+    ///        refresh it.
+    ///
+    /// The entry should be refreshed if it's looked up in the last
+    /// \c prefetch_percent percent of its TTL and has been looked up at
+    /// least \c prefetch_hits times.  Once this returns true, it returns
+    /// false for the rest of the life of the entry, so that only one
+    /// refresh is started; the refreshed data replace the entry.
+    ///
+    /// This doesn't lock the entry; the message cache calls it with its
+    /// table locked.
+    ///
+    /// \param time_now The current time.
+    /// \param prefetch_percent The part of the TTL, in percent, in which
+    ///        the entry is refreshed; 0 means it's never refreshed.
+    /// \param prefetch_hits The number of lookups, including this one,
+    ///        needed for the entry to be refreshed.
+    /// \return true if the caller should start the refresh.
+    bool countHit(time_t time_now, uint32_t prefetch_percent,
+                  uint32_t prefetch_hits);
+
     /// \short Protected memebers, so they can be accessed by tests.
     //@{
 protected:
@@ -167,12 +226,10 @@ protected:
                          const time_t time_now);
 
     time_t expire_time_;  // Expiration time of the message.
+    uint32_t ttl_;        // TTL of the message when it was cached.
     //@}
 
 private:
-    std::string entry_name_; // The name for this entry(name + type)
-    isc::nsas::HashKey* hash_key_ptr_;  // the key for messag entry in hash table.
-
     std::vector<RRsetRef> rrsets_;
     RRsetCachePtr rrset_cache_; //Normal rrset cache
     // SOA rrset from negative response
@@ -190,6 +247,9 @@ private:
     //TODO, there should be a better way to cache these header flags
     bool headerflag_aa_; // Whether AA bit is set.
     bool headerflag_tc_; // Whether TC bit is set.
+
+    uint32_t hit_count_; // Number of lookups of the message.
+    bool prefetching_;   // Whether a refresh has been started.
 };
 
 typedef boost::shared_ptr<MessageEntry> MessageEntryPtr;
@@ -22,6 +22,7 @@
 #include <algorithm>
 
 using namespace isc::dns;
+using namespace isc::util;
 using namespace std;
 
 namespace isc {
@@ -71,8 +72,12 @@ ResolverClassCache::getClass() const {
 bool
 ResolverClassCache::lookup(const isc::dns::Name& qname,
                       const isc::dns::RRType& qtype,
-                      isc::dns::Message& response) const
+                      isc::dns::Message& response,
+                      bool* prefetch) const
 {
+    if (prefetch != NULL) {
+        *prefetch = false;
+    }
     LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RESOLVER_LOOKUP_MSG).
         arg(qname).arg(qtype);
     // message response should has question section already.
@@ -93,7 +98,7 @@ ResolverClassCache::lookup(const isc::dns::Name& qname,
     }
 
     // Search in class-specific message cache.
-    return (messages_cache_->lookup(qname, qtype, response));
+    return (messages_cache_->lookup(qname, qtype, response, prefetch));
 }
 
 isc::dns::RRsetPtr
@@ -156,6 +161,45 @@ ResolverClassCache::update(const isc::dns::ConstRRsetPtr& rrset_ptr) {
     return (true);
 }
 
+void
+ResolverClassCache::setPrefetchPolicy(uint32_t percent, uint32_t hits) {
+    messages_cache_->setPrefetchPolicy(percent, hits);
+}
+
+uint64_t
+ResolverClassCache::getPrefetchCount() const {
+    return (messages_cache_->getPrefetchCount());
+}
+
+uint64_t
+ResolverClassCache::getPrefetchSuccessCount() const {
+    return (messages_cache_->getPrefetchSuccessCount());
+}
+
+size_t
+ResolverClassCache::dump(OutputBuffer& buffer) const {
+    buffer.writeUint16(cache_class_.getCode());
+    const size_t length_pos = buffer.getLength();
+    buffer.skip(4);
+    // The rrsets first, so that they're in the cache before the messages
+    // referring to them.
+    size_t count = rrsets_cache_->dump(buffer);
+    count += negative_soa_cache_->dump(buffer);
+    count += messages_cache_->dump(buffer);
+    const size_t length = buffer.getLength() - length_pos - 4;
+    buffer.writeUint16At(length >> 16, length_pos);
+    buffer.writeUint16At(length & 0xffff, length_pos + 2);
+    return (count);
+}
+
+size_t
+ResolverClassCache::load(InputBuffer& buffer) {
+    size_t count = rrsets_cache_->load(buffer);
+    count += negative_soa_cache_->load(buffer);
+    count += messages_cache_->load(buffer);
+    return (count);
+}
+
 
 ResolverCache::ResolverCache()
 {
@@ -182,12 +226,16 @@ bool
 ResolverCache::lookup(const isc::dns::Name& qname,
                       const isc::dns::RRType& qtype,
                       const isc::dns::RRClass& qclass,
-                      isc::dns::Message& response) const
+                      isc::dns::Message& response,
+                      bool* prefetch) const
 {
     ResolverClassCache* cc = getClassCache(qclass);
     if (cc) {
-        return (cc->lookup(qname, qtype, response));
+        return (cc->lookup(qname, qtype, response, prefetch));
     } else {
+        if (prefetch != NULL) {
+            *prefetch = false;
+        }
         LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RESOLVER_UNKNOWN_CLASS_MSG).
             arg(qclass);
         return (false);
@@ -261,6 +309,93 @@ ResolverCache::update(const isc::dns::ConstRRsetPtr& rrset_ptr) {
     }
 }
 
+void
+ResolverCache::setPrefetchPolicy(uint32_t percent, uint32_t hits) {
+    for (std::vector<ResolverClassCache*>::size_type i = 0;
+         i < class_caches_.size(); ++i) {
+        class_caches_[i]->setPrefetchPolicy(percent, hits);
+    }
+}
+
+uint64_t
+ResolverCache::getPrefetchCount() const {
+    uint64_t count = 0;
+    for (std::vector<ResolverClassCache*>::size_type i = 0;
+         i < class_caches_.size(); ++i) {
+        count += class_caches_[i]->getPrefetchCount();
+    }
+    return (count);
+}
+
+uint64_t
+ResolverCache::getPrefetchSuccessCount() const {
+    uint64_t count = 0;
+    for (std::vector<ResolverClassCache*>::size_type i = 0;
+         i < class_caches_.size(); ++i) {
+        count += class_caches_[i]->getPrefetchSuccessCount();
+    }
+    return (count);
+}
+
+size_t
+ResolverCache::dump(OutputBuffer& buffer) const {
+    buffer.writeUint32(CACHE_SNAPSHOT_MAGIC);
+    buffer.writeUint16(CACHE_SNAPSHOT_VERSION);
+    buffer.writeUint16(class_caches_.size());
+    size_t count = 0;
+    for (std::vector<ResolverClassCache*>::size_type i = 0;
+         i < class_caches_.size(); ++i) {
+        count += class_caches_[i]->dump(buffer);
+    }
+    LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_RESOLVER_DUMPED).arg(count).
+        arg(buffer.getLength());
+    return (count);
+}
+
+size_t
+ResolverCache::load(InputBuffer& buffer) {
+    size_t count = 0;
+    try {
+        if (buffer.readUint32() != CACHE_SNAPSHOT_MAGIC) {
+            isc_throw(CacheSnapshotError, "not a cache snapshot");
+        }
+        const uint16_t version = buffer.readUint16();
+        if (version != CACHE_SNAPSHOT_VERSION) {
+            isc_throw(CacheSnapshotError,
+                      "unsupported cache snapshot version: " << version);
+        }
+        const uint16_t class_count = buffer.readUint16();
+        for (uint16_t i = 0; i < class_count; ++i) {
+            const RRClass rrclass(buffer.readUint16());
+            const uint32_t length = buffer.readUint32();
+            const size_t end = buffer.getPosition() + length;
+            if (end > buffer.getLength()) {
+                isc_throw(CacheSnapshotError,
+                          "truncated cache snapshot for class " << rrclass);
+            }
+            ResolverClassCache* cc = getClassCache(rrclass);
+            if (cc) {
+                count += cc->load(buffer);
+                if (buffer.getPosition() != end) {
+                    isc_throw(CacheSnapshotError,
+                              "broken cache snapshot for class " << rrclass);
+                }
+            } else {
+                LOG_DEBUG(logger, DBG_TRACE_BASIC,
+                          CACHE_RESOLVER_LOAD_UNKNOWN_CLASS).arg(rrclass);
+                buffer.setPosition(end);
+            }
+        }
+    } catch (const CacheSnapshotError&) {
+        throw;
+    } catch (const isc::Exception& ex) {
+        isc_throw(CacheSnapshotError, "broken cache snapshot: " << ex.what());
+    }
+    LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_RESOLVER_LOADED).arg(count).
+        arg(buffer.getLength());
+    return (count);
+}
+
 ResolverClassCache*
 ResolverCache::getClassCache(const isc::dns::RRClass& cache_class) const {
     for (std::vector<ResolverClassCache*>::size_type i = 0;
@@ -21,9 +21,11 @@
 #include <dns/rrclass.h>
 #include <dns/message.h>
 #include <exceptions/exceptions.h>
+#include <util/buffer.h>
 #include "message_cache.h"
 #include "rrset_cache.h"
 #include "local_zone_data.h"
+#include "cache_snapshot.h"
 
 namespace isc {
 namespace cache {
@@ -77,8 +79,8 @@ public:
 /// \note Public interaction with the cache should be through ResolverCache,
 /// not directly with this one. (TODO: make this private/hidden/local to the .cc?)
 ///
-/// \todo The resolver cache class should provide the interfaces for
-///       loading, dumping and resizing.
+/// \todo The resolver cache class should provide the interface for
+///       resizing.
 class ResolverClassCache {
 public:
     /// \brief Default Constructor.
@@ -105,11 +107,14 @@ public:
     ///        no question section). If the message can be found
     ///        in cache, rrsets for the message will be added to
     ///        different sections(answer, authority, additional).
+    /// \param prefetch If not NULL, set to whether the message should be
+    ///        refreshed; see \c MessageCache::lookup().
     /// \return return true if the message can be found, or else,
     ///         return false.
     bool lookup(const isc::dns::Name& qname,
                 const isc::dns::RRType& qtype,
-                isc::dns::Message& response) const;
+                isc::dns::Message& response,
+                bool* prefetch = NULL) const;
 
     /// \brief Look up rrset in cache.
     ///
@@ -160,6 +165,36 @@ public:
     /// here.
     bool update(const isc::dns::ConstRRsetPtr& rrset_ptr);
 
+    /// \brief Set when messages are refreshed.
+    ///
+    /// See \c MessageCache::setPrefetchPolicy().
+    void setPrefetchPolicy(uint32_t percent, uint32_t hits);
+
+    /// \brief Get the number of refreshes requested by \c lookup().
+    uint64_t getPrefetchCount() const;
+
+    /// \brief Get the number of refreshes that were cached before the
+    ///        old message expired.
+    uint64_t getPrefetchSuccessCount() const;
+
+    /// \brief Write the cache to a snapshot.
+    ///
+    /// This writes the message and rrset caches, but not the local zone
+    /// data.  See cache_snapshot.h for the format.
+    ///
+    /// \param buffer The buffer the class section is appended to.
+    /// \return The number of message and rrset entries written.
+    size_t dump(isc::util::OutputBuffer& buffer) const;
+
+    /// \brief Load the cache from a snapshot.
+    ///
+    /// \throw CacheSnapshotError The snapshot is broken.
+    ///
+    /// \param buffer The buffer positioned after the class and length of
+    /// a class section written by \c dump().
+    /// \return The number of message and rrset entries loaded.
+    size_t load(isc::util::InputBuffer& buffer);
+
     /// \brief Get the RRClass this cache is for
     ///
     /// \return The RRClass of this cache
@@ -229,12 +264,17 @@ public:
     ///        no question section). If the message can be found
     ///        in cache, rrsets for the message will be added to
     ///        different sections(answer, authority, additional).
+    /// \param prefetch If not NULL, set to whether the message is popular
+    ///        and about to expire, so the caller should resolve the query
+    ///        again and update the cache with the result.  This is set
+    ///        only once for each cached message.
     /// \return return true if the message can be found, or else,
     ///         return false.
     bool lookup(const isc::dns::Name& qname,
                 const isc::dns::RRType& qtype,
                 const isc::dns::RRClass& qclass,
-                isc::dns::Message& response) const;
+                isc::dns::Message& response,
+                bool* prefetch = NULL) const;
 
     /// \brief Look up rrset in cache.
     ///
@@ -303,6 +343,68 @@ public:
     ///
     bool update(const isc::dns::ConstRRsetPtr& rrset_ptr);
 
+    /// \name Prefetch Interfaces
+    ///
+    /// Popular messages are refreshed shortly before they expire: when
+    /// \c lookup() finds such a message, it asks the caller to resolve
+    /// the query again, while the cached message is still used.  The
+    /// clients of the message then don't all miss the cache and wait for
+    /// the answer when it expires.
+    //@{
+    /// \brief Set when messages are refreshed.
+    ///
+    /// A message is refreshed if it's looked up in the last \c percent
+    /// percent of its TTL and has been looked up \c hits times (including
+    /// that lookup) since it was cached.  By default, messages are
+    /// refreshed in the last \c MessageCache::DEFAULT_PREFETCH_PERCENT
+    /// percent of their TTL after \c MessageCache::DEFAULT_PREFETCH_HITS
+    /// lookups.  This must not be called while other threads use the
+    /// cache.
+    ///
+    /// \param percent The part of the TTL in percent, 0 to disable
+    ///        refreshes.
+    /// \param hits The number of lookups.
+    void setPrefetchPolicy(uint32_t percent, uint32_t hits);
+
+    /// \brief Get the number of refreshes requested by \c lookup().
+    uint64_t getPrefetchCount() const;
+
+    /// \brief Get the number of refreshes that were cached before the
+    ///        old message expired.
+    ///
+    /// Without the refresh, each of these would have made the clients of
+    /// the message miss the cache.
+    uint64_t getPrefetchSuccessCount() const;
+    //@}
+
+    /// \name Snapshot Interfaces
+    ///
+    /// These write the whole cache to a compact binary snapshot and load
+    /// it back, so that a restarted resolver can start with a warm cache.
+    /// Expiration times are kept as absolute times, and entries that have
+    /// expired by the time the snapshot is loaded are skipped.  Local zone
+    /// data are not included.
+    //@{
+    /// \brief Write the cache to a snapshot.
+    ///
+    /// \param buffer The buffer the snapshot is appended to.
+    /// \return The number of message and rrset entries written.
+    size_t dump(isc::util::OutputBuffer& buffer) const;
+
+    /// \brief Load a snapshot into the cache.
+    ///
+    /// Loaded entries replace existing entries for the same data.  Data
+    /// of classes this cache doesn't have are skipped.  If the snapshot
+    /// is broken, the entries before the broken part remain loaded.
+    ///
+    /// \throw CacheSnapshotError The snapshot is broken or of an
+    /// unsupported version.
+    ///
+    /// \param buffer The buffer holding the snapshot.
+    /// \return The number of message and rrset entries loaded.
+    size_t load(isc::util::InputBuffer& buffer);
+    //@}
+
 private:
     /// \brief Returns the class-specific subcache
     ///
@@ -15,25 +15,49 @@
 #include <config.h>
 
 #include "rrset_cache.h"
+#include "cache_snapshot.h"
 #include "logger.h"
+#include <dns/rdata.h>
+#include <dns/rrset.h>
+#include <algorithm>
 #include <string>
-#include <nsas/nsas_entry_compare.h>
-#include <nsas/hash_table.h>
-#include <nsas/hash_deleter.h>
+#include <vector>
 
-using namespace isc::nsas;
 using namespace isc::dns;
+using namespace isc::util;
 using namespace std;
 
+namespace {
+void
+writeRdatas(OutputBuffer& buffer, const AbstractRRset& rrset) {
+    buffer.writeUint16(rrset.getRdataCount());
+    for (RdataIteratorPtr it = rrset.getRdataIterator(); !it->isLast();
+         it->next()) {
+        const size_t pos = buffer.getLength();
+        buffer.skip(2);
+        it->getCurrent().toWire(buffer);
+        buffer.writeUint16At(buffer.getLength() - pos - 2, pos);
+    }
+}
+
+void
+readRdatas(InputBuffer& buffer, AbstractRRset& rrset) {
+    const uint16_t count = buffer.readUint16();
+    for (uint16_t i = 0; i < count; ++i) {
+        const uint16_t len = buffer.readUint16();
+        rrset.addRdata(rdata::createRdata(rrset.getType(), rrset.getClass(),
+                                          buffer, len));
+    }
+}
+}
+
 namespace isc {
 namespace cache {
 
 RRsetCache::RRsetCache(uint32_t cache_size,
                        uint16_t rrset_class):
     class_(rrset_class),
-    rrset_table_(new NsasEntryCompare<RRsetEntry>, cache_size),
-    rrset_lru_((3 * cache_size),
-                  new HashDeleter<RRsetEntry>(rrset_table_))
+    rrset_table_(3 * cache_size)
 {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_RRSET_INIT).arg(cache_size).
         arg(RRClass(rrset_class));
@@ -45,22 +69,17 @@ RRsetCache::lookup(const isc::dns::Name& qname,
 {
     LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RRSET_LOOKUP).arg(qname).
         arg(qtype).arg(RRClass(class_));
-    const string entry_name = genCacheEntryName(qname, qtype);
+    const CacheEntryKey entry_key(qname, qtype, RRClass(class_));
 
-    RRsetEntryPtr entry_ptr = rrset_table_.get(HashKey(entry_name,
-                                                       RRClass(class_)));
+    RRsetEntryPtr entry_ptr = rrset_table_.get(entry_key);
     if (entry_ptr) {
         if (entry_ptr->getExpireTime() > time(NULL)) {
-            // Only touch the non-expired rrset entries
-            rrset_lru_.touch(entry_ptr);
             return (entry_ptr);
         } else {
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RRSET_EXPIRED).arg(qname).
                 arg(qtype).arg(RRClass(class_));
-            // the rrset entry has expired, so just remove it from
-            // hash table and lru list.
-            rrset_table_.remove(entry_ptr->hashKey());
-            rrset_lru_.remove(entry_ptr);
+            // the rrset entry has expired, so just remove it.
+            rrset_table_.remove(entry_key);
         }
     }
 
@@ -86,20 +105,90 @@ RRsetCache::update(const isc::dns::AbstractRRset& rrset,
             // existed rrset entry is more authoritative, just return it
             return (entry_ptr);
         } else {
+            // The old rrset entry will be replaced below.
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RRSET_REMOVE_OLD).
                 arg(rrset.getName()).arg(rrset.getType()).
                 arg(rrset.getClass());
-            // Remove the old rrset entry from the lru list.
-            rrset_lru_.remove(entry_ptr);
         }
     }
 
     entry_ptr.reset(new RRsetEntry(rrset, level));
-    rrset_table_.add(entry_ptr, entry_ptr->hashKey(), true);
-    rrset_lru_.add(entry_ptr);
+    rrset_table_.add(CacheEntryKey(rrset.getName(), rrset.getType(),
+                                   RRClass(class_)),
+                     entry_ptr);
     return (entry_ptr);
 }
 
+size_t
+RRsetCache::dump(OutputBuffer& buffer) const {
+    vector<RRsetEntryPtr> entries;
+    rrset_table_.getEntries(entries);
+    const time_t now = time(NULL);
+    entries.erase(remove_if(entries.begin(), entries.end(),
+                            ExpiredBefore<RRsetEntry>(now)),
+                  entries.end());
+
+    buffer.writeUint32(entries.size());
+    for (vector<RRsetEntryPtr>::const_iterator it = entries.begin();
+         it != entries.end(); ++it) {
+        const ConstRRsetPtr rrset = (*it)->getRRset();
+        writeSnapshotTime(buffer, (*it)->getExpireTime());
+        buffer.writeUint8((*it)->getTrustLevel());
+        rrset->getName().toWire(buffer);
+        buffer.writeUint16(rrset->getType().getCode());
+        writeRdatas(buffer, *rrset);
+        const ConstRRsetPtr rrsig = rrset->getRRsig();
+        if (rrsig) {
+            writeRdatas(buffer, *rrsig);
+        } else {
+            buffer.writeUint16(0);
+        }
+    }
+    return (entries.size());
+}
+
+size_t
+RRsetCache::load(InputBuffer& buffer) {
+    const time_t now = time(NULL);
+    size_t loaded = 0;
+    try {
+        const uint32_t count = buffer.readUint32();
+        for (uint32_t i = 0; i < count; ++i) {
+            const time_t expire_time = readSnapshotTime(buffer);
+            const uint8_t trust = buffer.readUint8();
+            if (trust > RRSET_TRUST_PRIM_ZONE_NONGLUE) {
+                isc_throw(CacheSnapshotError, "invalid trust level: " <<
+                          static_cast<int>(trust));
+            }
+            const Name name(buffer);
+            const RRType type(buffer.readUint16());
+            const uint32_t ttl = expire_time > now ? expire_time - now : 0;
+            RRset rrset(name, RRClass(class_), type, RRTTL(ttl));
+            readRdatas(buffer, rrset);
+            RRsetPtr rrsig(new RRset(name, RRClass(class_), RRType::RRSIG(),
+                                     RRTTL(ttl)));
+            readRdatas(buffer, *rrsig);
+            if (rrsig->getRdataCount() > 0) {
+                rrset.addRRsig(rrsig);
+            }
+            if (ttl == 0) {
+                continue;
+            }
+            rrset_table_.add(CacheEntryKey(name, type, RRClass(class_)),
+                             RRsetEntryPtr(new RRsetEntry(
+                                 rrset,
+                                 static_cast<RRsetTrustLevel>(trust))));
+            ++loaded;
+        }
+    } catch (const CacheSnapshotError&) {
+        throw;
+    } catch (const isc::Exception& ex) {
+        isc_throw(CacheSnapshotError, "broken rrset cache snapshot: " <<
+                  ex.what());
+    }
+    return (loaded);
+}
+
 } // namespace cache
 } // namespace isc
 
@@ -16,9 +16,9 @@
 #define RRSET_CACHE_H
 
 #include <cache/rrset_entry.h>
-#include <nsas/hash_table.h>
+#include <cache/cache_table.h>
 
-#include <util/lru_list.h>
+#include <util/buffer.h>
 
 namespace isc {
 namespace cache {
@@ -29,8 +29,8 @@ class RRsetEntry;
 /// The object of RRsetCache represented the cache for class-specific
 /// RRsets.
 ///
-/// \todo The rrset cache class should provide the interfaces for
-///       loading, dumping and resizing.
+/// \todo The rrset cache class should provide the interface for
+///       resizing.
 class RRsetCache{
     ///
     /// \name Constructors and Destructor
@@ -47,9 +47,7 @@ public:
     /// \param cache_size the size of rrset cache.
     /// \param rrset_class the class of rrset cache.
     RRsetCache(uint32_t cache_size, uint16_t rrset_class);
-    virtual ~RRsetCache() {
-        rrset_lru_.clear(); // Clear the rrset entries in the list.
-    }
+    virtual ~RRsetCache() {}
     //@}
 
     /// \brief Look up rrset in cache.
@@ -74,11 +72,30 @@ public:
     RRsetEntryPtr update(const isc::dns::AbstractRRset& rrset,
                          const RRsetTrustLevel& level);
 
+    /// \brief Write the unexpired rrset entries to a cache snapshot.
+    ///
+    /// See cache_snapshot.h for the format.
+    ///
+    /// \param buffer The buffer the entries are appended to.
+    /// \return The number of entries written.
+    size_t dump(isc::util::OutputBuffer& buffer) const;
+
+    /// \brief Load rrset entries from a cache snapshot.
+    ///
+    /// Entries that have expired are skipped.  The loaded entries replace
+    /// those of the same name and type in the cache, whatever their trust
+    /// level.
+    ///
+    /// \throw CacheSnapshotError The snapshot is broken.
+    ///
+    /// \param buffer The buffer positioned at the data written by \c dump().
+    /// \return The number of entries loaded.
+    size_t load(isc::util::InputBuffer& buffer);
+
     /// \short Protected memebers, so they can be accessed by tests.
 protected:
     uint16_t class_; // The class of the rrset cache.
-    isc::nsas::HashTable<RRsetEntry> rrset_table_;
-    isc::util::LruList<RRsetEntry> rrset_lru_;
+    CacheTable<RRsetEntry> rrset_table_;
 };
 
 typedef boost::shared_ptr<RRsetCache> RRsetCachePtr;
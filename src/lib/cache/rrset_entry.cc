@@ -15,24 +15,19 @@
 #include <config.h>
 
 #include <dns/message.h>
-#include <nsas/nsas_entry.h>
-#include <nsas/fetchable.h>
 #include "rrset_entry.h"
 #include "rrset_copy.h"
 
 using namespace isc::dns;
-using namespace isc::nsas;
 
 namespace isc {
 namespace cache {
 
 RRsetEntry::RRsetEntry(const isc::dns::AbstractRRset& rrset,
                        const RRsetTrustLevel& level):
-    entry_name_(genCacheEntryName(rrset.getName(), rrset.getType())),
     expire_time_(time(NULL) + rrset.getTTL().getValue()),
     trust_level_(level),
-    rrset_(new RRset(rrset.getName(), rrset.getClass(), rrset.getType(), rrset.getTTL())),
-    hash_key_(HashKey(entry_name_, rrset_->getClass()))
+    rrset_(new RRset(rrset.getName(), rrset.getClass(), rrset.getType(), rrset.getTTL()))
 {
     rrsetCopy(rrset, *(rrset_.get()));
 }
@@ -58,8 +53,14 @@ RRsetEntry::updateTTL(){
     uint32_t now = time(NULL);
     uint32_t newTTL = now < expire_time_ ? (expire_time_ - now) : 0;
 
-    RRTTL ttl(newTTL);
-    rrset_->setTTL(ttl);
+    // The RRset is shared by the threads looking it up, so they may race
+    // here; but they all store (nearly) the same value, and the TTL is a
+    // single 32-bit word, so a reader never sees a broken one.  We only
+    // store it when it changes, to keep the cache line of a popular RRset
+    // from bouncing between processors on every lookup.
+    if (newTTL != oldTTL) {
+        rrset_->setTTL(RRTTL(newTTL));
+    }
 }
 
 } // namespace cache
@@ -18,8 +18,6 @@
 #include <dns/rrset.h>
 #include <dns/message.h>
 #include <dns/rrttl.h>
-#include <nsas/nsas_entry.h>
-#include <nsas/fetchable.h>
 #include "cache_entry_key.h"
 
 namespace isc {
@@ -58,7 +56,7 @@ enum RRsetTrustLevel {
 /// The object of RRsetEntry represents one cached RRset.
 /// Each RRset entry may be refered using shared_ptr by several message
 /// entries.
-class RRsetEntry : public isc::nsas::NsasEntry<RRsetEntry>
+class RRsetEntry
 {
     ///
     /// \name Constructors and Destructor
@@ -100,13 +98,6 @@ public:
         return (rrset_->getTTL().getValue());
     }
 
-    /// \brief Get the hash key
-    ///
-    /// \return return hash key
-    isc::nsas::HashKey hashKey() const {
-        return (hash_key_);
-    }
-
     /// \brief get RRset trustworthiness
     ///
     /// \return return the trust level
@@ -118,11 +109,9 @@ private:
     void updateTTL();
 
 private:
-    std::string entry_name_; // The entry name for this rrset entry.
     time_t expire_time_;     // Expiration time of rrset.
     RRsetTrustLevel trust_level_; // RRset trustworthiness.
     boost::shared_ptr<isc::dns::RRset> rrset_;
-    isc::nsas::HashKey hash_key_; // RRsetEntry hash key
 };
 
 typedef boost::shared_ptr<RRsetEntry> RRsetEntryPtr;
@@ -0,0 +1,157 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <cache/cache_table.h>
+
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace isc::cache;
+using namespace isc::dns;
+using boost::lexical_cast;
+using std::string;
+
+namespace {
+
+typedef CacheTable<int> IntTable;
+typedef IntTable::EntryPtr IntPtr;
+
+CacheEntryKey
+makeKey(const string& name) {
+    return (CacheEntryKey(Name(name), RRType::A(), RRClass::IN()));
+}
+
+CacheEntryKey
+makeKey(int i) {
+    return (makeKey(lexical_cast<string>(i) + ".example.com"));
+}
+
+TEST(CacheTableTest, addGetRemove) {
+    IntTable table(10);
+    EXPECT_EQ(0, table.size());
+    EXPECT_FALSE(table.get(makeKey("a.example.com")));
+
+    table.add(makeKey("a.example.com"), IntPtr(new int(1)));
+    table.add(makeKey("b.example.com"), IntPtr(new int(2)));
+    EXPECT_EQ(2, table.size());
+    ASSERT_TRUE(table.get(makeKey("a.example.com")));
+    EXPECT_EQ(1, *table.get(makeKey("a.example.com")));
+    // Lookup ignores case of the name
+    ASSERT_TRUE(table.get(makeKey("B.Example.COM")));
+    EXPECT_EQ(2, *table.get(makeKey("B.Example.COM")));
+    // But not the type
+    EXPECT_FALSE(table.get(CacheEntryKey(Name("a.example.com"),
+                                         RRType::AAAA(), RRClass::IN())));
+
+    // Adding an entry of an existing key replaces the old one.
+    table.add(makeKey("a.example.com"), IntPtr(new int(3)));
+    EXPECT_EQ(2, table.size());
+    EXPECT_EQ(3, *table.get(makeKey("a.example.com")));
+
+    EXPECT_TRUE(table.remove(makeKey("a.example.com")));
+    EXPECT_FALSE(table.remove(makeKey("a.example.com")));
+    EXPECT_FALSE(table.get(makeKey("a.example.com")));
+    EXPECT_EQ(1, table.size());
+
+    table.clear();
+    EXPECT_EQ(0, table.size());
+    EXPECT_FALSE(table.get(makeKey("b.example.com")));
+
+    // The table is usable after clear().
+    table.add(makeKey("b.example.com"), IntPtr(new int(4)));
+    EXPECT_EQ(4, *table.get(makeKey("b.example.com")));
+}
+
+TEST(CacheTableTest, clockEviction) {
+    IntTable table(3);
+    table.add(makeKey(1), IntPtr(new int(1)));
+    table.add(makeKey(2), IntPtr(new int(2)));
+    table.add(makeKey(3), IntPtr(new int(3)));
+    EXPECT_EQ(3, table.size());
+
+    // 1 was referenced, so it gets a second chance and 2 is evicted.
+    EXPECT_TRUE(table.get(makeKey(1)));
+    table.add(makeKey(4), IntPtr(new int(4)));
+    EXPECT_EQ(3, table.size());
+    EXPECT_FALSE(table.get(makeKey(2)));
+
+    // Now 1 has lost its flag, 3 and 4 were never referenced since they
+    // were added.  The hand is at 3.
+    table.add(makeKey(5), IntPtr(new int(5)));
+    EXPECT_FALSE(table.get(makeKey(3)));
+    EXPECT_TRUE(table.get(makeKey(1)));
+    EXPECT_TRUE(table.get(makeKey(4)));
+    EXPECT_TRUE(table.get(makeKey(5)));
+
+    // All are referenced; the hand makes a full round and evicts the
+    // first one it met, 1.
+    table.add(makeKey(6), IntPtr(new int(6)));
+    EXPECT_EQ(3, table.size());
+    EXPECT_FALSE(table.get(makeKey(1)));
+}
+
+TEST(CacheTableTest, removedSlotReused) {
+    IntTable table(2);
+    table.add(makeKey(1), IntPtr(new int(1)));
+    table.add(makeKey(2), IntPtr(new int(2)));
+    EXPECT_TRUE(table.remove(makeKey(1)));
+
+    // The free slot is used, nothing is evicted.
+    table.add(makeKey(3), IntPtr(new int(3)));
+    EXPECT_EQ(2, table.size());
+    EXPECT_TRUE(table.get(makeKey(2)));
+    EXPECT_TRUE(table.get(makeKey(3)));
+}
+
+TEST(CacheTableTest, zeroCapacity) {
+    IntTable table(0);
+    table.add(makeKey(1), IntPtr(new int(1)));
+    EXPECT_EQ(0, table.size());
+    EXPECT_FALSE(table.get(makeKey(1)));
+    EXPECT_FALSE(table.remove(makeKey(1)));
+}
+
+TEST(CacheTableTest, sharded) {
+    // A large table is split into shards; the size is still bounded by
+    // the total capacity (rounded up to a multiple of the shard count).
+    const size_t capacity = 4096;
+    IntTable table(capacity);
+    for (int i = 0; i < 3 * static_cast<int>(capacity); ++i) {
+        table.add(makeKey(i), IntPtr(new int(i)));
+        ASSERT_LE(table.size(), capacity);
+    }
+    EXPECT_GE(table.size(), capacity * 9 / 10);
+
+    // The most recently added entries are all there.
+    for (int i = 3 * capacity - 16; i < 3 * static_cast<int>(capacity);
+         ++i) {
+        ASSERT_TRUE(table.get(makeKey(i)));
+        EXPECT_EQ(i, *table.get(makeKey(i)));
+    }
+
+    table.clear();
+    EXPECT_EQ(0, table.size());
+}
+
+}
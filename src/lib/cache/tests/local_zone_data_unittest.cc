@@ -18,11 +18,15 @@
 #include <cache/local_zone_data.h>
 #include <dns/rrset.h>
 #include <dns/rrttl.h>
+#include <util/threads/thread.h>
 #include "cache_test_messagefromfile.h"
 
+#include <boost/bind.hpp>
+
 using namespace isc::cache;
 using namespace isc::dns;
 using namespace std;
+using isc::util::thread::Thread;
 
 namespace {
 
@@ -61,4 +65,38 @@ TEST_F(LocalZoneDataTest, updateAndLookup) {
     EXPECT_EQ(ttl/2, rrset_ptr->getTTL().getValue());
 }
 
+// Look up the rrset until it has the given TTL.
+void
+lookupUntil(LocalZoneData* data, const Name& name, RRType type,
+            uint32_t ttl, bool* found)
+{
+    while (true) {
+        const RRsetPtr rrset_ptr = data->lookup(name, type);
+        if (rrset_ptr && rrset_ptr->getTTL().getValue() == ttl) {
+            *found = true;
+            return;
+        }
+    }
+}
+
+TEST_F(LocalZoneDataTest, updateWhileLookingUp) {
+    Message msg(Message::PARSE);
+    messageFromFile(msg, "message_fromWire3");
+    RRsetIterator rrset_iter = msg.beginSection(Message::SECTION_AUTHORITY);
+    const Name name = (*rrset_iter)->getName();
+    const RRType type = (*rrset_iter)->getType();
+
+    // Another thread keeps looking the rrset up while it's updated here
+    // several times; it must see every update without a lock of its own.
+    bool found = false;
+    Thread thread(boost::bind(lookupUntil, &local_zone_data, name, type, 10,
+                              &found));
+    for (uint32_t ttl = 100; ttl >= 10; ttl -= 10) {
+        (*rrset_iter)->setTTL(RRTTL(ttl));
+        local_zone_data.update(**rrset_iter);
+    }
+    thread.wait();
+    EXPECT_TRUE(found);
+}
+
 }
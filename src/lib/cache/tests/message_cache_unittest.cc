@@ -23,7 +23,6 @@
 #include "cache_test_messagefromfile.h"
 
 using namespace isc::cache;
-using namespace isc::nsas;
 using namespace isc;
 using namespace isc::dns;
 using namespace isc::util;
@@ -42,7 +41,7 @@ public:
     {}
 
     uint16_t messages_count() {
-        return message_lru_.size();
+        return message_table_.size();
     }
 };
 
@@ -56,13 +55,7 @@ public:
 
     /// \brief Remove one rrset entry from rrset cache.
     void removeRRsetEntry(Name& name, const RRType& type) {
-        const string entry_name = genCacheEntryName(name, type);
-        HashKey entry_key = HashKey(entry_name, RRClass(class_));
-        RRsetEntryPtr rrset_entry = rrset_table_.get(entry_key);
-        if (rrset_entry) {
-            rrset_lru_.remove(rrset_entry);
-            rrset_table_.remove(entry_key);
-        }
+        rrset_table_.remove(CacheEntryKey(name, type, RRClass(class_)));
     }
 };
 
@@ -143,6 +136,55 @@ TEST_F(MessageCacheTest, testUpdate) {
     EXPECT_FALSE(new_msg_render.getHeaderFlag(Message::HEADERFLAG_AA));
 }
 
+TEST_F(MessageCacheTest, prefetch) {
+    messageFromFile(message_parse, "message_fromWire1");
+    EXPECT_TRUE(message_cache_->update(message_parse));
+    Name qname("test.example.com.");
+
+    // By default, only the last 10% of the TTL is considered.
+    bool prefetch = true;
+    EXPECT_TRUE(message_cache_->lookup(qname, RRType::A(), message_render,
+                                       &prefetch));
+    EXPECT_FALSE(prefetch);
+
+    // Consider the whole TTL, and ask for a refresh on the third lookup.
+    message_cache_->setPrefetchPolicy(100, 3);
+    // Lookups that can't start a refresh are counted, too.
+    EXPECT_TRUE(message_cache_->lookup(qname, RRType::A(), message_render));
+    EXPECT_TRUE(message_cache_->lookup(qname, RRType::A(), message_render,
+                                       &prefetch));
+    EXPECT_TRUE(prefetch);
+    EXPECT_EQ(1, message_cache_->getPrefetchCount());
+
+    // The refresh is asked for only once.
+    EXPECT_TRUE(message_cache_->lookup(qname, RRType::A(), message_render,
+                                       &prefetch));
+    EXPECT_FALSE(prefetch);
+    EXPECT_EQ(1, message_cache_->getPrefetchCount());
+    EXPECT_EQ(0, message_cache_->getPrefetchSuccessCount());
+
+    // The refreshed message replaces the old one before it expired.
+    EXPECT_TRUE(message_cache_->update(message_parse));
+    EXPECT_EQ(1, message_cache_->getPrefetchSuccessCount());
+    // And it's a new entry, with its own lookup count.
+    EXPECT_TRUE(message_cache_->lookup(qname, RRType::A(), message_render,
+                                       &prefetch));
+    EXPECT_FALSE(prefetch);
+
+    // Updates without a refresh are not counted.
+    EXPECT_TRUE(message_cache_->update(message_parse));
+    EXPECT_EQ(1, message_cache_->getPrefetchSuccessCount());
+
+    // Refreshes can be disabled.
+    message_cache_->setPrefetchPolicy(0, 0);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(message_cache_->lookup(qname, RRType::A(),
+                                           message_render, &prefetch));
+        EXPECT_FALSE(prefetch);
+    }
+    EXPECT_EQ(1, message_cache_->getPrefetchCount());
+}
+
 TEST_F(MessageCacheTest, testCacheLruBehavior) {
     // qname = "test.example.com.", qtype = A
     updateMessageCache("message_fromWire1", message_cache_);
@@ -280,6 +280,30 @@ TEST_F(MessageEntryTest, testGenMessage) {
     EXPECT_EQ(7, msg.getRRCount(Message::SECTION_ADDITIONAL));
 }
 
+TEST_F(MessageEntryTest, countHit) {
+    messageFromFile(message_parse, "message_fromWire3");
+    DerivedMessageEntry message_entry(message_parse, rrset_cache_, negative_soa_cache_);
+    const time_t expire_time = message_entry.getExpireTime();
+    EXPECT_EQ(10800, message_entry.getTTL());
+    EXPECT_EQ(0, message_entry.getHitCount());
+
+    // Refreshes are disabled
+    EXPECT_FALSE(message_entry.countHit(expire_time - 1, 0, 1));
+    // Not in the last 10% (1080 seconds) of the TTL
+    EXPECT_FALSE(message_entry.countHit(expire_time - 1081, 10, 1));
+    // Not looked up often enough; this is the third time
+    EXPECT_FALSE(message_entry.countHit(expire_time - 1080, 10, 4));
+    // Expired
+    EXPECT_FALSE(message_entry.countHit(expire_time, 10, 1));
+    EXPECT_FALSE(message_entry.isPrefetching());
+
+    EXPECT_TRUE(message_entry.countHit(expire_time - 1080, 10, 5));
+    EXPECT_TRUE(message_entry.isPrefetching());
+    // The refresh is asked for only once.
+    EXPECT_FALSE(message_entry.countHit(expire_time - 1, 10, 1));
+    EXPECT_EQ(6, message_entry.getHitCount());
+}
+
 TEST_F(MessageEntryTest, testMaxTTL) {
     messageFromFile(message_parse, "message_large_ttl.wire");
 
@@ -16,12 +16,15 @@
 #include <string>
 #include <gtest/gtest.h>
 #include <dns/rrset.h>
+#include <dns/rdataclass.h>
+#include <util/buffer.h>
 #include "resolver_cache.h"
 #include "cache_test_messagefromfile.h"
 #include "cache_test_sectioncount.h"
 
 using namespace isc::cache;
 using namespace isc::dns;
+using namespace isc::util;
 using namespace std;
 
 namespace {
@@ -125,4 +128,117 @@ TEST_F(ResolverCacheTest, testLookupClosestRRset) {
     EXPECT_FALSE(rrset_ptr);
 }
 
+TEST_F(ResolverCacheTest, snapshotRoundTrip) {
+    Message msg(Message::PARSE);
+    messageFromFile(msg, "message_fromWire3");
+    cache->update(msg);
+    RRsetPtr ch_rrset(new RRset(Name("version.bind"), RRClass::CH(),
+                                RRType::TXT(), RRTTL(3600)));
+    ch_rrset->addRdata(rdata::createRdata(RRType::TXT(), RRClass::CH(),
+                                          "\"bind10\""));
+    cache->update(ch_rrset);
+
+    OutputBuffer buffer(0);
+    const size_t dumped = cache->dump(buffer);
+    // The message and the seven rrsets in it in class IN, one rrset in CH.
+    EXPECT_EQ(9, dumped);
+
+    vector<CacheSizeInfo> vec;
+    vec.push_back(CacheSizeInfo(RRClass::IN(), 100, 200));
+    vec.push_back(CacheSizeInfo(RRClass::CH(), 100, 200));
+    ResolverCache restored(vec);
+    InputBuffer ibuffer(buffer.getData(), buffer.getLength());
+    EXPECT_EQ(dumped, restored.load(ibuffer));
+
+    Name qname("example.com.");
+    Message new_msg(Message::PARSE);
+    messageFromFile(new_msg, "message_fromWire3");
+    new_msg.makeResponse();
+    EXPECT_TRUE(restored.lookup(qname, RRType::SOA(), RRClass::IN(),
+                                new_msg));
+    EXPECT_EQ(1, sectionRRsetCount(new_msg, Message::SECTION_ANSWER));
+
+    RRsetPtr rrset_ptr = restored.lookup(qname, RRType::NS(), RRClass::IN());
+    ASSERT_TRUE(rrset_ptr);
+    EXPECT_EQ(qname, rrset_ptr->getName());
+    rrset_ptr = restored.lookup(Name("version.bind"), RRType::TXT(),
+                                RRClass::CH());
+    ASSERT_TRUE(rrset_ptr);
+    ASSERT_EQ(1, rrset_ptr->getRdataCount());
+    EXPECT_EQ("\"bind10\"", rrset_ptr->getRdataIterator()->getCurrent().
+              toText());
+}
+
+TEST_F(ResolverCacheTest, snapshotSkipsUnknownClass) {
+    RRsetPtr ch_rrset(new RRset(Name("version.bind"), RRClass::CH(),
+                                RRType::TXT(), RRTTL(3600)));
+    ch_rrset->addRdata(rdata::createRdata(RRType::TXT(), RRClass::CH(),
+                                          "\"bind10\""));
+    cache->update(ch_rrset);
+    RRsetPtr in_rrset(new RRset(Name("example.com"), RRClass::IN(),
+                                RRType::A(), RRTTL(3600)));
+    in_rrset->addRdata(rdata::in::A("192.0.2.1"));
+    cache->update(in_rrset);
+
+    OutputBuffer buffer(0);
+    EXPECT_EQ(2, cache->dump(buffer));
+
+    // The data of class CH is skipped, the rest is loaded.
+    ResolverCache in_only;
+    InputBuffer ibuffer(buffer.getData(), buffer.getLength());
+    EXPECT_EQ(1, in_only.load(ibuffer));
+    EXPECT_TRUE(in_only.lookup(Name("example.com"), RRType::A(),
+                               RRClass::IN()));
+}
+
+TEST_F(ResolverCacheTest, snapshotSkipsExpired) {
+    RRsetPtr rrset(new RRset(Name("example.com"), RRClass::IN(),
+                             RRType::A(), RRTTL(1)));
+    rrset->addRdata(rdata::in::A("192.0.2.1"));
+    cache->update(rrset);
+
+    OutputBuffer buffer(0);
+    EXPECT_EQ(1, cache->dump(buffer));
+
+    // The entry expires after the snapshot has been written.
+    sleep(2);
+    ResolverCache restored;
+    InputBuffer ibuffer(buffer.getData(), buffer.getLength());
+    EXPECT_EQ(0, restored.load(ibuffer));
+    EXPECT_FALSE(restored.lookup(Name("example.com"), RRType::A(),
+                                 RRClass::IN()));
+
+    // Expired entries are not written either.
+    OutputBuffer expired_buffer(0);
+    EXPECT_EQ(0, cache->dump(expired_buffer));
+}
+
+TEST_F(ResolverCacheTest, brokenSnapshot) {
+    Message msg(Message::PARSE);
+    messageFromFile(msg, "message_fromWire3");
+    cache->update(msg);
+    OutputBuffer buffer(0);
+    cache->dump(buffer);
+
+    // Wrong magic
+    OutputBuffer bad_magic(0);
+    bad_magic.writeData(buffer.getData(), buffer.getLength());
+    bad_magic.writeUint16At(0, 0);
+    InputBuffer ibuffer1(bad_magic.getData(), bad_magic.getLength());
+    EXPECT_THROW(cache->load(ibuffer1), CacheSnapshotError);
+
+    // Unknown version
+    OutputBuffer bad_version(0);
+    bad_version.writeData(buffer.getData(), buffer.getLength());
+    bad_version.writeUint16At(CACHE_SNAPSHOT_VERSION + 1, 4);
+    InputBuffer ibuffer2(bad_version.getData(), bad_version.getLength());
+    EXPECT_THROW(cache->load(ibuffer2), CacheSnapshotError);
+
+    // Truncated data
+    for (size_t len = 0; len < buffer.getLength(); len += 7) {
+        InputBuffer ibuffer3(buffer.getData(), len);
+        EXPECT_THROW(cache->load(ibuffer3), CacheSnapshotError);
+    }
+}
+
 }
@@ -14,6 +14,7 @@
 
 #include <config.h>
 #include <string>
+#include <cstring>
 #include <gtest/gtest.h>
 #include <cache/cache_entry_key.h>
 #include <cache/rrset_entry.h>
@@ -46,6 +47,30 @@ TEST_F(GenCacheKeyTest, genCacheEntryKey2) {
     EXPECT_EQ(keystr, genCacheEntryName(name, type));
 }
 
+TEST_F(GenCacheKeyTest, cacheEntryKey) {
+    const CacheEntryKey key(Name("example.com"), RRType::A(), RRClass::IN());
+    const uint8_t expected_data[] = {
+        7, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 3, 'c', 'o', 'm', 0,
+        0, 1, 0, 1
+    };
+    ASSERT_EQ(sizeof(expected_data), key.getLength());
+    EXPECT_EQ(0, memcmp(expected_data, key.getData(), key.getLength()));
+
+    // Names are compared ignoring case.
+    const CacheEntryKey key_upper(Name("EXAMPLE.Com"), RRType::A(),
+                                  RRClass::IN());
+    EXPECT_TRUE(key == key_upper);
+    EXPECT_EQ(key.getHash(), key_upper.getHash());
+
+    // But the type and class matter.
+    EXPECT_FALSE(key == CacheEntryKey(Name("example.com"), RRType::AAAA(),
+                                      RRClass::IN()));
+    EXPECT_FALSE(key == CacheEntryKey(Name("example.com"), RRType::A(),
+                                      RRClass::CH()));
+    EXPECT_FALSE(key == CacheEntryKey(Name("example.org"), RRType::A(),
+                                      RRClass::IN()));
+}
+
 class DerivedRRsetEntry: public RRsetEntry {
 public:
     DerivedRRsetEntry(const isc::dns::RRset& rrset, const RRsetTrustLevel& level) : RRsetEntry(rrset, level) {};
@@ -65,7 +65,9 @@ namespace cryptolink {
 class HMACImpl {
 public:
     explicit HMACImpl(const void* secret, size_t secret_len,
-                      const HashAlgorithm hash_algorithm) {
+                      const HashAlgorithm hash_algorithm) :
+        pending_(false)
+    {
         Botan::HashFunction* hash;
         try {
             hash = Botan::get_hash(
@@ -132,6 +134,7 @@ public:
     void update(const void* data, const size_t len) {
         try {
             hmac_->update(static_cast<const Botan::byte*>(data), len);
+            pending_ = true;
         } catch (const Botan::Exception& exc) {
             isc_throw(isc::cryptolink::LibraryError, exc.what());
         }
@@ -139,7 +142,7 @@ public:
 
     void sign(isc::util::OutputBuffer& result, size_t len) {
         try {
-            Botan::SecureVector<Botan::byte> b_result(hmac_->final());
+            Botan::SecureVector<Botan::byte> b_result(finish());
 
             if (len == 0 || len > b_result.size()) {
                 len = b_result.size();
@@ -152,7 +155,7 @@ public:
 
     void sign(void* result, size_t len) {
         try {
-            Botan::SecureVector<Botan::byte> b_result(hmac_->final());
+            Botan::SecureVector<Botan::byte> b_result(finish());
             size_t output_size = getOutputLength();
             if (output_size > len) {
                 output_size = len;
@@ -165,7 +168,7 @@ public:
 
     std::vector<uint8_t> sign(size_t len) {
         try {
-            Botan::SecureVector<Botan::byte> b_result(hmac_->final());
+            Botan::SecureVector<Botan::byte> b_result(finish());
             if (len == 0 || len > b_result.size()) {
                 return (std::vector<uint8_t>(b_result.begin(), b_result.end()));
             } else {
@@ -183,7 +186,7 @@ public:
         // the check ourselves
         // SEE BELOW FOR TEMPORARY CHANGE
         try {
-            Botan::SecureVector<Botan::byte> our_mac = hmac_->final();
+            Botan::SecureVector<Botan::byte> our_mac = finish();
             if (len < getOutputLength()) {
                 // Currently we don't support truncated signature in TSIG (see
                 // #920).  To avoid validating too short signature accidently,
@@ -203,8 +206,27 @@ public:
         }
     }
 
+    void reset() {
+        if (pending_) {
+            try {
+                finish();
+            } catch (const Botan::Exception& exc) {
+                isc_throw(isc::cryptolink::LibraryError, exc.what());
+            }
+        }
+    }
+
 private:
+    // Botan's HMAC starts over with the same key once the MAC is computed,
+    // so completing (and discarding) it is all we need for a reset.
+    Botan::SecureVector<Botan::byte> finish() {
+        pending_ = false;
+        return (hmac_->final());
+    }
+
     boost::scoped_ptr<Botan::HMAC> hmac_;
+    // Whether data were added since the last finish()
+    bool pending_;
 };
 
 HMAC::HMAC(const void* secret, size_t secret_length,
@@ -247,6 +269,11 @@ HMAC::verify(const void* sig, const size_t len) {
     return (impl_->verify(sig, len));
 }
 
+void
+HMAC::reset() {
+    impl_->reset();
+}
+
 void
 signHMAC(const void* data, const size_t data_len, const void* secret,
          size_t secret_len, const HashAlgorithm hash_algorithm,
@@ -127,6 +127,22 @@ public:
     /// \return true if the signature is correct, false otherwise
     bool verify(const void* sig, size_t len);
 
+    /// \brief Discard the data added since the last signature
+    ///
+    /// This brings the object back to the state right after its
+    /// construction, so it can be used for another signature with the
+    /// same secret and algorithm.  Reusing an object this way saves the
+    /// setup of the underlying library (the lookup of the hash algorithm
+    /// and the computation of the keyed pads), which is a significant
+    /// part of the cost of signing or verifying a short message.
+    ///
+    /// \c sign() and \c verify() implicitly do the same, so this is only
+    /// needed if \c update() was not followed by either of them.
+    ///
+    /// \exception LibraryError if there was any unexpected exception
+    ///                         in the underlying library
+    void reset();
+
 private:
     HMACImpl* impl_;
 };
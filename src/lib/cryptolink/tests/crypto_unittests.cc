@@ -581,6 +581,38 @@ TEST(CryptoLinkTest, HMACSigLengthArgument) {
     EXPECT_EQ(32, sigBufferLength(SHA256, 3200));
 }
 
+TEST(CryptoLinkTest, HMACReuse) {
+    const std::string secret("secret");
+    const std::string data("some data to sign");
+    boost::shared_ptr<HMAC> hmac(
+        CryptoLink::getCryptoLink().createHMAC(secret.c_str(), secret.size(),
+                                               SHA256),
+        deleteHMAC);
+    hmac->update(data.c_str(), data.size());
+    const std::vector<uint8_t> sig = hmac->sign();
+
+    // The same object can sign the same data again after sign()...
+    hmac->update(data.c_str(), data.size());
+    EXPECT_TRUE(sig == hmac->sign());
+
+    // ... and verify(), ...
+    hmac->update(data.c_str(), data.size());
+    EXPECT_TRUE(hmac->verify(&sig[0], sig.size()));
+    hmac->update(data.c_str(), data.size());
+    EXPECT_TRUE(sig == hmac->sign());
+
+    // ... and the data added before reset() are discarded.
+    hmac->update("garbage", 7);
+    hmac->reset();
+    hmac->update(data.c_str(), data.size());
+    EXPECT_TRUE(sig == hmac->sign());
+
+    // reset() right after a signature (or construction) is a no-op.
+    hmac->reset();
+    hmac->update(data.c_str(), data.size());
+    EXPECT_TRUE(sig == hmac->sign());
+}
+
 TEST(CryptoLinkTest, BadKey) {
     OutputBuffer data_buf(0);
     OutputBuffer hmac_sig(0);
@@ -16,11 +16,15 @@
 #include <datasrc/client.h>
 #include <datasrc/memory/load_action.h>
 #include <datasrc/memory/zone_data_loader.h>
+#include <datasrc/memory/rdataset.h>
+#include <datasrc/memory/treenode_rrset.h>
 
 #include <util/memory_segment.h>
 
 #include <dns/name.h>
 #include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#include <dns/rdataclass.h>
 
 #include <cc/data.h>
 #include <exceptions/exceptions.h>
@@ -117,6 +121,18 @@ CacheConfig::CacheConfig(const std::string& datasrc_type,
             }
         }
     }
+
+    if (datasrc_conf.contains("cache-compact-zones")) {
+        const ConstElementPtr zones = datasrc_conf.get("cache-compact-zones");
+        for (size_t i = 0; i < zones->size(); ++i) {
+            const dns::Name zone_name(zones->get(i)->stringValue());
+            if (zone_config_.find(zone_name) == zone_config_.end()) {
+                isc_throw(CacheConfigError, "Compact zone is not cached: " <<
+                          zone_name);
+            }
+            compact_zones_.insert(zone_name);
+        }
+    }
 }
 
 namespace {
@@ -133,18 +149,21 @@ namespace {
 class IteratorLoader {
 public:
     IteratorLoader(const dns::RRClass& rrclass, const dns::Name& name,
-                   const ZoneIteratorPtr& iterator) :
+                   const ZoneIteratorPtr& iterator, bool compact) :
         rrclass_(rrclass),
         name_(name),
-        iterator_(iterator)
+        iterator_(iterator),
+        compact_(compact)
     {}
     memory::ZoneData* operator()(util::MemorySegment& segment) {
-        return (memory::loadZoneData(segment, rrclass_, name_, *iterator_));
+        return (memory::loadZoneData(segment, rrclass_, name_, *iterator_,
+                                     compact_));
     }
 private:
     const dns::RRClass rrclass_;
     const dns::Name name_;
     ZoneIteratorPtr iterator_;
+    const bool compact_;
 };
 
 // We can't use the loadZoneData function directly in boost::bind, since
@@ -152,11 +171,69 @@ private:
 // reliably and fails. So we simply wrap it into an unique name.
 memory::ZoneData*
 loadZoneDataFromFile(util::MemorySegment& segment, const dns::RRClass& rrclass,
-                     const dns::Name& name, const std::string& filename)
+                     const dns::Name& name, const std::string& filename,
+                     bool compact)
 {
-    return (memory::loadZoneData(segment, rrclass, name, filename));
+    return (memory::loadZoneData(segment, rrclass, name, filename, compact));
 }
 
+// The UpdateAction for zones cached from a data source.  It applies the
+// differences from the cached version to the current one in the data
+// source (whose serial is given on construction) as recorded in its
+// journal.  Like IteratorLoader, it's used after getCachedZoneWriter()
+// returns, but the journal reader uses a separate connection to the data
+// source (at least for the database based ones).
+class JournalUpdater {
+public:
+    JournalUpdater(const DataSourceClient& client,
+                   const dns::RRClass& rrclass, const dns::Name& name,
+                   uint32_t serial) :
+        client_(&client),
+        rrclass_(rrclass),
+        name_(name),
+        serial_(serial)
+    {}
+    memory::ZoneData* operator()(util::MemorySegment& segment,
+                                 const memory::ZoneData& old_zone_data)
+    {
+        const memory::ZoneNode* origin_node = old_zone_data.getOriginNode();
+        const memory::RdataSet* soa =
+            memory::RdataSet::find(origin_node->getData(), dns::RRType::SOA());
+        if (soa == NULL) {
+            return (NULL);
+        }
+        const memory::TreeNodeRRset soa_rrset(rrclass_, origin_node, soa,
+                                              false);
+        const uint32_t old_serial =
+            dynamic_cast<const dns::rdata::generic::SOA&>(
+                soa_rrset.getRdataIterator()->getCurrent()).
+            getSerial().getValue();
+        if (old_serial == serial_) {
+            // Nothing to apply.  Reloading the same version can still
+            // make sense (e.g., if it was modified without updating the
+            // serial), so let it be loaded from scratch.
+            return (NULL);
+        }
+
+        std::pair<ZoneJournalReader::Result, ZoneJournalReaderPtr> result;
+        try {
+            result = client_->getJournalReader(name_, old_serial, serial_);
+        } catch (const isc::NotImplemented&) {
+            return (NULL);      // the data source doesn't have a journal
+        }
+        if (result.first != ZoneJournalReader::SUCCESS) {
+            return (NULL);
+        }
+        return (memory::updateZoneData(segment, rrclass_, name_,
+                                       old_zone_data, *result.second));
+    }
+private:
+    const DataSourceClient* client_;
+    const dns::RRClass rrclass_;
+    const dns::Name name_;
+    const uint32_t serial_;
+};
+
 } // unnamed namespace
 
 memory::LoadAction
@@ -172,7 +249,7 @@ CacheConfig::getLoadAction(const dns::RRClass& rrclass,
     if (!found->second.empty()) {
         // This is "MasterFiles" data source.
         return (boost::bind(loadZoneDataFromFile, _1, rrclass, zone_name,
-                            found->second));
+                            found->second, isCompactZone(zone_name)));
     }
 
     // Otherwise there must be a "source" data source (ensured by constructor)
@@ -192,7 +269,43 @@ CacheConfig::getLoadAction(const dns::RRClass& rrclass,
 
     // Wrap the iterator into the correct functor (which keeps it alive as
     // long as it is needed).
-    return (IteratorLoader(rrclass, zone_name, iterator));
+    return (IteratorLoader(rrclass, zone_name, iterator,
+                           isCompactZone(zone_name)));
+}
+
+memory::UpdateAction
+CacheConfig::getUpdateAction(const dns::RRClass& rrclass,
+                             const dns::Name& zone_name) const
+{
+    Zones::const_iterator found = zone_config_.find(zone_name);
+    if (found == zone_config_.end() || !found->second.empty()) {
+        // Not cached, or cached from a master file.
+        return (memory::UpdateAction());
+    }
+    assert(datasrc_client_);
+
+    const DataSourceClient::FindResult result(
+        datasrc_client_->findZone(zone_name));
+    if (result.code != result::SUCCESS) {
+        return (memory::UpdateAction());
+    }
+    ZoneFinderContextPtr context;
+    try {
+        context = result.zone_finder->find(zone_name, dns::RRType::SOA());
+    } catch (const isc::NotImplemented&) {
+        // A data source that can't be searched can't provide differences
+        // either.
+        return (memory::UpdateAction());
+    }
+    if (context->code != ZoneFinder::SUCCESS) {
+        return (memory::UpdateAction());
+    }
+    const uint32_t serial =
+        dynamic_cast<const dns::rdata::generic::SOA&>(
+            context->rrset->getRdataIterator()->getCurrent()).
+        getSerial().getValue();
+
+    return (JournalUpdater(*datasrc_client_, rrclass, zone_name, serial));
 }
 
 } // namespace internal
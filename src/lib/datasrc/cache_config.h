@@ -25,6 +25,7 @@
 #include <boost/noncopyable.hpp>
 
 #include <map>
+#include <set>
 #include <string>
 
 namespace isc {
@@ -93,6 +94,15 @@ public:
     ///     exception from the dns::Name class will be thrown.
     ///   - Names in the list must not have duplicates;
     ///     throws CacheConfigError otherwise.
+    /// - For all types (unless cache is disabled)
+    ///   - "cache-compact-zones" configuration item is optional.  If it
+    ///     exists, it must be a list of strings; throws data::TypeError
+    ///     otherwise.
+    ///   - Each string value of cache-compact-zones entries must be a
+    ///     valid textual representation of a domain name of a zone to be
+    ///     cached; throws CacheConfigError if the zone isn't cached, or
+    ///     corresponding exception from the dns::Name class if the name
+    ///     is invalid.
     ///
     /// For other data source types than "MasterFiles", cache can be disabled.
     /// In this case cache-zones configuration item is simply ignored, even
@@ -144,6 +154,18 @@ public:
     /// \throw None
     const std::string& getSegmentType() const { return (segment_type_); }
 
+    /// \brief Return if the zone is to be cached in the compact form.
+    ///
+    /// The zones listed in the "cache-compact-zones" configuration item
+    /// are loaded with the names in their RDATA shared (see
+    /// \c memory::loadZoneData()).  This saves memory for zones with many
+    /// RRs pointing to the same names, such as delegation-heavy zones.
+    ///
+    /// \throw None
+    bool isCompactZone(const dns::Name& zone_name) const {
+        return (compact_zones_.count(zone_name) > 0);
+    }
+
     /// \brief Return a \c LoadAction functor to load zone data into memory.
     ///
     /// This method returns an appropriate \c LoadAction functor that can be
@@ -173,6 +195,32 @@ public:
     memory::LoadAction getLoadAction(const dns::RRClass& rrclass,
                                      const dns::Name& zone_name) const;
 
+    /// \brief Return an \c UpdateAction functor to update zone data in
+    /// memory.
+    ///
+    /// This method returns an \c UpdateAction functor that can be passed
+    /// to a \c memory::ZoneWriter object along with the \c LoadAction
+    /// (see \c getLoadAction()), so the writer can create the current
+    /// version of the zone by applying the differences stored in the
+    /// journal of the underlying data source to the version in memory,
+    /// instead of loading the entire zone.  If the differences aren't
+    /// available (e.g., the journal doesn't cover the version in memory),
+    /// the functor returns NULL so the writer loads the zone from scratch.
+    ///
+    /// If the specified zone is not configured to be cached, or it's cached
+    /// from a master file (for which no differences are available), it
+    /// returns an empty functor.  The same is true if the current version
+    /// of the zone can't be identified in the underlying data source.
+    ///
+    /// \throw DataSourceError Unexpected error happens in the underlying
+    /// data source.
+    ///
+    /// \param rrclass The RR class of the zone
+    /// \param zone_name The origin name of the zone
+    /// \return An \c UpdateAction functor or an empty functor (see above).
+    memory::UpdateAction getUpdateAction(const dns::RRClass& rrclass,
+                                         const dns::Name& zone_name) const;
+
     /// \brief Read only iterator type over configured cached zones.
     ///
     /// \note This initial version exposes the internal data structure (i.e.
@@ -208,6 +256,8 @@ private:
     // others it's an empty string.
     typedef std::map<dns::Name, std::string> Zones;
     Zones zone_config_;
+    // Zones to be cached in the compact form.
+    std::set<dns::Name> compact_zones_;
 };
 }
 }
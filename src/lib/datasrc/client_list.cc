@@ -237,6 +237,20 @@ genKeeper(const ConfigurableClientList::DataSourceInfo* info) {
     }
 }
 
+// Whether the given segment holds a non empty version of the zone.
+bool
+hasCachedZoneData(const ZoneTableSegment* segment, const Name& name) {
+    if (!segment) {
+        return (false);
+    }
+    const memory::ZoneTable* table = segment->getHeader().getTable();
+    if (!table) {
+        return (false);
+    }
+    const memory::ZoneTable::FindResult result(table->findZone(name));
+    return (result.code == result::SUCCESS && result.zone_data != NULL);
+}
+
 }
 
 // We have this class as a temporary storage, as the FindResult can't be
@@ -384,12 +398,21 @@ ConfigurableClientList::getCachedZoneWriter(const Name& name,
         if (!load_action) {
             return (ZoneWriterPair(ZONE_NOT_CACHED, ZoneWriterPtr()));
         }
+        // If a version of the zone is already cached, the writer may be
+        // able to apply the differences to it instead of loading the
+        // whole zone.  Preparing for that needs a lookup in the underlying
+        // data source, so we skip it for the initial load.
+        memory::UpdateAction update_action;
+        if (hasCachedZoneData(info.ztable_segment_.get(), name)) {
+            update_action =
+                info.getCacheConfig()->getUpdateAction(rrclass_, name);
+        }
         return (ZoneWriterPair(ZONE_SUCCESS,
                                ZoneWriterPtr(
                                    new memory::ZoneWriter(
                                        *info.ztable_segment_,
                                        load_action, name, rrclass_,
-                                       catch_load_error))));
+                                       catch_load_error, update_action))));
     }
 
     // We can't find the specified zone.  If a specific data source was
@@ -0,0 +1,175 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <util/memory_segment_local.h>
+
+#include <dns/name.h>
+#include <dns/labelsequence.h>
+
+#include <datasrc/memory/domaintree.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using std::vector;
+using namespace isc::bench;
+using namespace isc::datasrc::memory;
+using namespace isc::dns;
+
+namespace {
+typedef DomainTree<int> TestTree;
+typedef DomainTreeNode<int> TestNode;
+
+// All nodes share the same data; we only need them to be non empty.
+int node_data = 0;
+
+void
+nullDeleter(int*) {}
+
+class FindBenchMark {
+public:
+    FindBenchMark(const TestTree& tree, const vector<Name>& names) :
+        tree_(tree), names_(names)
+    {}
+    unsigned int run() {
+        const TestNode* node;
+        for (vector<Name>::const_iterator it = names_.begin();
+             it != names_.end();
+             ++it) {
+            tree_.find(*it, &node);
+        }
+        return (names_.size());
+    }
+private:
+    const TestTree& tree_;
+    const vector<Name>& names_;
+};
+
+// A simple linear congruential generator, so the test data are the same
+// for every run (and on every platform).
+class NameGenerator {
+public:
+    NameGenerator() : state_(1) {}
+    std::string getLabel() {
+        static const char chars[] = "abcdefghijklmnopqrstuvwxyz0123456789-";
+        const size_t len = 4 + next() % 9;
+        std::string label;
+        for (size_t i = 0; i < len; ++i) {
+            // Don't start or end a label with '-'.
+            label.push_back(chars[next() % (i == 0 || i == len - 1 ?
+                                            36 : 37)]);
+        }
+        return (label);
+    }
+    // Most names are directly below the origin as in typical large zones,
+    // while some are in (a few) sub domains.
+    Name getName(const Name& origin) {
+        if (next() % 8 == 0) {
+            return (Name(getLabel()).concatenate(
+                        Name("sub" + std::string(1, 'a' + next() % 26)).
+                        concatenate(origin)));
+        }
+        return (Name(getLabel()).concatenate(origin));
+    }
+    uint32_t next() {
+        state_ = state_ * 1103515245 + 12345;
+        return ((state_ >> 8) & 0xffffff);
+    }
+private:
+    uint32_t state_;
+};
+
+void
+usage() {
+    std::cerr << "Usage: domaintree_find_bench [-n iterations] "
+        "[-s zone_size] [-q query_count]" << std::endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 10;
+    size_t zone_size = 1000000;
+    size_t query_count = 100000;
+    while ((ch = getopt(argc, argv, "n:s:q:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case 's':
+            zone_size = atoi(optarg);
+            break;
+        case 'q':
+            query_count = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0 || zone_size == 0 || query_count == 0) {
+        usage();
+    }
+
+    // Build the zone.  Like the in-memory data source, the tree contains
+    // the origin and the names below it.
+    const Name origin("example.org");
+    isc::util::MemorySegmentLocal mem_sgmt;
+    TestTree* tree = TestTree::create(mem_sgmt);
+    TestNode* node;
+    tree->insert(mem_sgmt, origin, &node);
+    node->setData(&node_data);
+    NameGenerator generator;
+    vector<Name> names;
+    names.reserve(zone_size);
+    for (size_t i = 0; i < zone_size; ++i) {
+        names.push_back(generator.getName(origin));
+        tree->insert(mem_sgmt, names.back(), &node);
+        node->setData(&node_data);
+    }
+
+    // Queries for existing names, in an order unrelated to the tree's.
+    vector<Name> hit_names;
+    hit_names.reserve(query_count);
+    for (size_t i = 0; i < query_count; ++i) {
+        hit_names.push_back(names[generator.next() % names.size()]);
+    }
+    // And for new random names, which (most likely) don't exist and result
+    // in a partial match at the origin or one of the sub domains.
+    vector<Name> miss_names;
+    miss_names.reserve(query_count);
+    for (size_t i = 0; i < query_count; ++i) {
+        miss_names.push_back(generator.getName(origin));
+    }
+
+    std::cout << "Tree of " << tree->getNodeCount() << " nodes, "
+              << query_count << " queries per iteration" << std::endl;
+    std::cout << "Benchmark for finding existing names" << std::endl;
+    BenchMark<FindBenchMark>(iteration, FindBenchMark(*tree, hit_names));
+    std::cout << "Benchmark for finding non existent names" << std::endl;
+    BenchMark<FindBenchMark>(iteration, FindBenchMark(*tree, miss_names));
+
+    TestTree::destroy(mem_sgmt, tree, nullDeleter);
+
+    return (0);
+}
@@ -0,0 +1,275 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <util/memory_segment_local.h>
+
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+#include <dns/rdataclass.h>
+
+#include <log/logger_support.h>
+
+#include <datasrc/zone.h>
+#include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/zone_data_loader.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace isc::bench;
+using isc::datasrc::ZoneJournalReader;
+using namespace isc::datasrc::memory;
+using namespace isc::dns;
+
+namespace {
+// Load a zone file into the in-memory data source, from the master file
+// parser to the final zone data.  The number of "iterations" is the number
+// of records in the zone, so the benchmark result is given in records per
+// second.
+class ZoneLoadBenchMark {
+public:
+    ZoneLoadBenchMark(const string& filename, const Name& origin,
+                      size_t records, bool compact) :
+        filename_(filename), origin_(origin), records_(records),
+        compact_(compact)
+    {}
+    unsigned int run() {
+        isc::util::MemorySegmentLocal mem_sgmt;
+        ZoneData* zone_data = loadZoneData(mem_sgmt, RRClass::IN(), origin_,
+                                           filename_, compact_);
+        ZoneData::destroy(mem_sgmt, zone_data, RRClass::IN());
+        return (records_);
+    }
+private:
+    const string filename_;
+    const Name origin_;
+    const size_t records_;
+    const bool compact_;
+};
+
+// A journal reader returning a fixed sequence of differences.
+class DiffReader : public ZoneJournalReader {
+public:
+    DiffReader(const vector<ConstRRsetPtr>& diffs) : diffs_(diffs), pos_(0) {}
+    virtual ConstRRsetPtr getNextDiff() {
+        return (pos_ < diffs_.size() ? diffs_[pos_++] : ConstRRsetPtr());
+    }
+private:
+    const vector<ConstRRsetPtr>& diffs_;
+    size_t pos_;
+};
+
+// Create a new version of the zone from the current one and the given
+// differences.  Like ZoneLoadBenchMark, the number of "iterations" is the
+// number of records in the zone, so the two results can be compared.
+class ZoneUpdateBenchMark {
+public:
+    ZoneUpdateBenchMark(isc::util::MemorySegment& mem_sgmt,
+                        const ZoneData& zone_data, const Name& origin,
+                        const vector<ConstRRsetPtr>& diffs, size_t records) :
+        mem_sgmt_(mem_sgmt), zone_data_(zone_data), origin_(origin),
+        diffs_(diffs), records_(records)
+    {}
+    unsigned int run() {
+        DiffReader reader(diffs_);
+        ZoneData* zone_data = updateZoneData(mem_sgmt_, RRClass::IN(),
+                                             origin_, zone_data_, reader);
+        ZoneData::destroy(mem_sgmt_, zone_data, RRClass::IN());
+        return (records_);
+    }
+private:
+    isc::util::MemorySegment& mem_sgmt_;
+    const ZoneData& zone_data_;
+    const Name origin_;
+    const vector<ConstRRsetPtr>& diffs_;
+    const size_t records_;
+};
+
+ConstRRsetPtr
+createRR(const string& owner, const RRType& rrtype, const string& rdata) {
+    RRsetPtr rrset(new RRset(Name(owner), RRClass::IN(), rrtype,
+                             RRTTL(3600)));
+    rrset->addRdata(isc::dns::rdata::createRdata(rrtype, RRClass::IN(),
+                                                 rdata));
+    return (rrset);
+}
+
+// Generate the differences from the zone generated by generateZone()
+// to its next version, in which the address of the given number of A
+// records has changed.
+void
+generateDiffs(size_t records, size_t changes, vector<ConstRRsetPtr>& diffs) {
+    const string soa_rdata("ns1.example.org. hostmaster.example.org. %u "
+                           "7200 3600 2592000 3600");
+    char buf[128];
+    vector<ConstRRsetPtr> added;
+    snprintf(buf, sizeof(buf), soa_rdata.c_str(), 2013010100u);
+    diffs.push_back(createRR("example.org", RRType::SOA(), buf));
+    snprintf(buf, sizeof(buf), soa_rdata.c_str(), 2013010101u);
+    added.push_back(createRR("example.org", RRType::SOA(), buf));
+    for (size_t i = 5; i < records && changes > 0; i += 5, --changes) {
+        snprintf(buf, sizeof(buf), "host%u.example.org",
+                 static_cast<unsigned int>(i));
+        const string owner(buf);
+        snprintf(buf, sizeof(buf), "192.0.%u.%u",
+                 static_cast<unsigned int>((i / 256) % 256),
+                 static_cast<unsigned int>(i % 256));
+        diffs.push_back(createRR(owner, RRType::A(), buf));
+        snprintf(buf, sizeof(buf), "198.51.100.%u",
+                 static_cast<unsigned int>(i % 256));
+        added.push_back(createRR(owner, RRType::A(), buf));
+    }
+    diffs.insert(diffs.end(), added.begin(), added.end());
+}
+
+// Generate a synthetic zone of the given number of records of typical
+// types, one per host name, to the given file.
+void
+generateZone(const string& filename, size_t records) {
+    ofstream ofs(filename.c_str());
+    ofs << "$ORIGIN example.org.\n$TTL 3600\n"
+        << "@ IN SOA ns1 hostmaster 2013010100 7200 3600 2592000 3600\n"
+        << "  IN NS ns1\n  IN NS ns2\n"
+        << "ns1 IN A 192.0.2.1\nns2 IN A 192.0.2.2\n";
+    for (size_t i = 5; i < records; ++i) {
+        ofs << "host" << i;
+        switch (i % 5) {
+        case 0:
+            ofs << " IN A 192.0." << (i / 256) % 256 << "." << i % 256;
+            break;
+        case 1:
+            ofs << " 7200 IN AAAA 2001:db8::" << hex << i % 65536 << dec;
+            break;
+        case 2:
+            ofs << " IN MX 10 mail" << i % 100 << ".example.org.";
+            break;
+        case 3:
+            ofs << " IN CNAME host" << i - 3;
+            break;
+        case 4:
+            ofs << " IN TXT \"v=spf1 ip4:192.0.2.0/24 -all\"";
+            break;
+        }
+        ofs << "\n";
+    }
+}
+
+void
+usage() {
+    cerr << "Usage: zone_load_bench [-c] [-n records] [-u changes] "
+        "[-f zone_file [-o origin]]" << endl;
+    cerr << "  Without -f, a zone of the given number of records is "
+        "generated and loaded" << endl;
+    cerr << "  -c: share the names in the RDATA (compact zone data)" << endl;
+    cerr << "  -u: also update the generated zone with the given number "
+        "of changed records" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    size_t records = 1000000;
+    string filename;
+    string origin = "example.org";
+    size_t changes = 0;
+    bool compact = false;
+    while ((ch = getopt(argc, argv, "cn:u:f:o:")) != -1) {
+        switch (ch) {
+        case 'c':
+            compact = true;
+            break;
+        case 'n':
+            records = atoi(optarg);
+            break;
+        case 'u':
+            changes = atoi(optarg);
+            break;
+        case 'f':
+            filename = optarg;
+            break;
+        case 'o':
+            origin = optarg;
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0 || (changes > 0 && !filename.empty())) {
+        usage();
+    }
+
+    // The loader logs its progress; keep it quiet.
+    isc::log::initLogger("zone_load_bench", isc::log::WARN);
+
+    const bool generate = filename.empty();
+    if (generate) {
+        const char* tmpdir = getenv("TMPDIR");
+        filename = string(tmpdir != NULL ? tmpdir : "/tmp") +
+            "/zone_load_bench.zone";
+        generateZone(filename, records);
+    }
+
+    cout << "Parameters:" << endl;
+    cout << "  Zone file: " << filename << endl;
+    cout << "  Origin: " << origin << endl;
+    cout << "  Records: " << records << endl;
+
+    cout << "Benchmark for loading the zone (records/sec)" << endl;
+    BenchMark<ZoneLoadBenchMark>(1, ZoneLoadBenchMark(filename, Name(origin),
+                                                      records, compact));
+
+    if (changes > 0) {
+        vector<ConstRRsetPtr> diffs;
+        generateDiffs(records, changes, diffs);
+        isc::util::MemorySegmentLocal mem_sgmt;
+        ZoneData* zone_data = loadZoneData(mem_sgmt, RRClass::IN(),
+                                           Name(origin), filename, compact);
+        cout << "Benchmark for updating the zone with " << diffs.size()
+             << " differences (records/sec)" << endl;
+        BenchMark<ZoneUpdateBenchMark>(1, ZoneUpdateBenchMark(mem_sgmt,
+                                                              *zone_data,
+                                                              Name(origin),
+                                                              diffs,
+                                                              records));
+        ZoneData::destroy(mem_sgmt, zone_data, RRClass::IN());
+    }
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        cout << "Peak resident set size: " << usage.ru_maxrss << " KB"
+             << endl;
+    }
+
+    if (generate) {
+        remove(filename.c_str());
+    }
+
+    return (0);
+}
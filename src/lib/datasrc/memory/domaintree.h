@@ -138,6 +138,7 @@ private:
         void* p = mem_sgmt.allocate(sizeof(DomainTreeNode<T>) + labels_len);
         DomainTreeNode<T>* node = new(p) DomainTreeNode<T>(labels_len);
         labels.serialize(node->getLabelsData(), labels_len);
+        node->label_key_ = getLabelKey(labels);
         return (node);
     }
 
@@ -165,6 +166,39 @@ private:
     /// otherwise the serialize() method will throw an exception.
     void resetLabels(const dns::LabelSequence& labels) {
         labels.serialize(getLabelsData(), labels_capacity_);
+        label_key_ = getLabelKey(labels);
+    }
+
+    /// \brief Return a key summarizing the last label of a label sequence.
+    ///
+    /// The key consists of the first (up to) four characters of the last
+    /// (rightmost) label, converted to lower case and padded with zeros,
+    /// in the big endian order.  So, if the keys of two sequences are
+    /// different, their comparison results in \c NONE with the order of
+    /// the keys (without looking into the label data), as long as both
+    /// keys are non zero.  The key is 0 for an empty sequence and for
+    /// sequences ending with the root label, in which case the labels
+    /// need to be compared as usual.
+    ///
+    /// \throw none
+    static uint32_t getLabelKey(const dns::LabelSequence& labels) {
+        const size_t label_count = labels.getLabelCount();
+        if (label_count == 0) {
+            return (0);
+        }
+        dns::LabelSequence last_label(labels);
+        last_label.stripLeft(label_count - 1);
+        size_t data_len;
+        const uint8_t* data = last_label.getData(&data_len);
+        uint32_t key = 0;
+        for (size_t i = 1; i <= 4; ++i) {
+            uint8_t ch = (i <= data[0]) ? data[i] : 0;
+            if (ch >= 'A' && ch <= 'Z') {
+                ch += 'a' - 'A';
+            }
+            key = (key << 8) | ch;
+        }
+        return (key);
     }
 
 public:
@@ -736,6 +770,15 @@ private:
     // So we can change this implementation without affecting its users if
     // a future change to LabelSequence breaks this assumption.
     BOOST_STATIC_ASSERT((1 << 9) > dns::LabelSequence::MAX_SERIALIZED_LENGTH);
+
+    /// \brief The key of the node's last label; see \c getLabelKey().
+    ///
+    /// It lets \c find() skip most of the label comparisons with sibling
+    /// nodes without touching the label data, which are usually in a
+    /// different cache line than the links.  On 64-bit platforms it fits
+    /// in what used to be the padding at the end of the node, so it
+    /// doesn't make the node larger.
+    uint32_t label_key_;
 };
 
 template <typename T>
@@ -746,7 +789,8 @@ DomainTreeNode<T>::DomainTreeNode(size_t labels_capacity) :
     down_(NULL),
     data_(NULL),
     flags_(FLAG_RED | FLAG_SUBTREE_ROOT),
-    labels_capacity_(labels_capacity)
+    labels_capacity_(labels_capacity),
+    label_key_(0)
 {
 }
 
@@ -1844,10 +1888,28 @@ DomainTree<T>::findImpl(TT* tree,
 
     Result ret = NOTFOUND;
     dns::LabelSequence target_labels(target_labels_orig);
+    uint32_t target_key = DomainTreeNode<T>::getLabelKey(target_labels);
 
     while (node != NULL) {
+#ifdef __GNUC__
+        // We'll need one of the children in the next round (unless we
+        // find the name or go down); start loading them while we compare
+        // the labels.
+        __builtin_prefetch(node->left_.get());
+        __builtin_prefetch(node->right_.get());
+#endif
         node_path.last_compared_ = node;
-        node_path.last_comparison_ = target_labels.compare(node->getLabels());
+        if (target_key != 0 && node->label_key_ != 0 &&
+            target_key != node->label_key_) {
+            // The last labels are different, and we know the order
+            // from the keys.
+            node_path.last_comparison_ = isc::dns::NameComparisonResult(
+                target_key < node->label_key_ ? -1 : 1, 0,
+                isc::dns::NameComparisonResult::NONE);
+        } else {
+            node_path.last_comparison_ =
+                target_labels.compare(node->getLabels());
+        }
         const isc::dns::NameComparisonResult::NameRelation relation =
             node_path.last_comparison_.getRelation();
 
@@ -1878,6 +1940,7 @@ DomainTree<T>::findImpl(TT* tree,
                 node_path.push(node);
                 target_labels.stripRight(
                     node_path.last_comparison_.getCommonLabels());
+                target_key = DomainTreeNode<T>::getLabelKey(target_labels);
                 node = node->getDown();
             } else {
                 break;
@@ -2159,16 +2222,19 @@ DomainTree<T>::insert(util::MemorySegment& mem_sgmt,
     DomainTreeNode<T>* current = root_.get();
     DomainTreeNode<T>* up_node = NULL;
     isc::dns::LabelSequence target_labels(target_name);
+    uint32_t target_key = DomainTreeNode<T>::getLabelKey(target_labels);
 
     int order = -1;
-    // For possible LabelSequence serialization we always store labels data
-    // in the separate local buffer.
-    uint8_t labels_buf[dns::LabelSequence::MAX_SERIALIZED_LENGTH];
     while (current != NULL) {
-        const dns::LabelSequence current_labels(
-            dns::LabelSequence(current->getLabels(), labels_buf));
+        // Like in find(), the label keys tell the order of most of the
+        // nodes we pass without looking into the labels.
         const isc::dns::NameComparisonResult compare_result =
-            target_labels.compare(current_labels);
+            (target_key != 0 && current->label_key_ != 0 &&
+             target_key != current->label_key_) ?
+            isc::dns::NameComparisonResult(
+                target_key < current->label_key_ ? -1 : 1, 0,
+                isc::dns::NameComparisonResult::NONE) :
+            target_labels.compare(current->getLabels());
         const isc::dns::NameComparisonResult::NameRelation relation =
             compare_result.getRelation();
         if (relation == isc::dns::NameComparisonResult::EQUAL) {
@@ -2185,12 +2251,17 @@ DomainTree<T>::insert(util::MemorySegment& mem_sgmt,
             parent = NULL;
             up_node = current;
             target_labels.stripRight(compare_result.getCommonLabels());
+            target_key = DomainTreeNode<T>::getLabelKey(target_labels);
             current = current->getDown();
         } else {
             // The number of labels in common is fewer than the number of
             // labels at the current node, so the current node must be
             // adjusted to have just the common suffix, and a down pointer
-            // made to a new tree.
+            // made to a new tree.  The labels of the current node will be
+            // overwritten, so the new prefix is taken from a copy of them.
+            uint8_t labels_buf[dns::LabelSequence::MAX_SERIALIZED_LENGTH];
+            const dns::LabelSequence current_labels(current->getLabels(),
+                                                    labels_buf);
             dns::LabelSequence common_ancestor = target_labels;
             common_ancestor.stripLeft(target_labels.getLabelCount() -
                                       compare_result.getCommonLabels());
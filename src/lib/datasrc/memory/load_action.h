@@ -40,6 +40,24 @@ class ZoneData;
 /// It must not return NULL.
 typedef boost::function<ZoneData*(util::MemorySegment&)> LoadAction;
 
+/// \brief Callback to create a new version of zone data from the current one
+///
+/// This is called from the ZoneWriter before the LoadAction when the zone
+/// already has (non empty) data in memory, which is passed to the callback.
+/// The callback can use them to create the new version of the zone data
+/// more efficiently than loading it from scratch, e.g., by copying them and
+/// applying the differences from the current version.  The passed data are
+/// still in use and must not be modified.
+///
+/// Like the LoadAction, all data should be allocated from the passed
+/// MemorySegment, and the ownership is passed onto the caller.
+///
+/// It returns NULL if it can't create the new version this way (for
+/// example, because the differences aren't available); it may also throw
+/// in that case.  The ZoneWriter then falls back to the LoadAction.
+typedef boost::function<ZoneData*(util::MemorySegment&,
+                                  const ZoneData&)> UpdateAction;
+
 }
 }
 }
@@ -20,6 +20,7 @@
 #include <datasrc/memory/rdataset.h>
 #include <datasrc/memory/treenode_rrset.h>
 #include <datasrc/memory/zone_finder.h>
+#include <datasrc/memory/nsec3_hash_cache.h>
 #include <datasrc/memory/zone_table_segment.h>
 
 #include <datasrc/exceptions.h>
@@ -46,7 +47,8 @@ using boost::shared_ptr;
 InMemoryClient::InMemoryClient(shared_ptr<ZoneTableSegment> ztable_segment,
                                RRClass rrclass) :
     ztable_segment_(ztable_segment),
-    rrclass_(rrclass)
+    rrclass_(rrclass),
+    nsec3_hash_cache_(new NSEC3HashCache)
 {}
 
 RRClass
@@ -70,7 +72,8 @@ InMemoryClient::findZone(const isc::dns::Name& zone_name) const {
 
     ZoneFinderPtr finder;
     if (result.code != result::NOTFOUND && result.zone_data) {
-        finder.reset(new InMemoryZoneFinder(*result.zone_data, getClass()));
+        finder.reset(new InMemoryZoneFinder(*result.zone_data, getClass(),
+                                            nsec3_hash_cache_.get()));
     }
 
     return (DataSourceClient::FindResult(result.code, finder, result.flags));
@@ -37,6 +37,7 @@ namespace datasrc {
 namespace memory {
 
 class ZoneTableSegment;
+class NSEC3HashCache;
 
 /// \brief A data source client that holds all necessary data in memory.
 ///
@@ -117,6 +118,8 @@ public:
 private:
     boost::shared_ptr<ZoneTableSegment> ztable_segment_;
     const isc::dns::RRClass rrclass_;
+    // Shared by the finders of all zones; see NSEC3HashCache.
+    const boost::shared_ptr<NSEC3HashCache> nsec3_hash_cache_;
 };
 
 } // namespace memory
@@ -0,0 +1,138 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <util/memory_segment.h>
+
+#include <dns/labelsequence.h>
+
+#include "name_dictionary.h"
+#include "zone_data.h"
+
+#include <new>                  // for the placement new
+
+using namespace isc::dns;
+
+namespace isc {
+namespace datasrc {
+namespace memory {
+
+namespace {
+// The initial number of slots of the hash table.
+const uint32_t MIN_SLOT_COUNT = 16;
+}
+
+NameDictionary*
+NameDictionary::create(util::MemorySegment& mem_sgmt) {
+    void* p = mem_sgmt.allocate(sizeof(NameDictionary));
+    return (new(p) NameDictionary());
+}
+
+void
+NameDictionary::destroy(util::MemorySegment& mem_sgmt,
+                        NameDictionary* dictionary)
+{
+    Entry* entries = dictionary->entries_.get();
+    for (uint32_t i = 0; i < dictionary->slot_count_; ++i) {
+        if (entries[i].name) {
+            uint8_t* name = entries[i].name.get();
+            mem_sgmt.deallocate(name,
+                                LabelSequence(name).getSerializedLength());
+        }
+    }
+    if (entries != NULL) {
+        mem_sgmt.deallocate(entries, dictionary->slot_count_ * sizeof(Entry));
+    }
+    dictionary->~NameDictionary();
+    mem_sgmt.deallocate(dictionary, sizeof(NameDictionary));
+}
+
+const uint8_t*
+NameDictionary::find(const LabelSequence& labels) const {
+    if (count_ == 0) {
+        return (NULL);
+    }
+    const uint32_t hash = ZoneNameIndex::getHash(labels);
+    const uint32_t mask = slot_count_ - 1;
+    const Entry* entries = entries_.get();
+    for (uint32_t i = hash & mask; entries[i].name; i = (i + 1) & mask) {
+        if (entries[i].hash == hash &&
+            LabelSequence(entries[i].name.get()).equals(labels, true)) {
+            return (entries[i].name.get());
+        }
+    }
+    return (NULL);
+}
+
+const uint8_t*
+NameDictionary::add(util::MemorySegment& mem_sgmt,
+                    const LabelSequence& labels)
+{
+    const uint8_t* found = find(labels);
+    if (found != NULL) {
+        return (found);
+    }
+
+    // Keep the load factor at or below 1/2 (see ZoneNameIndex).  The table
+    // is replaced before the name is allocated, so the dictionary is
+    // consistent whichever allocation throws.
+    if ((count_ + 1) * 2 > slot_count_) {
+        rehash(mem_sgmt, slot_count_ == 0 ? MIN_SLOT_COUNT : slot_count_ * 2);
+    }
+    const size_t name_len = labels.getSerializedLength();
+    uint8_t* name = static_cast<uint8_t*>(mem_sgmt.allocate(name_len));
+    labels.serialize(name, name_len);
+    insert(entries_.get(), slot_count_, ZoneNameIndex::getHash(labels), name);
+    ++count_;
+    names_size_ += name_len;
+    return (name);
+}
+
+void
+NameDictionary::rehash(util::MemorySegment& mem_sgmt, uint32_t slot_count) {
+    void* p = mem_sgmt.allocate(slot_count * sizeof(Entry));
+    Entry* new_entries = static_cast<Entry*>(p);
+    for (uint32_t i = 0; i < slot_count; ++i) {
+        new(&new_entries[i]) Entry();
+    }
+
+    Entry* old_entries = entries_.get();
+    for (uint32_t i = 0; i < slot_count_; ++i) {
+        if (old_entries[i].name) {
+            insert(new_entries, slot_count, old_entries[i].hash,
+                   old_entries[i].name.get());
+        }
+    }
+    if (old_entries != NULL) {
+        mem_sgmt.deallocate(old_entries, slot_count_ * sizeof(Entry));
+    }
+    entries_ = new_entries;
+    slot_count_ = slot_count;
+}
+
+void
+NameDictionary::insert(Entry* entries, uint32_t slot_count, uint32_t hash,
+                       uint8_t* name)
+{
+    const uint32_t mask = slot_count - 1;
+    uint32_t i = hash & mask;
+    while (entries[i].name) {
+        i = (i + 1) & mask;
+    }
+    entries[i].hash = hash;
+    entries[i].name = name;
+}
+
+} // namespace memory
+} // namespace datasrc
+} // namespace isc
@@ -0,0 +1,143 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DATASRC_MEMORY_NAME_DICTIONARY_H
+#define DATASRC_MEMORY_NAME_DICTIONARY_H 1
+
+#include <util/memory_segment.h>
+
+#include <dns/labelsequence.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/interprocess/offset_ptr.hpp>
+
+#include <stdint.h>
+
+namespace isc {
+namespace datasrc {
+namespace memory {
+
+/// \brief A set of domain names shared by the RDATA of a zone.
+///
+/// This class keeps a single copy of each domain name added to it, in
+/// the serialized form of \c dns::LabelSequence, so RDATA encoded by
+/// \c RdataEncoder can refer to the copy instead of holding the name
+/// inline.  This saves memory for zones where many RRs point to the same
+/// small set of names, such as the NS RRs of delegation-heavy (TLD) zones.
+///
+/// Names are compared case sensitively, since the RDATA referring to
+/// them must be rendered as they were given.  They are never removed
+/// individually; all of them are released by \c destroy(), which is
+/// expected to happen only when the zone using the dictionary is
+/// destroyed.
+///
+/// Like \c ZoneNameIndex, the hash table is an open addressing table in
+/// the same memory segment, and all pointers are offset pointers, so it
+/// can be placed in a shared memory region.
+class NameDictionary : boost::noncopyable {
+public:
+    /// \brief Allocate and construct an empty \c NameDictionary.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.  In this case nothing is allocated.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt A \c MemorySegment from which memory for the new
+    /// \c NameDictionary is allocated.
+    static NameDictionary* create(util::MemorySegment& mem_sgmt);
+
+    /// \brief Destruct and deallocate \c NameDictionary and all its names.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt The \c MemorySegment that allocated memory for
+    /// \c dictionary.
+    /// \param dictionary A non-NULL pointer to a valid NameDictionary object
+    /// that was originally created by the \c create() method.
+    static void destroy(util::MemorySegment& mem_sgmt,
+                        NameDictionary* dictionary);
+
+    /// \brief Find the given name.
+    ///
+    /// \throw none
+    ///
+    /// \param labels The name to be found.
+    /// \return The serialized \c dns::LabelSequence data of the name if
+    /// it's in the dictionary; NULL otherwise.
+    const uint8_t* find(const dns::LabelSequence& labels) const;
+
+    /// \brief Add the given name, unless it's already in the dictionary.
+    ///
+    /// On exception, the dictionary is intact (the name may or may not have
+    /// been added).  Addresses returned by \c find() and \c add() before a
+    /// \c util::MemorySegmentGrown exception may have been relocated.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt The \c MemorySegment that allocated memory for
+    /// this dictionary.
+    /// \param labels The name to be added.
+    /// \return The serialized \c dns::LabelSequence data of the name in the
+    /// dictionary.
+    const uint8_t* add(util::MemorySegment& mem_sgmt,
+                       const dns::LabelSequence& labels);
+
+    /// \brief Return the number of names in the dictionary.
+    ///
+    /// \throw none
+    size_t getNameCount() const { return (count_); }
+
+    /// \brief Return the size of memory allocated for the dictionary.
+    ///
+    /// It covers the object itself, the hash table and the names; any
+    /// overhead of the memory segment is not included.
+    ///
+    /// \throw none
+    size_t getMemorySize() const {
+        return (sizeof(NameDictionary) + slot_count_ * sizeof(Entry) +
+                names_size_);
+    }
+
+private:
+    struct Entry {
+        uint32_t hash;
+        boost::interprocess::offset_ptr<uint8_t> name; // NULL if free
+    };
+
+    NameDictionary() : slot_count_(0), count_(0), names_size_(0) {}
+
+    void rehash(util::MemorySegment& mem_sgmt, uint32_t slot_count);
+    static void insert(Entry* entries, uint32_t slot_count, uint32_t hash,
+                       uint8_t* name);
+
+    // The hash table; NULL until the first name is added.  The number of
+    // slots is a power of 2.
+    boost::interprocess::offset_ptr<Entry> entries_;
+    uint32_t slot_count_;
+    uint32_t count_;
+    // The total size of the serialized names.
+    size_t names_size_;
+};
+
+} // namespace memory
+} // namespace datasrc
+} // namespace isc
+
+#endif // DATASRC_MEMORY_NAME_DICTIONARY_H
+
+// Local Variables:
+// mode: c++
+// End:
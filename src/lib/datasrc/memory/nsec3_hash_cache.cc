@@ -0,0 +1,192 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/nsec3_hash_cache.h>
+#include <datasrc/memory/zone_data.h>
+
+#include <dns/name.h>
+#include <dns/name_internal.h>
+
+#include <util/threads/sync.h>
+
+#include <boost/functional/hash.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <cstring>
+#include <list>
+#include <utility>
+
+using isc::dns::LabelSequence;
+using isc::dns::Name;
+using isc::util::thread::Mutex;
+
+namespace isc {
+namespace datasrc {
+namespace memory {
+
+namespace {
+// Caches smaller than this are not split, so the least recently used
+// entry is exactly the one that is evicted.  This matters little in
+// practice, but makes the behavior of small caches predictable.
+const size_t MIN_SHARDED_CAPACITY = 1024;
+const size_t NUM_SHARDS = 16;
+
+// The key of an entry: the hash algorithm, iterations, salt length, salt
+// and the lower-cased wire format of the name, in this order.
+void
+makeKey(const NSEC3Data& nsec3_data, const LabelSequence& name,
+        std::string& key)
+{
+    uint8_t buf[4 + 255 + Name::MAX_WIRE];
+    const size_t salt_len = nsec3_data.getSaltLen();
+    buf[0] = nsec3_data.hashalg;
+    buf[1] = nsec3_data.iterations >> 8;
+    buf[2] = nsec3_data.iterations & 0xff;
+    buf[3] = salt_len;
+    std::memcpy(buf + 4, nsec3_data.getSaltData(), salt_len);
+    size_t name_len;
+    const uint8_t* name_data = name.getData(&name_len);
+    dns::name::internal::downcase(name_data, buf + 4 + salt_len, name_len);
+    key.assign(reinterpret_cast<const char*>(buf), 4 + salt_len + name_len);
+}
+
+// A part of the cache with its own lock and LRU list.  The list is kept
+// in the order of use, the most recently used entry at the front.
+struct Shard {
+    typedef std::list<std::pair<std::string, std::string> > EntryList;
+    typedef boost::unordered_map<std::string, EntryList::iterator> EntryMap;
+
+    Shard() : size(0) {}
+
+    mutable Mutex mutex;
+    EntryList entries;
+    EntryMap index;
+    // std::list::size() may be linear in C++03
+    size_t size;
+};
+}
+
+struct NSEC3HashCache::NSEC3HashCacheImpl {
+    NSEC3HashCacheImpl(size_t capacity) :
+        num_shards_(capacity >= MIN_SHARDED_CAPACITY ? NUM_SHARDS : 1),
+        shard_capacity_((capacity + num_shards_ - 1) / num_shards_),
+        shards_(new Shard[num_shards_])
+    {}
+
+    Shard& getShard(const std::string& key) {
+        return (shards_[boost::hash_value(key) % num_shards_]);
+    }
+
+    const size_t num_shards_;
+    const size_t shard_capacity_;
+    boost::scoped_array<Shard> shards_;
+};
+
+NSEC3HashCache::NSEC3HashCache(size_t capacity) :
+    impl_(new NSEC3HashCacheImpl(capacity))
+{}
+
+NSEC3HashCache::~NSEC3HashCache() {
+    delete impl_;
+}
+
+bool
+NSEC3HashCache::find(const NSEC3Data& nsec3_data, const LabelSequence& name,
+                     std::string& hash)
+{
+    std::string key;
+    makeKey(nsec3_data, name, key);
+    Shard& shard = impl_->getShard(key);
+
+    Mutex::Locker locker(shard.mutex);
+    const Shard::EntryMap::const_iterator found = shard.index.find(key);
+    if (found == shard.index.end()) {
+        return (false);
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries,
+                         found->second);
+    hash = found->second->second;
+    return (true);
+}
+
+void
+NSEC3HashCache::insert(const NSEC3Data& nsec3_data, const LabelSequence& name,
+                       const std::string& hash)
+{
+    if (impl_->shard_capacity_ == 0) {
+        return;
+    }
+
+    std::string key;
+    makeKey(nsec3_data, name, key);
+    Shard& shard = impl_->getShard(key);
+
+    Mutex::Locker locker(shard.mutex);
+    const Shard::EntryMap::iterator found = shard.index.find(key);
+    if (found != shard.index.end()) {
+        found->second->second = hash;
+        shard.entries.splice(shard.entries.begin(), shard.entries,
+                             found->second);
+        return;
+    }
+
+    if (shard.size >= impl_->shard_capacity_) {
+        // Reuse the least recently used entry for the new one.
+        Shard::EntryList::iterator last = shard.entries.end();
+        --last;
+        shard.index.erase(last->first);
+        last->first.swap(key);
+        last->second = hash;
+        shard.entries.splice(shard.entries.begin(), shard.entries, last);
+    } else {
+        shard.entries.push_front(std::make_pair(key, hash));
+        ++shard.size;
+    }
+    try {
+        shard.index.insert(std::make_pair(shard.entries.front().first,
+                                          shard.entries.begin()));
+    } catch (...) {
+        // Keep the list and the index consistent.
+        shard.entries.pop_front();
+        --shard.size;
+        throw;
+    }
+}
+
+size_t
+NSEC3HashCache::getSize() const {
+    size_t size = 0;
+    for (size_t i = 0; i < impl_->num_shards_; ++i) {
+        const Shard& shard = impl_->shards_[i];
+        Mutex::Locker locker(shard.mutex);
+        size += shard.size;
+    }
+    return (size);
+}
+
+void
+NSEC3HashCache::clear() {
+    for (size_t i = 0; i < impl_->num_shards_; ++i) {
+        Shard& shard = impl_->shards_[i];
+        Mutex::Locker locker(shard.mutex);
+        shard.index.clear();
+        shard.entries.clear();
+        shard.size = 0;
+    }
+}
+
+} // namespace memory
+} // namespace datasrc
+} // namespace isc
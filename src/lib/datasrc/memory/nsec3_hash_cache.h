@@ -0,0 +1,118 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DATASRC_MEMORY_NSEC3_HASH_CACHE_H
+#define DATASRC_MEMORY_NSEC3_HASH_CACHE_H 1
+
+#include <dns/labelsequence.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <string>
+
+namespace isc {
+namespace datasrc {
+namespace memory {
+
+class NSEC3Data;
+
+/// \brief A cache of NSEC3 hashes of domain names.
+///
+/// Proving the nonexistence of a name in an NSEC3-signed zone needs the
+/// NSEC3 hash of the query name and each of its ancestors up to the zone
+/// origin, and each of them is an iterated SHA-1 calculation.  Most of
+/// these names (the closest enclosers, typically the origin itself and
+/// its direct children) are the same for many queries, so this class
+/// keeps recently calculated hashes for \c InMemoryZoneFinder::findNSEC3().
+///
+/// The entries are keyed by the NSEC3 parameters (hash algorithm,
+/// iterations and salt) as well as the name, ignoring its case.  So a
+/// single cache can be shared by all zones of a data source client, and
+/// an entry never becomes stale: when a zone is reloaded with new
+/// parameters its old entries are simply not found any more and are
+/// eventually evicted.
+///
+/// The number of entries is limited, and the least recently used ones are
+/// evicted when the limit is reached.  The entries are split into several
+/// shards, each with its own lock, so the cache can be used by multiple
+/// threads at the same time.
+class NSEC3HashCache : boost::noncopyable {
+public:
+    /// \brief The default maximum number of entries.
+    static const size_t DEFAULT_CAPACITY = 10000;
+
+    /// \brief Constructor.
+    ///
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param capacity The maximum number of entries in the cache.  If it's
+    /// 0, the cache never holds anything.
+    explicit NSEC3HashCache(size_t capacity = DEFAULT_CAPACITY);
+
+    /// \brief Destructor.
+    ~NSEC3HashCache();
+
+    /// \brief Find the hash of a name.
+    ///
+    /// If the hash is found it's also marked as the most recently used
+    /// one.
+    ///
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param nsec3_data The NSEC3 parameters of the zone.
+    /// \param name The (absolute) name to be hashed.
+    /// \param hash Set to the hash, in the form returned by
+    /// \c dns::NSEC3Hash::calculate(), if it's found.
+    /// \return true if the hash is found; false otherwise.
+    bool find(const NSEC3Data& nsec3_data, const dns::LabelSequence& name,
+              std::string& hash);
+
+    /// \brief Add the hash of a name.
+    ///
+    /// If the cache is full, the least recently used entry of the same
+    /// shard is removed.  If the name is already in the cache, its hash is
+    /// replaced.
+    ///
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param nsec3_data The NSEC3 parameters of the zone.
+    /// \param name The (absolute) name that was hashed.
+    /// \param hash The hash of \c name.
+    void insert(const NSEC3Data& nsec3_data, const dns::LabelSequence& name,
+                const std::string& hash);
+
+    /// \brief Return the number of entries in the cache.
+    ///
+    /// \throw none
+    size_t getSize() const;
+
+    /// \brief Remove all entries.
+    ///
+    /// \throw none
+    void clear();
+
+private:
+    struct NSEC3HashCacheImpl;
+    NSEC3HashCacheImpl* impl_;
+};
+
+} // namespace memory
+} // namespace datasrc
+} // namespace isc
+
+#endif // DATASRC_MEMORY_NSEC3_HASH_CACHE_H
+
+// Local Variables:
+// mode: c++
+// End:
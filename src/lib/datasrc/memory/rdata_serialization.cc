@@ -13,12 +13,15 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include "rdata_serialization.h"
+#include "name_dictionary.h"
 
 #include <exceptions/exceptions.h>
 
 #include <util/buffer.h>
+#include <util/memory_segment.h>
 
 #include <dns/name.h>
+#include <dns/name_internal.h>
 #include <dns/labelsequence.h>
 #include <dns/messagerenderer.h>
 #include <dns/rdata.h>
@@ -29,16 +32,17 @@
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
 #include <boost/optional.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <cassert>
 #include <cstring>
-#include <set>
+#include <map>
+#include <typeinfo>
 #include <vector>
 
 using namespace isc::dns;
 using namespace isc::dns::rdata;
 using std::vector;
-using std::set;
 
 namespace isc {
 namespace datasrc {
@@ -245,7 +249,8 @@ namespace {
 class RdataFieldComposer : public AbstractMessageRenderer {
 public:
     RdataFieldComposer() : last_data_pos_(0), encode_spec_(NULL),
-                           current_field_(0)
+                           current_field_(0), rdata_pos_(0),
+                           rdata_lengths_count_(0), rdata_names_count_(0)
     {}
     virtual ~RdataFieldComposer() {}
     virtual bool isTruncated() const { return (false); }
@@ -254,14 +259,14 @@ public:
     virtual void setTruncated() {}
     virtual void setLengthLimit(size_t) {}
     virtual void setCompressMode(CompressMode) {}
-    virtual void writeName(const LabelSequence&, bool) {
-        // We don't need this version of writeName
-        isc_throw(Unexpected, "unexpected version of writeName is called");
-    }
-
     // Called for each domain name in the RDATA, from the RDATA's toWire()
     // implementation.
     virtual void writeName(const Name& name, bool compress) {
+        writeName(LabelSequence(name), compress);
+    }
+
+    // Called for each domain name of previously encoded data being merged.
+    virtual void writeName(const LabelSequence& labels, bool compress) {
         // First, see if we have other data already stored in the renderer's
         // buffer, and handle it appropriately.
         updateOtherData();
@@ -271,7 +276,7 @@ public:
         if (current_field_ >= encode_spec_->field_count) {
             isc_throw(BadValue,
                       "RDATA encoder encounters an unexpected name data: " <<
-                      name);
+                      labels);
         }
         const RdataFieldSpec& field =
             encode_spec_->fields[current_field_++];
@@ -284,11 +289,12 @@ public:
         if (compress !=
             ((field.name_attributes & NAMEATTR_COMPRESSIBLE) != 0)) {
             isc_throw(BadValue, "RDATA encoder error, inconsistent name "
-                      "compression policy: " << name);
+                      "compression policy: " << labels);
         }
 
-        const LabelSequence labels(name);
         labels.serialize(labels_placeholder_, sizeof(labels_placeholder_));
+        name_fields_.push_back(std::make_pair(getLength(),
+                                              labels.getSerializedLength()));
         writeData(labels_placeholder_, labels.getSerializedLength());
 
         last_data_pos_ += labels.getSerializedLength();
@@ -298,11 +304,15 @@ public:
         AbstractMessageRenderer::clear();
         encode_spec_ = encode_spec;
         data_lengths_.clear();
+        name_fields_.clear();
         last_data_pos_ = 0;
     }
     // Called at the beginning of an RDATA.
     void startRdata() {
         current_field_ = 0;
+        rdata_pos_ = getLength();
+        rdata_lengths_count_ = data_lengths_.size();
+        rdata_names_count_ = name_fields_.size();
     }
     // Called at the end of an RDATA.
     void endRdata() {
@@ -314,11 +324,25 @@ public:
                       "RDATA encoder didn't find all expected fields");
         }
     }
+    // Return the position of the RDATA since the last startRdata().
+    size_t getRdataPos() const {
+        return (rdata_pos_);
+    }
+    // Remove the RDATA since the last startRdata() (used for duplicates).
+    void cancelRdata() {
+        trim(getLength() - rdata_pos_);
+        data_lengths_.resize(rdata_lengths_count_);
+        name_fields_.resize(rdata_names_count_);
+        last_data_pos_ = rdata_pos_;
+    }
 
     // Hold the lengths of variable length fields, in the order of their
     // appearance.  For convenience, allow the encoder to refer to it
     // directly.
     vector<uint16_t> data_lengths_;
+    // Hold the position and length of the serialized names in the buffer,
+    // in the order of their appearance.
+    vector<std::pair<size_t, size_t> > name_fields_;
 
 private:
     // We use generict write* methods, with the exception of writeName.
@@ -368,6 +392,10 @@ private:
     // the RDATA field (for encoding) currently handled.  Reset to 0 for
     // each RDATA of the session.
     size_t current_field_;
+    // The state at the beginning of the current RDATA, for cancelRdata().
+    size_t rdata_pos_;
+    size_t rdata_lengths_count_;
+    size_t rdata_names_count_;
     // Placeholder to convert a name object to a label sequence.
     uint8_t labels_placeholder_[LabelSequence::MAX_SERIALIZED_LENGTH];
 };
@@ -375,20 +403,53 @@ private:
 } // end of unnamed namespace
 
 namespace {
-// A trivial comparison function used for std::set<ConstRdataPtr> below.
-bool
-RdataLess(const ConstRdataPtr& rdata1, const ConstRdataPtr& rdata2) {
-    return (rdata1->compare(*rdata2) < 0);
+// The length of the fields of RRSIG RDATA preceding the signer's name
+// (from the type covered to the key tag).
+const size_t RRSIG_FIXED_LEN = 18;
+
+// The initial value and the update of the hash of encoded RDATA (FNV-1a).
+// Domain names are converted to lower case like in the canonical form.
+const size_t HASH_INIT = 2166136261U;
+
+size_t
+updateHash(size_t hash, const uint8_t* data, size_t data_len, bool is_name) {
+    for (size_t i = 0; i < data_len; ++i) {
+        hash = (hash ^ (is_name ? name::internal::maptolower[data[i]] :
+                        data[i])) * 16777619U;
+    }
+    return (hash);
+}
+
+// Return the length of the uncompressed wire-format name at the beginning
+// of the given data, or 0 if it doesn't end within the data.
+size_t
+getWireNameLength(const uint8_t* data, size_t data_len) {
+    size_t pos = 0;
+    while (pos < data_len) {
+        const size_t label_len = data[pos];
+        pos += label_len + 1;
+        if (label_len == 0) {
+            return (pos);
+        }
+    }
+    return (0);
+}
+
+// Return the length of the signer's name of the given RRSIG RDATA (in the
+// wire format), or 0 if it's broken.
+size_t
+getSignerLength(const uint8_t* data, size_t data_len) {
+    if (data_len <= RRSIG_FIXED_LEN) {
+        return (0);
+    }
+    return (getWireNameLength(data + RRSIG_FIXED_LEN,
+                              data_len - RRSIG_FIXED_LEN));
 }
 }
 
 struct RdataEncoder::RdataEncoderImpl {
-    RdataEncoderImpl() : encode_spec_(NULL), rrsig_buffer_(0),
-                         old_varlen_count_(0), old_sig_count_(0),
-                         old_data_len_(0), old_sig_len_(0),
-                         old_length_fields_(NULL), old_data_(NULL),
-                         old_sig_data_(NULL), olddata_buffer_(0),
-                         rdatas_(RdataLess), rrsigs_(RdataLess)
+    RdataEncoderImpl() : dictionary_(NULL), encode_spec_(NULL),
+                         rdata_type_(NULL), sig_type_(NULL), rrsig_buffer_(0)
     {}
 
     // Common initialization for RdataEncoder::start().
@@ -400,51 +461,302 @@ struct RdataEncoder::RdataEncoderImpl {
         encode_spec_ = &getRdataEncodeSpec(rrclass, rrtype);
         current_class_ = rrclass;
         current_type_ = rrtype;
+        rdata_type_ = getRdataType(rrtype);
+        sig_type_ = getRdataType(RRType::RRSIG());
         field_composer_.clearLocal(encode_spec_);
         rrsig_buffer_.clear();
         rrsig_lengths_.clear();
-        old_varlen_count_ = 0;
-        old_sig_count_ = 0;
-        old_data_len_ = 0;
-        old_sig_len_ = 0;
-        old_length_fields_ = NULL;
-        old_data_ = NULL;
-        old_sig_data_ = NULL;
-        olddata_buffer_.clear();
+        name_refs_.clear();
+        rdata_index_.clear();
+        rdata_positions_.clear();
+        rrsig_index_.clear();
+        rrsig_positions_.clear();
+    }
+
+    // Check the given Rdata is of the type of the session, like
+    // createRdata() would by making a copy of it (it throws std::bad_cast
+    // otherwise).  The copy is only made for the first Rdata of each C++
+    // type, which is remembered in rdata_types_.
+    void checkRdataType(const Rdata& rdata, const RRType& rrtype,
+                        const std::type_info*& known_type)
+    {
+        if (known_type != NULL && typeid(rdata) == *known_type) {
+            return;
+        }
+        createRdata(rrtype, *current_class_, rdata);
+        known_type = &typeid(rdata);
+        rdata_types_[std::make_pair(rrtype, *current_class_)] = known_type;
+    }
+    const std::type_info* getRdataType(const RRType& rrtype) const {
+        const RdataTypes::const_iterator found =
+            rdata_types_.find(std::make_pair(rrtype, *current_class_));
+        return (found != rdata_types_.end() ? found->second : NULL);
+    }
+
+    // Compute the hash of the RDATA encoded at the given position of
+    // field_composer_, which is the index-th one in the session.
+    size_t hashRdata(size_t pos, size_t index) const {
+        const uint8_t* dp =
+            static_cast<const uint8_t*>(field_composer_.getData()) + pos;
+        size_t varlen_pos = index * encode_spec_->varlen_count;
+        size_t hash = HASH_INIT;
+        for (size_t i = 0; i < encode_spec_->field_count; ++i) {
+            const RdataFieldSpec& field = encode_spec_->fields[i];
+            if (field.type == RdataFieldSpec::DOMAIN_NAME) {
+                const LabelSequence labels(dp);
+                size_t data_len;
+                const uint8_t* data = labels.getData(&data_len);
+                hash = updateHash(hash, data, data_len, true);
+                dp += labels.getSerializedLength();
+            } else {
+                const size_t data_len =
+                    (field.type == RdataFieldSpec::FIXEDLEN_DATA) ?
+                    field.fixeddata_len :
+                    field_composer_.data_lengths_[varlen_pos++];
+                hash = updateHash(hash, dp, data_len, false);
+                dp += data_len;
+            }
+        }
+        return (hash);
+    }
+
+    // Check if two RDATAs encoded in field_composer_ (see hashRdata() for
+    // the parameters) are the same in their canonical form; domain names
+    // are compared in a case-insensitive manner and other fields as they
+    // are.  Note that the canonical form of RR types not known to have
+    // domain names in encode_spec_ (such as CAA) is its plain wire format.
+    bool isSameRdata(size_t pos1, size_t index1, size_t pos2,
+                     size_t index2) const
+    {
+        const uint8_t* const data =
+            static_cast<const uint8_t*>(field_composer_.getData());
+        const uint8_t* dp1 = data + pos1;
+        const uint8_t* dp2 = data + pos2;
+        size_t varlen_pos1 = index1 * encode_spec_->varlen_count;
+        size_t varlen_pos2 = index2 * encode_spec_->varlen_count;
+        for (size_t i = 0; i < encode_spec_->field_count; ++i) {
+            const RdataFieldSpec& field = encode_spec_->fields[i];
+            if (field.type == RdataFieldSpec::DOMAIN_NAME) {
+                const LabelSequence labels1(dp1);
+                const LabelSequence labels2(dp2);
+                if (!labels1.equals(labels2)) {
+                    return (false);
+                }
+                dp1 += labels1.getSerializedLength();
+                dp2 += labels2.getSerializedLength();
+            } else {
+                const bool fixed =
+                    (field.type == RdataFieldSpec::FIXEDLEN_DATA);
+                const size_t len1 = fixed ? field.fixeddata_len :
+                    field_composer_.data_lengths_[varlen_pos1++];
+                const size_t len2 = fixed ? field.fixeddata_len :
+                    field_composer_.data_lengths_[varlen_pos2++];
+                if (len1 != len2 || std::memcmp(dp1, dp2, len1) != 0) {
+                    return (false);
+                }
+                dp1 += len1;
+                dp2 += len2;
+            }
+        }
+        return (true);
+    }
+
+    // Encode the given RDATA in field_composer_.
+    void addRdataInternal(const Rdata& rdata) {
+        field_composer_.startRdata();
+        rdata.toWire(field_composer_);
+        field_composer_.endRdata();
+    }
+
+    // Encode the given wire-format RDATA in field_composer_, splitting it
+    // into the fields as the toWire() of the corresponding Rdata would.
+    // A variable length field can only be determined if it's the last one.
+    void addWireRdataInternal(const uint8_t* data, size_t data_len) {
+        field_composer_.startRdata();
+        size_t pos = 0;
+        for (size_t i = 0; i < encode_spec_->field_count; ++i) {
+            const RdataFieldSpec& field = encode_spec_->fields[i];
+            if (field.type == RdataFieldSpec::DOMAIN_NAME) {
+                pos += addWireName(data + pos, data_len - pos,
+                                   (field.name_attributes &
+                                    NAMEATTR_COMPRESSIBLE) != 0);
+                continue;
+            }
+            size_t field_len = data_len - pos;
+            if (field.type == RdataFieldSpec::FIXEDLEN_DATA) {
+                if (field_len < field.fixeddata_len) {
+                    isc_throw(BadValue, "RDATA encoding: available data too "
+                              "short for the type");
+                }
+                field_len = field.fixeddata_len;
+            } else if (i + 1 != encode_spec_->field_count) {
+                isc_throw(BadValue, "RDATA of " << *current_type_ <<
+                          " can't be encoded from the wire format");
+            }
+            field_composer_.writeData(data + pos, field_len);
+            pos += field_len;
+        }
+        if (pos != data_len) {
+            isc_throw(BadValue, "RDATA encoding: extra data for the type");
+        }
+        field_composer_.endRdata();
+    }
+
+    // Encode the uncompressed wire-format name at the beginning of the given
+    // data in field_composer_ and return its length.
+    size_t addWireName(const uint8_t* data, size_t data_len, bool compress) {
+        // Convert it to a serialized LabelSequence: the number of labels,
+        // their offsets, and the name data.
+        uint8_t offsets[Name::MAX_LABELS];
+        size_t label_count = 0;
+        size_t pos = 0;
+        while (true) {
+            if (pos >= data_len || label_count == Name::MAX_LABELS ||
+                data[pos] > Name::MAX_LABELLEN) {
+                isc_throw(BadValue, "RDATA encoding: bad wire-format name");
+            }
+            offsets[label_count++] = pos;
+            const size_t label_len = data[pos];
+            pos += label_len + 1;
+            if (label_len == 0) {
+                break;
+            }
+        }
+        if (pos > Name::MAX_WIRE) {
+            isc_throw(BadValue, "RDATA encoding: bad wire-format name");
+        }
+        uint8_t* bp = wire_name_placeholder_;
+        *bp++ = label_count;
+        std::memcpy(bp, offsets, label_count);
+        std::memcpy(bp + label_count, data, pos);
+        field_composer_.writeName(LabelSequence(wire_name_placeholder_),
+                                  compress);
+        return (pos);
+    }
+
+    // Called after an RDATA is encoded in field_composer_.  If it's a
+    // duplicate of another one in the session, remove it and return false.
+    bool commitRdata() {
+        const size_t pos = field_composer_.getRdataPos();
+        const size_t index = rdata_positions_.size();
+        const size_t hash = hashRdata(pos, index);
+        const std::pair<HashIndex::const_iterator, HashIndex::const_iterator>
+            found = rdata_index_.equal_range(hash);
+        for (HashIndex::const_iterator it = found.first; it != found.second;
+             ++it) {
+            const size_t i = it->second;
+            if (isSameRdata(rdata_positions_[i], i, pos, index)) {
+                field_composer_.cancelRdata();
+                return (false);
+            }
+        }
+        rdata_index_.insert(HashIndex::value_type(hash, index));
+        rdata_positions_.push_back(pos);
+        return (true);
+    }
 
-        rdatas_.clear();
-        rrsigs_.clear();
+    // Called after an RRSIG RDATA is written at the given position of
+    // rrsig_buffer_ in the wire format.  If it's a duplicate of another
+    // one in the session, remove it and return false.  The comparison is
+    // in the canonical form, i.e., the signer's names are compared in a
+    // case-insensitive manner.
+    bool commitSIG(size_t pos) {
+        const size_t data_len = rrsig_buffer_.getLength() - pos;
+        if (data_len > 0xffff) {
+            isc_throw(RdataEncodingError, "RRSIG is too large: "
+                      << data_len << " bytes");
+        }
+        const uint8_t* const sigs =
+            static_cast<const uint8_t*>(rrsig_buffer_.getData());
+        const uint8_t* const dp = sigs + pos;
+        const size_t signer_len = getSignerLength(dp, data_len);
+        const size_t sig_pos = RRSIG_FIXED_LEN + signer_len;
+        const size_t hash = (signer_len == 0) ?
+            updateHash(HASH_INIT, dp, data_len, false) :
+            updateHash(updateHash(updateHash(HASH_INIT, dp, RRSIG_FIXED_LEN,
+                                             false),
+                                  dp + RRSIG_FIXED_LEN, signer_len, true),
+                       dp + sig_pos, data_len - sig_pos, false);
+        const std::pair<HashIndex::const_iterator, HashIndex::const_iterator>
+            found = rrsig_index_.equal_range(hash);
+        for (HashIndex::const_iterator it = found.first; it != found.second;
+             ++it) {
+            const size_t i = it->second;
+            if (rrsig_lengths_[i] != data_len) {
+                continue;
+            }
+            const uint8_t* const dp2 = sigs + rrsig_positions_[i];
+            const bool same = (signer_len == 0) ?
+                (std::memcmp(dp, dp2, data_len) == 0) :
+                (std::memcmp(dp, dp2, RRSIG_FIXED_LEN) == 0 &&
+                 name::internal::mismatchIgnoreCase(
+                     dp + RRSIG_FIXED_LEN, dp2 + RRSIG_FIXED_LEN,
+                     signer_len) == signer_len &&
+                 std::memcmp(dp + sig_pos, dp2 + sig_pos,
+                             data_len - sig_pos) == 0);
+            if (same) {
+                rrsig_buffer_.trim(data_len);
+                return (false);
+            }
+        }
+        rrsig_index_.insert(HashIndex::value_type(hash,
+                                                  rrsig_positions_.size()));
+        rrsig_positions_.push_back(pos);
+        rrsig_lengths_.push_back(data_len);
+        return (true);
     }
 
+    // Encode an RRSIG of the old data given in the merge mode; they must
+    // not contain duplicates.
+    void addOldSIGData(const void* data, size_t data_len) {
+        const size_t pos = rrsig_buffer_.getLength();
+        rrsig_buffer_.writeData(data, data_len);
+        if (!commitSIG(pos)) {
+            isc_throw(Unexpected, "duplicate RRSIG found in merging RdataSet");
+        }
+    }
+
+    // Placeholder to convert a wire-format name to a label sequence.
+    uint8_t wire_name_placeholder_[LabelSequence::MAX_SERIALIZED_LENGTH];
+
+    // The dictionary of shared names, if any.  It's kept across sessions.
+    NameDictionary* dictionary_;
+    // The shared names for the names in field_composer_ (in the order of
+    // name_fields_), set by internNames().  NULL for those encoded inline.
+    vector<const uint8_t*> name_refs_;
+
     const RdataEncodeSpec* encode_spec_; // encode spec of current RDATA set
     RdataFieldComposer field_composer_;
+
+    // The C++ types of the Rdata of the RR types and classes we've seen,
+    // and those of the current session (NULL if not known yet).
+    typedef std::map<std::pair<RRType, RRClass>, const std::type_info*>
+    RdataTypes;
+    RdataTypes rdata_types_;
+    const std::type_info* rdata_type_;
+    const std::type_info* sig_type_;
+
+    // Indices of the RDATAs (or RRSIGs) of the session by their hashes, so
+    // a new one is compared only with those of the same hash to detect
+    // duplicates.
+    typedef boost::unordered_multimap<size_t, size_t> HashIndex;
+
+    // The positions in field_composer_ of the RDATAs of the session and
+    // their index.
+    vector<size_t> rdata_positions_;
+    HashIndex rdata_index_;
+
+    // RRSIGs of the session, concatenated, and their lengths and positions
+    // in rrsig_buffer_ and their index.
     util::OutputBuffer rrsig_buffer_;
     vector<uint16_t> rrsig_lengths_;
+    vector<size_t> rrsig_positions_;
+    HashIndex rrsig_index_;
 
     // Placeholder for the RR class and type of the current session;
     // initially null, and will be (re)set at the beginning of each session.
     boost::optional<RRClass> current_class_;
     boost::optional<RRType> current_type_;
-
-    // Parameters corresponding to the previously encoded data in the
-    // merge mode.
-    size_t old_varlen_count_;
-    size_t old_sig_count_;
-    size_t old_data_len_;
-    size_t old_sig_len_;
-    const void* old_length_fields_;
-    const void* old_data_;
-    const void* old_sig_data_;
-    util::OutputBuffer olddata_buffer_;
-
-    // Temporary storage of Rdata and RRSIGs to be encoded.  They are used
-    // to detect and ignore duplicate data.
-    typedef boost::function<bool(const ConstRdataPtr&, const ConstRdataPtr&)>
-    RdataCmp;
-    // added unique Rdatas
-    set<ConstRdataPtr, RdataCmp> rdatas_;
-    // added unique RRSIG Rdatas
-    set<ConstRdataPtr, RdataCmp> rrsigs_;
 };
 
 RdataEncoder::RdataEncoder() :
@@ -455,31 +767,32 @@ RdataEncoder::~RdataEncoder() {
     delete impl_;
 }
 
+void
+RdataEncoder::setNameDictionary(NameDictionary* dictionary) {
+    impl_->dictionary_ = dictionary;
+}
+
 void
 RdataEncoder::start(RRClass rrclass, RRType rrtype) {
     impl_->start(rrclass, rrtype);
 }
 
 namespace {
-// Helper callbacks used in the merge mode of start().  These re-construct
-// each RDATA and RRSIG in the wire-format, counting the total length of the
-// encoded data fields.
+// Helper callbacks used in the merge mode of start().  These encode the
+// fields of the previously encoded RDATAs again.
 void
-decodeName(const LabelSequence& name_labels, RdataNameAttributes,
-           util::OutputBuffer* buffer, size_t* total_len)
+composeName(const LabelSequence& name_labels,
+            RdataNameAttributes attributes, AbstractMessageRenderer* composer)
 {
-    size_t name_dlen;
-    const uint8_t* name_data = name_labels.getData(&name_dlen);
-    buffer->writeData(name_data, name_dlen);
-    *total_len += name_labels.getSerializedLength();
+    composer->writeName(name_labels,
+                        (attributes & NAMEATTR_COMPRESSIBLE) != 0);
 }
 
 void
-decodeData(const void* data, size_t data_len, util::OutputBuffer* buffer,
-           size_t* total_len)
+composeData(const void* data, size_t data_len,
+            AbstractMessageRenderer* composer)
 {
-    buffer->writeData(data, data_len);
-    *total_len += data_len;
+    composer->writeData(data, data_len);
 }
 }
 
@@ -489,56 +802,34 @@ RdataEncoder::start(RRClass rrclass, RRType rrtype, const void* old_data,
 {
     impl_->start(rrclass, rrtype);
 
-    // Identify start points of various fields of the encoded data and
-    // remember it in class variables.
-    const uint8_t* cp = static_cast<const uint8_t*>(old_data);
-    impl_->old_varlen_count_ =
-        impl_->encode_spec_->varlen_count * old_rdata_count;
-    if (impl_->old_varlen_count_ > 0 || old_sig_count > 0) {
-        impl_->old_length_fields_ = cp;
-        cp += (impl_->old_varlen_count_ + old_sig_count) * sizeof(uint16_t);
-    }
-    impl_->old_data_ = cp;
-    impl_->old_sig_count_ = old_sig_count;
-
-    // Re-construct RDATAs and RRSIGs in the form of Rdata objects, and
-    // keep them in rdatas_ and rrsigs_ so we can detect and ignore duplicate
-    // data with the existing one later.  We'll also figure out the lengths
-    // of the RDATA and RRSIG part of the data by iterating over the data
-    // fields.  Note that the given old_data shouldn't contain duplicate
-    // Rdata or RRSIG as they should have been generated by this own class,
-    // which ensures that condition; if this assumption doesn't hold, we throw.
-    size_t total_len = 0;
+    // Encode the old RDATAs and RRSIGs again as if they were added first in
+    // this session, field by field.  With a name dictionary, the old data
+    // may contain references relative to their own location, so they
+    // can't be copied as they are.  The given old_data shouldn't contain
+    // duplicate RDATA or RRSIG as they should have been generated by this
+    // own class, which ensures that condition; if this assumption doesn't
+    // hold, we throw.
     RdataReader reader(rrclass, rrtype, old_data, old_rdata_count,
                        old_sig_count,
-                       boost::bind(decodeName, _1, _2, &impl_->olddata_buffer_,
-                                   &total_len),
-                       boost::bind(decodeData, _1, _2, &impl_->olddata_buffer_,
-                                   &total_len));
+                       boost::bind(composeName, _1, _2,
+                                   &impl_->field_composer_),
+                       boost::bind(composeData, _1, _2,
+                                   &impl_->field_composer_));
+    impl_->field_composer_.startRdata();
     while (reader.iterateRdata()) {
-        util::InputBuffer ibuffer(impl_->olddata_buffer_.getData(),
-                                  impl_->olddata_buffer_.getLength());
-        if (!impl_->rdatas_.insert(
-                createRdata(rrtype, rrclass, ibuffer,
-                            impl_->olddata_buffer_.getLength())).second) {
+        impl_->field_composer_.endRdata();
+        if (!impl_->commitRdata()) {
             isc_throw(Unexpected, "duplicate RDATA found in merging RdataSet");
         }
-        impl_->olddata_buffer_.clear();
+        impl_->field_composer_.startRdata();
     }
-    impl_->old_data_len_ = total_len;
 
-    total_len = 0;
-    while (reader.iterateSingleSig()) {
-        util::InputBuffer ibuffer(impl_->olddata_buffer_.getData(),
-                                  impl_->olddata_buffer_.getLength());
-        if (!impl_->rrsigs_.insert(
-                createRdata(RRType::RRSIG(), rrclass, ibuffer,
-                            impl_->olddata_buffer_.getLength())).second) {
-            isc_throw(Unexpected, "duplicate RRSIG found in merging RdataSet");
-        }
-        impl_->olddata_buffer_.clear();
+    RdataReader sig_reader(rrclass, rrtype, old_data, old_rdata_count,
+                           old_sig_count, &RdataReader::emptyNameAction,
+                           boost::bind(&RdataEncoderImpl::addOldSIGData,
+                                       impl_, _1, _2));
+    while (sig_reader.iterateSingleSig()) {
     }
-    impl_->old_sig_len_ = total_len;
 }
 
 bool
@@ -548,20 +839,11 @@ RdataEncoder::addRdata(const Rdata& rdata) {
                   "RdataEncoder::addRdata performed before start");
     }
 
-    // Simply ignore duplicate RDATA.  Creating RdataPtr also checks the
-    // given Rdata is of the correct RR type.
-    ConstRdataPtr rdatap = createRdata(*impl_->current_type_,
-                                       *impl_->current_class_, rdata);
-    if (impl_->rdatas_.find(rdatap) != impl_->rdatas_.end()) {
-        return (false);
-    }
-
-    impl_->field_composer_.startRdata();
-    rdata.toWire(impl_->field_composer_);
-    impl_->field_composer_.endRdata();
-    impl_->rdatas_.insert(rdatap);
-
-    return (true);
+    // Check the given Rdata is of the correct RR type, then encode it
+    // (and simply ignore it if it's a duplicate).
+    impl_->checkRdataType(rdata, *impl_->current_type_, impl_->rdata_type_);
+    impl_->addRdataInternal(rdata);
+    return (impl_->commitRdata());
 }
 
 bool
@@ -571,24 +853,63 @@ RdataEncoder::addSIGRdata(const Rdata& sig_rdata) {
                   "RdataEncoder::addSIGRdata performed before start");
     }
 
-    // Ignore duplicate RRSIGs
-    ConstRdataPtr rdatap = createRdata(RRType::RRSIG(), *impl_->current_class_,
-                                       sig_rdata);
-    if (impl_->rrsigs_.find(rdatap) != impl_->rrsigs_.end()) {
-        return (false);
+    // Likewise, for RRSIG.
+    impl_->checkRdataType(sig_rdata, RRType::RRSIG(), impl_->sig_type_);
+    const size_t pos = impl_->rrsig_buffer_.getLength();
+    sig_rdata.toWire(impl_->rrsig_buffer_);
+    return (impl_->commitSIG(pos));
+}
+
+bool
+RdataEncoder::addWireRdata(const void* data, size_t data_len) {
+    if (impl_->encode_spec_ == NULL) {
+        isc_throw(InvalidOperation,
+                  "RdataEncoder::addWireRdata performed before start");
     }
 
-    const size_t cur_pos = impl_->rrsig_buffer_.getLength();
-    sig_rdata.toWire(impl_->rrsig_buffer_);
-    const size_t rrsig_datalen = impl_->rrsig_buffer_.getLength() - cur_pos;
-    if (rrsig_datalen > 0xffff) {
-        isc_throw(RdataEncodingError, "RRSIG is too large: "
-                  << rrsig_datalen << " bytes");
+    impl_->addWireRdataInternal(static_cast<const uint8_t*>(data), data_len);
+    return (impl_->commitRdata());
+}
+
+bool
+RdataEncoder::addWireSIGRdata(const void* data, size_t data_len) {
+    if (impl_->encode_spec_ == NULL) {
+        isc_throw(InvalidOperation,
+                  "RdataEncoder::addWireSIGRdata performed before start");
     }
-    impl_->rrsigs_.insert(rdatap);
-    impl_->rrsig_lengths_.push_back(rrsig_datalen);
 
-    return (true);
+    const size_t pos = impl_->rrsig_buffer_.getLength();
+    impl_->rrsig_buffer_.writeData(data, data_len);
+    return (impl_->commitSIG(pos));
+}
+
+void
+RdataEncoder::internNames(util::MemorySegment& mem_sgmt) {
+    if (impl_->encode_spec_ == NULL) {
+        isc_throw(InvalidOperation,
+                  "RdataEncoder::internNames performed before start");
+    }
+    if (impl_->dictionary_ == NULL) {
+        return;
+    }
+
+    const vector<std::pair<size_t, size_t> >& name_fields =
+        impl_->field_composer_.name_fields_;
+    const uint8_t* const data =
+        static_cast<const uint8_t*>(impl_->field_composer_.getData());
+    impl_->name_refs_.assign(name_fields.size(), NULL);
+    try {
+        for (size_t i = 0; i < name_fields.size(); ++i) {
+            if (name_fields[i].second > NAME_REF_LENGTH) {
+                impl_->name_refs_[i] = impl_->dictionary_->add(
+                    mem_sgmt, LabelSequence(data + name_fields[i].first));
+            }
+        }
+    } catch (...) {
+        // The names found so far may have been relocated.
+        impl_->name_refs_.clear();
+        throw;
+    }
 }
 
 size_t
@@ -598,13 +919,19 @@ RdataEncoder::getStorageLength() const {
                   "RdataEncoder::getStorageLength performed before start");
     }
 
-    return (sizeof(uint16_t) * (impl_->old_varlen_count_ +
-                                impl_->old_sig_count_ +
-                                impl_->field_composer_.data_lengths_.size() +
+    // Names encoded as references save the difference of the lengths.
+    size_t saved_len = 0;
+    for (size_t i = 0; i < impl_->name_refs_.size(); ++i) {
+        if (impl_->name_refs_[i] != NULL) {
+            saved_len += impl_->field_composer_.name_fields_[i].second -
+                NAME_REF_LENGTH;
+        }
+    }
+
+    return (sizeof(uint16_t) * (impl_->field_composer_.data_lengths_.size() +
                                 impl_->rrsig_lengths_.size()) +
-            impl_->old_data_len_ + impl_->old_sig_len_ +
             impl_->rrsig_buffer_.getLength() +
-            impl_->field_composer_.getLength());
+            impl_->field_composer_.getLength() - saved_len);
 }
 
 void
@@ -625,12 +952,6 @@ RdataEncoder::encode(void* buf, size_t buf_len) const {
     uint8_t* dp = dp_beg;
     uint16_t* lenp = reinterpret_cast<uint16_t*>(buf);
 
-    // Encode list of lengths for variable length fields for old data (if any)
-    const size_t old_varlen_fields_len =
-        impl_->old_varlen_count_ * sizeof(uint16_t);
-    std::memcpy(lenp, impl_->old_length_fields_, old_varlen_fields_len);
-    lenp += impl_->old_varlen_count_;
-    dp += old_varlen_fields_len;
     // Encode list of lengths for variable length fields (if any)
     if (!impl_->field_composer_.data_lengths_.empty()) {
         const size_t varlen_fields_len =
@@ -640,12 +961,6 @@ RdataEncoder::encode(void* buf, size_t buf_len) const {
         lenp += impl_->field_composer_.data_lengths_.size();
         dp += varlen_fields_len;
     }
-    // Encode list of lengths for old RRSIGs (if any)
-    const size_t old_rrsigs_len = impl_->old_sig_count_ * sizeof(uint16_t);
-    std::memcpy(lenp, static_cast<const uint8_t*>(impl_->old_length_fields_) +
-                old_varlen_fields_len, old_rrsigs_len);
-    lenp += impl_->old_sig_count_;
-    dp += old_rrsigs_len;
     // Encode list of lengths for RRSIGs (if any)
     if (!impl_->rrsig_lengths_.empty()) {
         const size_t rrsigs_len =
@@ -653,17 +968,28 @@ RdataEncoder::encode(void* buf, size_t buf_len) const {
         std::memcpy(lenp, &impl_->rrsig_lengths_[0], rrsigs_len);
         dp += rrsigs_len;
     }
-    // Encode main old RDATA, if any
-    std::memcpy(dp, impl_->old_data_, impl_->old_data_len_);
-    dp += impl_->old_data_len_;
-    // Encode main RDATA
-    std::memcpy(dp, impl_->field_composer_.getData(),
-                impl_->field_composer_.getLength());
-    dp += impl_->field_composer_.getLength();
-    // Encode old RRSIGs, if any
-    std::memcpy(dp, static_cast<const uint8_t*>(impl_->old_data_) +
-                impl_->old_data_len_, impl_->old_sig_len_);
-    dp += impl_->old_sig_len_;
+    // Encode main RDATA, replacing names in the dictionary with references
+    const uint8_t* const composed_data =
+        static_cast<const uint8_t*>(impl_->field_composer_.getData());
+    size_t composed_pos = 0;
+    for (size_t i = 0; i < impl_->name_refs_.size(); ++i) {
+        if (impl_->name_refs_[i] == NULL) {
+            continue;
+        }
+        const std::pair<size_t, size_t>& name_field =
+            impl_->field_composer_.name_fields_[i];
+        std::memcpy(dp, composed_data + composed_pos,
+                    name_field.first - composed_pos);
+        dp += name_field.first - composed_pos;
+        const int64_t offset = impl_->name_refs_[i] - dp;
+        *dp = NAME_REF_TAG;
+        std::memcpy(dp + 1, &offset, sizeof(offset));
+        dp += NAME_REF_LENGTH;
+        composed_pos = name_field.first + name_field.second;
+    }
+    std::memcpy(dp, composed_data + composed_pos,
+                impl_->field_composer_.getLength() - composed_pos);
+    dp += impl_->field_composer_.getLength() - composed_pos;
     // Encode RRSIGs, if any
     std::memcpy(dp, impl_->rrsig_buffer_.getData(),
                 impl_->rrsig_buffer_.getLength());
@@ -711,8 +1037,10 @@ RdataReader::nextInternal(const NameAction& name_action,
         const RdataFieldSpec& spec(spec_.fields[(spec_pos_++) %
                                                 spec_.field_count]);
         if (spec.type == RdataFieldSpec::DOMAIN_NAME) {
-            const LabelSequence sequence(data_ + data_pos_);
-            data_pos_ += sequence.getSerializedLength();
+            size_t field_len;
+            const LabelSequence sequence(getNameFieldData(data_ + data_pos_,
+                                                          &field_len));
+            data_pos_ += field_len;
             name_action(sequence, spec.name_attributes);
         } else {
             const size_t length(spec.type == RdataFieldSpec::FIXEDLEN_DATA ?
@@ -788,10 +1116,10 @@ RdataReader::getSize() const {
         const RdataFieldSpec& spec =
             spec_.fields[spec_pos % spec_.field_count];
         if (spec.type == RdataFieldSpec::DOMAIN_NAME) {
-            const size_t seq_len =
-                LabelSequence(data_ + data_pos).getSerializedLength();
-            data_pos += seq_len;
-            storage_size += seq_len;
+            size_t field_len;
+            getNameFieldData(data_ + data_pos, &field_len);
+            data_pos += field_len;
+            storage_size += field_len;
         } else {
             const size_t data_len =
                 (spec.type == RdataFieldSpec::FIXEDLEN_DATA ?
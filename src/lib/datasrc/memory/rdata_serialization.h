@@ -34,7 +34,8 @@
 /// The entire set of RDATA is stored in a packed form in a contiguous
 /// memory region.  It's opaque data, without containing non trivial
 /// data structures, so it can be located anywhere in the memory or even
-/// dumped to a file.
+/// dumped to a file (unless domain names are encoded as references to
+/// shared names; see \c isc::datasrc::memory::RdataEncoder).
 ///
 /// Two main classes are provided: one is
 /// \c isc::datasrc::memory::RdataEncoder, which allows
@@ -72,6 +73,9 @@
 //            fixed-length).
 // or
 // opaque data, LabelSequence::getSerializedLength() bytes: data for a name
+// or
+// uint8_t 0xff, int64_t offset: reference to the data for a name stored
+//                               elsewhere (see setNameDictionary())
 // uint8_t[ns1]: 1st RRSIG data
 // ...
 // uint8_t[nsL]: last RRSIG data
@@ -89,8 +93,13 @@
 /// make it faster in rendering it into a DNS message.
 
 namespace isc {
+namespace util {
+class MemorySegment;
+}
+
 namespace datasrc {
 namespace memory {
+class NameDictionary;
 
 /// \brief General error in RDATA encoding.
 ///
@@ -133,6 +142,13 @@ public:
 ///
 /// The caller can reuse the \c RdataEncoder object for another set of RDATA
 /// by repeating the session from \c start().
+///
+/// Optionally, domain name fields can be encoded as references to names
+/// shared in a \c NameDictionary instead of copies of the names (see
+/// \c setNameDictionary() and \c internNames()).  Such encoded data are
+/// smaller, but they depend on the dictionary and on their own location in
+/// memory: they must not be copied as opaque data (e.g., with memcpy()) or
+/// outlive the dictionary.
 class RdataEncoder : boost::noncopyable {
 public:
     /// \brief Default constructor.
@@ -141,6 +157,22 @@ public:
     /// \brief The destrcutor.
     ~RdataEncoder();
 
+    /// \brief Set the dictionary of shared names used for encoding.
+    ///
+    /// If \c dictionary is non-NULL, \c internNames() adds the names of
+    /// the RDATA to it, and \c encode() encodes them as references to the
+    /// names in the dictionary.  A NULL \c dictionary (the default) disables
+    /// this, and all names are encoded inline.
+    ///
+    /// The setting is kept across encoding sessions.  The dictionary must
+    /// be set to the one referred to by the old data when \c start() is
+    /// called in the merge mode, if the old data were encoded with one.
+    ///
+    /// \throw none
+    ///
+    /// \param dictionary The dictionary, or NULL.
+    void setNameDictionary(NameDictionary* dictionary);
+
     /// \brief Start the encoding session.
     ///
     /// It re-initializes the internal encoder state for a new encoding
@@ -214,6 +246,8 @@ public:
     /// The check is based on the comparison in the "canonical form" as
     /// described in RFC4034 Section 6.2.  In particular, domain name fields
     /// of the RDATA are generally compared in case-insensitive manner.
+    /// It's done on the encoded data, so no copy of \c rdata is made
+    /// (except for the first Rdata of its C++ class to check its type).
     ///
     /// The caller can destroy \c rdata after this call is completed.
     ///
@@ -278,6 +312,65 @@ public:
     /// it's a duplicate and ignored.
     bool addSIGRdata(const dns::rdata::Rdata& sig_rdata);
 
+    /// \brief Add an RDATA in the wire format for encoding.
+    ///
+    /// This is the same as \c addRdata() except that it takes the RDATA in
+    /// the wire format, such as those of \c dns::WireRRset.  The data must
+    /// be of the RR type and class of the session, and must not contain
+    /// compressed names.  Since the data are split into the fields for the
+    /// encoding based on the type, only the data of types whose variable
+    /// length field (if any) is the last field can be encoded this way;
+    /// this is the case of all types \c dns::rdata::createWireRdata()
+    /// supports.
+    ///
+    /// \throw InvalidOperation called before start().
+    /// \throw BadValue The data are broken for the type, or can't be
+    /// encoded from the wire format.
+    /// \throw RdataEncodingError A very unusual case, such as over 64KB RDATA.
+    /// \throw std::bad_alloc Internal memory allocation failure.
+    ///
+    /// \param data The wire-format RDATA to be encoded in the session.
+    /// \param data_len The length of \c data in bytes.
+    /// \return true if the given RDATA was added to encode; false if
+    /// it's a duplicate and ignored.
+    bool addWireRdata(const void* data, size_t data_len);
+
+    /// \brief Add an RRSIG RDATA in the wire format for encoding.
+    ///
+    /// This is the same as \c addSIGRdata() except that it takes the RRSIG
+    /// RDATA in the wire format.
+    ///
+    /// \throw InvalidOperation called before start().
+    /// \throw RdataEncodingError A very unusual case, such as over 64KB RDATA.
+    /// \throw std::bad_alloc Internal memory allocation failure.
+    ///
+    /// \param data The wire-format RRSIG RDATA to be encoded in the session.
+    /// \param data_len The length of \c data in bytes.
+    /// \return true if the given RRSIG RDATA was added to encode; false if
+    /// it's a duplicate and ignored.
+    bool addWireSIGRdata(const void* data, size_t data_len);
+
+    /// \brief Add the names of the session to the dictionary.
+    ///
+    /// Each domain name field of the RDATA added so far that would be
+    /// larger than a reference is added to the dictionary set by
+    /// \c setNameDictionary(), and will be encoded as a reference by the
+    /// subsequent \c getStorageLength() and \c encode().  Names of RDATA
+    /// added after this call are encoded inline.  If no dictionary is set,
+    /// this method does nothing.
+    ///
+    /// The names referred to by the encoded data are located when this
+    /// method is called; if the memory segment is relocated by then
+    /// (i.e., \c util::MemorySegmentGrown is thrown for any allocation)
+    /// the session must be restarted from \c start().
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt The \c MemorySegment of the dictionary.
+    void internNames(util::MemorySegment& mem_sgmt);
+
     /// \brief Return the length of space for encoding for the session.
     ///
     /// It returns the size of the encoded data that would be generated for
@@ -63,3 +63,28 @@ struct RdataEncodeSpec {
 /// \brief Get the spec for given class and type
 const RdataEncodeSpec&
 getRdataEncodeSpec(const RRClass& rrclass, const RRType& rrtype);
+
+/// A domain name field is stored inline as a serialized \c LabelSequence,
+/// or, if the encoder has a \c NameDictionary, possibly as a reference to
+/// a name in it: \c NAME_REF_TAG followed by the offset (int64_t in the host
+/// byte order, unaligned) from the tag to the serialized name.  The tag
+/// can't be the first byte of a serialized \c LabelSequence, which is the
+/// number of labels.
+const uint8_t NAME_REF_TAG = 0xff;
+const size_t NAME_REF_LENGTH = 1 + sizeof(int64_t);
+
+/// \brief Return the serialized \c LabelSequence of a name field
+///
+/// \param field The beginning of the name field in encoded data.
+/// \param field_len Set to the length of the field.
+inline const uint8_t*
+getNameFieldData(const uint8_t* field, size_t* field_len) {
+    if (*field == NAME_REF_TAG) {
+        int64_t offset;
+        std::memcpy(&offset, field + 1, sizeof(offset));
+        *field_len = NAME_REF_LENGTH;
+        return (field + offset);
+    }
+    *field_len = LabelSequence(field).getSerializedLength();
+    return (field);
+}
@@ -14,6 +14,7 @@
 
 #include "rdataset.h"
 #include "rdata_serialization.h"
+#include "util_internal.h"
 
 #include <exceptions/exceptions.h>
 
@@ -22,6 +23,7 @@
 #include <dns/rrclass.h>
 #include <dns/rrtype.h>
 #include <dns/rrset.h>
+#include <dns/wire_rrset.h>
 #include <util/buffer.h>
 
 #include <boost/static_assert.hpp>
@@ -105,8 +107,11 @@ sanityChecks(const ConstRRsetPtr& rrset, const ConstRRsetPtr &sig_rrset,
     }
 
     const RRClass rrclass = rrset ? rrset->getClass() : sig_rrset->getClass();
+    const WireRRset* wire_sig_rrset =
+        dynamic_cast<const WireRRset*>(sig_rrset.get());
     const RRType rrtype = rrset ? rrset->getType() :
-        getCoveredType(sig_rrset->getRdataIterator()->getCurrent());
+        (wire_sig_rrset ? detail::getCoveredType(*wire_sig_rrset, 0) :
+         getCoveredType(sig_rrset->getRdataIterator()->getCurrent()));
 
     if (old_rdataset && old_rdataset->type != rrtype) {
         isc_throw(BadValue, "RR type doesn't match between RdataSets");
@@ -124,6 +129,7 @@ RdataSet::packSet(util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
 {
     const size_t ext_rrsig_count_len =
         rrsig_count >= MANY_RRSIG_COUNT ? sizeof(uint16_t) : 0;
+    encoder.internNames(mem_sgmt);
     const size_t data_len = encoder.getStorageLength();
     void* p = mem_sgmt.allocate(sizeof(RdataSet) + ext_rrsig_count_len +
                                 data_len);
@@ -157,7 +163,16 @@ RdataSet::create(util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
 
     // Store RDATAs to be added and check assumptions on the number of them
     size_t rdata_count = old_rdataset ? old_rdataset->getRdataCount() : 0;
-    if (rrset) {
+    // RDATA of a WireRRset are encoded directly from the wire format.
+    const WireRRset* wire_rrset = dynamic_cast<const WireRRset*>(rrset.get());
+    if (wire_rrset) {
+        for (size_t i = 0; i < wire_rrset->getRdataCount(); ++i) {
+            if (encoder.addWireRdata(wire_rrset->getWireRdata(i),
+                                     wire_rrset->getWireRdataLength(i))) {
+                ++rdata_count;
+            }
+        }
+    } else if (rrset) {
         for (RdataIteratorPtr it = rrset->getRdataIterator();
              !it->isLast();
              it->next()) {
@@ -174,7 +189,20 @@ RdataSet::create(util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
 
     // Same for RRSIG
     size_t rrsig_count = old_rdataset ? old_rdataset->getSigRdataCount() : 0;
-    if (sig_rrset) {
+    const WireRRset* wire_sig_rrset =
+        dynamic_cast<const WireRRset*>(sig_rrset.get());
+    if (wire_sig_rrset) {
+        for (size_t i = 0; i < wire_sig_rrset->getRdataCount(); ++i) {
+            if (detail::getCoveredType(*wire_sig_rrset, i) != rrtype) {
+                isc_throw(BadValue, "Type covered doesn't match");
+            }
+            if (encoder.addWireSIGRdata(
+                    wire_sig_rrset->getWireRdata(i),
+                    wire_sig_rrset->getWireRdataLength(i))) {
+                ++rrsig_count;
+            }
+        }
+    } else if (sig_rrset) {
         for (RdataIteratorPtr it = sig_rrset->getRdataIterator();
              !it->isLast();
              it->next())
@@ -288,21 +316,74 @@ RdataSet::subtract(util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
                     restoreTTL(old_rdataset.getTTLData())));
 }
 
+namespace {
+void
+findName(const LabelSequence&, RdataNameAttributes, bool* found) {
+    *found = true;
+}
+}
+
+RdataSet*
+RdataSet::copy(util::MemorySegment& mem_sgmt, const RRClass& rrclass,
+               const RdataSet& source, RdataEncoder* encoder)
+{
+    if (encoder != NULL) {
+        bool has_name = false;
+        RdataReader reader(rrclass, source.type, source.getDataBuf(),
+                           source.getRdataCount(), source.getSigRdataCount(),
+                           boost::bind(findName, _1, _2, &has_name),
+                           &RdataReader::emptyDataAction);
+        while (!has_name && reader.iterateRdata()) {}
+        if (has_name) {
+            encoder->start(rrclass, source.type, source.getDataBuf(),
+                           source.getRdataCount(), source.getSigRdataCount());
+            return (packSet(mem_sgmt, *encoder, source.getRdataCount(),
+                            source.getSigRdataCount(), source.type,
+                            restoreTTL(source.getTTLData())));
+        }
+    }
+
+    const size_t data_len =
+        RdataReader(rrclass, source.type,
+                    reinterpret_cast<const uint8_t*>(source.getDataBuf()),
+                    source.getRdataCount(), source.getSigRdataCount(),
+                    &RdataReader::emptyNameAction,
+                    &RdataReader::emptyDataAction).getSize();
+    const size_t rrsig_count = source.getSigRdataCount();
+    const size_t ext_rrsig_count_len =
+        rrsig_count >= MANY_RRSIG_COUNT ? sizeof(uint16_t) : 0;
+    void* p = mem_sgmt.allocate(sizeof(RdataSet) + ext_rrsig_count_len +
+                                data_len);
+    RdataSet* rdataset = new(p) RdataSet(source.type,
+                                         source.getRdataCount(), rrsig_count,
+                                         restoreTTL(source.getTTLData()));
+    if (rrsig_count >= MANY_RRSIG_COUNT) {
+        *rdataset->getExtSIGCountBuf() = rrsig_count;
+    }
+    std::memcpy(rdataset->getDataBuf(), source.getDataBuf(), data_len);
+    return (rdataset);
+}
+
 void
 RdataSet::destroy(util::MemorySegment& mem_sgmt, RdataSet* rdataset,
                   RRClass rrclass)
 {
+    const size_t alloc_len = rdataset->getMemorySize(rrclass);
+    rdataset->~RdataSet();
+    mem_sgmt.deallocate(rdataset, alloc_len);
+}
+
+size_t
+RdataSet::getMemorySize(RRClass rrclass) const {
     const size_t data_len =
-        RdataReader(rrclass, rdataset->type,
-                    reinterpret_cast<const uint8_t*>(rdataset->getDataBuf()),
-                    rdataset->getRdataCount(), rdataset->getSigRdataCount(),
+        RdataReader(rrclass, type,
+                    reinterpret_cast<const uint8_t*>(getDataBuf()),
+                    getRdataCount(), getSigRdataCount(),
                     &RdataReader::emptyNameAction,
                     &RdataReader::emptyDataAction).getSize();
     const size_t ext_rrsig_count_len =
-        rdataset->sig_rdata_count_ == MANY_RRSIG_COUNT ? sizeof(uint16_t) : 0;
-    rdataset->~RdataSet();
-    mem_sgmt.deallocate(rdataset,
-                        sizeof(RdataSet) + ext_rrsig_count_len + data_len);
+        sig_rdata_count_ == MANY_RRSIG_COUNT ? sizeof(uint16_t) : 0;
+    return (sizeof(RdataSet) + ext_rrsig_count_len + data_len);
 }
 
 namespace {
@@ -254,6 +254,38 @@ public:
                               const dns::ConstRRsetPtr& sig_rrset,
                               const RdataSet& old_rdataset);
 
+    /// \brief Allocate and construct a copy of an existing \c RdataSet
+    ///
+    /// The new \c RdataSet has the same RR type, TTL, RDATAs and RRSIGs
+    /// as \c source.  As the encoded data are simply copied, this is much
+    /// cheaper than creating the same \c RdataSet from RRsets with
+    /// \c create().  The \c next pointer of the copy is NULL.
+    ///
+    /// If \c encoder is given, RDATAs that contain domain names are
+    /// encoded again with it instead, using its name dictionary (see
+    /// \c RdataEncoder::setNameDictionary()) if any.  This is necessary if
+    /// \c source refers to names in a dictionary, as such encoded data can't
+    /// be simply copied.
+    ///
+    /// Like \c create(), the given \c rrclass must be the RR class of the
+    /// \c source.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data (including \c source if it's in the same segment).
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt A \c MemorySegment from which memory for the new
+    /// \c RdataSet is allocated.
+    /// \param rrclass The RR class of the \c source.
+    /// \param source The \c RdataSet to be copied.
+    /// \param encoder If non-NULL, the encoder to encode the copy with.
+    ///
+    /// \return A pointer to the created \c RdataSet.
+    static RdataSet* copy(util::MemorySegment& mem_sgmt,
+                          const dns::RRClass& rrclass,
+                          const RdataSet& source,
+                          RdataEncoder* encoder = NULL);
+
     /// \brief Destruct and deallocate \c RdataSet
     ///
     /// Note that this method needs to know the expected RR class of the
@@ -402,6 +434,17 @@ public:
     /// \throw none
     const void* getTTLData() const { return (&ttl_); }
 
+    /// \brief Return the size of memory allocated for the \c RdataSet.
+    ///
+    /// This includes the encoded RDATAs, but not names they refer to in
+    /// a name dictionary.  Like \c destroy(), it needs the RR class of the
+    /// \c RdataSet.
+    ///
+    /// \throw none
+    ///
+    /// \param rrclass The RR class of the \c RdataSet.
+    size_t getMemorySize(dns::RRClass rrclass) const;
+
     /// \brief Accessor to the memory region for encoded RDATAs.
     ///
     /// The only valid usage of the returned pointer is to pass it to
@@ -159,15 +159,15 @@ getLengthHelper(size_t* rlength, size_t rr_count, uint16_t name_labels_size,
 // Common code logic for rendering a single (either main or RRSIG) RRset.
 size_t
 writeRRs(AbstractMessageRenderer& renderer, size_t rr_count,
-         const LabelSequence& name_labels, const RRType& rrtype,
-         const RRClass& rrclass, const void* ttl_data,
+         const LabelSequence& name_labels, const size_t* name_hashes,
+         const RRType& rrtype, const RRClass& rrclass, const void* ttl_data,
          RdataReader& reader, bool (RdataReader::* rdata_iterate_fn)())
 {
     for (size_t i = 0; i < rr_count; ++i) {
         const size_t pos0 = renderer.getLength();
 
         // Name, type, class, TTL
-        renderer.writeName(name_labels, true);
+        renderer.writeHashedName(name_labels, name_hashes, true);
         rrtype.toWire(renderer);
         rrclass.toWire(renderer);
         renderer.writeData(ttl_data, sizeof(uint32_t));
@@ -235,10 +235,15 @@ TreeNodeRRset::toWire(AbstractMessageRenderer& renderer) const {
     uint8_t labels_buf[LabelSequence::MAX_SERIALIZED_LENGTH];
     const LabelSequence name_labels = getOwnerLabels(labels_buf);
 
+    // The owner name is rendered for every RR, so we calculate the hash
+    // values for name compression only once.
+    size_t name_hashes[Name::MAX_LABELS];
+    AbstractMessageRenderer::computeNameHashes(name_labels, name_hashes);
+
     // Render the main (non RRSIG) RRs
     const size_t rendered_rdata_count =
         writeRRs(renderer, rdataset_->getRdataCount(), name_labels,
-                 rdataset_->type, rrclass_, ttl_data_, reader,
+                 name_hashes, rdataset_->type, rrclass_, ttl_data_, reader,
                  &RdataReader::iterateRdata);
     if (renderer.isTruncated()) {
         return (rendered_rdata_count);
@@ -248,8 +253,8 @@ TreeNodeRRset::toWire(AbstractMessageRenderer& renderer) const {
 
     // Render any RRSIGs, if we supposed to do so
     const size_t rendered_rrsig_count = dnssec_ok_ ?
-        writeRRs(renderer, rrsig_count_, name_labels, RRType::RRSIG(),
-                 rrclass_, ttl_data_, reader,
+        writeRRs(renderer, rrsig_count_, name_labels, name_hashes,
+                 RRType::RRSIG(), rrclass_, ttl_data_, reader,
                  &RdataReader::iterateSingleSig) : 0;
 
     return (rendered_rdata_count + rendered_rrsig_count);
@@ -18,12 +18,32 @@
 #include <dns/rdataclass.h>
 #include <dns/rrset.h>
 #include <dns/rrtype.h>
+#include <dns/wire_rrset.h>
+
+#include <exceptions/exceptions.h>
+
+#include <stdint.h>
 
 namespace isc {
 namespace datasrc {
 namespace memory {
 namespace detail {
 
+/// \brief Return the covered RR type of an RRSIG RDATA in a WireRRset.
+///
+/// The type covered is the first field of the wire-format RRSIG RDATA.
+///
+/// \throw isc::BadValue The RDATA is too short to contain the field.
+inline dns::RRType
+getCoveredType(const dns::WireRRset& sig_rrset, size_t i) {
+    if (sig_rrset.getWireRdataLength(i) < sizeof(uint16_t)) {
+        isc_throw(isc::BadValue, "RRSIG RDATA is too short, name: "
+                  << sig_rrset.getName());
+    }
+    const uint8_t* const dp = sig_rrset.getWireRdata(i);
+    return (dns::RRType((dp[0] << 8) | dp[1]));
+}
+
 /// \brief Return the covered RR type of an RRSIG RRset.
 ///
 /// This is a commonly used helper to extract the type covered field of an
@@ -33,14 +53,22 @@ namespace detail {
 /// it comes from a master file or another data source iterator, but it could
 /// still happen in some buggy situations.  This function catches and rejects
 /// such cases.
+///
+/// If \c sig_rrset is a \c dns::WireRRset, the type is taken from the
+/// wire-format data.
 inline dns::RRType
 getCoveredType(const dns::ConstRRsetPtr& sig_rrset) {
-    dns::RdataIteratorPtr it = sig_rrset->getRdataIterator();
-    if (it->isLast()) {
+    if (sig_rrset->getRdataCount() == 0) {
         isc_throw(isc::Unexpected,
                   "Empty RRset is passed in-memory loader, name: "
                   << sig_rrset->getName());
     }
+    const dns::WireRRset* wire_rrset =
+        dynamic_cast<const dns::WireRRset*>(sig_rrset.get());
+    if (wire_rrset != NULL) {
+        return (getCoveredType(*wire_rrset, 0));
+    }
+    dns::RdataIteratorPtr it = sig_rrset->getRdataIterator();
     return (dynamic_cast<const dns::rdata::generic::RRSIG&>(it->getCurrent()).
             typeCovered());
 }
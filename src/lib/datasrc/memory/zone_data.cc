@@ -13,13 +13,17 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <util/memory_segment.h>
+#include <util/buffer.h>
 
 #include <dns/name.h>
+#include <dns/name_internal.h>
+#include <dns/labelsequence.h>
 #include <dns/rrclass.h>
 #include <dns/rdataclass.h>
 
 #include "rdataset.h"
 #include "rdata_serialization.h"
+#include "name_dictionary.h"
 #include "zone_data.h"
 #include "segment_object_holder.h"
 
@@ -61,6 +65,67 @@ void
 nullDeleter(RdataSet* rdataset_head) {
     assert(rdataset_head == NULL);
 }
+
+// The node flags copied by ZoneData::copy() and NSEC3Data::copy(); all
+// that can be set by the application.
+const ZoneNode::Flags copied_flags[] = {
+    ZoneNode::FLAG_CALLBACK, ZoneNode::FLAG_USER1, ZoneNode::FLAG_USER2,
+    ZoneNode::FLAG_USER3
+};
+
+// Return the absolute name of a node as a Name object.
+Name
+getAbsoluteName(const ZoneNode& node) {
+    uint8_t buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    size_t data_len;
+    const uint8_t* data = node.getAbsoluteLabels(buf).getData(&data_len);
+    util::InputBuffer buffer(data, data_len);
+    return (Name(buffer));
+}
+
+// A helper for ZoneData::copy() and NSEC3Data::copy(): insert all names of
+// the source tree (from the zone origin) into the target, which is either
+// ZoneData or NSEC3Data, and copy their node flags and RdataSets (encoding
+// them again with the encoder if given).  The RdataSets are linked into
+// the target tree as soon as they are created, so they are released with
+// the target on exception.
+template <typename TargetType>
+void
+copyNames(util::MemorySegment& mem_sgmt, RRClass rrclass,
+          const ZoneTree& source_tree, const Name& zone_origin,
+          TargetType& target, RdataEncoder* encoder)
+{
+    ZoneChain node_path;
+    const ZoneNode* node = NULL;
+    source_tree.find<void*>(LabelSequence(zone_origin), &node, node_path,
+                            NULL, NULL);
+    assert(node != NULL);
+    for (; node != NULL; node = source_tree.nextNode(node_path)) {
+        ZoneNode* target_node = NULL;
+        target.insertName(mem_sgmt, getAbsoluteName(*node), &target_node);
+
+        for (size_t i = 0;
+             i < sizeof(copied_flags) / sizeof(copied_flags[0]);
+             ++i) {
+            target_node->setFlag(copied_flags[i],
+                                 node->getFlag(copied_flags[i]));
+        }
+
+        RdataSet* last = NULL;
+        for (const RdataSet* rdataset = node->getData();
+             rdataset != NULL;
+             rdataset = rdataset->getNext()) {
+            RdataSet* copied = RdataSet::copy(mem_sgmt, rrclass, *rdataset,
+                                              encoder);
+            if (last == NULL) {
+                target_node->setData(copied);
+            } else {
+                last->next = copied;
+            }
+            last = copied;
+        }
+    }
+}
 }
 
 NSEC3Data*
@@ -138,6 +203,37 @@ NSEC3Data::insertName(util::MemorySegment& mem_sgmt, const Name& name,
             result == ZoneTree::ALREADYEXISTS) && node != NULL);
 }
 
+NSEC3Data*
+NSEC3Data::copy(util::MemorySegment& mem_sgmt, RRClass nsec3_class,
+                const Name& zone_origin, const NSEC3Data& source)
+{
+    const std::vector<uint8_t> salt(source.getSaltData(),
+                                    source.getSaltData() +
+                                    source.getSaltLen());
+    detail::SegmentObjectHolder<NSEC3Data, RRClass> holder(mem_sgmt,
+                                                           nsec3_class);
+    holder.set(create(mem_sgmt, zone_origin, source.hashalg, source.flags,
+                      source.iterations, salt));
+    copyNames(mem_sgmt, nsec3_class, source.getNSEC3Tree(), zone_origin,
+              *holder.get(), NULL);
+    return (holder.release());
+}
+
+ZoneNode*
+NSEC3Data::findName(const Name& name) {
+    ZoneNode* node = NULL;
+    if (nsec3_tree_->find(name, &node) != ZoneTree::EXACTMATCH) {
+        return (NULL);
+    }
+    return (node);
+}
+
+void
+NSEC3Data::removeName(util::MemorySegment& mem_sgmt, ZoneNode* node) {
+    assert(node->isEmpty());
+    nsec3_tree_->remove(mem_sgmt, node, nullDeleter);
+}
+
 namespace {
 // A helper to convert a TTL value in network byte order and set it in
 // ZoneData::min_ttl_.  We can use util::OutputBuffer, but copy the logic
@@ -156,6 +252,113 @@ setTTLInNetOrder(uint32_t val, uint32_t* result) {
 }
 }
 
+size_t
+ZoneNameIndex::getSlotCount(size_t max_names) {
+    // Keep the load factor below 1/2 so the probe sequences are short
+    // and there's always a free slot to terminate them.
+    size_t slot_count = 1;
+    while (slot_count <= max_names) {
+        slot_count <<= 1;
+    }
+    return (slot_count << 1);
+}
+
+uint32_t
+ZoneNameIndex::getHash(const LabelSequence& labels) {
+    // 32-bit FNV-1a over the wire format data, with the label characters
+    // converted to lower case.
+    size_t data_len;
+    const uint8_t* data = labels.getData(&data_len);
+    uint32_t hash = 2166136261U;
+    size_t i = 0;
+    while (i < data_len) {
+        const size_t label_len = data[i++];
+        hash = (hash ^ label_len) * 16777619U;
+        for (const size_t end = i + label_len; i < end; ++i) {
+            hash = (hash ^ isc::dns::name::internal::maptolower[data[i]]) *
+                16777619U;
+        }
+    }
+    return (hash);
+}
+
+ZoneNameIndex*
+ZoneNameIndex::create(util::MemorySegment& mem_sgmt, const ZoneTree& zone_tree,
+                      const ZoneNode& origin_node)
+{
+    // The node count of the tree is an upper bound of the number of names
+    // to be indexed.  Allocation is the only thing that can throw.
+    const size_t slot_count = getSlotCount(zone_tree.getNodeCount());
+    void* p = mem_sgmt.allocate(getAllocSize(slot_count));
+    ZoneNameIndex* index = new(p) ZoneNameIndex(slot_count);
+    Entry* entries = index->getEntries();
+    for (size_t i = 0; i < slot_count; ++i) {
+        new(&entries[i]) Entry();
+    }
+
+    // Iterate over the tree starting from the origin, which is the
+    // smallest name of the zone.
+    uint8_t buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    ZoneChain node_path;
+    const ZoneNode* node = NULL;
+    zone_tree.find<void*>(origin_node.getAbsoluteLabels(buf), &node,
+                          node_path, NULL, NULL);
+    assert(node == &origin_node);
+    for (; node != NULL; node = zone_tree.nextNode(node_path)) {
+        if (node->isEmpty()) {
+            continue;
+        }
+        // The tree search stops at (or may skip) the names below a node
+        // with the callback enabled, so we don't index them.
+        bool below_cut = false;
+        for (const ZoneNode* upper = node->getUpperNode();
+             upper != NULL && !below_cut;
+             upper = upper->getUpperNode()) {
+            below_cut = upper->getFlag(ZoneNode::FLAG_CALLBACK);
+        }
+        if (!below_cut) {
+            index->insert(getHash(node->getAbsoluteLabels(buf)), node);
+        }
+    }
+
+    return (index);
+}
+
+void
+ZoneNameIndex::destroy(util::MemorySegment& mem_sgmt, ZoneNameIndex* index) {
+    const size_t slot_count = index->slot_count_;
+    index->~ZoneNameIndex();
+    mem_sgmt.deallocate(index, getAllocSize(slot_count));
+}
+
+void
+ZoneNameIndex::insert(uint32_t hash, const ZoneNode* node) {
+    const uint32_t mask = slot_count_ - 1;
+    Entry* entries = getEntries();
+    uint32_t i = hash & mask;
+    while (entries[i].node) {
+        i = (i + 1) & mask;
+    }
+    entries[i].hash = hash;
+    entries[i].node = node;
+    ++count_;
+}
+
+const ZoneNode*
+ZoneNameIndex::find(const LabelSequence& labels) const {
+    const uint32_t hash = getHash(labels);
+    const uint32_t mask = slot_count_ - 1;
+    const Entry* entries = getEntries();
+    uint8_t buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    for (uint32_t i = hash & mask; entries[i].node; i = (i + 1) & mask) {
+        if (entries[i].hash == hash &&
+            entries[i].node->getAbsoluteLabels(buf).equals(labels)) {
+            return (entries[i].node.get());
+        }
+    }
+    return (NULL);
+}
+
 ZoneData::ZoneData(ZoneTree* zone_tree, ZoneNode* origin_node) :
     zone_tree_(zone_tree), origin_node_(origin_node),
     min_ttl_(0)          // tentatively set to silence static checkers
@@ -190,6 +393,33 @@ ZoneData::create(util::MemorySegment& mem_sgmt) {
     return (zone_data);
 }
 
+ZoneData*
+ZoneData::copy(util::MemorySegment& mem_sgmt, RRClass zone_class,
+               const ZoneData& source)
+{
+    assert(!source.isEmpty());
+
+    const Name zone_origin = getAbsoluteName(*source.origin_node_);
+    detail::SegmentObjectHolder<ZoneData, RRClass> holder(mem_sgmt,
+                                                          zone_class);
+    holder.set(create(mem_sgmt, zone_origin));
+    RdataEncoder encoder;
+    if (source.name_dictionary_) {
+        holder.get()->createNameDictionary(mem_sgmt);
+        encoder.setNameDictionary(holder.get()->getNameDictionary());
+    }
+    copyNames(mem_sgmt, zone_class, *source.zone_tree_, zone_origin,
+              *holder.get(), source.name_dictionary_ ? &encoder : NULL);
+    if (source.nsec3_data_) {
+        NSEC3Data* nsec3_data = NSEC3Data::copy(mem_sgmt, zone_class,
+                                                zone_origin,
+                                                *source.nsec3_data_);
+        holder.get()->setNSEC3Data(nsec3_data);
+    }
+    holder.get()->min_ttl_ = source.min_ttl_;
+    return (holder.release());
+}
+
 void
 ZoneData::destroy(util::MemorySegment& mem_sgmt, ZoneData* zone_data,
                   RRClass zone_class)
@@ -200,6 +430,11 @@ ZoneData::destroy(util::MemorySegment& mem_sgmt, ZoneData* zone_data,
     if (zone_data->nsec3_data_) {
         NSEC3Data::destroy(mem_sgmt, zone_data->nsec3_data_.get(), zone_class);
     }
+    zone_data->clearNameIndex(mem_sgmt);
+    // The RdataSets may refer to the names, so this must be the last.
+    if (zone_data->name_dictionary_) {
+        NameDictionary::destroy(mem_sgmt, zone_data->name_dictionary_.get());
+    }
     mem_sgmt.deallocate(zone_data, sizeof(ZoneData));
 }
 
@@ -207,6 +442,7 @@ void
 ZoneData::insertName(util::MemorySegment& mem_sgmt, const Name& name,
                      ZoneNode** node)
 {
+    clearNameIndex(mem_sgmt);
     const ZoneTree::Result result = zone_tree_->insert(mem_sgmt, name, node);
 
     // This should be ensured by the API:
@@ -214,11 +450,94 @@ ZoneData::insertName(util::MemorySegment& mem_sgmt, const Name& name,
             result == ZoneTree::ALREADYEXISTS) && node != NULL);
 }
 
+ZoneNode*
+ZoneData::findName(const Name& name) {
+    ZoneNode* node = NULL;
+    if (zone_tree_->find(name, &node) != ZoneTree::EXACTMATCH) {
+        return (NULL);
+    }
+    return (node);
+}
+
+void
+ZoneData::removeName(util::MemorySegment& mem_sgmt, ZoneNode* node) {
+    // The origin node must always exist (see the class description).  As
+    // it's the root of the tree, the tree never removes it as an empty
+    // upper node either.
+    assert(node != origin_node_.get() && node->isEmpty());
+    clearNameIndex(mem_sgmt);
+    zone_tree_->remove(mem_sgmt, node, nullDeleter);
+}
+
 void
 ZoneData::setMinTTL(uint32_t min_ttl_val) {
     setTTLInNetOrder(min_ttl_val, &min_ttl_);
 }
 
+void
+ZoneData::buildNameIndex(util::MemorySegment& mem_sgmt) {
+    ZoneNameIndex* index = ZoneNameIndex::create(mem_sgmt, *zone_tree_,
+                                                 *origin_node_);
+    clearNameIndex(mem_sgmt);
+    name_index_ = index;
+}
+
+void
+ZoneData::clearNameIndex(util::MemorySegment& mem_sgmt) {
+    if (name_index_) {
+        ZoneNameIndex::destroy(mem_sgmt, name_index_.get());
+        name_index_ = NULL;
+    }
+}
+
+void
+ZoneData::createNameDictionary(util::MemorySegment& mem_sgmt) {
+    if (!name_dictionary_) {
+        name_dictionary_ = NameDictionary::create(mem_sgmt);
+    }
+}
+
+namespace {
+// Add the usage of the names (from the zone origin) and RdataSets of the
+// given tree, which is either that of ZoneData or NSEC3Data.
+void
+addTreeUsage(const ZoneTree& tree, const LabelSequence& origin,
+             RRClass rrclass, ZoneMemoryUsage& usage)
+{
+    ZoneChain node_path;
+    const ZoneNode* node = NULL;
+    tree.find<void*>(origin, &node, node_path, NULL, NULL);
+    assert(node != NULL);
+    for (; node != NULL; node = tree.nextNode(node_path)) {
+        ++usage.node_count;
+        usage.node_size += sizeof(ZoneNode) +
+            node->getLabels().getSerializedLength();
+        for (const RdataSet* rdataset = node->getData();
+             rdataset != NULL;
+             rdataset = rdataset->getNext()) {
+            ++usage.rdataset_count;
+            usage.rdataset_size += rdataset->getMemorySize(rrclass);
+        }
+    }
+}
+}
+
+ZoneMemoryUsage
+ZoneData::getMemoryUsage(RRClass zone_class) const {
+    ZoneMemoryUsage usage;
+    uint8_t buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    const LabelSequence origin = origin_node_->getAbsoluteLabels(buf);
+    addTreeUsage(*zone_tree_, origin, zone_class, usage);
+    if (nsec3_data_) {
+        addTreeUsage(nsec3_data_->getNSEC3Tree(), origin, zone_class, usage);
+    }
+    if (name_dictionary_) {
+        usage.dictionary_name_count = name_dictionary_->getNameCount();
+        usage.dictionary_size = name_dictionary_->getMemorySize();
+    }
+    return (usage);
+}
+
 } // namespace memory
 } // namespace datasrc
 } // datasrc isc
@@ -40,6 +40,7 @@ class NSEC3;
 
 namespace datasrc {
 namespace memory {
+class NameDictionary;
 
 typedef DomainTree<RdataSet> ZoneTree;
 typedef DomainTreeNode<RdataSet> ZoneNode;
@@ -158,6 +159,32 @@ public:
     static void destroy(util::MemorySegment& mem_sgmt, NSEC3Data* data,
                         dns::RRClass nsec3_class);
 
+    /// \brief Allocate and construct a copy of \c NSEC3Data.
+    ///
+    /// The copy has the same hash parameters as \c source, and a copy of
+    /// all names (with their node flags) and \c RdataSet objects of its
+    /// NSEC3 name space.  See \c ZoneData::copy() for the intended usage.
+    ///
+    /// This method ensures there'll be no memory leak on exception.  But,
+    /// like \c create(), addresses allocated from \c mem_sgmt could be
+    /// relocated if \c util::MemorySegmentGrown is thrown, including that
+    /// of \c source if it's stored in the same segment.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt A \c MemorySegment from which memory for the new
+    /// \c NSEC3Data is allocated.
+    /// \param nsec3_class The RR class of the \c RdataSet stored in the NSEC3
+    /// name space of \c source.
+    /// \param zone_origin The zone origin.
+    /// \param source The \c NSEC3Data to be copied.
+    static NSEC3Data* copy(util::MemorySegment& mem_sgmt,
+                           dns::RRClass nsec3_class,
+                           const dns::Name& zone_origin,
+                           const NSEC3Data& source);
+
 private:
     // Domain tree for the Internal NSEC3 name space.  Access to it is
     // limited only via public methods.
@@ -202,6 +229,11 @@ public:
     /// (e.g., whether the first label is a valid encoded string for an NSEC3
     /// owner name).
     ///
+    /// If the zone has a name index (see \c buildNameIndex()), it's
+    /// destroyed, as the tree may be restructured.  Likewise, the caller
+    /// must call \c clearNameIndex() before changing the data or flags of
+    /// any existing node.
+    ///
     /// \throw std::bad_alloc Memory allocation fails
     ///
     /// \param mem_sgmt Memory segment in which resource for the new memory
@@ -213,6 +245,34 @@ public:
     void insertName(util::MemorySegment& mem_sgmt, const dns::Name& name,
                     ZoneNode** node);
 
+    /// \brief Find a name in the NSEC3 name space for modification.
+    ///
+    /// It returns the node of the given name (whether or not it has any
+    /// data), or NULL if the name doesn't exist in the name space.  Like
+    /// \c insertName(), the caller must call \c ZoneData::clearNameIndex()
+    /// before changing the data or flags of the node.
+    ///
+    /// \throw none
+    ///
+    /// \param name The name to be found.
+    ZoneNode* findName(const dns::Name& name);
+
+    /// \brief Remove a name from the NSEC3 name space.
+    ///
+    /// The given node must be one of the NSEC3 name space (e.g., one
+    /// returned by \c findName()) other than the zone origin, and must not
+    /// have any data; it's the caller's responsibility to destroy them
+    /// beforehand.  Any upper node that is left empty without any
+    /// subdomain is also removed, so any pointer to the removed nodes must
+    /// not be used after this call.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt The \c MemorySegment that allocated memory for
+    /// the name space.
+    /// \param node The node to be removed.
+    void removeName(util::MemorySegment& mem_sgmt, ZoneNode* node);
+
 private:
     // Common subroutine for the public versions of create().
     static NSEC3Data* create(util::MemorySegment& mem_sgmt,
@@ -241,6 +301,137 @@ private:
     }
 };
 
+/// \brief Hash index of the owner names of a zone.
+///
+/// This class is an optional companion of \c ZoneData that maps the full
+/// (absolute) owner names of the zone to their \c ZoneNode in a single
+/// open addressing hash table, so an exact match lookup doesn't have to
+/// walk down the \c DomainTree levels, comparing labels at each one.
+///
+/// Only names for which the tree search would stop at the node itself
+/// with an exact match are indexed: non-empty nodes that have no ancestor
+/// (up to and including the origin) with \c ZoneNode::FLAG_CALLBACK set,
+/// i.e., that are not below a zone cut or DNAME.  A miss in the index
+/// therefore doesn't mean anything; the caller must fall back to the tree
+/// search, which is also needed for closest encloser, wildcard and NSEC
+/// lookups.
+///
+/// The index is a snapshot of the tree at the time of \c create(); it's
+/// not updated when the tree is modified, and must be destroyed (or
+/// rebuilt) whenever that happens.  \c ZoneData takes care of this.
+///
+/// Like \c NSEC3Data, the hash table is stored in the same memory segment
+/// immediately following the main class object, and all pointers are
+/// offset pointers, so it can be placed in a shared memory region.
+class ZoneNameIndex : boost::noncopyable {
+public:
+    /// \brief Allocate and construct \c ZoneNameIndex.
+    ///
+    /// It indexes the names of the given tree that meet the condition
+    /// described in the class description.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.  In this case nothing is allocated.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt A \c MemorySegment from which memory for the new
+    /// \c ZoneNameIndex is allocated.
+    /// \param zone_tree The zone's name space.
+    /// \param origin_node The origin node of the zone in \c zone_tree.
+    static ZoneNameIndex* create(util::MemorySegment& mem_sgmt,
+                                 const ZoneTree& zone_tree,
+                                 const ZoneNode& origin_node);
+
+    /// \brief Destruct and deallocate \c ZoneNameIndex.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt The \c MemorySegment that allocated memory for
+    /// \c index.
+    /// \param index A non-NULL pointer to a valid ZoneNameIndex object
+    /// that was originally created by the \c create() method.
+    static void destroy(util::MemorySegment& mem_sgmt, ZoneNameIndex* index);
+
+    /// \brief Find the node of the given name.
+    ///
+    /// The comparison is case insensitive as in the \c DomainTree.
+    ///
+    /// \throw none
+    ///
+    /// \param labels The absolute name to be found.
+    /// \return The node of the name if it's indexed; NULL otherwise.
+    const ZoneNode* find(const dns::LabelSequence& labels) const;
+
+    /// \brief Return the number of indexed names.
+    ///
+    /// \throw none
+    size_t getNameCount() const { return (count_); }
+
+    /// \brief Return a hash value of the given name.
+    ///
+    /// Unlike \c dns::LabelSequence::getHash(), it covers all the labels
+    /// of the name, as names in a zone often only differ in their
+    /// leftmost labels, which are far from the end of a long name.  It's
+    /// case insensitive.
+    ///
+    /// This is public mainly for tests.
+    ///
+    /// \throw none
+    static uint32_t getHash(const dns::LabelSequence& labels);
+
+private:
+    struct Entry {
+        uint32_t hash;
+        boost::interprocess::offset_ptr<const ZoneNode> node; // NULL if free
+    };
+
+    // The number of slots of the table.  It's a power of 2.
+    static size_t getSlotCount(size_t max_names);
+    static size_t getAllocSize(size_t slot_count) {
+        return (sizeof(ZoneNameIndex) + slot_count * sizeof(Entry));
+    }
+
+    explicit ZoneNameIndex(uint32_t slot_count) :
+        slot_count_(slot_count), count_(0)
+    {}
+
+    void insert(uint32_t hash, const ZoneNode* node);
+
+    const Entry* getEntries() const {
+        return (reinterpret_cast<const Entry*>(this + 1));
+    }
+    Entry* getEntries() {
+        return (reinterpret_cast<Entry*>(this + 1));
+    }
+
+    const uint32_t slot_count_;
+    uint32_t count_;
+};
+
+/// \brief Memory usage of a zone.
+///
+/// This is the result of \c ZoneData::getMemoryUsage().  The sizes are
+/// those requested from the memory segment; any overhead of the segment
+/// (such as alignment and bookkeeping) is not included.
+struct ZoneMemoryUsage {
+    ZoneMemoryUsage() :
+        node_count(0), node_size(0), rdataset_count(0), rdataset_size(0),
+        dictionary_name_count(0), dictionary_size(0)
+    {}
+
+    /// \brief Return the total size of all the data.
+    size_t getTotalSize() const {
+        return (node_size + rdataset_size + dictionary_size);
+    }
+
+    size_t node_count;     ///< Number of nodes, including NSEC3 ones
+    size_t node_size;      ///< Size of the nodes (approximate)
+    size_t rdataset_count; ///< Number of \c RdataSet objects
+    size_t rdataset_size;  ///< Size of the \c RdataSet objects
+    size_t dictionary_name_count; ///< Number of names in the dictionary
+    size_t dictionary_size; ///< Size of the \c NameDictionary, if any
+};
+
 /// \brief DNS zone data.
 ///
 /// This class encapsulates the content of a DNS zone (which is essentially a
@@ -437,6 +628,43 @@ public:
     /// \c ZoneData is allocated.
     static ZoneData* create(util::MemorySegment& mem_sgmt);
 
+    /// \brief Allocate and construct a copy of \c ZoneData.
+    ///
+    /// The copy has all the names of \c source with the same node flags
+    /// (including the zone status held in the origin node), a copy of all
+    /// their \c RdataSet objects (in the same order), a copy of the
+    /// associated \c NSEC3Data if any, and the same minimum TTL.  The
+    /// exact match name index isn't copied; the caller needs to call
+    /// \c buildNameIndex() on the copy if it wants one.  If \c source has
+    /// a name dictionary, the copy has a new one, and the RDATA are encoded
+    /// with references to it.
+    ///
+    /// This is intended to be used to prepare a new version of a zone
+    /// while the current version is still in use: \c source is not
+    /// modified, and the copy can be updated independently of it.  Every
+    /// node and \c RdataSet is copied, so it takes time and memory
+    /// proportional to the size of the zone, but as the encoded RDATA are
+    /// simply copied, it's cheaper than building the same data from RRsets.
+    ///
+    /// This method ensures there'll be no memory leak on exception.  But,
+    /// like \c create(), addresses allocated from \c mem_sgmt could be
+    /// relocated if \c util::MemorySegmentGrown is thrown, including that
+    /// of \c source if it's stored in the same segment.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt A \c MemorySegment from which memory for the new
+    /// \c ZoneData is allocated.
+    /// \param zone_class The RR class of the \c RdataSet stored in
+    /// \c source.
+    /// \param source The \c ZoneData to be copied.  It must not be an
+    /// "empty" zone data (see the other \c create()).
+    static ZoneData* copy(util::MemorySegment& mem_sgmt,
+                          dns::RRClass zone_class,
+                          const ZoneData& source);
+
     /// \brief Destruct and deallocate \c ZoneData.
     ///
     /// It releases all resource allocated in the internal storage NSEC3 for
@@ -525,6 +753,41 @@ public:
     /// \throw none
     const NSEC3Data* getNSEC3Data() const { return (nsec3_data_.get()); }
 
+    /// \brief Return the exact match name index of the zone.
+    ///
+    /// It returns NULL unless the index was built by \c buildNameIndex()
+    /// and the zone hasn't been modified since then.
+    ///
+    /// \throw none
+    const ZoneNameIndex* getNameIndex() const { return (name_index_.get()); }
+
+    /// \brief Return the name dictionary of the zone.
+    ///
+    /// It returns NULL unless one was created by \c createNameDictionary().
+    ///
+    /// \throw none
+    const NameDictionary* getNameDictionary() const {
+        return (name_dictionary_.get());
+    }
+
+    /// \brief Return the name dictionary of the zone, mutable version.
+    ///
+    /// The names of new \c RdataSet objects of the zone are expected to be
+    /// added to it (see \c RdataEncoder::setNameDictionary()).
+    ///
+    /// \throw none
+    NameDictionary* getNameDictionary() { return (name_dictionary_.get()); }
+
+    /// \brief Return the memory usage of the zone.
+    ///
+    /// It walks the entire zone, so it's not cheap for large zones.
+    ///
+    /// \throw none
+    ///
+    /// \param zone_class The RR class of the \c RdataSet stored in the
+    /// zone.
+    ZoneMemoryUsage getMemoryUsage(dns::RRClass zone_class) const;
+
     /// \brief Return a pointer to the zone's minimum TTL data.
     ///
     /// The returned pointer points to a memory region that is valid at least
@@ -589,6 +852,36 @@ public:
     void insertName(util::MemorySegment& mem_sgmt, const dns::Name& name,
                     ZoneNode** node);
 
+    /// \brief Find a name of the zone for modification.
+    ///
+    /// It returns the node of the given name (whether or not it has any
+    /// data), or NULL if the name doesn't exist in the zone's name space.
+    /// Like \c insertName(), the name is expected to belong to the zone's
+    /// "normal" name space, and the caller must call \c clearNameIndex()
+    /// before changing the data or flags of the node.
+    ///
+    /// \throw none
+    ///
+    /// \param name The name to be found.
+    ZoneNode* findName(const dns::Name& name);
+
+    /// \brief Remove a name from the zone.
+    ///
+    /// The given node must be one of the zone (e.g., one returned by
+    /// \c findName()) other than the origin node, which always has to
+    /// exist, and must not have any data; it's the caller's responsibility
+    /// to destroy them beforehand.  Any upper node that is left empty
+    /// without any subdomain is also removed, so any pointer to the removed
+    /// nodes must not be used after this call.  Like \c insertName(), it
+    /// destroys the name index of the zone, if any.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt The \c MemorySegment that allocated memory for
+    /// this zone data.
+    /// \param node The node to be removed.
+    void removeName(util::MemorySegment& mem_sgmt, ZoneNode* node);
+
     /// \brief Specify whether or not the zone is signed in terms of DNSSEC.
     ///
     /// The zone will be considered "signed" (in that subsequent calls to
@@ -659,12 +952,57 @@ public:
     /// \param min_ttl_val The minimum TTL value as unsigned 32-bit integer
     /// in the host byte order.
     void setMinTTL(uint32_t min_ttl_val);
+
+    /// \brief Build the exact match name index of the zone.
+    ///
+    /// It (re)builds the \c ZoneNameIndex of the current content of the
+    /// zone, which can then be retrieved by \c getNameIndex().  It's
+    /// expected to be called once the zone is fully loaded; the index is
+    /// destroyed by any subsequent call to \c insertName(),
+    /// \c removeName() or \c clearNameIndex().
+    ///
+    /// On exception, the zone data are intact (any old index is kept).
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt The \c MemorySegment that allocated memory for
+    /// this zone data.
+    void buildNameIndex(util::MemorySegment& mem_sgmt);
+
+    /// \brief Destroy the exact match name index of the zone, if any.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt The \c MemorySegment that allocated memory for
+    /// this zone data.
+    void clearNameIndex(util::MemorySegment& mem_sgmt);
+
+    /// \brief Create the name dictionary of the zone.
+    ///
+    /// Once created, the \c NameDictionary returned by
+    /// \c getNameDictionary() is kept until the zone data are destroyed,
+    /// as the encoded RDATA of the zone may refer to its names.  It's
+    /// expected to be called right after \c create(), before any
+    /// \c RdataSet is added.  If the zone already has one, this method
+    /// does nothing.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt The \c MemorySegment that allocated memory for
+    /// this zone data.
+    void createNameDictionary(util::MemorySegment& mem_sgmt);
     //@}
 
 private:
     const boost::interprocess::offset_ptr<ZoneTree> zone_tree_;
     const boost::interprocess::offset_ptr<ZoneNode> origin_node_;
     boost::interprocess::offset_ptr<NSEC3Data> nsec3_data_;
+    boost::interprocess::offset_ptr<ZoneNameIndex> name_index_;
+    boost::interprocess::offset_ptr<NameDictionary> name_dictionary_;
     uint32_t min_ttl_;
 };
 
@@ -26,11 +26,20 @@
 #include <dns/rrset.h>
 #include <dns/zone_checker.h>
 
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
 #include <boost/foreach.hpp>
 #include <boost/bind.hpp>
 #include <boost/noncopyable.hpp>
 
+#include <deque>
 #include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
 
 using namespace isc::dns;
 using namespace isc::dns::rdata;
@@ -76,6 +85,7 @@ public:
 
     void addFromLoad(const isc::dns::ConstRRsetPtr& rrset);
     void flushNodeRRsets();
+    void buildNameIndex() { updater_.buildNameIndex(); }
 
 private:
     typedef std::map<isc::dns::RRType, isc::dns::ConstRRsetPtr> NodeRRsets;
@@ -176,17 +186,54 @@ logError(const dns::Name* zone_name, const dns::RRClass* rrclass,
         arg(reason);
 }
 
+// Check the (fully loaded or updated) zone data with dns::checkZone().
+void
+validateZoneData(const Name& zone_name, const RRClass& rrclass,
+                 ZoneData& zone_data)
+{
+    RRsetCollection collection(zone_data, rrclass);
+    const dns::ZoneCheckerCallbacks
+        callbacks(boost::bind(&logError, &zone_name, &rrclass, _1),
+                  boost::bind(&logWarning, &zone_name, &rrclass, _1));
+    if (!dns::checkZone(zone_name, rrclass, collection, callbacks)) {
+        isc_throw(ZoneValidationError,
+                  "Errors found when validating zone: "
+                  << zone_name << "/" << rrclass);
+    }
+}
+
+// Log the memory usage of the (fully loaded or updated) zone data.
+void
+logMemoryUsage(const Name& zone_name, const RRClass& rrclass,
+               const ZoneData& zone_data)
+{
+    // Walking the zone is expensive, so skip it unless it's logged.
+    if (!logger.isDebugEnabled(DBG_TRACE_BASIC)) {
+        return;
+    }
+    const ZoneMemoryUsage usage = zone_data.getMemoryUsage(rrclass);
+    LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_MEM_ZONE_MEMORY_USAGE).
+        arg(zone_name).arg(rrclass).arg(usage.getTotalSize()).
+        arg(usage.node_count).arg(usage.node_size).
+        arg(usage.rdataset_count).arg(usage.rdataset_size).
+        arg(usage.dictionary_name_count).arg(usage.dictionary_size);
+}
+
 ZoneData*
 loadZoneDataInternal(util::MemorySegment& mem_sgmt,
                      const isc::dns::RRClass& rrclass,
                      const Name& zone_name,
-                     boost::function<void(LoadCallback)> rrset_installer)
+                     boost::function<void(LoadCallback)> rrset_installer,
+                     bool compact)
 {
     while (true) { // Try as long as it takes to load and grow the segment
         bool created = false;
         try {
             SegmentObjectHolder<ZoneData, RRClass> holder(mem_sgmt, rrclass);
             holder.set(ZoneData::create(mem_sgmt, zone_name));
+            if (compact) {
+                holder.get()->createNameDictionary(mem_sgmt);
+            }
 
             // Nothing from this point on should throw MemorySegmentGrown.
             // It is handled inside here.
@@ -197,6 +244,8 @@ loadZoneDataInternal(util::MemorySegment& mem_sgmt,
                                         _1));
             // Add any last RRsets that were left
             loader.flushNodeRRsets();
+            // The zone is complete; index its names for exact match lookups.
+            loader.buildNameIndex();
 
             const ZoneNode* origin_node = holder.get()->getOriginNode();
             const RdataSet* rdataset = origin_node->getData();
@@ -208,15 +257,8 @@ loadZoneDataInternal(util::MemorySegment& mem_sgmt,
                 }
             }
 
-            RRsetCollection collection(*(holder.get()), rrclass);
-            const dns::ZoneCheckerCallbacks
-                callbacks(boost::bind(&logError, &zone_name, &rrclass, _1),
-                          boost::bind(&logWarning, &zone_name, &rrclass, _1));
-            if (!dns::checkZone(zone_name, rrclass, collection, callbacks)) {
-                isc_throw(ZoneValidationError,
-                          "Errors found when validating zone: "
-                          << zone_name << "/" << rrclass);
-            }
+            validateZoneData(zone_name, rrclass, *holder.get());
+            logMemoryUsage(zone_name, rrclass, *holder.get());
 
             return (holder.release());
         } catch (const util::MemorySegmentGrown&) {
@@ -238,16 +280,211 @@ masterLoaderWrapper(const char* const filename, const Name& origin,
     dns::RRCollator collator(boost::bind(callback, _1));
 
     try {
-        dns::MasterLoader(filename, origin, zone_class,
-                          createMasterLoaderCallbacks(origin, zone_class,
-                                                      &load_ok),
-                          collator.getCallback()).load();
+        dns::MasterLoader loader(filename, origin, zone_class,
+                                 createMasterLoaderCallbacks(origin,
+                                                             zone_class,
+                                                             &load_ok),
+                                 collator.getCallback());
+        // Well-known types are passed in the wire format, so we can
+        // encode them without creating Rdata objects.
+        loader.setAddWireCallback(collator.getWireCallback());
+        loader.load();
         collator.flush();
     } catch (const dns::MasterLoaderError& e) {
         isc_throw(ZoneLoaderException, e.what());
     }
 }
 
+// A bounded queue of RRset batches, passed from the thread reading (and
+// parsing) the zone to the one adding them to the zone data.  There is
+// exactly one thread on each side.
+class RRsetBatchQueue : boost::noncopyable {
+public:
+    typedef std::vector<ConstRRsetPtr> Batch;
+
+    // Thrown from push() to the reading side once the adding side gave up.
+    struct Aborted {};
+
+    RRsetBatchQueue() : closed_(false), aborted_(false) {}
+
+    // Pass the content of the batch to the other side (the batch will be
+    // empty on return).  Waits while the queue is full.
+    void push(Batch& batch) {
+        util::thread::Mutex::Locker locker(mutex_);
+        while (batches_.size() >= MAX_BATCHES && !aborted_) {
+            not_full_.wait(mutex_);
+        }
+        if (aborted_) {
+            throw Aborted();
+        }
+        batches_.push_back(Batch());
+        batches_.back().swap(batch);
+        not_empty_.signal();
+    }
+
+    // Tell the other side there won't be any more batches.
+    void close() {
+        util::thread::Mutex::Locker locker(mutex_);
+        closed_ = true;
+        not_empty_.signal();
+    }
+
+    // Get the next batch into the given (empty) one.  Waits while the queue
+    // is empty; returns false if it's closed and there are no more batches.
+    bool pop(Batch& batch) {
+        util::thread::Mutex::Locker locker(mutex_);
+        while (batches_.empty() && !closed_) {
+            not_empty_.wait(mutex_);
+        }
+        if (batches_.empty()) {
+            return (false);
+        }
+        batch.swap(batches_.front());
+        batches_.pop_front();
+        not_full_.signal();
+        return (true);
+    }
+
+    // Make the reading side stop (at its next push()).
+    void abort() {
+        util::thread::Mutex::Locker locker(mutex_);
+        aborted_ = true;
+        batches_.clear();
+        not_full_.signal();
+    }
+
+    // The number of RRsets in a batch and the maximum number of batches
+    // waiting in the queue.  The former amortizes the locking, and the
+    // latter limits the memory used by the parsed but not yet added RRsets.
+    static const size_t BATCH_SIZE = 256;
+    static const size_t MAX_BATCHES = 64;
+
+private:
+    util::thread::Mutex mutex_;
+    util::thread::CondVar not_empty_;
+    util::thread::CondVar not_full_;
+    std::deque<Batch> batches_;
+    bool closed_;
+    bool aborted_;
+};
+
+// The callback for the reading thread: collect the RRsets into a batch and
+// pass it to the queue once it's full.
+void
+addToBatch(RRsetBatchQueue* queue, RRsetBatchQueue::Batch* batch,
+           const ConstRRsetPtr& rrset)
+{
+    batch->push_back(rrset);
+    if (batch->size() >= RRsetBatchQueue::BATCH_SIZE) {
+        queue->push(*batch);
+    }
+}
+
+// The error that stopped the reading thread, to be rethrown in the caller's
+// thread (we can't transfer exception objects between threads).
+struct ReadError {
+    enum Type {
+        NONE,
+        LOADER,                 // ZoneLoaderException
+        NO_MEMORY,              // std::bad_alloc
+        OTHER
+    };
+    ReadError() : type(NONE) {}
+    Type type;
+    std::string what;
+};
+
+// The main function of the reading thread.
+void
+readRRsets(boost::function<void(LoadCallback)> rrset_installer,
+           RRsetBatchQueue* queue, ReadError* error)
+{
+    try {
+        RRsetBatchQueue::Batch batch;
+        rrset_installer(boost::bind(addToBatch, queue, &batch, _1));
+        if (!batch.empty()) {
+            queue->push(batch);
+        }
+    } catch (const RRsetBatchQueue::Aborted&) {
+        // The other side has failed and will report its own error.
+    } catch (const ZoneLoaderException& ex) {
+        error->type = ReadError::LOADER;
+        error->what = ex.what();
+    } catch (const std::bad_alloc&) {
+        error->type = ReadError::NO_MEMORY;
+    } catch (const std::exception& ex) {
+        error->type = ReadError::OTHER;
+        error->what = ex.what();
+    } catch (...) {
+        error->type = ReadError::OTHER;
+        error->what = "unknown exception";
+    }
+    queue->close();
+}
+
+// An installer that runs the given one in a separate thread, so reading and
+// parsing the zone (which is usually the most expensive part of loading a
+// zone from a master file) is done in parallel with adding the parsed RRsets
+// to the zone data in the caller's thread.  The zone data (and the memory
+// segment) are only touched by the caller's thread, so no further
+// synchronization is needed.
+void
+pipelinedInstaller(boost::function<void(LoadCallback)> rrset_installer,
+                   LoadCallback callback)
+{
+    RRsetBatchQueue queue;
+    ReadError error;
+    util::thread::Thread reader(boost::bind(readRRsets, rrset_installer,
+                                            &queue, &error));
+    try {
+        RRsetBatchQueue::Batch batch;
+        while (queue.pop(batch)) {
+            BOOST_FOREACH(const ConstRRsetPtr& rrset, batch) {
+                callback(rrset);
+            }
+            batch.clear();
+        }
+    } catch (...) {
+        // Make the reader stop and wait for it, as it refers to the local
+        // objects.
+        queue.abort();
+        reader.wait();
+        throw;
+    }
+    reader.wait();
+
+    switch (error.type) {
+    case ReadError::NONE:
+        break;
+    case ReadError::LOADER:
+        isc_throw(ZoneLoaderException, error.what);
+    case ReadError::NO_MEMORY:
+        throw std::bad_alloc();
+    case ReadError::OTHER:
+        isc_throw(isc::Unexpected, "Failed to read zone: " << error.what);
+    }
+}
+
+// How to read zone files; see setZoneFileReadMode().
+detail::ZoneFileReadMode zone_file_read_mode = detail::READ_AUTO;
+
+// Whether to read the zone file in a separate thread (pipelinedInstaller()).
+// That only helps if the reading thread can run in parallel with the
+// caller's; on a single CPU the thread switching just makes it slower.
+bool
+readInThread() {
+    switch (zone_file_read_mode) {
+    case detail::READ_IN_THREAD:
+        return (true);
+    case detail::READ_IN_CALLER:
+        return (false);
+    case detail::READ_AUTO:
+        break;
+    }
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus >= 2);
+}
+
 // The installer called from the iterator version of loadZoneData().
 void
 generateRRsetFromIterator(ZoneIterator* iterator, LoadCallback callback) {
@@ -257,37 +494,160 @@ generateRRsetFromIterator(ZoneIterator* iterator, LoadCallback callback) {
     }
 }
 
+// Apply the differences read from a journal reader to the zone.  They are
+// in the form of IXFR (RFC 1995): each sequence starts with the SOA of the
+// older version followed by the deleted RRs, then the SOA of the newer
+// version followed by the added RRs.  Each RRset returned by the reader
+// contains a single RR, so RRSIGs come separately from the RRs they cover.
+void
+applyDiffs(ZoneDataUpdater& updater, ZoneJournalReader& journal_reader) {
+    bool deleting = false;
+    ConstRRsetPtr rrset;
+    while ((rrset = journal_reader.getNextDiff()) != NULL) {
+        if (rrset->getType() == RRType::SOA()) {
+            deleting = !deleting;
+        }
+        const bool is_rrsig = (rrset->getType() == RRType::RRSIG());
+        const ConstRRsetPtr covered = is_rrsig ? ConstRRsetPtr() : rrset;
+        const ConstRRsetPtr sig = is_rrsig ? rrset : ConstRRsetPtr();
+        if (deleting) {
+            updater.remove(covered, sig);
+        } else {
+            updater.add(covered, sig);
+        }
+    }
+    if (deleting) {
+        isc_throw(ZoneValidationError,
+                  "Differences end in the middle of a sequence");
+    }
+}
+
+// ZoneDataUpdater::add() only ever marks the zone signed.  Once the
+// differences are applied, bring the DNSSEC status back in line with
+// what loading the new version from scratch would result in.
+void
+updateSignedStatus(util::MemorySegment& mem_sgmt, const RRClass& rrclass,
+                   ZoneData& zone_data)
+{
+    const RdataSet* origin_data = zone_data.getOriginNode()->getData();
+    const NSEC3Data* nsec3_data = zone_data.getNSEC3Data();
+    // The NSEC3 name space always has the origin node.
+    if (nsec3_data != NULL && nsec3_data->getNSEC3Tree().getNodeCount() <= 1 &&
+        RdataSet::find(origin_data, RRType::NSEC3PARAM()) == NULL) {
+        NSEC3Data::destroy(mem_sgmt, zone_data.setNSEC3Data(NULL), rrclass);
+    }
+    zone_data.setSigned(zone_data.isNSEC3Signed() ||
+                        RdataSet::find(origin_data, RRType::NSEC()) != NULL);
+}
+
+// A helper for updateZoneData(): keep the address of the old version of
+// the zone data in the segment while it's being copied, as the growth of
+// the segment can relocate it.
+class OldZoneDataHolder : boost::noncopyable {
+public:
+    OldZoneDataHolder(util::MemorySegment& mem_sgmt,
+                      const ZoneData& zone_data) :
+        mem_sgmt_(mem_sgmt)
+    {
+        // We don't care if it grows; we always get the address anew.
+        mem_sgmt_.setNamedAddress(NAME, const_cast<ZoneData*>(&zone_data));
+    }
+    ~OldZoneDataHolder() {
+        mem_sgmt_.clearNamedAddress(NAME);
+    }
+    const ZoneData& get() const {
+        return (*static_cast<const ZoneData*>(
+                    mem_sgmt_.getNamedAddress(NAME).second));
+    }
+private:
+    static const char* const NAME;
+    util::MemorySegment& mem_sgmt_;
+};
+const char* const OldZoneDataHolder::NAME = "updater_old_zone_data";
+
 } // end of unnamed namespace
 
 ZoneData*
 loadZoneData(util::MemorySegment& mem_sgmt,
              const isc::dns::RRClass& rrclass,
              const isc::dns::Name& zone_name,
-             const std::string& zone_file)
+             const std::string& zone_file,
+             bool compact)
 {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_MEM_LOAD_FROM_FILE).
         arg(zone_name).arg(rrclass).arg(zone_file);
 
-    return (loadZoneDataInternal(mem_sgmt, rrclass, zone_name,
-                                 boost::bind(masterLoaderWrapper,
-                                             zone_file.c_str(),
-                                             zone_name, rrclass,
-                                             _1)));
+    const boost::function<void(LoadCallback)> installer =
+        boost::bind(masterLoaderWrapper, zone_file.c_str(), zone_name,
+                    rrclass, _1);
+    if (readInThread()) {
+        return (loadZoneDataInternal(mem_sgmt, rrclass, zone_name,
+                                     boost::bind(pipelinedInstaller,
+                                                 installer, _1), compact));
+    }
+    return (loadZoneDataInternal(mem_sgmt, rrclass, zone_name, installer,
+                                 compact));
 }
 
 ZoneData*
 loadZoneData(util::MemorySegment& mem_sgmt,
              const isc::dns::RRClass& rrclass,
              const isc::dns::Name& zone_name,
-             ZoneIterator& iterator)
+             ZoneIterator& iterator,
+             bool compact)
 {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_MEM_LOAD_FROM_DATASRC).
         arg(zone_name).arg(rrclass);
 
     return (loadZoneDataInternal(mem_sgmt, rrclass, zone_name,
                                  boost::bind(generateRRsetFromIterator,
-                                             &iterator, _1)));
+                                             &iterator, _1), compact));
+}
+
+ZoneData*
+updateZoneData(util::MemorySegment& mem_sgmt,
+               const isc::dns::RRClass& rrclass,
+               const isc::dns::Name& zone_name,
+               const ZoneData& old_zone_data,
+               ZoneJournalReader& journal_reader)
+{
+    LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_MEM_UPDATE_ZONE).
+        arg(zone_name).arg(rrclass);
+
+    OldZoneDataHolder old_holder(mem_sgmt, old_zone_data);
+    while (true) { // Try as long as it takes to copy and grow the segment
+        bool copied = false;
+        try {
+            SegmentObjectHolder<ZoneData, RRClass> holder(mem_sgmt, rrclass);
+            holder.set(ZoneData::copy(mem_sgmt, rrclass, old_holder.get()));
+
+            // Nothing from this point on should throw MemorySegmentGrown.
+            // It is handled inside here.
+            copied = true;
+
+            {
+                ZoneDataUpdater updater(mem_sgmt, rrclass, zone_name,
+                                        *holder.get());
+                applyDiffs(updater, journal_reader);
+                updateSignedStatus(mem_sgmt, rrclass, *holder.get());
+                updater.buildNameIndex();
+            }
+            validateZoneData(zone_name, rrclass, *holder.get());
+            logMemoryUsage(zone_name, rrclass, *holder.get());
+
+            return (holder.release());
+        } catch (const util::MemorySegmentGrown&) {
+            assert(!copied);
+        }
+    }
+}
+
+namespace detail {
+void
+setZoneFileReadMode(ZoneFileReadMode mode) {
+    zone_file_read_mode = mode;
 }
+} // namespace detail
 
 } // namespace memory
 } // namespace datasrc
@@ -17,6 +17,7 @@
 
 #include <datasrc/exceptions.h>
 #include <datasrc/memory/zone_data.h>
+#include <datasrc/zone.h>
 #include <datasrc/zone_iterator.h>
 #include <dns/name.h>
 #include <dns/rrclass.h>
@@ -44,14 +45,28 @@ struct ZoneValidationError : public ZoneLoaderException {
 /// RRsets are passed by the master loader. Throws \c EmptyZone if an
 /// empty zone would be created due to the \c loadZoneData().
 ///
+/// If \c compact is true, the zone data have a name dictionary (see
+/// \c ZoneData::createNameDictionary()), and the names in the RDATA of
+/// the zone are shared in it.  This saves memory for zones where many RRs
+/// have the same names in their RDATA (e.g., NS RRs of delegations to
+/// a limited set of name servers), but costs memory for names that appear
+/// only once, and makes loading somewhat slower.
+///
+/// If the system has two or more CPUs online, the zone file is read and
+/// parsed in a separate thread, in parallel with building the zone data
+/// in the caller's thread.  On a single CPU this only adds the cost of
+/// switching the threads, so it's all done in the caller's thread.
+///
 /// \param mem_sgmt The memory segment.
 /// \param rrclass The RRClass.
 /// \param zone_name The name of the zone that is being loaded.
 /// \param zone_file Filename which contains the zone data for \c zone_name.
+/// \param compact Whether to share the names in the RDATA of the zone.
 ZoneData* loadZoneData(util::MemorySegment& mem_sgmt,
                        const isc::dns::RRClass& rrclass,
                        const isc::dns::Name& zone_name,
-                       const std::string& zone_file);
+                       const std::string& zone_file,
+                       bool compact = false);
 
 /// \brief Create and return a ZoneData instance populated from the
 /// \c iterator.
@@ -65,10 +80,63 @@ ZoneData* loadZoneData(util::MemorySegment& mem_sgmt,
 /// \param rrclass The RRClass.
 /// \param zone_name The name of the zone that is being loaded.
 /// \param iterator Iterator that returns RRsets to load into the zone.
+/// \param compact Whether to share the names in the RDATA of the zone
+/// (see the other version).
 ZoneData* loadZoneData(util::MemorySegment& mem_sgmt,
                        const isc::dns::RRClass& rrclass,
                        const isc::dns::Name& zone_name,
-                       ZoneIterator& iterator);
+                       ZoneIterator& iterator,
+                       bool compact = false);
+
+/// \brief Create and return a new version of a zone by applying
+/// differences to its current version.
+///
+/// It makes a full copy of \c old_zone_data (see \c ZoneData::copy())
+/// and applies the differences read from \c journal_reader to it, so the
+/// result is the same as loading the newer version of the zone from
+/// scratch.  Nothing is shared between the two versions, so the cost is
+/// still proportional to the size of the zone; it only saves reading and
+/// encoding the unchanged records again.  \c old_zone_data is not
+/// modified, so it can keep being used (e.g., for lookups) while the new
+/// version is being prepared.
+///
+/// Throws \c ZoneDataUpdater::AddError if the differences are
+/// inconsistent with the zone data, \c ZoneValidationError if the
+/// resulting zone is invalid, and \c DataSourceError if the
+/// differences can't be read.  Other exceptions than \c std::bad_alloc
+/// are possible for unexpected differences, e.g., ones that can't be
+/// applied because of a limitation of the implementation (such as a
+/// change of NSEC3 parameters); in any case the caller can still fall
+/// back to loading the zone from scratch.
+///
+/// \param mem_sgmt The memory segment.  \c old_zone_data must be in it.
+/// \param rrclass The RRClass.
+/// \param zone_name The name of the zone that is being updated.
+/// \param old_zone_data The current version of the zone data.
+/// \param journal_reader The reader of the differences from the version
+/// of \c old_zone_data to the new one.
+ZoneData* updateZoneData(util::MemorySegment& mem_sgmt,
+                         const isc::dns::RRClass& rrclass,
+                         const isc::dns::Name& zone_name,
+                         const ZoneData& old_zone_data,
+                         ZoneJournalReader& journal_reader);
+
+namespace detail {
+/// \brief How \c loadZoneData() reads zone files (see its description).
+enum ZoneFileReadMode {
+    READ_AUTO,          ///< In a separate thread if there are 2+ CPUs
+    READ_IN_THREAD,     ///< Always in a separate thread
+    READ_IN_CALLER      ///< Always in the caller's thread
+};
+
+/// \brief Set how \c loadZoneData() reads zone files.
+///
+/// This is for tests, so both ways can be tested regardless of the number
+/// of CPUs.  The default is \c READ_AUTO.  It's not thread safe.
+///
+/// \throw None
+void setZoneFileReadMode(ZoneFileReadMode mode);
+} // namespace detail
 
 } // namespace memory
 } // namespace datasrc
@@ -144,15 +144,29 @@ ZoneDataUpdater::validate(const isc::dns::ConstRRsetPtr rrset) const {
     // For RRSIGs, check consistency of the type covered.  We know the
     // RRset isn't empty, so the following check is safe.
     if (rrset->getType() == RRType::RRSIG()) {
-        RdataIteratorPtr rit = rrset->getRdataIterator();
-        const RRType covered = dynamic_cast<const generic::RRSIG&>(
-            rit->getCurrent()).typeCovered();
-        for (rit->next(); !rit->isLast(); rit->next()) {
-            if (dynamic_cast<const generic::RRSIG&>(
-                     rit->getCurrent()).typeCovered() != covered)
-            {
-                isc_throw(AddError, "RRSIG contains mixed covered types: "
-                          << rrset->toText());
+        const WireRRset* wire_rrset =
+            dynamic_cast<const WireRRset*>(rrset.get());
+        if (wire_rrset != NULL) {
+            // Avoid creating Rdata objects; the type covered is in the
+            // beginning of each wire-format RDATA.
+            const RRType covered = getCoveredType(*wire_rrset, 0);
+            for (size_t i = 1; i < wire_rrset->getRdataCount(); ++i) {
+                if (getCoveredType(*wire_rrset, i) != covered) {
+                    isc_throw(AddError, "RRSIG contains mixed covered types: "
+                              << rrset->toText());
+                }
+            }
+        } else {
+            RdataIteratorPtr rit = rrset->getRdataIterator();
+            const RRType covered = dynamic_cast<const generic::RRSIG&>(
+                rit->getCurrent()).typeCovered();
+            for (rit->next(); !rit->isLast(); rit->next()) {
+                if (dynamic_cast<const generic::RRSIG&>(
+                         rit->getCurrent()).typeCovered() != covered)
+                {
+                    isc_throw(AddError, "RRSIG contains mixed covered types: "
+                              << rrset->toText());
+                }
             }
         }
     }
@@ -226,10 +240,10 @@ ZoneDataUpdater::getNSEC3Hash() {
 template <typename T>
 void
 ZoneDataUpdater::setupNSEC3(const ConstRRsetPtr rrset) {
-    // We know rrset has exactly one RDATA
-    const T& nsec3_rdata =
-        dynamic_cast<const T&>(
-            rrset->getRdataIterator()->getCurrent());
+    // We know rrset has exactly one RDATA.  The iterator must be kept
+    // while we use the RDATA, as it may own it (as for dns::WireRRset).
+    const RdataIteratorPtr rit = rrset->getRdataIterator();
+    const T& nsec3_rdata = dynamic_cast<const T&>(rit->getCurrent());
 
     NSEC3Data* nsec3_data = zone_data_->getNSEC3Data();
     if (nsec3_data == NULL) {
@@ -273,6 +287,7 @@ ZoneDataUpdater::addNSEC3(const Name& name, const ConstRRsetPtr& rrset,
     // Create a new RdataSet, merging any existing NSEC3 data for this
     // name.
     RdataSet* old_rdataset = node->getData();
+    encoder_.setNameDictionary(zone_data_->getNameDictionary());
     RdataSet* rdataset = RdataSet::create(mem_sgmt_, encoder_, rrset, rrsig,
                                           old_rdataset);
     old_rdataset = node->setData(rdataset);
@@ -305,6 +320,8 @@ ZoneDataUpdater::addRdataSet(const Name& name, const RRType& rrtype,
         // Create a new RdataSet, merging any existing data for this
         // type.
         RdataSet* old_rdataset = RdataSet::find(rdataset_head, rrtype, true);
+        // The dictionary may have moved if the segment has grown.
+        encoder_.setNameDictionary(zone_data_->getNameDictionary());
         RdataSet* rdataset_new = RdataSet::create(mem_sgmt_, encoder_,
                                                   rrset, rrsig, old_rdataset);
         if (old_rdataset == NULL) {
@@ -433,6 +450,136 @@ ZoneDataUpdater::add(const ConstRRsetPtr& rrset,
     } while (!added);
 }
 
+void
+ZoneDataUpdater::removeRdataSet(const Name& name, const RRType& rrtype,
+                                const ConstRRsetPtr& rrset,
+                                const ConstRRsetPtr& rrsig)
+{
+    NSEC3Data* nsec3_data = NULL;
+    ZoneNode* node = NULL;
+    if (rrtype == RRType::NSEC3()) {
+        nsec3_data = zone_data_->getNSEC3Data();
+        if (nsec3_data != NULL) {
+            node = nsec3_data->findName(name);
+        }
+    } else {
+        node = zone_data_->findName(name);
+    }
+    RdataSet* old_rdataset =
+        node ? RdataSet::find(node->getData(), rrtype, true) : NULL;
+    if (old_rdataset == NULL) {
+        return;                 // nothing to remove
+    }
+
+    // This is the only part that can throw (including the growth of
+    // the segment); the zone is intact until it succeeds.
+    encoder_.setNameDictionary(zone_data_->getNameDictionary());
+    RdataSet* rdataset_new = RdataSet::subtract(mem_sgmt_, encoder_, rrset,
+                                                rrsig, *old_rdataset);
+
+    // Replace the old RdataSet in the list with the new one, or unlink it
+    // if nothing is left, and destroy the old one.
+    zone_data_->clearNameIndex(mem_sgmt_);
+    for (RdataSet* cur = node->getData(), *prev = NULL;
+         cur != NULL;
+         prev = cur, cur = cur->getNext()) {
+        if (cur == old_rdataset) {
+            RdataSet* next = cur->getNext();
+            if (rdataset_new != NULL) {
+                rdataset_new->next = next;
+                next = rdataset_new;
+            }
+            if (prev == NULL) {
+                node->setData(next);
+            } else {
+                prev->next = next;
+            }
+            break;
+        }
+    }
+    RdataSet::destroy(mem_sgmt_, old_rdataset, rrclass_);
+
+    if (nsec3_data != NULL) {
+        if (node->isEmpty()) {
+            nsec3_data->removeName(mem_sgmt_, node);
+        }
+        return;
+    }
+
+    // Undo the zone cut mark if the (non RRSIG) NS or DNAME making it has
+    // gone.  See addRdataSet().
+    const bool is_origin = (node == zone_data_->getOriginNode());
+    if (rrtype == RRType::NS() || rrtype == RRType::DNAME()) {
+        const RdataSet* rdataset_head = node->getData();
+        node->setFlag(ZoneNode::FLAG_CALLBACK,
+                      (!is_origin &&
+                       RdataSet::find(rdataset_head, RRType::NS()) != NULL) ||
+                      RdataSet::find(rdataset_head, RRType::DNAME()) != NULL);
+    }
+
+    if (node->isEmpty() && !is_origin) {
+        zone_data_->removeName(mem_sgmt_, node);
+        // If it was the wildcard name of its parent, the parent is not
+        // a "wildcard level" anymore (the zone finder relies on the
+        // wildcard node to exist under a node marked as such).  Note that
+        // the node may remain (without data) if it has subdomains.
+        if (name.isWildcard() && zone_data_->findName(name) == NULL) {
+            ZoneNode* parent = zone_data_->findName(name.split(1));
+            if (parent != NULL) {
+                parent->setFlag(ZoneData::WILDCARD_NODE, false);
+            }
+        }
+    }
+}
+
+void
+ZoneDataUpdater::remove(const ConstRRsetPtr& rrset,
+                        const ConstRRsetPtr& sig_rrset)
+{
+    if (!rrset && !sig_rrset) {
+        isc_throw(NullRRset,
+                  "ZoneDataUpdater::remove is given 2 NULL pointers");
+    }
+
+    const Name& name = rrset ? rrset->getName() : sig_rrset->getName();
+    const RRType& rrtype = rrset ? rrset->getType() :
+        getCoveredType(sig_rrset);
+
+    LOG_DEBUG(logger, DBG_TRACE_DATA, DATASRC_MEMORY_MEM_REMOVE_RRSET).
+        arg(name).
+        arg(rrset ? rrtype.toText() : "RRSIG(" + rrtype.toText() + ")").
+        arg(zone_name_);
+
+    // As in add(), retry with the relocated zone data on growth of the
+    // segment; nothing is modified in that case.
+    bool removed = false;
+    do {
+        try {
+            removeRdataSet(name, rrtype, rrset, sig_rrset);
+            removed = true;
+        } catch (const isc::util::MemorySegmentGrown&) {
+            zone_data_ =
+                static_cast<ZoneData*>(
+                    mem_sgmt_.getNamedAddress("updater_zone_data").second);
+        }
+    } while (!removed);
+}
+
+void
+ZoneDataUpdater::buildNameIndex() {
+    while (true) {
+        try {
+            zone_data_->buildNameIndex(mem_sgmt_);
+            return;
+        } catch (const isc::util::MemorySegmentGrown&) {
+            // Nothing was built; retry with the relocated zone data.
+            zone_data_ =
+                static_cast<ZoneData*>(
+                    mem_sgmt_.getNamedAddress("updater_zone_data").second);
+        }
+    }
+}
+
 } // namespace memory
 } // namespace datasrc
 } // namespace isc
@@ -33,7 +33,8 @@ namespace memory {
 /// \brief A helper class to add records to a zone.
 ///
 /// This class provides an \c add() method that can be used to add
-/// RRsets to a ZoneData instance. The RRsets are first validated for
+/// RRsets to a ZoneData instance (and a \c remove() method to remove them
+/// again). The RRsets are first validated for
 /// correctness and consistency, and their data is made into RdataSets
 /// which are added to the ZoneData for the zone.
 ///
@@ -157,6 +158,40 @@ public:
     void add(const isc::dns::ConstRRsetPtr& rrset,
              const isc::dns::ConstRRsetPtr& sig_rrset);
 
+    /// \brief Remove an RRset from the zone.
+    ///
+    /// It removes the RDATAs of \c rrset and the RRSIGs of \c sig_rrset
+    /// from the zone, which is the reverse operation of \c add().  It's
+    /// intended to be used to apply differences of zone versions (e.g.,
+    /// those of an IXFR) to the zone data.  As with \c add(), at least one
+    /// of \c rrset or \c sig_rrset must be non NULL.
+    ///
+    /// The RDATAs and RRSIGs that don't exist in the zone are ignored.
+    /// When all the data of an owner name are removed, the name itself is
+    /// removed from the zone (unless it's the zone origin or has
+    /// subdomains), and so are the node flags that depended on the removed
+    /// data (such as the zone cut or the wildcard marks).
+    ///
+    /// \throw NullRRset Both \c rrset and sig_rrset is NULL
+    /// \throw isc::BadValue The given RRsets are inconsistent (e.g., the
+    /// type covered by the RRSIGs doesn't match the type of \c rrset).
+    ///
+    /// \param rrset The RRset to be removed.
+    /// \param sig_rrset An associated RRSIG RRset to be removed. It
+    ///                  can be empty.
+    void remove(const isc::dns::ConstRRsetPtr& rrset,
+                const isc::dns::ConstRRsetPtr& sig_rrset);
+
+    /// \brief Build the exact match name index of the zone.
+    ///
+    /// This is a wrapper of \c ZoneData::buildNameIndex() that handles
+    /// the growth of the memory segment.  It's expected to be called once
+    /// all RRsets are added; any subsequent call to \c add() drops the
+    /// index.
+    ///
+    /// \throw std::bad_alloc Memory allocation fails.
+    void buildNameIndex();
+
 private:
     // Add the necessary magic for any wildcard contained in 'name'
     // (including itself) to be found in the zone.
@@ -200,6 +235,10 @@ private:
                      const isc::dns::RRType& rrtype,
                      const isc::dns::ConstRRsetPtr& rrset,
                      const isc::dns::ConstRRsetPtr& rrsig);
+    void removeRdataSet(const isc::dns::Name& name,
+                        const isc::dns::RRType& rrtype,
+                        const isc::dns::ConstRRsetPtr& rrset,
+                        const isc::dns::ConstRRsetPtr& rrsig);
 
     util::MemorySegment& mem_sgmt_;
     const isc::dns::RRClass rrclass_;
@@ -408,6 +408,12 @@ public:
 // DomainTree::find() will result in EXACTMATCH or PARTIALMATCH (note that
 // the given name is generally expected to be contained in the zone, so
 // even if it doesn't exist, it should at least match the zone origin).
+//
+// If the zone has a name index, it's tried first: a hit means the tree
+// search would result in EXACTMATCH at a non-empty node without any zone
+// cut or DNAME above it, so we can return SUCCESS right away.  Note that
+// node_path isn't set in that case; the caller only needs it for empty
+// nodes, which are never indexed.
 // If it finds an exact match, that's obviously the best one.  The partial
 // match case is more complicated.
 //
@@ -469,6 +475,14 @@ FindNodeResult findNode(const ZoneData& zone_data,
                         ZoneFinder::FindOptions options,
                         bool out_of_zone_ok = false)
 {
+    const ZoneNameIndex* name_index = zone_data.getNameIndex();
+    if (name_index != NULL) {
+        const ZoneNode* node = name_index->find(name_labels);
+        if (node != NULL) {
+            return (FindNodeResult(ZoneFinder::SUCCESS, node, NULL));
+        }
+    }
+
     const ZoneNode* node = NULL;
     FindState state((options & ZoneFinder::FIND_GLUE_OK) != 0);
 
@@ -950,11 +964,9 @@ InMemoryZoneFinder::findNSEC3(const isc::dns::Name& name, bool recursive) {
                   origin_ls << "/" << getClass());
     }
 
-    const boost::scoped_ptr<NSEC3Hash> hash
-        (NSEC3Hash::create(nsec3_data->hashalg,
-                           nsec3_data->iterations,
-                           nsec3_data->getSaltData(),
-                           nsec3_data->getSaltLen()));
+    // The hash calculator is only created when a hash isn't in the cache.
+    boost::scoped_ptr<NSEC3Hash> hash;
+    std::string hlabel;
 
     // Examine all names from the query name to the origin name, stripping
     // the deepest label one by one, until we find a name that has a matching
@@ -962,7 +974,19 @@ InMemoryZoneFinder::findNSEC3(const isc::dns::Name& name, bool recursive) {
     for (unsigned int labels = qlabels; labels >= olabels;
          --labels, name_ls.stripLeft(1))
     {
-        const std::string hlabel = hash->calculate(name_ls);
+        if (nsec3_hash_cache_ == NULL ||
+            !nsec3_hash_cache_->find(*nsec3_data, name_ls, hlabel)) {
+            if (!hash) {
+                hash.reset(NSEC3Hash::create(nsec3_data->hashalg,
+                                             nsec3_data->iterations,
+                                             nsec3_data->getSaltData(),
+                                             nsec3_data->getSaltLen()));
+            }
+            hlabel = hash->calculate(name_ls);
+            if (nsec3_hash_cache_ != NULL) {
+                nsec3_hash_cache_->insert(*nsec3_data, name_ls, hlabel);
+            }
+        }
 
         LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_FINDNSEC3_TRYHASH).
             arg(name).arg(labels).arg(hlabel);
@@ -17,6 +17,7 @@
 
 #include <datasrc/memory/zone_data.h>
 #include <datasrc/memory/treenode_rrset.h>
+#include <datasrc/memory/nsec3_hash_cache.h>
 
 #include <datasrc/zone_finder.h>
 #include <dns/name.h>
@@ -48,10 +49,15 @@ public:
     ///
     /// \param zone_data The ZoneData containing the zone.
     /// \param rrclass The RR class of the zone
+    /// \param nsec3_hash_cache If non-NULL, \c findNSEC3() looks up the
+    /// NSEC3 hashes of names in this cache before calculating them, and
+    /// adds those it calculates.  It must be valid while the finder is used.
     InMemoryZoneFinder(const ZoneData& zone_data,
-                       const isc::dns::RRClass& rrclass) :
+                       const isc::dns::RRClass& rrclass,
+                       NSEC3HashCache* nsec3_hash_cache = NULL) :
         zone_data_(zone_data),
-        rrclass_(rrclass)
+        rrclass_(rrclass),
+        nsec3_hash_cache_(nsec3_hash_cache)
     {}
 
     /// \brief Find an RRset in the datasource
@@ -111,6 +117,7 @@ private:
 
     const ZoneData& zone_data_;
     const isc::dns::RRClass rrclass_;
+    NSEC3HashCache* const nsec3_hash_cache_;
 };
 
 } // namespace memory
@@ -18,6 +18,7 @@
 #include <datasrc/memory/zone_table_segment_local.h>
 #ifdef USE_SHARED_MEMORY
 #include <datasrc/memory/zone_table_segment_mapped.h>
+#include <datasrc/memory/zone_table_segment_mapped_zones.h>
 #endif
 #include <datasrc/memory/zone_writer.h>
 
@@ -39,6 +40,8 @@ ZoneTableSegment::create(const RRClass& rrclass, const std::string& type) {
 #ifdef USE_SHARED_MEMORY
     } else if (type == "mapped") {
         return (new ZoneTableSegmentMapped(rrclass));
+    } else if (type == "mapped-zones") {
+        return (new ZoneTableSegmentMappedZones(rrclass));
 #endif
     }
     isc_throw(UnknownSegmentType, "Zone table segment type not supported: "
@@ -50,6 +53,31 @@ ZoneTableSegment::destroy(ZoneTableSegment *segment) {
     delete segment;
 }
 
+isc::util::MemorySegment&
+ZoneTableSegment::getZoneSegment(const Name&) {
+    if (!isWritable()) {
+        isc_throw(isc::InvalidOperation,
+                  "getZoneSegment() called for a read-only segment");
+    }
+    return (getMemorySegment());
+}
+
+ZoneData*
+ZoneTableSegment::installZone(const Name& origin, ZoneData* zone_data) {
+    ZoneTable* table(getHeader().getTable());
+    if (!table) {
+        isc_throw(isc::Unexpected, "No zone table present");
+    }
+    const ZoneTable::AddResult result(
+        zone_data ? table->addZone(getMemorySegment(), origin, zone_data) :
+        table->addEmptyZone(getMemorySegment(), origin));
+    return (result.zone_data);
+}
+
+void
+ZoneTableSegment::finishZone(const Name&) {
+}
+
 } // namespace memory
 } // namespace datasrc
 } // namespace isc
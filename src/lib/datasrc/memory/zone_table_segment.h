@@ -175,6 +175,63 @@ public:
     /// exception-free.
     virtual bool isWritable() const = 0;
 
+    /// \brief Return the \c MemorySegment in which a new version of a
+    /// zone is to be built.
+    ///
+    /// This method, \c installZone() and \c finishZone() are used by
+    /// \c ZoneWriter to build and install a new version of the zone of
+    /// \c origin.  A \c ZoneWriter gets the segment on construction,
+    /// builds the \c ZoneData in it, installs it with \c installZone(),
+    /// and calls \c finishZone() when it's done, whether or not the new
+    /// version was installed.  There must be at most one such sequence
+    /// for a zone at a time.
+    ///
+    /// The default implementation returns \c getMemorySegment(), that is,
+    /// all zones are built in the single segment of the zone table.
+    /// Derived classes that keep each zone in a segment of its own can
+    /// override these methods.
+    ///
+    /// \throw isc::InvalidOperation the segment isn't writable.
+    ///
+    /// \param origin The origin name of the zone.
+    virtual isc::util::MemorySegment&
+    getZoneSegment(const isc::dns::Name& origin);
+
+    /// \brief Install a new version of a zone in the zone table.
+    ///
+    /// \c zone_data must have been built in the segment returned by
+    /// \c getZoneSegment() for the same origin.  If it's NULL, the zone
+    /// is installed as an empty zone (see \c ZoneTable::addEmptyZone()).
+    ///
+    /// It returns the old version of the zone data, which the caller
+    /// must destroy in the segment returned by \c getZoneSegment() once
+    /// it's not used any more.  The old version can be NULL, e.g., if the
+    /// zone didn't exist or was empty, or if the implementation releases
+    /// it in \c finishZone().
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown,
+    /// possibly relocating data.  The zone isn't installed; the caller
+    /// should retry with the relocated \c zone_data.
+    /// \throw isc::Unexpected There's no zone table in the segment.
+    ///
+    /// \param origin The origin name of the zone.
+    /// \param zone_data The new version of the zone data.
+    virtual ZoneData* installZone(const isc::dns::Name& origin,
+                                  ZoneData* zone_data);
+
+    /// \brief Finish building a new version of a zone.
+    ///
+    /// See \c getZoneSegment().  It's called after the old version of the
+    /// zone returned by \c installZone() (if any) has been destroyed, or
+    /// when the new version is given up without being installed.  It can
+    /// be called more than once; calls other than the first one for
+    /// \c getZoneSegment() are no-op.
+    ///
+    /// The default implementation does nothing.
+    ///
+    /// \param origin The origin name of the zone.
+    virtual void finishZone(const isc::dns::Name& origin);
+
     /// \brief Create an instance depending on the requested memory
     /// segment implementation type.
     ///
@@ -0,0 +1,546 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/zone_table_segment_mapped_zones.h>
+#include <datasrc/memory/zone_table.h>
+#include <datasrc/memory/zone_data.h>
+
+#include <util/buffer.h>
+
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace isc::data;
+using namespace isc::dns;
+using namespace isc::util;
+
+namespace isc {
+namespace datasrc {
+namespace memory {
+
+namespace { // unnamed namespace
+
+// The name with which the zone index is associated in the index file.
+const char* const ZONE_INDEX_NAME = "zone_index";
+
+// The name with which the zone data is associated in the file of a zone.
+const char* const ZONE_DATA_NAME = "zone_data";
+
+// The index is a single block of data in the index file:
+//
+// - The size of the block (uint32)
+// - The next version number to be used (uint32)
+// - The number of zones (uint32)
+// - For each zone, its version (uint32, 0 for empty zones) and the offset
+//   of its name from the beginning of the block (uint32)
+// - The names of the zones in wire format
+//
+// All numbers are in network byte order.
+const size_t INDEX_HEADER_SIZE = sizeof(uint32_t) * 3;
+const size_t INDEX_ENTRY_SIZE = sizeof(uint32_t) * 2;
+
+ZoneData*
+getZoneData(MemorySegment& segment) {
+    const MemorySegment::NamedAddressResult result =
+        segment.getNamedAddress(ZONE_DATA_NAME);
+    return (result.first ? static_cast<ZoneData*>(result.second) : NULL);
+}
+
+bool
+fileExists(const std::string& filename) {
+    struct stat st;
+    return (stat(filename.c_str(), &st) == 0);
+}
+
+} // end of unnamed namespace
+
+ZoneTableSegmentMappedZones::ZoneTableSegmentMappedZones(
+    const RRClass& rrclass) :
+    ZoneTableSegment(rrclass),
+    impl_type_("mapped-zones"),
+    rrclass_(rrclass),
+    next_version_(1),
+    index_changed_(false)
+{
+}
+
+ZoneTableSegmentMappedZones::~ZoneTableSegmentMappedZones() {
+    try {
+        clear();
+    } catch (const isc::Exception&) {
+        // We can't do much about it in the destructor; the index file
+        // is left as it was.
+    }
+}
+
+const std::string&
+ZoneTableSegmentMappedZones::getImplType() const {
+    return (impl_type_);
+}
+
+std::string
+ZoneTableSegmentMappedZones::getZoneFileName(uint32_t version) const {
+    return (current_filename_ + "." +
+            boost::lexical_cast<std::string>(version));
+}
+
+void
+ZoneTableSegmentMappedZones::readIndex(
+    const std::string& filename, bool must_exist,
+    std::vector<std::pair<Name, uint32_t> >& zones,
+    uint32_t& next_version) const
+{
+    if (!fileExists(filename)) {
+        if (must_exist) {
+            isc_throw(ResetFailed, "Error in resetting zone table segment to "
+                      "use " << filename << ": index file doesn't exist");
+        }
+        next_version = 1;
+        return;
+    }
+
+    try {
+        const MemorySegmentMapped segment(filename);
+        const MemorySegment::NamedAddressResult result =
+            segment.getNamedAddress(ZONE_INDEX_NAME);
+        if (!result.first) {
+            isc_throw(isc::BadValue, "no zone index in the file");
+        }
+        const uint8_t* const data = static_cast<const uint8_t*>(result.second);
+        InputBuffer size_buffer(data, sizeof(uint32_t));
+        InputBuffer buffer(data, size_buffer.readUint32());
+        buffer.setPosition(sizeof(uint32_t));
+        next_version = buffer.readUint32();
+        const uint32_t zone_count = buffer.readUint32();
+        for (uint32_t i = 0; i < zone_count; ++i) {
+            buffer.setPosition(INDEX_HEADER_SIZE + INDEX_ENTRY_SIZE * i);
+            const uint32_t version = buffer.readUint32();
+            buffer.setPosition(buffer.readUint32());
+            zones.push_back(std::pair<Name, uint32_t>(Name(buffer), version));
+        }
+    } catch (const isc::Exception& ex) {
+        isc_throw(ResetFailed, "Error in resetting zone table segment to use "
+                  << filename << ": broken index: " << ex.what());
+    }
+}
+
+void
+ZoneTableSegmentMappedZones::writeIndex() {
+    size_t names_length = 0;
+    BOOST_FOREACH(const ZoneVersions::value_type& zone, zones_) {
+        names_length += zone.first.getLength();
+    }
+    const size_t entries_length = INDEX_ENTRY_SIZE * zones_.size();
+    OutputBuffer buffer(INDEX_HEADER_SIZE + entries_length + names_length);
+    buffer.writeUint32(INDEX_HEADER_SIZE + entries_length + names_length);
+    buffer.writeUint32(next_version_);
+    buffer.writeUint32(zones_.size());
+    size_t name_offset = INDEX_HEADER_SIZE + entries_length;
+    BOOST_FOREACH(const ZoneVersions::value_type& zone, zones_) {
+        buffer.writeUint32(zone.second.version);
+        buffer.writeUint32(name_offset);
+        name_offset += zone.first.getLength();
+    }
+    BOOST_FOREACH(const ZoneVersions::value_type& zone, zones_) {
+        zone.first.toWire(buffer);
+    }
+
+    // Write the new index in a temporary file first and rename it over
+    // the current one, so readers always see one complete version of it.
+    const std::string tmp_filename = current_filename_ + ".tmp";
+    {
+        MemorySegmentMapped segment(
+            tmp_filename, MemorySegmentMapped::CREATE_ONLY,
+            std::max(static_cast<size_t>(MemorySegmentMapped::INITIAL_SIZE),
+                     buffer.getLength() * 2));
+        void* ptr = NULL;
+        while (!ptr) {
+            try {
+                ptr = segment.allocate(buffer.getLength());
+            } catch (const MemorySegmentGrown&) {
+                // Do nothing and try again.
+            }
+        }
+        std::memcpy(ptr, buffer.getData(), buffer.getLength());
+        // The named address is kept valid even if the segment grows.
+        segment.setNamedAddress(ZONE_INDEX_NAME, ptr);
+        segment.shrinkToFit();
+    }
+    if (std::rename(tmp_filename.c_str(), current_filename_.c_str()) != 0) {
+        const int error = errno;
+        unlink(tmp_filename.c_str());
+        isc_throw(isc::Unexpected, "Failed to update zone index "
+                  << current_filename_ << ": " << std::strerror(error));
+    }
+    index_changed_ = false;
+}
+
+ZoneTableSegmentMappedZones::ZoneVersions
+ZoneTableSegmentMappedZones::mapZones(
+    const std::vector<std::pair<Name, uint32_t> >& zones,
+    bool same_file) const
+{
+    ZoneVersions versions;
+    for (size_t i = 0; i < zones.size(); ++i) {
+        const Name& name = zones[i].first;
+        const uint32_t version = zones[i].second;
+        const ZoneVersions::const_iterator current = zones_.find(name);
+        if (version == 0 ||
+            (same_file && current != zones_.end() &&
+             current->second.version == version)) {
+            // Empty zones have nothing to map, and we keep using the
+            // versions we already have.
+            versions[name] = version == 0 ? ZoneVersion() : current->second;
+            continue;
+        }
+        const std::string filename = getZoneFileName(version);
+        try {
+            const SegmentPtr segment(new MemorySegmentMapped(filename));
+            if (!getZoneData(*segment)) {
+                isc_throw(ResetFailed, "no zone data in the file");
+            }
+            versions[name] = ZoneVersion(version, segment);
+        } catch (const isc::Exception& ex) {
+            isc_throw(ResetFailed, "Error in resetting zone table segment "
+                      "to use " << filename << " for zone " << name << ": "
+                      << ex.what());
+        }
+    }
+    return (versions);
+}
+
+ZoneTable*
+ZoneTableSegmentMappedZones::createTable(const ZoneVersions& zones) {
+    ZoneTable* table = ZoneTable::create(table_sgmt_, rrclass_);
+    BOOST_FOREACH(const ZoneVersions::value_type& zone, zones) {
+        if (zone.second.segment) {
+            table->addZone(table_sgmt_, zone.first,
+                           getZoneData(*zone.second.segment));
+        } else {
+            table->addEmptyZone(table_sgmt_, zone.first);
+        }
+    }
+    return (table);
+}
+
+void
+ZoneTableSegmentMappedZones::destroyTable() {
+    if (!header_) {
+        return;
+    }
+    // The zone data belong to the mapped files, so we replace them with
+    // empty zones before destroying the table, which would otherwise try
+    // to destroy them too.
+    ZoneTable* table = header_->getTable();
+    BOOST_FOREACH(const ZoneVersions::value_type& zone, zones_) {
+        table->addEmptyZone(table_sgmt_, zone.first);
+    }
+    ZoneTable::destroy(table_sgmt_, table);
+    header_.reset();
+}
+
+void
+ZoneTableSegmentMappedZones::restoreZone(const Name& origin) {
+    const ZoneVersions::const_iterator current = zones_.find(origin);
+    ZoneTable* table = header_->getTable();
+    if (current != zones_.end() && current->second.segment) {
+        table->addZone(table_sgmt_, origin,
+                       getZoneData(*current->second.segment));
+    } else {
+        table->addEmptyZone(table_sgmt_, origin);
+    }
+}
+
+void
+ZoneTableSegmentMappedZones::replaceZone(const Name& origin,
+                                         const ZoneVersion& zone)
+{
+    ZoneVersion& current = zones_[origin];
+    if (current.version != 0) {
+        obsolete_files_.push_back(getZoneFileName(current.version));
+    }
+    current = zone;
+    index_changed_ = true;
+}
+
+void
+ZoneTableSegmentMappedZones::discardPendingZones() {
+    BOOST_FOREACH(const PendingZones::value_type& pending, pending_zones_) {
+        if (pending.second.installed) {
+            restoreZone(pending.first);
+        }
+        unlink(getZoneFileName(pending.second.zone.version).c_str());
+    }
+    pending_zones_.clear();
+}
+
+void
+ZoneTableSegmentMappedZones::removeObsoleteFiles() {
+    BOOST_FOREACH(const std::string& filename, obsolete_files_) {
+        unlink(filename.c_str());
+    }
+    obsolete_files_.clear();
+}
+
+void
+ZoneTableSegmentMappedZones::sync() {
+    if (isWritable() && index_changed_) {
+        writeIndex();
+    }
+}
+
+void
+ZoneTableSegmentMappedZones::reset(MemorySegmentOpenMode mode,
+                                   isc::data::ConstElementPtr params)
+{
+    if (!params || params->getType() != Element::map) {
+        isc_throw(isc::InvalidParameter,
+                  "Configuration does not contain a map");
+    }
+
+    if (!params->contains("mapped-file")) {
+        isc_throw(isc::InvalidParameter,
+                  "Configuration does not contain a \"mapped-file\" key");
+    }
+
+    ConstElementPtr mapped_file = params->get("mapped-file");
+    if ((!mapped_file) || (mapped_file->getType() != Element::string)) {
+        isc_throw(isc::InvalidParameter,
+                  "Value of \"mapped-file\" is not a string");
+    }
+
+    if (mode != CREATE && mode != READ_WRITE && mode != READ_ONLY) {
+        isc_throw(isc::InvalidParameter,
+                  "Invalid MemorySegmentOpenMode passed to reset()");
+    }
+
+    const std::string filename = mapped_file->stringValue();
+
+    // Give up any zone still being built, and save the index if we are
+    // the writer, so we (and others) can see the current zones below.
+    if (isUsable()) {
+        discardPendingZones();
+        sync();
+    }
+
+    // If we keep using the same index, we only need to map the zones
+    // that have changed.
+    const bool incremental =
+        isUsable() && mode != CREATE && filename == current_filename_;
+
+    // Map the zones first, so we still have the current state intact
+    // if it fails.
+    std::vector<std::pair<Name, uint32_t> > index;
+    uint32_t next_version = 1;
+    const bool has_index = (mode != CREATE) && fileExists(filename);
+    if (mode != CREATE) {
+        readIndex(filename, mode == READ_ONLY, index, next_version);
+    }
+    const std::string old_filename = current_filename_;
+    current_filename_ = filename; // used in getZoneFileName()
+    ZoneVersions zones;
+    try {
+        zones = mapZones(index, incremental);
+    } catch (...) {
+        current_filename_ = old_filename;
+        throw;
+    }
+
+    if (incremental) {
+        // Replace the zones in the current table that have changed.
+        ZoneTable* table = header_->getTable();
+        BOOST_FOREACH(const ZoneVersions::value_type& zone, zones) {
+            const ZoneVersions::const_iterator current =
+                zones_.find(zone.first);
+            if (current != zones_.end() &&
+                current->second.version == zone.second.version) {
+                continue;
+            }
+            if (zone.second.segment) {
+                table->addZone(table_sgmt_, zone.first,
+                               getZoneData(*zone.second.segment));
+            } else {
+                table->addEmptyZone(table_sgmt_, zone.first);
+            }
+        }
+        BOOST_FOREACH(const ZoneVersions::value_type& zone, zones_) {
+            if (zones.find(zone.first) == zones.end()) {
+                table->addEmptyZone(table_sgmt_, zone.first);
+            }
+        }
+    } else {
+        destroyTable();
+        header_.reset(new ZoneTableHeader(createTable(zones)));
+    }
+    // This releases the mappings of the zones we don't use any more.
+    zones_.swap(zones);
+
+    current_mode_ = mode;
+    next_version_ = next_version;
+    // A new index must be written even if it's empty.
+    index_changed_ = (mode != READ_ONLY) && !has_index;
+    if (mode != READ_ONLY) {
+        removeObsoleteFiles();
+    }
+}
+
+void
+ZoneTableSegmentMappedZones::clear() {
+    if (isUsable()) {
+        discardPendingZones();
+        sync();
+        destroyTable();
+        zones_.clear();
+    }
+}
+
+ZoneTableHeader&
+ZoneTableSegmentMappedZones::getHeader() {
+    if (!isUsable()) {
+        isc_throw(isc::InvalidOperation,
+                  "getHeader() called without calling reset() first");
+    }
+    return (*header_);
+}
+
+const ZoneTableHeader&
+ZoneTableSegmentMappedZones::getHeader() const {
+    if (!isUsable()) {
+        isc_throw(isc::InvalidOperation,
+                  "getHeader() called without calling reset() first");
+    }
+    return (*header_);
+}
+
+MemorySegment&
+ZoneTableSegmentMappedZones::getMemorySegment() {
+    if (!isUsable()) {
+        isc_throw(isc::InvalidOperation,
+                  "getMemorySegment() called without calling reset() first");
+    }
+    return (table_sgmt_);
+}
+
+bool
+ZoneTableSegmentMappedZones::isUsable() const {
+    return (header_);
+}
+
+bool
+ZoneTableSegmentMappedZones::isWritable() const {
+    return (isUsable() &&
+            ((current_mode_ == CREATE) || (current_mode_ == READ_WRITE)));
+}
+
+MemorySegment&
+ZoneTableSegmentMappedZones::getZoneSegment(const Name& origin) {
+    if (!isWritable()) {
+        isc_throw(isc::InvalidOperation,
+                  "getZoneSegment() called for a read-only segment");
+    }
+    if (pending_zones_.find(origin) != pending_zones_.end()) {
+        isc_throw(isc::InvalidOperation, "A new version of zone " << origin
+                  << " is already being built");
+    }
+
+    const uint32_t version = next_version_;
+    const SegmentPtr segment(
+        new MemorySegmentMapped(getZoneFileName(version),
+                                MemorySegmentMapped::CREATE_ONLY));
+    ++next_version_;
+    index_changed_ = true;
+    pending_zones_[origin].zone = ZoneVersion(version, segment);
+    return (*segment);
+}
+
+ZoneData*
+ZoneTableSegmentMappedZones::installZone(const Name& origin,
+                                         ZoneData* zone_data)
+{
+    const PendingZones::iterator pending = pending_zones_.find(origin);
+    if (pending == pending_zones_.end()) {
+        isc_throw(isc::InvalidOperation, "installZone() called for zone "
+                  << origin << " without getZoneSegment()");
+    }
+
+    if (zone_data) {
+        if (pending->second.zone.segment->setNamedAddress(ZONE_DATA_NAME,
+                                                          zone_data)) {
+            // zone_data has been relocated; the caller has to retry.
+            isc_throw(MemorySegmentGrown,
+                      "Segment grown when installing zone " << origin);
+        }
+        header_->getTable()->addZone(table_sgmt_, origin, zone_data);
+    } else {
+        header_->getTable()->addEmptyZone(table_sgmt_, origin);
+    }
+    pending->second.installed = true;
+    pending->second.empty = !zone_data;
+
+    // The old version is released in finishZone().
+    return (NULL);
+}
+
+void
+ZoneTableSegmentMappedZones::finishZone(const Name& origin) {
+    const PendingZones::iterator it = pending_zones_.find(origin);
+    if (it == pending_zones_.end()) {
+        return;
+    }
+    PendingZone pending = it->second;
+    pending_zones_.erase(it);
+
+    const std::string filename = getZoneFileName(pending.zone.version);
+    if (!pending.installed || pending.empty) {
+        pending.zone.segment.reset();
+        unlink(filename.c_str());
+        if (pending.installed) {
+            replaceZone(origin, ZoneVersion());
+        }
+        return;
+    }
+
+    // Make the new version read-only: shrink it, close it and map it
+    // again in the read-only mode.  The table must not refer to the zone
+    // data while the file isn't mapped (even replacing an entry looks
+    // at the old data), so we keep the segment until we are done.
+    SegmentPtr segment;
+    try {
+        header_->getTable()->addEmptyZone(table_sgmt_, origin);
+        pending.zone.segment->shrinkToFit();
+        pending.zone.segment.reset();
+        segment.reset(new MemorySegmentMapped(filename));
+        header_->getTable()->addZone(table_sgmt_, origin,
+                                     getZoneData(*segment));
+        replaceZone(origin, ZoneVersion(pending.zone.version, segment));
+    } catch (...) {
+        restoreZone(origin);
+        segment.reset();
+        pending.zone.segment.reset();
+        unlink(filename.c_str());
+        throw;
+    }
+}
+
+} // namespace memory
+} // namespace datasrc
+} // namespace isc
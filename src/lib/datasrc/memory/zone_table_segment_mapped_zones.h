@@ -0,0 +1,238 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef ZONE_TABLE_SEGMENT_MAPPED_ZONES_H
+#define ZONE_TABLE_SEGMENT_MAPPED_ZONES_H
+
+#include <datasrc/memory/zone_table_segment.h>
+#include <util/memory_segment_local.h>
+#include <util/memory_segment_mapped.h>
+
+#include <dns/name.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace datasrc {
+namespace memory {
+
+/// \brief Mapped-file based implementation of \c ZoneTableSegment class
+/// with a separate mapped file for each zone.
+///
+/// Unlike \c ZoneTableSegmentMapped, which keeps the zone table and all
+/// zones in a single mapped file, this implementation keeps each version
+/// of each zone in a mapped file of its own, and a small mapped index
+/// file that lists the current version of the zones.  A new version of a
+/// zone is built in a new file, and the index is replaced atomically
+/// (by renaming a new file over it) when the writer is done.  Files of
+/// a zone version are never modified once the version is installed, so
+/// any number of readers can map and share them while the writer
+/// prepares newer versions of other (or the same) zones.
+///
+/// Readers that \c reset() the segment to the same index file again
+/// only map the zone files that have changed since the last \c reset(),
+/// and replace the corresponding zones in the table.  The zone table
+/// itself lives in local memory of the process, and points to the zone
+/// data in the mapped files.
+///
+/// Files of zone versions replaced by the writer are removed the next
+/// time the writer resets the segment to a writable mode; it's up to
+/// the user to make sure all readers have moved to newer versions by
+/// then.
+class ZoneTableSegmentMappedZones : public ZoneTableSegment {
+    // This is so that \c ZoneTableSegmentMappedZones can be instantiated
+    // from \c ZoneTableSegment::create().
+    friend class ZoneTableSegment;
+
+protected:
+    /// \brief Protected constructor
+    ///
+    /// Instances are expected to be created by the factory method
+    /// (\c ZoneTableSegment::create()), so this constructor is
+    /// protected.
+    ZoneTableSegmentMappedZones(const isc::dns::RRClass& rrclass);
+
+public:
+    /// \brief Destructor
+    virtual ~ZoneTableSegmentMappedZones();
+
+    /// \brief Returns "mapped-zones" as the implementation type.
+    virtual const std::string& getImplType() const;
+
+    /// \brief Return the \c ZoneTableHeader for this zone table segment.
+    ///
+    /// \throws isc::InvalidOperation if this method is called without a
+    /// successful \c reset() call first.
+    virtual ZoneTableHeader& getHeader();
+
+    /// \brief const version of \c getHeader().
+    virtual const ZoneTableHeader& getHeader() const;
+
+    /// \brief Return the \c MemorySegment of the zone table.
+    ///
+    /// This is a local memory segment; the zone data are in the segments
+    /// returned by \c getZoneSegment().
+    ///
+    /// \throws isc::InvalidOperation if this method is called without a
+    /// successful \c reset() call first.
+    virtual isc::util::MemorySegment& getMemorySegment();
+
+    /// \brief Returns if the segment is writable.
+    ///
+    /// Segments successfully opened in CREATE or READ_WRITE modes are
+    /// writable. Segments opened in READ_ONLY mode are not writable.
+    virtual bool isWritable() const;
+
+    /// \brief Return a new mapped segment for a new version of a zone.
+    ///
+    /// The segment is a new mapped file, which becomes the file of the
+    /// zone in \c finishZone() if the zone is installed, and is removed
+    /// otherwise.
+    ///
+    /// \throws isc::InvalidOperation the segment isn't writable, or
+    /// there's already a new version of the zone being built.
+    virtual isc::util::MemorySegment&
+    getZoneSegment(const isc::dns::Name& origin);
+
+    /// \brief Install a new version of a zone in the zone table.
+    ///
+    /// The old version isn't returned; it's released with its mapped
+    /// file in \c finishZone().
+    ///
+    /// \throws isc::InvalidOperation \c getZoneSegment() wasn't called
+    /// for the zone.
+    virtual ZoneData* installZone(const isc::dns::Name& origin,
+                                  ZoneData* zone_data);
+
+    /// \brief Finish building a new version of a zone.
+    ///
+    /// If the new version was installed, its file is remapped read-only
+    /// and it replaces the old version, whose file is released.  The
+    /// index file is updated when the segment is reset or cleared next
+    /// time.
+    virtual void finishZone(const isc::dns::Name& origin);
+
+    /// \brief Close the current segment (if open) and open the requested
+    /// one.
+    ///
+    /// \c params should be a map containing a "mapped-file" key that
+    /// points to a string value containing the filename of the mapped
+    /// index file.  Files of the zones are named after it, with a
+    /// version number appended.  E.g.,
+    ///
+    ///  {"mapped-file": "/var/bind10/mapped-files/zone-sqlite3.mapped"}
+    ///
+    /// In the CREATE mode the existing index is ignored (and overwritten
+    /// when the segment is synchronized).  In the READ_WRITE and
+    /// READ_ONLY modes the zones listed in the index are mapped; if the
+    /// index doesn't exist, the zone table is empty in the READ_WRITE
+    /// mode, and \c ResetFailed is thrown in the READ_ONLY mode.
+    ///
+    /// If the segment is reset to the index file it currently uses, the
+    /// zones whose version hasn't changed are kept mapped as they are.
+    ///
+    /// Please see the \c ZoneTableSegment API documentation for the
+    /// behavior in case of exceptions.
+    ///
+    /// \param mode The open mode (see the \c MemorySegmentOpenMode
+    /// documentation in \c ZoneTableSegment class).
+    /// \param params An element containing config for the mapped files
+    /// (see the description).
+    virtual void reset(MemorySegmentOpenMode mode,
+                       isc::data::ConstElementPtr params);
+
+    /// \brief Close the currently configured segment (if open).
+    ///
+    /// If the segment is writable, the index file is updated first.
+    virtual void clear();
+
+    /// \brief Return true if the segment is usable.
+    ///
+    /// See the base class for the description.
+    virtual bool isUsable() const;
+
+private:
+    typedef boost::shared_ptr<isc::util::MemorySegmentMapped> SegmentPtr;
+
+    // A version of a zone, and the segment of it.  Version 0 means an
+    // empty zone, which doesn't have a segment.
+    struct ZoneVersion {
+        ZoneVersion() : version(0) {}
+        ZoneVersion(uint32_t version_param, SegmentPtr segment_param) :
+            version(version_param), segment(segment_param)
+        {}
+        uint32_t version;
+        SegmentPtr segment;
+    };
+    typedef std::map<isc::dns::Name, ZoneVersion> ZoneVersions;
+
+    // A new version of a zone being built.
+    struct PendingZone {
+        PendingZone() : installed(false), empty(false) {}
+        ZoneVersion zone;
+        bool installed;
+        bool empty;
+    };
+    typedef std::map<isc::dns::Name, PendingZone> PendingZones;
+
+    std::string getZoneFileName(uint32_t version) const;
+    void readIndex(const std::string& filename, bool must_exist,
+                   std::vector<std::pair<isc::dns::Name, uint32_t> >& zones,
+                   uint32_t& next_version) const;
+    void writeIndex();
+    ZoneVersions mapZones(
+        const std::vector<std::pair<isc::dns::Name, uint32_t> >& zones,
+        bool same_file) const;
+    ZoneTable* createTable(const ZoneVersions& zones);
+    void destroyTable();
+    void restoreZone(const isc::dns::Name& origin);
+    void replaceZone(const isc::dns::Name& origin, const ZoneVersion& zone);
+    void discardPendingZones();
+    void removeObsoleteFiles();
+    void sync();
+
+private:
+    std::string impl_type_;
+    isc::dns::RRClass rrclass_;
+    MemorySegmentOpenMode current_mode_;
+    std::string current_filename_;
+    // The segment of the zone table (and nothing else).
+    isc::util::MemorySegmentLocal table_sgmt_;
+    // This is NULL until reset() succeeds.
+    boost::scoped_ptr<ZoneTableHeader> header_;
+    ZoneVersions zones_;
+    PendingZones pending_zones_;
+    uint32_t next_version_;
+    // True if zones_ has changed since the index was written (writer only).
+    bool index_changed_;
+    // Zone files that were replaced by the writer, to be removed later.
+    std::vector<std::string> obsolete_files_;
+};
+
+} // namespace memory
+} // namespace datasrc
+} // namespace isc
+
+#endif // ZONE_TABLE_SEGMENT_MAPPED_ZONES_H
+
+// Local Variables:
+// mode: c++
+// End:
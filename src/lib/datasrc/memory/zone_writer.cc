@@ -16,6 +16,7 @@
 #include <datasrc/memory/zone_data.h>
 #include <datasrc/memory/zone_table_segment.h>
 #include <datasrc/memory/segment_object_holder.h>
+#include <datasrc/memory/logger.h>
 
 #include <boost/scoped_ptr.hpp>
 
@@ -43,11 +44,13 @@ checkZoneTableSegment(ZoneTableSegment& segment) {
 struct ZoneWriter::Impl {
     Impl(ZoneTableSegment& segment, const LoadAction& load_action,
          const dns::Name& origin, const dns::RRClass& rrclass,
-         bool throw_on_load_error) :
+         bool throw_on_load_error, const UpdateAction& update_action) :
         // We validate segment first so we can use it to initialize
         // data_holder_ safely.
         segment_(checkZoneTableSegment(segment)),
+        zone_sgmt_(segment.getZoneSegment(origin)),
         load_action_(load_action),
+        update_action_(update_action),
         origin_(origin),
         rrclass_(rrclass),
         state_(ZW_UNUSED),
@@ -56,14 +59,43 @@ struct ZoneWriter::Impl {
         while (true) {
             try {
                 data_holder_.reset(
-                    new ZoneDataHolder(segment.getMemorySegment(), rrclass_));
+                    new ZoneDataHolder(zone_sgmt_, rrclass_));
                 break;
             } catch (const isc::util::MemorySegmentGrown&) {}
         }
     }
 
+    // Try to create the new version of the zone from the current one
+    // with update_action_.  Return NULL if it's not possible for whatever
+    // reason; the zone should then be loaded from scratch.
+    ZoneData* update() {
+        if (update_action_.empty()) {
+            return (NULL);
+        }
+        const ZoneTable* table = segment_.getHeader().getTable();
+        if (!table) {
+            return (NULL);
+        }
+        const ZoneTable::FindResult result(table->findZone(origin_));
+        if (result.code != result::SUCCESS || !result.zone_data) {
+            return (NULL);      // no zone or an empty zone
+        }
+        try {
+            return (update_action_(zone_sgmt_, *result.zone_data));
+        } catch (const isc::Exception& ex) {
+            LOG_WARN(logger, DATASRC_MEMORY_MEM_UPDATE_FAILED).
+                arg(origin_).arg(rrclass_).arg(ex.what());
+            return (NULL);
+        }
+    }
+
     ZoneTableSegment& segment_;
+    // The segment in which the new version of the zone is built.  It's
+    // the same as the memory segment of segment_ unless each zone has its
+    // own segment.
+    isc::util::MemorySegment& zone_sgmt_;
     const LoadAction load_action_;
+    const UpdateAction update_action_;
     const dns::Name origin_;
     const dns::RRClass rrclass_;
     enum State {
@@ -82,8 +114,10 @@ ZoneWriter::ZoneWriter(ZoneTableSegment& segment,
                        const LoadAction& load_action,
                        const dns::Name& origin,
                        const dns::RRClass& rrclass,
-                       bool throw_on_load_error) :
-    impl_(new Impl(segment, load_action, origin, rrclass, throw_on_load_error))
+                       bool throw_on_load_error,
+                       const UpdateAction& update_action) :
+    impl_(new Impl(segment, load_action, origin, rrclass, throw_on_load_error,
+                   update_action))
 {
 }
 
@@ -101,8 +135,10 @@ ZoneWriter::load(std::string* error_msg) {
     }
 
     try {
-        ZoneData* zone_data =
-            impl_->load_action_(impl_->segment_.getMemorySegment());
+        ZoneData* zone_data = impl_->update();
+        if (!zone_data) {
+            zone_data = impl_->load_action_(impl_->zone_sgmt_);
+        }
 
         if (!zone_data) {
             // Bug inside impl_->load_action_.
@@ -136,23 +172,15 @@ ZoneWriter::install() {
 
     while (impl_->state_ != Impl::ZW_INSTALLED) {
         try {
-            ZoneTableHeader& header = impl_->segment_.getHeader();
-            ZoneTable* table(header.getTable());
-            if (!table) {
-                isc_throw(isc::Unexpected, "No zone table present");
-            }
             // We still need to hold the zone data until we return from
-            // addZone in case it throws, but we then need to immediately
+            // installZone in case it throws, but we then need to immediately
             // release it as the ownership is transferred to the zone table.
             // we release this by (re)set it to the old data; that way we can
             // use the holder for the final cleanup.
-            const ZoneTable::AddResult result(
-                impl_->data_holder_->get() ?
-                table->addZone(impl_->segment_.getMemorySegment(),
-                               impl_->origin_, impl_->data_holder_->get()) :
-                table->addEmptyZone(impl_->segment_.getMemorySegment(),
-                                    impl_->origin_));
-            impl_->data_holder_->set(result.zone_data);
+            ZoneData* old_data =
+                impl_->segment_.installZone(impl_->origin_,
+                                            impl_->data_holder_->get());
+            impl_->data_holder_->set(old_data);
             impl_->state_ = Impl::ZW_INSTALLED;
         } catch (const isc::util::MemorySegmentGrown&) {}
     }
@@ -164,10 +192,10 @@ ZoneWriter::cleanup() {
 
     ZoneData* zone_data = impl_->data_holder_->release();
     if (zone_data) {
-        ZoneData::destroy(impl_->segment_.getMemorySegment(), zone_data,
-                          impl_->rrclass_);
+        ZoneData::destroy(impl_->zone_sgmt_, zone_data, impl_->rrclass_);
         impl_->state_ = Impl::ZW_CLEANED;
     }
+    impl_->segment_.finishZone(impl_->origin_);
 }
 
 }
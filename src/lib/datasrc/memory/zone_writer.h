@@ -53,6 +53,11 @@ public:
     /// so the zone table recognizes the existence of the zone (and being
     /// aware that it's broken).
     ///
+    /// If \c update_action is given (non empty), the \c load() method first
+    /// tries to create the new version of the zone with it from the zone
+    /// data currently in the table, if any, and uses \c load_action only if
+    /// that doesn't work.
+    ///
     /// \throw isc::InvalidOperation if \c segment is read-only.
     ///
     /// \param segment The zone table segment to store the zone into.
@@ -61,9 +66,12 @@ public:
     /// \param rrclass The class of the zone.
     /// \param catch_load_error true if loading errors are to be caught
     /// internally; false otherwise.
+    /// \param update_action The callback used to create the new version
+    /// of the zone from the current one (optional).
     ZoneWriter(ZoneTableSegment& segment,
                const LoadAction& load_action, const dns::Name& name,
-               const dns::RRClass& rrclass, bool catch_load_error);
+               const dns::RRClass& rrclass, bool catch_load_error,
+               const UpdateAction& update_action = UpdateAction());
 
     /// \brief Destructor.
     ~ZoneWriter();
@@ -83,6 +91,9 @@ public:
     /// for the error in case a load error happens.  In other cases any
     /// passed non NULL error_msg will be intact.
     ///
+    /// Any error of the update action (see the constructor) is logged
+    /// and ignored; the zone is then loaded with the load action.
+    ///
     /// \note As this contains reading of files or other data sources, or with
     ///     some other source of the data to load, it may throw quite anything.
     ///     If it throws, do not call any other methods on the object and
@@ -254,6 +254,32 @@ TEST_F(CacheConfigTest, badConstructWithMock) {
                  isc::InvalidParameter);
 }
 
+TEST_F(CacheConfigTest, compactZones) {
+    // Zones aren't compact by default.
+    const CacheConfig cache_conf("mock", &mock_client_, *mock_config_, true);
+    EXPECT_FALSE(cache_conf.isCompactZone(Name(".")));
+
+    const CacheConfig cache_conf2(
+        "mock", &mock_client_,
+        *Element::fromJSON("{\"cache-enable\": true,"
+                           " \"cache-zones\": [\"example.com\","
+                           "                   \"example.org\"],"
+                           " \"cache-compact-zones\": [\"EXAMPLE.org\"]}"),
+        true);
+    EXPECT_FALSE(cache_conf2.isCompactZone(Name("example.com")));
+    EXPECT_TRUE(cache_conf2.isCompactZone(Name("example.org")));
+
+    // A compact zone must be cached.
+    EXPECT_THROW(CacheConfig("mock", &mock_client_,
+                             *Element::fromJSON(
+                                 "{\"cache-enable\": true,"
+                                 " \"cache-zones\": [\"example.com\"],"
+                                 " \"cache-compact-zones\":"
+                                 "     [\"example.org\"]}"),
+                             true),
+                 CacheConfigError);
+}
+
 TEST_F(CacheConfigTest, getLoadActionWithMock) {
     uint8_t labels_buf[LabelSequence::MAX_SERIALIZED_LENGTH];
 
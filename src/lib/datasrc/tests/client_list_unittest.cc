@@ -1250,6 +1250,36 @@ TEST_P(ListTest, reloadNewZone) {
               doReload(Name("example.com")));
 }
 
+// The underlying data source is asked for the current version of the zone
+// (for updating the cached one with the differences) only when a version
+// of the zone is already cached.
+TEST_P(ListTest, cachedZoneWriterUpdateLookup) {
+    const ConstElementPtr elem(Element::fromJSON("["
+        "{"
+        "   \"type\": \"test_type\","
+        "   \"cache-enable\": true,"
+        "   \"cache-zones\": [\"example.org\", \"example.com\"],"
+        "   \"params\": [\"example.org\"]"
+        "}]"));
+    list_->configure(elem, true);
+    MockDataSourceClient* client = static_cast<MockDataSourceClient*>(
+        list_->getDataSources()[0].data_src_client_);
+    ASSERT_TRUE(client->insertZone(Name("example.com")));
+
+    // example.com isn't cached yet.  The zone is only looked up for
+    // checking its existence and for creating the zone iterator.
+    size_t count = client->getFindZoneCount();
+    EXPECT_EQ(ConfigurableClientList::ZONE_SUCCESS,
+              list_->getCachedZoneWriter(Name("example.com"), false).first);
+    EXPECT_EQ(count + 2, client->getFindZoneCount());
+
+    // example.org is cached, so the current version is also looked up.
+    count = client->getFindZoneCount();
+    EXPECT_EQ(ConfigurableClientList::ZONE_SUCCESS,
+              list_->getCachedZoneWriter(Name("example.org"), false).first);
+    EXPECT_EQ(count + 3, client->getFindZoneCount());
+}
+
 // The underlying data source throws. Check we don't modify the state.
 TEST_P(ListTest, reloadZoneThrow) {
     list_->configure(config_elem_zones_, true);
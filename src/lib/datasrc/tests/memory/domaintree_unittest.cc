@@ -811,6 +811,48 @@ TEST_F(DomainTreeTest, findName) {
     EXPECT_EQ(Name("q"), cdtnode->getName());
 }
 
+// find() uses the first characters of the labels to skip full comparisons
+// in many cases.  Check that it doesn't affect the results, especially for
+// labels that have the same first characters, differ only in the case,
+// are shorter than the key, or contain zero bytes.
+TEST_F(DomainTreeTest, findNameLabelKey) {
+    TreeHolder tree_holder(mem_sgmt_, TestDomainTree::create(mem_sgmt_));
+    TestDomainTree& tree(*tree_holder.get());
+    const char* const names[] = {
+        "example", "examples", "exam", "ex", "e", "example2", "EXAMPLF",
+        "ex\\000", "ex\\000a", "ex\\000\\000a", "a.zzzz", "b.zzzz",
+        "c.b.zzzz", "zzzy", "zzzza", NULL
+    };
+    for (size_t i = 0; names[i] != NULL; ++i) {
+        EXPECT_EQ(TestDomainTree::SUCCESS,
+                  tree.insert(mem_sgmt_, Name(names[i]), &dtnode));
+        dtnode->setData(new int(i));
+    }
+    for (size_t i = 0; names[i] != NULL; ++i) {
+        SCOPED_TRACE(names[i]);
+        EXPECT_EQ(TestDomainTree::EXACTMATCH,
+                  tree.find(Name(names[i]), &cdtnode));
+        EXPECT_EQ(Name(names[i]).toText(),
+                  cdtnode->getAbsoluteLabels(buf).toText());
+    }
+    // The case of the name doesn't matter.
+    EXPECT_EQ(TestDomainTree::EXACTMATCH, tree.find(Name("EXAMPLES"),
+                                                    &cdtnode));
+    EXPECT_EQ(Name("examples"), cdtnode->getName());
+    EXPECT_EQ(TestDomainTree::EXACTMATCH, tree.find(Name("examplf"),
+                                                    &cdtnode));
+    EXPECT_EQ(Name("EXAMPLF"), cdtnode->getName());
+
+    // "zzzz" was split from "a.zzzz" when "b.zzzz" was inserted.
+    EXPECT_EQ(TestDomainTree::PARTIALMATCH, tree.find(Name("x.c.b.zzzz"),
+                                                      &cdtnode));
+    EXPECT_EQ("c.b.zzzz.", cdtnode->getAbsoluteLabels(buf).toText());
+    EXPECT_EQ(TestDomainTree::NOTFOUND, tree.find(Name("examp"), &cdtnode));
+    EXPECT_EQ(TestDomainTree::NOTFOUND, tree.find(Name("ex\\000\\000"),
+                                                  &cdtnode));
+    EXPECT_EQ(TestDomainTree::NOTFOUND, tree.find(Name("zzz"), &cdtnode));
+}
+
 TEST_F(DomainTreeTest, findError) {
     // For the version that takes a node chain, the chain must be empty.
     TestDomainTreeNodeChain chain;
@@ -0,0 +1,148 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "memory_segment_mock.h"
+
+#include <datasrc/memory/name_dictionary.h>
+
+#include <dns/name.h>
+#include <dns/labelsequence.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <new>                  // for bad_alloc
+#include <string>
+#include <vector>
+
+using namespace isc::dns;
+using namespace isc::datasrc::memory;
+using isc::datasrc::memory::test::MemorySegmentMock;
+
+namespace {
+
+class NameDictionaryTest : public ::testing::Test {
+protected:
+    NameDictionaryTest() :
+        dictionary_(NameDictionary::create(mem_sgmt_))
+    {}
+    ~NameDictionaryTest() {
+        if (dictionary_ != NULL) {
+            NameDictionary::destroy(mem_sgmt_, dictionary_);
+        }
+        EXPECT_TRUE(mem_sgmt_.allMemoryDeallocated());
+    }
+
+    MemorySegmentMock mem_sgmt_;
+    NameDictionary* dictionary_;
+};
+
+Name
+getTestName(int i) {
+    return (Name("ns" + boost::lexical_cast<std::string>(i) + ".example.com"));
+}
+
+TEST_F(NameDictionaryTest, create) {
+    EXPECT_EQ(0, dictionary_->getNameCount());
+    EXPECT_EQ(sizeof(NameDictionary), dictionary_->getMemorySize());
+    EXPECT_EQ(static_cast<const uint8_t*>(NULL),
+              dictionary_->find(LabelSequence(Name("example.com"))));
+}
+
+TEST_F(NameDictionaryTest, addAndFind) {
+    const Name ns_name("ns.example.com");
+    const LabelSequence labels(ns_name);
+    const uint8_t* name = dictionary_->add(mem_sgmt_, labels);
+    ASSERT_NE(static_cast<const uint8_t*>(NULL), name);
+    EXPECT_TRUE(LabelSequence(name).equals(labels, true));
+    EXPECT_EQ(name, dictionary_->find(labels));
+    EXPECT_EQ(1, dictionary_->getNameCount());
+
+    // Adding the same name again returns the existing copy.
+    EXPECT_EQ(name, dictionary_->add(mem_sgmt_,
+                                     LabelSequence(Name("ns.example.com"))));
+    EXPECT_EQ(1, dictionary_->getNameCount());
+
+    // Names are compared case sensitively.
+    const Name upper_ns_name("NS.example.com");
+    const LabelSequence upper_labels(upper_ns_name);
+    EXPECT_EQ(static_cast<const uint8_t*>(NULL),
+              dictionary_->find(upper_labels));
+    const uint8_t* upper_name = dictionary_->add(mem_sgmt_, upper_labels);
+    EXPECT_NE(name, upper_name);
+    EXPECT_TRUE(LabelSequence(upper_name).equals(upper_labels, true));
+    EXPECT_EQ(2, dictionary_->getNameCount());
+
+    // Other names aren't found.
+    EXPECT_EQ(static_cast<const uint8_t*>(NULL),
+              dictionary_->find(LabelSequence(Name("example.com"))));
+}
+
+TEST_F(NameDictionaryTest, manyNames) {
+    // Enough names to grow the hash table several times.
+    const int count = 100;
+    std::vector<const uint8_t*> names;
+    size_t names_size = 0;
+    for (int i = 0; i < count; ++i) {
+        const Name name(getTestName(i));
+        const LabelSequence labels(name);
+        names.push_back(dictionary_->add(mem_sgmt_, labels));
+        names_size += labels.getSerializedLength();
+    }
+    EXPECT_EQ(count, dictionary_->getNameCount());
+    // The names themselves are never moved.
+    for (int i = 0; i < count; ++i) {
+        EXPECT_EQ(names[i], dictionary_->find(LabelSequence(getTestName(i))));
+    }
+    // The size covers the hash table, too.
+    EXPECT_LT(sizeof(NameDictionary) + names_size,
+              dictionary_->getMemorySize());
+}
+
+TEST_F(NameDictionaryTest, addFailure) {
+    for (int i = 0; i < 8; ++i) {
+        dictionary_->add(mem_sgmt_, LabelSequence(getTestName(i)));
+    }
+    const size_t size = dictionary_->getMemorySize();
+
+    // The 9th name needs a bigger table.  If allocating it fails, nothing
+    // changes.
+    mem_sgmt_.setThrowCount(1);
+    EXPECT_THROW(dictionary_->add(mem_sgmt_, LabelSequence(getTestName(8))),
+                 std::bad_alloc);
+    EXPECT_EQ(8, dictionary_->getNameCount());
+    EXPECT_EQ(size, dictionary_->getMemorySize());
+    EXPECT_EQ(static_cast<const uint8_t*>(NULL),
+              dictionary_->find(LabelSequence(getTestName(8))));
+
+    // If allocating the name fails, the table has grown but the name
+    // isn't added.
+    mem_sgmt_.setThrowCount(2);
+    EXPECT_THROW(dictionary_->add(mem_sgmt_, LabelSequence(getTestName(8))),
+                 std::bad_alloc);
+    EXPECT_EQ(8, dictionary_->getNameCount());
+    EXPECT_EQ(static_cast<const uint8_t*>(NULL),
+              dictionary_->find(LabelSequence(getTestName(8))));
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_NE(static_cast<const uint8_t*>(NULL),
+                  dictionary_->find(LabelSequence(getTestName(i))));
+    }
+
+    // Everything is released on destruction (checked in the destructor).
+    EXPECT_NE(static_cast<const uint8_t*>(NULL),
+              dictionary_->add(mem_sgmt_, LabelSequence(getTestName(8))));
+}
+
+}
@@ -0,0 +1,159 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/nsec3_hash_cache.h>
+#include <datasrc/memory/zone_data.h>
+
+#include <util/memory_segment_local.h>
+
+#include <dns/name.h>
+#include <dns/labelsequence.h>
+#include <dns/rdataclass.h>
+#include <dns/rrclass.h>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+using namespace isc::dns;
+using namespace isc::dns::rdata;
+using namespace isc::datasrc::memory;
+using isc::util::MemorySegmentLocal;
+using std::string;
+
+namespace {
+
+class NSEC3HashCacheTest : public ::testing::Test {
+protected:
+    NSEC3HashCacheTest() :
+        zname_("example.org"),
+        nsec3_data_(NSEC3Data::create(
+                        mem_sgmt_, zname_,
+                        generic::NSEC3PARAM("1 0 12 aabbccdd"))),
+        nsec3_data_other_salt_(NSEC3Data::create(
+                                   mem_sgmt_, zname_,
+                                   generic::NSEC3PARAM("1 0 12 aabbccde"))),
+        nsec3_data_other_iter_(NSEC3Data::create(
+                                   mem_sgmt_, zname_,
+                                   generic::NSEC3PARAM("1 0 11 aabbccdd"))),
+        name_("www.example.org"), name_upper_("WWW.EXAMPLE.ORG")
+    {}
+
+    ~NSEC3HashCacheTest() {
+        NSEC3Data::destroy(mem_sgmt_, nsec3_data_, RRClass::IN());
+        NSEC3Data::destroy(mem_sgmt_, nsec3_data_other_salt_, RRClass::IN());
+        NSEC3Data::destroy(mem_sgmt_, nsec3_data_other_iter_, RRClass::IN());
+    }
+
+    MemorySegmentLocal mem_sgmt_;
+    const Name zname_;
+    NSEC3Data* const nsec3_data_;
+    NSEC3Data* const nsec3_data_other_salt_;
+    NSEC3Data* const nsec3_data_other_iter_;
+    const Name name_;
+    const Name name_upper_;
+};
+
+TEST_F(NSEC3HashCacheTest, findAndInsert) {
+    NSEC3HashCache cache;
+    string hash;
+
+    EXPECT_EQ(0, cache.getSize());
+    EXPECT_FALSE(cache.find(*nsec3_data_, LabelSequence(name_), hash));
+
+    cache.insert(*nsec3_data_, LabelSequence(name_), "HASH1");
+    EXPECT_EQ(1, cache.getSize());
+    EXPECT_TRUE(cache.find(*nsec3_data_, LabelSequence(name_), hash));
+    EXPECT_EQ("HASH1", hash);
+
+    // The case of the name doesn't matter.
+    hash.clear();
+    EXPECT_TRUE(cache.find(*nsec3_data_, LabelSequence(name_upper_), hash));
+    EXPECT_EQ("HASH1", hash);
+
+    // But the NSEC3 parameters do.
+    EXPECT_FALSE(cache.find(*nsec3_data_other_salt_, LabelSequence(name_),
+                            hash));
+    EXPECT_FALSE(cache.find(*nsec3_data_other_iter_, LabelSequence(name_),
+                            hash));
+
+    // So does the name, of course.  A label sequence of part of the name
+    // is a different name.
+    LabelSequence parent(name_);
+    parent.stripLeft(1);
+    EXPECT_FALSE(cache.find(*nsec3_data_, parent, hash));
+
+    // Inserting an existing name replaces its hash.
+    cache.insert(*nsec3_data_, LabelSequence(name_upper_), "HASH2");
+    EXPECT_EQ(1, cache.getSize());
+    EXPECT_TRUE(cache.find(*nsec3_data_, LabelSequence(name_), hash));
+    EXPECT_EQ("HASH2", hash);
+
+    cache.clear();
+    EXPECT_EQ(0, cache.getSize());
+    EXPECT_FALSE(cache.find(*nsec3_data_, LabelSequence(name_), hash));
+}
+
+TEST_F(NSEC3HashCacheTest, evictLeastRecentlyUsed) {
+    NSEC3HashCache cache(2);
+    const Name name1("a.example.org"), name2("b.example.org"),
+        name3("c.example.org");
+    string hash;
+
+    cache.insert(*nsec3_data_, LabelSequence(name1), "HASH1");
+    cache.insert(*nsec3_data_, LabelSequence(name2), "HASH2");
+    EXPECT_EQ(2, cache.getSize());
+
+    // Use name1, making name2 the least recently used one, which is
+    // removed when a new name is added.
+    EXPECT_TRUE(cache.find(*nsec3_data_, LabelSequence(name1), hash));
+    cache.insert(*nsec3_data_, LabelSequence(name3), "HASH3");
+    EXPECT_EQ(2, cache.getSize());
+    EXPECT_TRUE(cache.find(*nsec3_data_, LabelSequence(name1), hash));
+    EXPECT_EQ("HASH1", hash);
+    EXPECT_FALSE(cache.find(*nsec3_data_, LabelSequence(name2), hash));
+    EXPECT_TRUE(cache.find(*nsec3_data_, LabelSequence(name3), hash));
+    EXPECT_EQ("HASH3", hash);
+}
+
+TEST_F(NSEC3HashCacheTest, capacity) {
+    // A cache with no capacity never holds anything.
+    NSEC3HashCache empty_cache(0);
+    string hash;
+    empty_cache.insert(*nsec3_data_, LabelSequence(name_), "HASH");
+    EXPECT_EQ(0, empty_cache.getSize());
+    EXPECT_FALSE(empty_cache.find(*nsec3_data_, LabelSequence(name_), hash));
+
+    // A large cache is split, but never holds more entries in total than
+    // its capacity (rounded up to a multiple of the number of the parts),
+    // and keeps about that many.
+    const size_t capacity = 2000;
+    NSEC3HashCache cache(capacity);
+    for (size_t i = 0; i < capacity * 2; ++i) {
+        std::ostringstream oss;
+        oss << "name" << i << ".example.org";
+        cache.insert(*nsec3_data_, LabelSequence(Name(oss.str())),
+                     oss.str());
+    }
+    EXPECT_GE(capacity + 16, cache.getSize());
+    EXPECT_LE(capacity * 9 / 10, cache.getSize());
+
+    // The most recently added one should be there.
+    EXPECT_TRUE(cache.find(*nsec3_data_,
+                           LabelSequence(Name("name3999.example.org")), hash));
+    EXPECT_EQ("name3999.example.org", hash);
+}
+
+}
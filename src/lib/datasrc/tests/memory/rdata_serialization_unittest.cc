@@ -15,6 +15,7 @@
 #include <exceptions/exceptions.h>
 
 #include <util/buffer.h>
+#include <util/memory_segment_local.h>
 
 #include <dns/name.h>
 #include <dns/labelsequence.h>
@@ -25,6 +26,7 @@
 #include <dns/rrtype.h>
 
 #include <datasrc/memory/rdata_serialization.h>
+#include <datasrc/memory/name_dictionary.h>
 
 #include <util/unittests/wiredata.h>
 
@@ -32,6 +34,7 @@
 
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <cstring>
 #include <algorithm>
@@ -45,6 +48,7 @@ using namespace isc::dns::rdata;
 using namespace isc::datasrc::memory;
 
 using isc::util::unittests::matchWireData;
+using boost::lexical_cast;
 using std::string;
 using std::vector;
 
@@ -1061,6 +1065,90 @@ TEST_F(RdataSerializationTest, addSIGRdataOnly) {
     EXPECT_TRUE(called);
 }
 
+void
+countData(size_t* count, const void*, size_t) {
+    ++*count;
+}
+
+TEST_F(RdataSerializationTest, duplicateIgnoresNameCase) {
+    // Duplicates are detected on the encoded data, where names in RDATA
+    // and the RRSIG signer are compared case-insensitively while other
+    // data must be identical.
+    encoder_.start(RRClass::IN(), RRType::MX());
+    EXPECT_TRUE(encoder_.addRdata(*createRdata(RRType::MX(), RRClass::IN(),
+                                               "5 mx1.example.com.")));
+    EXPECT_FALSE(encoder_.addRdata(*createRdata(RRType::MX(), RRClass::IN(),
+                                                "5 MX1.Example.COM.")));
+    EXPECT_TRUE(encoder_.addRdata(*createRdata(RRType::MX(), RRClass::IN(),
+                                               "10 mx1.example.com.")));
+    EXPECT_TRUE(encoder_.addSIGRdata(*rrsig_rdata_));
+    EXPECT_FALSE(encoder_.addSIGRdata(
+                     *createRdata(RRType::RRSIG(), RRClass::IN(),
+                                  "A 5 2 3600 20120814220826 "
+                                  "20120715220826 12345 COM. FAKE")));
+    EXPECT_TRUE(encoder_.addSIGRdata(
+                    *createRdata(RRType::RRSIG(), RRClass::IN(),
+                                 "A 5 2 3600 20120814220826 "
+                                 "20120715220826 54321 com. FAKE")));
+    encodeWrapper(encoder_.getStorageLength());
+
+    // Only the non-duplicate ones were encoded.
+    size_t rdata_count = 0;
+    RdataReader reader(RRClass::IN(), RRType::MX(), &encoded_data_[0], 2, 2,
+                       ignoreName,
+                       boost::bind(countData, &rdata_count, _1, _2));
+    reader.iterate();
+    EXPECT_EQ(2, rdata_count);
+    rdata_count = 0;
+    reader.iterateAllSigs();
+    EXPECT_EQ(2, rdata_count);
+}
+
+TEST_F(RdataSerializationTest, duplicateInLargeRRset) {
+    // Duplicates are found among many RDATAs and RRSIGs, including when
+    // they are merged with old data.
+    const size_t count = 1000;
+    encoder_.start(RRClass::IN(), RRType::NS());
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_TRUE(encoder_.addRdata(
+                        *createRdata(RRType::NS(), RRClass::IN(),
+                                     "ns" + lexical_cast<string>(i) +
+                                     ".example.com.")));
+        EXPECT_TRUE(encoder_.addSIGRdata(
+                        *createRdata(RRType::RRSIG(), RRClass::IN(),
+                                     "NS 5 2 3600 20120814220826 "
+                                     "20120715220826 " +
+                                     lexical_cast<string>(i) +
+                                     " com. FAKE")));
+    }
+    encodeWrapper(encoder_.getStorageLength());
+
+    encoder_.start(RRClass::IN(), RRType::NS(), &encoded_data_[0], count,
+                   count);
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_FALSE(encoder_.addRdata(
+                         *createRdata(RRType::NS(), RRClass::IN(),
+                                      "NS" + lexical_cast<string>(i) +
+                                      ".Example.COM.")));
+        EXPECT_FALSE(encoder_.addSIGRdata(
+                         *createRdata(RRType::RRSIG(), RRClass::IN(),
+                                      "NS 5 2 3600 20120814220826 "
+                                      "20120715220826 " +
+                                      lexical_cast<string>(i) +
+                                      " COM. FAKE")));
+    }
+    EXPECT_TRUE(encoder_.addRdata(*createRdata(RRType::NS(), RRClass::IN(),
+                                               "ns.example.org.")));
+    encodeWrapper(encoder_.getStorageLength());
+
+    size_t rdata_count = 0;
+    RdataReader reader(RRClass::IN(), RRType::NS(), &encoded_data_[0],
+                       count + 1, count, ignoreName,
+                       boost::bind(countData, &rdata_count, _1, _2));
+    reader.iterateAllSigs();
+    EXPECT_EQ(count, rdata_count);
+}
+
 TEST_F(RdataSerializationTest, badAddSIGRdata) {
     // try adding SIG before start
     EXPECT_THROW(encoder_.addSIGRdata(*rrsig_rdata_), isc::InvalidOperation);
@@ -1078,4 +1166,192 @@ TEST_F(RdataSerializationTest, badAddSIGRdata) {
     encoder_.start(RRClass::IN(), RRType::A());
     EXPECT_THROW(encoder_.addSIGRdata(big_sigrdata), RdataEncodingError);
 }
+
+// Encode the given RDATA (and the common RRSIG) through addWireRdata() and
+// addWireSIGRdata(), and check the result is identical to that of
+// addRdata() and addSIGRdata().
+void
+checkWireEncode(const RRClass& rrclass, const RRType& rrtype,
+                const vector<ConstRdataPtr>& rdata_list,
+                const ConstRdataPtr& rrsig_rdata)
+{
+    RdataEncoder expected_encoder;
+    expected_encoder.start(rrclass, rrtype);
+    RdataEncoder actual_encoder;
+    actual_encoder.start(rrclass, rrtype);
+
+    isc::util::OutputBuffer ob(0);
+    BOOST_FOREACH(const ConstRdataPtr& rdata, rdata_list) {
+        ob.clear();
+        rdata->toWire(ob);
+        EXPECT_EQ(expected_encoder.addRdata(*rdata),
+                  actual_encoder.addWireRdata(ob.getData(), ob.getLength()));
+    }
+    ob.clear();
+    rrsig_rdata->toWire(ob);
+    EXPECT_EQ(expected_encoder.addSIGRdata(*rrsig_rdata),
+              actual_encoder.addWireSIGRdata(ob.getData(), ob.getLength()));
+
+    ASSERT_EQ(expected_encoder.getStorageLength(),
+              actual_encoder.getStorageLength());
+    vector<uint8_t> expected_data(expected_encoder.getStorageLength());
+    vector<uint8_t> actual_data(actual_encoder.getStorageLength());
+    expected_encoder.encode(&expected_data[0], expected_data.size());
+    actual_encoder.encode(&actual_data[0], actual_data.size());
+    matchWireData(&expected_data[0], expected_data.size(),
+                  &actual_data[0], actual_data.size());
+}
+
+TEST_F(RdataSerializationTest, addWireRdata) {
+    // The types dns::rdata::createWireRdata() supports.
+    const char* const wire_types[] = {
+        "A", "NS", "CNAME", "MX", "TXT", "AAAA", "DS", "NSEC3", NULL
+    };
+    for (size_t i = 0; wire_types[i] != NULL; ++i) {
+        for (size_t j = 0; test_rdata_list[j].rrclass != NULL; ++j) {
+            if (string(test_rdata_list[j].rrtype) != wire_types[i]) {
+                continue;
+            }
+            SCOPED_TRACE(string(test_rdata_list[j].rrclass) + "/" +
+                         test_rdata_list[j].rrtype);
+            const RRClass rrclass(test_rdata_list[j].rrclass);
+            const RRType rrtype(test_rdata_list[j].rrtype);
+            vector<ConstRdataPtr> rdata_list;
+            rdata_list.push_back(createRdata(rrtype, rrclass,
+                                             test_rdata_list[j].rdata));
+            // Duplicates are detected the same way.
+            rdata_list.push_back(createRdata(rrtype, rrclass,
+                                             test_rdata_list[j].rdata));
+            checkWireEncode(rrclass, rrtype, rdata_list, rrsig_rdata_);
+        }
+    }
+
+    // Multiple RDATAs, with names in different cases.
+    vector<ConstRdataPtr> rdata_list;
+    rdata_list.push_back(createRdata(RRType::MX(), RRClass::IN(),
+                                     "10 mx.example.com."));
+    rdata_list.push_back(createRdata(RRType::MX(), RRClass::IN(),
+                                     "10 MX.example.com."));
+    rdata_list.push_back(createRdata(RRType::MX(), RRClass::IN(),
+                                     "20 mx2.example.com."));
+    checkWireEncode(RRClass::IN(), RRType::MX(), rdata_list, rrsig_rdata_);
+
+    // The root name in RDATA.
+    rdata_list.clear();
+    rdata_list.push_back(createRdata(RRType::NS(), RRClass::IN(), "."));
+    checkWireEncode(RRClass::IN(), RRType::NS(), rdata_list, rrsig_rdata_);
+}
+
+TEST_F(RdataSerializationTest, badAddWireRdata) {
+    const uint8_t data[] = { 192, 0, 2, 1, 0 };
+
+    // try adding data before start
+    EXPECT_THROW(encoder_.addWireRdata(data, 4), isc::InvalidOperation);
+    EXPECT_THROW(encoder_.addWireSIGRdata(data, 4), isc::InvalidOperation);
+
+    // Short or long data for a fixed length type.
+    encoder_.start(RRClass::IN(), RRType::A());
+    EXPECT_THROW(encoder_.addWireRdata(data, 3), isc::BadValue);
+    EXPECT_THROW(encoder_.addWireRdata(data, 5), isc::BadValue);
+
+    // Broken names: no terminating label, too long label, trailing data.
+    const uint8_t bad_name1[] = { 2, 'n', 's' };
+    const uint8_t bad_name2[] = { 64, 'n', 's', 0 };
+    const uint8_t bad_name3[] = { 2, 'n', 's', 0, 0 };
+    encoder_.start(RRClass::IN(), RRType::NS());
+    EXPECT_THROW(encoder_.addWireRdata(bad_name1, sizeof(bad_name1)),
+                 isc::BadValue);
+    EXPECT_THROW(encoder_.addWireRdata(bad_name2, sizeof(bad_name2)),
+                 isc::BadValue);
+    EXPECT_THROW(encoder_.addWireRdata(bad_name3, sizeof(bad_name3)),
+                 isc::BadValue);
+    EXPECT_THROW(encoder_.addWireRdata(NULL, 0), isc::BadValue);
+
+    // A variable length field that isn't the last one can't be determined.
+    isc::util::OutputBuffer ob(0);
+    createRdata(RRType::NAPTR(), RRClass::IN(),
+                "100 50 \"s\" \"http\" \"\" _http._tcp.example.com.")->
+        toWire(ob);
+    encoder_.start(RRClass::IN(), RRType::NAPTR());
+    EXPECT_THROW(encoder_.addWireRdata(ob.getData(), ob.getLength()),
+                 isc::BadValue);
+
+    // The encoder is still usable after the errors.
+    encoder_.start(RRClass::IN(), RRType::A());
+    EXPECT_TRUE(encoder_.addWireRdata(data, 4));
+    encodeWrapper(encoder_.getStorageLength());
+    EXPECT_EQ(4, encoded_data_.size());
+}
+
+// Render the given NS RDATA (and the common RRSIG) and the data encoded in
+// encoded_data, and check they're identical.
+void
+checkNSData(const vector<ConstRdataPtr>& rdata_list,
+            const ConstRdataPtr& rrsig_rdata,
+            const vector<uint8_t>& encoded_data)
+{
+    MessageRenderer expected_renderer;
+    BOOST_FOREACH(const ConstRdataPtr& rdata, rdata_list) {
+        rdata->toWire(expected_renderer);
+    }
+    expected_renderer.writeName(dummyName2());
+    rrsig_rdata->toWire(expected_renderer);
+
+    MessageRenderer actual_renderer;
+    // This decoder also checks the size of the encoded data.
+    HybridDecoder<true, true>::decode(RRClass::IN(), RRType::NS(),
+                                      rdata_list.size(), 1, 0, encoded_data,
+                                      encoded_data.size(), actual_renderer);
+    matchWireData(expected_renderer.getData(), expected_renderer.getLength(),
+                  actual_renderer.getData(), actual_renderer.getLength());
+}
+
+TEST_F(RdataSerializationTest, encodeWithNameDictionary) {
+    isc::util::MemorySegmentLocal mem_sgmt;
+    NameDictionary* dictionary = NameDictionary::create(mem_sgmt);
+    encoder_.setNameDictionary(dictionary);
+
+    // A name long enough to be shared, and one that is shorter than a
+    // reference to it.
+    rdata_list_.push_back(createRdata(RRType::NS(), RRClass::IN(),
+                                      "ns1.example.com."));
+    rdata_list_.push_back(createRdata(RRType::NS(), RRClass::IN(), "."));
+    encoder_.start(RRClass::IN(), RRType::NS());
+    BOOST_FOREACH(const ConstRdataPtr& rdata, rdata_list_) {
+        encoder_.addRdata(*rdata);
+    }
+    encoder_.addSIGRdata(*rrsig_rdata_);
+
+    // Names are only moved to the dictionary by internNames().
+    const size_t inline_len = encoder_.getStorageLength();
+    EXPECT_EQ(0, dictionary->getNameCount());
+    encoder_.internNames(mem_sgmt);
+    EXPECT_EQ(1, dictionary->getNameCount());
+    const Name ns1_name("ns1.example.com");
+    const LabelSequence ns1_labels(ns1_name);
+    EXPECT_NE(static_cast<const uint8_t*>(NULL),
+              dictionary->find(ns1_labels));
+    EXPECT_EQ(inline_len - ns1_labels.getSerializedLength() + NAME_REF_LENGTH,
+              encoder_.getStorageLength());
+    encodeWrapper(encoder_.getStorageLength());
+    checkNSData(rdata_list_, rrsig_rdata_, encoded_data_);
+
+    // Merge more RDATA into the encoded data.  The existing name is shared
+    // again, and duplicates are still detected.
+    encoder_.start(RRClass::IN(), RRType::NS(), &encoded_data_[0], 2, 1);
+    EXPECT_FALSE(encoder_.addRdata(*rdata_list_[0]));
+    rdata_list_.push_back(createRdata(RRType::NS(), RRClass::IN(),
+                                      "ns2.example.com."));
+    EXPECT_TRUE(encoder_.addRdata(*rdata_list_[2]));
+    EXPECT_FALSE(encoder_.addSIGRdata(*rrsig_rdata_));
+    encoder_.internNames(mem_sgmt);
+    EXPECT_EQ(2, dictionary->getNameCount());
+    // The old data is no longer needed once the merge has started.
+    std::fill(encoded_data_.begin(), encoded_data_.end(), 0);
+    encodeWrapper(encoder_.getStorageLength());
+    checkNSData(rdata_list_, rrsig_rdata_, encoded_data_);
+
+    NameDictionary::destroy(mem_sgmt, dictionary);
+    EXPECT_TRUE(mem_sgmt.allMemoryDeallocated());
+}
 }
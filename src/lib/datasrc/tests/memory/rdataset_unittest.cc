@@ -23,6 +23,7 @@
 #include <dns/rrclass.h>
 #include <dns/rrtype.h>
 #include <dns/rrttl.h>
+#include <dns/wire_rrset.h>
 
 #include <datasrc/memory/segment_object_holder.h>
 #include <datasrc/memory/rdata_serialization.h>
@@ -335,6 +336,28 @@ TEST_F(RdataSetTest, duplicate) {
     checkRdataSet(*holder2.get(), def_rdata_txt_, def_rrsig_txt_);
 }
 
+TEST_F(RdataSetTest, copy) {
+    SegmentObjectHolder<RdataSet, RRClass> holder1(mem_sgmt_, rrclass);
+    holder1.set(RdataSet::create(mem_sgmt_, encoder_, a_rrset_,
+                                 rrsig_rrset_));
+    // The next pointer of the source doesn't matter.
+    holder1.get()->next = holder1.get();
+
+    SegmentObjectHolder<RdataSet, RRClass> holder2(mem_sgmt_, rrclass);
+    holder2.set(RdataSet::copy(mem_sgmt_, rrclass, *holder1.get()));
+    EXPECT_NE(holder1.get(), holder2.get());
+    checkRdataSet(*holder2.get(), def_rdata_txt_, def_rrsig_txt_);
+    holder1.get()->next = NULL;
+
+    // Same for RRSIG only.
+    SegmentObjectHolder<RdataSet, RRClass> holder3(mem_sgmt_, rrclass);
+    holder3.set(RdataSet::create(mem_sgmt_, encoder_, ConstRRsetPtr(),
+                                 rrsig_rrset_));
+    SegmentObjectHolder<RdataSet, RRClass> holder4(mem_sgmt_, rrclass);
+    holder4.set(RdataSet::copy(mem_sgmt_, rrclass, *holder3.get()));
+    checkRdataSet(*holder4.get(), vector<string>(), def_rrsig_txt_);
+}
+
 TEST_F(RdataSetTest, getNext) {
     RdataSet* rdataset = RdataSet::create(mem_sgmt_, encoder_, a_rrset_,
                                           ConstRRsetPtr());
@@ -468,6 +491,39 @@ TEST_F(RdataSetTest, createWithRRSIG) {
     RdataSet::destroy(mem_sgmt_, rdataset, RRClass::IN());
 }
 
+TEST_F(RdataSetTest, createFromWireRRset) {
+    // RDATA of dns::WireRRset are encoded from the wire format; the result
+    // is the same as that for the normal RRsets.  The duplicate is ignored.
+    const boost::shared_ptr<WireRRset> rrset(
+        new WireRRset(a_rrset_->getName(), rrclass, RRType::A(),
+                      a_rrset_->getTTL()));
+    rrset->addRdata(a_rrset_->getRdataIterator()->getCurrent());
+    rrset->addRdata(a_rrset_->getRdataIterator()->getCurrent());
+    const boost::shared_ptr<WireRRset> sig_rrset(
+        new WireRRset(rrsig_rrset_->getName(), rrclass, RRType::RRSIG(),
+                      rrsig_rrset_->getTTL()));
+    sig_rrset->addRdata(rrsig_rrset_->getRdataIterator()->getCurrent());
+
+    RdataSet* rdataset = RdataSet::create(mem_sgmt_, encoder_, rrset,
+                                          sig_rrset);
+    checkRdataSet(*rdataset, def_rdata_txt_, def_rrsig_txt_);
+    RdataSet::destroy(mem_sgmt_, rdataset, RRClass::IN());
+
+    rdataset = RdataSet::create(mem_sgmt_, encoder_, ConstRRsetPtr(),
+                                sig_rrset);
+    checkRdataSet(*rdataset, vector<string>(), def_rrsig_txt_);
+    RdataSet::destroy(mem_sgmt_, rdataset, RRClass::IN());
+
+    // Type covered must match.
+    const boost::shared_ptr<WireRRset> bad_sig_rrset(
+        new WireRRset(rrsig_rrset_->getName(), rrclass, RRType::RRSIG(),
+                      rrsig_rrset_->getTTL()));
+    bad_sig_rrset->addRdata("AAAA 5 2 3600 20120814220826 20120715220826 "
+                            "1234 example.com. FAKE");
+    EXPECT_THROW(RdataSet::create(mem_sgmt_, encoder_, rrset, bad_sig_rrset),
+                 isc::BadValue);
+}
+
 // A helper function to create an RRSIG RRset containing the given number of
 // unique RDATAs.
 RRsetPtr
@@ -557,6 +613,18 @@ TEST_F(RdataSetTest, mergeCreateManyRRSIGs) {
                                       holder.get()), rrsig->getRdataCount());
 }
 
+TEST_F(RdataSetTest, copyManyRRSIGs) {
+    // With the extended RRSIG count field (used for 7 or more).
+    const size_t sig_count = 10;
+    SegmentObjectHolder<RdataSet, RRClass> holder1(mem_sgmt_, rrclass);
+    holder1.set(RdataSet::create(mem_sgmt_, encoder_, a_rrset_,
+                                 getRRSIGWithRdataCount(sig_count)));
+    SegmentObjectHolder<RdataSet, RRClass> holder2(mem_sgmt_, rrclass);
+    holder2.set(RdataSet::copy(mem_sgmt_, rrclass, *holder1.get()));
+    EXPECT_EQ(1, holder2.get()->getRdataCount());
+    EXPECT_EQ(sig_count, holder2.get()->getSigRdataCount());
+}
+
 TEST_F(RdataSetTest, createWithRRSIGOnly) {
     // A rare, but allowed, case: RdataSet without the main RRset but with
     // RRSIG.
@@ -18,8 +18,13 @@
 #include <datasrc/memory/rdataset.h>
 #include <datasrc/memory/zone_data.h>
 #include <datasrc/memory/zone_data_updater.h>
+#include <datasrc/memory/name_dictionary.h>
+#include <datasrc/memory/treenode_rrset.h>
 #include <datasrc/memory/segment_object_holder.h>
 #include <datasrc/zone_iterator.h>
+#include <datasrc/zone.h>
+
+#include <testutils/dnsmessage_test.h>
 
 #include <util/buffer.h>
 
@@ -35,12 +40,21 @@
 
 #include <gtest/gtest.h>
 
+#include <boost/lexical_cast.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
 using namespace isc::dns;
 using namespace isc::datasrc::memory;
 #ifdef USE_SHARED_MEMORY
 using isc::util::MemorySegmentMapped;
 #endif
 using isc::datasrc::memory::detail::SegmentObjectHolder;
+using isc::testutils::textToRRset;
 
 namespace {
 
@@ -86,6 +100,270 @@ TEST_F(ZoneDataLoaderTest, zoneMinTTL) {
     EXPECT_EQ(RRTTL(1200), RRTTL(b));
 }
 
+TEST_F(ZoneDataLoaderTest, nameIndex) {
+    // The loaded zone has the exact match index of its (non-NSEC3) names.
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                              TEST_DATA_DIR
+                              "/example.org-nsec3-signed.zone");
+    const ZoneNameIndex* index = zone_data_->getNameIndex();
+    ASSERT_NE(static_cast<const ZoneNameIndex*>(NULL), index);
+    EXPECT_EQ(2, index->getNameCount());
+    EXPECT_EQ(zone_data_->getOriginNode(),
+              index->find(LabelSequence(Name("example.org"))));
+    EXPECT_NE(static_cast<const ZoneNode*>(NULL),
+              index->find(LabelSequence(Name("ns.example.org"))));
+}
+
+// Write a zone of the given number of A RRs (in addition to the apex SOA
+// and NS) to the given file.  The given extra lines are written before
+// and after the RRs.
+void
+writeLargeZone(const char* filename, size_t count,
+               const std::string& head = "", const std::string& tail = "")
+{
+    std::ofstream of(filename);
+    of << head << "\n";
+    of << "example.org. 3600 IN SOA ns.example.org. admin.example.org. "
+        "1 3600 300 3600000 3600\n";
+    of << "example.org. 3600 IN NS ns.example.org.\n";
+    for (size_t i = 0; i < count; ++i) {
+        of << "host" << i << ".example.org. 3600 IN A 192.0.2.1\n";
+    }
+    of << tail << "\n";
+}
+
+// Both ways of reading zone files, regardless of the number of CPUs.
+const detail::ZoneFileReadMode read_modes[] = {
+    detail::READ_IN_THREAD, detail::READ_IN_CALLER
+};
+
+// Zones may be read in a separate thread and passed to the loader in
+// batches.  Load a zone that needs many batches (more than can wait in the
+// queue at once), and check we get all of them.  Do the same when the zone
+// is read in the caller's thread.
+TEST_F(ZoneDataLoaderTest, loadLargeZone) {
+    const char* const zone_file = TEST_DATA_BUILDDIR "/large.zone";
+    const size_t count = 20000;
+    writeLargeZone(zone_file, count);
+    for (size_t i = 0; i < sizeof(read_modes) / sizeof(read_modes[0]); ++i) {
+        SCOPED_TRACE("read mode " + boost::lexical_cast<std::string>(i));
+        detail::setZoneFileReadMode(read_modes[i]);
+        zone_data_ = loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                                  zone_file);
+
+        // The origin and all the hosts.
+        EXPECT_EQ(count + 1, zone_data_->getNameIndex()->getNameCount());
+        const ZoneNode* node = NULL;
+        EXPECT_EQ(ZoneTree::EXACTMATCH,
+                  zone_data_->getZoneTree().find(
+                      Name("host19999.example.org"), &node));
+        ZoneData::destroy(mem_sgmt_, zone_data_, zclass_);
+        zone_data_ = NULL;
+    }
+    detail::setZoneFileReadMode(detail::READ_AUTO);
+    EXPECT_EQ(0, unlink(zone_file));
+}
+
+// Errors found by either of the threads at the end of a large zone are
+// propagated correctly, and don't leak anything.
+TEST_F(ZoneDataLoaderTest, loadLargeZoneError) {
+    const char* const zone_file = TEST_DATA_BUILDDIR "/large.zone";
+
+    for (size_t i = 0; i < sizeof(read_modes) / sizeof(read_modes[0]); ++i) {
+        SCOPED_TRACE("read mode " + boost::lexical_cast<std::string>(i));
+        detail::setZoneFileReadMode(read_modes[i]);
+
+        // Broken input; detected by the reading thread.
+        writeLargeZone(zone_file, 20000, "", "broken.example.org. 3600 IN A");
+        EXPECT_THROW(loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                                  zone_file),
+                     isc::datasrc::ZoneLoaderException);
+
+        // Out of zone data; detected when adding it to the zone.
+        writeLargeZone(zone_file, 20000, "",
+                       "example.com. 3600 IN A 192.0.2.1");
+        EXPECT_THROW(loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                                  zone_file),
+                     ZoneDataUpdater::AddError);
+
+        // Same, at the beginning.  The reading thread (if any) is stopped
+        // in the middle.
+        writeLargeZone(zone_file, 20000, "example.com. 3600 IN A 192.0.2.1");
+        EXPECT_THROW(loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                                  zone_file),
+                     ZoneDataUpdater::AddError);
+    }
+    detail::setZoneFileReadMode(detail::READ_AUTO);
+
+    EXPECT_EQ(0, unlink(zone_file));
+}
+
+// A journal reader that returns the given RRs one by one.
+class TestJournalReader : public isc::datasrc::ZoneJournalReader {
+public:
+    void addDiff(const std::string& rr_text) {
+        diffs_.push_back(textToRRset(rr_text, RRClass::IN(),
+                                     Name("example.org")));
+    }
+    virtual ConstRRsetPtr getNextDiff() {
+        if (diffs_.empty()) {
+            return (ConstRRsetPtr());
+        }
+        const ConstRRsetPtr rrset = diffs_.front();
+        diffs_.erase(diffs_.begin());
+        return (rrset);
+    }
+private:
+    std::vector<ConstRRsetPtr> diffs_;
+};
+
+TEST_F(ZoneDataLoaderTest, updateZoneData) {
+    const char* const zone_file = TEST_DATA_BUILDDIR "/update.zone";
+    writeLargeZone(zone_file, 3);
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                              zone_file);
+    EXPECT_EQ(0, unlink(zone_file));
+
+    TestJournalReader reader;
+    reader.addDiff("example.org. 3600 IN SOA ns.example.org. "
+                   "admin.example.org. 1 3600 300 3600000 3600");
+    reader.addDiff("host0.example.org. 3600 IN A 192.0.2.1");
+    reader.addDiff("example.org. 3600 IN SOA ns.example.org. "
+                   "admin.example.org. 2 3600 300 3600000 1200");
+    reader.addDiff("host1.example.org. 3600 IN AAAA 2001:db8::1");
+    reader.addDiff("new.example.org. 3600 IN A 192.0.2.2");
+
+    ZoneData* new_data = updateZoneData(mem_sgmt_, zclass_,
+                                        Name("example.org"), *zone_data_,
+                                        reader);
+    SegmentObjectHolder<ZoneData, RRClass> holder(mem_sgmt_, zclass_);
+    holder.set(new_data);
+
+    // The differences are applied to the new version, including the
+    // name index and the minimum TTL.
+    const ZoneNameIndex* index = new_data->getNameIndex();
+    ASSERT_NE(static_cast<const ZoneNameIndex*>(NULL), index);
+    EXPECT_EQ(4, index->getNameCount());
+    EXPECT_EQ(static_cast<ZoneNode*>(NULL),
+              new_data->findName(Name("host0.example.org")));
+    ZoneNode* node = new_data->findName(Name("host1.example.org"));
+    ASSERT_NE(static_cast<ZoneNode*>(NULL), node);
+    EXPECT_NE(static_cast<const RdataSet*>(NULL),
+              RdataSet::find(node->getData(), RRType::AAAA()));
+    EXPECT_NE(static_cast<ZoneNode*>(NULL),
+              new_data->findName(Name("new.example.org")));
+    isc::util::InputBuffer b(new_data->getMinTTLData(), sizeof(uint32_t));
+    EXPECT_EQ(RRTTL(1200), RRTTL(b));
+
+    // The old version is intact.
+    EXPECT_EQ(4, zone_data_->getNameIndex()->getNameCount());
+    EXPECT_NE(static_cast<ZoneNode*>(NULL),
+              zone_data_->findName(Name("host0.example.org")));
+    EXPECT_EQ(static_cast<ZoneNode*>(NULL),
+              zone_data_->findName(Name("new.example.org")));
+}
+
+TEST_F(ZoneDataLoaderTest, updateZoneDataError) {
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                              TEST_DATA_DIR
+                              "/example.org-nsec3-signed.zone");
+
+    // Differences that end in the middle of a sequence.
+    TestJournalReader reader;
+    reader.addDiff("example.org. 3600 IN SOA ns.example.org. "
+                   "admin.example.org. 1 3600 300 3600000 3600");
+    EXPECT_THROW(updateZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                                *zone_data_, reader),
+                 ZoneValidationError);
+
+    // Differences that can't be applied to the zone.
+    TestJournalReader reader2;
+    reader2.addDiff("example.org. 86400 IN SOA ns.example.org. "
+                    "ns.example.org. 2012013000 7200 3600 2592000 1200");
+    reader2.addDiff("example.org. 86400 IN SOA ns.example.org. "
+                    "ns.example.org. 2012013001 7200 3600 2592000 1200");
+    reader2.addDiff("ns.example.org. 3600 IN CNAME example.org.");
+    EXPECT_THROW(updateZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                                *zone_data_, reader2),
+                 ZoneDataUpdater::AddError);
+    // Teardown checks for memory segment leaks
+}
+
+// Return the text of the RRset of the given name and type in the zone.
+std::string
+getRRsetText(const ZoneData& zone_data, const Name& name, const RRType& type) {
+    const ZoneNode* node = NULL;
+    EXPECT_EQ(ZoneTree::EXACTMATCH, zone_data.getZoneTree().find(name, &node));
+    const RdataSet* rdset = RdataSet::find(node->getData(), type);
+    EXPECT_NE(static_cast<const RdataSet*>(NULL), rdset);
+    return (TreeNodeRRset(RRClass::IN(), node, rdset, true).toText());
+}
+
+TEST_F(ZoneDataLoaderTest, loadCompactZone) {
+    // A delegation-heavy zone, where all the children use the same name
+    // servers.
+    const char* const zone_file = TEST_DATA_BUILDDIR "/compact.zone";
+    std::string delegations;
+    for (int i = 0; i < 100; ++i) {
+        const std::string child = "child" + boost::lexical_cast<std::string>(i) +
+            ".example.org. 3600 IN NS ";
+        delegations += child + "ns1.example.net.\n";
+        delegations += child + "ns2.example.net.\n";
+    }
+    writeLargeZone(zone_file, 0, "", delegations);
+    zone_data_ = loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                              zone_file, true);
+    SegmentObjectHolder<ZoneData, RRClass> holder(mem_sgmt_, zclass_);
+    holder.set(loadZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                            zone_file));
+    const ZoneData& inline_data = *holder.get();
+    EXPECT_EQ(0, unlink(zone_file));
+
+    // The names of the SOA, the apex NS and the delegations are shared.
+    const NameDictionary* dictionary = zone_data_->getNameDictionary();
+    ASSERT_NE(static_cast<const NameDictionary*>(NULL), dictionary);
+    EXPECT_EQ(4, dictionary->getNameCount());
+    EXPECT_EQ(static_cast<const NameDictionary*>(NULL),
+              inline_data.getNameDictionary());
+
+    // The compact form is smaller, but has the same names and RRsets.
+    const ZoneMemoryUsage usage = zone_data_->getMemoryUsage(zclass_);
+    const ZoneMemoryUsage inline_usage = inline_data.getMemoryUsage(zclass_);
+    EXPECT_EQ(inline_usage.node_count, usage.node_count);
+    EXPECT_EQ(inline_usage.rdataset_count, usage.rdataset_count);
+    EXPECT_EQ(4, usage.dictionary_name_count);
+    EXPECT_EQ(dictionary->getMemorySize(), usage.dictionary_size);
+    EXPECT_EQ(0, inline_usage.dictionary_size);
+    EXPECT_LT(usage.rdataset_size, inline_usage.rdataset_size);
+    EXPECT_LT(usage.getTotalSize(), inline_usage.getTotalSize());
+    EXPECT_EQ(getRRsetText(inline_data, Name("child42.example.org"),
+                           RRType::NS()),
+              getRRsetText(*zone_data_, Name("child42.example.org"),
+                           RRType::NS()));
+    EXPECT_EQ(getRRsetText(inline_data, Name("example.org"), RRType::SOA()),
+              getRRsetText(*zone_data_, Name("example.org"), RRType::SOA()));
+
+    // Updates keep the compact form.
+    TestJournalReader reader;
+    reader.addDiff("example.org. 3600 IN SOA ns.example.org. "
+                   "admin.example.org. 1 3600 300 3600000 3600");
+    reader.addDiff("example.org. 3600 IN SOA ns.example.org. "
+                   "admin.example.org. 2 3600 300 3600000 3600");
+    reader.addDiff("child42.example.org. 3600 IN NS ns3.example.net.");
+    SegmentObjectHolder<ZoneData, RRClass> new_holder(mem_sgmt_, zclass_);
+    new_holder.set(updateZoneData(mem_sgmt_, zclass_, Name("example.org"),
+                                  *zone_data_, reader));
+    const NameDictionary* new_dictionary =
+        new_holder.get()->getNameDictionary();
+    ASSERT_NE(static_cast<const NameDictionary*>(NULL), new_dictionary);
+    EXPECT_NE(dictionary, new_dictionary);
+    EXPECT_EQ(5, new_dictionary->getNameCount());
+    EXPECT_EQ(4, dictionary->getNameCount());
+    EXPECT_EQ(3, RdataSet::find(new_holder.get()->findName(
+                                    Name("child42.example.org"))->getData(),
+                                RRType::NS())->getRdataCount());
+}
+
 // Load bunch of small zones, hoping some of the relocation will happen
 // during the memory creation, not only Rdata creation.
 // Note: this doesn't even compile unless USE_SHARED_MEMORY is defined.
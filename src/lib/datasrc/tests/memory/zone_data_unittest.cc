@@ -15,6 +15,8 @@
 #include <datasrc/memory/zone_data.h>
 #include <datasrc/memory/rdata_serialization.h>
 #include <datasrc/memory/rdataset.h>
+#include <datasrc/memory/name_dictionary.h>
+#include <datasrc/memory/treenode_rrset.h>
 
 #include <dns/rdataclass.h>
 
@@ -278,6 +280,317 @@ TEST_F(ZoneDataTest, minTTL) {
     EXPECT_EQ(RRTTL(1200), createRRTTL(zone_data_->getMinTTLData()));
 }
 
+// Add an A RdataSet to the node of the given name, and return the node.
+ZoneNode*
+addTestData(isc::util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
+            ZoneData& zone_data, const std::string& name)
+{
+    ZoneNode* node = NULL;
+    zone_data.insertName(mem_sgmt, Name(name), &node);
+    node->setData(RdataSet::create(mem_sgmt, encoder,
+                                   textToRRset(name + " 3600 IN A 192.0.2.1"),
+                                   ConstRRsetPtr()));
+    return (node);
+}
+
+TEST_F(ZoneDataTest, nameIndexHash) {
+    // The hash is case insensitive.
+    EXPECT_EQ(ZoneNameIndex::getHash(LabelSequence(Name("www.example.com"))),
+              ZoneNameIndex::getHash(LabelSequence(Name("WWW.Example.COM"))));
+    // And covers the whole name, even if it's longer than what
+    // LabelSequence::getHash() would look at.
+    EXPECT_NE(ZoneNameIndex::getHash(LabelSequence(
+                                         Name("host-a.example.com"))),
+              ZoneNameIndex::getHash(LabelSequence(
+                                         Name("host-b.example.com"))));
+    EXPECT_NE(ZoneNameIndex::getHash(LabelSequence(
+                                         Name("www.example.com"))),
+              ZoneNameIndex::getHash(LabelSequence(
+                                         Name("www.example.org"))));
+}
+
+TEST_F(ZoneDataTest, nameIndex) {
+    // No index by default.
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+
+    const ZoneNode* origin = addTestData(mem_sgmt_, encoder_, *zone_data_,
+                                         "example.com.");
+    const ZoneNode* www = addTestData(mem_sgmt_, encoder_, *zone_data_,
+                                      "www.example.com.");
+    // This makes b.example.com an empty non terminal.
+    const ZoneNode* deep = addTestData(mem_sgmt_, encoder_, *zone_data_,
+                                       "a.b.example.com.");
+    // Names at and below a zone cut.
+    ZoneNode* cut = addTestData(mem_sgmt_, encoder_, *zone_data_,
+                                "child.example.com.");
+    cut->setFlag(ZoneNode::FLAG_CALLBACK);
+    addTestData(mem_sgmt_, encoder_, *zone_data_, "ns.child.example.com.");
+
+    zone_data_->buildNameIndex(mem_sgmt_);
+    const ZoneNameIndex* index = zone_data_->getNameIndex();
+    ASSERT_NE(static_cast<const ZoneNameIndex*>(NULL), index);
+    EXPECT_EQ(4, index->getNameCount());
+
+    EXPECT_EQ(origin, index->find(LabelSequence(zname_)));
+    EXPECT_EQ(www, index->find(LabelSequence(Name("WWW.example.com"))));
+    EXPECT_EQ(deep, index->find(LabelSequence(Name("a.b.example.com"))));
+    EXPECT_EQ(cut, index->find(LabelSequence(Name("child.example.com"))));
+    // Empty nodes, names below a zone cut and names not in the zone at all
+    // aren't indexed.
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              index->find(LabelSequence(Name("b.example.com"))));
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              index->find(LabelSequence(Name("ns.child.example.com"))));
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              index->find(LabelSequence(Name("ftp.example.com"))));
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              index->find(LabelSequence(Name("example.org"))));
+
+    // Rebuilding replaces the old index (any leak would be caught in
+    // TearDown()).
+    zone_data_->buildNameIndex(mem_sgmt_);
+    EXPECT_EQ(4, zone_data_->getNameIndex()->getNameCount());
+
+    // Inserting a name drops the index.
+    ZoneNode* node = NULL;
+    zone_data_->insertName(mem_sgmt_, Name("ftp.example.com"), &node);
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+
+    // Build it again to confirm destroy() releases it.
+    zone_data_->buildNameIndex(mem_sgmt_);
+    zone_data_->buildNameIndex(mem_sgmt_);
+    EXPECT_NE(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+}
+
+TEST_F(ZoneDataTest, nameIndexExceptionSafety) {
+    addTestData(mem_sgmt_, encoder_, *zone_data_, "www.example.com.");
+    zone_data_->buildNameIndex(mem_sgmt_);
+    const ZoneNameIndex* index = zone_data_->getNameIndex();
+
+    // A failed rebuild keeps the old index.
+    mem_sgmt_.setThrowCount(1);
+    EXPECT_THROW(zone_data_->buildNameIndex(mem_sgmt_), std::bad_alloc);
+    EXPECT_EQ(index, zone_data_->getNameIndex());
+
+    zone_data_->clearNameIndex(mem_sgmt_);
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+    // It's okay to clear it again.
+    zone_data_->clearNameIndex(mem_sgmt_);
+}
+
+TEST_F(ZoneDataTest, findAndRemoveName) {
+    EXPECT_EQ(zone_data_->getOriginNode(), zone_data_->findName(zname_));
+    EXPECT_EQ(static_cast<ZoneNode*>(NULL),
+              zone_data_->findName(Name("www.example.com")));
+
+    const ZoneNode* node =
+        addTestData(mem_sgmt_, encoder_, *zone_data_, "a.b.example.com.");
+    addTestData(mem_sgmt_, encoder_, *zone_data_, "c.b.example.com.");
+    EXPECT_EQ(node, zone_data_->findName(Name("A.B.example.com")));
+    // Empty nodes can be found too.
+    EXPECT_NE(static_cast<ZoneNode*>(NULL),
+              zone_data_->findName(Name("b.example.com")));
+    EXPECT_EQ(4, zone_data_->getZoneTree().getNodeCount());
+
+    // The node must be empty to be removed.
+    ZoneNode* found = zone_data_->findName(Name("a.b.example.com"));
+    RdataSet::destroy(mem_sgmt_, found->setData(NULL), RRClass::IN());
+    zone_data_->buildNameIndex(mem_sgmt_);
+    zone_data_->removeName(mem_sgmt_, found);
+    EXPECT_EQ(static_cast<ZoneNode*>(NULL),
+              zone_data_->findName(Name("a.b.example.com")));
+    EXPECT_EQ(3, zone_data_->getZoneTree().getNodeCount());
+    // The name index has been destroyed.
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+
+    // Once the last subdomain is removed, the now empty upper node is gone
+    // too, but the origin stays.
+    found = zone_data_->findName(Name("c.b.example.com"));
+    RdataSet::destroy(mem_sgmt_, found->setData(NULL), RRClass::IN());
+    zone_data_->removeName(mem_sgmt_, found);
+    EXPECT_EQ(static_cast<ZoneNode*>(NULL),
+              zone_data_->findName(Name("b.example.com")));
+    EXPECT_EQ(1, zone_data_->getZoneTree().getNodeCount());
+    EXPECT_EQ(zone_data_->getOriginNode(), zone_data_->findName(zname_));
+}
+
+TEST_F(ZoneDataTest, copy) {
+    // Set up some data: two RdataSets at www, a wildcard, the zone status
+    // and NSEC3 data with a single name.
+    ZoneNode* node = NULL;
+    zone_data_->insertName(mem_sgmt_, a_rrset_->getName(), &node);
+    RdataSet* rdataset_a =
+        RdataSet::create(mem_sgmt_, encoder_, a_rrset_, ConstRRsetPtr());
+    RdataSet* rdataset_aaaa =
+        RdataSet::create(mem_sgmt_, encoder_, aaaa_rrset_, ConstRRsetPtr());
+    rdataset_aaaa->next = rdataset_a;
+    node->setData(rdataset_aaaa);
+    addTestData(mem_sgmt_, encoder_, *zone_data_, "*.wild.example.com.");
+    zone_data_->insertName(mem_sgmt_, Name("wild.example.com"), &node);
+    node->setFlag(ZoneData::WILDCARD_NODE);
+    zone_data_->setSigned(true);
+    zone_data_->setMinTTL(1200);
+    zone_data_->setNSEC3Data(NSEC3Data::create(mem_sgmt_, zname_,
+                                               param_rdata_));
+    zone_data_->getNSEC3Data()->insertName(mem_sgmt_,
+                                           nsec3_rrset_->getName(), &node);
+    node->setData(RdataSet::create(mem_sgmt_, encoder_, nsec3_rrset_,
+                                   ConstRRsetPtr()));
+    zone_data_->buildNameIndex(mem_sgmt_);
+
+    ZoneData* copied = ZoneData::copy(mem_sgmt_, RRClass::IN(), *zone_data_);
+    EXPECT_EQ(zone_data_->getZoneTree().getNodeCount(),
+              copied->getZoneTree().getNodeCount());
+    EXPECT_TRUE(copied->isSigned());
+    EXPECT_EQ(RRTTL(1200), createRRTTL(copied->getMinTTLData()));
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              copied->getNameIndex());
+
+    // The RdataSets are copied in the same order.
+    const ZoneNode* found = NULL;
+    EXPECT_EQ(ZoneTree::EXACTMATCH,
+              copied->getZoneTree().find(a_rrset_->getName(), &found));
+    const RdataSet* rdataset = found->getData();
+    ASSERT_NE(static_cast<const RdataSet*>(NULL), rdataset);
+    EXPECT_NE(rdataset_aaaa, rdataset);
+    EXPECT_EQ(RRType::AAAA(), rdataset->type);
+    ASSERT_NE(static_cast<const RdataSet*>(NULL), rdataset->getNext());
+    EXPECT_EQ(RRType::A(), rdataset->getNext()->type);
+    EXPECT_EQ(static_cast<const RdataSet*>(NULL),
+              rdataset->getNext()->getNext());
+    // And so are the node flags.
+    EXPECT_EQ(ZoneTree::EXACTMATCH,
+              copied->getZoneTree().find(Name("wild.example.com"), &found));
+    EXPECT_TRUE(found->getFlag(ZoneData::WILDCARD_NODE));
+    EXPECT_EQ(ZoneTree::EXACTMATCH,
+              copied->getZoneTree().find(Name("*.wild.example.com"), &found));
+    EXPECT_FALSE(found->isEmpty());
+
+    const NSEC3Data* nsec3_data = copied->getNSEC3Data();
+    ASSERT_NE(static_cast<const NSEC3Data*>(NULL), nsec3_data);
+    EXPECT_NE(zone_data_->getNSEC3Data(), nsec3_data);
+    EXPECT_EQ(param_rdata_.getHashalg(), nsec3_data->hashalg);
+    EXPECT_EQ(param_rdata_.getFlags(), nsec3_data->flags);
+    EXPECT_EQ(param_rdata_.getIterations(), nsec3_data->iterations);
+    ASSERT_EQ(param_rdata_.getSalt().size(), nsec3_data->getSaltLen());
+    EXPECT_EQ(0, memcmp(&param_rdata_.getSalt()[0],
+                        nsec3_data->getSaltData(),
+                        param_rdata_.getSalt().size()));
+    EXPECT_EQ(ZoneTree::EXACTMATCH,
+              nsec3_data->getNSEC3Tree().find(nsec3_rrset_->getName(),
+                                              &found));
+    ASSERT_NE(static_cast<const RdataSet*>(NULL), found->getData());
+    EXPECT_EQ(RRType::NSEC3(), found->getData()->type);
+
+    // The copy is independent of the original.
+    copied->setSigned(false);
+    EXPECT_TRUE(zone_data_->isSigned());
+
+    ZoneData::destroy(mem_sgmt_, copied, RRClass::IN());
+}
+
+TEST_F(ZoneDataTest, copyExceptionSafety) {
+    addTestData(mem_sgmt_, encoder_, *zone_data_, "www.example.com.");
+    addTestData(mem_sgmt_, encoder_, *zone_data_, "a.b.example.com.");
+    zone_data_->setNSEC3Data(NSEC3Data::create(mem_sgmt_, zname_,
+                                               param_rdata_));
+
+    // Make the allocation fail at every possible point of the copy; it
+    // shouldn't leak (TearDown() would detect it).
+    for (size_t count = 1; ; ++count) {
+        mem_sgmt_.setThrowCount(count);
+        try {
+            ZoneData* copied = ZoneData::copy(mem_sgmt_, RRClass::IN(),
+                                              *zone_data_);
+            mem_sgmt_.setThrowCount(0);
+            ZoneData::destroy(mem_sgmt_, copied, RRClass::IN());
+            break;
+        } catch (const std::bad_alloc&) {}
+    }
+}
+
+// Add an NS RdataSet of the given target to the node of the given name.
+void
+addNSData(isc::util::MemorySegment& mem_sgmt, RdataEncoder& encoder,
+          ZoneData& zone_data, const std::string& name,
+          const std::string& target)
+{
+    ZoneNode* node = NULL;
+    zone_data.insertName(mem_sgmt, Name(name), &node);
+    node->setData(RdataSet::create(mem_sgmt, encoder,
+                                   textToRRset(name + " 3600 IN NS " + target),
+                                   ConstRRsetPtr()));
+}
+
+// Return the text of the NS RRset of the given name in the zone.
+std::string
+getNSText(const ZoneData& zone_data, const Name& name) {
+    const ZoneNode* node = NULL;
+    EXPECT_EQ(ZoneTree::EXACTMATCH, zone_data.getZoneTree().find(name, &node));
+    return (TreeNodeRRset(RRClass::IN(), node, node->getData(), true).
+            toText());
+}
+
+TEST_F(ZoneDataTest, nameDictionary) {
+    EXPECT_EQ(static_cast<const NameDictionary*>(NULL),
+              zone_data_->getNameDictionary());
+    zone_data_->createNameDictionary(mem_sgmt_);
+    NameDictionary* dictionary = zone_data_->getNameDictionary();
+    ASSERT_NE(static_cast<NameDictionary*>(NULL), dictionary);
+    // Creating it again is a no-op.
+    zone_data_->createNameDictionary(mem_sgmt_);
+    EXPECT_EQ(dictionary, zone_data_->getNameDictionary());
+
+    // Two delegations to the same name server share its name.
+    encoder_.setNameDictionary(dictionary);
+    addNSData(mem_sgmt_, encoder_, *zone_data_, "a.example.com.",
+              "ns.example.org.");
+    addNSData(mem_sgmt_, encoder_, *zone_data_, "b.example.com.",
+              "ns.example.org.");
+    EXPECT_EQ(1, dictionary->getNameCount());
+    EXPECT_EQ("a.example.com. 3600 IN NS ns.example.org.\n",
+              getNSText(*zone_data_, Name("a.example.com")));
+
+    const ZoneMemoryUsage usage = zone_data_->getMemoryUsage(RRClass::IN());
+    // The origin, a and b.
+    EXPECT_EQ(3, usage.node_count);
+    EXPECT_EQ(2, usage.rdataset_count);
+    EXPECT_EQ(1, usage.dictionary_name_count);
+    EXPECT_EQ(dictionary->getMemorySize(), usage.dictionary_size);
+    EXPECT_EQ(usage.node_size + usage.rdataset_size + usage.dictionary_size,
+              usage.getTotalSize());
+
+    // The copy has its own dictionary, and the same data.
+    ZoneData* copied = ZoneData::copy(mem_sgmt_, RRClass::IN(), *zone_data_);
+    const NameDictionary* copied_dictionary = copied->getNameDictionary();
+    ASSERT_NE(static_cast<const NameDictionary*>(NULL), copied_dictionary);
+    EXPECT_NE(dictionary, copied_dictionary);
+    EXPECT_EQ(1, copied_dictionary->getNameCount());
+    EXPECT_EQ(getNSText(*zone_data_, Name("b.example.com")),
+              getNSText(*copied, Name("b.example.com")));
+    const ZoneMemoryUsage copied_usage =
+        copied->getMemoryUsage(RRClass::IN());
+    EXPECT_EQ(usage.getTotalSize(), copied_usage.getTotalSize());
+    ZoneData::destroy(mem_sgmt_, copied, RRClass::IN());
+
+    // The copy doesn't leak if it fails at any point (TearDown() would
+    // detect it).
+    for (size_t count = 1; ; ++count) {
+        mem_sgmt_.setThrowCount(count);
+        try {
+            copied = ZoneData::copy(mem_sgmt_, RRClass::IN(), *zone_data_);
+            mem_sgmt_.setThrowCount(0);
+            ZoneData::destroy(mem_sgmt_, copied, RRClass::IN());
+            break;
+        } catch (const std::bad_alloc&) {}
+    }
+}
+
 TEST_F(ZoneDataTest, emptyData) {
     // normally create zone data are never "empty"
     EXPECT_FALSE(zone_data_->isEmpty());
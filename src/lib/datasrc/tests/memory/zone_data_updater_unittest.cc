@@ -26,6 +26,7 @@
 #include <dns/rrclass.h>
 #include <dns/rrset.h>
 #include <dns/rrttl.h>
+#include <dns/wire_rrset.h>
 
 #include <util/memory_segment_local.h>
 #include <util/memory_segment_mapped.h>
@@ -306,6 +307,62 @@ TEST_P(ZoneDataUpdaterTest, rrsigForNSEC3Only) {
                  isc::NotImplemented);
 }
 
+// Convert the given RRset to dns::WireRRset, which the loader passes for
+// well-known types.
+ConstRRsetPtr
+toWireRRset(const ConstRRsetPtr& rrset) {
+    boost::shared_ptr<WireRRset> wire_rrset(
+        new WireRRset(rrset->getName(), rrset->getClass(), rrset->getType(),
+                      rrset->getTTL()));
+    for (RdataIteratorPtr it = rrset->getRdataIterator(); !it->isLast();
+         it->next()) {
+        wire_rrset->addRdata(it->getCurrent());
+    }
+    return (wire_rrset);
+}
+
+TEST_P(ZoneDataUpdaterTest, wireRRsets) {
+    // NSEC3 and its RRSIG.  The NSEC3 parameters are taken from the RDATA.
+    updater_->add(toWireRRset(textToRRset(
+                      "AABB.example.org. 3600 IN NSEC3 1 0 10 AA 00000000 A")),
+                  toWireRRset(textToRRset(
+                      "AABB.example.org. 3600 IN RRSIG NSEC3 5 3 3600 "
+                      "20150420235959 20051021000000 1 example.org. FAKE")));
+    EXPECT_TRUE(getZoneData()->isNSEC3Signed());
+    ZoneNode* node = NULL;
+    getZoneData()->getNSEC3Data()->insertName(*mem_sgmt_,
+                                              Name("AABB.example.org"),
+                                              &node);
+    ASSERT_NE(static_cast<RdataSet*>(NULL), node->getData());
+    EXPECT_EQ(1, node->getData()->getRdataCount());
+    EXPECT_EQ(1, node->getData()->getSigRdataCount());
+    // Inconsistent parameters are rejected.
+    EXPECT_THROW(updater_->add(toWireRRset(textToRRset(
+                                   "09GM.example.org. 3600 IN NSEC3 "
+                                   "1 0 11 AA 00000000 A")),
+                               ConstRRsetPtr()),
+                 ZoneDataUpdater::AddError);
+
+    // RRSIG-only, with the covered type taken from the wire format.
+    updater_->add(ConstRRsetPtr(), toWireRRset(textToRRset(
+                      "www.example.org. 3600 IN RRSIG A 5 3 3600 "
+                      "20150420235959 20051021000000 1 example.org. FAKE")));
+    node = getNode(*mem_sgmt_, Name("www.example.org"), getZoneData());
+    ASSERT_NE(static_cast<RdataSet*>(NULL), node->getData());
+    EXPECT_EQ(RRType::A(), node->getData()->type);
+
+    // Mixed covered types are rejected.
+    boost::shared_ptr<WireRRset> sig_rrset(
+        new WireRRset(Name("www.example.org"), zclass_, RRType::RRSIG(),
+                      RRTTL(3600)));
+    sig_rrset->addRdata("A 5 3 3600 20150420235959 20051021000000 1 "
+                        "example.org. FAKE");
+    sig_rrset->addRdata("AAAA 5 3 3600 20150420235959 20051021000000 1 "
+                        "example.org. FAKE");
+    EXPECT_THROW(updater_->add(ConstRRsetPtr(), sig_rrset),
+                 ZoneDataUpdater::AddError);
+}
+
 // Generate many small RRsets. This tests that the underlying memory segment
 // can grow during the execution and that the updater handles that well.
 //
@@ -332,6 +389,113 @@ TEST_P(ZoneDataUpdaterTest, manySmallRRsets) {
     }
 }
 
+TEST_P(ZoneDataUpdaterTest, removeNull) {
+    // Same as add(), at least one of them must be non NULL.
+    EXPECT_THROW(updater_->remove(ConstRRsetPtr(), ConstRRsetPtr()),
+                 ZoneDataUpdater::NullRRset);
+}
+
+TEST_P(ZoneDataUpdaterTest, remove) {
+    updater_->add(textToRRset("www.example.org. 3600 IN A 192.0.2.1\n"
+                              "www.example.org. 3600 IN A 192.0.2.2"),
+                  textToRRset("www.example.org. 3600 IN RRSIG A 5 3 3600 "
+                              "20150420235959 20051021000000 1 "
+                              "example.org. FAKE"));
+    updater_->add(textToRRset("www.example.org. 3600 IN AAAA 2001:db8::1"),
+                  ConstRRsetPtr());
+    ZoneData* zone_data = getZoneData();
+    EXPECT_EQ(2, zone_data->getZoneTree().getNodeCount());
+
+    // Removing a part of the RRset leaves the rest intact.
+    updater_->remove(textToRRset("www.example.org. 3600 IN A 192.0.2.1"),
+                     ConstRRsetPtr());
+    ZoneNode* node = zone_data->findName(Name("www.example.org"));
+    ASSERT_NE(static_cast<ZoneNode*>(NULL), node);
+    const RdataSet* rdset = RdataSet::find(node->getData(), RRType::A());
+    ASSERT_NE(static_cast<RdataSet*>(NULL), rdset);
+    EXPECT_EQ(1, rdset->getRdataCount());
+    EXPECT_EQ(1, rdset->getSigRdataCount());
+
+    // Removing data that doesn't exist is a no-op.
+    updater_->remove(textToRRset("www.example.org. 3600 IN A 192.0.2.3"),
+                     ConstRRsetPtr());
+    updater_->remove(textToRRset("www.example.org. 3600 IN TXT \"test\""),
+                     ConstRRsetPtr());
+    updater_->remove(textToRRset("nx.example.org. 3600 IN A 192.0.2.1"),
+                     ConstRRsetPtr());
+    EXPECT_EQ(2, zone_data->getZoneTree().getNodeCount());
+
+    // Removing all the RDATAs (and the RRSIG) removes the RdataSet.
+    updater_->remove(textToRRset("www.example.org. 3600 IN A 192.0.2.2"),
+                     textToRRset("www.example.org. 3600 IN RRSIG A 5 3 3600 "
+                                 "20150420235959 20051021000000 1 "
+                                 "example.org. FAKE"));
+    node = zone_data->findName(Name("www.example.org"));
+    ASSERT_NE(static_cast<ZoneNode*>(NULL), node);
+    EXPECT_EQ(static_cast<const RdataSet*>(NULL),
+              RdataSet::find(node->getData(), RRType::A(), true));
+    EXPECT_NE(static_cast<const RdataSet*>(NULL),
+              RdataSet::find(node->getData(), RRType::AAAA()));
+
+    // And once the name is empty, it's removed from the tree.
+    updater_->remove(textToRRset("www.example.org. 3600 IN AAAA 2001:db8::1"),
+                     ConstRRsetPtr());
+    EXPECT_EQ(static_cast<ZoneNode*>(NULL),
+              zone_data->findName(Name("www.example.org")));
+    EXPECT_EQ(1, zone_data->getZoneTree().getNodeCount());
+}
+
+TEST_P(ZoneDataUpdaterTest, removeFlags) {
+    updater_->add(textToRRset("child.example.org. 3600 IN NS ns.example.com."),
+                  ConstRRsetPtr());
+    updater_->add(textToRRset("*.wild.example.org. 3600 IN A 192.0.2.1"),
+                  ConstRRsetPtr());
+    ZoneData* zone_data = getZoneData();
+    ZoneNode* node = zone_data->findName(Name("child.example.org"));
+    ASSERT_NE(static_cast<ZoneNode*>(NULL), node);
+    EXPECT_TRUE(node->getFlag(ZoneNode::FLAG_CALLBACK));
+    node = zone_data->findName(Name("wild.example.org"));
+    ASSERT_NE(static_cast<ZoneNode*>(NULL), node);
+    EXPECT_TRUE(node->getFlag(ZoneData::WILDCARD_NODE));
+
+    // Removing the delegation clears the zone cut mark (and the name).
+    updater_->remove(textToRRset("child.example.org. 3600 IN NS "
+                                 "ns.example.com."), ConstRRsetPtr());
+    EXPECT_EQ(static_cast<ZoneNode*>(NULL),
+              zone_data->findName(Name("child.example.org")));
+
+    // Removing the wildcard clears the wildcard mark of the parent.
+    updater_->add(textToRRset("wild.example.org. 3600 IN A 192.0.2.2"),
+                  ConstRRsetPtr());
+    updater_->remove(textToRRset("*.wild.example.org. 3600 IN A 192.0.2.1"),
+                     ConstRRsetPtr());
+    EXPECT_EQ(static_cast<ZoneNode*>(NULL),
+              zone_data->findName(Name("*.wild.example.org")));
+    node = zone_data->findName(Name("wild.example.org"));
+    ASSERT_NE(static_cast<ZoneNode*>(NULL), node);
+    EXPECT_FALSE(node->getFlag(ZoneData::WILDCARD_NODE));
+}
+
+TEST_P(ZoneDataUpdaterTest, removeNSEC3) {
+    updater_->add(textToRRset(
+                      "example.org. 3600 IN NSEC3PARAM 1 0 12 AABBCCDD"),
+                  ConstRRsetPtr());
+    updater_->add(textToRRset(
+                      "09GM5T42SMIMT7R8DF6RTG80SFMS1NLU.example.org. 3600 IN "
+                      "NSEC3 1 0 12 AABBCCDD 2T7B4G4VSA5SMI47K61MV5BV1A22BOJR "
+                      "A RRSIG"), ConstRRsetPtr());
+    const NSEC3Data* nsec3_data = getZoneData()->getNSEC3Data();
+    ASSERT_NE(static_cast<const NSEC3Data*>(NULL), nsec3_data);
+    EXPECT_EQ(2, nsec3_data->getNSEC3Tree().getNodeCount());
+
+    updater_->remove(textToRRset(
+                         "09GM5T42SMIMT7R8DF6RTG80SFMS1NLU.example.org. 3600 "
+                         "IN NSEC3 1 0 12 AABBCCDD "
+                         "2T7B4G4VSA5SMI47K61MV5BV1A22BOJR A RRSIG"),
+                     ConstRRsetPtr());
+    EXPECT_EQ(1, nsec3_data->getNSEC3Tree().getNodeCount());
+}
+
 TEST_P(ZoneDataUpdaterTest, updaterCollision) {
     ZoneData* zone_data = ZoneData::create(*mem_sgmt_,
                                            Name("another.example.com."));
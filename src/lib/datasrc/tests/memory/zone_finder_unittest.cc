@@ -680,6 +680,48 @@ TEST_F(InMemoryZoneFinderTest, glue) {
              NULL, ZoneFinder::FIND_GLUE_OK);
 }
 
+// Exact matches can be found via the name index of the zone; any other
+// lookup must fall back to the tree and get the same result as without it.
+TEST_F(InMemoryZoneFinderTest, nameIndex) {
+    addToZoneData(rr_a_);
+    addToZoneData(rr_ns_);
+    addToZoneData(rr_child_ns_);
+    addToZoneData(rr_child_glue_);
+    addToZoneData(rr_dname_);
+    addToZoneData(rr_wild_);
+    addToZoneData(rr_emptywild_);
+    updater_->buildNameIndex();
+    ASSERT_NE(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+
+    // Indexed names.
+    findTest(origin_, RRType::A(), ZoneFinder::SUCCESS, true, rr_a_);
+    findTest(origin_, RRType::AAAA(), ZoneFinder::NXRRSET, true);
+    findTest(Name("dname.example.org"), RRType::DNAME(), ZoneFinder::SUCCESS,
+             true, rr_dname_);
+    findTest(Name("child.example.org"), RRType::A(), ZoneFinder::DELEGATION,
+             true, rr_child_ns_);
+
+    // Names that aren't indexed.
+    findTest(rr_child_glue_->getName(), RRType::A(), ZoneFinder::DELEGATION,
+             true, rr_child_ns_);
+    findTest(rr_child_glue_->getName(), RRType::A(), ZoneFinder::SUCCESS, true,
+             rr_child_glue_, ZoneFinder::RESULT_DEFAULT, NULL,
+             ZoneFinder::FIND_GLUE_OK);
+    findTest(Name("below.dname.example.org"), RRType::A(), ZoneFinder::DNAME,
+             true, rr_dname_);
+    findTest(Name("foo.example.org"), RRType::A(), ZoneFinder::NXRRSET, true);
+    findTest(Name("a.wild.example.org"), RRType::A(), ZoneFinder::SUCCESS,
+             false, rr_wild_, ZoneFinder::RESULT_WILDCARD);
+    findTest(Name("nosuch.example.org"), RRType::A(), ZoneFinder::NXDOMAIN,
+             true);
+
+    // Adding data drops the index.
+    addToZoneData(rr_cname_);
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+}
+
 TEST_F(InMemoryZoneFinderTest, findAtOrigin) {
     // Add origin NS.
     rr_ns_->addRRsig(createRdata(RRType::RRSIG(), RRClass::IN(),
@@ -1664,6 +1706,18 @@ TEST_F(InMemoryZoneFinderNSEC3Test, findNSEC3) {
     performNSEC3Test(zone_finder_);
 }
 
+TEST_F(InMemoryZoneFinderNSEC3Test, findNSEC3WithHashCache) {
+    // The results should be the same when the hashes are calculated (and
+    // cached) and when they are taken from the cache.
+    NSEC3HashCache cache;
+    InMemoryZoneFinder finder(*zone_data_, class_, &cache);
+    performNSEC3Test(finder);
+    const size_t cache_size = cache.getSize();
+    EXPECT_LT(0, cache_size);
+    performNSEC3Test(finder);
+    EXPECT_EQ(cache_size, cache.getSize());
+}
+
 struct TestData {
      // String for the name passed to findNSEC3() (concatenated with
      // "example.org.")
@@ -0,0 +1,236 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/zone_writer.h>
+#include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/zone_data_loader.h>
+#include <datasrc/memory/zone_table_segment_mapped_zones.h>
+#include <datasrc/exceptions.h>
+
+#include <gtest/gtest.h>
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <cerrno>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace isc::dns;
+using namespace isc::datasrc;
+using namespace isc::datasrc::memory;
+using namespace isc::data;
+using boost::scoped_ptr;
+
+namespace {
+
+const char* const index_file = TEST_DATA_BUILDDIR "/test-zones.mapped";
+
+bool
+fileExists(const std::string& path) {
+    struct stat sb;
+    return (stat(path.c_str(), &sb) == 0);
+}
+
+std::string
+getZoneFile(int version) {
+    return (std::string(index_file) + "." +
+            boost::lexical_cast<std::string>(version));
+}
+
+ZoneData*
+loadZoneDataWrapper(isc::util::MemorySegment& segment, const Name& name) {
+    return (loadZoneData(segment, RRClass::IN(), name,
+                         TEST_DATA_DIR "/template.zone"));
+}
+
+ZoneData*
+failingLoadAction(isc::util::MemorySegment&) {
+    isc_throw(ZoneLoaderException, "faked loader exception");
+}
+
+class ZoneTableSegmentMappedZonesTest : public ::testing::Test {
+protected:
+    ZoneTableSegmentMappedZonesTest() :
+        writer_(ZoneTableSegment::create(RRClass::IN(), "mapped-zones")),
+        reader_(ZoneTableSegment::create(RRClass::IN(), "mapped-zones")),
+        config_params_(Element::fromJSON(
+                           "{\"mapped-file\": \"" + std::string(index_file) +
+                           "\"}"))
+    {}
+
+    ~ZoneTableSegmentMappedZonesTest() {
+        writer_.reset();
+        reader_.reset();
+        unlink(index_file);
+        for (int i = 1; i < 10; ++i) {
+            unlink(getZoneFile(i).c_str());
+        }
+    }
+
+    // Load the zone into the writer segment.
+    void loadZone(const Name& origin, bool fail = false) {
+        ZoneWriter writer(*writer_,
+                          fail ? LoadAction(failingLoadAction) :
+                          boost::bind(loadZoneDataWrapper, _1, origin),
+                          origin, RRClass::IN(), true);
+        writer.load();
+        writer.install();
+        writer.cleanup();
+    }
+
+    const ZoneData* findZone(ZoneTableSegment& segment, const Name& origin) {
+        const ZoneTable::FindResult result =
+            segment.getHeader().getTable()->findZone(origin);
+        EXPECT_EQ(isc::datasrc::result::SUCCESS, result.code);
+        return (result.zone_data);
+    }
+
+    scoped_ptr<ZoneTableSegment> writer_;
+    scoped_ptr<ZoneTableSegment> reader_;
+    const ConstElementPtr config_params_;
+};
+
+TEST_F(ZoneTableSegmentMappedZonesTest, getImplType) {
+    EXPECT_EQ("mapped-zones", writer_->getImplType());
+}
+
+TEST_F(ZoneTableSegmentMappedZonesTest, uninitialized) {
+    EXPECT_FALSE(writer_->isUsable());
+    EXPECT_FALSE(writer_->isWritable());
+    EXPECT_THROW(writer_->getHeader(), isc::InvalidOperation);
+    EXPECT_THROW(writer_->getMemorySegment(), isc::InvalidOperation);
+    EXPECT_THROW(writer_->getZoneSegment(Name("example.org")),
+                 isc::InvalidOperation);
+    // clear() is a no-op.
+    writer_->clear();
+}
+
+TEST_F(ZoneTableSegmentMappedZonesTest, resetBadConfig) {
+    EXPECT_THROW(writer_->reset(ZoneTableSegment::CREATE,
+                                ConstElementPtr()),
+                 isc::InvalidParameter);
+    EXPECT_THROW(writer_->reset(ZoneTableSegment::CREATE,
+                                Element::fromJSON("{}")),
+                 isc::InvalidParameter);
+    EXPECT_THROW(writer_->reset(ZoneTableSegment::CREATE,
+                                Element::fromJSON("{\"mapped-file\": 1}")),
+                 isc::InvalidParameter);
+    EXPECT_FALSE(writer_->isUsable());
+}
+
+TEST_F(ZoneTableSegmentMappedZonesTest, resetReadOnlyWithoutIndex) {
+    EXPECT_THROW(reader_->reset(ZoneTableSegment::READ_ONLY,
+                                config_params_),
+                 ResetFailed);
+    EXPECT_FALSE(reader_->isUsable());
+
+    // The writer can start without an index, and creates one.
+    writer_->reset(ZoneTableSegment::READ_WRITE, config_params_);
+    EXPECT_TRUE(writer_->isWritable());
+    EXPECT_EQ(0, writer_->getHeader().getTable()->getZoneCount());
+    writer_->clear();
+    EXPECT_FALSE(writer_->isUsable());
+    EXPECT_TRUE(fileExists(index_file));
+}
+
+TEST_F(ZoneTableSegmentMappedZonesTest, loadAndRead) {
+    writer_->reset(ZoneTableSegment::CREATE, config_params_);
+    loadZone(Name("example.org"));
+    loadZone(Name("example.com"));
+    loadZone(Name("example.net"), true); // installed as an empty zone
+    EXPECT_NE(static_cast<const ZoneData*>(NULL),
+              findZone(*writer_, Name("example.org")));
+
+    // Each zone has its own file (no file for the empty zone).
+    EXPECT_TRUE(fileExists(getZoneFile(1)));
+    EXPECT_TRUE(fileExists(getZoneFile(2)));
+    EXPECT_FALSE(fileExists(getZoneFile(3)));
+
+    // The index isn't written until the writer is done.
+    EXPECT_FALSE(fileExists(index_file));
+    writer_->reset(ZoneTableSegment::READ_ONLY, config_params_);
+    EXPECT_TRUE(fileExists(index_file));
+
+    reader_->reset(ZoneTableSegment::READ_ONLY, config_params_);
+    EXPECT_FALSE(reader_->isWritable());
+    EXPECT_EQ(3, reader_->getHeader().getTable()->getZoneCount());
+    EXPECT_NE(static_cast<const ZoneData*>(NULL),
+              findZone(*reader_, Name("example.org")));
+    EXPECT_NE(static_cast<const ZoneData*>(NULL),
+              findZone(*reader_, Name("example.com")));
+    const ZoneTable::FindResult result =
+        reader_->getHeader().getTable()->findZone(Name("example.net"));
+    EXPECT_EQ(isc::datasrc::result::SUCCESS, result.code);
+    EXPECT_EQ(isc::datasrc::result::ZONE_EMPTY, result.flags);
+
+    // A reader can't write.
+    EXPECT_THROW(ZoneWriter(*reader_, boost::bind(loadZoneDataWrapper, _1,
+                                                  Name("example.org")),
+                            Name("example.org"), RRClass::IN(), true),
+                 isc::InvalidOperation);
+}
+
+TEST_F(ZoneTableSegmentMappedZonesTest, updateZone) {
+    writer_->reset(ZoneTableSegment::CREATE, config_params_);
+    loadZone(Name("example.org"));
+    loadZone(Name("example.com"));
+    writer_->reset(ZoneTableSegment::READ_WRITE, config_params_);
+    reader_->reset(ZoneTableSegment::READ_ONLY, config_params_);
+    const ZoneData* const org_data = findZone(*reader_, Name("example.org"));
+    const ZoneData* const com_data = findZone(*reader_, Name("example.com"));
+
+    // Reload one of the zones.  It's built in a new file, and the old one
+    // is kept for the readers.
+    loadZone(Name("example.org"));
+    EXPECT_TRUE(fileExists(getZoneFile(1)));
+    EXPECT_TRUE(fileExists(getZoneFile(3)));
+    writer_->reset(ZoneTableSegment::READ_ONLY, config_params_);
+
+    // The reader only replaces the updated zone.
+    reader_->reset(ZoneTableSegment::READ_ONLY, config_params_);
+    EXPECT_NE(static_cast<const ZoneData*>(NULL),
+              findZone(*reader_, Name("example.org")));
+    EXPECT_NE(org_data, findZone(*reader_, Name("example.org")));
+    EXPECT_EQ(com_data, findZone(*reader_, Name("example.com")));
+
+    // The old file is removed when the writer starts the next update.
+    writer_->reset(ZoneTableSegment::READ_WRITE, config_params_);
+    EXPECT_FALSE(fileExists(getZoneFile(1)));
+    EXPECT_TRUE(fileExists(getZoneFile(2)));
+    EXPECT_TRUE(fileExists(getZoneFile(3)));
+}
+
+TEST_F(ZoneTableSegmentMappedZonesTest, abandonedWriter) {
+    writer_->reset(ZoneTableSegment::CREATE, config_params_);
+    loadZone(Name("example.org"));
+    {
+        ZoneWriter writer(*writer_, boost::bind(loadZoneDataWrapper, _1,
+                                                Name("example.org")),
+                          Name("example.org"), RRClass::IN(), true);
+        writer.load();
+        // Only one version of a zone can be built at a time.
+        EXPECT_THROW(writer_->getZoneSegment(Name("example.org")),
+                     isc::InvalidOperation);
+        EXPECT_TRUE(fileExists(getZoneFile(2)));
+    }
+    // The new version is discarded, and the old one is kept.
+    EXPECT_FALSE(fileExists(getZoneFile(2)));
+    EXPECT_NE(static_cast<const ZoneData*>(NULL),
+              findZone(*writer_, Name("example.org")));
+}
+
+}
@@ -126,7 +126,7 @@ private:
 // A test data source. It pretends it has some zones.
 
 MockDataSourceClient::MockDataSourceClient(const char* zone_names[]) :
-    have_a_(true), use_baditerator_(true)
+    have_a_(true), use_baditerator_(true), find_zone_count_(0)
 {
     for (const char** zone = zone_names; *zone; ++zone) {
         zones.insert(Name(*zone));
@@ -140,7 +140,7 @@ MockDataSourceClient::MockDataSourceClient(
     const data::ConstElementPtr& configuration) :
     type_(type),
     configuration_(configuration),
-    have_a_(true), use_baditerator_(true)
+    have_a_(true), use_baditerator_(true), find_zone_count_(0)
 {
     EXPECT_NE("MasterFiles", type) << "MasterFiles is a special case "
         "and it never should be created as a data source client";
@@ -153,6 +153,7 @@ MockDataSourceClient::MockDataSourceClient(
 
 DataSourceClient::FindResult
 MockDataSourceClient::findZone(const Name& name) const {
+    ++find_zone_count_;
     if (zones.empty()) {
         return (FindResult(result::NOTFOUND, ZoneFinderPtr()));
     }
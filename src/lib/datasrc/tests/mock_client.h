@@ -65,6 +65,9 @@ public:
     bool insertZone(const dns::Name& zone_name) {
         return (zones.insert(zone_name).second);
     }
+
+    /// \brief Return the number of times \c findZone() has been called.
+    size_t getFindZoneCount() const { return (find_zone_count_); }
     const std::string type_;
     const data::ConstElementPtr configuration_;
 
@@ -72,6 +75,7 @@ private:
     std::set<dns::Name> zones;
     bool have_a_; // control the iterator behavior whether to include A record
     bool use_baditerator_; // whether to use bogus zone iterators for tests
+    mutable size_t find_zone_count_; // number of findZone() calls
 };
 
 } // end of unittest
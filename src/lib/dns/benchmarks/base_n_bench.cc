@@ -0,0 +1,131 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <util/encode/base32hex.h>
+#include <util/encode/base64.h>
+#include <util/encode/hex.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace isc::bench;
+using namespace isc::util::encode;
+
+namespace {
+typedef string (*EncodeFunction)(const vector<uint8_t>&);
+typedef void (*DecodeFunction)(const string&, vector<uint8_t>&);
+
+class EncodeBenchMark {
+public:
+    EncodeBenchMark(EncodeFunction encode, const vector<uint8_t>& data) :
+        encode_(encode), data_(data)
+    {}
+    unsigned int run() {
+        const string encoded = encode_(data_);
+        assert(!encoded.empty());
+        return (1);
+    }
+private:
+    const EncodeFunction encode_;
+    const vector<uint8_t>& data_;
+};
+
+class DecodeBenchMark {
+public:
+    DecodeBenchMark(DecodeFunction decode, const string& text) :
+        decode_(decode), text_(text)
+    {}
+    unsigned int run() {
+        decode_(text_, result_);
+        assert(!result_.empty());
+        return (1);
+    }
+private:
+    const DecodeFunction decode_;
+    const string& text_;
+    vector<uint8_t> result_;
+};
+
+// The data sizes are those of typical DNSSEC data using each encoding:
+// a 2048-bit RSA signature or key (base64), an NSEC3 hash (base32hex)
+// and a SHA-256 DS digest (hex).
+struct Codec {
+    const char* name;
+    EncodeFunction encode;
+    DecodeFunction decode;
+    size_t data_len;
+};
+const Codec codecs[] = {
+    { "base64", encodeBase64, decodeBase64, 256 },
+    { "base32hex", encodeBase32Hex, decodeBase32Hex, 20 },
+    { "hex", encodeHex, decodeHex, 32 },
+    { NULL, NULL, NULL, 0 }
+};
+
+void
+usage() {
+    cerr << "Usage: base_n_bench [-n iterations]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 1000000;
+    while ((ch = getopt(argc, argv, "n:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0) {
+        usage();
+    }
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+
+    for (size_t i = 0; codecs[i].name != NULL; ++i) {
+        vector<uint8_t> data(codecs[i].data_len);
+        for (size_t j = 0; j < data.size(); ++j) {
+            data[j] = (j * 37 + 11) & 0xff;
+        }
+        const string text = codecs[i].encode(data);
+
+        cout << "Benchmark for encoding " << data.size() << " bytes in "
+             << codecs[i].name << endl;
+        BenchMark<EncodeBenchMark>(iteration,
+                                   EncodeBenchMark(codecs[i].encode, data));
+        cout << "Benchmark for decoding " << data.size() << " bytes in "
+             << codecs[i].name << endl;
+        BenchMark<DecodeBenchMark>(iteration,
+                                   DecodeBenchMark(codecs[i].decode, text));
+    }
+
+    return (0);
+}
@@ -0,0 +1,180 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <dns/master_loader.h>
+#include <dns/master_loader_callbacks.h>
+#include <dns/name.h>
+#include <dns/rdata.h>
+#include <dns/rrclass.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+
+#include <boost/bind.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace isc::bench;
+using namespace isc::dns;
+
+namespace {
+// Load a zone file with MasterLoader, either directly from the file (which
+// is then memory-mapped) or from an std::ifstream.  The number of
+// "iterations" is the number of loaded RRs, so the benchmark result is
+// given in records per second.
+class LoaderBenchMark {
+public:
+    LoaderBenchMark(const string& filename, const Name& origin,
+                    bool use_stream) :
+        filename_(filename), origin_(origin), use_stream_(use_stream),
+        count_(0)
+    {}
+    unsigned int run() {
+        count_ = 0;
+        const MasterLoaderCallbacks callbacks(
+            boost::bind(&LoaderBenchMark::reportIssue, this, _1, _2, _3),
+            boost::bind(&LoaderBenchMark::reportIssue, this, _1, _2, _3));
+        const AddRRCallback add_callback =
+            boost::bind(&LoaderBenchMark::addRR, this);
+        if (use_stream_) {
+            ifstream ifs(filename_.c_str());
+            MasterLoader loader(ifs, origin_, RRClass::IN(), callbacks,
+                                add_callback);
+            loader.load();
+        } else {
+            MasterLoader loader(filename_.c_str(), origin_, RRClass::IN(),
+                                callbacks, add_callback);
+            loader.load();
+        }
+        return (count_);
+    }
+private:
+    void reportIssue(const string& source, size_t line, const string& reason)
+    {
+        cerr << source << ":" << line << ": " << reason << endl;
+    }
+    void addRR() {
+        ++count_;
+    }
+
+    const string filename_;
+    const Name origin_;
+    const bool use_stream_;
+    unsigned int count_;
+};
+
+// Generate a synthetic zone of the given number of records (roughly) of
+// typical types, one per host name, to the given file.
+void
+generateZone(const string& filename, size_t records) {
+    ofstream ofs(filename.c_str());
+    ofs << "$ORIGIN example.org.\n$TTL 3600\n"
+        << "@ IN SOA ns1 hostmaster 2013010100 7200 3600 2592000 3600\n"
+        << "  IN NS ns1\n  IN NS ns2\n"
+        << "ns1 IN A 192.0.2.1\nns2 IN A 192.0.2.2\n";
+    for (size_t i = 5; i < records; ++i) {
+        ofs << "host" << i;
+        switch (i % 5) {
+        case 0:
+            ofs << " IN A 192.0." << (i / 256) % 256 << "." << i % 256;
+            break;
+        case 1:
+            ofs << " 7200 IN AAAA 2001:db8::" << hex << i % 65536 << dec;
+            break;
+        case 2:
+            ofs << " IN MX 10 mail" << i % 100 << ".example.org.";
+            break;
+        case 3:
+            ofs << " IN CNAME host" << i - 3;
+            break;
+        case 4:
+            ofs << " IN TXT \"v=spf1 ip4:192.0.2.0/24 -all\" ; comment";
+            break;
+        }
+        ofs << "\n";
+    }
+}
+
+void
+usage() {
+    cerr << "Usage: master_loader_bench [-n records] [-f zone_file "
+        "[-o origin]]" << endl;
+    cerr << "  Without -f, a zone of the given number of records is "
+        "generated and loaded" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    size_t records = 1000000;
+    string filename;
+    string origin = "example.org";
+    while ((ch = getopt(argc, argv, "n:f:o:")) != -1) {
+        switch (ch) {
+        case 'n':
+            records = atoi(optarg);
+            break;
+        case 'f':
+            filename = optarg;
+            break;
+        case 'o':
+            origin = optarg;
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0) {
+        usage();
+    }
+
+    const bool generate = filename.empty();
+    if (generate) {
+        const char* tmpdir = getenv("TMPDIR");
+        filename = string(tmpdir != NULL ? tmpdir : "/tmp") +
+            "/master_loader_bench.zone";
+        generateZone(filename, records);
+    }
+
+    cout << "Parameters:" << endl;
+    cout << "  Zone file: " << filename << endl;
+    if (generate) {
+        cout << "  Records: " << records << endl;
+    }
+
+    cout << "Benchmark for loading from the file (records/sec)" << endl;
+    BenchMark<LoaderBenchMark>(1, LoaderBenchMark(filename, Name(origin),
+                                                  false));
+    cout << "Benchmark for loading from a stream (records/sec)" << endl;
+    BenchMark<LoaderBenchMark>(1, LoaderBenchMark(filename, Name(origin),
+                                                  true));
+
+    if (generate) {
+        remove(filename.c_str());
+    }
+
+    return (0);
+}
@@ -0,0 +1,219 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <util/buffer.h>
+
+#include <dns/edns.h>
+#include <dns/labelsequence.h>
+#include <dns/message.h>
+#include <dns/message_view.h>
+#include <dns/messagerenderer.h>
+#include <dns/name.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rdata.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace std;
+using namespace isc::util;
+using namespace isc::bench;
+using namespace isc::dns;
+
+// Count the calls to the global operator new so we can show the number of
+// memory allocations per parsed message.
+namespace {
+size_t allocation_count = 0;
+}
+
+void*
+operator new(size_t size) throw(std::bad_alloc) {
+    ++allocation_count;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    return (p);
+}
+
+void
+operator delete(void* p) throw() {
+    free(p);
+}
+
+namespace {
+// Parse the same wire data with Message::fromWire(), the way b10-auth
+// handles a query: it takes the question and EDNS of the message.
+// If use_arena is true, the message allocates its objects from its arena.
+class MessageBenchMark {
+public:
+    MessageBenchMark(const vector<uint8_t>& data, bool use_arena) :
+        message_(new Message(Message::PARSE, use_arena)), data_(data)
+    {}
+    unsigned int run() {
+        message_->clear(Message::PARSE);
+        InputBuffer buffer(&data_[0], data_.size());
+        message_->fromWire(buffer);
+        const ConstQuestionPtr question = *message_->beginQuestion();
+        assert(question->getType() == RRType::A());
+        return (1);
+    }
+private:
+    boost::shared_ptr<Message> message_;
+    const vector<uint8_t>& data_;
+};
+
+// Same as the above, using MessageView.
+class MessageViewBenchMark {
+public:
+    MessageViewBenchMark(const vector<uint8_t>& data) :
+        view_(new MessageView), data_(data)
+    {}
+    unsigned int run() {
+        view_->parse(&data_[0], data_.size());
+        uint8_t buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+        const LabelSequence qname =
+            view_->getName(Message::SECTION_QUESTION, 0, buf);
+        assert(qname.getLabelCount() > 0);
+        assert(view_->getType(Message::SECTION_QUESTION, 0) == RRType::A());
+        return (1);
+    }
+private:
+    boost::shared_ptr<MessageView> view_;
+    const vector<uint8_t>& data_;
+};
+
+// Return the number of allocations for parsing the data once, after the
+// benchmark object has parsed it a few times to reach the steady state.
+template <typename T>
+size_t
+countAllocations(T& benchmark) {
+    for (int i = 0; i < 3; ++i) {
+        benchmark.run();
+    }
+    const size_t count_before = allocation_count;
+    benchmark.run();
+    return (allocation_count - count_before);
+}
+
+// Render a test message: a query for www.example.com/A with EDNS, or
+// a positive response to it with a typical set of RRs.
+vector<uint8_t>
+renderMessage(bool response) {
+    Message message(Message::RENDER);
+    message.setQid(0x1035);
+    message.setOpcode(Opcode::QUERY());
+    message.setRcode(Rcode::NOERROR());
+    message.setHeaderFlag(Message::HEADERFLAG_RD);
+    const Name qname("www.example.com");
+    message.addQuestion(Question(qname, RRClass::IN(), RRType::A()));
+    if (response) {
+        message.setHeaderFlag(Message::HEADERFLAG_QR);
+        message.setHeaderFlag(Message::HEADERFLAG_AA);
+        RRsetPtr answer(new RRset(qname, RRClass::IN(), RRType::A(),
+                                  RRTTL(3600)));
+        answer->addRdata(rdata::createRdata(RRType::A(), RRClass::IN(),
+                                            "192.0.2.1"));
+        answer->addRdata(rdata::createRdata(RRType::A(), RRClass::IN(),
+                                            "192.0.2.2"));
+        message.addRRset(Message::SECTION_ANSWER, answer);
+        RRsetPtr ns(new RRset(Name("example.com"), RRClass::IN(),
+                              RRType::NS(), RRTTL(3600)));
+        ns->addRdata(rdata::createRdata(RRType::NS(), RRClass::IN(),
+                                        "ns1.example.com."));
+        ns->addRdata(rdata::createRdata(RRType::NS(), RRClass::IN(),
+                                        "ns2.example.com."));
+        message.addRRset(Message::SECTION_AUTHORITY, ns);
+        for (int i = 1; i <= 2; ++i) {
+            RRsetPtr glue(new RRset(Name("ns" + string(1, '0' + i) +
+                                         ".example.com"),
+                                    RRClass::IN(), RRType::A(), RRTTL(3600)));
+            glue->addRdata(rdata::createRdata(RRType::A(), RRClass::IN(),
+                                              "192.0.2." +
+                                              string(1, '0' + i + 2)));
+            message.addRRset(Message::SECTION_ADDITIONAL, glue);
+        }
+    }
+    EDNSPtr edns(new EDNS());
+    edns->setUDPSize(4096);
+    edns->setDNSSECAwareness(true);
+    message.setEDNS(edns);
+    MessageRenderer renderer;
+    message.toWire(renderer);
+    const uint8_t* wire = static_cast<const uint8_t*>(renderer.getData());
+    return (vector<uint8_t>(wire, wire + renderer.getLength()));
+}
+
+void
+usage() {
+    cerr << "Usage: message_parse_bench [-n iterations]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 100000;
+    while ((ch = getopt(argc, argv, "n:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0) {
+        usage();
+    }
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+
+    for (int i = 0; i < 2; ++i) {
+        const bool response = (i == 1);
+        const string desc = response ? "(response)" : "(query)";
+        const vector<uint8_t> data = renderMessage(response);
+
+        MessageBenchMark message_bench(data, false);
+        cout << "Benchmark for Message " << desc << ": "
+             << countAllocations(message_bench) << " allocations" << endl;
+        BenchMark<MessageBenchMark>(iteration, message_bench);
+
+        MessageBenchMark arena_bench(data, true);
+        cout << "Benchmark for Message with arena " << desc << ": "
+             << countAllocations(arena_bench) << " allocations" << endl;
+        BenchMark<MessageBenchMark>(iteration, arena_bench);
+
+        MessageViewBenchMark view_bench(data);
+        cout << "Benchmark for MessageView " << desc << ": "
+             << countAllocations(view_bench) << " allocations" << endl;
+        BenchMark<MessageViewBenchMark>(iteration, view_bench);
+    }
+
+    return (0);
+}
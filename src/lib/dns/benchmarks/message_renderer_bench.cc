@@ -19,6 +19,8 @@
 #include <dns/messagerenderer.h>
 #include <oldmessagerenderer.h>
 
+#include <boost/shared_ptr.hpp>
+
 #include <cassert>
 #include <vector>
 
@@ -61,6 +63,35 @@ private:
     const vector<Name>& names_;
 };
 
+// Same as the above for MessageRenderer, but the hash values of the names
+// are calculated beforehand and the names are rendered by writeHashedName(),
+// the way TreeNodeRRset renders owner names.
+class HashedRendererBenchMark {
+public:
+    HashedRendererBenchMark(const vector<Name>& names) :
+        renderer_(new MessageRenderer), names_(names),
+        hashes_(names.size() * Name::MAX_LABELS)
+    {
+        for (size_t i = 0; i < names_.size(); ++i) {
+            MessageRenderer::computeNameHashes(
+                LabelSequence(names_[i]), &hashes_[i * Name::MAX_LABELS]);
+        }
+    }
+    unsigned int run() {
+        renderer_->clear();
+        for (size_t i = 0; i < names_.size(); ++i) {
+            renderer_->writeHashedName(LabelSequence(names_[i]),
+                                       &hashes_[i * Name::MAX_LABELS]);
+        }
+        assert(!renderer_->isTruncated());
+        return (names_.size());
+    }
+private:
+    boost::shared_ptr<MessageRenderer> renderer_;
+    const vector<Name>& names_;
+    vector<size_t> hashes_;
+};
+
 //
 // Builtin benchmark data.
 //
@@ -182,6 +213,11 @@ main(int argc, char* argv[]) {
         typedef MessageRendererBenchMark<MessageRenderer> RendererBenchMark;
         cout << "Benchmark for new MessageRenderer " << it->second << endl;
         BenchMark<RendererBenchMark>(iteration, RendererBenchMark(names));
+
+        cout << "Benchmark for new MessageRenderer with precomputed hashes "
+             << it->second << endl;
+        BenchMark<HashedRendererBenchMark>(iteration,
+                                           HashedRendererBenchMark(names));
     }
 
     return (0);
@@ -0,0 +1,211 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <dns/name.h>
+#include <dns/name_internal.h>
+#include <dns/labelsequence.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace isc::bench;
+using namespace isc::dns;
+using isc::dns::name::internal::maptolower;
+
+namespace {
+// The byte-by-byte implementations of the case-insensitive comparisons
+// used before they were vectorized, for comparison.
+bool
+oldEquals(const LabelSequence& ls1, const LabelSequence& ls2) {
+    size_t len1, len2;
+    const uint8_t* data1 = ls1.getData(&len1);
+    const uint8_t* data2 = ls2.getData(&len2);
+    if (len1 != len2) {
+        return (false);
+    }
+    for (size_t i = 0; i < len1; ++i) {
+        if (maptolower[data1[i]] != maptolower[data2[i]]) {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+// LabelSequence keeps the label offsets; we need to calculate them here.
+void
+getOffsets(const uint8_t* data, size_t labels, size_t* offsets) {
+    size_t pos = 0;
+    for (size_t i = 0; i < labels; ++i) {
+        offsets[i] = pos;
+        pos += data[pos] + 1;
+    }
+}
+
+// This only returns the order of the names, but otherwise does the same
+// amount of work as the old LabelSequence::compare().
+int
+oldCompare(const LabelSequence& ls1, const LabelSequence& ls2) {
+    size_t len1, len2;
+    const uint8_t* data1 = ls1.getData(&len1);
+    const uint8_t* data2 = ls2.getData(&len2);
+    size_t offsets1[Name::MAX_LABELS], offsets2[Name::MAX_LABELS];
+    getOffsets(data1, ls1.getLabelCount(), offsets1);
+    getOffsets(data2, ls2.getLabelCount(), offsets2);
+
+    int l1 = ls1.getLabelCount();
+    int l2 = ls2.getLabelCount();
+    const int ldiff = l1 - l2;
+    unsigned int l = (ldiff < 0) ? l1 : l2;
+    while (l > 0) {
+        --l;
+        --l1;
+        --l2;
+        size_t pos1 = offsets1[l1];
+        size_t pos2 = offsets2[l2];
+        const unsigned int count1 = data1[pos1++];
+        const unsigned int count2 = data2[pos2++];
+        const int cdiff = static_cast<int>(count1) - static_cast<int>(count2);
+        unsigned int count = (cdiff < 0) ? count1 : count2;
+        while (count > 0) {
+            const int chdiff = static_cast<int>(maptolower[data1[pos1]]) -
+                static_cast<int>(maptolower[data2[pos2]]);
+            if (chdiff != 0) {
+                return (chdiff);
+            }
+            --count;
+            ++pos1;
+            ++pos2;
+        }
+        if (cdiff != 0) {
+            return (cdiff);
+        }
+    }
+    return (ldiff);
+}
+
+// Compare each name with the next one in the list (and itself, in
+// different case), which is similar to what happens in a DomainTree
+// search.
+class CompareBenchMark {
+public:
+    CompareBenchMark(const vector<Name>& names, const vector<Name>& unames,
+                     bool old, bool equals) :
+        names_(names), unames_(unames), old_(old), equals_(equals)
+    {}
+    unsigned int run() {
+        unsigned int count = 0;
+        for (size_t i = 0; i + 1 < names_.size(); ++i) {
+            const LabelSequence ls1(names_[i]);
+            const LabelSequence ls2(names_[i + 1]);
+            const LabelSequence uls1(unames_[i]);
+            if (equals_) {
+                if (old_) {
+                    count += oldEquals(ls1, ls2) ? 1 : 0;
+                    count += oldEquals(ls1, uls1) ? 1 : 0;
+                } else {
+                    count += ls1.equals(ls2) ? 1 : 0;
+                    count += ls1.equals(uls1) ? 1 : 0;
+                }
+            } else {
+                if (old_) {
+                    count += oldCompare(ls1, ls2) < 0 ? 1 : 0;
+                    count += oldCompare(ls1, uls1) == 0 ? 1 : 0;
+                } else {
+                    count += ls1.compare(ls2).getOrder() < 0 ? 1 : 0;
+                    count += ls1.compare(uls1).getOrder() == 0 ? 1 : 0;
+                }
+            }
+        }
+        assert(count >= names_.size() - 1);
+        return ((names_.size() - 1) * 2);
+    }
+private:
+    const vector<Name>& names_;
+    const vector<Name>& unames_;
+    const bool old_;
+    const bool equals_;
+};
+
+// A sorted list of names of typical and longer lengths with common
+// suffixes, like those in a DomainTree.
+const char* const test_names[] = {
+    "example.com", "www.example.com", "mail.example.com",
+    "a.root-servers.net", "b.root-servers.net", "c.root-servers.net",
+    "a.gtld-servers.net", "b.gtld-servers.net",
+    "thisisalonglabelname.example.org",
+    "thisisalonglabelname.thisisalonglabelname.example.org",
+    "a-very-long-host-name-in-a-long-domain.subdomain.example.net",
+    "a-very-long-host-name-in-a-long-domain.subdomain2.example.net",
+    NULL
+};
+
+void
+usage() {
+    cerr << "Usage: name_compare_bench [-n iterations]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 1000000;
+    while ((ch = getopt(argc, argv, "n:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case '?':
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0) {
+        usage();
+    }
+
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+
+    vector<Name> names, unames;
+    for (size_t i = 0; test_names[i] != NULL; ++i) {
+        names.push_back(Name(test_names[i]));
+        string uname(test_names[i]);
+        for (size_t j = 0; j < uname.size(); ++j) {
+            uname[j] = toupper(uname[j]);
+        }
+        unames.push_back(Name(uname));
+    }
+
+    cout << "Benchmark for old LabelSequence::equals()" << endl;
+    BenchMark<CompareBenchMark>(iteration,
+                                CompareBenchMark(names, unames, true, true));
+    cout << "Benchmark for new LabelSequence::equals()" << endl;
+    BenchMark<CompareBenchMark>(iteration,
+                                CompareBenchMark(names, unames, false, true));
+    cout << "Benchmark for old LabelSequence::compare()" << endl;
+    BenchMark<CompareBenchMark>(iteration,
+                                CompareBenchMark(names, unames, true, false));
+    cout << "Benchmark for new LabelSequence::compare()" << endl;
+    BenchMark<CompareBenchMark>(iteration,
+                                CompareBenchMark(names, unames, false, false));
+
+    return (0);
+}
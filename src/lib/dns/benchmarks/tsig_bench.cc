@@ -0,0 +1,236 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <bench/benchmark.h>
+
+#include <util/buffer.h>
+
+#include <cryptolink/cryptolink.h>
+#include <cryptolink/crypto_hmac.h>
+
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/name.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#include <dns/tsig.h>
+#include <dns/tsigkey.h>
+#include <dns/tsigrecord.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+using boost::lexical_cast;
+using namespace isc::util;
+using namespace isc::bench;
+using namespace isc::cryptolink;
+using namespace isc::dns;
+
+namespace {
+// Sign a message with an HMAC object created for every message, which is
+// what TSIGContext used to do, for comparison.
+class CreateHMACBenchMark {
+public:
+    CreateHMACBenchMark(const TSIGKey& key, const vector<uint8_t>& data) :
+        key_(key), data_(data)
+    {}
+    unsigned int run() {
+        boost::scoped_ptr<HMAC> hmac(
+            CryptoLink::getCryptoLink().createHMAC(key_.getSecret(),
+                                                   key_.getSecretLength(),
+                                                   key_.getAlgorithm()));
+        hmac->update(&data_[0], data_.size());
+        hmac->sign(digest_, sizeof(digest_));
+        return (1);
+    }
+private:
+    const TSIGKey& key_;
+    const vector<uint8_t>& data_;
+    uint8_t digest_[64];
+};
+
+// The same with the pooled HMAC objects of the key.
+class PooledHMACBenchMark {
+public:
+    PooledHMACBenchMark(const TSIGKey& key, const vector<uint8_t>& data) :
+        key_(key), data_(data)
+    {}
+    unsigned int run() {
+        const boost::shared_ptr<HMAC> hmac(key_.getHMAC());
+        hmac->update(&data_[0], data_.size());
+        hmac->sign(digest_, sizeof(digest_));
+        return (1);
+    }
+private:
+    const TSIGKey& key_;
+    const vector<uint8_t>& data_;
+    uint8_t digest_[64];
+};
+
+// Sign a message with a new TSIGContext for the key in the key ring, as
+// a server does for each response (or a client for each request).
+class SignBenchMark {
+public:
+    SignBenchMark(const TSIGKeyRing& keyring, const TSIGKey& key,
+                  const vector<uint8_t>& data) :
+        keyring_(keyring), key_(key), data_(data)
+    {}
+    unsigned int run() {
+        TSIGContext ctx(key_.getKeyName(), key_.getAlgorithmName(),
+                        keyring_);
+        ctx.sign(0x1035, &data_[0], data_.size());
+        return (1);
+    }
+private:
+    const TSIGKeyRing& keyring_;
+    const TSIGKey& key_;
+    const vector<uint8_t>& data_;
+};
+
+// Verify a signed message with a new TSIGContext, as a server does for
+// each request.
+class VerifyBenchMark {
+public:
+    VerifyBenchMark(const TSIGKeyRing& keyring, const TSIGRecord& record,
+                    const vector<uint8_t>& data) :
+        keyring_(keyring), record_(record), data_(data)
+    {}
+    unsigned int run() {
+        TSIGContext ctx(record_.getName(), record_.getRdata().getAlgorithm(),
+                        keyring_);
+        const TSIGError error = ctx.verify(&record_, &data_[0],
+                                           data_.size());
+        assert(error == TSIGError::NOERROR());
+        return (1);
+    }
+private:
+    const TSIGKeyRing& keyring_;
+    const TSIGRecord& record_;
+    const vector<uint8_t>& data_;
+};
+
+// Render a typical (SOA) query, and sign it with the given context if
+// it's non NULL.
+void
+renderQuery(vector<uint8_t>& data, TSIGContext* ctx) {
+    Message message(Message::RENDER);
+    message.setQid(0x1035);
+    message.setOpcode(Opcode::QUERY());
+    message.setRcode(Rcode::NOERROR());
+    message.addQuestion(Question(Name("example.com"), RRClass::IN(),
+                                 RRType::SOA()));
+    MessageRenderer renderer;
+    message.toWire(renderer, ctx);
+    data.assign(static_cast<const uint8_t*>(renderer.getData()),
+                static_cast<const uint8_t*>(renderer.getData()) +
+                renderer.getLength());
+}
+
+void
+usage() {
+    cerr << "Usage: tsig_bench [-n iterations] [-k keys]" << endl;
+    exit (1);
+}
+}
+
+int
+main(int argc, char* argv[]) {
+    int ch;
+    int iteration = 100000;
+    int key_count = 100;
+    while ((ch = getopt(argc, argv, "n:k:")) != -1) {
+        switch (ch) {
+        case 'n':
+            iteration = atoi(optarg);
+            break;
+        case 'k':
+            key_count = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    if (argc != 0 || iteration <= 0 || key_count <= 0) {
+        usage();
+    }
+
+    const Name algorithms[] = {
+        TSIGKey::HMACMD5_NAME(), TSIGKey::HMACSHA1_NAME(),
+        TSIGKey::HMACSHA256_NAME(), TSIGKey::HMACSHA512_NAME()
+    };
+    const string secret = "a 32-byte secret for TSIG bench.";
+
+    // The keys of the ring only differ in the first labels of their names,
+    // and the algorithms are used in turn.
+    TSIGKeyRing keyring;
+    for (int i = 0; i < key_count; ++i) {
+        keyring.add(TSIGKey(Name("key-for-host" + lexical_cast<string>(i) +
+                                 ".example"),
+                            algorithms[i % 4], secret.c_str(),
+                            secret.size()));
+    }
+
+    vector<uint8_t> query;
+    renderQuery(query, NULL);
+    cout << "Parameters:" << endl;
+    cout << "  Iterations: " << iteration << endl;
+    cout << "  Keys in the key ring: " << key_count << endl;
+    cout << "  Message size: " << query.size() << " bytes" << endl;
+
+    for (int i = 0; i < 4 && i < key_count; ++i) {
+        const Name key_name("key-for-host" + lexical_cast<string>(i) +
+                            ".example");
+        const TSIGKey& key = *keyring.find(key_name).key;
+        cout << "Algorithm " << key.getAlgorithmName() << endl;
+
+        cout << "Benchmark for HMAC created per message" << endl;
+        BenchMark<CreateHMACBenchMark>(iteration,
+                                       CreateHMACBenchMark(key, query));
+        cout << "Benchmark for HMAC from the pool of the key" << endl;
+        BenchMark<PooledHMACBenchMark>(iteration,
+                                       PooledHMACBenchMark(key, query));
+
+        cout << "Benchmark for TSIG sign" << endl;
+        BenchMark<SignBenchMark>(iteration,
+                                 SignBenchMark(keyring, key, query));
+
+        vector<uint8_t> signed_query;
+        TSIGContext ctx(key);
+        renderQuery(signed_query, &ctx);
+        InputBuffer buffer(&signed_query[0], signed_query.size());
+        Message message(Message::PARSE);
+        message.fromWire(buffer);
+        cout << "Benchmark for TSIG verify" << endl;
+        BenchMark<VerifyBenchMark>(iteration,
+                                   VerifyBenchMark(keyring,
+                                                   *message.getTSIGRecord(),
+                                                   signed_query));
+    }
+
+    return (0);
+}
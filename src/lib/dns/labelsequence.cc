@@ -161,15 +161,8 @@ LabelSequence::equals(const LabelSequence& other, bool case_sensitive) const {
     // As long as the data was originally validated as (part of) a name,
     // label length must never be a capital ascii character, so we can
     // simply compare them after converting to lower characters.
-    for (size_t i = 0; i < len; ++i) {
-        const uint8_t ch = data[i];
-        const uint8_t other_ch = other_data[i];
-        if (isc::dns::name::internal::maptolower[ch] !=
-            isc::dns::name::internal::maptolower[other_ch]) {
-            return (false);
-        }
-    }
-    return (true);
+    return (isc::dns::name::internal::mismatchIgnoreCase(data, other_data,
+                                                         len) == len);
 }
 
 NameComparisonResult
@@ -200,31 +193,35 @@ LabelSequence::compare(const LabelSequence& other,
         assert(count1 <= Name::MAX_LABELLEN && count2 <= Name::MAX_LABELLEN);
 
         const int cdiff = static_cast<int>(count1) - static_cast<int>(count2);
-        unsigned int count = (cdiff < 0) ? count1 : count2;
-
-        while (count > 0) {
-            const uint8_t label1 = data_[pos1];
-            const uint8_t label2 = other.data_[pos2];
+        const unsigned int count = (cdiff < 0) ? count1 : count2;
+
+        // Find the first differing character of the labels, if any.
+        const uint8_t* const label1 = &data_[pos1];
+        const uint8_t* const label2 = &other.data_[pos2];
+        unsigned int i = 0;
+        if (case_sensitive) {
+            while (i < count && label1[i] == label2[i]) {
+                ++i;
+            }
+        } else {
+            i = isc::dns::name::internal::mismatchIgnoreCase(label1, label2,
+                                                             count);
+        }
+        if (i < count) {
             int chdiff;
-
             if (case_sensitive) {
-                chdiff = static_cast<int>(label1) - static_cast<int>(label2);
+                chdiff = static_cast<int>(label1[i]) -
+                    static_cast<int>(label2[i]);
             } else {
                 chdiff = static_cast<int>(
-                    isc::dns::name::internal::maptolower[label1]) -
+                    isc::dns::name::internal::maptolower[label1[i]]) -
                     static_cast<int>(
-                        isc::dns::name::internal::maptolower[label2]);
+                        isc::dns::name::internal::maptolower[label2[i]]);
             }
-
-            if (chdiff != 0) {
-                return (NameComparisonResult(
-                            chdiff, nlabels,
-                            nlabels == 0 ? NameComparisonResult::NONE :
-                            NameComparisonResult::COMMONANCESTOR));
-            }
-            --count;
-            ++pos1;
-            ++pos2;
+            return (NameComparisonResult(
+                        chdiff, nlabels,
+                        nlabels == 0 ? NameComparisonResult::NONE :
+                        NameComparisonResult::COMMONANCESTOR));
         }
         if (cdiff != 0) {
             return (NameComparisonResult(
@@ -277,11 +274,15 @@ LabelSequence::getHash(bool case_sensitive) const {
         length = 16;
     }
 
+    uint8_t buf[16];
+    if (!case_sensitive) {
+        isc::dns::name::internal::downcase(s, buf, length);
+        s = buf;
+    }
+
     size_t hash_val = 0;
     while (length > 0) {
-        const uint8_t c = *s++;
-        boost::hash_combine(hash_val, case_sensitive ? c :
-                            isc::dns::name::internal::maptolower[c]);
+        boost::hash_combine(hash_val, *s++);
         --length;
     }
     return (hash_val);
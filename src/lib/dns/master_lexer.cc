@@ -24,10 +24,15 @@
 
 #include <bitset>
 #include <cassert>
+#include <cstring>
 #include <limits>
 #include <string>
 #include <vector>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace isc {
 namespace dns {
 
@@ -42,6 +47,41 @@ const size_t MasterLexer::SOURCE_SIZE_UNKNOWN =
 
 namespace {
 typedef boost::shared_ptr<master_lexer_internal::InputSource> InputSourcePtr;
+
+// The characters that end or otherwise affect a string or number token
+// unless escaped: the separators (see MasterLexerImpl), the beginning of a
+// comment and the escape.
+const char SPECIAL_CHARS[] = " \t\n\r()\";\\";
+const size_t SPECIAL_CHARS_LEN = sizeof(SPECIAL_CHARS) - 1;
+
+// Return the length of the leading part of the data that consists of
+// "plain" characters, for which plain_chars is true.  The characters that
+// are not plain must be the non-ASCII ones (with the high bit set) and
+// SPECIAL_CHARS.  With SSE2, the data is examined 16 characters at a time.
+size_t
+findNonPlainChar(const char* data, size_t len, const bool* plain_chars) {
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= len; i += 16) {
+        const __m128i chars =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        unsigned int mask = _mm_movemask_epi8(chars); // non-ASCII ones
+        for (size_t j = 0; j < SPECIAL_CHARS_LEN; ++j) {
+            mask |= _mm_movemask_epi8(
+                _mm_cmpeq_epi8(chars, _mm_set1_epi8(SPECIAL_CHARS[j])));
+        }
+        if (mask != 0) {
+            return (i + __builtin_ctz(mask));
+        }
+    }
+#endif
+    for (; i < len; ++i) {
+        if (!plain_chars[static_cast<unsigned char>(data[i])]) {
+            break;
+        }
+    }
+    return (i);
+}
 } // end unnamed namespace
 using namespace master_lexer_internal;
 
@@ -63,6 +103,13 @@ struct MasterLexer::MasterLexerImpl {
         separators_.set('"');
         esc_separators_.set('\r');
         esc_separators_.set('\n');
+
+        // Non-ASCII characters are left to isTokenEnd().
+        for (size_t c = 0; c < 256; ++c) {
+            plain_chars_[c] = (c < 0x80 &&
+                               std::memchr(SPECIAL_CHARS, c,
+                                           SPECIAL_CHARS_LEN) == NULL);
+        }
     }
 
     // A helper method to skip possible comments toward the end of EOL or EOF.
@@ -81,6 +128,23 @@ struct MasterLexer::MasterLexerImpl {
         return (c);
     }
 
+    // Append the characters from the current position of the source to
+    // data_, as long as they are plain ones (see plain_chars_), so
+    // they don't have to be processed one by one.  This only takes the
+    // characters the source has buffered, so there may be more of them.
+    // Returns the number of the appended characters.
+    size_t appendPlainChars() {
+        size_t len;
+        const char* const data = source_->getBufferedData(&len);
+        if (len == 0) {
+            return (0);
+        }
+        const size_t plain_len = findNonPlainChar(data, len, plain_chars_);
+        data_.insert(data_.end(), data, data + plain_len);
+        source_->skipBufferedData(plain_len);
+        return (plain_len);
+    }
+
     bool isTokenEnd(int c, bool escaped) {
         // Special case of EOF (end of stream); this is not in the bitmaps
         if (c == InputSource::END_OF_STREAM) {
@@ -127,6 +191,10 @@ struct MasterLexer::MasterLexerImpl {
     std::bitset<128> separators_;
     std::bitset<128> esc_separators_;
 
+    // Whether a given character can be handled by appendPlainChars(),
+    // i.e., it's an ASCII character other than SPECIAL_CHARS.
+    bool plain_chars_[256];
+
     // These are to allow restoring state before previous token.
     bool has_previous_;
     size_t previous_paren_count_;
@@ -519,6 +587,9 @@ String::handle(MasterLexer& lexer) const {
 
     bool escaped = false;
     while (true) {
+        if (!escaped) {
+            getLexerImpl(lexer)->appendPlainChars();
+        }
         const int c = getLexerImpl(lexer)->skipComment(
             getLexerImpl(lexer)->source_->getChar(), escaped);
 
@@ -584,6 +655,14 @@ Number::handle(MasterLexer& lexer) const {
     bool escaped = false;
 
     while (true) {
+        if (!escaped) {
+            const size_t len = getLexerImpl(lexer)->appendPlainChars();
+            for (size_t i = data.size() - len; i < data.size(); ++i) {
+                if (!isdigit(data[i])) {
+                    digits_only = false;
+                }
+            }
+        }
         const int c = getLexerImpl(lexer)->skipComment(
             getLexerImpl(lexer)->source_->getChar(), escaped);
         if (getLexerImpl(lexer)->isTokenEnd(c, escaped)) {
@@ -21,6 +21,10 @@
 #include <cerrno>
 #include <cstring>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace isc {
 namespace dns {
 namespace master_lexer_internal {
@@ -82,6 +86,32 @@ getStreamSize(std::istream& is) {
     return (ret);
 }
 
+// Open the file for reading with read(2).  Returns -1 if it's not
+// a regular file or opening it fails; the caller will then read the file
+// as a stream.
+int
+openRegularFile(const char* filename) {
+    const int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return (-1);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return (-1);
+    }
+    return (fd);
+}
+
+// The maximum amount of data read from the input stream at a time.  If the
+// buffer has this much data that has been consumed (and it's at least half
+// of the buffer), compact() removes it.
+const size_t READ_CHUNK_SIZE = 4096;
+
+// The same for a file read with read(2).  Files are read in larger chunks
+// to save system calls.
+const size_t FILE_READ_CHUNK_SIZE = 65536;
+
 } // end of unnamed namespace
 
 // Explicit definition of class static constant.  The value is given in the
@@ -92,11 +122,14 @@ InputSource::InputSource(std::istream& input_stream) :
     at_eof_(false),
     line_(1),
     saved_line_(line_),
+    buffer_begin_(0),
     buffer_pos_(0),
     total_pos_(0),
     name_(createStreamName(input_stream)),
     input_(input_stream),
-    input_size_(getStreamSize(input_))
+    input_size_(getStreamSize(input_)),
+    fd_(-1),
+    file_read_size_(0)
 {}
 
 namespace {
@@ -124,48 +157,115 @@ InputSource::InputSource(const char* filename) :
     at_eof_(false),
     line_(1),
     saved_line_(line_),
+    buffer_begin_(0),
     buffer_pos_(0),
     total_pos_(0),
     name_(filename),
     input_(openFileStream(file_stream_, filename)),
-    input_size_(getStreamSize(input_))
-{}
+    input_size_(getStreamSize(input_)),
+    fd_(-1),
+    file_read_size_(0)
+{
+    // We open the file as a stream first anyway, so the errors are handled
+    // the same way as before and we can fall back to it.
+    if (input_size_ != MasterLexer::SOURCE_SIZE_UNKNOWN) {
+        fd_ = openRegularFile(filename);
+        if (fd_ >= 0) {
+            file_stream_.close();
+        }
+    }
+}
 
 InputSource::~InputSource()
 {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
     if (file_stream_.is_open()) {
         file_stream_.close();
     }
 }
 
+bool
+InputSource::readFile() {
+    const size_t old_size = buffer_.size();
+    buffer_.resize(old_size + FILE_READ_CHUNK_SIZE);
+    ssize_t count;
+    do {
+        count = read(fd_, &buffer_[old_size], FILE_READ_CHUNK_SIZE);
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0) {
+        const int error = errno;
+        buffer_.resize(old_size);
+        if (count < 0) {
+            isc_throw(MasterLexer::ReadError,
+                      "Error reading from the input file: " << getName() <<
+                      ": " << std::strerror(error));
+        }
+        // The file may have been truncated while we were reading it.  The
+        // rest of the file would be lost, so don't pretend it's the end.
+        if (file_read_size_ < input_size_) {
+            isc_throw(MasterLexer::ReadError,
+                      "Input file was truncated while reading: " <<
+                      getName());
+        }
+        return (false);
+    }
+    buffer_.resize(old_size + count);
+    file_read_size_ += count;
+    return (true);
+}
+
+bool
+InputSource::readStream() {
+    // Read as much data as the stream has available without blocking, up
+    // to READ_CHUNK_SIZE.
+    const size_t old_size = buffer_.size();
+    buffer_.resize(old_size + READ_CHUNK_SIZE);
+    std::streamsize count = input_.readsome(&buffer_[old_size],
+                                            READ_CHUNK_SIZE);
+    if (count <= 0) {
+        // Nothing is available now (or readsome() isn't supported for the
+        // stream).  Read a single character, which may block.
+        const int c = input_.get();
+        // Have we reached EOF now?  If so, return early.
+        if (input_.eof()) {
+            buffer_.resize(old_size);
+            return (false);
+        }
+        buffer_[old_size] = c;
+        count = 1;
+    }
+    // This has to come after the .eof() check as some
+    // implementations seem to check the eofbit also in .fail().
+    if (input_.fail()) {
+        buffer_.resize(old_size);
+        isc_throw(MasterLexer::ReadError,
+                  "Error reading from the input stream: " << getName());
+    }
+    buffer_.resize(old_size + count);
+    return (true);
+}
+
 int
 InputSource::getChar() {
-    if (buffer_pos_ == buffer_.size()) {
+    if (buffer_begin_ + buffer_pos_ == buffer_.size()) {
         // We may have reached EOF at the last call to
         // getChar(). at_eof_ will be set then. We then simply return
         // early.
         if (at_eof_) {
             return (END_OF_STREAM);
         }
-        // We are not yet at EOF. Read from the stream.
-        const int c = input_.get();
-        // Have we reached EOF now? If so, set at_eof_ and return early,
-        // but don't modify buffer_pos_ (which should still be equal to
-        // the size of buffer_).
-        if (input_.eof()) {
+        // We are not yet at EOF. Read from the stream.  If we have reached
+        // EOF now, set at_eof_ and return early, but don't modify
+        // buffer_pos_.
+        if (!(fd_ >= 0 ? readFile() : readStream())) {
             at_eof_ = true;
             return (END_OF_STREAM);
         }
-        // This has to come after the .eof() check as some
-        // implementations seem to check the eofbit also in .fail().
-        if (input_.fail()) {
-            isc_throw(MasterLexer::ReadError,
-                      "Error reading from the input stream: " << getName());
-        }
-        buffer_.push_back(c);
     }
 
-    const int c = buffer_[buffer_pos_];
+    const int c = buffer_[buffer_begin_ + buffer_pos_];
     ++buffer_pos_;
     ++total_pos_;
     if (c == '\n') {
@@ -185,7 +285,8 @@ InputSource::ungetChar() {
     } else {
         --buffer_pos_;
         --total_pos_;
-        if (buffer_[buffer_pos_] == '\n') {
+        const char c = buffer_[buffer_begin_ + buffer_pos_];
+        if (c == '\n') {
             --line_;
         }
     }
@@ -207,12 +308,17 @@ InputSource::saveLine() {
 
 void
 InputSource::compact() {
-    if (buffer_pos_ == buffer_.size()) {
+    buffer_begin_ += buffer_pos_;
+    if (buffer_begin_ == buffer_.size()) {
         buffer_.clear();
-    } else {
-        buffer_.erase(buffer_.begin(), buffer_.begin() + buffer_pos_);
+        buffer_begin_ = 0;
+    } else if (buffer_begin_ >= READ_CHUNK_SIZE &&
+               buffer_begin_ >= buffer_.size() / 2) {
+        // Moving the rest of the data costs no more than what we have
+        // consumed since the last time.
+        buffer_.erase(buffer_.begin(), buffer_.begin() + buffer_begin_);
+        buffer_begin_ = 0;
     }
-
     buffer_pos_ = 0;
 }
 
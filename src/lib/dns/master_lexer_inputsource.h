@@ -36,6 +36,13 @@ namespace master_lexer_internal {
 /// can have multiple InputSources if $INCLUDE is used. The source can
 /// also be generic input stream (std::istream).
 ///
+/// A regular file is read with \c read(2) in large chunks.  Data of an
+/// input stream is read in bulk as long as the stream has it available.
+/// In either case the data is kept in an internal buffer, and
+/// \c getBufferedData() gives access to the data that has been read but not
+/// consumed yet, so that the lexer can scan the data for the end of a token
+/// without calling \c getChar() for each character.
+///
 /// This class is not meant for public use. We also enforce that
 /// instances are non-copyable.
 class InputSource : boost::noncopyable {
@@ -73,6 +80,10 @@ public:
     /// \brief Constructor which takes a filename to read from. The
     /// associated file stream is managed internally.
     ///
+    /// If the file is a regular file, it's read with \c read(2) instead of
+    /// the stream.  If the file is truncated while it's being read,
+    /// \c getChar() throws \c MasterLexer::ReadError.
+    ///
     /// \throws OpenError when opening the input file fails or the size of
     /// the file cannot be detected.
     explicit InputSource(const char* filename);
@@ -149,9 +160,38 @@ public:
     /// of file is reached, \c END_OF_STREAM is returned.
     ///
     /// \throws MasterLexer::ReadError when reading from the input stream or
-    /// file fails.
+    /// file fails, or the file turns out to be shorter than its size at
+    /// the construction.
     int getChar();
 
+    /// \brief Returns the data that has already been read from the source
+    /// but not consumed by \c getChar() yet.
+    ///
+    /// The returned data is valid until the next call to a non-const
+    /// method of this class.  It can be empty even if the source isn't at
+    /// the end; \c getChar() reads more data as necessary.
+    ///
+    /// \param len Set to the length of the returned data.
+    /// \return A pointer to the data; it's undefined if \c len is 0.
+    const char* getBufferedData(size_t* len) const {
+        *len = buffer_.size() - buffer_begin_ - buffer_pos_;
+        return (*len > 0 ? &buffer_[buffer_begin_ + buffer_pos_] : NULL);
+    }
+
+    /// \brief Consume the given length of the data returned by
+    /// \c getBufferedData().
+    ///
+    /// This has the same effect as calling \c getChar() \c len times,
+    /// but the data must not contain a newline character (the caller is
+    /// expected to know that as it has examined the data).
+    ///
+    /// \param len The number of characters to consume.  It must not exceed
+    /// the length given by \c getBufferedData().
+    void skipBufferedData(size_t len) {
+        buffer_pos_ += len;
+        total_pos_ += len;
+    }
+
     /// \brief Skips backward a single character in the input
     /// source. The last-read character is unget.
     ///
@@ -168,11 +208,23 @@ public:
     void ungetAll();
 
 private:
+    // Read more data from the input stream into buffer_.  Returns false
+    // if the stream is at its end.
+    bool readStream();
+    // The same for the file read by fd_.
+    bool readFile();
+
     bool at_eof_;
     size_t line_;
     size_t saved_line_;
 
+    // Data read from the input stream or file.
     std::vector<char> buffer_;
+    // The position in buffer_ where compact() was last called.  The data
+    // before it is removed from time to time, not on every compact(), so
+    // the data read in bulk doesn't have to be moved for each token.
+    size_t buffer_begin_;
+    // The number of characters consumed since the last compact().
     size_t buffer_pos_;
     size_t total_pos_;
 
@@ -180,6 +232,12 @@ private:
     std::ifstream file_stream_;
     std::istream& input_;
     const size_t input_size_;
+
+    // The file descriptor of a regular file read with read(2); -1 if we
+    // read from input_.
+    int fd_;
+    // The number of bytes read from fd_.
+    size_t file_read_size_;
 };
 
 } // namespace master_lexer_internal
@@ -21,6 +21,8 @@
 #include <dns/rrtype.h>
 #include <dns/rdata.h>
 
+#include <util/buffer.h>
+
 #include <boost/format.hpp>
 #include <boost/algorithm/string/predicate.hpp> // for iequals
 #include <boost/scoped_ptr.hpp>
@@ -96,6 +98,7 @@ public:
         zone_class_(zone_class),
         callbacks_(callbacks),
         add_callback_(add_callback),
+        wire_buffer_(0),
         options_(options),
         master_file_(master_file),
         initialized_(false),
@@ -155,6 +158,11 @@ public:
     /// far. See \c MasterLexer::getTotalSourceSize().
     size_t getSize() const { return (lexer_.getTotalSourceSize()); }
 
+    /// \brief See \c MasterLoader::setAddWireCallback().
+    void setAddWireCallback(const AddWireRRCallback& add_wire_callback) {
+        add_wire_callback_ = add_wire_callback;
+    }
+
     /// \brief Return the line number being parsed in the pushed input
     /// sources. See \c MasterLexer::getPosition().
     size_t getPosition() const { return (lexer_.getPosition()); }
@@ -522,6 +530,8 @@ private:
     const RRClass zone_class_;
     MasterLoaderCallbacks callbacks_;
     const AddRRCallback add_callback_;
+    AddWireRRCallback add_wire_callback_; // Optional, see setAddWireCallback
+    util::OutputBuffer wire_buffer_; // Placeholder for wire-format RDATA
     boost::scoped_ptr<RRTTL> default_ttl_; // Default TTL of RRs used when
                                            // unspecified.  If NULL no default
                                            // is known.
@@ -972,18 +982,38 @@ MasterLoader::MasterLoaderImpl::loadIncremental(size_t count_limit) {
             const RRType rrtype = parseRRParams(explicit_ttl, next_token);
             // TODO: Check if it is SOA, it should be at the origin.
 
-            const rdata::RdataPtr rdata =
-                rdata::createRdata(rrtype, zone_class_, lexer_,
-                                   &active_origin_, options_, callbacks_);
-
-            // In case we get NULL, it means there was error creating
-            // the Rdata. The errors should have been reported by
+            // In case we fail to get the RDATA, it means there was error
+            // creating it. The errors should have been reported by
             // callbacks_ already. We need to decide if we want to continue
             // or not.
-            if (rdata) {
-                add_callback_(*last_name_, zone_class_, rrtype,
-                              getCurrentTTL(explicit_ttl, rrtype, rdata),
-                              rdata);
+            bool loaded = false;
+            if (!add_wire_callback_.empty() &&
+                rdata::canCreateWireRdata(rrtype, zone_class_)) {
+                // Note that SOA is never converted this way, so we don't
+                // need the RDATA to get the TTL.
+                if (rdata::createWireRdata(rrtype, zone_class_, lexer_,
+                                           &active_origin_, options_,
+                                           callbacks_, wire_buffer_)) {
+                    add_wire_callback_(
+                        *last_name_, zone_class_, rrtype,
+                        getCurrentTTL(explicit_ttl, rrtype,
+                                      rdata::ConstRdataPtr()),
+                        static_cast<const uint8_t*>(wire_buffer_.getData()),
+                        wire_buffer_.getLength());
+                    loaded = true;
+                }
+            } else {
+                const rdata::RdataPtr rdata =
+                    rdata::createRdata(rrtype, zone_class_, lexer_,
+                                       &active_origin_, options_, callbacks_);
+                if (rdata) {
+                    add_callback_(*last_name_, zone_class_, rrtype,
+                                  getCurrentTTL(explicit_ttl, rrtype, rdata),
+                                  rdata);
+                    loaded = true;
+                }
+            }
+            if (loaded) {
                 // Good, we loaded another one
                 ++count;
                 ++rr_count_;
@@ -1055,6 +1085,11 @@ MasterLoader::~MasterLoader() {
     delete impl_;
 }
 
+void
+MasterLoader::setAddWireCallback(const AddWireRRCallback& add_wire_callback) {
+    impl_->setAddWireCallback(add_wire_callback);
+}
+
 bool
 MasterLoader::loadIncremental(size_t count_limit) {
     const bool result = impl_->loadIncremental(count_limit);
@@ -102,6 +102,25 @@ public:
     /// \brief Destructor
     ~MasterLoader();
 
+    /// \brief Set the callback for RRs in the wire format.
+    ///
+    /// If set, RRs whose RDATA can be converted directly to the wire
+    /// format (see \c rdata::canCreateWireRdata()) are reported via
+    /// \c add_wire_callback instead of the \c add_callback given to the
+    /// constructor, skipping the construction of \c Rdata objects.  Other
+    /// RRs, including those generated by the $GENERATE directive, are still
+    /// reported via \c add_callback.  It's not set by default.
+    ///
+    /// It's expected to be called before the loading starts; if it's
+    /// called in the middle of loading, the new callback takes effect
+    /// from the next RR.
+    ///
+    /// \throw None
+    /// \param add_wire_callback The callback to be called with each RR
+    /// in the wire format.  If empty, all RRs are reported via the
+    /// \c add_callback.
+    void setAddWireCallback(const AddWireRRCallback& add_wire_callback);
+
     /// \brief Load some RRs
     ///
     /// This method loads at most count_limit RRs and reports them. In case
@@ -21,6 +21,8 @@
 #include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <stdint.h>
+
 namespace isc {
 namespace dns {
 class Name;
@@ -48,6 +50,24 @@ typedef boost::function<void(const Name& name, const RRClass& rrclass,
                              const rdata::RdataPtr& rdata)>
     AddRRCallback;
 
+/// \brief Type of callback to add a RR in the wire format.
+///
+/// This is a variant of \c AddRRCallback which receives the RDATA in the
+/// wire format instead of an \c Rdata object (see
+/// \c MasterLoader::setAddWireCallback()).  The data are only valid during
+/// the call; the callback needs to copy them if it wants to keep them.
+///
+/// \param name The domain name where the RR belongs.
+/// \param rrclass The class of the RR.
+/// \param rrtype Type of the RR.
+/// \param rrttl Time to live of the RR.
+/// \param data The wire-format RDATA of the RR.
+/// \param data_len The length of \c data in bytes.
+typedef boost::function<void(const Name& name, const RRClass& rrclass,
+                             const RRType& rrtype, const RRTTL& rrttl,
+                             const uint8_t* data, size_t data_len)>
+    AddWireRRCallback;
+
 /// \brief Set of issue callbacks for a loader.
 ///
 /// This holds a set of callbacks by which a loader (such as MasterLoader)
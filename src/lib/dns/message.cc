@@ -22,11 +22,14 @@
 
 #include <boost/foreach.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include <exceptions/exceptions.h>
 
 #include <util/buffer.h>
+#include <util/memory_arena.h>
 
 #include <dns/edns.h>
 #include <dns/exceptions.h>
@@ -93,10 +96,14 @@ const char* const sectiontext[] = {
 
 class MessageImpl {
 public:
-    MessageImpl(Message::Mode mode);
+    MessageImpl(Message::Mode mode, bool use_arena);
     // Open issues: should we rather have a header in wire-format
     // for efficiency?
     Message::Mode mode_;
+    // The arena for the parsed objects, if enabled.  The objects share
+    // its ownership (through their allocators), so it's kept until all of
+    // them are destroyed, even if they outlive the message.
+    boost::shared_ptr<MemoryArena> arena_;
     qid_t qid_;
 
     // We want to use NULL for [op,r]code_ to mean the code being not
@@ -121,8 +128,13 @@ public:
     // RRsetsSorter* sorter_; : TODO
 
     void init();
+    bool isArenaInUse() const;
     void setOpcode(const Opcode& opcode);
     void setRcode(const Rcode& rcode);
+    QuestionPtr createQuestion(const Name& name, const RRClass& rrclass,
+                               const RRType& rrtype);
+    RRsetPtr createRRset(const Name& name, const RRClass& rrclass,
+                         const RRType& rrtype, const RRTTL& ttl);
     int parseQuestion(InputBuffer& buffer);
     int parseSection(const Message::Section section, InputBuffer& buffer,
                      Message::ParseOptions options);
@@ -145,8 +157,9 @@ public:
     void toWire(AbstractMessageRenderer& renderer, TSIGContext* tsig_ctx);
 };
 
-MessageImpl::MessageImpl(Message::Mode mode) :
+MessageImpl::MessageImpl(Message::Mode mode, bool use_arena) :
     mode_(mode),
+    arena_(use_arena ? new MemoryArena : NULL),
     rcode_placeholder_(Rcode(0)), // as a placeholder the value doesn't matter
     opcode_placeholder_(Opcode(0)) // ditto
 {
@@ -155,6 +168,15 @@ MessageImpl::MessageImpl(Message::Mode mode) :
 
 void
 MessageImpl::init() {
+    // If the application still holds some objects from the arena, it
+    // can't be reused yet.  Check it before changing anything, so the
+    // message and those objects are left intact.
+    if (arena_ && isArenaInUse()) {
+        isc_throw(InvalidMessageOperation,
+                  "message cleared while objects from its arena "
+                  "are still in use");
+    }
+
     flags_ = 0;
     qid_ = 0;
     rcode_ = NULL;
@@ -171,6 +193,44 @@ MessageImpl::init() {
     rrsets_[Message::SECTION_ANSWER].clear();
     rrsets_[Message::SECTION_AUTHORITY].clear();
     rrsets_[Message::SECTION_ADDITIONAL].clear();
+
+    // All objects from the arena have now been released (checked above).
+    if (arena_) {
+        arena_->reset();
+    }
+}
+
+namespace {
+// Count p if it's an object from the arena that only the message refers
+// to, i.e., one that will be released when the message drops it.
+template <typename T>
+void
+countArenaObject(const MemoryArena& arena, const boost::shared_ptr<T>& p,
+                 size_t& count)
+{
+    if (p && p.unique() && arena.contains(p.get())) {
+        ++count;
+    }
+}
+}
+
+// Whether any object allocated from the arena is referenced outside the
+// message.  Each object from the arena is a single allocation (see
+// createQuestion() etc), so this is the case unless all of them are the
+// objects only the message refers to.
+bool
+MessageImpl::isArenaInUse() const {
+    size_t count = 0;
+    BOOST_FOREACH(const QuestionPtr& question, questions_) {
+        countArenaObject(*arena_, question, count);
+    }
+    for (int i = Message::SECTION_ANSWER; i < NUM_SECTIONS; ++i) {
+        BOOST_FOREACH(const RRsetPtr& rrset, rrsets_[i]) {
+            countArenaObject(*arena_, rrset, count);
+        }
+    }
+    countArenaObject(*arena_, tsig_rr_, count);
+    return (arena_->getAllocationCount() != count);
 }
 
 void
@@ -185,6 +245,28 @@ MessageImpl::setRcode(const Rcode& rcode) {
     rcode_ = &rcode_placeholder_;
 }
 
+QuestionPtr
+MessageImpl::createQuestion(const Name& name, const RRClass& rrclass,
+                            const RRType& rrtype)
+{
+    if (arena_) {
+        return (boost::allocate_shared<Question>(
+                    ArenaAllocator<Question>(arena_), name, rrclass, rrtype));
+    }
+    return (QuestionPtr(new Question(name, rrclass, rrtype)));
+}
+
+RRsetPtr
+MessageImpl::createRRset(const Name& name, const RRClass& rrclass,
+                         const RRType& rrtype, const RRTTL& ttl)
+{
+    if (arena_) {
+        return (boost::allocate_shared<RRset>(ArenaAllocator<RRset>(arena_),
+                                              name, rrclass, rrtype, ttl));
+    }
+    return (RRsetPtr(new RRset(name, rrclass, rrtype, ttl)));
+}
+
 namespace {
 // This helper class is used by MessageImpl::toWire() to render a set of
 // RRsets of a specific section of message to a given MessageRenderer.
@@ -385,8 +467,8 @@ MessageImpl::toWire(AbstractMessageRenderer& renderer, TSIGContext* tsig_ctx) {
     }
 }
 
-Message::Message(Mode mode) :
-    impl_(new MessageImpl(mode))
+Message::Message(Mode mode, bool use_arena) :
+    impl_(new MessageImpl(mode, use_arena))
 {}
 
 Message::~Message() {
@@ -680,7 +762,7 @@ MessageImpl::parseQuestion(InputBuffer& buffer) {
         // optimized algorithm that requires the question section contain
         // exactly one RR.
 
-        questions_.push_back(QuestionPtr(new Question(name, rrclass, rrtype)));
+        questions_.push_back(createQuestion(name, rrclass, rrtype));
         ++added;
     }
 
@@ -799,7 +881,7 @@ MessageImpl::addRR(Message::Section section, const Name& name,
             return;
         }
     }
-    RRsetPtr rrset(new RRset(name, rrclass, rrtype, ttl));
+    RRsetPtr rrset(createRRset(name, rrclass, rrtype, ttl));
     rrset->addRdata(rdata);
     rrsets_[section].push_back(rrset);
 }
@@ -818,7 +900,7 @@ MessageImpl::addRR(Message::Section section, const Name& name,
             return;
         }
     }
-    RRsetPtr rrset(new RRset(name, rrclass, rrtype, ttl));
+    RRsetPtr rrset(createRRset(name, rrclass, rrtype, ttl));
     rrsets_[section].push_back(rrset);
 }
 
@@ -857,10 +939,15 @@ MessageImpl::addTSIG(Message::Section section, unsigned int count,
     if (tsig_rr_) {
         isc_throw(DNSMessageFORMERR, "multiple TSIG RRs found");
     }
-    tsig_rr_ = ConstTSIGRecordPtr(new TSIGRecord(name, rrclass,
-                                                 ttl, rdata,
-                                                 buffer.getPosition() -
-                                                 start_position));
+    const size_t tsig_length = buffer.getPosition() - start_position;
+    if (arena_) {
+        tsig_rr_ = boost::allocate_shared<TSIGRecord>(
+            ArenaAllocator<TSIGRecord>(arena_), name, rrclass, ttl, rdata,
+            tsig_length);
+    } else {
+        tsig_rr_ = ConstTSIGRecordPtr(new TSIGRecord(name, rrclass, ttl, rdata,
+                                                     tsig_length));
+    }
 }
 
 namespace {
@@ -257,7 +257,31 @@ public:
 public:
     /// \brief The constructor.
     /// The mode of the message is specified by the \c mode parameter.
-    Message(Mode mode);
+    ///
+    /// If \c use_arena is true, the \c Question, \c RRset and
+    /// \c TSIGRecord objects created by \c fromWire() (along with their
+    /// shared pointer control blocks) are allocated from a memory arena
+    /// owned by the message instead of the global \c operator \c new.
+    /// The arena is reset by \c clear(), so everything the previous
+    /// message allocated is released at once, and a message reused for
+    /// many queries normally parses them without allocating memory for
+    /// those objects.
+    ///
+    /// The price is that such objects are only valid until the message is
+    /// cleared or destroyed: the application must not keep the pointers
+    /// obtained from the message (e.g., via \c beginSection() or
+    /// \c getTSIGRecord()) beyond that, nor append the sections of the
+    /// message to a message that lives longer.  \c clear() detects
+    /// pointers still held at that point and throws.  Such objects keep
+    /// the arena alive, so they remain valid even after the message is
+    /// destroyed, but then the whole arena is kept for them.  The arena
+    /// is disabled by default, and none of the servers currently enable
+    /// it.
+    ///
+    /// \param mode The mode of the message.
+    /// \param use_arena Whether to allocate the parsed objects from the
+    /// per-message arena.
+    Message(Mode mode, bool use_arena = false);
     /// \brief The destructor.
     ~Message();
 private:
@@ -525,6 +549,14 @@ public:
 
     /// \brief Clear the message content (if any) and reinitialize it in the
     /// specified mode.
+    ///
+    /// If the message uses a memory arena (see the constructor), the
+    /// arena is reset, too.
+    ///
+    /// \throw InvalidMessageOperation The message uses a memory arena and
+    /// some objects allocated from it are still referenced outside the
+    /// message.  The message (including the arena) is left unchanged in
+    /// that case, so the referenced objects remain valid.
     void clear(Mode mode);
 
     /// \brief Adds all rrsets from the source the given section in the
@@ -630,7 +662,8 @@ public:
     /// ordering conscious.  For example, in AXFR and IXFR, the position of
     /// the SOA RRs are crucial.
     ///
-    /// \exception InvalidMessageOperation \c Message is in the RENDER mode
+    /// \exception InvalidMessageOperation \c Message is in the RENDER mode,
+    /// or it uses a memory arena that can't be reset (see \c clear())
     /// \exception DNSMessageFORMERR The given message data is syntactically
     /// \exception MessageTooShort The given data is shorter than a valid
     /// header section
@@ -0,0 +1,459 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <exceptions/exceptions.h>
+
+#include <util/buffer.h>
+#include <util/io_utilities.h>
+
+#include <dns/exceptions.h>
+#include <dns/message_view.h>
+#include <dns/name.h>
+#include <dns/rdata.h>
+#include <dns/rdataclass.h>
+
+#include <boost/utility/in_place_factory.hpp>
+
+#include <cstring>
+
+using namespace isc::dns::rdata;
+using isc::util::InputBuffer;
+using isc::util::readUint16;
+using isc::util::readUint32;
+
+namespace isc {
+namespace dns {
+
+namespace {
+// protocol constants (see message.cc)
+const size_t HEADERLEN = 12;
+
+const unsigned int OPCODE_MASK = 0x7800;
+const unsigned int OPCODE_SHIFT = 11;
+const unsigned int RCODE_MASK = 0x000f;
+const unsigned int HEADERFLAG_MASK = 0x87b0;
+
+const unsigned int MAX_LABELLEN = 63;
+const unsigned int COMPRESS_POINTER_MARK8 = 0xc0;
+
+// The TTL field of the OPT RR (see edns.cc)
+const unsigned int EDNS_VERSION_SHIFT = 16;
+const unsigned int EDNS_EXTRCODE_SHIFT = 24;
+const uint32_t EDNS_VERSION_MASK = 0x00ff0000;
+const uint32_t EDNS_EXTFLAG_DO = 0x00008000;
+
+const char* const sectiontext[] = {
+    "QUESTION",
+    "ANSWER",
+    "AUTHORITY",
+    "ADDITIONAL"
+};
+
+// Read the wire-format name at pos of the message data, and return the
+// position following it (not following any compression pointers).  The
+// checks are the same as those of the Name constructor from an
+// InputBuffer.
+//
+// If buf isn't NULL, the name is stored there in the serialized form of
+// LabelSequence.
+size_t
+readName(const uint8_t* data, size_t length, size_t pos,
+         uint8_t* buf = NULL)
+{
+    uint8_t offsets[Name::MAX_LABELS];
+    // We don't know the number of labels until we're done, so the name
+    // data are first stored after the space for the largest possible
+    // offsets, and moved next to the actual offsets at the end.
+    uint8_t* const ndata = (buf != NULL) ? buf + 1 + Name::MAX_LABELS : NULL;
+    unsigned int label_count = 0;
+    size_t nused = 0;
+    size_t end = 0;             // set on the first pointer or the end
+    size_t biggest_pointer = pos;
+
+    while (true) {
+        if (pos >= length) {
+            isc_throw(DNSMessageFORMERR, "incomplete wire-format name");
+        }
+        const unsigned int c = data[pos++];
+        if (c <= MAX_LABELLEN) {
+            if (nused + c + 1 > Name::MAX_WIRE) {
+                isc_throw(DNSMessageFORMERR, "wire name is too long: "
+                          << nused + c + 1 << " bytes");
+            }
+            if (pos + c > length) {
+                isc_throw(DNSMessageFORMERR, "incomplete wire-format name");
+            }
+            offsets[label_count++] = nused;
+            if (ndata != NULL) {
+                std::memcpy(ndata + nused, data + pos - 1, c + 1);
+            }
+            nused += c + 1;
+            pos += c;
+            if (c == 0) {
+                break;
+            }
+        } else if ((c & COMPRESS_POINTER_MARK8) == COMPRESS_POINTER_MARK8) {
+            if (pos >= length) {
+                isc_throw(DNSMessageFORMERR, "incomplete wire-format name");
+            }
+            const size_t new_pos = ((c & ~COMPRESS_POINTER_MARK8) << 8) |
+                data[pos++];
+            if (end == 0) {
+                end = pos;
+            }
+            if (new_pos >= biggest_pointer) {
+                isc_throw(DNSMessageFORMERR,
+                          "bad compression pointer (out of range): " <<
+                          new_pos);
+            }
+            biggest_pointer = new_pos;
+            pos = new_pos;
+        } else {
+            // this case includes local compression pointer, which hasn't
+            // been standardized.
+            isc_throw(DNSMessageFORMERR, "unknown label character: " << c);
+        }
+    }
+
+    if (buf != NULL) {
+        buf[0] = label_count;
+        std::memmove(buf + 1 + label_count, ndata, nused);
+        std::memcpy(buf + 1, offsets, label_count);
+    }
+    return (end != 0 ? end : pos);
+}
+}
+
+MessageView::MessageView() :
+    data_(NULL), length_(0), qid_(0), flags_(0), opcode_(0), rcode_(0),
+    tsig_length_(0)
+{
+    clear();
+}
+
+void
+MessageView::clear() {
+    data_ = NULL;
+    length_ = 0;
+    rrs_.clear();
+    for (int i = 0; i <= NUM_SECTIONS; ++i) {
+        section_begin_[i] = 0;
+    }
+    edns_ = boost::none;
+    tsig_length_ = 0;
+}
+
+void
+MessageView::parse(const void* data, size_t length) {
+    clear();
+
+    if (length < HEADERLEN) {
+        isc_throw(MessageTooShort, "Malformed DNS message (short length): "
+                  << length);
+    }
+
+    const uint8_t* const dp = static_cast<const uint8_t*>(data);
+    qid_ = readUint16(dp, length);
+    const uint16_t codes_and_flags = readUint16(dp + 2, length - 2);
+    opcode_ = Opcode((codes_and_flags & OPCODE_MASK) >> OPCODE_SHIFT);
+    rcode_ = Rcode(codes_and_flags & RCODE_MASK);
+    flags_ = (codes_and_flags & HEADERFLAG_MASK);
+    unsigned int counts[NUM_SECTIONS];
+    for (int i = 0; i < NUM_SECTIONS; ++i) {
+        counts[i] = readUint16(dp + 4 + i * 2, length - 4 - i * 2);
+    }
+
+    data_ = dp;
+    length_ = length;
+    try {
+        size_t pos = parseQuestions(HEADERLEN,
+                                    counts[Message::SECTION_QUESTION]);
+        for (int i = Message::SECTION_ANSWER; i < NUM_SECTIONS; ++i) {
+            section_begin_[i] = rrs_.size();
+            pos = parseSection(static_cast<Message::Section>(i), pos,
+                               counts[i]);
+        }
+        section_begin_[NUM_SECTIONS] = rrs_.size();
+    } catch (...) {
+        clear();
+        throw;
+    }
+}
+
+size_t
+MessageView::parseQuestions(size_t pos, unsigned int count) {
+    for (unsigned int i = 0; i < count; ++i) {
+        RRInfo rr;
+        rr.name_pos = pos;
+        pos = readName(data_, length_, pos);
+        if (length_ - pos < 2 * sizeof(uint16_t)) {
+            isc_throw(DNSMessageFORMERR, "Question section too short: " <<
+                      (length_ - pos) << " bytes");
+        }
+        rr.type = readUint16(data_ + pos, length_ - pos);
+        rr.rrclass = readUint16(data_ + pos + 2, length_ - pos - 2);
+        rr.ttl = 0;
+        rr.rdata_pos = 0;
+        rr.rdata_len = 0;
+        pos += 2 * sizeof(uint16_t);
+        rrs_.push_back(rr);
+    }
+    return (pos);
+}
+
+size_t
+MessageView::parseSection(const Message::Section section, size_t pos,
+                          unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i) {
+        const size_t start_pos = pos;
+        RRInfo rr;
+        rr.name_pos = pos;
+        pos = readName(data_, length_, pos);
+
+        // buffer must store at least RR TYPE, RR CLASS, TTL, and RDLEN.
+        if (length_ - pos < 3 * sizeof(uint16_t) + sizeof(uint32_t)) {
+            isc_throw(DNSMessageFORMERR, sectiontext[section] <<
+                      " section too short: " << (length_ - pos) << " bytes");
+        }
+        rr.type = readUint16(data_ + pos, length_ - pos);
+        rr.rrclass = readUint16(data_ + pos + 2, length_ - pos - 2);
+        rr.ttl = readUint32(data_ + pos + 4, length_ - pos - 4);
+        rr.rdata_len = readUint16(data_ + pos + 8, length_ - pos - 8);
+        pos += 3 * sizeof(uint16_t) + sizeof(uint32_t);
+        rr.rdata_pos = pos;
+        if (length_ - pos < rr.rdata_len) {
+            isc_throw(DNSMessageFORMERR, sectiontext[section] <<
+                      " section too short for RDATA: " << (length_ - pos) <<
+                      " bytes");
+        }
+        pos += rr.rdata_len;
+
+        // Like Message::fromWire(), an RR of class ANY or NONE with empty
+        // RDATA is a normal RR whatever its type.
+        const RRClass rrclass(rr.rrclass);
+        if ((rrclass == RRClass::ANY() || rrclass == RRClass::NONE()) &&
+            rr.rdata_len == 0) {
+            rrs_.push_back(rr);
+        } else if (rr.type == RRType::OPT().getCode()) {
+            setEDNS(section, rr);
+        } else if (rr.type == RRType::TSIG().getCode()) {
+            if (section != Message::SECTION_ADDITIONAL) {
+                isc_throw(DNSMessageFORMERR,
+                          "TSIG RR found in an invalid section");
+            }
+            if (i != count - 1) {
+                isc_throw(DNSMessageFORMERR, "TSIG RR is not the last record");
+            }
+            tsig_ = rr;
+            tsig_length_ = pos - start_pos;
+        } else {
+            rrs_.push_back(rr);
+        }
+    }
+    return (pos);
+}
+
+void
+MessageView::setEDNS(const Message::Section section, const RRInfo& rr) {
+    if (section != Message::SECTION_ADDITIONAL) {
+        isc_throw(DNSMessageFORMERR,
+                  "EDNS OPT RR found in an invalid section");
+    }
+    if (edns_) {
+        isc_throw(DNSMessageFORMERR, "multiple EDNS OPT RR found");
+    }
+
+    // The same checks as the EDNS constructor and the OPT RDATA, in the
+    // same order.
+    const uint8_t version = (rr.ttl & EDNS_VERSION_MASK) >>
+        EDNS_VERSION_SHIFT;
+    if (version > EDNS::SUPPORTED_VERSION) {
+        isc_throw(DNSMessageBADVERS, "unsupported EDNS version: " <<
+                  static_cast<unsigned int>(version));
+    }
+    uint8_t name_buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    readName(data_, length_, rr.name_pos, name_buf);
+    if (name_buf[0] != 1) {
+        isc_throw(DNSMessageFORMERR, "invalid owner name for EDNS OPT RR: "
+                  << LabelSequence(name_buf));
+    }
+    size_t pos = rr.rdata_pos;
+    size_t rdata_len = rr.rdata_len;
+    while (rdata_len > 0) {
+        if (rdata_len < 4) {
+            isc_throw(InvalidRdataLength,
+                      "Pseudo OPT RR record too short: "
+                      << rdata_len << " bytes");
+        }
+        const uint16_t option_length = readUint16(data_ + pos + 2, 2);
+        rdata_len -= 4;
+        if (rdata_len < option_length) {
+            isc_throw(InvalidRdataLength, "Corrupt pseudo OPT RR record");
+        }
+        pos += 4 + option_length;
+        rdata_len -= option_length;
+    }
+
+    edns_ = boost::in_place(version);
+    edns_->setUDPSize(rr.rrclass);
+    edns_->setDNSSECAwareness((rr.ttl & EDNS_EXTFLAG_DO) != 0);
+    rcode_ = Rcode(rcode_.getCode(), rr.ttl >> EDNS_EXTRCODE_SHIFT);
+}
+
+void
+MessageView::checkParsed() const {
+    if (data_ == NULL) {
+        isc_throw(InvalidMessageOperation, "No message parsed in the view");
+    }
+}
+
+qid_t
+MessageView::getQid() const {
+    checkParsed();
+    return (qid_);
+}
+
+bool
+MessageView::getHeaderFlag(const Message::HeaderFlag flag) const {
+    checkParsed();
+    if (flag == 0 || (flag & ~HEADERFLAG_MASK) != 0) {
+        isc_throw(InvalidParameter,
+                  "MessageView::getHeaderFlag:: Invalid flag is specified: "
+                  << flag);
+    }
+    return ((flags_ & flag) != 0);
+}
+
+const Opcode&
+MessageView::getOpcode() const {
+    checkParsed();
+    return (opcode_);
+}
+
+const Rcode&
+MessageView::getRcode() const {
+    checkParsed();
+    return (rcode_);
+}
+
+unsigned int
+MessageView::getRRCount(const Message::Section section) const {
+    checkParsed();
+    if (section < 0 || section >= NUM_SECTIONS) {
+        isc_throw(OutOfRange, "Invalid message section: " << section);
+    }
+    return (section_begin_[section + 1] - section_begin_[section]);
+}
+
+const MessageView::RRInfo&
+MessageView::getRRInfo(const Message::Section section, size_t index) const {
+    if (index >= getRRCount(section)) {
+        isc_throw(OutOfRange, "RR index out of range in " <<
+                  sectiontext[section] << " section: " << index);
+    }
+    return (rrs_[section_begin_[section] + index]);
+}
+
+LabelSequence
+MessageView::getName(const Message::Section section, size_t index,
+                     uint8_t buf[LabelSequence::MAX_SERIALIZED_LENGTH]) const
+{
+    readName(data_, length_, getRRInfo(section, index).name_pos, buf);
+    return (LabelSequence(buf));
+}
+
+RRType
+MessageView::getType(const Message::Section section, size_t index) const {
+    return (RRType(getRRInfo(section, index).type));
+}
+
+RRClass
+MessageView::getClass(const Message::Section section, size_t index) const {
+    return (RRClass(getRRInfo(section, index).rrclass));
+}
+
+RRTTL
+MessageView::getTTL(const Message::Section section, size_t index) const {
+    const RRInfo& rr = getRRInfo(section, index);
+    if (section == Message::SECTION_QUESTION) {
+        isc_throw(InvalidMessageSection,
+                  "TTL requested for the question section");
+    }
+    return (RRTTL(rr.ttl));
+}
+
+QuestionPtr
+MessageView::createQuestion(size_t index) const {
+    const RRInfo& rr = getRRInfo(Message::SECTION_QUESTION, index);
+    InputBuffer buffer(data_, length_);
+    buffer.setPosition(rr.name_pos);
+    return (QuestionPtr(new Question(Name(buffer), RRClass(rr.rrclass),
+                                     RRType(rr.type))));
+}
+
+RRsetPtr
+MessageView::createRRset(const Message::Section section, size_t index) const
+{
+    const RRInfo& rr = getRRInfo(section, index);
+    if (section == Message::SECTION_QUESTION) {
+        isc_throw(InvalidMessageSection,
+                  "RRset requested for the question section");
+    }
+    InputBuffer buffer(data_, length_);
+    buffer.setPosition(rr.name_pos);
+    const RRClass rrclass(rr.rrclass);
+    const RRType rrtype(rr.type);
+    RRsetPtr rrset(new RRset(Name(buffer), rrclass, rrtype, RRTTL(rr.ttl)));
+    // If class is ANY or NONE, rdlength may be zero, to signal an empty
+    // RRset (see Message::fromWire()).
+    if (!((rrclass == RRClass::ANY() || rrclass == RRClass::NONE()) &&
+          rr.rdata_len == 0)) {
+        buffer.setPosition(rr.rdata_pos);
+        rrset->addRdata(createRdata(rrtype, rrclass, buffer, rr.rdata_len));
+    }
+    return (rrset);
+}
+
+const EDNS*
+MessageView::getEDNS() const {
+    checkParsed();
+    return (edns_ ? &*edns_ : NULL);
+}
+
+bool
+MessageView::hasTSIGRecord() const {
+    checkParsed();
+    return (tsig_length_ != 0);
+}
+
+ConstTSIGRecordPtr
+MessageView::createTSIGRecord() const {
+    if (!hasTSIGRecord()) {
+        return (ConstTSIGRecordPtr());
+    }
+    InputBuffer buffer(data_, length_);
+    buffer.setPosition(tsig_.name_pos);
+    const Name name(buffer);
+    buffer.setPosition(tsig_.rdata_pos);
+    const RRClass rrclass(tsig_.rrclass);
+    const ConstRdataPtr rdata = createRdata(RRType::TSIG(), rrclass, buffer,
+                                            tsig_.rdata_len);
+    return (ConstTSIGRecordPtr(new TSIGRecord(name, rrclass,
+                                              RRTTL(tsig_.ttl), *rdata,
+                                              tsig_length_)));
+}
+
+} // namespace dns
+} // namespace isc
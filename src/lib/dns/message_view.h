@@ -0,0 +1,245 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef MESSAGE_VIEW_H
+#define MESSAGE_VIEW_H 1
+
+#include <dns/edns.h>
+#include <dns/labelsequence.h>
+#include <dns/message.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+#include <dns/tsigrecord.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace dns {
+
+/// \brief A read-only view of a DNS message in wire format.
+///
+/// \c MessageView is a lightweight alternative to the \c PARSE mode of
+/// \c Message for applications that only need a small part of an incoming
+/// message, such as the question and EDNS of a query.
+/// \c Message::fromWire() builds a \c Question, \c RRset, \c Name and
+/// \c Rdata object, each with its own memory allocation, for every entry of
+/// the message.  \c parse() of this class instead validates the message
+/// and only records where each RR is in the wire data.  The RRs can then
+/// be examined in place, and the complete objects are created only when
+/// they're explicitly requested.
+///
+/// Like \c Message, a \c MessageView object is expected to be reused for
+/// many messages.  Its internal table of RRs is kept across calls to
+/// \c parse(), and only grows when a message has more RRs than any
+/// previous one, so parsing normally involves no memory allocation.
+///
+/// The view refers to the wire data passed to \c parse(); the data must be
+/// kept valid and unmodified as long as the view is used for it.
+///
+/// \c parse() checks the same structural constraints as
+/// \c Message::fromWire(): the header, the owner names (including the
+/// compression pointers), the field lengths, and the placement and validity
+/// of the EDNS OPT and TSIG RRs.  The RDATA other than that of OPT,
+/// however, are only checked to fit in the message; they're fully validated
+/// when they're converted to \c Rdata objects by \c createRRset() or
+/// \c createTSIGRecord().  RRs aren't combined into RRsets either: each RR
+/// is accessed by its index in the section, as with the
+/// \c Message::PRESERVE_ORDER option.
+class MessageView : boost::noncopyable {
+public:
+    /// \brief The default constructor.
+    ///
+    /// The view is empty until a message is successfully parsed.
+    MessageView();
+
+    /// \brief Parse a DNS message in wire format.
+    ///
+    /// If it fails, the view is emptied, and the exception of the failure
+    /// is propagated.
+    ///
+    /// \throw MessageTooShort The data is too short for the header.
+    /// \throw DNSMessageFORMERR The message is malformed.
+    /// \throw DNSMessageBADVERS The message has EDNS of an unsupported
+    /// version.
+    /// \throw InvalidRdataLength The RDATA of an OPT RR are broken.
+    ///
+    /// \param data The wire-format data of the message.
+    /// \param length The length of \c data in bytes.
+    void parse(const void* data, size_t length);
+
+    /// \brief Empty the view.
+    ///
+    /// \throw none
+    void clear();
+
+    /// \brief Return whether a message has been successfully parsed.
+    ///
+    /// The other accessors throw \c InvalidMessageOperation unless this
+    /// is true.
+    ///
+    /// \throw none
+    bool isParsed() const { return (data_ != NULL); }
+
+    /// \brief Return the query ID of the message.
+    qid_t getQid() const;
+
+    /// \brief Return whether the specified header flag bit is set.
+    ///
+    /// \throw InvalidParameter The flag isn't valid (see
+    /// \c Message::getHeaderFlag()).
+    bool getHeaderFlag(const Message::HeaderFlag flag) const;
+
+    /// \brief Return the Opcode of the message.
+    const Opcode& getOpcode() const;
+
+    /// \brief Return the Rcode of the message.
+    ///
+    /// If the message has EDNS, the extended part of the Rcode is
+    /// included.
+    const Rcode& getRcode() const;
+
+    /// \brief Return the number of RRs in the given section.
+    ///
+    /// Like \c Message::getRRCount(), the OPT and TSIG RRs aren't counted.
+    ///
+    /// \throw OutOfRange The section isn't valid.
+    unsigned int getRRCount(const Message::Section section) const;
+
+    /// \brief Return the owner name of the RR (or the question) at the
+    /// given position.
+    ///
+    /// The name is decompressed into the given buffer, so the returned
+    /// \c LabelSequence is valid as long as \c buf is.
+    ///
+    /// \throw OutOfRange The section or the index isn't valid.
+    ///
+    /// \param section The section of the RR.
+    /// \param index The index of the RR in the section.
+    /// \param buf A placeholder for the name data.
+    LabelSequence getName(const Message::Section section, size_t index,
+                          uint8_t buf[LabelSequence::MAX_SERIALIZED_LENGTH])
+        const;
+
+    /// \brief Return the type of the RR (or the question) at the given
+    /// position.
+    ///
+    /// \throw OutOfRange The section or the index isn't valid.
+    RRType getType(const Message::Section section, size_t index) const;
+
+    /// \brief Return the class of the RR (or the question) at the given
+    /// position.
+    ///
+    /// \throw OutOfRange The section or the index isn't valid.
+    RRClass getClass(const Message::Section section, size_t index) const;
+
+    /// \brief Return the TTL of the RR at the given position.
+    ///
+    /// \throw OutOfRange The section or the index isn't valid.
+    /// \throw InvalidMessageSection The section is the question section.
+    RRTTL getTTL(const Message::Section section, size_t index) const;
+
+    /// \brief Create a \c Question object for the question at the given
+    /// position.
+    ///
+    /// \throw OutOfRange The index isn't valid.
+    /// \throw std::bad_alloc Memory allocation fails.
+    QuestionPtr createQuestion(size_t index) const;
+
+    /// \brief Create an \c RRset object containing the RR at the given
+    /// position.
+    ///
+    /// As with \c Message::fromWire(), the RRset is empty if the RR is of
+    /// class ANY or NONE and has empty RDATA.
+    ///
+    /// \throw OutOfRange The section or the index isn't valid.
+    /// \throw InvalidMessageSection The section is the question section.
+    /// \throw DNSMessageFORMERR or other exception of \c createRdata()
+    /// The RDATA aren't valid for the type of the RR.
+    /// \throw std::bad_alloc Memory allocation fails.
+    RRsetPtr createRRset(const Message::Section section, size_t index) const;
+
+    /// \brief Return the EDNS of the message.
+    ///
+    /// \return A pointer to an \c EDNS object in the view, or NULL if the
+    /// message doesn't have EDNS.  It's valid until the view is cleared or
+    /// used for another message.
+    const EDNS* getEDNS() const;
+
+    /// \brief Return whether the message is signed with TSIG.
+    bool hasTSIGRecord() const;
+
+    /// \brief Create a \c TSIGRecord object for the TSIG RR of the message.
+    ///
+    /// \throw DNSMessageFORMERR The TSIG RR isn't valid.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \return The TSIG record, or a NULL pointer if the message isn't
+    /// signed.
+    ConstTSIGRecordPtr createTSIGRecord() const;
+
+private:
+    // Where to find an RR (or a question) in the wire data.
+    struct RRInfo {
+        uint32_t name_pos;
+        uint32_t rdata_pos;
+        uint16_t type;
+        uint16_t rrclass;
+        uint32_t ttl;
+        uint16_t rdata_len;
+    };
+
+    static const int NUM_SECTIONS = 4;
+
+    const RRInfo& getRRInfo(const Message::Section section, size_t index)
+        const;
+    void checkParsed() const;
+    size_t parseQuestions(size_t pos, unsigned int count);
+    size_t parseSection(const Message::Section section, size_t pos,
+                        unsigned int count);
+    void setEDNS(const Message::Section section, const RRInfo& rr);
+
+    const uint8_t* data_;       // NULL unless a message is parsed
+    size_t length_;
+    qid_t qid_;
+    uint16_t flags_;
+    Opcode opcode_;
+    Rcode rcode_;
+    // The RRs of all sections, except OPT and TSIG.  section_begin_[i] is
+    // the index of the first RR of the i-th section, and
+    // section_begin_[NUM_SECTIONS] is the number of the RRs.
+    std::vector<RRInfo> rrs_;
+    size_t section_begin_[NUM_SECTIONS + 1];
+    boost::optional<EDNS> edns_;
+    RRInfo tsig_;
+    size_t tsig_length_;        // the RR length; 0 if there's no TSIG
+};
+
+} // namespace dns
+} // namespace isc
+
+#endif  // MESSAGE_VIEW_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -24,11 +24,11 @@
 
 #include <limits>
 #include <cassert>
+#include <cstring>
 #include <vector>
 
 using namespace std;
 using namespace isc::util;
-using isc::dns::name::internal::maptolower;
 
 namespace isc {
 namespace dns {
@@ -72,78 +72,78 @@ struct NameCompare {
     /// \brief Constructor
     ///
     /// \param buffer The buffer for rendering used in the caller renderer
-    /// \param name_buf An input buffer storing the wire-format data of the
-    /// name to be newly rendered (and only that data).
+    /// \param name_data The wire-format data of the name to be newly
+    /// rendered (and only that data).
+    /// \param name_len The length of \c name_data.
     /// \param hash The hash value for the name.
-    NameCompare(const OutputBuffer& buffer, InputBuffer& name_buf,
-                size_t hash) :
-        buffer_(&buffer), name_buf_(&name_buf), hash_(hash)
+    NameCompare(const OutputBuffer& buffer, const uint8_t* name_data,
+                size_t name_len, size_t hash) :
+        buffer_(&buffer), name_data_(name_data), name_len_(name_len),
+        hash_(hash)
     {}
 
     bool operator()(const OffsetItem& item) const {
         // Trivial inequality check.  If either the hash or the total length
         // doesn't match, the names are obviously different.
-        if (item.hash_  != hash_ || item.len_ != name_buf_->getLength()) {
+        if (item.hash_  != hash_ || item.len_ != name_len_) {
             return (false);
         }
 
-        // Compare the name data, character-by-character.
-        // item_pos keeps track of the position in the buffer corresponding to
-        // the character to compare.  item_label_len is the number of
-        // characters in the labels where the character pointed by item_pos
-        // belongs.  When it reaches zero, nextPosition() identifies the
-        // position for the subsequent label, taking into account name
-        // compression, and resets item_label_len to the length of the new
-        // label.
-        name_buf_->setPosition(0); // buffer can be reused, so reset position
+        // Compare the name data, label-by-label (including the length
+        // byte of each label).  The labels of the stored name may be
+        // scattered in the buffer due to name compression, but a pointer
+        // can only be placed at the beginning of a label, so within a label
+        // we can compare the data as a whole.
+        const uint8_t* const buffer_data =
+            static_cast<const uint8_t*>(buffer_->getData());
         uint16_t item_pos = item.pos_;
-        uint16_t item_label_len = 0;
-        for (size_t i = 0; i < item.len_; ++i, ++item_pos) {
-            item_pos = nextPosition(*buffer_, item_pos, item_label_len);
-            const uint8_t ch1 = (*buffer_)[item_pos];
-            const uint8_t ch2 = name_buf_->readUint8();
+        size_t pos = 0;
+        while (pos < name_len_) {
+            item_pos = skipPointers(buffer_data, item_pos);
+            const size_t len = buffer_data[item_pos] + 1;
+            if (pos + len > name_len_) {
+                return (false);
+            }
             if (CASE_SENSITIVE) {
-                if (ch1 != ch2) {
+                if (std::memcmp(buffer_data + item_pos, name_data_ + pos,
+                                len) != 0) {
                     return (false);
                 }
             } else {
-                if (maptolower[ch1] != maptolower[ch2]) {
+                if (name::internal::mismatchIgnoreCase(buffer_data + item_pos,
+                                                       name_data_ + pos,
+                                                       len) != len) {
                     return (false);
                 }
             }
+            item_pos += len;
+            pos += len;
         }
 
         return (true);
     }
 
 private:
-    uint16_t nextPosition(const OutputBuffer& buffer,
-                          uint16_t pos, uint16_t& llen) const
-    {
-        if (llen == 0) {
-            size_t i = 0;
-
-            while ((buffer[pos] & Name::COMPRESS_POINTER_MARK8) ==
-                   Name::COMPRESS_POINTER_MARK8) {
-                pos = (buffer[pos] & ~Name::COMPRESS_POINTER_MARK8) *
-                    256 + buffer[pos + 1];
-
-                // This loop should stop as long as the buffer has been
-                // constructed validly and the search/insert argument is based
-                // on a valid name, which is an assumption for this class.
-                // But we'll abort if a bug could cause an infinite loop.
-                i += 2;
-                assert(i < Name::MAX_WIRE);
-            }
-            llen = buffer[pos];
-        } else {
-            --llen;
+    static uint16_t skipPointers(const uint8_t* buffer_data, uint16_t pos) {
+        size_t i = 0;
+        while ((buffer_data[pos] & Name::COMPRESS_POINTER_MARK8) ==
+               Name::COMPRESS_POINTER_MARK8) {
+            pos = (buffer_data[pos] & ~Name::COMPRESS_POINTER_MARK8) *
+                256 + buffer_data[pos + 1];
+
+            // This loop should stop as long as the buffer has been
+            // constructed validly and the search/insert argument is based
+            // on a valid name, which is an assumption for this class.
+            // But we'll abort if a bug could cause an infinite loop.
+            i += 2;
+            assert(i < Name::MAX_WIRE);
         }
         return (pos);
     }
 
     const OutputBuffer* buffer_;
-    InputBuffer* name_buf_;
+    const uint8_t* const name_data_;
+    const size_t name_len_;
     const size_t hash_;
 };
 }
@@ -178,8 +178,9 @@ struct MessageRenderer::MessageRendererImpl {
         }
     }
 
-    uint16_t findOffset(const OutputBuffer& buffer, InputBuffer& name_buf,
-                        size_t hash, bool case_sensitive) const
+    uint16_t findOffset(const OutputBuffer& buffer, const uint8_t* name_data,
+                        size_t name_len, size_t hash,
+                        bool case_sensitive) const
     {
         // Find a matching entry, if any.  We use some heuristics here: often
         // the same name appears consecutively (like repeating the same owner
@@ -191,11 +192,13 @@ struct MessageRenderer::MessageRendererImpl {
         if (case_sensitive) {
             found = find_if(table_[bucket_id].rbegin(),
                             table_[bucket_id].rend(),
-                            NameCompare<true>(buffer, name_buf, hash));
+                            NameCompare<true>(buffer, name_data,
+                                              name_len, hash));
         } else {
             found = find_if(table_[bucket_id].rbegin(),
                             table_[bucket_id].rend(),
-                            NameCompare<false>(buffer, name_buf, hash));
+                            NameCompare<false>(buffer, name_data,
+                                               name_len, hash));
         }
         if (found != table_[bucket_id].rend()) {
             return (found->pos_);
@@ -290,6 +293,22 @@ MessageRenderer::setCompressMode(const CompressMode mode) {
 
 void
 MessageRenderer::writeName(const LabelSequence& ls, const bool compress) {
+    writeNameInternal(ls, NULL, compress);
+}
+
+void
+MessageRenderer::writeHashedName(const LabelSequence& ls,
+                                 const size_t* hashes, const bool compress)
+{
+    // The given hash values are case insensitive.
+    writeNameInternal(ls, impl_->compress_mode_ == CASE_INSENSITIVE ?
+                      hashes : NULL, compress);
+}
+
+void
+MessageRenderer::writeNameInternal(const LabelSequence& ls,
+                                   const size_t* hashes, const bool compress)
+{
     LabelSequence sequence(ls);
     const size_t nlabels = sequence.getLabelCount();
     size_t data_len;
@@ -312,10 +331,9 @@ MessageRenderer::writeName(const LabelSequence& ls, const bool compress) {
             break;
         }
         // write with range check for safety
-        impl_->seq_hashes_.at(nlabels_uncomp) =
-            sequence.getHash(impl_->compress_mode_);
-        InputBuffer name_buf(data, data_len);
-        ptr_offset = impl_->findOffset(getBuffer(), name_buf,
+        impl_->seq_hashes_.at(nlabels_uncomp) = (hashes != NULL) ?
+            hashes[nlabels_uncomp] : sequence.getHash(impl_->compress_mode_);
+        ptr_offset = impl_->findOffset(getBuffer(), data, data_len,
                                        impl_->seq_hashes_[nlabels_uncomp],
                                        case_sensitive);
         if (ptr_offset != MessageRendererImpl::NO_OFFSET) {
@@ -398,5 +416,19 @@ AbstractMessageRenderer::clear() {
     buffer_->clear();
 }
 
+void
+AbstractMessageRenderer::computeNameHashes(const LabelSequence& ls,
+                                           size_t* hashes)
+{
+    LabelSequence sequence(ls);
+    const size_t nlabels = sequence.getLabelCount();
+    for (size_t i = 0; i < nlabels; ++i) {
+        if (i > 0) {
+            sequence.stripLeft(1);
+        }
+        hashes[i] = sequence.getHash(false);
+    }
+}
+
 }
 }
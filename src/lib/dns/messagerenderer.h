@@ -347,7 +347,43 @@ public:
     /// \param compress A boolean indicating whether to enable name
     /// compression.
     virtual void writeName(const LabelSequence& ls, bool compress = true) = 0;
+
+    /// \brief Write a \c LabelSequence object into the internal buffer
+    /// using precomputed hash values for name compression.
+    ///
+    /// This is the same as \c writeName(const LabelSequence&, bool), except
+    /// that the caller provides the hash values of the name and its
+    /// ancestors, which are used to look up the names rendered so far.
+    /// They must be calculated by \c computeNameHashes() for \c ls.
+    /// This is useful when the same name is rendered many times, such as
+    /// the owner name of each RR of an RRset.
+    ///
+    /// This default implementation ignores the hash values and simply
+    /// calls \c writeName().
+    ///
+    /// \param ls A \c LabelSequence object to be written.
+    /// \param hashes The hash values calculated by \c computeNameHashes()
+    /// for \c ls.
+    /// \param compress A boolean indicating whether to enable name
+    /// compression.
+    virtual void writeHashedName(const LabelSequence& ls,
+                                 const size_t* hashes, bool compress = true)
+    {
+        static_cast<void>(hashes);
+        writeName(ls, compress);
+    }
     //@}
+
+    /// \brief Calculate the hash values for \c writeHashedName().
+    ///
+    /// It stores the case insensitive hash value of \c ls in
+    /// \c hashes[0], that of \c ls with its leftmost label stripped in
+    /// \c hashes[1], and so on.  \c hashes must have room for
+    /// <code>ls.getLabelCount()</code> values.
+    ///
+    /// \param ls A \c LabelSequence object.
+    /// \param hashes An array to store the hash values.
+    static void computeNameHashes(const LabelSequence& ls, size_t* hashes);
 };
 
 /// The \c MessageRenderer is a concrete derived class of
@@ -390,7 +426,17 @@ public:
     virtual void writeName(const Name& name, bool compress = true);
     virtual void writeName(const LabelSequence& ls, bool compress = true);
 
+    /// The hash values are only used in the \c CASE_INSENSITIVE mode;
+    /// they are ignored (and calculated internally) otherwise.
+    virtual void writeHashedName(const LabelSequence& ls,
+                                 const size_t* hashes, bool compress = true);
+
 private:
+    // Common implementation of the writeName() variants.  If hashes is
+    // NULL, the hash values are calculated as the names are looked up.
+    void writeNameInternal(const LabelSequence& ls, const size_t* hashes,
+                           bool compress);
+
     struct MessageRendererImpl;
     MessageRendererImpl* impl_;
 };
@@ -294,7 +294,68 @@ stringParse(Iterator s, Iterator send, bool downcase, Offsets& offsets,
     }
 }
 
+// A fixed size container for stringParse(), so a textual name can be
+// converted to the wire format without allocating memory.  stringParse()
+// may go a few bytes beyond MAX_WIRE before it detects a too long name,
+// so the caller should leave some room for that.
+template <size_t N>
+class FixedNameBuffer {
+public:
+    FixedNameBuffer() : size_(0) {}
+    void reserve(size_t) {}
+    void push_back(uint8_t c) {
+        assert(size_ < N);
+        data_[size_++] = c;
+    }
+    size_t size() const { return (size_); }
+    uint8_t& back() { return (data_[size_ - 1]); }
+    uint8_t& at(size_t pos) {
+        assert(pos < size_);
+        return (data_[pos]);
+    }
+    const uint8_t* data() const { return (data_); }
+private:
+    uint8_t data_[N];
+    size_t size_;
+};
+
+}
+
+namespace name {
+namespace internal {
+void
+textToWire(const char* namedata, size_t data_len, const Name* origin,
+           OutputBuffer& buffer)
+{
+    // The checks and the conversion are the same as those of the Name
+    // constructor from a string with an origin.
+    if (namedata == NULL || data_len == 0) {
+        isc_throw(isc::InvalidParameter, "No name data provided");
+    }
+    const bool absolute = (namedata[data_len - 1] == '.');
+    if (!absolute && origin == NULL) {
+        isc_throw(MissingNameOrigin,
+                  "No origin available and name is relative");
+    }
+
+    FixedNameBuffer<Name::MAX_LABELS + 2> offsets;
+    FixedNameBuffer<Name::MAX_WIRE + 3> ndata;
+    stringParse(namedata, namedata + data_len, false, offsets, ndata);
+
+    if (absolute) {
+        buffer.writeData(ndata.data(), ndata.size());
+        return;
+    }
+    // Replace the trailing root label with the origin.
+    if (offsets.size() - 1 + origin->getLabelCount() > Name::MAX_LABELS ||
+        ndata.size() - 1 + origin->getLength() > Name::MAX_WIRE) {
+        isc_throw(TooLongName, "Combined name is too long");
+    }
+    buffer.writeData(ndata.data(), ndata.size() - 1);
+    origin->toWire(buffer);
 }
+} // end of internal
+} // end of name
 
 Name::Name(const std::string &namestring, bool downcase) {
     // Prepare inputs for the parser
@@ -528,25 +589,13 @@ Name::equals(const Name& other) const {
         return (false);
     }
 
-    for (unsigned int l = labelcount_, pos = 0; l > 0; --l) {
-        uint8_t count = ndata_[pos];
-        if (count != other.ndata_[pos]) {
-            return (false);
-        }
-        ++pos;
-
-        while (count-- > 0) {
-            uint8_t label1 = ndata_[pos];
-            uint8_t label2 = other.ndata_[pos];
-
-            if (maptolower[label1] != maptolower[label2]) {
-                return (false);
-            }
-            ++pos;
-        }
-    }
-
-    return (true);
+    // Label lengths are never converted by case folding, so comparing the
+    // whole data ignoring case also ensures the labels are of the same
+    // lengths.
+    return (mismatchIgnoreCase(
+                reinterpret_cast<const uint8_t*>(ndata_.data()),
+                reinterpret_cast<const uint8_t*>(other.ndata_.data()),
+                length_) == length_);
 }
 
 bool
@@ -702,12 +751,11 @@ Name::downcase() {
         assert(count <= MAX_LABELLEN);
         assert(nlen >= count);
 
-        while (count > 0) {
-            ndata_.at(pos) =
-                maptolower[ndata_.at(pos)];
-            ++pos;
-            --nlen;
-            --count;
+        if (count > 0) {
+            uint8_t* label = reinterpret_cast<uint8_t*>(&ndata_.at(pos));
+            name::internal::downcase(label, label, count);
+            pos += count;
+            nlen -= count;
         }
     }
 
@@ -0,0 +1,209 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dns/name_internal.h>
+
+#include <cstring>
+
+// SSE2 is always available on x86-64 (and on i386 if the compiler is told
+// so).  AVX2 isn't, so the AVX2 versions are compiled for that target only
+// and are used if the CPU supports it, which is checked at runtime.  That
+// requires the target attribute and __builtin_cpu_supports() of GCC 4.9 or
+// a recent clang.
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define NAME_INTERNAL_USE_SSE2 1
+#if defined(__x86_64__)
+#if defined(__clang__)
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_cpu_supports)
+#define NAME_INTERNAL_USE_AVX2 1
+#endif
+#endif
+#elif defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define NAME_INTERNAL_USE_AVX2 1
+#endif
+#endif
+#endif
+
+#ifdef NAME_INTERNAL_USE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace isc {
+namespace dns {
+namespace name {
+namespace internal {
+
+namespace {
+// Word-sized version, used for the data the vector versions don't cover
+// (and for everything on other architectures).  Words are loaded with
+// memcpy() so we don't have to care about alignment; the compiler converts
+// it to a single load.  The last (n % 8) bytes are processed one by one.
+const uint64_t ONES = 0x0101010101010101ULL;
+const uint64_t HIGH_BITS = 0x8080808080808080ULL;
+
+inline uint64_t
+loadWord(const uint8_t* data) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return (word);
+}
+
+// Convert the upper case characters in each byte of the word.  For each
+// byte whose high bit isn't set, adding (0x80 - 'A') to its lower 7 bits
+// sets the high bit iff it's >= 'A', and adding (0x7f - 'Z') does iff it's
+// > 'Z'; neither addition carries over to the next byte.
+inline uint64_t
+downcaseWord(uint64_t word) {
+    const uint64_t lower_bits = word & ~HIGH_BITS;
+    const uint64_t ge_a = lower_bits + (0x80 - 'A') * ONES;
+    const uint64_t gt_z = lower_bits + (0x7f - 'Z') * ONES;
+    const uint64_t upper = (ge_a ^ gt_z) & ~word & HIGH_BITS;
+    return (word | (upper >> 2));
+}
+
+#ifdef NAME_INTERNAL_USE_SSE2
+inline __m128i
+downcase128(__m128i data) {
+    // Signed comparison, so bytes >= 0x80 are never considered upper case.
+    const __m128i upper =
+        _mm_and_si128(_mm_cmpgt_epi8(data, _mm_set1_epi8('A' - 1)),
+                      _mm_cmplt_epi8(data, _mm_set1_epi8('Z' + 1)));
+    return (_mm_or_si128(data, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+}
+#endif
+
+#ifdef NAME_INTERNAL_USE_AVX2
+bool
+hasAVX2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return (has_avx2);
+}
+
+__attribute__((target("avx2"))) inline __m256i
+downcase256(__m256i data) {
+    const __m256i upper =
+        _mm256_and_si256(_mm256_cmpgt_epi8(data, _mm256_set1_epi8('A' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), data));
+    return (_mm256_or_si256(data,
+                            _mm256_and_si256(upper, _mm256_set1_epi8(0x20))));
+}
+
+// Process the first (n / 32) * 32 bytes.  Return the index of the first
+// mismatch, or the number of the processed bytes if there's none.
+__attribute__((target("avx2"))) size_t
+mismatchAVX2(const uint8_t* data1, const uint8_t* data2, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i d1 = downcase256(_mm256_loadu_si256(
+                                  reinterpret_cast<const __m256i*>(data1 + i)));
+        const __m256i d2 = downcase256(_mm256_loadu_si256(
+                                  reinterpret_cast<const __m256i*>(data2 + i)));
+        const uint32_t mask =
+            static_cast<uint32_t>(_mm256_movemask_epi8(
+                                      _mm256_cmpeq_epi8(d1, d2)));
+        if (mask != 0xffffffffU) {
+            return (i + __builtin_ctz(~mask));
+        }
+    }
+    return (i);
+}
+
+__attribute__((target("avx2"))) size_t
+downcaseAVX2(const uint8_t* src, uint8_t* dst, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i data = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                            downcase256(data));
+    }
+    return (i);
+}
+#endif
+}
+
+size_t
+mismatchIgnoreCaseLong(const uint8_t* data1, const uint8_t* data2,
+                       size_t n)
+{
+    size_t i = 0;
+#ifdef NAME_INTERNAL_USE_AVX2
+    if (n >= 32 && hasAVX2()) {
+        const size_t end = n & ~static_cast<size_t>(31);
+        i = mismatchAVX2(data1, data2, end);
+        if (i < end) {
+            return (i);
+        }
+    }
+#endif
+#ifdef NAME_INTERNAL_USE_SSE2
+    for (; i + 16 <= n; i += 16) {
+        const __m128i d1 = downcase128(_mm_loadu_si128(
+                                 reinterpret_cast<const __m128i*>(data1 + i)));
+        const __m128i d2 = downcase128(_mm_loadu_si128(
+                                 reinterpret_cast<const __m128i*>(data2 + i)));
+        const unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(d1, d2));
+        if (mask != 0xffff) {
+            return (i + __builtin_ctz(~mask));
+        }
+    }
+#endif
+    for (; i + 8 <= n; i += 8) {
+        if (downcaseWord(loadWord(data1 + i)) !=
+            downcaseWord(loadWord(data2 + i))) {
+            // The mismatch is located byte by byte below, which doesn't
+            // depend on the byte order.
+            break;
+        }
+    }
+    for (; i < n; ++i) {
+        if (maptolower[data1[i]] != maptolower[data2[i]]) {
+            return (i);
+        }
+    }
+    return (n);
+}
+
+void
+downcase(const uint8_t* src, uint8_t* dst, size_t n) {
+    size_t i = 0;
+#ifdef NAME_INTERNAL_USE_AVX2
+    if (n >= 32 && hasAVX2()) {
+        i = downcaseAVX2(src, dst, n);
+    }
+#endif
+#ifdef NAME_INTERNAL_USE_SSE2
+    for (; i + 16 <= n; i += 16) {
+        const __m128i data = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         downcase128(data));
+    }
+#endif
+    for (; i + 8 <= n; i += 8) {
+        const uint64_t word = downcaseWord(loadWord(src + i));
+        std::memcpy(dst + i, &word, sizeof(word));
+    }
+    for (; i < n; ++i) {
+        dst[i] = maptolower[src[i]];
+    }
+}
+
+} // end of internal
+} // end of name
+} // end of dns
+} // end of isc
@@ -27,11 +27,59 @@
 // we'll keep it semi-private (note also that except for very performance
 // sensitive applications the standard std::tolower() function should be just
 // sufficient).
+#include <cstddef>
+
+#include <stdint.h>
+
 namespace isc {
+namespace util {
+class OutputBuffer;
+}
 namespace dns {
+class Name;
+
 namespace name {
 namespace internal {
 extern const uint8_t maptolower[];
+
+// Return the index of the first of the n bytes at data1 and data2 that
+// differ when ASCII upper case characters are converted to lower case, or
+// n if they are all equal that way.  The conversion is the same as that
+// by maptolower; since label length bytes are never larger than 63, this
+// can be applied to label sequence data as a whole.
+//
+// These operations are the innermost loops of name comparison, so they are
+// implemented with SSE2 or AVX2 instructions where available (the latter
+// is detected at runtime), and otherwise with word-sized operations.
+// Short data, such as most labels, are simply compared inline, as that's
+// faster than the function call.
+size_t mismatchIgnoreCaseLong(const uint8_t* data1, const uint8_t* data2,
+                              size_t n);
+
+inline size_t
+mismatchIgnoreCase(const uint8_t* data1, const uint8_t* data2, size_t n) {
+    if (n >= 8) {
+        return (mismatchIgnoreCaseLong(data1, data2, n));
+    }
+    size_t i = 0;
+    while (i < n && maptolower[data1[i]] == maptolower[data2[i]]) {
+        ++i;
+    }
+    return (i);
+}
+
+// Copy n bytes from src to dst, converting ASCII upper case characters to
+// lower case as maptolower does.  src and dst may be the same, but may
+// not otherwise overlap.
+void downcase(const uint8_t* src, uint8_t* dst, size_t n);
+
+// Convert a textual name to the wire format and write it to buffer, like
+// the Name constructor from a string with an origin followed by toWire(),
+// and with the same exceptions.  Unlike the constructor, it doesn't need
+// any memory allocation (other than possibly for the buffer), so it's
+// used where many names are converted just to get the wire format.
+void textToWire(const char* namedata, size_t data_len, const Name* origin,
+                isc::util::OutputBuffer& buffer);
 } // end of internal
 } // end of name
 } // end of dns
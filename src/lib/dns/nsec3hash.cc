@@ -77,8 +77,6 @@ public:
             }
             std::memcpy(salt_data_, salt_data, salt_length);
         }
-
-        SHA1Reset(&sha1_ctx_);
     }
 
     virtual ~NSEC3HashRFC5155() {
@@ -104,54 +102,26 @@ private:
     // The following members are placeholder of work place and don't hold
     // any state over multiple calls so can be mutable without breaking
     // constness.
-    mutable SHA1Context sha1_ctx_;
     mutable vector<uint8_t> digest_;
     mutable OutputBuffer obuf_;
 };
 
-inline void
-iterateSHA1(SHA1Context* ctx, const uint8_t* input, size_t inlength,
-            const uint8_t* salt, size_t saltlen,
-            uint8_t output[SHA1_HASHSIZE])
-{
-    SHA1Reset(ctx);
-    SHA1Input(ctx, input, inlength);
-    SHA1Input(ctx, salt, saltlen); // this works whether saltlen == or > 0
-    SHA1Result(ctx, output);
-}
-
 string
 NSEC3HashRFC5155::calculateForWiredata(const uint8_t* data,
                                        size_t length) const
 {
     // We first need to normalize the name by converting all upper case
-    // characters in the labels to lower ones.
-
+    // characters in the labels to lower ones.  Label lengths are never
+    // converted, so we can simply convert the whole data.
     uint8_t name_buf[256];
     assert(length < sizeof (name_buf));
-
-    const uint8_t *p1 = data;
-    uint8_t *p2 = name_buf;
-    while (*p1 != 0) {
-        char len = *p1;
-
-        *p2++ = *p1++;
-        while (len--) {
-            *p2++ = isc::dns::name::internal::maptolower[*p1++];
-        }
-    }
-
-    *p2 = *p1;
+    isc::dns::name::internal::downcase(data, name_buf, length);
 
     uint8_t* const digest = &digest_[0];
     assert(digest_.size() == SHA1_HASHSIZE);
 
-    iterateSHA1(&sha1_ctx_, name_buf, length,
-                salt_data_, salt_length_, digest);
-    for (unsigned int n = 0; n < iterations_; ++n) {
-        iterateSHA1(&sha1_ctx_, digest, SHA1_HASHSIZE,
-                    salt_data_, salt_length_, digest);
-    }
+    SHA1IteratedHash(name_buf, length, salt_data_, salt_length_,
+                     iterations_, digest);
 
     return (encodeBase32Hex(digest_));
 }
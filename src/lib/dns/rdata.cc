@@ -15,14 +15,22 @@
 #include <exceptions/exceptions.h>
 
 #include <util/buffer.h>
+#include <util/encode/base32hex.h>
+#include <util/encode/base64.h>
 #include <util/encode/hex.h>
+#include <util/time_utilities.h>
 
 #include <dns/name.h>
+#include <dns/name_internal.h>
 #include <dns/messagerenderer.h>
 #include <dns/master_lexer.h>
 #include <dns/rdata.h>
 #include <dns/rrparamregistry.h>
+#include <dns/rrclass.h>
 #include <dns/rrtype.h>
+#include <dns/rdata/generic/detail/char_string.h>
+#include <dns/rdata/generic/detail/nsec_bitmap.h>
+#include <dns/rdata/generic/detail/nsec3param_common.h>
 
 #include <boost/lexical_cast.hpp>
 #include <boost/shared_ptr.hpp>
@@ -36,6 +44,9 @@
 #include <ostream>
 #include <vector>
 
+#include <arpa/inet.h> // XXX: for inet_pton/ntop(), not exist in C++ standards
+#include <sys/socket.h> // for AF_INET/AF_INET6
+#include <errno.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -133,6 +144,260 @@ fromtextError(bool& error_issued, const MasterLexer& lexer,
         isc_throw(Unexpected, "bug: createRdata() saw unexpected token type");
     }
 }
+
+// Consume to end of line / file after the RDATA text.
+// Call callback via fromtextError once if there was an error, and return
+// false if there was any extra input text.
+bool
+consumeRdataEnd(bool& error_issued, MasterLexer& lexer,
+                MasterLoaderCallbacks& callbacks)
+{
+    bool extra_text = false;
+    do {
+        const MasterToken& token = lexer.getNextToken();
+        switch (token.getType()) {
+        case MasterToken::END_OF_LINE:
+            return (!extra_text);
+        case MasterToken::END_OF_FILE:
+            callbacks.warning(lexer.getSourceName(), lexer.getSourceLine(),
+                              "file does not end with newline");
+            return (!extra_text);
+        default:
+            extra_text = true;
+            fromtextError(error_issued, lexer, callbacks, &token,
+                          "extra input text");
+            // Continue until we see EOL or EOF
+        }
+    } while (true);
+
+    // We shouldn't reach here
+    assert(false);
+    return (false); // add explicit return to silence some compilers
+}
+
+// The following are the wire-format counterparts of the constructors from
+// MasterLexer of the RDATA types handled by createWireRdata().  They read
+// the same tokens and throw the same exceptions as the constructors, and
+// write the resulting RDATA to the buffer.
+
+void
+addressToWire(int family, const char* type_txt, MasterLexer& lexer,
+              OutputBuffer& buffer)
+{
+    // The string region of a token is always nul-terminated.
+    const MasterToken::StringRegion& region =
+        lexer.getNextToken(MasterToken::STRING).getStringRegion();
+    if (region.len != strlen(region.beg)) {
+        isc_throw(InvalidRdataText, "Bad IN/" << type_txt <<
+                  " RDATA text: unexpected nul in string: '" <<
+                  region.beg << "'");
+    }
+    uint8_t addr[16];
+    const int result = inet_pton(family, region.beg, addr);
+    if (result == 0) {
+        isc_throw(InvalidRdataText, "Bad IN/" << type_txt <<
+                  " RDATA text: '" << region.beg << "'");
+    } else if (result < 0) {
+        isc_throw(isc::Unexpected, "Unexpected failure in parsing IN/" <<
+                  type_txt << " RDATA text: '" << region.beg << "': " <<
+                  strerror(errno));
+    }
+    buffer.writeData(addr, family == AF_INET ? 4 : 16);
+}
+
+void
+nameToWire(MasterLexer& lexer, const Name* origin, OutputBuffer& buffer) {
+    const MasterToken::StringRegion& region =
+        lexer.getNextToken(MasterToken::STRING).getStringRegion();
+    name::internal::textToWire(region.beg, region.len, origin, buffer);
+}
+
+void
+mxToWire(MasterLexer& lexer, const Name* origin, OutputBuffer& buffer) {
+    const uint32_t num = lexer.getNextToken(MasterToken::NUMBER).getNumber();
+    if (num > 65535) {
+        isc_throw(InvalidRdataText, "Invalid MX preference: " << num);
+    }
+    buffer.writeUint16(num);
+    nameToWire(lexer, origin, buffer);
+}
+
+void
+txtToWire(MasterLexer& lexer, OutputBuffer& buffer) {
+    generic::detail::CharString char_string;
+    bool empty = true;
+    while (true) {
+        const MasterToken& token = lexer.getNextToken(
+            MasterToken::QSTRING, true);
+        if (token.getType() != MasterToken::STRING &&
+            token.getType() != MasterToken::QSTRING) {
+            break;
+        }
+        char_string.clear();
+        generic::detail::stringToCharString(token.getStringRegion(),
+                                            char_string);
+        buffer.writeData(&char_string[0], char_string.size());
+        empty = false;
+    }
+
+    // Let upper layer handle eol/eof.
+    lexer.ungetToken();
+
+    if (empty) {
+        isc_throw(InvalidRdataText, "Failed to construct" <<
+                  RRType::TXT() << " RDATA: empty input");
+    }
+}
+
+void
+dsToWire(MasterLexer& lexer, OutputBuffer& buffer) {
+    const uint32_t tag = lexer.getNextToken(MasterToken::NUMBER).getNumber();
+    if (tag > 0xffff) {
+        isc_throw(InvalidRdataText, "Invalid DS tag: " << tag);
+    }
+    const uint32_t algorithm =
+        lexer.getNextToken(MasterToken::NUMBER).getNumber();
+    if (algorithm > 0xff) {
+        isc_throw(InvalidRdataText, "Invalid DS algorithm: " << algorithm);
+    }
+    const uint32_t digest_type =
+        lexer.getNextToken(MasterToken::NUMBER).getNumber();
+    if (digest_type > 0xff) {
+        isc_throw(InvalidRdataText, "Invalid DS digest type: "
+                  << digest_type);
+    }
+
+    string digest;
+    while (true) {
+        const MasterToken& token = lexer.getNextToken();
+        if (token.getType() != MasterToken::STRING) {
+            break;
+        }
+        digest.append(token.getString());
+    }
+    lexer.ungetToken();
+    if (digest.empty()) {
+        isc_throw(InvalidRdataText, "Missing DS digest");
+    }
+    vector<uint8_t> digest_data;
+    encode::decodeHex(digest, digest_data);
+
+    buffer.writeUint16(tag);
+    buffer.writeUint8(algorithm);
+    buffer.writeUint8(digest_type);
+    buffer.writeData(&digest_data[0], digest_data.size());
+}
+
+void
+rrsigToWire(MasterLexer& lexer, const Name* origin, OutputBuffer& buffer) {
+    const RRType covered(lexer.getNextToken(MasterToken::STRING).getString());
+    const uint32_t algorithm =
+        lexer.getNextToken(MasterToken::NUMBER).getNumber();
+    if (algorithm > 0xff) {
+        isc_throw(InvalidRdataText, "RRSIG algorithm out of range");
+    }
+    const uint32_t labels =
+        lexer.getNextToken(MasterToken::NUMBER).getNumber();
+    if (labels > 0xff) {
+        isc_throw(InvalidRdataText, "RRSIG labels out of range");
+    }
+    const uint32_t originalttl =
+        lexer.getNextToken(MasterToken::NUMBER).getNumber();
+    const uint32_t timeexpire =
+        timeFromText32(lexer.getNextToken(MasterToken::STRING).getString());
+    const uint32_t timeinception =
+        timeFromText32(lexer.getNextToken(MasterToken::STRING).getString());
+    const uint32_t tag =
+        lexer.getNextToken(MasterToken::NUMBER).getNumber();
+    if (tag > 0xffff) {
+        isc_throw(InvalidRdataText, "RRSIG key tag out of range");
+    }
+
+    covered.toWire(buffer);
+    buffer.writeUint8(algorithm);
+    buffer.writeUint8(labels);
+    buffer.writeUint32(originalttl);
+    buffer.writeUint32(timeexpire);
+    buffer.writeUint32(timeinception);
+    buffer.writeUint16(tag);
+    nameToWire(lexer, origin, buffer);
+
+    string signature_txt;
+    string signature_part;
+    // Whitespace is allowed within base64 text, so read to the end of input.
+    while (true) {
+        const MasterToken& token =
+            lexer.getNextToken(MasterToken::STRING, true);
+        if ((token.getType() == MasterToken::END_OF_FILE) ||
+            (token.getType() == MasterToken::END_OF_LINE)) {
+            break;
+        }
+        token.getString(signature_part);
+        signature_txt.append(signature_part);
+    }
+    lexer.ungetToken();
+
+    // missing signature is okay
+    if (!signature_txt.empty()) {
+        vector<uint8_t> signature;
+        encode::decodeBase64(signature_txt, signature);
+        if (!signature.empty()) {
+            buffer.writeData(&signature[0], signature.size());
+        }
+    }
+}
+
+void
+nsec3ToWire(MasterLexer& lexer, OutputBuffer& buffer) {
+    vector<uint8_t> salt;
+    const generic::detail::nsec3::ParseNSEC3ParamResult params =
+        generic::detail::nsec3::parseNSEC3ParamFromLexer("NSEC3", lexer,
+                                                         salt);
+
+    const string& nexthash =
+        lexer.getNextToken(MasterToken::STRING).getString();
+    if (*nexthash.rbegin() == '=') {
+        isc_throw(InvalidRdataText, "NSEC3 hash has padding: " << nexthash);
+    }
+    vector<uint8_t> next;
+    encode::decodeBase32Hex(nexthash, next);
+    if (next.size() > 255) {
+        isc_throw(InvalidRdataText, "NSEC3 hash is too long: "
+                  << next.size() << " bytes");
+    }
+
+    vector<uint8_t> typebits;
+    // For NSEC3 empty bitmap is possible and allowed.
+    generic::detail::nsec::buildBitmapsFromLexer("NSEC3", lexer, typebits,
+                                                 true);
+
+    buffer.writeUint8(params.algorithm);
+    buffer.writeUint8(params.flags);
+    buffer.writeUint16(params.iterations);
+    buffer.writeUint8(salt.size());
+    if (!salt.empty()) {
+        buffer.writeData(&salt[0], salt.size());
+    }
+    assert(!next.empty());
+    buffer.writeUint8(next.size());
+    buffer.writeData(&next[0], next.size());
+    if (!typebits.empty()) {
+        buffer.writeData(&typebits[0], typebits.size());
+    }
+}
+
+// The RR type codes of the RDATA handled by createWireRdata().
+enum WireRdataType {
+    WIRE_A = 1,
+    WIRE_NS = 2,
+    WIRE_CNAME = 5,
+    WIRE_MX = 15,
+    WIRE_TXT = 16,
+    WIRE_AAAA = 28,
+    WIRE_DS = 43,
+    WIRE_RRSIG = 46,
+    WIRE_NSEC3 = 50
+};
 }
 
 RdataPtr
@@ -159,28 +424,85 @@ createRdata(const RRType& rrtype, const RRClass& rrclass,
     // error; it doesn't make sense to catch and try to recover from them
     // here.  Just propagate.
 
-    // Consume to end of line / file.
-    // Call callback via fromtextError once if there was an error.
-    do {
-        const MasterToken& token = lexer.getNextToken();
-        switch (token.getType()) {
-        case MasterToken::END_OF_LINE:
-            return (rdata);
-        case MasterToken::END_OF_FILE:
-            callbacks.warning(lexer.getSourceName(), lexer.getSourceLine(),
-                              "file does not end with newline");
-            return (rdata);
-        default:
-            rdata.reset();      // we'll return NULL
-            fromtextError(error_issued, lexer, callbacks, &token,
-                          "extra input text");
-            // Continue until we see EOL or EOF
+    if (!consumeRdataEnd(error_issued, lexer, callbacks)) {
+        rdata.reset();      // we'll return NULL
+    }
+    return (rdata);
+}
+
+bool
+canCreateWireRdata(const RRType& rrtype, const RRClass& rrclass) {
+    switch (rrtype.getCode()) {
+    case WIRE_A:
+    case WIRE_AAAA:
+        return (rrclass == RRClass::IN());
+    case WIRE_NS:
+    case WIRE_CNAME:
+    case WIRE_MX:
+    case WIRE_TXT:
+    case WIRE_DS:
+    case WIRE_RRSIG:
+    case WIRE_NSEC3:
+        return (true);
+    default:
+        return (false);
+    }
+}
+
+bool
+createWireRdata(const RRType& rrtype, const RRClass& rrclass,
+                MasterLexer& lexer, const Name* origin,
+                MasterLoader::Options, MasterLoaderCallbacks& callbacks,
+                OutputBuffer& buffer)
+{
+    if (!canCreateWireRdata(rrtype, rrclass)) {
+        isc_throw(InvalidParameter, "RDATA of " << rrtype << "/" << rrclass
+                  << " can't be created in the wire format");
+    }
+    buffer.clear();
+
+    bool error_issued = false;
+    try {
+        switch (rrtype.getCode()) {
+        case WIRE_A:
+            addressToWire(AF_INET, "A", lexer, buffer);
+            break;
+        case WIRE_AAAA:
+            addressToWire(AF_INET6, "AAAA", lexer, buffer);
+            break;
+        case WIRE_NS:
+        case WIRE_CNAME:
+            nameToWire(lexer, origin, buffer);
+            break;
+        case WIRE_MX:
+            mxToWire(lexer, origin, buffer);
+            break;
+        case WIRE_TXT:
+            txtToWire(lexer, buffer);
+            break;
+        case WIRE_DS:
+            dsToWire(lexer, buffer);
+            break;
+        case WIRE_RRSIG:
+            rrsigToWire(lexer, origin, buffer);
+            break;
+        case WIRE_NSEC3:
+            nsec3ToWire(lexer, buffer);
+            break;
         }
-    } while (true);
+        if (buffer.getLength() > MAX_RDLENGTH) {
+            isc_throw(InvalidRdataLength, "RDATA is too long: " <<
+                      buffer.getLength() << " bytes");
+        }
+    } catch (const MasterLexer::LexerError& error) {
+        fromtextError(error_issued, lexer, callbacks, &error.token_, "");
+    } catch (const Exception& ex) {
+        // See createRdata() about the exceptions caught here.
+        fromtextError(error_issued, lexer, callbacks, NULL, ex.what());
+    }
 
-    // We shouldn't reach here
-    assert(false);
-    return (RdataPtr()); // add explicit return to silence some compilers
+    return (consumeRdataEnd(error_issued, lexer, callbacks) &&
+            !error_issued);
 }
 
 int
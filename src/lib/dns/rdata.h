@@ -548,6 +548,51 @@ RdataPtr createRdata(const RRType& rrtype, const RRClass& rrclass,
 
 //@}
 
+/// \brief Return whether \c createWireRdata() supports the given pair of
+/// RR type and class.
+///
+/// As of this writing, these are IN/A, IN/AAAA, and NS, CNAME, MX, TXT, DS,
+/// RRSIG and NSEC3 of any class.
+bool canCreateWireRdata(const RRType& rrtype, const RRClass& rrclass);
+
+/// \brief Convert textual RDATA to the wire format using the master lexer.
+///
+/// This is a variant of \c createRdata() using the master lexer which
+/// writes the wire-format RDATA into \c buffer instead of creating an
+/// \c Rdata object.  It's intended for applications that load a large
+/// number of RRs from master files and only need their wire format, such
+/// as the in-memory data source; for such applications the construction
+/// (and destruction) of the \c Rdata objects can be a major part of the
+/// overhead.
+///
+/// It reads the same input as \c createRdata() would, with the same error
+/// handling: errors are reported via \c callbacks, and the lexer is always
+/// updated to the end of line or file.  The resulting data are the same as
+/// those of \c Rdata::toWire() of the object \c createRdata() would create.
+///
+/// \throw InvalidParameter \c canCreateWireRdata() is false for the
+/// \c rrtype and \c rrclass.
+///
+/// \param rrtype An \c RRType object specifying the type/class pair.
+/// \param rrclass An \c RRClass object specifying the type/class pair.
+/// \param lexer A \c MasterLexer object parsing a master file for the
+/// RDATA to be created
+/// \param origin If non NULL, specifies the origin of any domain name fields
+/// of the RDATA that are non absolute.
+/// \param options Master loader options controlling how to deal with errors
+/// or non critical issues in the parsed RDATA.
+/// \param callbacks Callback to be called when an error or non critical issue
+/// is found.
+/// \param buffer The buffer to store the wire-format RDATA.  It's cleared
+/// first.
+/// \return true if the RDATA was successfully converted; false otherwise,
+/// in which case the content of \c buffer is undefined.
+bool createWireRdata(const RRType& rrtype, const RRClass& rrclass,
+                     MasterLexer& lexer, const Name* origin,
+                     MasterLoader::Options options,
+                     MasterLoaderCallbacks& callbacks,
+                     isc::util::OutputBuffer& buffer);
+
 ///
 /// \brief Gives relative ordering of two names in terms of DNSSEC RDATA
 /// ordering.
@@ -24,6 +24,7 @@
 #include <dns/rrttl.h>
 #include <dns/rdata.h>
 #include <dns/rrset.h>
+#include <dns/wire_rrset.h>
 
 #include <boost/bind.hpp>
 
@@ -35,13 +36,28 @@ using namespace rdata;
 
 class RRCollator::Impl {
 public:
-    Impl(const AddRRsetCallback& callback) : callback_(callback) {}
+    Impl(const AddRRsetCallback& callback) :
+        current_wire_(NULL), callback_(callback)
+    {}
 
     void addRR(const Name& name, const RRClass& rrclass,
                const RRType& rrtype, const RRTTL& rrttl,
                const RdataPtr& rdata);
 
+    void addWireRR(const Name& name, const RRClass& rrclass,
+                   const RRType& rrtype, const RRTTL& rrttl,
+                   const uint8_t* data, size_t data_len);
+
+    void flush() {
+        if (current_rrset_) {
+            callback_(current_rrset_);
+            current_rrset_.reset();
+            current_wire_ = NULL;
+        }
+    }
+
     RRsetPtr current_rrset_;
+    WireRRset* current_wire_;   // current_rrset_ if it's a WireRRset
     const AddRRsetCallback callback_;
 };
 
@@ -61,6 +77,24 @@ isSameType(RRType type1, const ConstRdataPtr& rdata1,
     }
     return (true);
 }
+
+// Wire-format version of isSameType().  The type covered is the first
+// field of RRSIG RDATA.
+inline bool
+isSameWireType(RRType type1, const uint8_t* data1, size_t data1_len,
+               const WireRRset& rrset)
+{
+    if (type1 != rrset.getType()) {
+        return (false);
+    }
+    if (type1 == RRType::RRSIG()) {
+        if (data1_len < 2 || rrset.getWireRdataLength(0) < 2) {
+            isc_throw(BadValue, "RRSIG RDATA is too short");
+        }
+        return (std::equal(data1, data1 + 2, rrset.getWireRdata(0)));
+    }
+    return (true);
+}
 }
 
 void
@@ -68,11 +102,11 @@ RRCollator::Impl::addRR(const Name& name, const RRClass& rrclass,
                         const RRType& rrtype, const RRTTL& rrttl,
                         const RdataPtr& rdata)
 {
-    if (current_rrset_ && (!isSameType(rrtype, rdata, current_rrset_) ||
+    if (current_rrset_ && (current_wire_ != NULL ||
+                           !isSameType(rrtype, rdata, current_rrset_) ||
                            current_rrset_->getClass() != rrclass ||
                            current_rrset_->getName() != name)) {
-        callback_(current_rrset_);
-        current_rrset_.reset();
+        flush();
     }
 
     if (!current_rrset_) {
@@ -84,6 +118,29 @@ RRCollator::Impl::addRR(const Name& name, const RRClass& rrclass,
     current_rrset_->addRdata(rdata);
 }
 
+void
+RRCollator::Impl::addWireRR(const Name& name, const RRClass& rrclass,
+                            const RRType& rrtype, const RRTTL& rrttl,
+                            const uint8_t* data, size_t data_len)
+{
+    if (current_rrset_ &&
+        (current_wire_ == NULL ||
+         !isSameWireType(rrtype, data, data_len, *current_wire_) ||
+         current_wire_->getClass() != rrclass ||
+         current_wire_->getName() != name)) {
+        flush();
+    }
+
+    if (!current_rrset_) {
+        current_wire_ = new WireRRset(name, rrclass, rrtype, rrttl);
+        current_rrset_ = RRsetPtr(current_wire_);
+    } else if (current_wire_->getTTL() != rrttl) {
+        // RRs with different TTLs are given.  Smaller TTL should win.
+        current_wire_->setTTL(std::min(current_wire_->getTTL(), rrttl));
+    }
+    current_wire_->addWireRdata(data, data_len);
+}
+
 RRCollator::RRCollator(const AddRRsetCallback& callback) :
     impl_(new Impl(callback))
 {}
@@ -98,12 +155,15 @@ RRCollator::getCallback() {
                         _1, _2, _3, _4, _5));
 }
 
+AddWireRRCallback
+RRCollator::getWireCallback() {
+    return (boost::bind(&RRCollator::Impl::addWireRR, this->impl_,
+                        _1, _2, _3, _4, _5, _6));
+}
+
 void
 RRCollator::flush() {
-    if (impl_->current_rrset_) {
-        impl_->callback_(impl_->current_rrset_);
-        impl_->current_rrset_.reset();
-    }
+    impl_->flush();
 }
 
 } // end namespace dns
@@ -119,6 +119,17 @@ public:
     /// confusion.
     AddRRCallback getCallback();
 
+    /// \brief Return \c MasterLoader compatible callback for wire-format
+    /// RRs.
+    ///
+    /// This is similar to \c getCallback(), but returns a functor in the
+    /// form of \c AddWireRRCallback (see
+    /// \c MasterLoader::setAddWireCallback()).  The RRs given via this
+    /// functor are collated into \c WireRRset objects.  RRs given via this
+    /// functor and those given via the \c getCallback() functor are never
+    /// collated into the same RRset.
+    AddWireRRCallback getWireCallback();
+
 private:
     class Impl;
     Impl* impl_;
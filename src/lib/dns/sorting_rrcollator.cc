@@ -0,0 +1,556 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <exceptions/exceptions.h>
+
+// include this first to check the header is self-contained.
+#include <dns/sorting_rrcollator.h>
+
+#include <dns/labelsequence.h>
+#include <dns/name.h>
+#include <dns/name_internal.h>
+#include <dns/rdataclass.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#include <dns/rrttl.h>
+#include <dns/rdata.h>
+#include <dns/rrset.h>
+
+#include <util/buffer.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using isc::util::InputBuffer;
+using isc::util::OutputBuffer;
+
+namespace isc {
+namespace dns {
+using namespace rdata;
+
+namespace {
+// Each RR is kept as a record of the following form, both in memory and
+// in the temporary files.  The integers are in host byte order, as the
+// files never outlive the process.
+//
+//   uint32_t  length of the rest of the record
+//   uint16_t  key length
+//   key       the sort key (see makeKey())
+//   uint32_t  TTL
+//   uint8_t   owner name length
+//   owner     the owner name in wire format, as given
+//   rdata     the RDATA in wire format, up to the end of the record
+//
+// Records are sorted by the key and, for the same key, in the order
+// they were given, so the RDATA of an RRset keep their order.
+
+const size_t RECORD_HEADER_LEN = sizeof(uint32_t);
+const size_t KEY_OFFSET = RECORD_HEADER_LEN + sizeof(uint16_t);
+// The key is the owner name, plus RR class, type and type covered.
+const size_t KEY_TYPES_LEN = 6;
+const size_t MAX_KEY_LEN = Name::MAX_WIRE + KEY_TYPES_LEN;
+
+// The maximum number of temporary files merged at once.  When there are
+// this many, they are merged into one before any more are created.
+const size_t MAX_MERGE_WIDTH = 64;
+
+const size_t FILE_BUFFER_SIZE = 64 * 1024;
+
+inline uint32_t
+readUint32(const uint8_t* cp) {
+    uint32_t n;
+    std::memcpy(&n, cp, sizeof(n));
+    return (n);
+}
+
+inline uint16_t
+readUint16(const uint8_t* cp) {
+    uint16_t n;
+    std::memcpy(&n, cp, sizeof(n));
+    return (n);
+}
+
+inline size_t
+getRecordLength(const uint8_t* record) {
+    return (RECORD_HEADER_LEN + readUint32(record));
+}
+
+inline size_t
+getKeyLength(const uint8_t* record) {
+    return (readUint16(record + RECORD_HEADER_LEN));
+}
+
+inline bool
+keyEquals(const uint8_t* key1, size_t len1, const uint8_t* key2,
+          size_t len2)
+{
+    return (len1 == len2 && std::memcmp(key1, key2, len1) == 0);
+}
+
+inline int
+compareKeys(const uint8_t* record1, const uint8_t* record2) {
+    const size_t len1 = getKeyLength(record1);
+    const size_t len2 = getKeyLength(record2);
+    const int cmp = std::memcmp(record1 + KEY_OFFSET, record2 + KEY_OFFSET,
+                                std::min(len1, len2));
+    if (cmp != 0) {
+        return (cmp);
+    }
+    return (static_cast<int>(len1) - static_cast<int>(len2));
+}
+
+inline void
+writeUint16BE(uint8_t* cp, uint16_t n) {
+    cp[0] = n >> 8;
+    cp[1] = n & 0xff;
+}
+
+// Build the sort key of an RR: the labels of the owner name from the root,
+// lower-cased and each preceded by its length, followed by the RR class,
+// type and type covered (0 unless it's an RRSIG) in network byte order.
+// Returns the key length.
+size_t
+makeKey(const Name& name, const RRClass& rrclass, const RRType& rrtype,
+        const Rdata& rdata, uint8_t* key)
+{
+    const LabelSequence labels(name);
+    size_t name_len;
+    const uint8_t* data = labels.getData(&name_len);
+    size_t offsets[Name::MAX_LABELS];
+    size_t label_count = 0;
+    for (size_t pos = 0; pos < name_len; pos += data[pos] + 1) {
+        offsets[label_count++] = pos;
+    }
+    uint8_t* cp = key;
+    while (label_count > 0) {
+        const size_t pos = offsets[--label_count];
+        const size_t len = data[pos] + 1;
+        *cp = data[pos];
+        name::internal::downcase(data + pos + 1, cp + 1, len - 1);
+        cp += len;
+    }
+    writeUint16BE(cp, rrclass.getCode());
+    writeUint16BE(cp + 2, rrtype.getCode());
+    const uint16_t covered = (rrtype == RRType::RRSIG()) ?
+        dynamic_cast<const generic::RRSIG&>(rdata).typeCovered().getCode() :
+        0;
+    writeUint16BE(cp + 4, covered);
+    return (cp + KEY_TYPES_LEN - key);
+}
+
+// Orders the records in memory (given by their offsets), keeping the
+// order of those with the same key.
+class RecordLess {
+public:
+    RecordLess(const uint8_t* base) : base_(base) {}
+    bool operator()(size_t offset1, size_t offset2) const {
+        const int cmp = compareKeys(base_ + offset1, base_ + offset2);
+        return (cmp < 0 || (cmp == 0 && offset1 < offset2));
+    }
+private:
+    const uint8_t* const base_;
+};
+
+// Reads records from a temporary file one by one.
+class RunReader : boost::noncopyable {
+public:
+    RunReader(FILE* fp, size_t index) : fp_(fp), index_(index) {}
+
+    // Read the next record.  Returns false at the end of the file.
+    bool next() {
+        uint8_t header[RECORD_HEADER_LEN];
+        const size_t n = std::fread(header, 1, sizeof(header), fp_);
+        if (n == 0 && std::feof(fp_)) {
+            return (false);
+        }
+        if (n != sizeof(header)) {
+            throwReadError();
+        }
+        const size_t body_len = readUint32(header);
+        record_.resize(RECORD_HEADER_LEN + body_len);
+        std::memcpy(&record_[0], header, sizeof(header));
+        if (std::fread(&record_[RECORD_HEADER_LEN], 1, body_len, fp_) !=
+            body_len) {
+            throwReadError();
+        }
+        return (true);
+    }
+
+    const uint8_t* getRecord() const { return (&record_[0]); }
+    size_t getIndex() const { return (index_); }
+
+private:
+    void throwReadError() {
+        isc_throw(SortingRRCollatorError,
+                  "failed to read a temporary file: " <<
+                  (std::ferror(fp_) ? std::strerror(errno) :
+                   "unexpected end of file"));
+    }
+
+    FILE* const fp_;
+    const size_t index_;
+    std::vector<uint8_t> record_;
+};
+
+// The order of the readers in the merge heap; the file index breaks ties,
+// since files written earlier have records given earlier.
+struct RunReaderGreater {
+    bool operator()(const RunReader* reader1,
+                    const RunReader* reader2) const
+    {
+        const int cmp = compareKeys(reader1->getRecord(),
+                                    reader2->getRecord());
+        return (cmp > 0 ||
+                (cmp == 0 && reader1->getIndex() > reader2->getIndex()));
+    }
+};
+
+// Merge the records of the given files (which must be sorted), passing
+// them in order to the sink.
+template <typename Sink>
+void
+mergeRuns(const std::vector<FILE*>& runs, Sink& sink) {
+    std::vector<RunReader*> readers;
+    try {
+        std::priority_queue<RunReader*, std::vector<RunReader*>,
+            RunReaderGreater> heap;
+        for (size_t i = 0; i < runs.size(); ++i) {
+            if (std::fseek(runs[i], 0, SEEK_SET) != 0) {
+                isc_throw(SortingRRCollatorError,
+                          "failed to rewind a temporary file: " <<
+                          std::strerror(errno));
+            }
+            readers.push_back(new RunReader(runs[i], i));
+            if (readers.back()->next()) {
+                heap.push(readers.back());
+            }
+        }
+        while (!heap.empty()) {
+            RunReader* reader = heap.top();
+            heap.pop();
+            sink(reader->getRecord());
+            if (reader->next()) {
+                heap.push(reader);
+            }
+        }
+    } catch (...) {
+        for (size_t i = 0; i < readers.size(); ++i) {
+            delete readers[i];
+        }
+        throw;
+    }
+    for (size_t i = 0; i < readers.size(); ++i) {
+        delete readers[i];
+    }
+}
+
+// A sink of records writing them to a file.
+class RunWriter {
+public:
+    RunWriter(FILE* fp) : fp_(fp) {}
+    void operator()(const uint8_t* record) {
+        const size_t len = getRecordLength(record);
+        if (std::fwrite(record, 1, len, fp_) != len) {
+            isc_throw(SortingRRCollatorError,
+                      "failed to write a temporary file: " <<
+                      std::strerror(errno));
+        }
+    }
+private:
+    FILE* const fp_;
+};
+
+// A sink of records building RRsets from them and passing them to the
+// callback.
+class RRsetBuilder {
+public:
+    RRsetBuilder(const SortingRRCollator::AddRRsetCallback& callback) :
+        callback_(callback), key_len_(0)
+    {}
+
+    void operator()(const uint8_t* record) {
+        const size_t key_len = getKeyLength(record);
+        const uint8_t* const key = record + KEY_OFFSET;
+        const uint8_t* cp = key + key_len;
+        const RRTTL ttl(readUint32(cp));
+        cp += sizeof(uint32_t);
+        const size_t owner_len = *cp++;
+        const uint8_t* const owner = cp;
+        cp += owner_len;
+        const size_t rdata_len = record + getRecordLength(record) - cp;
+
+        if (!rrset_ || !keyEquals(key, key_len, key_, key_len_)) {
+            finish();
+            const uint8_t* const types = key + key_len - KEY_TYPES_LEN;
+            InputBuffer owner_buffer(owner, owner_len);
+            rrset_.reset(new RRset(Name(owner_buffer),
+                                   RRClass((types[0] << 8) | types[1]),
+                                   RRType((types[2] << 8) | types[3]),
+                                   ttl));
+            std::memcpy(key_, key, key_len);
+            key_len_ = key_len;
+        } else if (ttl < rrset_->getTTL()) {
+            rrset_->setTTL(ttl);
+        }
+        InputBuffer rdata_buffer(cp, rdata_len);
+        rrset_->addRdata(createRdata(rrset_->getType(), rrset_->getClass(),
+                                     rdata_buffer, rdata_len));
+    }
+
+    void finish() {
+        if (rrset_) {
+            RRsetPtr rrset;
+            rrset.swap(rrset_);
+            callback_(rrset);
+        }
+    }
+
+private:
+    const SortingRRCollator::AddRRsetCallback& callback_;
+    RRsetPtr rrset_;
+    uint8_t key_[MAX_KEY_LEN];
+    size_t key_len_;
+};
+}
+
+class SortingRRCollator::Impl {
+public:
+    Impl(const AddRRsetCallback& callback, size_t window_size,
+         const std::string& temp_dir) :
+        callback_(callback), window_size_(window_size), temp_dir_(temp_dir),
+        rr_count_(0), rdata_buffer_(0)
+    {}
+
+    ~Impl() {
+        clear();
+    }
+
+    void addRR(const Name& name, const RRClass& rrclass,
+               const RRType& rrtype, const RRTTL& rrttl,
+               const RdataPtr& rdata);
+    void flush();
+    void clear();
+
+    const AddRRsetCallback callback_;
+    const size_t window_size_;
+    const std::string temp_dir_;
+    size_t rr_count_;
+    // The records not written to temporary files yet, and their offsets.
+    std::vector<uint8_t> records_;
+    std::vector<size_t> offsets_;
+    // The temporary files, each holding sorted records.
+    std::vector<FILE*> runs_;
+
+private:
+    void sortRecords() {
+        if (!offsets_.empty()) {
+            std::sort(offsets_.begin(), offsets_.end(),
+                      RecordLess(&records_[0]));
+        }
+    }
+    FILE* createTempFile() const;
+    void spill();
+
+    OutputBuffer rdata_buffer_;
+};
+
+void
+SortingRRCollator::Impl::addRR(const Name& name, const RRClass& rrclass,
+                               const RRType& rrtype, const RRTTL& rrttl,
+                               const RdataPtr& rdata)
+{
+    uint8_t key[MAX_KEY_LEN];
+    const size_t key_len = makeKey(name, rrclass, rrtype, *rdata, key);
+    rdata_buffer_.clear();
+    rdata->toWire(rdata_buffer_);
+    const size_t owner_len = name.getLength();
+    const size_t body_len = sizeof(uint16_t) + key_len + sizeof(uint32_t) +
+        1 + owner_len + rdata_buffer_.getLength();
+
+    const size_t offset = records_.size();
+    records_.resize(offset + RECORD_HEADER_LEN + body_len);
+    offsets_.push_back(offset);
+    uint8_t* cp = &records_[offset];
+    const uint32_t body_len32 = body_len;
+    std::memcpy(cp, &body_len32, sizeof(body_len32));
+    cp += sizeof(body_len32);
+    const uint16_t key_len16 = key_len;
+    std::memcpy(cp, &key_len16, sizeof(key_len16));
+    cp += sizeof(key_len16);
+    std::memcpy(cp, key, key_len);
+    cp += key_len;
+    const uint32_t ttl = rrttl.getValue();
+    std::memcpy(cp, &ttl, sizeof(ttl));
+    cp += sizeof(ttl);
+    *cp++ = owner_len;
+    size_t name_len;
+    std::memcpy(cp, LabelSequence(name).getData(&name_len), owner_len);
+    cp += owner_len;
+    std::memcpy(cp, rdata_buffer_.getData(), rdata_buffer_.getLength());
+    ++rr_count_;
+
+    if (records_.size() + offsets_.size() * sizeof(size_t) >= window_size_) {
+        spill();
+    }
+}
+
+FILE*
+SortingRRCollator::Impl::createTempFile() const {
+    FILE* fp = NULL;
+    if (temp_dir_.empty()) {
+        fp = std::tmpfile();
+    } else {
+        std::vector<char> path(temp_dir_.begin(), temp_dir_.end());
+        const char* const suffix = "/b10-rrcollator-XXXXXX";
+        path.insert(path.end(), suffix, suffix + std::strlen(suffix) + 1);
+        const int fd = mkstemp(&path[0]);
+        if (fd >= 0) {
+            // The file is only accessed through the descriptor from now on.
+            unlink(&path[0]);
+            fp = fdopen(fd, "w+b");
+            if (fp == NULL) {
+                close(fd);
+            }
+        }
+    }
+    if (fp == NULL) {
+        isc_throw(SortingRRCollatorError,
+                  "failed to create a temporary file in " <<
+                  (temp_dir_.empty() ? "the default directory" : temp_dir_) <<
+                  ": " << std::strerror(errno));
+    }
+    std::setvbuf(fp, NULL, _IOFBF, FILE_BUFFER_SIZE);
+    return (fp);
+}
+
+void
+SortingRRCollator::Impl::spill() {
+    if (offsets_.empty()) {
+        return;
+    }
+
+    if (runs_.size() >= MAX_MERGE_WIDTH) {
+        // Merge the existing files into one, so we don't have too many
+        // files open, and merging them later doesn't need too much memory.
+        FILE* const merged = createTempFile();
+        try {
+            RunWriter writer(merged);
+            mergeRuns(runs_, writer);
+        } catch (...) {
+            std::fclose(merged);
+            throw;
+        }
+        for (size_t i = 0; i < runs_.size(); ++i) {
+            std::fclose(runs_[i]);
+        }
+        runs_.clear();
+        runs_.push_back(merged);
+    }
+
+    sortRecords();
+    FILE* const fp = createTempFile();
+    try {
+        RunWriter writer(fp);
+        for (size_t i = 0; i < offsets_.size(); ++i) {
+            writer(&records_[offsets_[i]]);
+        }
+        if (std::fflush(fp) != 0) {
+            isc_throw(SortingRRCollatorError,
+                      "failed to write a temporary file: " <<
+                      std::strerror(errno));
+        }
+        runs_.push_back(fp);
+    } catch (...) {
+        std::fclose(fp);
+        throw;
+    }
+    records_.clear();
+    offsets_.clear();
+}
+
+void
+SortingRRCollator::Impl::flush() {
+    RRsetBuilder builder(callback_);
+    if (runs_.empty()) {
+        sortRecords();
+        for (size_t i = 0; i < offsets_.size(); ++i) {
+            builder(&records_[offsets_[i]]);
+        }
+    } else {
+        spill();
+        mergeRuns(runs_, builder);
+    }
+    builder.finish();
+}
+
+void
+SortingRRCollator::Impl::clear() {
+    for (size_t i = 0; i < runs_.size(); ++i) {
+        std::fclose(runs_[i]);
+    }
+    runs_.clear();
+    std::vector<uint8_t>().swap(records_);
+    std::vector<size_t>().swap(offsets_);
+    rr_count_ = 0;
+}
+
+SortingRRCollator::SortingRRCollator(const AddRRsetCallback& callback,
+                                     size_t window_size,
+                                     const std::string& temp_dir) :
+    impl_(new Impl(callback, window_size, temp_dir))
+{}
+
+SortingRRCollator::~SortingRRCollator() {
+    delete impl_;
+}
+
+AddRRCallback
+SortingRRCollator::getCallback() {
+    return (boost::bind(&SortingRRCollator::Impl::addRR, this->impl_,
+                        _1, _2, _3, _4, _5));
+}
+
+void
+SortingRRCollator::flush() {
+    try {
+        impl_->flush();
+    } catch (...) {
+        impl_->clear();
+        throw;
+    }
+    impl_->clear();
+}
+
+size_t
+SortingRRCollator::getRRCount() const {
+    return (impl_->rr_count_);
+}
+
+size_t
+SortingRRCollator::getRunCount() const {
+    return (impl_->runs_.size());
+}
+
+} // end namespace dns
+} // end namespace isc
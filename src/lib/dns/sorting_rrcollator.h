@@ -0,0 +1,145 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SORTING_RRCOLLATOR_H
+#define SORTING_RRCOLLATOR_H 1
+
+#include <exceptions/exceptions.h>
+
+#include <dns/master_loader_callbacks.h>
+#include <dns/rrcollator.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <string>
+
+namespace isc {
+namespace dns {
+
+/// \brief An I/O error on the temporary files of \c SortingRRCollator.
+class SortingRRCollatorError : public isc::Exception {
+public:
+    SortingRRCollatorError(const char* file, size_t line, const char* what) :
+        isc::Exception(file, line, what)
+    {}
+};
+
+/// \brief A converter from a stream of RRs in any order to a stream of
+/// complete RRsets
+///
+/// Like \c RRCollator, this class works as a callback for \c MasterLoader
+/// or anything else producing a stream of RRs, and produces a stream of
+/// RRsets through its own callback.  Unlike \c RRCollator, it collates
+/// all RRs of the same RRset (having the same owner name, ignoring case,
+/// RR type and class, and, for RRSIGs, the same type covered) into a
+/// single RRset wherever they appear in the stream.  The TTL of an RRset
+/// is the smallest one among its RRs, and its owner name is that of the
+/// first of its RRs.  The RDATA of an RRset are in the order they were
+/// given.
+///
+/// To do this, the RRs are kept (in a compact wire-format form) until
+/// \c flush() is called, and all RRsets are produced from \c flush().
+/// The memory used for the RRs is limited by a "window" size given on
+/// construction; when the RRs don't fit in the window, they are sorted
+/// and written to a temporary file, and \c flush() merges all these
+/// files.  So a stream of any size can be collated with bounded memory,
+/// the cost being a pass over a temporary copy of the data.
+///
+/// The RRsets are produced in an order in which all RRsets of the same
+/// owner name are consecutive, but otherwise the order is unspecified.
+///
+/// The temporary files are removed from their directory as soon as they
+/// are created, so they never remain after the object is destroyed or the
+/// process terminates.
+class SortingRRCollator : boost::noncopyable {
+public:
+    /// \brief Callback functor type for \c SortingRRCollator.
+    ///
+    /// It's the same as the one of \c RRCollator.
+    typedef RRCollator::AddRRsetCallback AddRRsetCallback;
+
+    /// \brief The default size of the in-memory window, in bytes.
+    static const size_t DEFAULT_WINDOW_SIZE = 64 * 1024 * 1024;
+
+    /// \brief Constructor.
+    ///
+    /// \throw std::bad_alloc Internal memory allocation fails.
+    ///
+    /// \param callback The callback functor to be called for each collated
+    /// RRset.
+    /// \param window_size The maximum number of bytes of RRs kept in
+    /// memory before they are written to a temporary file.
+    /// \param temp_dir The directory for the temporary files.  If it's
+    /// empty, they are created in the system's default directory for
+    /// temporary files.
+    SortingRRCollator(const AddRRsetCallback& callback,
+                      size_t window_size = DEFAULT_WINDOW_SIZE,
+                      const std::string& temp_dir = "");
+
+    /// \brief Destructor.
+    ///
+    /// Like that of \c RRCollator, RRs that haven't been passed to the
+    /// callback by \c flush() are simply discarded.
+    ///
+    /// \throw None
+    ~SortingRRCollator();
+
+    /// \brief Call the callback on all the collated RRsets.
+    ///
+    /// This method is expected to be called once all RRs have been passed
+    /// to this object.  After that, the object is empty and can be used
+    /// for a new stream of RRs.
+    ///
+    /// It propagates any exception thrown from the callback.  In that
+    /// case the remaining RRs are discarded.
+    ///
+    /// \throw SortingRRCollatorError Reading or writing a temporary file
+    /// fails.
+    /// \throw std::bad_alloc Internal memory allocation fails.
+    void flush();
+
+    /// \brief Return \c MasterLoader compatible callback.
+    ///
+    /// The returned functor gives the RR to this object.  It never calls
+    /// the callback for RRsets.
+    ///
+    /// The functor throws \c SortingRRCollatorError if it fails to create
+    /// or write a temporary file, and \c std::bad_alloc if internal memory
+    /// allocation fails.
+    AddRRCallback getCallback();
+
+    /// \brief Return the number of RRs given since the last \c flush().
+    ///
+    /// \throw None
+    size_t getRRCount() const;
+
+    /// \brief Return the number of temporary files currently in use.
+    ///
+    /// This is mainly for tests.
+    ///
+    /// \throw None
+    size_t getRunCount() const;
+
+private:
+    class Impl;
+    Impl* impl_;
+};
+
+} // namespace dns
+} // namespace isc
+#endif  // SORTING_RRCOLLATOR_H
+
+// Local Variables:
+// mode: c++
+// End:
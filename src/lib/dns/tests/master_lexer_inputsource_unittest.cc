@@ -23,6 +23,7 @@
 #include <string>
 
 #include <string.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace isc::dns;
@@ -141,6 +142,114 @@ TEST_F(InputSourceTest, file) {
     checkGetAndUngetChar(source, str.c_str(), str.size());
 }
 
+// getBufferedData() should give the data that has been read but not
+// consumed, and skipBufferedData() should consume it.  The first 5
+// characters of str must not include a newline.
+void
+checkBufferedData(InputSource& source, const char* str,
+                  const size_t str_length)
+{
+    size_t len;
+    source.getBufferedData(&len);
+    if (len == 0) {
+        // Nothing has been read from the stream yet.  Read something.
+        EXPECT_EQ(str[0], source.getChar());
+        source.ungetChar();
+    }
+    const char* data = source.getBufferedData(&len);
+    ASSERT_LT(5, len);
+    ASSERT_GE(str_length, len);
+    EXPECT_EQ(0, memcmp(str, data, len));
+
+    source.skipBufferedData(5);
+    EXPECT_EQ(5, source.getPosition());
+    EXPECT_EQ(1, source.getCurrentLine());
+    EXPECT_EQ(str[5], source.getChar());
+    data = source.getBufferedData(&len);
+    EXPECT_EQ(0, memcmp(str + 6, data, len));
+
+    // The consumed data can be ungotten as usual.
+    source.ungetChar();
+    source.ungetChar();
+    EXPECT_EQ(str[4], source.getChar());
+    source.ungetAll();
+    EXPECT_EQ(0, source.getPosition());
+    EXPECT_EQ(str[0], source.getChar());
+
+    // Nothing is left at the end.
+    while (source.getChar() != InputSource::END_OF_STREAM) {
+        ;
+    }
+    source.getBufferedData(&len);
+    EXPECT_EQ(0, len);
+}
+
+TEST_F(InputSourceTest, bufferedData) {
+    checkBufferedData(source_, str_, str_length_);
+}
+
+TEST_F(InputSourceTest, bufferedDataFile) {
+    // The file is read in large chunks, so once we get the first character,
+    // all of this small file is available.
+    std::ifstream fs(TEST_DATA_SRCDIR "/masterload.txt");
+    const std::string str((std::istreambuf_iterator<char>(fs)),
+                          std::istreambuf_iterator<char>());
+    fs.close();
+
+    InputSource source(TEST_DATA_SRCDIR "/masterload.txt");
+    size_t len;
+    EXPECT_EQ(str[0], source.getChar());
+    source.getBufferedData(&len);
+    EXPECT_EQ(str.size() - 1, len);
+    source.ungetChar();
+    checkBufferedData(source, str.c_str(), str.size());
+}
+
+// If the file gets truncated while we are reading it, it's an error (not
+// the end of the file).
+TEST_F(InputSourceTest, truncatedFile) {
+    const char* const filename = TEST_DATA_BUILDDIR "/truncated.txt";
+    const std::string line("example.org. 3600 IN A 192.0.2.1\n");
+    {
+        std::ofstream ofs(filename);
+        for (size_t i = 0; i < 10000; ++i) {
+            ofs << line;
+        }
+    }
+
+    InputSource source(filename);
+    EXPECT_EQ(line.size() * 10000, source.getSize());
+    EXPECT_EQ(line[0], source.getChar());
+    ASSERT_EQ(0, truncate(filename, line.size() * 100));
+    EXPECT_THROW({
+        while (source.getChar() != InputSource::END_OF_STREAM) {
+            ;
+        }
+    }, MasterLexer::ReadError);
+    unlink(filename);
+}
+
+// The data read in bulk from a stream is kept across compact() as long as
+// it's not consumed, including when the consumed part is removed.
+TEST_F(InputSourceTest, compactLargeStream) {
+    std::string str;
+    for (size_t i = 0; str.size() < 20000; ++i) {
+        str += "Line" + std::string(i % 80, 'x') + "\n";
+    }
+    stringstream ss(str);
+    InputSource source(ss);
+    for (size_t i = 0; i < str.size(); ++i) {
+        ASSERT_EQ(str[i], source.getChar());
+        if (str[i] == '\n') {
+            source.compact();
+            EXPECT_THROW(source.ungetChar(),
+                         InputSource::UngetBeforeBeginning);
+        }
+    }
+    EXPECT_EQ(InputSource::END_OF_STREAM, source.getChar());
+    EXPECT_EQ(str.size(), source.getPosition());
+}
+
 // ungetAll() should skip back to the place where the InputSource
 // started at construction, or the last saved start of line.
 TEST_F(InputSourceTest, ungetAll) {
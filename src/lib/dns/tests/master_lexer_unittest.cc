@@ -446,6 +446,45 @@ TEST_F(MasterLexerTest, getNextTokenString) {
     eofCheck(lexer, MasterToken::STRING);
 }
 
+// Strings and numbers of various lengths, whose data is examined in bulk
+// where possible.  Special characters in the middle of them should be
+// handled just like when the data is examined character by character.
+TEST_F(MasterLexerTest, getNextTokenLongString) {
+    for (size_t len = 1; len <= 40; ++len) {
+        ss << string(len, 'a') << " " << string(len, '1') << " "
+           << string(len, 'b') << "\\ " << string(len, 'c') << "\n"
+           << string(len, 'd') << ";comment " << string(len, 'e') << "\n"
+           << string(len, 'f') << "\x80(" << string(len, 'g') << ")\n";
+    }
+    lexer.pushSource(ss);
+
+    for (size_t len = 1; len <= 40; ++len) {
+        EXPECT_EQ(string(len, 'a'),
+                  lexer.getNextToken(MasterToken::STRING).getString());
+        if (len < 10) {
+            EXPECT_EQ(lexical_cast<uint32_t>(string(len, '1')),
+                      lexer.getNextToken(MasterToken::NUMBER).getNumber());
+        } else {
+            // Too large for a number; it's a string if it's not expected
+            // to be a number.
+            EXPECT_EQ(string(len, '1'),
+                      lexer.getNextToken(MasterToken::STRING).getString());
+        }
+        EXPECT_EQ(string(len, 'b') + "\\ " + string(len, 'c'),
+                  lexer.getNextToken(MasterToken::STRING).getString());
+        EXPECT_EQ(MasterToken::END_OF_LINE, lexer.getNextToken().getType());
+        EXPECT_EQ(string(len, 'd'),
+                  lexer.getNextToken(MasterToken::STRING).getString());
+        EXPECT_EQ(MasterToken::END_OF_LINE, lexer.getNextToken().getType());
+        EXPECT_EQ(string(len, 'f') + "\x80",
+                  lexer.getNextToken(MasterToken::STRING).getString());
+        EXPECT_EQ(string(len, 'g'),
+                  lexer.getNextToken(MasterToken::STRING).getString());
+        EXPECT_EQ(MasterToken::END_OF_LINE, lexer.getNextToken().getType());
+    }
+    EXPECT_EQ(MasterToken::END_OF_FILE, lexer.getNextToken().getType());
+}
+
 TEST_F(MasterLexerTest, getNextTokenQString) {
     ss << "\"quoted-string\"\n";
     ss << "\n";
@@ -21,6 +21,8 @@
 #include <dns/name.h>
 #include <dns/rdata.h>
 
+#include <util/buffer.h>
+
 #include <gtest/gtest.h>
 
 #include <boost/bind.hpp>
@@ -73,6 +75,25 @@ public:
         rrsets_.push_back(rrset);
     }
 
+    // Wire-format version of addRRset().  It also counts the RRs added
+    // this way.
+    void addWireRRset(const Name& name, const RRClass& rrclass,
+                      const RRType& rrtype, const RRTTL& rrttl,
+                      const uint8_t* data, size_t data_len)
+    {
+        isc::util::InputBuffer buffer(data, data_len);
+        addRRset(name, rrclass, rrtype, rrttl,
+                 rdata::createRdata(rrtype, rrclass, buffer, data_len));
+        ++wire_count_;
+    }
+
+    void setWireCallback() {
+        wire_count_ = 0;
+        loader_->setAddWireCallback(
+            boost::bind(&MasterLoaderTest::addWireRRset, this,
+                        _1, _2, _3, _4, _5, _6));
+    }
+
     void setLoader(const char* file, const Name& origin,
                    const RRClass& rrclass, const MasterLoader::Options options)
     {
@@ -146,6 +167,7 @@ public:
     vector<string> errors_;
     vector<string> warnings_;
     list<RRsetPtr> rrsets_;
+    size_t wire_count_;
 };
 
 // Test simple loading. The zone file contains no tricky things, and nothing is
@@ -1316,6 +1338,58 @@ TEST_F(MasterLoaderTest, ttlUnknownAndEOF) {
                          1);
 }
 
+// Test loading with the wire-format callback.  Supported types are given
+// via the callback, and the others as usual.
+TEST_F(MasterLoaderTest, wireCallback) {
+    setLoader(TEST_DATA_SRCDIR "/example.org", Name("example.org."),
+              RRClass::IN(), MasterLoader::MANY_ERRORS);
+    setWireCallback();
+    loader_->load();
+    EXPECT_TRUE(loader_->loadedSucessfully());
+    EXPECT_TRUE(errors_.empty());
+    EXPECT_TRUE(warnings_.empty());
+
+    checkBasicRRs();
+    EXPECT_EQ(3, wire_count_);  // NS, A and AAAA
+}
+
+// Errors are handled the same way as with the normal callback.
+TEST_F(MasterLoaderTest, wireCallbackErrors) {
+    stringstream zone_stream("a.example.org. IN A 192.0.2.1\n"
+                             "b.example.org. 1800 IN A 192.0.2.256\n"
+                             "c.example.org. 1800 IN A 192.0.2.1 garbage\n"
+                             "d IN MX 10 mx\n"
+                             "e IN A 192.0.2.2");
+    setLoader(zone_stream, Name("example.org."), RRClass::IN(),
+              MasterLoader::MANY_ERRORS);
+    setWireCallback();
+    loader_->load();
+    EXPECT_FALSE(loader_->loadedSucessfully());
+    checkRR("d.example.org", RRType::MX(), "10 mx.example.org.", RRTTL(1800));
+    checkRR("e.example.org", RRType::A(), "192.0.2.2", RRTTL(1800));
+    EXPECT_EQ(2, wire_count_);
+
+    ASSERT_EQ(3, errors_.size());
+    checkCallbackMessage(errors_.at(0), "no TTL specified; load rejected", 1);
+    checkCallbackMessage(errors_.at(1), "createRdata from text failed: "
+                         "Bad IN/A RDATA text: '192.0.2.256'", 2);
+    checkCallbackMessage(errors_.at(2), "createRdata from text failed near "
+                         "'garbage': extra input text", 3);
+    ASSERT_EQ(2, warnings_.size());
+    checkCallbackMessage(warnings_.at(0), "using RFC1035 TTL semantics; "
+                         "default to the last explicitly stated TTL", 4);
+    checkCallbackMessage(warnings_.at(1), "file does not end with newline",
+                         5);
+
+    // Without MANY_ERRORS, the first error stops the load.
+    stringstream zone_stream2("b.example.org. 1800 IN A 192.0.2.256\n");
+    setLoader(zone_stream2, Name("example.org."), RRClass::IN(),
+              MasterLoader::DEFAULT);
+    setWireCallback();
+    EXPECT_THROW(loader_->load(), MasterLoaderError);
+    EXPECT_EQ(0, wire_count_);
+}
+
 TEST_F(MasterLoaderTest, ttlOverflow) {
     stringstream zone_stream;
     zone_stream << "example.org. IN SOA . . 0 0 0 0 2147483648\n";
@@ -638,6 +638,93 @@ TEST_F(MessageTest, fromWireMultiple) {
     checkMessageFromWire(message_parse, test_name);
 }
 
+TEST_F(MessageTest, fromWireWithArena) {
+    // Parsing with the arena gives the same result, also when the message
+    // is reused.
+    Message message(Message::PARSE, true);
+    for (int i = 0; i < 3; ++i) {
+        message.clear(Message::PARSE);
+        factoryFromFile(message, "message_fromWire1");
+        checkMessageFromWire(message, test_name);
+    }
+
+    // The same for messages with RRs of empty RDATA and with TSIG.
+    message.clear(Message::PARSE);
+    factoryFromFile(message, "message_fromWire19.wire",
+                    Message::PRESERVE_ORDER);
+    EXPECT_EQ(3, message.getRRCount(Message::SECTION_ANSWER));
+    message.clear(Message::PARSE);
+    factoryFromFile(message, "message_toWire2.wire");
+    const TSIGRecord* tsig_rr = message.getTSIGRecord();
+    ASSERT_NE(static_cast<void*>(NULL), tsig_rr);
+    EXPECT_EQ(Name("www.example.com"), tsig_rr->getName());
+    EXPECT_EQ(85, tsig_rr->getLength());
+    message.clear(Message::PARSE);
+    EXPECT_EQ(static_cast<void*>(NULL), message.getTSIGRecord());
+
+    // Failures in the middle of parsing don't break anything, either.
+    message.clear(Message::PARSE);
+    EXPECT_THROW(factoryFromFile(message, "message_fromWire13.wire"),
+                 DNSMessageFORMERR);
+    message.clear(Message::PARSE);
+    factoryFromFile(message, "message_fromWire1");
+    checkMessageFromWire(message, test_name);
+}
+
+TEST_F(MessageTest, clearWithArenaObjectsInUse) {
+    // Objects from the arena that are still referenced outside the message
+    // prevent it from being reset.
+    Message message(Message::PARSE, true);
+    factoryFromFile(message, "message_fromWire1");
+    QuestionPtr question = *message.beginQuestion();
+    ConstRRsetPtr rrset = *message.beginSection(Message::SECTION_ANSWER);
+    EXPECT_THROW(message.clear(Message::RENDER), InvalidMessageOperation);
+
+    // The message is left unchanged, and the objects held remain intact.
+    EXPECT_THROW(message.setQid(0), InvalidMessageOperation); // still PARSE
+    checkMessageFromWire(message, test_name);
+    EXPECT_EQ(test_name, question->getName());
+    EXPECT_EQ(test_name, rrset->getName());
+    EXPECT_EQ(2, rrset->getRdataCount());
+
+    // Parsing another message, which starts with clearing the message,
+    // fails in the same way and doesn't overwrite them, either.
+    EXPECT_THROW(factoryFromFile(message, "message_fromWire1"),
+                 InvalidMessageOperation);
+    checkMessageFromWire(message, test_name);
+    EXPECT_EQ(test_name, question->getName());
+    EXPECT_EQ(test_name, rrset->getName());
+    EXPECT_EQ(2, rrset->getRdataCount());
+
+    // An object removed from the message but still held elsewhere counts,
+    // too.
+    question.reset();
+    rrset.reset();
+    RRsetIterator it = message.beginSection(Message::SECTION_ANSWER);
+    rrset = *it;
+    EXPECT_TRUE(message.removeRRset(Message::SECTION_ANSWER, it));
+    EXPECT_THROW(message.clear(Message::PARSE), InvalidMessageOperation);
+
+    // Once they are released the message can be cleared and reused.
+    rrset.reset();
+    EXPECT_NO_THROW(message.clear(Message::PARSE));
+    factoryFromFile(message, "message_fromWire1");
+    checkMessageFromWire(message, test_name);
+}
+
+TEST_F(MessageTest, arenaObjectsOutliveMessage) {
+    // Objects from the arena keep it alive, so they can still be used
+    // after the message is destroyed.
+    ConstRRsetPtr rrset;
+    {
+        Message message(Message::PARSE, true);
+        factoryFromFile(message, "message_fromWire1");
+        rrset = *message.beginSection(Message::SECTION_ANSWER);
+    }
+    EXPECT_EQ(test_name, rrset->getName());
+    EXPECT_EQ(2, rrset->getRdataCount());
+}
+
 TEST_F(MessageTest, fromWireShortBuffer) {
     // We trim a valid message (ending with an SOA RR) for one byte.
     // fromWire() should throw an exception while parsing the trimmed RR.
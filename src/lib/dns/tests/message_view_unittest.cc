@@ -0,0 +1,359 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <exceptions/exceptions.h>
+
+#include <util/buffer.h>
+
+#include <dns/edns.h>
+#include <dns/exceptions.h>
+#include <dns/message.h>
+#include <dns/message_view.h>
+#include <dns/messagerenderer.h>
+#include <dns/question.h>
+#include <dns/rdataclass.h>
+
+#include <gtest/gtest.h>
+
+#include <dns/tests/unittest_util.h>
+
+#include <string>
+#include <vector>
+
+using namespace isc;
+using namespace isc::dns;
+using namespace isc::dns::rdata;
+using isc::util::InputBuffer;
+using isc::UnitTestUtil;
+
+namespace {
+
+class MessageViewTest : public ::testing::Test {
+protected:
+    MessageViewTest() :
+        bogus_section_(static_cast<Message::Section>(
+                           Message::SECTION_ADDITIONAL + 1))
+    {}
+
+    void parseFile(const char* datafile) {
+        data_.clear();
+        UnitTestUtil::readWireData(datafile, data_);
+        view_.parse(&data_[0], data_.size());
+    }
+
+    void parseText(const std::string& datastr) {
+        data_.clear();
+        UnitTestUtil::readWireData(datastr, data_);
+        view_.parse(&data_[0], data_.size());
+    }
+
+    // Render the given message into data_.
+    void renderMessage(Message& message) {
+        MessageRenderer renderer;
+        message.toWire(renderer);
+        const uint8_t* const dp =
+            static_cast<const uint8_t*>(renderer.getData());
+        data_.assign(dp, dp + renderer.getLength());
+    }
+
+    std::string getNameText(Message::Section section, size_t index) {
+        return (view_.getName(section, index, labels_buf_).toText());
+    }
+
+    const Message::Section bogus_section_;
+    MessageView view_;
+    std::vector<unsigned char> data_;
+    uint8_t labels_buf_[LabelSequence::MAX_SERIALIZED_LENGTH];
+};
+
+// Parse the given data with both Message and MessageView, and check they
+// agree on whether it's valid, and if so, on the content.
+void
+checkSameAsMessage(const std::vector<unsigned char>& data) {
+    Message message(Message::PARSE);
+    MessageView view;
+    const unsigned char* const dp = data.empty() ? NULL : &data[0];
+    InputBuffer buffer(dp, data.size());
+    bool message_ok = true;
+    try {
+        message.fromWire(buffer, Message::PRESERVE_ORDER);
+    } catch (const isc::Exception&) {
+        message_ok = false;
+    }
+    bool view_ok = true;
+    try {
+        view.parse(dp, data.size());
+    } catch (const isc::Exception&) {
+        view_ok = false;
+    }
+    ASSERT_EQ(message_ok, view_ok);
+    EXPECT_EQ(view_ok, view.isParsed());
+    if (!view_ok) {
+        return;
+    }
+
+    EXPECT_EQ(message.getQid(), view.getQid());
+    EXPECT_EQ(message.getOpcode(), view.getOpcode());
+    EXPECT_EQ(message.getRcode(), view.getRcode());
+    EXPECT_EQ(message.getHeaderFlag(Message::HEADERFLAG_RD),
+              view.getHeaderFlag(Message::HEADERFLAG_RD));
+    EXPECT_EQ(message.getRRCount(Message::SECTION_QUESTION),
+              view.getRRCount(Message::SECTION_QUESTION));
+    QuestionIterator qit = message.beginQuestion();
+    for (size_t i = 0; qit != message.endQuestion(); ++qit, ++i) {
+        EXPECT_EQ((*qit)->toText(), view.createQuestion(i)->toText());
+    }
+    for (int s = Message::SECTION_ANSWER; s <= Message::SECTION_ADDITIONAL;
+         ++s) {
+        const Message::Section section = static_cast<Message::Section>(s);
+        EXPECT_EQ(message.getRRCount(section), view.getRRCount(section));
+        RRsetIterator rit = message.beginSection(section);
+        for (size_t i = 0; rit != message.endSection(section); ++rit, ++i) {
+            EXPECT_EQ((*rit)->toText(),
+                      view.createRRset(section, i)->toText());
+        }
+    }
+    if (message.getEDNS()) {
+        ASSERT_NE(static_cast<const EDNS*>(NULL), view.getEDNS());
+        EXPECT_EQ(message.getEDNS()->toText(), view.getEDNS()->toText());
+    } else {
+        EXPECT_EQ(static_cast<const EDNS*>(NULL), view.getEDNS());
+    }
+    if (message.getTSIGRecord() != NULL) {
+        ASSERT_TRUE(view.hasTSIGRecord());
+        EXPECT_EQ(message.getTSIGRecord()->toText(),
+                  view.createTSIGRecord()->toText());
+        EXPECT_EQ(message.getTSIGRecord()->getLength(),
+                  view.createTSIGRecord()->getLength());
+    } else {
+        EXPECT_FALSE(view.hasTSIGRecord());
+    }
+}
+
+TEST_F(MessageViewTest, notParsed) {
+    EXPECT_FALSE(view_.isParsed());
+    EXPECT_THROW(view_.getQid(), InvalidMessageOperation);
+    EXPECT_THROW(view_.getRcode(), InvalidMessageOperation);
+    EXPECT_THROW(view_.getRRCount(Message::SECTION_QUESTION),
+                 InvalidMessageOperation);
+    EXPECT_THROW(view_.getEDNS(), InvalidMessageOperation);
+}
+
+TEST_F(MessageViewTest, parse) {
+    parseFile("message_fromWire1");
+    EXPECT_TRUE(view_.isParsed());
+    EXPECT_EQ(0x1035, view_.getQid());
+    EXPECT_EQ(Opcode::QUERY(), view_.getOpcode());
+    EXPECT_EQ(Rcode::NOERROR(), view_.getRcode());
+    EXPECT_TRUE(view_.getHeaderFlag(Message::HEADERFLAG_QR));
+    EXPECT_TRUE(view_.getHeaderFlag(Message::HEADERFLAG_AA));
+    EXPECT_TRUE(view_.getHeaderFlag(Message::HEADERFLAG_RD));
+    EXPECT_FALSE(view_.getHeaderFlag(Message::HEADERFLAG_TC));
+    EXPECT_THROW(view_.getHeaderFlag(static_cast<Message::HeaderFlag>(0)),
+                 InvalidParameter);
+
+    EXPECT_EQ(1, view_.getRRCount(Message::SECTION_QUESTION));
+    EXPECT_EQ(2, view_.getRRCount(Message::SECTION_ANSWER));
+    EXPECT_EQ(0, view_.getRRCount(Message::SECTION_AUTHORITY));
+    EXPECT_EQ(0, view_.getRRCount(Message::SECTION_ADDITIONAL));
+
+    // The names are decompressed.
+    EXPECT_EQ("test.example.com.",
+              getNameText(Message::SECTION_QUESTION, 0));
+    EXPECT_EQ("test.example.com.", getNameText(Message::SECTION_ANSWER, 1));
+    EXPECT_TRUE(view_.getName(Message::SECTION_ANSWER, 0, labels_buf_).
+                equals(LabelSequence(Name("test.example.com"))));
+    EXPECT_EQ(RRType::A(), view_.getType(Message::SECTION_QUESTION, 0));
+    EXPECT_EQ(RRClass::IN(), view_.getClass(Message::SECTION_QUESTION, 0));
+    EXPECT_EQ(RRTTL(3600), view_.getTTL(Message::SECTION_ANSWER, 0));
+    EXPECT_EQ(RRTTL(7200), view_.getTTL(Message::SECTION_ANSWER, 1));
+
+    // Objects are created on request.
+    EXPECT_EQ("test.example.com. IN A", view_.createQuestion(0)->toText());
+    EXPECT_EQ("test.example.com. 7200 IN A 192.0.2.2\n",
+              view_.createRRset(Message::SECTION_ANSWER, 1)->toText());
+
+    EXPECT_EQ(static_cast<const EDNS*>(NULL), view_.getEDNS());
+    EXPECT_FALSE(view_.hasTSIGRecord());
+    EXPECT_FALSE(view_.createTSIGRecord());
+
+    checkSameAsMessage(data_);
+}
+
+TEST_F(MessageViewTest, badAccess) {
+    parseFile("message_fromWire1");
+    EXPECT_THROW(view_.getRRCount(bogus_section_), OutOfRange);
+    EXPECT_THROW(view_.getType(bogus_section_, 0), OutOfRange);
+    EXPECT_THROW(view_.getType(Message::SECTION_ANSWER, 2), OutOfRange);
+    EXPECT_THROW(view_.getName(Message::SECTION_AUTHORITY, 0, labels_buf_),
+                 OutOfRange);
+    EXPECT_THROW(view_.createQuestion(1), OutOfRange);
+    EXPECT_THROW(view_.createRRset(Message::SECTION_ADDITIONAL, 0),
+                 OutOfRange);
+    EXPECT_THROW(view_.getTTL(Message::SECTION_QUESTION, 0),
+                 InvalidMessageSection);
+    EXPECT_THROW(view_.createRRset(Message::SECTION_QUESTION, 0),
+                 InvalidMessageSection);
+}
+
+TEST_F(MessageViewTest, reuse) {
+    parseFile("message_fromWire1");
+    parseFile("message_fromWire2");
+    EXPECT_EQ(0, view_.getRRCount(Message::SECTION_ANSWER));
+    EXPECT_NE(static_cast<const EDNS*>(NULL), view_.getEDNS());
+
+    // A failure empties the view.
+    EXPECT_THROW(parseFile("message_fromWire4"), DNSMessageFORMERR);
+    EXPECT_FALSE(view_.isParsed());
+    parseFile("message_fromWire1");
+    EXPECT_EQ(2, view_.getRRCount(Message::SECTION_ANSWER));
+    view_.clear();
+    EXPECT_FALSE(view_.isParsed());
+}
+
+TEST_F(MessageViewTest, EDNS) {
+    parseFile("message_fromWire2");
+    const EDNS* edns = view_.getEDNS();
+    ASSERT_NE(static_cast<const EDNS*>(NULL), edns);
+    EXPECT_EQ(0, edns->getVersion());
+    EXPECT_EQ(4096, edns->getUDPSize());
+    EXPECT_TRUE(edns->getDNSSECAwareness());
+    // The OPT RR isn't counted.
+    EXPECT_EQ(0, view_.getRRCount(Message::SECTION_ADDITIONAL));
+
+    // Compressed root name as the owner.
+    parseFile("message_fromWire7");
+    EXPECT_NE(static_cast<const EDNS*>(NULL), view_.getEDNS());
+
+    // Bad EDNS.  These are the same as Message.
+    EXPECT_THROW(parseFile("message_fromWire4"), DNSMessageFORMERR);
+    EXPECT_THROW(parseFile("message_fromWire5"), DNSMessageFORMERR);
+    EXPECT_THROW(parseFile("message_fromWire6"), DNSMessageFORMERR);
+    EXPECT_THROW(parseFile("message_fromWire9"), DNSMessageBADVERS);
+}
+
+TEST_F(MessageViewTest, sameAsMessage) {
+    const char* const datafiles[] = {
+        "message_fromWire1", "message_fromWire2", "message_fromWire3",
+        "message_fromWire4", "message_fromWire5", "message_fromWire6",
+        "message_fromWire7", "message_fromWire8", "message_fromWire9",
+        NULL
+    };
+    for (int i = 0; datafiles[i] != NULL; ++i) {
+        SCOPED_TRACE(datafiles[i]);
+        data_.clear();
+        UnitTestUtil::readWireData(datafiles[i], data_);
+        checkSameAsMessage(data_);
+    }
+}
+
+TEST_F(MessageViewTest, truncated) {
+    // Every truncated form of a valid message is rejected, like Message.
+    UnitTestUtil::readWireData("message_fromWire2", data_);
+    const std::vector<unsigned char> full_data = data_;
+    for (size_t len = 0; len < full_data.size(); ++len) {
+        const std::vector<unsigned char> data(full_data.begin(),
+                                              full_data.begin() + len);
+        if (len < 12) {
+            EXPECT_THROW(view_.parse(&full_data[0], len), MessageTooShort);
+        } else {
+            EXPECT_THROW(view_.parse(&full_data[0], len), DNSMessageFORMERR);
+        }
+        checkSameAsMessage(data);
+    }
+}
+
+TEST_F(MessageViewTest, badNames) {
+    // A name pointing to itself.
+    EXPECT_THROW(parseText("1035 0000 0001 0000 0000 0000 c00c 0001 0001"),
+                 DNSMessageFORMERR);
+    checkSameAsMessage(data_);
+
+    // A forward pointer.
+    EXPECT_THROW(parseText("1035 0000 0001 0000 0000 0000 c012 0001 0001 00"),
+                 DNSMessageFORMERR);
+    checkSameAsMessage(data_);
+
+    // Unknown label type.
+    EXPECT_THROW(parseText("1035 0000 0001 0000 0000 0000 4000 0001 0001"),
+                 DNSMessageFORMERR);
+    checkSameAsMessage(data_);
+
+    // Too long (64 labels of 3 bytes plus root).
+    std::string long_name;
+    for (int i = 0; i < 64; ++i) {
+        long_name += " 03616263";
+    }
+    EXPECT_THROW(parseText("1035 0000 0001 0000 0000 0000" + long_name +
+                           " 00 0001 0001"),
+                 DNSMessageFORMERR);
+    checkSameAsMessage(data_);
+}
+
+TEST_F(MessageViewTest, longName) {
+    // The longest possible name (127 labels) is decompressed correctly.
+    std::string name_text;
+    for (int i = 0; i < 127; ++i) {
+        name_text += "a.";
+    }
+    const Name name(name_text);
+    Message message(Message::RENDER);
+    message.setOpcode(Opcode::QUERY());
+    message.setRcode(Rcode::NOERROR());
+    message.addQuestion(Question(name, RRClass::IN(), RRType::A()));
+    RRsetPtr rrset(new RRset(name, RRClass::IN(), RRType::CNAME(),
+                             RRTTL(60)));
+    rrset->addRdata(generic::CNAME(name));
+    message.addRRset(Message::SECTION_ANSWER, rrset);
+    renderMessage(message);
+
+    view_.parse(&data_[0], data_.size());
+    EXPECT_TRUE(view_.getName(Message::SECTION_QUESTION, 0, labels_buf_).
+                equals(LabelSequence(name), true));
+    EXPECT_TRUE(view_.getName(Message::SECTION_ANSWER, 0, labels_buf_).
+                equals(LabelSequence(name), true));
+    checkSameAsMessage(data_);
+}
+
+TEST_F(MessageViewTest, TSIG) {
+    Message message(Message::RENDER);
+    message.setQid(0x2d65);
+    message.setOpcode(Opcode::QUERY());
+    message.setRcode(Rcode::NOERROR());
+    message.addQuestion(Question(Name("www.example.com"), RRClass::IN(),
+                                 RRType::A()));
+    RRsetPtr tsig_rrset(new RRset(Name("www.example.com"), RRClass::ANY(),
+                                  RRType::TSIG(), RRTTL(0)));
+    tsig_rrset->addRdata(any::TSIG("hmac-md5.sig-alg.reg.int. 1302890362 "
+                                   "300 0 11621 0 0"));
+    message.addRRset(Message::SECTION_ADDITIONAL, tsig_rrset);
+    renderMessage(message);
+
+    view_.parse(&data_[0], data_.size());
+    EXPECT_TRUE(view_.hasTSIGRecord());
+    EXPECT_EQ(0, view_.getRRCount(Message::SECTION_ADDITIONAL));
+    const ConstTSIGRecordPtr tsig_record = view_.createTSIGRecord();
+    ASSERT_TRUE(tsig_record);
+    EXPECT_EQ(Name("www.example.com"), tsig_record->getName());
+    EXPECT_EQ(11621, tsig_record->getRdata().getOriginalID());
+    checkSameAsMessage(data_);
+
+    // Move the TSIG to the answer section (ANCOUNT=1, ARCOUNT=0).
+    data_[7] = 1;
+    data_[11] = 0;
+    EXPECT_THROW(view_.parse(&data_[0], data_.size()), DNSMessageFORMERR);
+    checkSameAsMessage(data_);
+}
+
+}
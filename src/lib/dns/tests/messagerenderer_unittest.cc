@@ -238,6 +238,61 @@ TEST_F(MessageRendererTest, writeNameLabelSequence3) {
                   renderer.getData(), renderer.getLength());
 }
 
+// Render the same set of names with writeName() and writeHashedName();
+// the results should be identical.
+void
+checkHashedName(MessageRenderer::CompressMode mode) {
+    const char* const names[] = {
+        "a.example.com", "a.example.com", "b.eXample.CoM", "example.com",
+        "a.example.org", "A.EXAMPLE.ORG", ".", "www.a.example.com", NULL
+    };
+    MessageRenderer expected;
+    MessageRenderer renderer;
+    expected.setCompressMode(mode);
+    renderer.setCompressMode(mode);
+    for (size_t i = 0; names[i] != NULL; ++i) {
+        const Name name(names[i]);
+        const LabelSequence ls(name);
+        size_t hashes[Name::MAX_LABELS];
+        MessageRenderer::computeNameHashes(ls, hashes);
+        expected.writeName(ls);
+        renderer.writeHashedName(ls, hashes);
+
+        // Uncompressed names and relative sequences.
+        expected.writeName(ls, false);
+        renderer.writeHashedName(ls, hashes, false);
+        if (ls.getLabelCount() > 1) {
+            LabelSequence rel_ls(ls);
+            rel_ls.stripRight(1);
+            MessageRenderer::computeNameHashes(rel_ls, hashes);
+            expected.writeName(rel_ls);
+            renderer.writeHashedName(rel_ls, hashes);
+        }
+    }
+    matchWireData(expected.getData(), expected.getLength(),
+                  renderer.getData(), renderer.getLength());
+}
+
+TEST_F(MessageRendererTest, writeHashedName) {
+    checkHashedName(MessageRenderer::CASE_INSENSITIVE);
+    // The hash values are ignored in this mode, and the result should
+    // still be correct.
+    checkHashedName(MessageRenderer::CASE_SENSITIVE);
+}
+
+TEST_F(MessageRendererTest, computeNameHashes) {
+    const Name name("www.Example.com");
+    size_t hashes[Name::MAX_LABELS];
+    MessageRenderer::computeNameHashes(LabelSequence(name), hashes);
+    LabelSequence ls(name);
+    for (size_t i = 0; i < name.getLabelCount(); ++i) {
+        EXPECT_EQ(ls.getHash(false), hashes[i]);
+        if (i + 1 < name.getLabelCount()) {
+            ls.stripLeft(1);
+        }
+    }
+}
+
 TEST_F(MessageRendererTest, setBuffer) {
     OutputBuffer new_buffer(0);
     renderer.setBuffer(&new_buffer);
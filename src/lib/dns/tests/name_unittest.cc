@@ -22,6 +22,7 @@
 #include <util/buffer.h>
 #include <dns/exceptions.h>
 #include <dns/name.h>
+#include <dns/name_internal.h>
 #include <dns/messagerenderer.h>
 
 #include <dns/tests/unittest_util.h>
@@ -758,4 +759,127 @@ TEST_F(NameTest, LeftShiftOperator) {
     oss << example_name;
     EXPECT_EQ(example_name.toText(), oss.str());
 }
+
+// The internal helpers for case insensitive comparison are optimized for
+// various lengths and alignments of data, so check them with all
+// combinations against the simple implementation by maptolower.
+TEST_F(NameTest, mismatchIgnoreCase) {
+    using isc::dns::name::internal::maptolower;
+    using isc::dns::name::internal::mismatchIgnoreCase;
+
+    // All byte values, including those around the upper case letters.
+    vector<uint8_t> data1(300);
+    for (size_t i = 0; i < data1.size(); ++i) {
+        data1[i] = static_cast<uint8_t>(i * 7);
+    }
+    vector<uint8_t> data2(data1.size());
+    for (size_t i = 0; i < data2.size(); ++i) {
+        data2[i] = maptolower[data1[i]];
+    }
+
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (size_t n = 0; n <= 256; ++n) {
+            // The same data ignoring case.
+            EXPECT_EQ(n, mismatchIgnoreCase(&data1[offset], &data2[offset],
+                                            n));
+            // A mismatch at every possible position.
+            for (size_t i = 0; i < n; ++i) {
+                const uint8_t saved = data2[offset + i];
+                data2[offset + i] ^= 0x01;
+                EXPECT_EQ(i, mismatchIgnoreCase(&data1[offset],
+                                                &data2[offset], n));
+                // Only ASCII case is ignored.
+                data2[offset + i] = saved ^ 0x80;
+                EXPECT_EQ(i, mismatchIgnoreCase(&data1[offset],
+                                                &data2[offset], n));
+                data2[offset + i] = saved;
+            }
+        }
+    }
+}
+
+TEST_F(NameTest, downcaseData) {
+    using isc::dns::name::internal::maptolower;
+    using isc::dns::name::internal::downcase;
+
+    vector<uint8_t> data(300);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 7);
+    }
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (size_t n = 0; n <= 256; ++n) {
+            // Bytes beyond n must be intact.
+            vector<uint8_t> result(data.size(), 0xff);
+            downcase(&data[offset], &result[offset], n);
+            for (size_t i = 0; i < result.size(); ++i) {
+                if (i >= offset && i < offset + n) {
+                    EXPECT_EQ(maptolower[data[i]], result[i]);
+                } else {
+                    EXPECT_EQ(0xff, result[i]);
+                }
+            }
+
+            // In-place conversion.
+            result = data;
+            downcase(&result[offset], &result[offset], n);
+            for (size_t i = offset; i < offset + n; ++i) {
+                EXPECT_EQ(maptolower[data[i]], result[i]);
+            }
+        }
+    }
+}
+
+// Check textToWire() against the Name constructor followed by toWire().
+void
+checkTextToWire(const string& text, const Name* origin) {
+    SCOPED_TRACE(text);
+    OutputBuffer expected(0);
+    Name(text.c_str(), text.size(), origin).toWire(expected);
+    OutputBuffer buffer(0);
+    buffer.writeUint8(0xff);    // should be intact
+    isc::dns::name::internal::textToWire(text.c_str(), text.size(), origin,
+                                         buffer);
+    ASSERT_LT(0, buffer.getLength());
+    EXPECT_EQ(0xff, buffer[0]);
+    matchWireData(expected.getData(), expected.getLength(),
+                  static_cast<const uint8_t*>(buffer.getData()) + 1,
+                  buffer.getLength() - 1);
+}
+
+TEST_F(NameTest, textToWire) {
+    using isc::dns::name::internal::textToWire;
+
+    const Name origin("example.com");
+    checkTextToWire("www.example.com.", NULL);
+    checkTextToWire("www.example.com.", &origin);
+    checkTextToWire("WWW.Example.COM.", NULL);  // case is preserved
+    checkTextToWire(".", NULL);
+    checkTextToWire("www", &origin);
+    checkTextToWire("a.b.c", &origin);
+    checkTextToWire("@", &origin);
+    checkTextToWire("\\065\\.b.", NULL);
+    checkTextToWire(string(63, 'x') + "." + string(63, 'x') + "." +
+                    string(63, 'x') + "." + string(61, 'x') + ".", NULL);
+
+    // Errors are the same as those of the constructor.
+    OutputBuffer buffer(0);
+    EXPECT_THROW(textToWire("", 0, NULL, buffer), isc::InvalidParameter);
+    EXPECT_THROW(textToWire(NULL, 0, &origin, buffer),
+                 isc::InvalidParameter);
+    EXPECT_THROW(textToWire("www", 3, NULL, buffer), MissingNameOrigin);
+    EXPECT_THROW(textToWire("a..b.", 5, NULL, buffer), EmptyLabel);
+    const string toolong_label = string(64, 'x') + ".";
+    EXPECT_THROW(textToWire(toolong_label.c_str(), toolong_label.size(),
+                            NULL, buffer), TooLongLabel);
+    const string toolong_name = string(63, 'x') + "." + string(63, 'x') +
+        "." + string(63, 'x') + "." + string(62, 'x') + ".";
+    EXPECT_THROW(textToWire(toolong_name.c_str(), toolong_name.size(),
+                            NULL, buffer), TooLongName);
+    // The name is valid by itself, but too long with the origin.
+    const string long_name = string(63, 'x') + "." + string(63, 'x') + "." +
+        string(63, 'x') + "." + string(50, 'x');
+    EXPECT_THROW(textToWire(long_name.c_str(), long_name.size(), &origin,
+                            buffer), TooLongName);
+    EXPECT_EQ(0, buffer.getLength());
+}
 }
@@ -107,6 +107,12 @@ public:
     // Return if callback is called since the previous call to clear().
     bool isCalled() const { return (type_ != NONE); }
 
+    // Check the callback is called the same way as the other one, except
+    // for the source name.
+    void check(const CreateRdataCallback& other) const {
+        check(source_, other.line_, other.type_, other.reason_txt_);
+    }
+
     void check(const string& expected_srcname, size_t expected_line,
                CallbackType expected_type, const string& expected_reason)
         const
@@ -214,6 +220,166 @@ TEST_F(RdataTest, createRdataWithLexer) {
                    "file does not end with newline");
 }
 
+// Convert text to RDATA with createWireRdata(), and compare the result with
+// that of createRdata() (both the RDATA and the error or warning callback).
+void
+checkWireRdata(const RRType& rrtype, const RRClass& rrclass,
+               const string& text)
+{
+    SCOPED_TRACE(rrtype.toText() + " " + text);
+    const Name origin("example.org");
+
+    CreateRdataCallback callback;
+    MasterLoaderCallbacks callbacks(
+        boost::bind(&CreateRdataCallback::callback, &callback,
+                    CreateRdataCallback::ERROR, _1, _2, _3),
+        boost::bind(&CreateRdataCallback::callback, &callback,
+                    CreateRdataCallback::WARN,  _1, _2, _3));
+    stringstream ss1(text);
+    MasterLexer lexer1;
+    lexer1.pushSource(ss1);
+    ConstRdataPtr rdata;
+    string exception_txt;
+    try {
+        rdata = createRdata(rrtype, rrclass, lexer1, &origin,
+                            MasterLoader::MANY_ERRORS, callbacks);
+    } catch (const isc::Exception& ex) {
+        // Some errors, such as bad base64 text, are propagated as
+        // exceptions.
+        exception_txt = ex.what();
+    }
+    const CreateRdataCallback expected_callback = callback;
+
+    callback.clear();
+    stringstream ss2(text);
+    MasterLexer lexer2;
+    lexer2.pushSource(ss2);
+    OutputBuffer buffer(0);
+    buffer.writeUint8(0);   // should be cleared
+    if (!exception_txt.empty()) {
+        try {
+            createWireRdata(rrtype, rrclass, lexer2, &origin,
+                            MasterLoader::MANY_ERRORS, callbacks, buffer);
+            ADD_FAILURE() << "expected exception wasn't thrown";
+        } catch (const isc::Exception& ex) {
+            EXPECT_EQ(exception_txt, string(ex.what()));
+        }
+        return;
+    }
+    EXPECT_EQ(rdata != NULL,
+              createWireRdata(rrtype, rrclass, lexer2, &origin,
+                              MasterLoader::MANY_ERRORS, callbacks, buffer));
+    callback.check(expected_callback);
+    // Both should have consumed the same input.
+    EXPECT_EQ(lexer1.getPosition(), lexer2.getPosition());
+
+    if (rdata) {
+        OutputBuffer expected_buffer(0);
+        rdata->toWire(expected_buffer);
+        matchWireData(expected_buffer.getData(), expected_buffer.getLength(),
+                      buffer.getData(), buffer.getLength());
+    }
+}
+
+TEST_F(RdataTest, createWireRdata) {
+    // Valid cases, including relative names, comments, and the end of input
+    // without a newline.
+    checkWireRdata(RRType::A(), RRClass::IN(), "192.0.2.1\n");
+    checkWireRdata(RRType::A(), RRClass::IN(), "192.0.2.1 ; comment\n");
+    checkWireRdata(RRType::A(), RRClass::IN(), "192.0.2.1");
+    checkWireRdata(RRType::AAAA(), RRClass::IN(), "2001:db8::1\n");
+    checkWireRdata(RRType::NS(), RRClass::IN(), "ns.example.com.\n");
+    checkWireRdata(RRType::NS(), RRClass::CH(), "ns\n");
+    checkWireRdata(RRType::NS(), RRClass::IN(), "@\n");
+    checkWireRdata(RRType::CNAME(), RRClass::IN(), "Www.Example.COM.\n");
+    checkWireRdata(RRType::MX(), RRClass::IN(), "10 mx\n");
+    checkWireRdata(RRType::MX(), RRClass::IN(), "65535 mx.example.com.\n");
+    checkWireRdata(RRType::TXT(), RRClass::IN(), "text\n");
+    checkWireRdata(RRType::TXT(), RRClass::IN(),
+                   "\"some text\" more \"\" \\065\n");
+    checkWireRdata(RRType::TXT(), RRClass::IN(), "(multi\n line)\n");
+    checkWireRdata(RRType::DS(), RRClass::IN(),
+                   "12892 5 2 F1E184C0E1D615D20EB3C223ACED3B03C773DD952D"
+                   "5F0EB5C777586DE18DA6B5\n");
+    checkWireRdata(RRType::DS(), RRClass::IN(), "12892 5 1 F1E1 84C0\n");
+    checkWireRdata(RRType::RRSIG(), RRClass::IN(),
+                   "A 5 4 43200 20100223214617 20100222214617 8496 "
+                   "isc.org. evxhlGx13mpKLVkKsjpGzycS5twtIoxOmlN14w9t5AgzGB"
+                   "eaxwZEa3mDzOizsCYsSWfrSRNBKZ9uE/FR7a9LsA==\n");
+    checkWireRdata(RRType::RRSIG(), RRClass::IN(),
+                   "NSEC3 5 4 43200 20100223214617 20100222214617 8496 "
+                   "signer ( evxhlGx13mpK\n LVkKsjpGzycS5twt )\n");
+    checkWireRdata(RRType::RRSIG(), RRClass::IN(),
+                   "A 5 4 43200 20100223214617 20100222214617 8496 "
+                   "isc.org.\n");
+    checkWireRdata(RRType::NSEC3(), RRClass::IN(),
+                   "1 1 12 aabbccdd 2T7B4G4VSA5SMI47K61MV5BV1A22BOJR "
+                   "A RRSIG\n");
+    checkWireRdata(RRType::NSEC3(), RRClass::IN(),
+                   "1 0 0 - 2T7B4G4VSA5SMI47K61MV5BV1A22BOJR\n");
+
+    // Error cases.  The error callback is called the same way.
+    checkWireRdata(RRType::A(), RRClass::IN(), "192.0.2.1 extra text\n");
+    checkWireRdata(RRType::A(), RRClass::IN(), "2001:db8::1\n");
+    checkWireRdata(RRType::A(), RRClass::IN(), ")\n");
+    checkWireRdata(RRType::A(), RRClass::IN(), "\n");
+    checkWireRdata(RRType::AAAA(), RRClass::IN(), "192.0.2.1\n");
+    checkWireRdata(RRType::NS(), RRClass::IN(), "bad..name.\n");
+    checkWireRdata(RRType::CNAME(), RRClass::IN(), "\"quoted.\"\n");
+    checkWireRdata(RRType::MX(), RRClass::IN(), "65536 mx.example.com.\n");
+    checkWireRdata(RRType::MX(), RRClass::IN(), "mx.example.com.\n");
+    checkWireRdata(RRType::TXT(), RRClass::IN(), "\n");
+    checkWireRdata(RRType::TXT(), RRClass::IN(), string(256, 'x') + "\n");
+    checkWireRdata(RRType::DS(), RRClass::IN(), "65536 5 2 F1E1\n");
+    checkWireRdata(RRType::DS(), RRClass::IN(), "12892 256 2 F1E1\n");
+    checkWireRdata(RRType::DS(), RRClass::IN(), "12892 5 256 F1E1\n");
+    checkWireRdata(RRType::DS(), RRClass::IN(), "12892 5 2\n");
+    checkWireRdata(RRType::DS(), RRClass::IN(), "12892 5 2 F1E\n");
+    checkWireRdata(RRType::RRSIG(), RRClass::IN(),
+                   "A 256 4 43200 20100223214617 20100222214617 8496 "
+                   "isc.org.\n");
+    checkWireRdata(RRType::RRSIG(), RRClass::IN(),
+                   "A 5 4 43200 201002232146 20100222214617 8496 "
+                   "isc.org.\n");
+    checkWireRdata(RRType::RRSIG(), RRClass::IN(),
+                   "A 5 4 43200 20100223214617 20100222214617 65536 "
+                   "isc.org.\n");
+    checkWireRdata(RRType::RRSIG(), RRClass::IN(),
+                   "BADTYPE 5 4 43200 20100223214617 20100222214617 8496 "
+                   "isc.org.\n");
+    checkWireRdata(RRType::RRSIG(), RRClass::IN(),
+                   "A 5 4 43200 20100223214617 20100222214617 8496 "
+                   "isc.org. evxhlGx13m=pKL\n");
+    checkWireRdata(RRType::NSEC3(), RRClass::IN(),
+                   "1 1 12 aabbccdd 2T7B4G4VSA5SMI47K61MV5BV1A22BOJR=\n");
+    checkWireRdata(RRType::NSEC3(), RRClass::IN(),
+                   "1 1 12 aabbccdd 2T7B4G4VSA5SMI47K61MV5BV1A22BOJR "
+                   "BADTYPE\n");
+    checkWireRdata(RRType::NSEC3(), RRClass::IN(),
+                   "1 1 65536 aabbccdd 2T7B4G4VSA5SMI47K61MV5BV1A22BOJR\n");
+}
+
+TEST_F(RdataTest, canCreateWireRdata) {
+    EXPECT_TRUE(canCreateWireRdata(RRType::A(), RRClass::IN()));
+    EXPECT_TRUE(canCreateWireRdata(RRType::AAAA(), RRClass::IN()));
+    EXPECT_TRUE(canCreateWireRdata(RRType::NS(), RRClass::CH()));
+    EXPECT_TRUE(canCreateWireRdata(RRType::NSEC3(), RRClass::IN()));
+    // A/AAAA are class specific.
+    EXPECT_FALSE(canCreateWireRdata(RRType::A(), RRClass::CH()));
+    EXPECT_FALSE(canCreateWireRdata(RRType::AAAA(), RRClass::CH()));
+    // Other types are not supported.
+    EXPECT_FALSE(canCreateWireRdata(RRType::SOA(), RRClass::IN()));
+    EXPECT_FALSE(canCreateWireRdata(RRType::NSEC(), RRClass::IN()));
+    EXPECT_FALSE(canCreateWireRdata(RRType(65000), RRClass::IN()));
+
+    stringstream ss("ns1.example.com. root.example.com. 1 2 3 4 5\n");
+    lexer.pushSource(ss);
+    EXPECT_THROW(createWireRdata(RRType::SOA(), RRClass::IN(), lexer, NULL,
+                                 MasterLoader::MANY_ERRORS, loader_cb,
+                                 obuffer),
+                 isc::InvalidParameter);
+}
+
 TEST_F(RdataTest, getLength) {
     const in::AAAA aaaa_rdata("2001:db8::1");
     EXPECT_EQ(16, aaaa_rdata.getLength());
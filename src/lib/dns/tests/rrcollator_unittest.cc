@@ -22,6 +22,9 @@
 #include <dns/rdata.h>
 #include <dns/rrset.h>
 #include <dns/rrttl.h>
+#include <dns/wire_rrset.h>
+
+#include <util/buffer.h>
 
 #include <gtest/gtest.h>
 
@@ -54,6 +57,7 @@ protected:
         throw_from_callback_(false),
         collator_(boost::bind(addRRset, _1, &rrsets_, &throw_from_callback_)),
         rr_callback_(collator_.getCallback()),
+        wire_callback_(collator_.getWireCallback()),
         a_rdata1_(createRdata(RRType::A(), rrclass_, "192.0.2.1")),
         a_rdata2_(createRdata(RRType::A(), rrclass_, "192.0.2.2")),
         txt_rdata_(createRdata(RRType::TXT(), rrclass_, "test")),
@@ -92,6 +96,24 @@ protected:
         rrsets_.clear();
     }
 
+    // Call wire_callback_ with the wire format of the given RDATA.
+    void addWireRR(const Name& name, const RRClass& rrclass,
+                   const RRType& rrtype, const RRTTL& rrttl,
+                   const ConstRdataPtr& rdata)
+    {
+        isc::util::OutputBuffer buffer(0);
+        rdata->toWire(buffer);
+        wire_callback_(name, rrclass, rrtype, rrttl,
+                       static_cast<const uint8_t*>(buffer.getData()),
+                       buffer.getLength());
+    }
+
+    // Check the first RRset given via the callback is a WireRRset.
+    bool isWireRRset() const {
+        return (!rrsets_.empty() &&
+                dynamic_cast<const WireRRset*>(rrsets_[0].get()) != NULL);
+    }
+
     const Name origin_;
     const RRClass rrclass_;
     const RRTTL rrttl_;
@@ -99,6 +121,7 @@ protected:
     bool throw_from_callback_;
     RRCollator collator_;
     AddRRCallback rr_callback_;
+    AddWireRRCallback wire_callback_;
     const RdataPtr a_rdata1_, a_rdata2_, txt_rdata_, sig_rdata1_, sig_rdata2_;
     vector<ConstRdataPtr> rdatas_; // placeholder for expected data
 };
@@ -211,4 +234,90 @@ TEST_F(RRCollatorTest, withMasterLoader) {
     checkRRset(origin_, rrclass_, RRType::A(), rrttl_, rdatas_);
 }
 
+TEST_F(RRCollatorTest, wireRRs) {
+    // Same as basicCases, but with the wire-format callback.  The resulting
+    // RRsets are WireRRsets.
+    addWireRR(origin_, rrclass_, RRType::A(), RRTTL(20), a_rdata1_);
+    addWireRR(origin_, rrclass_, RRType::A(), RRTTL(10), a_rdata2_);
+    EXPECT_TRUE(rrsets_.empty());
+    addWireRR(origin_, rrclass_, RRType::TXT(), rrttl_, txt_rdata_);
+    rdatas_.push_back(a_rdata1_);
+    rdatas_.push_back(a_rdata2_);
+    EXPECT_TRUE(isWireRRset());
+    checkRRset(origin_, rrclass_, RRType::A(), RRTTL(10), rdatas_);
+
+    addWireRR(Name("txt.example.com"), rrclass_, RRType::TXT(), rrttl_,
+              txt_rdata_);
+    rdatas_.clear();
+    rdatas_.push_back(txt_rdata_);
+    checkRRset(origin_, rrclass_, RRType::TXT(), rrttl_, rdatas_);
+
+    addWireRR(Name("txt.example.com"), RRClass::CH(), RRType::TXT(), rrttl_,
+              txt_rdata_);
+    checkRRset(Name("txt.example.com"), rrclass_, RRType::TXT(), rrttl_,
+               rdatas_);
+
+    collator_.flush();
+    EXPECT_TRUE(isWireRRset());
+    checkRRset(Name("txt.example.com"), RRClass::CH(), RRType::TXT(), rrttl_,
+               rdatas_);
+}
+
+TEST_F(RRCollatorTest, addWireRRSIGs) {
+    // RRSIGs in the wire format are also distinguished by their covered
+    // types.
+    addWireRR(origin_, rrclass_, RRType::RRSIG(), rrttl_, sig_rdata1_);
+    addWireRR(origin_, rrclass_, RRType::RRSIG(), rrttl_, sig_rdata1_);
+    addWireRR(origin_, rrclass_, RRType::RRSIG(), rrttl_, sig_rdata2_);
+
+    rdatas_.push_back(sig_rdata1_);
+    rdatas_.push_back(sig_rdata1_);
+    checkRRset(origin_, rrclass_, RRType::RRSIG(), rrttl_, rdatas_);
+
+    // Too short RRSIG RDATA can't be compared.
+    const uint8_t data[] = { 0 };
+    EXPECT_THROW(wire_callback_(origin_, rrclass_, RRType::RRSIG(), rrttl_,
+                                data, sizeof(data)), isc::BadValue);
+}
+
+TEST_F(RRCollatorTest, mixWireAndRdata) {
+    // RRs given via the two callbacks are never collated into one RRset.
+    rr_callback_(origin_, rrclass_, RRType::A(), rrttl_, a_rdata1_);
+    addWireRR(origin_, rrclass_, RRType::A(), rrttl_, a_rdata2_);
+    rdatas_.push_back(a_rdata1_);
+    EXPECT_FALSE(isWireRRset());
+    checkRRset(origin_, rrclass_, RRType::A(), rrttl_, rdatas_);
+
+    rr_callback_(origin_, rrclass_, RRType::A(), rrttl_, a_rdata1_);
+    rdatas_.clear();
+    rdatas_.push_back(a_rdata2_);
+    EXPECT_TRUE(isWireRRset());
+    checkRRset(origin_, rrclass_, RRType::A(), rrttl_, rdatas_);
+}
+
+TEST_F(RRCollatorTest, withMasterLoaderWire) {
+    // With the wire-format callback, supported types are given as
+    // WireRRsets, and others as usual.
+    std::istringstream ss("example.com. 3600 IN A 192.0.2.1\n"
+                          "example.com. 3600 IN A 192.0.2.2\n"
+                          "example.com. 3600 IN NSEC "
+                          "example.com. A NSEC\n");
+    MasterLoader loader(ss, origin_, rrclass_,
+                        MasterLoaderCallbacks::getNullCallbacks(),
+                        collator_.getCallback());
+    loader.setAddWireCallback(collator_.getWireCallback());
+    loader.load();
+    rdatas_.push_back(a_rdata1_);
+    rdatas_.push_back(a_rdata2_);
+    EXPECT_TRUE(isWireRRset());
+    checkRRset(origin_, rrclass_, RRType::A(), rrttl_, rdatas_);
+
+    collator_.flush();
+    rdatas_.clear();
+    rdatas_.push_back(createRdata(RRType::NSEC(), rrclass_,
+                                  "example.com. A NSEC"));
+    EXPECT_FALSE(isWireRRset());
+    checkRRset(origin_, rrclass_, RRType::NSEC(), rrttl_, rdatas_);
+}
+
 }
@@ -0,0 +1,280 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <exceptions/exceptions.h>
+
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/sorting_rrcollator.h>
+#include <dns/rdata.h>
+#include <dns/rdataclass.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+using namespace isc::dns;
+using namespace isc::dns::rdata;
+
+namespace {
+
+void
+addRRset(const RRsetPtr& rrset, vector<ConstRRsetPtr>* to_append,
+         const bool* do_throw) {
+    if (*do_throw) {
+        isc_throw(isc::Unexpected, "faked failure");
+    }
+    to_append->push_back(rrset);
+}
+
+class SortingRRCollatorTest : public ::testing::Test {
+protected:
+    SortingRRCollatorTest() :
+        origin_("example.com"), rrclass_(RRClass::IN()), rrttl_(3600),
+        throw_from_callback_(false),
+        collator_(boost::bind(addRRset, _1, &rrsets_, &throw_from_callback_)),
+        rr_callback_(collator_.getCallback()),
+        a_rdata1_(createRdata(RRType::A(), rrclass_, "192.0.2.1")),
+        a_rdata2_(createRdata(RRType::A(), rrclass_, "192.0.2.2")),
+        txt_rdata_(createRdata(RRType::TXT(), rrclass_, "test")),
+        sig_rdata1_(createRdata(RRType::RRSIG(), rrclass_,
+                                "A 5 3 3600 20000101000000 20000201000000 "
+                                "12345 example.com. FAKE")),
+        sig_rdata2_(createRdata(RRType::RRSIG(), rrclass_,
+                                "NS 5 3 3600 20000101000000 20000201000000 "
+                                "12345 example.com. FAKE"))
+    {}
+
+    // Find the RRset of the given name, class and type in rrsets_, and
+    // check it.  Each RRset must appear only once.
+    void checkRRset(const Name& expected_name, const RRClass& expected_class,
+                    const RRType& expected_type, const RRTTL& expected_ttl,
+                    const vector<ConstRdataPtr>& expected_rdatas) {
+        SCOPED_TRACE(expected_name.toText(true) + "/" +
+                     expected_class.toText() + "/" + expected_type.toText());
+
+        ConstRRsetPtr actual;
+        for (size_t i = 0; i < rrsets_.size(); ++i) {
+            if (rrsets_[i]->getName() == expected_name &&
+                rrsets_[i]->getClass() == expected_class &&
+                rrsets_[i]->getType() == expected_type) {
+                ASSERT_FALSE(actual) << "duplicate RRset";
+                actual = rrsets_[i];
+            }
+        }
+        ASSERT_TRUE(actual);
+        EXPECT_EQ(expected_ttl, actual->getTTL());
+        ASSERT_EQ(expected_rdatas.size(), actual->getRdataCount());
+        vector<ConstRdataPtr>::const_iterator it = expected_rdatas.begin();
+        for (RdataIteratorPtr rit = actual->getRdataIterator();
+             !rit->isLast();
+             rit->next()) {
+            EXPECT_EQ(0, rit->getCurrent().compare(**it));
+            ++it;
+        }
+    }
+
+    const Name origin_;
+    const RRClass rrclass_;
+    const RRTTL rrttl_;
+    vector<ConstRRsetPtr> rrsets_;
+    bool throw_from_callback_;
+    SortingRRCollator collator_;
+    AddRRCallback rr_callback_;
+    const RdataPtr a_rdata1_, a_rdata2_, txt_rdata_, sig_rdata1_, sig_rdata2_;
+    vector<ConstRdataPtr> rdatas_; // placeholder for expected data
+};
+
+TEST_F(SortingRRCollatorTest, basicCases) {
+    const Name txt_name("txt.example.com");
+
+    // RRs of the same RRsets, interleaved with others.  Nothing is given
+    // until flush().
+    rr_callback_(origin_, rrclass_, RRType::A(), rrttl_, a_rdata1_);
+    rr_callback_(origin_, rrclass_, RRType::TXT(), rrttl_, txt_rdata_);
+    rr_callback_(txt_name, rrclass_, RRType::TXT(), rrttl_, txt_rdata_);
+    rr_callback_(txt_name, RRClass::CH(), RRType::TXT(), rrttl_, txt_rdata_);
+    rr_callback_(origin_, rrclass_, RRType::A(), rrttl_, a_rdata2_);
+    EXPECT_TRUE(rrsets_.empty());
+    EXPECT_EQ(5, collator_.getRRCount());
+    EXPECT_EQ(0, collator_.getRunCount());
+
+    collator_.flush();
+    EXPECT_EQ(4, rrsets_.size());
+    EXPECT_EQ(0, collator_.getRRCount());
+
+    rdatas_.push_back(a_rdata1_);
+    rdatas_.push_back(a_rdata2_);
+    checkRRset(origin_, rrclass_, RRType::A(), rrttl_, rdatas_);
+    rdatas_.clear();
+    rdatas_.push_back(txt_rdata_);
+    checkRRset(origin_, rrclass_, RRType::TXT(), rrttl_, rdatas_);
+    checkRRset(txt_name, rrclass_, RRType::TXT(), rrttl_, rdatas_);
+    checkRRset(txt_name, RRClass::CH(), RRType::TXT(), rrttl_, rdatas_);
+
+    // The RRsets of the same name are consecutive.
+    EXPECT_EQ(rrsets_[0]->getName(), rrsets_[1]->getName());
+    EXPECT_EQ(rrsets_[2]->getName(), rrsets_[3]->getName());
+
+    // Redundant flush() will be no-op.
+    rrsets_.clear();
+    collator_.flush();
+    EXPECT_TRUE(rrsets_.empty());
+}
+
+TEST_F(SortingRRCollatorTest, nameCase) {
+    // Owner names are compared case insensitively, and the RRset has the
+    // name of the first RR.
+    const Name upper_origin("EXAMPLE.COM");
+    rr_callback_(upper_origin, rrclass_, RRType::A(), rrttl_, a_rdata1_);
+    rr_callback_(origin_, rrclass_, RRType::A(), rrttl_, a_rdata2_);
+    collator_.flush();
+    ASSERT_EQ(1, rrsets_.size());
+    EXPECT_EQ("EXAMPLE.COM.", rrsets_[0]->getName().toText());
+    EXPECT_EQ(2, rrsets_[0]->getRdataCount());
+}
+
+TEST_F(SortingRRCollatorTest, minTTL) {
+    rr_callback_(origin_, rrclass_, RRType::A(), RRTTL(20), a_rdata1_);
+    rr_callback_(origin_, rrclass_, RRType::TXT(), rrttl_, txt_rdata_);
+    rr_callback_(origin_, rrclass_, RRType::A(), RRTTL(10), a_rdata2_);
+    collator_.flush();
+    rdatas_.push_back(a_rdata1_);
+    rdatas_.push_back(a_rdata2_);
+    checkRRset(origin_, rrclass_, RRType::A(), RRTTL(10), rdatas_);
+}
+
+TEST_F(SortingRRCollatorTest, addRRSIGs) {
+    // RRSIGs are distinguished by their covered types.
+    rr_callback_(origin_, rrclass_, RRType::RRSIG(), rrttl_, sig_rdata1_);
+    rr_callback_(origin_, rrclass_, RRType::A(), rrttl_, a_rdata1_);
+    rr_callback_(origin_, rrclass_, RRType::RRSIG(), rrttl_, sig_rdata2_);
+    rr_callback_(origin_, rrclass_, RRType::RRSIG(), rrttl_, sig_rdata1_);
+    collator_.flush();
+    ASSERT_EQ(3, rrsets_.size());
+    size_t sig_a_count = 0, sig_ns_count = 0;
+    for (size_t i = 0; i < rrsets_.size(); ++i) {
+        if (rrsets_[i]->getType() != RRType::RRSIG()) {
+            continue;
+        }
+        RdataIteratorPtr rit = rrsets_[i]->getRdataIterator();
+        const RRType covered = dynamic_cast<const generic::RRSIG&>(
+            rit->getCurrent()).typeCovered();
+        if (covered == RRType::A()) {
+            sig_a_count = rrsets_[i]->getRdataCount();
+        } else if (covered == RRType::NS()) {
+            sig_ns_count = rrsets_[i]->getRdataCount();
+        }
+    }
+    EXPECT_EQ(2, sig_a_count);
+    EXPECT_EQ(1, sig_ns_count);
+}
+
+TEST_F(SortingRRCollatorTest, emptyFlush) {
+    collator_.flush();
+    EXPECT_TRUE(rrsets_.empty());
+}
+
+TEST_F(SortingRRCollatorTest, throwFromCallback) {
+    rr_callback_(origin_, rrclass_, RRType::A(), rrttl_, a_rdata1_);
+    rr_callback_(origin_, rrclass_, RRType::TXT(), rrttl_, txt_rdata_);
+
+    // The exception is propagated, and the remaining RRs are discarded.
+    throw_from_callback_ = true;
+    EXPECT_THROW(collator_.flush(), isc::Unexpected);
+    EXPECT_EQ(0, collator_.getRRCount());
+
+    throw_from_callback_ = false;
+    collator_.flush();
+    EXPECT_TRUE(rrsets_.empty());
+}
+
+// Give RRs of many RRsets in an order where no two RRs of the same RRset
+// are consecutive, and return the collated RRsets in text.
+vector<string>
+collateMany(size_t window_size, const string& temp_dir,
+            size_t* run_count = NULL)
+{
+    vector<ConstRRsetPtr> rrsets;
+    const bool no_throw = false;
+    SortingRRCollator collator(boost::bind(addRRset, _1, &rrsets, &no_throw),
+                               window_size, temp_dir);
+    AddRRCallback callback = collator.getCallback();
+    for (size_t i = 0; i < 1000; ++i) {
+        std::ostringstream name_oss, addr_oss;
+        name_oss << "name" << (i % 100) << ".example.com";
+        addr_oss << "192.0.2." << (i / 100);
+        callback(Name(name_oss.str()), RRClass::IN(), RRType::A(),
+                 RRTTL(3600), createRdata(RRType::A(), RRClass::IN(),
+                                          addr_oss.str()));
+    }
+    if (run_count != NULL) {
+        *run_count = collator.getRunCount();
+    }
+    collator.flush();
+
+    vector<string> texts;
+    for (size_t i = 0; i < rrsets.size(); ++i) {
+        texts.push_back(rrsets[i]->toText());
+    }
+    return (texts);
+}
+
+TEST_F(SortingRRCollatorTest, spillToFiles) {
+    // All in memory.
+    size_t run_count = 0;
+    const vector<string> expected = collateMany(1024 * 1024, "", &run_count);
+    EXPECT_EQ(0, run_count);
+    ASSERT_EQ(100, expected.size());
+    // Each RRset has all its RDATA in the given order.
+    EXPECT_EQ("name0.example.com. 3600 IN A 192.0.2.0\n"
+              "name0.example.com. 3600 IN A 192.0.2.1\n"
+              "name0.example.com. 3600 IN A 192.0.2.2\n"
+              "name0.example.com. 3600 IN A 192.0.2.3\n"
+              "name0.example.com. 3600 IN A 192.0.2.4\n"
+              "name0.example.com. 3600 IN A 192.0.2.5\n"
+              "name0.example.com. 3600 IN A 192.0.2.6\n"
+              "name0.example.com. 3600 IN A 192.0.2.7\n"
+              "name0.example.com. 3600 IN A 192.0.2.8\n"
+              "name0.example.com. 3600 IN A 192.0.2.9\n", expected[0]);
+
+    // A small window, so the RRs are written to several files.
+    EXPECT_TRUE(expected == collateMany(4096, "", &run_count));
+    EXPECT_LT(1, run_count);
+
+    // Each RR goes to its own file, so the files are merged before all
+    // RRs are given.
+    EXPECT_TRUE(expected == collateMany(1, TEST_DATA_BUILDDIR, &run_count));
+    EXPECT_LT(1, run_count);
+    EXPECT_GE(64, run_count);
+}
+
+TEST_F(SortingRRCollatorTest, badTempDir) {
+    SortingRRCollator collator(boost::bind(addRRset, _1, &rrsets_,
+                                           &throw_from_callback_),
+                               1, "/no/such/dir");
+    EXPECT_THROW(collator.getCallback()(origin_, rrclass_, RRType::A(),
+                                        rrttl_, a_rdata1_),
+                 SortingRRCollatorError);
+}
+
+}
@@ -13,12 +13,17 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <string>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <gtest/gtest.h>
 
 #include <exceptions/exceptions.h>
 
 #include <cryptolink/cryptolink.h>
+#include <cryptolink/crypto_hmac.h>
 
 #include <dns/tsigkey.h>
 
@@ -151,6 +156,46 @@ TEST_F(TSIGKeyTest, assignment) {
     compareTSIGKeys(original, copy);
 }
 
+TEST_F(TSIGKeyTest, getHMAC) {
+    const TSIGKey key(key_name, TSIGKey::HMACSHA256_NAME(),
+                      secret.c_str(), secret.size());
+    boost::shared_ptr<isc::cryptolink::HMAC> hmac = key.getHMAC();
+    EXPECT_EQ(32, hmac->getOutputLength());
+    hmac->update("some data", 9);
+    const vector<uint8_t> sig = hmac->sign();
+
+    // The object is returned to the pool of the key once released, and
+    // it's reused for later calls, also through copies of the key.  The
+    // data added to it in the previous use are discarded.
+    const isc::cryptolink::HMAC* const used = hmac.get();
+    hmac->update("garbage", 7);
+    hmac.reset();
+    const TSIGKey copy(key);
+    hmac = copy.getHMAC();
+    EXPECT_EQ(used, hmac.get());
+    hmac->update("some data", 9);
+    EXPECT_TRUE(sig == hmac->sign());
+
+    // Concurrent users get different objects.
+    boost::shared_ptr<isc::cryptolink::HMAC> hmac2 = key.getHMAC();
+    EXPECT_NE(hmac.get(), hmac2.get());
+    hmac2->update("some data", 9);
+    EXPECT_TRUE(sig == hmac2->sign());
+
+    // The pool survives the keys.
+    {
+        const TSIGKey key2(key);
+        hmac = key2.getHMAC();
+    }
+    hmac.reset();
+
+    // A key without secret (or with an unknown algorithm) can't be used.
+    EXPECT_THROW(TSIGKey(key_name, TSIGKey::HMACSHA256_NAME(), NULL,
+                         0).getHMAC(), isc::cryptolink::BadKey);
+    EXPECT_THROW(TSIGKey(key_name, Name("unknown-alg"), NULL, 0).getHMAC(),
+                 isc::cryptolink::UnsupportedAlgorithm);
+}
+
 class TSIGKeyRingTest : public ::testing::Test {
 protected:
     TSIGKeyRingTest() :
@@ -302,6 +347,27 @@ TEST_F(TSIGKeyRingTest, findFromSome) {
               keyring.find(Name("another.example"), sha256_name).key);
 }
 
+TEST_F(TSIGKeyRingTest, findFromMany) {
+    // A larger set of similar names, and case-insensitive matching.
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(TSIGKeyRing::SUCCESS,
+                  keyring.add(TSIGKey(Name("key" +
+                                           boost::lexical_cast<string>(i) +
+                                           ".example"),
+                                      sha256_name, secret, secret_len)));
+    }
+    EXPECT_EQ(100, keyring.size());
+    for (int i = 0; i < 100; ++i) {
+        const Name name("KEY" + boost::lexical_cast<string>(i) + ".Example");
+        const TSIGKeyRing::FindResult result(keyring.find(name,
+                                                          sha256_name));
+        ASSERT_EQ(TSIGKeyRing::SUCCESS, result.code);
+        EXPECT_EQ(name, result.key->getKeyName());
+    }
+    EXPECT_EQ(TSIGKeyRing::NOTFOUND,
+              keyring.find(Name("key100.example")).code);
+}
+
 TEST(TSIGStringTest, TSIGKeyFromToString) {
     TSIGKey k1 = TSIGKey("test.example:MSG6Ng==:hmac-md5.sig-alg.reg.int");
     TSIGKey k2 = TSIGKey("test.example.:MSG6Ng==:hmac-md5.sig-alg.reg.int.");
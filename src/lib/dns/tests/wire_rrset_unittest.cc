@@ -0,0 +1,176 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <util/buffer.h>
+#include <dns/messagerenderer.h>
+#include <dns/name.h>
+#include <dns/rdata.h>
+#include <dns/rdataclass.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#include <dns/rrttl.h>
+#include <dns/rrset.h>
+#include <dns/wire_rrset.h>
+
+#include <util/unittests/wiredata.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace std;
+using namespace isc::dns;
+using namespace isc::util;
+using namespace isc::dns::rdata;
+using isc::util::unittests::matchWireData;
+
+namespace {
+
+class WireRRsetTest : public ::testing::Test {
+protected:
+    WireRRsetTest() :
+        buffer_(0), expected_buffer_(0),
+        rrset_(Name("www.example.com"), RRClass::IN(), RRType::MX(),
+               RRTTL(3600)),
+        expected_rrset_(Name("www.example.com"), RRClass::IN(), RRType::MX(),
+                        RRTTL(3600)),
+        rdata1_(createRdata(RRType::MX(), RRClass::IN(),
+                            "10 mx1.example.com.")),
+        rdata2_(createRdata(RRType::MX(), RRClass::IN(),
+                            "20 mx2.example.com."))
+    {
+        expected_rrset_.addRdata(rdata1_);
+        expected_rrset_.addRdata(rdata2_);
+    }
+
+    // Add the wire format of rdata to rrset_.
+    void addWireRdata(const Rdata& rdata) {
+        buffer_.clear();
+        rdata.toWire(buffer_);
+        rrset_.addWireRdata(buffer_.getData(), buffer_.getLength());
+    }
+
+    OutputBuffer buffer_;
+    OutputBuffer expected_buffer_;
+    WireRRset rrset_;
+    BasicRRset expected_rrset_;
+    const ConstRdataPtr rdata1_, rdata2_;
+};
+
+TEST_F(WireRRsetTest, getParams) {
+    EXPECT_EQ(Name("www.example.com"), rrset_.getName());
+    EXPECT_EQ(RRClass::IN(), rrset_.getClass());
+    EXPECT_EQ(RRType::MX(), rrset_.getType());
+    EXPECT_EQ(RRTTL(3600), rrset_.getTTL());
+    rrset_.setTTL(RRTTL(60));
+    EXPECT_EQ(RRTTL(60), rrset_.getTTL());
+    EXPECT_EQ(0, rrset_.getRdataCount());
+}
+
+TEST_F(WireRRsetTest, addWireRdata) {
+    addWireRdata(*rdata1_);
+    addWireRdata(*rdata2_);
+    EXPECT_EQ(2, rrset_.getRdataCount());
+
+    for (size_t i = 0; i < 2; ++i) {
+        expected_buffer_.clear();
+        (i == 0 ? rdata1_ : rdata2_)->toWire(expected_buffer_);
+        matchWireData(expected_buffer_.getData(),
+                      expected_buffer_.getLength(),
+                      rrset_.getWireRdata(i), rrset_.getWireRdataLength(i));
+    }
+    EXPECT_THROW(rrset_.getWireRdata(2), isc::OutOfRange);
+    EXPECT_THROW(rrset_.getWireRdataLength(2), isc::OutOfRange);
+
+    // Empty RDATA (which is valid for some types) is held as is.
+    rrset_.addWireRdata(NULL, 0);
+    EXPECT_EQ(3, rrset_.getRdataCount());
+    EXPECT_EQ(0, rrset_.getWireRdataLength(2));
+    EXPECT_EQ(static_cast<const uint8_t*>(NULL), rrset_.getWireRdata(2));
+
+    // Too long RDATA
+    const vector<uint8_t> data(MAX_RDLENGTH + 1);
+    EXPECT_THROW(rrset_.addWireRdata(&data[0], data.size()),
+                 InvalidRdataLength);
+}
+
+TEST_F(WireRRsetTest, addRdata) {
+    // Rdata objects and text are converted to the wire format.
+    rrset_.addRdata(rdata1_);
+    rrset_.addRdata("20 mx2.example.com.");
+    EXPECT_EQ(2, rrset_.getRdataCount());
+    expected_buffer_.clear();
+    rdata2_->toWire(expected_buffer_);
+    matchWireData(expected_buffer_.getData(), expected_buffer_.getLength(),
+                  rrset_.getWireRdata(1), rrset_.getWireRdataLength(1));
+}
+
+TEST_F(WireRRsetTest, getRdataIterator) {
+    addWireRdata(*rdata1_);
+    addWireRdata(*rdata2_);
+    RdataIteratorPtr it = rrset_.getRdataIterator();
+    ASSERT_FALSE(it->isLast());
+    EXPECT_EQ(0, it->getCurrent().compare(*rdata1_));
+    it->next();
+    ASSERT_FALSE(it->isLast());
+    EXPECT_EQ(0, it->getCurrent().compare(*rdata2_));
+    it->next();
+    EXPECT_TRUE(it->isLast());
+    it->first();
+    EXPECT_EQ(0, it->getCurrent().compare(*rdata1_));
+}
+
+TEST_F(WireRRsetTest, render) {
+    // The results are the same as those of BasicRRset.
+    addWireRdata(*rdata1_);
+    addWireRdata(*rdata2_);
+    EXPECT_EQ(expected_rrset_.toText(), rrset_.toText());
+    EXPECT_EQ(expected_rrset_.getLength(), rrset_.getLength());
+
+    buffer_.clear();
+    EXPECT_EQ(2, rrset_.toWire(buffer_));
+    EXPECT_EQ(2, expected_rrset_.toWire(expected_buffer_));
+    matchWireData(expected_buffer_.getData(), expected_buffer_.getLength(),
+                  buffer_.getData(), buffer_.getLength());
+
+    MessageRenderer renderer;
+    MessageRenderer expected_renderer;
+    EXPECT_EQ(2, rrset_.toWire(renderer));
+    EXPECT_EQ(2, expected_rrset_.toWire(expected_renderer));
+    matchWireData(expected_renderer.getData(), expected_renderer.getLength(),
+                  renderer.getData(), renderer.getLength());
+}
+
+TEST_F(WireRRsetTest, emptyRRset) {
+    EXPECT_THROW(rrset_.toText(), EmptyRRset);
+    EXPECT_THROW(rrset_.getLength(), EmptyRRset);
+
+    WireRRset any_rrset(Name("www.example.com"), RRClass::ANY(),
+                        RRType::MX(), RRTTL(0));
+    EXPECT_EQ(Name("www.example.com").getLength() + 10,
+              any_rrset.getLength());
+}
+
+TEST_F(WireRRsetTest, rrsig) {
+    EXPECT_FALSE(rrset_.getRRsig());
+    EXPECT_EQ(0, rrset_.getRRsigDataCount());
+    EXPECT_THROW(rrset_.addRRsig(RdataPtr()), isc::NotImplemented);
+    EXPECT_THROW(rrset_.addRRsig(ConstRdataPtr()), isc::NotImplemented);
+    EXPECT_THROW(rrset_.addRRsig(expected_rrset_), isc::NotImplemented);
+    EXPECT_THROW(rrset_.addRRsig(ConstRRsetPtr()), isc::NotImplemented);
+    EXPECT_THROW(rrset_.addRRsig(RRsetPtr()), isc::NotImplemented);
+    EXPECT_THROW(rrset_.removeRRsig(), isc::NotImplemented);
+}
+
+}
@@ -66,8 +66,9 @@ struct TSIGContext::TSIGContextImpl {
     {
         if (error == TSIGError::NOERROR()) {
             // In normal (NOERROR) case, the key should be valid, and we
-            // should be able to pre-create a corresponding HMAC object,
-            // which will be likely to be used for sign or verify later.
+            // should be able to pre-create (or get from the pool of the key)
+            // a corresponding HMAC object, which will be likely to be used
+            // for sign or verify later.
             // We do this in the constructor so that we can know the expected
             // digest length in advance.  The creation should normally succeed,
             // but the key information could be still broken, which could
@@ -75,10 +76,7 @@ struct TSIGContext::TSIGContextImpl {
             // it at this moment; a subsequent sign/verify operation will try
             // to create the HMAC, which would also fail.
             try {
-                hmac_.reset(CryptoLink::getCryptoLink().createHMAC(
-                                key_.getSecret(), key_.getSecretLength(),
-                                key_.getAlgorithm()),
-                            deleteHMAC);
+                hmac_ = key_.getHMAC();
             } catch (const isc::Exception&) {
                 return;
             }
@@ -109,20 +107,17 @@ struct TSIGContext::TSIGContextImpl {
     }
 
     // A shortcut method to create an HMAC object for sign/verify.  If one
-    // has been successfully created in the constructor, return it; otherwise
-    // create a new one and return it.  In the former case, the ownership is
-    // transferred to the caller; the stored HMAC will be reset after the
-    // call.
+    // has been successfully created in the constructor, return it;
+    // otherwise get a new one from the key and return it.  In the former
+    // case, the ownership is transferred to the caller; the stored HMAC
+    // will be reset after the call.
     HMACPtr createHMAC() {
         if (hmac_) {
             HMACPtr ret = HMACPtr();
             ret.swap(hmac_);
             return (ret);
         }
-        return (HMACPtr(CryptoLink::getCryptoLink().createHMAC(
-                            key_.getSecret(), key_.getSecretLength(),
-                            key_.getAlgorithm()),
-                        deleteHMAC));
+        return (key_.getHMAC());
     }
 
     // The following three are helper methods to compute the digest for
@@ -12,17 +12,23 @@
 // OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
-#include <map>
 #include <utility>
 #include <vector>
 #include <sstream>
 
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+
 #include <exceptions/exceptions.h>
 
 #include <cryptolink/cryptolink.h>
+#include <cryptolink/crypto_hmac.h>
 
+#include <dns/labelsequence.h>
 #include <dns/name.h>
+#include <dns/name_internal.h>
 #include <util/encode/base64.h>
+#include <util/threads/sync.h>
 #include <dns/tsigkey.h>
 
 using namespace std;
@@ -57,6 +63,68 @@ namespace {
 
         return (isc::cryptolink::UNKNOWN_HASH);
     }
+
+// A pool of idle HMAC objects keyed with the same secret.  Creating an
+// HMAC object involves the lookup of the hash algorithm and computing the
+// keyed pads in the crypto library, which costs about as much as signing
+// a short DNS message, so we keep used objects for later reuse.
+class HMACPool : boost::noncopyable {
+public:
+    ~HMACPool() {
+        for (vector<HMAC*>::iterator it = idle_.begin(); it != idle_.end();
+             ++it) {
+            deleteHMAC(*it);
+        }
+    }
+    HMAC* get(const void* secret, size_t secret_len,
+              HashAlgorithm algorithm)
+    {
+        {
+            isc::util::thread::Mutex::Locker locker(mutex_);
+            if (!idle_.empty()) {
+                HMAC* hmac = idle_.back();
+                idle_.pop_back();
+                return (hmac);
+            }
+        }
+        return (CryptoLink::getCryptoLink().createHMAC(secret, secret_len,
+                                                        algorithm));
+    }
+    // Called from the deleter of the shared pointer, so this must not
+    // throw.  An object that can't be reset or stored is simply deleted.
+    void put(HMAC* hmac) {
+        try {
+            hmac->reset();
+            isc::util::thread::Mutex::Locker locker(mutex_);
+            if (idle_.size() < MAX_IDLE) {
+                idle_.push_back(hmac);
+                return;
+            }
+        } catch (...) {
+        }
+        deleteHMAC(hmac);
+    }
+private:
+    // The number of idle objects we keep; it's the number of concurrent
+    // sign or verify operations with a single key we expect at most.
+    static const size_t MAX_IDLE = 32;
+
+    isc::util::thread::Mutex mutex_;
+    vector<HMAC*> idle_;
+};
+
+// The deleter of the shared pointers returned by TSIGKey::getHMAC().  It
+// holds a reference to the pool, so the pool survives until all objects
+// are returned even if the keys are gone.
+class HMACReturner {
+public:
+    HMACReturner(const boost::shared_ptr<HMACPool>& pool) : pool_(pool) {}
+    void operator()(HMAC* hmac) const {
+        pool_->put(hmac);
+    }
+private:
+    boost::shared_ptr<HMACPool> pool_;
+};
 }
 
 struct
@@ -67,7 +135,8 @@ TSIGKey::TSIGKeyImpl {
         key_name_(key_name), algorithm_name_(algorithm_name),
         algorithm_(algorithm),
         secret_(static_cast<const uint8_t*>(secret),
-                static_cast<const uint8_t*>(secret) + secret_len)
+                static_cast<const uint8_t*>(secret) + secret_len),
+        hmac_pool_(new HMACPool)
     {
         // Convert the key and algorithm names to the canonical form.
         key_name_.downcase();
@@ -80,6 +149,8 @@ TSIGKey::TSIGKeyImpl {
     Name algorithm_name_;
     const isc::cryptolink::HashAlgorithm algorithm_;
     const vector<uint8_t> secret_;
+    // Shared with the copies of the key, as they have the same secret.
+    const boost::shared_ptr<HMACPool> hmac_pool_;
 };
 
 TSIGKey::TSIGKey(const Name& key_name, const Name& algorithm_name,
@@ -194,6 +265,14 @@ TSIGKey::getSecretLength() const {
     return (impl_->secret_.size());
 }
 
+boost::shared_ptr<HMAC>
+TSIGKey::getHMAC() const {
+    return (boost::shared_ptr<HMAC>(
+                impl_->hmac_pool_->get(getSecret(), getSecretLength(),
+                                       getAlgorithm()),
+                HMACReturner(impl_->hmac_pool_)));
+}
+
 std::string
 TSIGKey::toText() const {
     const vector<uint8_t> secret_v(static_cast<const uint8_t*>(getSecret()),
@@ -247,8 +326,32 @@ Name& TSIGKey::HMACSHA512_NAME() {
     return (alg_name);
 }
 
+namespace {
+// Hash and equality of key names for the key ring, both case-insensitive.
+// Key names are typically long and alike (e.g. "host1-host2.example."),
+// so the hash covers the whole name.
+struct KeyNameHash {
+    size_t operator()(const Name& key_name) const {
+        size_t length;
+        const uint8_t* data = LabelSequence(key_name).getData(&length);
+        size_t hash = 2166136261U; // FNV-1a
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ name::internal::maptolower[data[i]]) * 16777619U;
+        }
+        return (hash);
+    }
+};
+
+struct KeyNameEqual {
+    bool operator()(const Name& name1, const Name& name2) const {
+        return (name1.equals(name2));
+    }
+};
+}
+
 struct TSIGKeyRing::TSIGKeyRingImpl {
-    typedef map<Name, TSIGKey> TSIGKeyMap;
+    typedef boost::unordered_map<Name, TSIGKey, KeyNameHash, KeyNameEqual>
+    TSIGKeyMap;
     typedef pair<Name, TSIGKey> NameAndKey;
     TSIGKeyMap keys;
 };
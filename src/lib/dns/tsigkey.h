@@ -17,6 +17,8 @@
 
 #include <cryptolink/cryptolink.h>
 
+#include <boost/shared_ptr.hpp>
+
 namespace isc {
 namespace dns {
 
@@ -184,6 +186,25 @@ public:
     const void* getSecret() const;
     //@}
 
+    /// \brief Return an HMAC object to sign or verify with this key.
+    ///
+    /// The returned object is keyed with the secret of this key and ready
+    /// to be fed the data to sign or verify.  The object is owned by the
+    /// returned shared pointer, and when it's released the object is put
+    /// back into a pool shared by this key and all its copies (including
+    /// the one stored in a \c TSIGKeyRing), so that the next call can
+    /// reuse it without setting up the crypto library again.  The pool
+    /// is safe to use from multiple threads, and it keeps as many objects
+    /// as there have been concurrent users (up to a small limit).
+    ///
+    /// \exception isc::cryptolink::UnsupportedAlgorithm The algorithm of
+    /// this key is unknown.
+    /// \exception isc::cryptolink::BadKey The secret is empty.
+    /// \exception isc::cryptolink::LibraryError Other crypto library error.
+    ///
+    /// \return A shared pointer to the keyed HMAC object.
+    boost::shared_ptr<isc::cryptolink::HMAC> getHMAC() const;
+
     /// \brief Converts the TSIGKey to a string value
     ///
     /// The resulting string will be of the form
@@ -226,6 +247,12 @@ private:
 /// algorithms are considered to be the same, and cannot be stored in the
 /// key ring at the same time.
 ///
+/// Keys are found through a hash of their (case-insensitive) names, so
+/// the cost of \c find() doesn't grow with the number of keys.  Since a
+/// stored key shares its pool of keyed HMAC objects with its copies (see
+/// \c TSIGKey::getHMAC()), the \c TSIGContext objects created for a key
+/// of the ring don't set up the crypto library for every message.
+///
 /// <b>Implementation Note:</b>
 /// For simplicity the initial implementation requests the application make
 /// a copy of keys stored in the key ring if it needs to use the keys for
@@ -0,0 +1,141 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <exceptions/exceptions.h>
+
+#include <util/buffer.h>
+
+#include <dns/wire_rrset.h>
+#include <dns/messagerenderer.h>
+#include <dns/rdata.h>
+
+#include <string>
+#include <vector>
+
+using namespace isc::util;
+
+namespace isc {
+namespace dns {
+
+uint16_t
+WireRRset::getLength() const {
+    if (offsets_.empty()) {
+        // empty rrsets are only allowed for classes ANY and NONE
+        if (rrclass_ != RRClass::ANY() && rrclass_ != RRClass::NONE()) {
+            isc_throw(EmptyRRset,
+                      "getLength() is attempted for an empty RRset");
+        }
+        // name, TYPE, CLASS, TTL and RDLENGTH (=0)
+        return (name_.getLength() + 10);
+    }
+
+    // This is a size_t as some of the following additions may overflow due
+    // to a programming mistake somewhere.
+    const size_t length = (name_.getLength() + 10) * offsets_.size() +
+        data_.size();
+    // 65535 (max UDP size) - 12 (DNS header size)
+    assert(length <= 65523);
+    return (length);
+}
+
+std::string
+WireRRset::toText() const {
+    return (AbstractRRset::toText());
+}
+
+unsigned int
+WireRRset::toWire(AbstractMessageRenderer& renderer) const {
+    return (AbstractRRset::toWire(renderer));
+}
+
+unsigned int
+WireRRset::toWire(OutputBuffer& buffer) const {
+    return (AbstractRRset::toWire(buffer));
+}
+
+void
+WireRRset::addRdata(rdata::ConstRdataPtr rdata) {
+    addRdata(*rdata);
+}
+
+void
+WireRRset::addRdata(const rdata::Rdata& rdata) {
+    OutputBuffer buffer(0);
+    rdata.toWire(buffer);
+    addWireRdata(buffer.getData(), buffer.getLength());
+}
+
+void
+WireRRset::addRdata(const std::string& rdata_str) {
+    addRdata(*rdata::createRdata(rrtype_, rrclass_, rdata_str));
+}
+
+void
+WireRRset::addWireRdata(const void* data, size_t len) {
+    if (len > rdata::MAX_RDLENGTH) {
+        isc_throw(rdata::InvalidRdataLength, "RDATA is too long: " << len);
+    }
+    const uint8_t* const cp = static_cast<const uint8_t*>(data);
+    offsets_.push_back(data_.size());
+    data_.insert(data_.end(), cp, cp + len);
+}
+
+const uint8_t*
+WireRRset::getWireRdata(size_t i) const {
+    if (i >= offsets_.size()) {
+        isc_throw(isc::OutOfRange, "RDATA index out of range: " << i);
+    }
+    return (getWireRdataLength(i) == 0 ? NULL : &data_[offsets_[i]]);
+}
+
+size_t
+WireRRset::getWireRdataLength(size_t i) const {
+    if (i >= offsets_.size()) {
+        isc_throw(isc::OutOfRange, "RDATA index out of range: " << i);
+    }
+    const size_t end = (i + 1 < offsets_.size()) ? offsets_[i + 1] :
+        data_.size();
+    return (end - offsets_[i]);
+}
+
+namespace {
+class WireRdataIterator : public RdataIterator {
+public:
+    WireRdataIterator(const WireRRset& rrset) {
+        for (size_t i = 0; i < rrset.getRdataCount(); ++i) {
+            InputBuffer buffer(rrset.getWireRdata(i),
+                               rrset.getWireRdataLength(i));
+            rdatas_.push_back(rdata::createRdata(
+                                  rrset.getType(), rrset.getClass(), buffer,
+                                  buffer.getLength()));
+        }
+        it_ = rdatas_.begin();
+    }
+    virtual void first() { it_ = rdatas_.begin(); }
+    virtual void next() { ++it_; }
+    virtual const rdata::Rdata& getCurrent() const { return (**it_); }
+    virtual bool isLast() const { return (it_ == rdatas_.end()); }
+private:
+    std::vector<rdata::ConstRdataPtr> rdatas_;
+    std::vector<rdata::ConstRdataPtr>::const_iterator it_;
+};
+}
+
+RdataIteratorPtr
+WireRRset::getRdataIterator() const {
+    return (RdataIteratorPtr(new WireRdataIterator(*this)));
+}
+
+} // namespace dns
+} // namespace isc
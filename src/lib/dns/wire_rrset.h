@@ -0,0 +1,196 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DNS_WIRE_RRSET_H
+#define DNS_WIRE_RRSET_H 1
+
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#include <dns/rrttl.h>
+#include <dns/rrset.h>
+
+#include <exceptions/exceptions.h>
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace dns {
+
+/// \brief An RRset that holds its RDATA in the wire format.
+///
+/// This is a special derived class of \c AbstractRRset which stores all
+/// RDATA in a single buffer in the wire format, without any \c Rdata
+/// objects.  It's intended to be used for loading a large number of RRs
+/// from master files (see \c MasterLoader::setAddWireCallback() and
+/// \c RRCollator::getWireCallback()) by applications that only need the
+/// wire format of the RDATA, such as the in-memory data source; these can
+/// get the data by the \c getWireRdata() and \c getWireRdataLength()
+/// methods.
+///
+/// Other applications can still use it as a normal \c AbstractRRset.
+/// \c getRdataIterator() creates \c Rdata objects from the wire-format
+/// data, so it's more expensive than for \c BasicRRset.  The \c addRdata()
+/// methods convert the given RDATA into the wire format.
+///
+/// Like \c BasicRRset, it doesn't support RRSIGs associated with the RRset;
+/// \c getRRsig() returns NULL and the \c addRRsig() and \c removeRRsig()
+/// methods throw \c isc::NotImplemented.
+class WireRRset : public AbstractRRset {
+private:
+    WireRRset(const WireRRset& source);
+    WireRRset& operator=(const WireRRset& source);
+public:
+    /// \brief Constructor from (mostly) fixed parameters of the RRset.
+    ///
+    /// \param name The owner name of the RRset.
+    /// \param rrclass The RR class of the RRset.
+    /// \param rrtype The RR type of the RRset.
+    /// \param ttl The TTL of the RRset.
+    WireRRset(const Name& name, const RRClass& rrclass,
+              const RRType& rrtype, const RRTTL& ttl) :
+        name_(name), rrclass_(rrclass), rrtype_(rrtype), ttl_(ttl)
+    {}
+
+    virtual ~WireRRset() {}
+
+    virtual unsigned int getRdataCount() const {
+        return (offsets_.size());
+    }
+
+    virtual uint16_t getLength() const;
+
+    virtual const Name& getName() const { return (name_); }
+
+    virtual const RRClass& getClass() const { return (rrclass_); }
+
+    virtual const RRType& getType() const { return (rrtype_); }
+
+    virtual const RRTTL& getTTL() const { return (ttl_); }
+
+    virtual void setTTL(const RRTTL& ttl) { ttl_ = ttl; }
+
+    virtual std::string toText() const;
+
+    virtual unsigned int toWire(AbstractMessageRenderer& renderer) const;
+
+    virtual unsigned int toWire(isc::util::OutputBuffer& buffer) const;
+
+    /// \brief Add an RDATA to the RRset.
+    ///
+    /// The RDATA is converted to the wire format.
+    virtual void addRdata(rdata::ConstRdataPtr rdata);
+
+    /// \brief Add an RDATA to the RRset.
+    ///
+    /// The RDATA is converted to the wire format.
+    virtual void addRdata(const rdata::Rdata& rdata);
+
+    /// \brief Add an RDATA to the RRset from its textual representation.
+    virtual void addRdata(const std::string& rdata_str);
+
+    /// \brief Return an iterator of the RDATA of the RRset.
+    ///
+    /// It creates an \c Rdata object for each RDATA on construction.  Unlike
+    /// the case of \c BasicRRset, these objects are owned by the iterator,
+    /// so the references returned by \c getCurrent() are only valid while
+    /// the iterator is alive.
+    virtual RdataIteratorPtr getRdataIterator() const;
+
+    /// \brief Add an RDATA in the wire format to the RRset.
+    ///
+    /// \c data must be a valid wire-format RDATA of the type and class of
+    /// the RRset; this method doesn't check it.  It must not contain
+    /// compressed names.
+    ///
+    /// \throw InvalidRdataLength \c len is larger than
+    /// \c rdata::MAX_RDLENGTH.
+    /// \param data The wire-format RDATA.
+    /// \param len The length of \c data in bytes.
+    void addWireRdata(const void* data, size_t len);
+
+    /// \brief Return the i-th wire-format RDATA of the RRset.
+    ///
+    /// It returns NULL for an RDATA of zero length.
+    ///
+    /// \throw isc::OutOfRange \c i is not smaller than \c getRdataCount().
+    const uint8_t* getWireRdata(size_t i) const;
+
+    /// \brief Return the length of the i-th wire-format RDATA of the RRset.
+    ///
+    /// \throw isc::OutOfRange \c i is not smaller than \c getRdataCount().
+    size_t getWireRdataLength(size_t i) const;
+
+    /// \name Associated RRSIG methods
+    ///
+    /// These are the same as those of \c BasicRRset.
+    //@{
+    virtual RRsetPtr getRRsig() const {
+        return (RRsetPtr());
+    }
+
+    virtual unsigned int getRRsigDataCount() const {
+        return (0);
+    }
+
+    virtual void addRRsig(const rdata::ConstRdataPtr&) {
+        isc_throw(NotImplemented,
+                  "WireRRset does not implement the addRRsig() method");
+    }
+
+    virtual void addRRsig(const rdata::RdataPtr&) {
+        isc_throw(NotImplemented,
+                  "WireRRset does not implement the addRRsig() method");
+    }
+
+    virtual void addRRsig(const AbstractRRset&) {
+        isc_throw(NotImplemented,
+                  "WireRRset does not implement the addRRsig() method");
+    }
+
+    virtual void addRRsig(const ConstRRsetPtr&) {
+        isc_throw(NotImplemented,
+                  "WireRRset does not implement the addRRsig() method");
+    }
+
+    virtual void addRRsig(const RRsetPtr&) {
+        isc_throw(NotImplemented,
+                  "WireRRset does not implement the addRRsig() method");
+    }
+
+    virtual void removeRRsig() {
+        isc_throw(NotImplemented,
+                  "WireRRset does not implement the removeRRsig() method");
+    }
+    //@}
+
+private:
+    const Name name_;
+    const RRClass rrclass_;
+    const RRType rrtype_;
+    RRTTL ttl_;
+    std::vector<uint8_t> data_;      // all RDATA, concatenated
+    std::vector<size_t> offsets_;    // beginning of each RDATA in data_
+};
+
+} // namespace dns
+} // namespace isc
+#endif  // DNS_WIRE_RRSET_H
+
+// Local Variables:
+// mode: c++
+// End:
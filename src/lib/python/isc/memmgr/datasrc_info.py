@@ -46,6 +46,10 @@ class SegmentInfo:
     exist       READY<------complete_----------COPYING
                             update()
 
+    Segments whose readers and writer share the same underlying data
+    (see _needs_copy()) skip the COPYING state and go directly from
+    SYNCHRONIZING to READY.
+
     """
     # Common constants of user type: reader or writer
     READER = 0
@@ -117,6 +121,23 @@ class SegmentInfo:
 
         return None
 
+    # Helper method to determine the state after all old readers have
+    # migrated in sync_reader() and remove_reader().
+    def __state_after_sync(self):
+        return self.COPYING if self._needs_copy() else self.READY
+
+    def _needs_copy(self):
+        """Return whether the old version of the segment needs to be
+        updated (copied) separately once all readers have migrated to the
+        updated version.
+
+        This is True by default; subclasses whose readers and writer
+        share the same underlying data can override it to return False,
+        in which case the COPYING state is skipped.
+
+        """
+        return True
+
     def add_event(self, event_data):
         """Add an event to the end of the pending events queue. The
         event_data is not used internally by this class, and is returned
@@ -193,9 +214,9 @@ class SegmentInfo:
         version of the segment to the set of reader modules that are
         using the "current" version of the segment, and if there are no
         reader modules using the "old" version of the segment, the state
-        is changed to COPYING. If the state has changed to COPYING, it
-        pops the head (oldest) event from the pending events queue and
-        returns it; otherwise it returns None."""
+        is changed to COPYING (or READY, see _needs_copy()). If the state
+        has changed, it pops the head (oldest) event from the pending
+        events queue and returns it; otherwise it returns None."""
         if self.__state != self.SYNCHRONIZING:
             raise SegmentInfoError('sync_reader() called in ' +
                                    'incorrect state: ' + str(self.__state))
@@ -209,7 +230,7 @@ class SegmentInfo:
         self.__old_readers.remove(reader_session_id)
         self.__readers.add(reader_session_id)
 
-        return self.__sync_reader_helper(self.COPYING)
+        return self.__sync_reader_helper(self.__state_after_sync())
 
     def remove_reader(self, reader_session_id):
         """This method must only be called in the SYNCHRONIZING
@@ -219,15 +240,15 @@ class SegmentInfo:
         segment or the "old" version of the segment (wherever the reader
         belonged), and in the latter case, if there are no reader
         modules using the "old" version of the segment, the state is
-        changed to COPYING. If the state has changed to COPYING, it pops
-        the head (oldest) event from the pending events queue and
-        returns it; otherwise it returns None."""
+        changed to COPYING (or READY, see _needs_copy()). If the state
+        has changed, it pops the head (oldest) event from the pending
+        events queue and returns it; otherwise it returns None."""
         if self.__state != self.SYNCHRONIZING:
             raise SegmentInfoError('remove_reader() called in ' +
                                    'incorrect state: ' + str(self.__state))
         if reader_session_id in self.__old_readers:
             self.__old_readers.remove(reader_session_id)
-            return self.__sync_reader_helper(self.COPYING)
+            return self.__sync_reader_helper(self.__state_after_sync())
         elif reader_session_id in self.__readers:
             self.__readers.remove(reader_session_id)
             return None
@@ -265,6 +286,9 @@ class SegmentInfo:
         """
         if type == 'mapped':
             return MappedSegmentInfo(genid, rrclass, datasrc_name, mgr_config)
+        elif type == 'mapped-zones':
+            return MappedZonesSegmentInfo(genid, rrclass, datasrc_name,
+                                          mgr_config)
         elif type is None or type == 'local':
             return None
         raise SegmentInfoError('unknown segment type to create info: ' + type)
@@ -351,6 +375,43 @@ class MappedSegmentInfo(SegmentInfo):
         # Versions should be different
         assert(self.__reader_ver != self.__writer_ver)
 
+class MappedZonesSegmentInfo(SegmentInfo):
+    """SegmentInfo implementation of 'mapped-zones' type memory segments.
+
+    Segments of this type keep each zone in a separate mapped file and
+    list the current ones in a single index file, which the writer
+    replaces atomically when it completes updates.  Readers and the
+    writer therefore use the same index file, and files of updated zones
+    are never modified, so there's no need to update the old version
+    separately (the COPYING state is skipped).
+
+    Like MappedSegmentInfo, access to this class is not protected by any
+    explicit synchronization mechanism.
+
+    """
+    def __init__(self, genid, rrclass, datasrc_name, mgr_config):
+        super().__init__()
+
+        # Something like "/var/bind10/zone-IN-1-sqlite3-mapped-zones"
+        self.__mapped_file = mgr_config['mapped_file_dir'] + os.sep + \
+            'zone-' + str(rrclass) + '-' + str(genid) + '-' + datasrc_name + \
+            '-mapped-zones'
+
+        # Readers can't use the index until the writer builds the first
+        # version of it.
+        self.__reader_ready = False
+
+    def get_reset_param(self, user_type):
+        if user_type == self.READER and not self.__reader_ready:
+            return None
+        return {'mapped-file': self.__mapped_file}
+
+    def switch_versions(self):
+        self.__reader_ready = True
+
+    def _needs_copy(self):
+        return False
+
 class DataSrcInfo:
     """A container for datasrc.ConfigurableClientLists and associated
     in-memory segment information corresponding to a given geration of
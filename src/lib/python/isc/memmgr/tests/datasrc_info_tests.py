@@ -366,6 +366,45 @@ class TestSegmentInfo(unittest.TestCase):
                           SegmentInfo.WRITER)
         self.assertRaises(SegmentInfoError, TestSegmentInfo().switch_versions)
 
+class TestMappedZonesSegmentInfo(unittest.TestCase):
+    def setUp(self):
+        self.__mapped_file_dir = os.environ['TESTDATA_WRITE_PATH']
+        self.__sgmt_info = SegmentInfo.create('mapped-zones', 0, RRClass.IN,
+                                              'sqlite3',
+                                              {'mapped_file_dir':
+                                                   self.__mapped_file_dir})
+        self.__mapped_file = self.__mapped_file_dir + \
+            '/zone-IN-0-sqlite3-mapped-zones'
+
+    def test_reset_params(self):
+        # Readers have nothing to use until the writer builds the index.
+        self.assertIsNone(self.__sgmt_info.get_reset_param(SegmentInfo.READER))
+        self.assertEqual({'mapped-file': self.__mapped_file},
+                         self.__sgmt_info.get_reset_param(SegmentInfo.WRITER))
+
+        # After that, the readers and the writer always use the same index.
+        for i in range(2):
+            self.__sgmt_info.switch_versions()
+            for user_type in [SegmentInfo.READER, SegmentInfo.WRITER]:
+                self.assertEqual({'mapped-file': self.__mapped_file},
+                                 self.__sgmt_info.get_reset_param(user_type))
+
+    def test_no_copy(self):
+        # Once all readers migrate, there's nothing to copy, so it goes
+        # directly to READY and returns the next event.
+        self.__sgmt_info.add_reader(1)
+        self.__sgmt_info.add_reader(2)
+        self.__sgmt_info.add_event((42,))
+        self.__sgmt_info.add_event((43,))
+        self.__sgmt_info.start_update()
+        self.assertIsNone(self.__sgmt_info.complete_update())
+        self.assertIsNone(self.__sgmt_info.sync_reader(1))
+        self.assertEqual(self.__sgmt_info.get_state(),
+                         SegmentInfo.SYNCHRONIZING)
+        self.assertTupleEqual(self.__sgmt_info.remove_reader(2), (42,))
+        self.assertEqual(self.__sgmt_info.get_state(), SegmentInfo.READY)
+        self.assertListEqual(self.__sgmt_info.get_events(), [(43,)])
+
 class MockClientList:
     """A mock ConfigurableClientList class.
 
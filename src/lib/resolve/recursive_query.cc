@@ -18,10 +18,13 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <unistd.h>             // for some IPC/network system calls
+#include <map>
 #include <string>
+#include <vector>
 
 #include <boost/lexical_cast.hpp>
 #include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
 
 #include <dns/question.h>
 #include <dns/message.h>
@@ -34,6 +37,7 @@
 #include <cache/resolver_cache.h>
 #include <nsas/address_request_callback.h>
 #include <nsas/nameserver_address.h>
+#include <util/threads/sync.h>
 
 #include <asio.hpp>
 #include <asiodns/dns_service.h>
@@ -123,6 +127,45 @@ deepestDelegation(Name name, RRClass rrclass,
     return (".");
 }
 
+namespace {
+class RunningQuery;
+}
+
+// The queries being resolved, by their original question.  A question
+// asked again while its query is running doesn't start another query;
+// it's added to the waiters of the running one, which answers them all.
+// The map and the waiters of the queries in it are protected by the mutex.
+struct InFlightQueries : boost::noncopyable {
+    // The questions are compared like the cache does, ignoring the case
+    // of the name.  The resolver doesn't ask for DNSSEC data upstream, so
+    // the answer doesn't depend on the DO bit of the query.
+    struct Key {
+        explicit Key(const Question& question) :
+            name(question.getName()), type(question.getType()),
+            qclass(question.getClass())
+        {}
+        bool operator<(const Key& other) const {
+            if (qclass != other.qclass) {
+                return (qclass < other.qclass);
+            }
+            if (type != other.type) {
+                return (type < other.type);
+            }
+            return (name.lthan(other.name));
+        }
+        Name name;
+        RRType type;
+        RRClass qclass;
+    };
+    typedef std::map<Key, RunningQuery*> QueryMap;
+
+    InFlightQueries() : coalesced_count(0) {}
+
+    isc::util::thread::Mutex mutex;
+    QueryMap queries;
+    uint64_t coalesced_count;
+};
+
 // Here we do not use the typedef above, as the SunStudio compiler
 // mishandles this in its name mangling, and wouldn't compile.
 // We can probably use a typedef, but need to move it to a central
@@ -141,7 +184,8 @@ RecursiveQuery::RecursiveQuery(DNSServiceBase& dns_service,
     upstream_root_(new AddressVector(upstream_root)),
     test_server_("", 0),
     query_timeout_(query_timeout), client_timeout_(client_timeout),
-    lookup_timeout_(lookup_timeout), retries_(retries), rtt_recorder_()
+    lookup_timeout_(lookup_timeout), retries_(retries), rtt_recorder_(),
+    in_flight_(new InFlightQueries)
 {
 }
 
@@ -250,6 +294,10 @@ private:
     asio::deadline_timer client_timer;
     asio::deadline_timer lookup_timer;
 
+    // If set, the first lookup skips the cache.  This is used to refresh
+    // a cached answer that is about to expire.
+    bool skip_cache_;
+
     // If we timed out ourselves (lookup timeout), stop issuing queries
     bool done_;
 
@@ -305,6 +353,29 @@ private:
     // sent to this object as well as being used to update the NSAS.
     boost::shared_ptr<RttRecorder> rtt_recorder_;
 
+    // The queries being resolved, if this one can be waited for, and our
+    // entry in it while we are there.
+    boost::shared_ptr<InFlightQueries> in_flight_;
+    InFlightQueries::QueryMap::iterator in_flight_entry_;
+    bool in_flight_listed_;
+
+    // The answer messages and callbacks of the same question asked while
+    // we are running.  They are answered together with our own callback.
+    typedef std::pair<MessagePtr,
+                      isc::resolve::ResolverInterface::CallbackPtr> Waiter;
+    std::vector<Waiter> waiters_;
+
+    // Remove us from the queries being resolved, so no more waiters are
+    // added, and move the waiters we have to the given vector.
+    void leaveInFlight(std::vector<Waiter>& waiters) {
+        if (in_flight_listed_) {
+            isc::util::thread::Mutex::Locker locker(in_flight_->mutex);
+            in_flight_->queries.erase(in_flight_entry_);
+            in_flight_listed_ = false;
+            waiters.swap(waiters_);
+        }
+    }
+
     // perform a single lookup; first we check the cache to see
     // if we have a response for our query stored already. if
     // so, call handlerecursiveresponse(), if not, we call send()
@@ -314,7 +385,12 @@ private:
 
         Message cached_message(Message::RENDER);
         isc::resolve::initResponseMessage(question_, cached_message);
-        if (cache_.lookup(question_.getName(), question_.getType(),
+        // Only the answer being refreshed is skipped; if it's a CNAME, the
+        // target can come from the cache.
+        const bool skip_cache = skip_cache_;
+        skip_cache_ = false;
+        if (!skip_cache &&
+            cache_.lookup(question_.getName(), question_.getType(),
                           question_.getClass(), cached_message)) {
 
             LOG_DEBUG(isc::resolve::logger, RESLIB_DBG_CACHE, RESLIB_RUNQ_CACHE_FIND)
@@ -676,7 +752,10 @@ public:
         unsigned retries,
         isc::nsas::NameserverAddressStore& nsas,
         isc::cache::ResolverCache& cache,
-        boost::shared_ptr<RttRecorder>& recorder)
+        boost::shared_ptr<RttRecorder>& recorder,
+        const boost::shared_ptr<InFlightQueries>& in_flight =
+            boost::shared_ptr<InFlightQueries>(),
+        bool skip_cache = false)
         :
         io_(io),
         question_(question),
@@ -691,6 +770,7 @@ public:
         retries_(retries),
         client_timer(io.get_io_service()),
         lookup_timer(io.get_io_service()),
+        skip_cache_(skip_cache),
         done_(false),
         callback_called_(false),
         nsas_(nsas),
@@ -699,11 +779,26 @@ public:
         nsas_callback_(),
         nsas_callback_out_(false),
         outstanding_events_(0),
-        rtt_recorder_(recorder)
+        rtt_recorder_(recorder),
+        in_flight_(in_flight),
+        in_flight_listed_(false)
     {
         // Set here to avoid using "this" in initializer list.
         nsas_callback_.reset(new ResolverNSASCallback(this));
 
+        // Let the same question wait for us.  This must be done before
+        // the first lookup, which may already give the answer.  If another
+        // query got there first, we simply don't take waiters.
+        if (in_flight_) {
+            isc::util::thread::Mutex::Locker locker(in_flight_->mutex);
+            const std::pair<InFlightQueries::QueryMap::iterator, bool>
+                result(in_flight_->queries.insert(
+                           std::make_pair(InFlightQueries::Key(question_),
+                                          this)));
+            in_flight_entry_ = result.first;
+            in_flight_listed_ = result.second;
+        }
+
         // Setup the timer to stop trying (lookup_timeout)
         if (lookup_timeout >= 0) {
             lookup_timer.expires_from_now(
@@ -723,7 +818,22 @@ public:
         doLookup();
     }
 
-    virtual ~RunningQuery() {};
+    virtual ~RunningQuery() {
+        // We normally leave when our callback is called; this is only for
+        // the case we are deleted before (e.g. by tests), and any waiters
+        // are dropped.
+        std::vector<Waiter> waiters;
+        leaveInFlight(waiters);
+    }
+
+    // Add the answer message and callback of the same question, to be
+    // answered when we are.  Called with the mutex of the queries being
+    // resolved locked, while we are there.
+    void addWaiter(MessagePtr answer_message,
+                   isc::resolve::ResolverInterface::CallbackPtr callback)
+    {
+        waiters_.push_back(Waiter(answer_message, callback));
+    }
 
     // called if we have a lookup timeout; if our callback has
     // not been called, call it now. Then stop.
@@ -754,9 +864,12 @@ public:
     // If the callback has not been called yet, call it now
     // If success is true, we call 'success' with our answer_message
     // If it is false, we call failure()
+    // The same is done with a copy of the answer for each waiter.
     void callCallback(bool success) {
         if (!callback_called_) {
             callback_called_ = true;
+            std::vector<Waiter> waiters;
+            leaveInFlight(waiters);
 
             // There are two types of messages we could store in the
             // cache;
@@ -780,6 +893,18 @@ public:
             } else {
                 resolvercallback_->failure();
             }
+            for (std::vector<Waiter>::iterator it = waiters.begin();
+                 it != waiters.end(); ++it) {
+                if (success) {
+                    if (answer_message_) {
+                        isc::resolve::copyResponseMessage(*answer_message_,
+                                                          it->first);
+                    }
+                    it->second->success(it->first);
+                } else {
+                    it->second->failure();
+                }
+            }
         }
     }
 
@@ -1075,6 +1200,54 @@ public:
 
 }
 
+namespace {
+// The callback of the queries refreshing cached answers.  The answer is
+// cached by the query itself, and nobody is waiting for it.
+class PrefetchCallback : public isc::resolve::ResolverInterface::Callback {
+public:
+    virtual void success(const isc::dns::MessagePtr) {}
+    virtual void failure() {}
+};
+}
+
+AbstractRunningQuery*
+RecursiveQuery::prefetch(const Question& question) {
+    LOG_DEBUG(isc::resolve::logger, RESLIB_DBG_CACHE, RESLIB_RECQ_PREFETCH)
+              .arg(questionText(question));
+    MessagePtr answer_message(new Message(Message::RENDER));
+    isc::resolve::initResponseMessage(question, *answer_message);
+    OutputBufferPtr buffer(new OutputBuffer(0));
+    isc::resolve::ResolverInterface::CallbackPtr callback(
+        new PrefetchCallback);
+    // There's no client to send an error to, so no client timeout.
+    return (new RunningQuery(dns_service_.getIOService(), question,
+                             answer_message, test_server_, buffer, callback,
+                             query_timeout_, -1, lookup_timeout_, retries_,
+                             nsas_, cache_, rtt_recorder_,
+                             boost::shared_ptr<InFlightQueries>(), true));
+}
+
+bool
+RecursiveQuery::coalesce(const Question& question, MessagePtr answer_message,
+                         isc::resolve::ResolverInterface::CallbackPtr callback)
+{
+    isc::util::thread::Mutex::Locker locker(in_flight_->mutex);
+    const InFlightQueries::QueryMap::iterator it =
+        in_flight_->queries.find(InFlightQueries::Key(question));
+    if (it == in_flight_->queries.end()) {
+        return (false);
+    }
+    it->second->addWaiter(answer_message, callback);
+    ++in_flight_->coalesced_count;
+    return (true);
+}
+
+uint64_t
+RecursiveQuery::getCoalescedCount() const {
+    isc::util::thread::Mutex::Locker locker(in_flight_->mutex);
+    return (in_flight_->coalesced_count);
+}
+
 AbstractRunningQuery*
 RecursiveQuery::resolve(const QuestionPtr& question,
     const isc::resolve::ResolverInterface::CallbackPtr callback)
@@ -1089,8 +1262,10 @@ RecursiveQuery::resolve(const QuestionPtr& question,
     // First try to see if we have something cached in the messagecache
     LOG_DEBUG(isc::resolve::logger, RESLIB_DBG_TRACE, RESLIB_RESOLVE)
               .arg(questionText(*question)).arg(1);
+    bool need_prefetch = false;
     if (cache_.lookup(question->getName(), question->getType(),
-                      question->getClass(), *answer_message) &&
+                      question->getClass(), *answer_message,
+                      &need_prefetch) &&
         answer_message->getRRCount(Message::SECTION_ANSWER) > 0) {
         // Message found, return that
         LOG_DEBUG(isc::resolve::logger, RESLIB_DBG_CACHE, RESLIB_RECQ_CACHE_FIND)
@@ -1099,6 +1274,9 @@ RecursiveQuery::resolve(const QuestionPtr& question,
         // TODO: err, should cache set rcode as well?
         answer_message->setRcode(Rcode::NOERROR());
         callback->success(answer_message);
+        if (need_prefetch) {
+            return (prefetch(*question));
+        }
     } else {
         // Perhaps we only have the one RRset?
         // TODO: can we do this? should we check for specific types only?
@@ -1113,6 +1291,10 @@ RecursiveQuery::resolve(const QuestionPtr& question,
                                      cached_rrset);
             answer_message->setRcode(Rcode::NOERROR());
             callback->success(answer_message);
+        } else if (coalesce(*question, answer_message, callback)) {
+            // The question is being resolved, wait for that answer
+            LOG_DEBUG(isc::resolve::logger, RESLIB_DBG_TRACE, RESLIB_RECQ_COALESCED)
+                      .arg(questionText(*question)).arg(1);
         } else {
             // Message not found in cache, start recursive query.  It will
             // delete itself when it is done
@@ -1122,7 +1304,7 @@ RecursiveQuery::resolve(const QuestionPtr& question,
                                      test_server_, buffer, callback,
                                      query_timeout_, client_timeout_,
                                      lookup_timeout_, retries_, nsas_,
-                                     cache_, rtt_recorder_));
+                                     cache_, rtt_recorder_, in_flight_));
         }
     }
     return (NULL);
@@ -1151,8 +1333,10 @@ RecursiveQuery::resolve(const Question& question,
     LOG_DEBUG(isc::resolve::logger, RESLIB_DBG_TRACE, RESLIB_RESOLVE)
               .arg(questionText(question)).arg(2);
 
+    bool need_prefetch = false;
     if (cache_.lookup(question.getName(), question.getType(),
-                      question.getClass(), *answer_message) &&
+                      question.getClass(), *answer_message,
+                      &need_prefetch) &&
         answer_message->getRRCount(Message::SECTION_ANSWER) > 0) {
 
         // Message found, return that
@@ -1161,6 +1345,9 @@ RecursiveQuery::resolve(const Question& question,
         // TODO: err, should cache set rcode as well?
         answer_message->setRcode(Rcode::NOERROR());
         crs->success(answer_message);
+        if (need_prefetch) {
+            return (prefetch(question));
+        }
     } else {
         // Perhaps we only have the one RRset?
         // TODO: can we do this? should we check for specific types only?
@@ -1176,6 +1363,10 @@ RecursiveQuery::resolve(const Question& question,
             answer_message->setRcode(Rcode::NOERROR());
             crs->success(answer_message);
 
+        } else if (coalesce(question, answer_message, crs)) {
+            // The question is being resolved, wait for that answer
+            LOG_DEBUG(isc::resolve::logger, RESLIB_DBG_TRACE, RESLIB_RECQ_COALESCED)
+                      .arg(questionText(question)).arg(2);
         } else {
             // Message not found in cache, start recursive query.  It will
             // delete itself when it is done
@@ -1184,7 +1375,7 @@ RecursiveQuery::resolve(const Question& question,
             return (new RunningQuery(io, question, answer_message,
                                      test_server_, buffer, crs, query_timeout_,
                                      client_timeout_, lookup_timeout_, retries_,
-                                     nsas_, cache_, rtt_recorder_));
+                                     nsas_, cache_, rtt_recorder_, in_flight_));
         }
     }
     return (NULL);
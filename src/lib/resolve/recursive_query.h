@@ -54,6 +54,11 @@ private:
 
 typedef std::vector<std::pair<std::string, uint16_t> > AddressVector;
 
+/// \brief The queries being resolved by a RecursiveQuery
+///
+/// Defined in the implementation; see \c RecursiveQuery::resolve().
+struct InFlightQueries;
+
 /// \brief A Running query
 ///
 /// This base class represents an active running query object;
@@ -143,6 +148,11 @@ public:
     /// CallbackPtr object shall be called (with either success() or
     /// failure(). See ResolverInterface::Callback for more information.
     ///
+    /// If the same question (name, type and class) is already being
+    /// resolved, no new query is started.  The callback is called with
+    /// the answer of the running query when that one gets it, and NULL is
+    /// returned.
+    ///
     /// \param question The question being answered <qname/qclass/qtype>
     /// \param callback Callback object. See
     ///        \c ResolverInterface::Callback for more information
@@ -156,6 +166,10 @@ public:
     /// callback object, which calls resume() on the given DNSServer
     /// object.
     ///
+    /// Questions already being resolved are handled as by the other
+    /// version; the answer of the running query is copied to
+    /// \c answer_message.
+    ///
     /// \param question The question being answered <qname/qclass/qtype>
     /// \param answer_message An output Message into which the final response will
     ///        be copied.
@@ -167,8 +181,11 @@ public:
     ///         itself in normal circumstances, and can normally be ignored
     ///         by the caller, but a pointer is returned for use-cases
     ///         such as unit tests.
-    ///         Returns NULL if the data was found internally and no actual
-    ///         query was sent.
+    ///         Returns NULL if the data was found internally or is
+    ///         already being resolved, and no actual query was sent.
+    ///         If the data was found in the cache, but
+    ///         is popular and about to expire, a query refreshing it is
+    ///         sent and returned.
     AbstractRunningQuery* resolve(const isc::dns::Question& question,
                           isc::dns::MessagePtr answer_message,
                           isc::util::OutputBufferPtr buffer,
@@ -208,7 +225,39 @@ public:
     /// \param port Port number of the test server
     void setTestServer(const std::string& address, uint16_t port);
 
+    /// \brief Return the number of coalesced questions
+    ///
+    /// This is the number of questions given to \c resolve() that were
+    /// not in the cache but already being resolved, so they waited for
+    /// the answer of the running query instead of starting a new one.
+    uint64_t getCoalescedCount() const;
+
 private:
+    /// \brief Wait for the answer of a running query
+    ///
+    /// If a query is resolving the question, the answer message and
+    /// callback are added to those it answers when it's done.
+    ///
+    /// \param question The question to be resolved
+    /// \param answer_message The message the answer is copied to
+    /// \param callback The callback to be called with \c answer_message
+    /// \return true if a query was found, false otherwise
+    bool coalesce(const isc::dns::Question& question,
+                  isc::dns::MessagePtr answer_message,
+                  isc::resolve::ResolverInterface::CallbackPtr callback);
+
+    /// \brief Refresh a cached answer
+    ///
+    /// Resolves the question without looking at the cached answer, and
+    /// caches the result.  This is done when the cache finds that the
+    /// answer is popular and about to expire, so that it's refreshed
+    /// while it's still used and its clients don't miss the cache when
+    /// it expires.
+    ///
+    /// \param question The question of the cached answer
+    /// \return The query refreshing the answer
+    AbstractRunningQuery* prefetch(const isc::dns::Question& question);
+
     DNSServiceBase& dns_service_;
     isc::nsas::NameserverAddressStore& nsas_;
     isc::cache::ResolverCache& cache_;
@@ -222,6 +271,9 @@ private:
     int lookup_timeout_;
     unsigned retries_;
     boost::shared_ptr<RttRecorder>  rtt_recorder_;  ///< Round-trip time recorder
+    /// The queries being resolved; shared with them, as they may outlive
+    /// this object.
+    boost::shared_ptr<InFlightQueries> in_flight_;
 };
 
 }      // namespace asiodns
@@ -1000,6 +1000,73 @@ TEST_F(RecursiveQueryTest, CachedNS) {
         "It does not ask NSAS anything, how does it know where to send?";
 }
 
+// Test that a popular cached answer that is about to expire is used, and
+// a query refreshing it is started.
+TEST_F(RecursiveQueryTest, prefetch) {
+    setDNSService(true, true);
+    // Refresh answers on their second lookup, whatever their TTL left.
+    cache_.setPrefetchPolicy(100, 2);
+
+    // A delegation, so that we know where the refreshing query starts,
+    // and the answer to be refreshed.
+    RRsetPtr nsUpper(new RRset(Name("example.org"), RRClass::IN(),
+                               RRType::NS(), RRTTL(300)));
+    nsUpper->addRdata(rdata::generic::NS(Name("ns.example.org")));
+    RRsetPtr nsIp(new RRset(Name("ns.example.org"), RRClass::IN(),
+                            RRType::A(), RRTTL(300)));
+    nsIp->addRdata(rdata::in::A("192.0.2.1"));
+    ASSERT_TRUE(cache_.update(nsUpper));
+    ASSERT_TRUE(cache_.update(nsIp));
+
+    const Question q(Name("www.example.org"), RRClass::IN(), RRType::A());
+    Message cached(Message::RENDER);
+    cached.setOpcode(Opcode::QUERY());
+    cached.setRcode(Rcode::NOERROR());
+    cached.setHeaderFlag(Message::HEADERFLAG_QR);
+    cached.addQuestion(q);
+    RRsetPtr www(new RRset(q.getName(), RRClass::IN(), RRType::A(),
+                           RRTTL(300)));
+    www->addRdata(rdata::in::A("192.0.2.3"));
+    cached.addRRset(Message::SECTION_ANSWER, www);
+    ASSERT_TRUE(cache_.update(cached));
+
+    vector<pair<string, uint16_t> > roots;
+    roots.push_back(pair<string, uint16_t>("192.0.2.2", 53));
+    vector<pair<string, uint16_t> > upstream;
+    RecursiveQuery rq(*dns_service_, *nsas_, cache_, upstream, roots);
+    MockServer server(io_service_);
+
+    // The first lookup is answered from the cache, and nothing is sent.
+    MessagePtr answer(new Message(Message::RENDER));
+    EXPECT_EQ(static_cast<AbstractRunningQuery*>(NULL),
+              rq.resolve(q, answer, OutputBufferPtr(new OutputBuffer(0)),
+                         &server));
+    EXPECT_EQ(1, answer->getRRCount(Message::SECTION_ANSWER));
+    EXPECT_TRUE(resolver_->requests.empty());
+    EXPECT_EQ(0, cache_.getPrefetchCount());
+
+    // The second one is answered from the cache as well, but it also
+    // starts a query to refresh the answer.  It goes to the delegation
+    // point, as any other query for the name would.
+    answer.reset(new Message(Message::RENDER));
+    running_query_ = rq.resolve(q, answer,
+                                OutputBufferPtr(new OutputBuffer(0)),
+                                &server);
+    EXPECT_NE(static_cast<AbstractRunningQuery*>(NULL), running_query_);
+    EXPECT_EQ(1, answer->getRRCount(Message::SECTION_ANSWER));
+    EXPECT_EQ(1, cache_.getPrefetchCount());
+    EXPECT_NO_THROW(EXPECT_EQ(nsUpper->getName(),
+                              (*resolver_)[0]->getName()));
+
+    // Only one refresh is started.
+    answer.reset(new Message(Message::RENDER));
+    EXPECT_EQ(static_cast<AbstractRunningQuery*>(NULL),
+              rq.resolve(q, answer, OutputBufferPtr(new OutputBuffer(0)),
+                         &server));
+    EXPECT_EQ(1, answer->getRRCount(Message::SECTION_ANSWER));
+    EXPECT_EQ(1, cache_.getPrefetchCount());
+}
+
 // TODO: add tests that check whether the cache is updated on succesfull
 // responses, and not updated on failures.
 
@@ -0,0 +1,327 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <boost/bind.hpp>
+
+#include <asio.hpp>
+
+#include <util/buffer.h>
+
+#include <dns/question.h>
+#include <dns/message.h>
+#include <dns/messagerenderer.h>
+#include <dns/opcode.h>
+#include <dns/name.h>
+#include <dns/rcode.h>
+#include <dns/rrtype.h>
+#include <dns/rrset.h>
+#include <dns/rrttl.h>
+#include <dns/rdata.h>
+
+#include <asiodns/dns_service.h>
+#include <asiolink/io_service.h>
+#include <resolve/recursive_query.h>
+#include <resolve/resolver_interface.h>
+
+using namespace asio;
+using namespace asio::ip;
+using namespace isc::asiolink;
+using namespace isc::dns;
+using namespace isc::dns::rdata;
+using namespace isc::util;
+using namespace isc::resolve;
+using namespace std;
+
+/// RecursiveQuery Test - 4
+///
+/// This checks that questions asked while the same question is being
+/// resolved don't start queries of their own, but are answered with the
+/// result of the running one.
+///
+/// By using the "test_server_" element of RecursiveQuery, all queries are
+/// directed to the fake authoritative server in the RecursiveQueryTest4
+/// class, which answers every query it receives with an A record and counts
+/// the queries for each name.
+
+namespace {
+const char* const TEST_ADDRESS4 = "127.0.0.1"; ///< Server is on this address
+const uint16_t TEST_PORT4 = 5304;              ///< ... and this port
+const size_t BUFFER_SIZE = 1024;               ///< For all buffers
+
+const char* const DUMMY_ADDR4 = "192.0.2.1";   ///< address to return as A
+} // end anonymous namespace
+
+namespace isc {
+namespace asiodns {
+
+class MockResolver4 : public isc::resolve::ResolverInterface {
+public:
+    virtual void resolve(const QuestionPtr&,
+                         const ResolverInterface::CallbackPtr&)
+    {}
+
+    virtual ~MockResolver4() {}
+};
+
+/// \brief Test fixture for the RecursiveQuery Test
+class RecursiveQueryTest4 : public virtual ::testing::Test
+{
+public:
+    IOService       service_;                   ///< Service to run everything
+    DNSService      dns_service_;               ///< Resolver is part of "server"
+    boost::shared_ptr<MockResolver4> resolver_; ///< Mock resolver
+    isc::nsas::NameserverAddressStore* nsas_;   ///< Nameserver address store
+    isc::cache::ResolverCache cache_;           ///< Resolver cache
+
+    /// Number of queries received by the server, per name
+    map<string, int> queries_;
+    /// Number of callbacks still to be called
+    int pending_;
+
+    /// Data for UDP
+    udp::endpoint   udp_remote_;                ///< Endpoint for UDP receives
+    uint8_t         udp_receive_buffer_[BUFFER_SIZE];   ///< Receive buffer for UDP I/O
+    OutputBufferPtr udp_send_buffer_;           ///< Send buffer for UDP I/O
+    udp::socket     udp_socket_;                ///< Socket used by UDP server
+
+    /// \brief Constructor
+    RecursiveQueryTest4() :
+        service_(),
+        dns_service_(service_, NULL, NULL),
+        resolver_(new MockResolver4()),
+        nsas_(new isc::nsas::NameserverAddressStore(resolver_)),
+        pending_(0),
+        udp_remote_(),
+        udp_receive_buffer_(),
+        udp_send_buffer_(new OutputBuffer(BUFFER_SIZE)),
+        udp_socket_(service_.get_io_service(), udp::v4())
+    {
+    }
+
+    ~RecursiveQueryTest4() {
+        delete nsas_;
+        resolver_.reset();
+    }
+
+    /// \brief Start the server
+    ///
+    /// Binds the UDP socket and issues the first read.
+    void startServer() {
+        udp_socket_.set_option(socket_base::reuse_address(true));
+        udp_socket_.bind(udp::endpoint(address::from_string(TEST_ADDRESS4),
+                                       TEST_PORT4));
+        udpReceive();
+    }
+
+    /// \brief Run the service until all callbacks have been called
+    ///
+    /// The callbacks stop the service when the last of them is called.
+    /// The handlers of the cancelled timers of the queries are then run,
+    /// so that the queries delete themselves.
+    void run() {
+        service_.run();
+        service_.get_io_service().reset();
+        service_.get_io_service().poll();
+    }
+
+    /// \brief Issue a read on the UDP socket
+    void udpReceive() {
+        udp_socket_.async_receive_from(
+            asio::buffer(udp_receive_buffer_, sizeof(udp_receive_buffer_)),
+            udp_remote_,
+            boost::bind(&RecursiveQueryTest4::udpReceiveHandler,
+                        this, _1, _2));
+    }
+
+    /// \brief UDP Receive Handler
+    ///
+    /// Answers the query with an A record of the queried name and counts
+    /// it.
+    ///
+    /// \param ec ASIO error code, completion code of asynchronous I/O issued
+    ///        by the "server" to receive data.
+    /// \param length Amount of data received.
+    void udpReceiveHandler(asio::error_code ec = asio::error_code(),
+                           size_t length = 0)
+    {
+        ASSERT_EQ(0, ec.value());
+
+        InputBuffer buffer(udp_receive_buffer_, length);
+        Message query(Message::PARSE);
+        query.fromWire(buffer);
+        EXPECT_FALSE(query.getHeaderFlag(Message::HEADERFLAG_QR));
+        const Question question = **query.beginQuestion();
+        ++queries_[question.getName().toText()];
+
+        Message message(Message::RENDER);
+        message.setQid(query.getQid());
+        message.setHeaderFlag(Message::HEADERFLAG_QR);
+        message.setOpcode(Opcode::QUERY());
+        message.setHeaderFlag(Message::HEADERFLAG_AA);
+        message.setRcode(Rcode::NOERROR());
+        message.addQuestion(question);
+        RRsetPtr answer(new RRset(question.getName(), RRClass::IN(),
+                                  RRType::A(), RRTTL(300)));
+        answer->addRdata(createRdata(RRType::A(), RRClass::IN(),
+                                     DUMMY_ADDR4));
+        message.addRRset(Message::SECTION_ANSWER, answer);
+
+        udp_send_buffer_->clear();
+        MessageRenderer renderer;
+        renderer.setBuffer(udp_send_buffer_.get());
+        message.toWire(renderer);
+        renderer.setBuffer(NULL);
+
+        // The answer is sent synchronously, to keep it simple; the
+        // RecursiveQuery reads it when control gets back to run().
+        udp_socket_.send_to(asio::buffer(udp_send_buffer_->getData(),
+                                         udp_send_buffer_->getLength()),
+                            udp_remote_);
+        udpReceive();
+    }
+};
+
+/// \brief Resolver Callback Object
+///
+/// Checks the answer, and stops the service when it's the last one the
+/// test waits for.
+class ResolverCallback4 : public isc::resolve::ResolverInterface::Callback {
+public:
+    /// \brief Constructor
+    ResolverCallback4(RecursiveQueryTest4& test, const Name& name) :
+        test_(test), name_(name), success_(0), failure_(0)
+    {}
+
+    /// \brief Resolver Callback Success
+    ///
+    /// \param response Answer to the question.
+    virtual void success(const isc::dns::MessagePtr response) {
+        EXPECT_EQ(Rcode::NOERROR(), response->getRcode());
+        EXPECT_EQ(1, response->getRRCount(Message::SECTION_QUESTION));
+        ASSERT_EQ(1, response->getRRCount(Message::SECTION_ANSWER));
+        const ConstRRsetPtr rrset =
+            *response->beginSection(Message::SECTION_ANSWER);
+        EXPECT_EQ(name_, rrset->getName());
+        EXPECT_EQ(string(DUMMY_ADDR4),
+                  rrset->getRdataIterator()->getCurrent().toText());
+        ++success_;
+        done();
+    }
+
+    /// \brief Resolver Failure Completion
+    virtual void failure() {
+        ADD_FAILURE() << "Resolver reported completion failure";
+        ++failure_;
+        done();
+    }
+
+    int getSuccess() const {
+        return (success_);
+    }
+
+    int getFailure() const {
+        return (failure_);
+    }
+
+private:
+    void done() {
+        if (--test_.pending_ == 0) {
+            test_.service_.stop();
+        }
+    }
+
+    RecursiveQueryTest4& test_;
+    const Name name_;
+    int success_;
+    int failure_;
+};
+
+typedef boost::shared_ptr<ResolverCallback4> ResolverCallback4Ptr;
+
+TEST_F(RecursiveQueryTest4, coalesce) {
+    startServer();
+
+    std::vector<std::pair<std::string, uint16_t> > upstream;         // Empty
+    std::vector<std::pair<std::string, uint16_t> > upstream_root;    // Empty
+    RecursiveQuery query(dns_service_, *nsas_, cache_,
+                         upstream, upstream_root);
+    query.setTestServer(TEST_ADDRESS4, TEST_PORT4);
+    EXPECT_EQ(0, query.getCoalescedCount());
+
+    // Ask the same question several times before any answer arrives.  Only
+    // the first one starts a query.  The case of the name doesn't matter.
+    const QuestionPtr question(new Question(Name("coalesce.example.org"),
+                                            RRClass::IN(), RRType::A()));
+    const QuestionPtr question_upper(
+        new Question(Name("COALESCE.example.org"), RRClass::IN(),
+                     RRType::A()));
+    vector<ResolverCallback4Ptr> callbacks;
+    for (int i = 0; i < 5; ++i) {
+        callbacks.push_back(ResolverCallback4Ptr(
+            new ResolverCallback4(*this, question->getName())));
+        ++pending_;
+        AbstractRunningQuery* running_query =
+            query.resolve(i == 4 ? question_upper : question,
+                          callbacks.back());
+        if (i == 0) {
+            EXPECT_NE(static_cast<AbstractRunningQuery*>(NULL),
+                      running_query);
+        } else {
+            EXPECT_EQ(static_cast<AbstractRunningQuery*>(NULL),
+                      running_query);
+        }
+    }
+    EXPECT_EQ(4, query.getCoalescedCount());
+
+    // A different question is resolved by itself.
+    const QuestionPtr other(new Question(Name("other.example.org"),
+                                         RRClass::IN(), RRType::A()));
+    const ResolverCallback4Ptr other_callback(
+        new ResolverCallback4(*this, other->getName()));
+    ++pending_;
+    EXPECT_NE(static_cast<AbstractRunningQuery*>(NULL),
+              query.resolve(other, other_callback));
+    EXPECT_EQ(4, query.getCoalescedCount());
+
+    run();
+
+    // Each question was sent upstream once, and everybody got the answer.
+    EXPECT_EQ(0, pending_);
+    EXPECT_EQ(1, queries_["coalesce.example.org."]);
+    EXPECT_EQ(1, queries_["other.example.org."]);
+    for (size_t i = 0; i < callbacks.size(); ++i) {
+        EXPECT_EQ(1, callbacks[i]->getSuccess());
+        EXPECT_EQ(0, callbacks[i]->getFailure());
+    }
+    EXPECT_EQ(1, other_callback->getSuccess());
+
+    // The query has finished, so the question is answered from the cache
+    // now, and isn't counted as coalesced.
+    const ResolverCallback4Ptr cached_callback(
+        new ResolverCallback4(*this, question->getName()));
+    ++pending_;
+    EXPECT_EQ(static_cast<AbstractRunningQuery*>(NULL),
+              query.resolve(question, cached_callback));
+    EXPECT_EQ(1, cached_callback->getSuccess());
+    EXPECT_EQ(4, query.getCoalescedCount());
+    EXPECT_EQ(1, queries_["coalesce.example.org."]);
+}
+
+} // namespace asiodns
+} // namespace isc
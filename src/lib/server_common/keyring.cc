@@ -25,6 +25,8 @@ typedef boost::shared_ptr<TSIGKeyRing> KeyringPtr;
 
 KeyringPtr keyring;
 
+isc::util::thread::Mutex keyring_mutex;
+
 namespace {
 
 void
@@ -41,7 +43,9 @@ updateKeyring(const std::string&, ConstElementPtr data,
     for (size_t i(0); list && i < list->size(); ++ i) {
         load->add(TSIGKey(list->get(i)->stringValue()));
     }
+    isc::util::thread::Mutex::Locker locker(keyring_mutex);
     keyring.swap(load);
+    // The old keyring (now in load) is released after unlocking.
 }
 
 }
@@ -63,7 +67,10 @@ deinitKeyring(config::ModuleCCSession& session) {
         return;
     }
     LOG_DEBUG(logger, DBG_TRACE_BASIC, SRVCOMM_KEYS_DEINIT);
-    keyring.reset();
+    {
+        isc::util::thread::Mutex::Locker locker(keyring_mutex);
+        keyring.reset();
+    }
     session.removeRemoteConfig("tsig_keys");
 }
 
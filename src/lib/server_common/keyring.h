@@ -18,6 +18,7 @@
 #include <boost/shared_ptr.hpp>
 #include <dns/tsigkey.h>
 #include <config/ccsession.h>
+#include <util/threads/sync.h>
 
 /**
  * \file keyring.h
@@ -35,7 +36,8 @@
  * If you want to keep a key (or session) for longer time or your application
  * is multithreaded, you might want to have a copy of the shared pointer to
  * hold a reference. Otherwise an update might replace the keyring and delete
- * the keys in the old one.
+ * the keys in the old one. Threads other than the one receiving the
+ * configuration updates must make that copy while holding keyring_mutex.
  *
  * Also note that, while the interface doesn't prevent application from
  * modifying the keyring, it is not a good idea to do so. As mentioned above,
@@ -57,6 +59,14 @@ namespace server_common {
  */
 extern boost::shared_ptr<dns::TSIGKeyRing> keyring;
 
+/**
+ * \brief Lock for replacing the key ring
+ *
+ * The key ring is replaced (and reset by deinitKeyring) while holding this
+ * lock. Other threads must hold it while copying the keyring shared pointer.
+ */
+extern util::thread::Mutex keyring_mutex;
+
 /**
  * \brief Load the key ring for the first time
  *
@@ -65,6 +65,22 @@ public:
         return;
     }
 
+    /// \brief Set the value of a counter item specified with \a type.
+    ///
+    /// This is intended for items whose value is maintained elsewhere
+    /// and only copied into the counter for reporting.
+    ///
+    /// \param type %Counter item to set
+    /// \param value The new value of the item
+    ///
+    /// \throw isc::OutOfRange \a type is invalid
+    void set(const Counter::Type& type, const Counter::Value& value) {
+        if (type >= counters_.size()) {
+            isc_throw(isc::OutOfRange, "Counter type is out of range");
+        }
+        counters_.at(type) = value;
+    }
+
     /// \brief Get the value of a counter item specified with \a type.
     ///
     /// \param type %Counter item to get the value of
@@ -80,6 +80,17 @@ TEST_F(CounterTest, incrementCounterItem) {
     EXPECT_EQ(counter.get(ITEM1), 4294967308LL); // 4294967306 + 2
 }
 
+TEST_F(CounterTest, setCounterItem) {
+    counter.inc(ITEM1);
+    counter.set(ITEM1, 10);
+    counter.set(ITEM2, 4294967306LL);
+    EXPECT_EQ(counter.get(ITEM1), 10);
+    EXPECT_EQ(counter.get(ITEM2), 4294967306LL);
+    EXPECT_EQ(counter.get(ITEM3), 0);
+    counter.inc(ITEM1);
+    EXPECT_EQ(counter.get(ITEM1), 11);
+}
+
 TEST_F(CounterTest, invalidCounterItem) {
     // Incrementing out-of-bound counter will cause an isc::OutOfRange
     // exception
@@ -87,4 +98,6 @@ TEST_F(CounterTest, invalidCounterItem) {
     // Trying to get out-of-bound counter will cause an isc::OutOfRange
     // exception
     EXPECT_THROW(counter.get(NUMBER_OF_ITEMS), isc::OutOfRange);
+    // Same for setting a value
+    EXPECT_THROW(counter.set(NUMBER_OF_ITEMS, 1), isc::OutOfRange);
 }
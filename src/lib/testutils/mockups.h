@@ -115,7 +115,7 @@ private:
 // to addServerXXX methods so the test code subsequently checks the parameters.
 class MockDNSService : public isc::asiodns::DNSServiceBase {
 public:
-    MockDNSService() : tcp_recv_timeout_(0) {}
+    MockDNSService() : tcp_recv_timeout_(0), udp_batch_size_(1) {}
 
     // A helper tuple of parameters passed to addServerUDPFromFD().
     struct UDPFdParams {
@@ -155,10 +155,19 @@ public:
         return tcp_recv_timeout_;
     }
 
+    virtual void setUDPBatchSize(size_t batch_size) {
+        udp_batch_size_ = batch_size;
+    }
+
+    size_t getUDPBatchSize() {
+        return udp_batch_size_;
+    }
+
 private:
     std::vector<std::pair<int, int> > tcp_fd_params_;
     std::vector<UDPFdParams> udp_fd_params_;
     size_t tcp_recv_timeout_;
+    size_t udp_batch_size_;
 };
 
 // A nonoperative DNSServer object to be used in calls to processMessage().
@@ -12,268 +12,206 @@
 // OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 // PERFORMANCE OF THIS SOFTWARE.
 
-#include <util/encode/base32hex_from_binary.h>
-#include <util/encode/binary_from_base32hex.h>
-#include <util/encode/base16_from_binary.h>
-#include <util/encode/binary_from_base16.h>
 #include <util/encode/base32hex.h>
 #include <util/encode/base64.h>
+#include <util/encode/hex.h>
 
 #include <exceptions/exceptions.h>
 
-#include <boost/archive/iterators/base64_from_binary.hpp>
-#include <boost/archive/iterators/binary_from_base64.hpp>
-#include <boost/archive/iterators/transform_width.hpp>
-#include <boost/math/common_factor.hpp>
-
 #include <stdint.h>
-#include <stdexcept>
 #include <cassert>
-#include <iterator>
+#include <cctype>
 #include <string>
 #include <vector>
 
+// The base64 encoder and decoder convert 12 bytes to 16 characters and vice
+// versa at once with SSSE3 instructions.  SSSE3 isn't part of the baseline
+// x86_64 instruction set, so these are compiled for that target only and are
+// used if the CPU supports it, which is checked at runtime.  That requires
+// the target attribute and __builtin_cpu_supports() of GCC 4.9 or a recent
+// clang.
+#if defined(__x86_64__)
+#if defined(__clang__)
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_cpu_supports)
+#define BASE_N_USE_SSSE3 1
+#endif
+#endif
+#elif defined(__GNUC__) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define BASE_N_USE_SSSE3 1
+#endif
+#endif
+
+#ifdef BASE_N_USE_SSSE3
+#include <immintrin.h>
+#endif
+
 using namespace std;
-using namespace boost::archive::iterators;
 
 namespace isc {
 namespace util {
 namespace encode {
 
-// Some versions of clang cannot handle exceptions in unnamed namespaces
-// so this exception is defined in an 'internal' namespace
-namespace clang_unnamed_namespace_workaround {
-// An internally caught exception to unify a few possible cases of the same
-// error.
-class IncompleteBaseInput : public std::exception {
-};
-} // end namespace internal
-
 // In the following anonymous namespace, we provide a generic framework
-// to encode/decode baseN format.  We use the following tools:
-// - boost base64_from_binary/binary_from_base64: provide mapping table for
-//   base64.
-//   These classes take another iterator (Base) as a template argument, and
-//   their dereference operator (operator*()) first retrieves an input value
-//   from Base via Base::operator* and converts the value using their mapping
-//   table.  The converted value is returned as their own operator*.
-// - base{32hex,16}_from_binary/binary_from_base{32hex,16}: provide mapping
-//   table for base32hex and base16.  A straightforward variation of their
-//   base64 counterparts.
-// - EncodeNormalizer/DecodeNormalizer: supplemental filter handling baseN
-//   padding characters (=)
-// - boost transform_width: an iterator framework for handling data stream
-//   per bit-group.  It takes another iterator (Base) and output/input bit
-//   numbers (BitsOut/BitsIn) template arguments.  A transform_width object
-//   internally maintains a bit stream, which can be retrieved per BitsOut
-//   bits via its dereference operator (operator*()).  It builds the stream
-//   by internally iterating over the Base object via Base::operator++ and
-//   Base::operator*, using the least BitsIn bits of the result of
-//   Base::operator*.  In our usage BitsIn for encoding and BitsOut for
-//   decoding are always 8 (# of bits for one byte).
-//
-// Its dereference operator
-//   retrieves BitsIn bits from the result of "*Base" (if necessary it
-//   internally calls ++Base) 
+// to encode/decode baseN format.  Input is converted a group of bytes (or
+// encoded characters) at a time, a group being the smallest number of
+// bytes that can be represented by whole encoded characters: 3 bytes in
+// 4 characters for base64, 5 bytes in 8 characters for base32hex and 1 byte
+// in 2 characters for base16.  Encoding maps each chunk of bits to its
+// character with a string of the encoding characters.  Decoding maps each
+// character to its bits with a table of all 256 byte values, which also
+// tells spaces, the padding character and invalid characters.  Partial
+// groups at the end of the data (for encoding) and groups broken by spaces
+// (for decoding) are handled a chunk at a time.
 //
-// A conceptual description of how the encoding and decoding work is as
-// follows:
-// Encoding:
-//   input binary data => Normalizer (append sufficient number of 0 bits)
-//                     => transform_width (extract bit groups from the original
-//                                         stream)
-//                     => baseXX_from_binary (convert each bit group to an
-//                                            encoded byte using the mapping)
-// Decoding:
-//   input baseXX text => Normalizer (convert '='s to the encoded characters
-//                                    corresponding to 0, e.g. 'A's in base64)
-//                     => binary_from_baseXX (convert each encoded byte into
-//                                            the original group bit)
-//                     => transform_width (build original byte stream by
-//                                         concatenating the decoded bit
-//                                         stream)
-//
-// Below, we define a set of templated classes to handle different parameters
-// for different encoding algorithms.
+// Decoding is strict: the text must be a valid, canonical encoding of the
+// data (see RFC4648), with padding characters as necessary.  Space
+// characters are ignored, except between the encoded characters and
+// padding.
 namespace {
 // Common constants used for all baseN encoding.
 const char BASE_PADDING_CHAR = '=';
-const uint8_t BINARY_ZERO_CODE = 0;
-  
-// EncodeNormalizer is an input iterator intended to be used as a filter
-// between the binary stream and baseXX_from_binary translator (via
-// transform_width).  An EncodeNormalizer object is configured with two
-// iterators (base and base_end), specifying the head and end of the input
-// stream.  It internally iterators over the original stream, and return
-// each byte of the stream intact via its dereference operator until it
-// reaches the end of the stream.  After that the EncodeNormalizer object
-// will return 0 no matter how many times it is subsequently incremented.
-// This is necessary because the input binary stream may not contain
-// sufficient bits for a full encoded text while baseXX_from_binary expects
-// a sufficient length of input.
-// Note: this class is intended to be used within this implementation file,
-// and assumes "base < base_end" on construction without validating the
-// arguments.  The behavior is undefined if this assumption doesn't hold.
-class EncodeNormalizer : public iterator<input_iterator_tag, uint8_t> {
-public:
-    EncodeNormalizer(const vector<uint8_t>::const_iterator& base,
-                     const vector<uint8_t>::const_iterator& base_end) :
-        base_(base), base_end_(base_end), in_pad_(false)
-    {}
-    EncodeNormalizer& operator++() { // prefix version
-        increment();
-        return (*this);
-    }
-    EncodeNormalizer operator++(int) { // postfix version
-        const EncodeNormalizer copy = *this;
-        increment();
-        return (copy);
-    }
-    const uint8_t& operator*() const {
-        if (in_pad_) {
-            return (BINARY_ZERO_CODE);
-        } else {
-            return (*base_);
-        }
-    }
-    bool operator==(const EncodeNormalizer& other) const {
-        return (base_ == other.base_);
+
+// Values of the decoding tables for characters that don't encode data.
+const uint8_t DECODE_INVALID = 0xff;
+const uint8_t DECODE_SPACE = 0xfe;
+const uint8_t DECODE_PADDING = 0xfd;
+
+#ifdef BASE_N_USE_SSSE3
+bool
+hasSSSE3() {
+    static const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+    return (has_ssse3);
+}
+
+// Encode as many 12-byte blocks of data as possible into base64, leaving
+// at least 4 bytes, as 16 bytes are loaded for each block.  Returns the
+// number of bytes encoded.
+//
+// The bytes of each 3-byte group are shuffled into a 32-bit word so that
+// two multiplications can move the four 6-bit chunks to the four bytes of
+// the word.  The chunks are then mapped to characters by adding an offset
+// depending on their range (A-Z, a-z, 0-9, +, /), with a lookup of the
+// offset.
+__attribute__((target("ssse3"))) size_t
+encodeBase64SSSE3(const uint8_t* data, size_t len, char* out) {
+    const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7,
+                                         4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '+' - 62,
+                                          '/' - 63, 'A', 0, 0);
+    size_t done = 0;
+    for (; len - done >= 16; done += 12, out += 16) {
+        const __m128i in = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + done)),
+            shuffle);
+        const __m128i ac = _mm_mulhi_epu16(
+            _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+            _mm_set1_epi32(0x04000040));
+        const __m128i bd = _mm_mullo_epi16(
+            _mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+            _mm_set1_epi32(0x01000010));
+        const __m128i chunks = _mm_or_si128(ac, bd);
+
+        // 0-25 => 13, 26-51 => 0, 52-61 => 1-10, 62 => 11, 63 => 12
+        __m128i range = _mm_subs_epu8(chunks, _mm_set1_epi8(51));
+        range = _mm_or_si128(range,
+                             _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26),
+                                                          chunks),
+                                           _mm_set1_epi8(13)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                         _mm_add_epi8(chunks,
+                                      _mm_shuffle_epi8(offsets, range)));
     }
-private:
-    void increment() {
-        if (!in_pad_) {
-            ++base_;
-        }
-        if (base_ == base_end_) {
-            in_pad_ = true;
+    return (done);
+}
+
+inline __m128i
+inRange(__m128i chars, char low, char high) {
+    return (_mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(low - 1)),
+                          _mm_cmplt_epi8(chars, _mm_set1_epi8(high + 1))));
+}
+
+// Decode as many 16-character blocks of base64 text as possible, until
+// the end of the text or a block containing anything other than the
+// encoding characters.  Returns the number of characters decoded; 16 bytes
+// are stored for each 12 bytes of data, so the output buffer must have
+// 4 extra bytes.
+//
+// The characters are validated and converted to their 6-bit values by
+// comparing them with each range of the encoding characters, and the
+// values are packed with two multiply-adds.
+__attribute__((target("ssse3"))) size_t
+decodeBase64SSSE3(const char* text, size_t len, uint8_t* out) {
+    const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                          14, 13, 12, -1, -1, -1, -1);
+    size_t done = 0;
+    for (; len - done >= 16; done += 16, out += 12) {
+        const __m128i chars =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + done));
+        const __m128i upper = inRange(chars, 'A', 'Z');
+        const __m128i lower = inRange(chars, 'a', 'z');
+        const __m128i digit = inRange(chars, '0', '9');
+        const __m128i plus = _mm_cmpeq_epi8(chars, _mm_set1_epi8('+'));
+        const __m128i slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+        const __m128i valid = _mm_or_si128(
+            _mm_or_si128(_mm_or_si128(upper, lower), digit),
+            _mm_or_si128(plus, slash));
+        if (_mm_movemask_epi8(valid) != 0xffff) {
+            break;
         }
+
+        __m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+        shift = _mm_or_si128(shift, _mm_and_si128(lower,
+                                                  _mm_set1_epi8(26 - 'a')));
+        shift = _mm_or_si128(shift, _mm_and_si128(digit,
+                                                  _mm_set1_epi8(52 - '0')));
+        shift = _mm_or_si128(shift, _mm_and_si128(plus,
+                                                  _mm_set1_epi8(62 - '+')));
+        shift = _mm_or_si128(shift, _mm_and_si128(slash,
+                                                  _mm_set1_epi8(63 - '/')));
+        const __m128i values = _mm_add_epi8(chars, shift);
+
+        // Each pair of 6-bit values to 12 bits, and each pair of those to
+        // 24 bits, which are the 3 bytes (in reverse order) of 32-bit words.
+        const __m128i pairs = _mm_maddubs_epi16(values,
+                                                _mm_set1_epi32(0x01400140));
+        const __m128i words = _mm_madd_epi16(pairs,
+                                             _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                         _mm_shuffle_epi8(words, shuffle));
     }
-    vector<uint8_t>::const_iterator base_;
-    const vector<uint8_t>::const_iterator base_end_;
-    bool in_pad_;
-};
+    return (done);
+}
+#endif
 
-// DecodeNormalizer is an input iterator intended to be used as a filter
-// between the encoded baseX stream and binary_from_baseXX.
-// A DecodeNormalizer object is configured with three string iterators
-// (base, base_beginpad, and base_end), specifying the head of the string,
-// the beginning position of baseX padding (when there's padding), and
-// end of the string, respectively.  It internally iterators over the original
-// stream, and return each character of the encoded string via its dereference
-// operator until it reaches base_beginpad.  After that the DecodeNormalizer
-// will return the encoding character corresponding to the all-0 value
-// (which is specified on construction via base_zero_code.  see also
-// BaseZeroCode below).  This translation is necessary because
-// binary_from_baseXX doesn't accept the padding character (i.e. '=').
-// Note: this class is intended to be used within this implementation file,
-// and for simplicity assumes "base < base_beginpad <= base_end" on
-// construction without validating the arguments.  The behavior is undefined
-// if this assumption doesn't hold.
-class DecodeNormalizer : public iterator<input_iterator_tag, char> {
+template <int BitsPerChunk>
+class BaseNTransformer {
 public:
-    DecodeNormalizer(const char base_zero_code,
-                     const string::const_iterator& base,
-                     const string::const_iterator& base_beginpad,
-                     const string::const_iterator& base_end,
-                     size_t* char_count) :
-        base_zero_code_(base_zero_code),
-        base_(base), base_beginpad_(base_beginpad), base_end_(base_end),
-        in_pad_(false), char_count_(char_count)
-    {
-        // Skip beginning spaces, if any.  We need do it here because
-        // otherwise the first call to operator*() would be confused.
-        skipSpaces();
-    }
-    DecodeNormalizer& operator++() {
-        if (base_ < base_end_) {
-            ++*char_count_;
-        }
-        ++base_;
-        skipSpaces();
-        if (base_ == base_beginpad_) {
-            in_pad_ = true;
-        }
-        return (*this);
-    }
-    void skipSpaces() {
-        // If (char is signed and) *base_ < 0, on Windows platform with Visual
-        // Studio compiler it may trigger _ASSERTE((unsigned)(c + 1) <= 256);
-        // so make sure that the parameter of isspace() is larger than 0.
-        // We don't simply cast it to unsigned char to avoid confusing the
-        // isspace() implementation with a possible extension for values
-        // larger than 127.  Also note the check is not ">= 0"; for systems
-        // where char is unsigned that would always be true and would possibly
-        // trigger a compiler warning that could stop the build.
-        while (base_ != base_end_ && *base_ > 0 && isspace(*base_)) {
-            ++base_;
-        }
-    }
-    const char& operator*() const {
-        if (base_ == base_end_) {
-            // binary_from_baseX can call this operator when it needs more bits
-            // even if the internal iterator (base_) has reached its end
-            // (if that happens it means the input is an incomplete baseX
-            // string and should be rejected).  So this is the only point
-            // we can catch and reject this type of invalid input.
-            //
-            // More recent versions of Boost fixed the behavior and the
-            // out-of-range call to this operator doesn't happen.  It's good,
-            // but in that case we need to catch incomplete baseX input in
-            // a different way.  It's done via char_count_ and after the
-            // completion of decoding.
-
-            // throw this now and convert it
-            throw clang_unnamed_namespace_workaround::IncompleteBaseInput();
-        }
-        if (*base_ == BASE_PADDING_CHAR) {
-            // Padding can only happen at the end of the input string.  We can
-            // detect any violation of this by checking in_pad_, which is
-            // true iff we are on or after the first valid sequence of padding
-            // characters.
-            if (in_pad_) {
-                return (base_zero_code_);
-            } else {
-                isc_throw(BadValue, "Intermediate padding found");
-            }
-        } else {
-            return (*base_);
-        }
-    }
-    bool operator==(const DecodeNormalizer& other) const {
-        return (base_ == other.base_);
-    }
-private:
-    const char base_zero_code_;
-    string::const_iterator base_;
-    const string::const_iterator base_beginpad_;
-    const string::const_iterator base_end_;
-    bool in_pad_;
-    // Store number of non-space decoded characters (incl. pad) here.  Define
-    // it as a pointer so we can carry it over to any copied objects.
-    size_t* char_count_;
-};
+    // \param algorithm The name of the encoding, for error messages.
+    // \param encoding_chars The encoding characters in the order of their
+    // values.
+    // \param ignore_case Whether lower case letters are decoded the same
+    // as the upper case encoding characters.
+    BaseNTransformer(const char* algorithm, const char* encoding_chars,
+                     bool ignore_case);
 
-// BitsPerChunk: number of bits to be converted using the baseN mapping table.
-//               e.g. 6 for base64.
-// BaseZeroCode: the byte character that represents a value of 0 in
-//               the corresponding encoding.  e.g. 'A' for base64.
-// Encoder: baseX_from_binary<transform_width<EncodeNormalizer,
-//                                            BitsPerChunk, 8> >
-// Decoder: transform_width<binary_from_baseX<DecodeNormalizer>,
-//                          8, BitsPerChunk>
-template <int BitsPerChunk, char BaseZeroCode,
-          typename Encoder, typename Decoder>
-struct BaseNTransformer {
-    static string encode(const vector<uint8_t>& binary);
-    static void decode(const char* algorithm,
-                       const string& base64, vector<uint8_t>& result);
+    string encode(const vector<uint8_t>& binary) const;
+    void decode(const string& input, vector<uint8_t>& result) const;
 
+private:
     // BITS_PER_GROUP is the number of bits for the smallest possible (non
     // empty) bit string that can be converted to a valid baseN encoded text
     // without padding.  It's the least common multiple of 8 and BitsPerChunk,
     // e.g. 24 for base64.
     static const int BITS_PER_GROUP =
-        boost::math::static_lcm<BitsPerChunk, 8>::value;
+        BitsPerChunk == 6 ? 24 : (BitsPerChunk == 5 ? 40 : 8);
+    static const int BYTES_PER_GROUP = BITS_PER_GROUP / 8;
+    static const int CHARS_PER_GROUP = BITS_PER_GROUP / BitsPerChunk;
+    static const uint8_t CHUNK_MASK = (1 << BitsPerChunk) - 1;
 
     // MAX_PADDING_CHARS is the maximum number of padding characters
     // that can appear in a valid baseN encoded text.
@@ -285,16 +223,44 @@ struct BaseNTransformer {
     // byte, and each group consists of 4 encoded characters, so
     // MAX_PADDING_CHARS is 4 - 2 = 2.
     static const int MAX_PADDING_CHARS =
-        BITS_PER_GROUP / BitsPerChunk -
+        CHARS_PER_GROUP -
         (8 / BitsPerChunk + ((8 % BitsPerChunk) == 0 ? 0 : 1));
-}; 
 
-template <int BitsPerChunk, char BaseZeroCode,
-          typename Encoder, typename Decoder>
-string
-BaseNTransformer<BitsPerChunk, BaseZeroCode, Encoder, Decoder>::encode(
-    const vector<uint8_t>& binary)
+    static void storeGroup(uint64_t group, uint8_t* out) {
+        for (int i = 0; i < BYTES_PER_GROUP; ++i) {
+            out[i] = group >> ((BYTES_PER_GROUP - 1 - i) * 8);
+        }
+    }
+
+    const char* const algorithm_;
+    const char* const encoding_chars_;
+    uint8_t decode_table_[256];
+};
+
+template <int BitsPerChunk>
+BaseNTransformer<BitsPerChunk>::BaseNTransformer(const char* algorithm,
+                                                 const char* encoding_chars,
+                                                 bool ignore_case) :
+    algorithm_(algorithm), encoding_chars_(encoding_chars)
 {
+    for (int ch = 0; ch < 256; ++ch) {
+        // See the note about isspace() in decode().
+        decode_table_[ch] = (ch < 0x80 && isspace(ch)) ?
+            DECODE_SPACE : DECODE_INVALID;
+    }
+    decode_table_[static_cast<uint8_t>(BASE_PADDING_CHAR)] = DECODE_PADDING;
+    for (int value = 0; value <= CHUNK_MASK; ++value) {
+        const uint8_t ch = encoding_chars[value];
+        decode_table_[ch] = value;
+        if (ignore_case) {
+            decode_table_[tolower(ch)] = value;
+        }
+    }
+}
+
+template <int BitsPerChunk>
+string
+BaseNTransformer<BitsPerChunk>::encode(const vector<uint8_t>& binary) const {
     // calculate the resulting length.
     size_t bits = binary.size() * 8;
     if (bits % BITS_PER_GROUP > 0) {
@@ -302,41 +268,82 @@ BaseNTransformer<BitsPerChunk, BaseZeroCode, Encoder, Decoder>::encode(
     }
     const size_t len = bits / BitsPerChunk;
 
-    string result;
-    result.reserve(len);
-    result.assign(Encoder(EncodeNormalizer(binary.begin(), binary.end())),
-                  Encoder(EncodeNormalizer(binary.end(), binary.end())));
-    assert(len >= result.length());
-    result.append(len - result.length(), BASE_PADDING_CHAR);
+    string result(len, BASE_PADDING_CHAR);
+    if (binary.empty()) {
+        return (result);
+    }
+    const uint8_t* data = &binary[0];
+    const uint8_t* const data_end = data + binary.size();
+    char* out = &result[0];
+
+#ifdef BASE_N_USE_SSSE3
+    if (BitsPerChunk == 6 && hasSSSE3()) {
+        const size_t done = encodeBase64SSSE3(data, binary.size(), out);
+        data += done;
+        out += done / 3 * 4;
+    }
+#endif
+
+    // Whole groups
+    for (; data_end - data >= BYTES_PER_GROUP;
+         data += BYTES_PER_GROUP, out += CHARS_PER_GROUP) {
+        uint64_t group = 0;
+        for (int i = 0; i < BYTES_PER_GROUP; ++i) {
+            group = (group << 8) | data[i];
+        }
+        for (int i = 0; i < CHARS_PER_GROUP; ++i) {
+            out[i] = encoding_chars_[(group >> ((CHARS_PER_GROUP - 1 - i) *
+                                                BitsPerChunk)) & CHUNK_MASK];
+        }
+    }
+
+    // The rest of the data, padded with 0 bits to make whole chunks.  The
+    // rest of the group is padding characters, which are already there.
+    uint32_t bitbuf = 0;
+    int nbits = 0;
+    for (; data != data_end; ++data) {
+        bitbuf = (bitbuf << 8) | *data;
+        nbits += 8;
+        while (nbits >= BitsPerChunk) {
+            nbits -= BitsPerChunk;
+            *out++ = encoding_chars_[(bitbuf >> nbits) & CHUNK_MASK];
+        }
+    }
+    if (nbits > 0) {
+        *out++ = encoding_chars_[(bitbuf << (BitsPerChunk - nbits)) &
+                                 CHUNK_MASK];
+    }
+    assert(out <= &result[0] + len);
     return (result);
 }
 
-template <int BitsPerChunk, char BaseZeroCode,
-          typename Encoder, typename Decoder>
+template <int BitsPerChunk>
 void
-BaseNTransformer<BitsPerChunk, BaseZeroCode, Encoder, Decoder>::decode(
-    const char* const algorithm,
-    const string& input,
-    vector<uint8_t>& result)
+BaseNTransformer<BitsPerChunk>::decode(const string& input,
+                                       vector<uint8_t>& result) const
 {
     // enumerate the number of trailing padding characters (=), ignoring
-    // white spaces.  since baseN_from_binary doesn't accept padding,
-    // we handle it explicitly.
+    // white spaces.
+    // Note: isspace() is only used for characters in the ASCII range (see
+    // the constructor).  If (char is signed and) the character is negative,
+    // on Windows platform with Visual Studio compiler it may trigger
+    // _ASSERTE((unsigned)(c + 1) <= 256), and we don't want to confuse the
+    // isspace() implementation with a possible extension for values larger
+    // than 127 either.
     size_t padchars = 0;
-    string::const_reverse_iterator srit = input.rbegin();
-    string::const_reverse_iterator srit_end = input.rend();
-    while (srit != srit_end) {
-        char ch = *srit;
-        if (ch == BASE_PADDING_CHAR) {
+    size_t pad_begin = input.size();
+    while (pad_begin > 0) {
+        const uint8_t code =
+            decode_table_[static_cast<uint8_t>(input[pad_begin - 1])];
+        if (code == DECODE_PADDING) {
             if (++padchars > MAX_PADDING_CHARS) {
-                isc_throw(BadValue, "Too many " << algorithm
+                isc_throw(BadValue, "Too many " << algorithm_
                           << " padding characters: " << input);
             }
-        } else if (!(ch > 0 && isspace(ch))) {
-            // see the note for DecodeNormalizer::skipSpaces() above for ch > 0
+        } else if (code != DECODE_SPACE) {
             break;
         }
-        ++srit;
+        --pad_begin;
     }
     // then calculate the number of padding bits corresponding to the padding
     // characters.  In general, the padding bits consist of all-zero
@@ -347,7 +354,7 @@ BaseNTransformer<BitsPerChunk, BaseZeroCode, Encoder, Decoder>::decode(
     // 0000...0 0......0 000...
     // 0      7 8     15 16.... (bits)
     // The number of bits for the '==...' part is padchars * BitsPerChunk.
-    // So the total number of padding bits is the smallest multiple of 8 
+    // So the total number of padding bits is the smallest multiple of 8
     // that is >= padchars * BitsPerChunk.
     // (Below, note the common idiom of the bitwise AND with ~7.  It clears the
     // lowest three bits, so has the effect of rounding the result down to the
@@ -365,44 +372,114 @@ BaseNTransformer<BitsPerChunk, BaseZeroCode, Encoder, Decoder>::decode(
     // 0      7 (bits)
     // The following check rejects this type of invalid encoding.
     if (padbits > BitsPerChunk * (padchars + 1)) {
-        isc_throw(BadValue, "Invalid " << algorithm << "padding: " << input);
+        isc_throw(BadValue, "Invalid " << algorithm_ << "padding: " << input);
     }
 
     // convert the number of bits in bytes for convenience.
     const size_t padbytes = padbits / 8;
 
-    try {
-        size_t char_count = 0;
-        result.assign(Decoder(DecodeNormalizer(BaseZeroCode, input.begin(),
-                                               srit.base(), input.end(),
-                                               &char_count)),
-                      Decoder(DecodeNormalizer(BaseZeroCode, input.end(),
-                                               input.end(), input.end(),
-                                               NULL)));
-
-        // Number of bits of the conversion result including padding must be
-        // a multiple of 8; otherwise the decoder reaches the end of input
-        // with some incomplete bits of data, which is invalid.
-        if (((char_count * BitsPerChunk) % 8) != 0) {
-            // catch this immediately below
-            throw clang_unnamed_namespace_workaround::IncompleteBaseInput();
+    // Make room for the largest possible result (plus what the vector
+    // versions may write beyond it), and shrink it at the end.
+    result.resize((pad_begin + padchars) / CHARS_PER_GROUP * BYTES_PER_GROUP +
+                  BYTES_PER_GROUP + 16);
+    uint8_t* out = &result[0];
+    const char* const text = input.data();
+    size_t pos = 0;
+    size_t char_count = 0;      // number of non-space characters (incl. pad)
+    uint64_t group = 0;
+    int group_chars = 0;
+
+    while (pos < pad_begin) {
+        if (group_chars == 0) {
+#ifdef BASE_N_USE_SSSE3
+            if (BitsPerChunk == 6 && hasSSSE3()) {
+                const size_t done = decodeBase64SSSE3(text + pos,
+                                                      pad_begin - pos, out);
+                pos += done;
+                char_count += done;
+                out += done / 4 * 3;
+            }
+#endif
+            // A whole group without spaces can be converted at once.
+            if (pad_begin - pos >= CHARS_PER_GROUP) {
+                uint64_t whole_group = 0;
+                int i = 0;
+                for (; i < CHARS_PER_GROUP; ++i) {
+                    const uint8_t code =
+                        decode_table_[static_cast<uint8_t>(text[pos + i])];
+                    if (code > CHUNK_MASK) {
+                        break;
+                    }
+                    whole_group = (whole_group << BitsPerChunk) | code;
+                }
+                if (i == CHARS_PER_GROUP) {
+                    storeGroup(whole_group, out);
+                    out += BYTES_PER_GROUP;
+                    pos += CHARS_PER_GROUP;
+                    char_count += CHARS_PER_GROUP;
+                    continue;
+                }
+            } else if (pos == pad_begin) {
+                break;
+            }
+        }
+
+        const uint8_t code = decode_table_[static_cast<uint8_t>(text[pos])];
+        ++pos;
+        if (code == DECODE_SPACE) {
+            continue;
+        }
+        if (code == DECODE_PADDING) {
+            // Padding can only happen at the end of the input string.
+            isc_throw(BadValue, "Intermediate padding found");
+        }
+        if (code == DECODE_INVALID) {
+            isc_throw(BadValue, "attempt to decode a value not in "
+                      << algorithm_ << " char set");
+        }
+        group = (group << BitsPerChunk) | code;
+        ++char_count;
+        if (++group_chars == CHARS_PER_GROUP) {
+            storeGroup(group, out);
+            out += BYTES_PER_GROUP;
+            group = 0;
+            group_chars = 0;
         }
-    } catch (const clang_unnamed_namespace_workaround::IncompleteBaseInput&) {
-        // we unify error handling for incomplete input here.
-        isc_throw(BadValue, "Incomplete input for " << algorithm
+    }
+
+    if (padchars > 0) {
+        // The padding must immediately follow the encoded characters.
+        if (char_count == 0 || text[pad_begin] != BASE_PADDING_CHAR) {
+            isc_throw(BadValue, "Intermediate padding found");
+        }
+        // padding characters represent all-0 chunks.
+        char_count += padchars;
+        group <<= BitsPerChunk * padchars;
+        group_chars += padchars;
+        if (group_chars == CHARS_PER_GROUP) {
+            storeGroup(group, out);
+            out += BYTES_PER_GROUP;
+            group_chars = 0;
+        }
+    }
+
+    // Number of bits of the conversion result including padding must be
+    // a multiple of 8; otherwise the decoder reaches the end of input
+    // with some incomplete bits of data, which is invalid.  (This also
+    // means the input is a sequence of whole groups).
+    if (((char_count * BitsPerChunk) % 8) != 0 || group_chars != 0) {
+        isc_throw(BadValue, "Incomplete input for " << algorithm_
                   << ": " << input);
-    } catch (const dataflow_exception& ex) {
-        // convert any boost exceptions into our local one.
-        isc_throw(BadValue, ex.what());
     }
+    result.resize(out - &result[0]);
 
     // Confirm the original BaseX text is the canonical encoding of the
     // data, that is, that the first byte of padding is indeed 0.
-    // (DecodeNormalizer and binary_from_baseXX ensure that the rest of the
-    // padding is all zero).
+    // (the rest of the padding is all zero as the padding characters
+    // represent all-0 chunks).
     assert(result.size() >= padbytes);
     if (padbytes > 0 && *(result.end() - padbytes) != 0) {
-            isc_throw(BadValue, "Non 0 bits included in " << algorithm
+            isc_throw(BadValue, "Non 0 bits included in " << algorithm_
                       << " padding: " << input);
     }
 
@@ -413,64 +490,64 @@ BaseNTransformer<BitsPerChunk, BaseZeroCode, Encoder, Decoder>::decode(
 //
 // Instantiation for BASE-64
 //
-typedef
-base64_from_binary<transform_width<EncodeNormalizer, 6, 8> > base64_encoder;
-typedef
-transform_width<binary_from_base64<DecodeNormalizer>, 8, 6> base64_decoder;
-typedef BaseNTransformer<6, 'A', base64_encoder, base64_decoder>
-Base64Transformer;
+const BaseNTransformer<6>&
+getBase64Transformer() {
+    static const BaseNTransformer<6> transformer(
+        "base64",
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/",
+        false);
+    return (transformer);
+}
 
 //
 // Instantiation for BASE-32HEX
 //
-typedef
-base32hex_from_binary<transform_width<EncodeNormalizer, 5, 8> >
-base32hex_encoder;
-typedef
-transform_width<binary_from_base32hex<DecodeNormalizer>, 8, 5>
-base32hex_decoder;
-typedef BaseNTransformer<5, '0', base32hex_encoder, base32hex_decoder>
-Base32HexTransformer;
+const BaseNTransformer<5>&
+getBase32HexTransformer() {
+    static const BaseNTransformer<5> transformer(
+        "base32hex", "0123456789ABCDEFGHIJKLMNOPQRSTUV", true);
+    return (transformer);
+}
 
 //
 // Instantiation for BASE-16 (HEX)
 //
-typedef
-base16_from_binary<transform_width<EncodeNormalizer, 4, 8> > base16_encoder;
-typedef
-transform_width<binary_from_base16<DecodeNormalizer>, 8, 4> base16_decoder;
-typedef BaseNTransformer<4, '0', base16_encoder, base16_decoder>
-Base16Transformer;
+const BaseNTransformer<4>&
+getBase16Transformer() {
+    static const BaseNTransformer<4> transformer(
+        "base16", "0123456789ABCDEF", true);
+    return (transformer);
+}
 }
 
 string
 encodeBase64(const vector<uint8_t>& binary) {
-    return (Base64Transformer::encode(binary));
+    return (getBase64Transformer().encode(binary));
 }
 
 void
 decodeBase64(const string& input, vector<uint8_t>& result) {
-    Base64Transformer::decode("base64", input, result);
+    getBase64Transformer().decode(input, result);
 }
 
 string
 encodeBase32Hex(const vector<uint8_t>& binary) {
-    return (Base32HexTransformer::encode(binary));
+    return (getBase32HexTransformer().encode(binary));
 }
 
 void
 decodeBase32Hex(const string& input, vector<uint8_t>& result) {
-    Base32HexTransformer::decode("base32hex", input, result);
+    getBase32HexTransformer().decode(input, result);
 }
 
 string
 encodeHex(const vector<uint8_t>& binary) {
-    return (Base16Transformer::encode(binary));
+    return (getBase16Transformer().encode(binary));
 }
 
 void
 decodeHex(const string& input, vector<uint8_t>& result) {
-    Base16Transformer::decode("base16", input, result);
+    getBase16Transformer().decode(input, result);
 }
 
 } // namespace encode
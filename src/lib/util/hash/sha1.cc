@@ -52,6 +52,25 @@
  */
 #include <util/hash/sha1.h>
 
+#include <cstring>
+
+// The SHA extensions of x86 (SHA-NI) compute four rounds of SHA-1 with a
+// single instruction.  Not all CPUs have them, so the block function using
+// them is compiled for that target only and is used if the CPU supports
+// it, which is checked at runtime.  That requires the target attribute and
+// the SHA intrinsics of GCC 4.9 or clang.
+#if defined(__x86_64__) && \
+    (defined(__clang__) || \
+     (defined(__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SHA1_USE_SHANI 1
+#include <cpuid.h>
+#include <immintrin.h>
+#ifndef bit_SHA
+#define bit_SHA (1 << 29)
+#endif
+#endif
+
 namespace isc {
 namespace util {
 namespace hash {
@@ -79,11 +98,263 @@ SHA_Parity(const uint32_t x, const uint32_t y, const uint32_t z) {
     return ((x) ^ (y) ^ (z));
 }
 
-static inline int
-SHA1CircularShift(uint8_t bits, uint32_t word) {
+namespace {
+inline uint32_t
+rotateLeft(uint32_t word, unsigned int bits) {
     return ((word << bits) | (word >> (32 - bits)));
 }
 
+inline uint32_t
+loadBigEndian(const uint8_t* data) {
+    return ((static_cast<uint32_t>(data[0]) << 24) |
+            (static_cast<uint32_t>(data[1]) << 16) |
+            (static_cast<uint32_t>(data[2]) << 8) |
+            static_cast<uint32_t>(data[3]));
+}
+
+inline void
+storeBigEndian(uint32_t word, uint8_t* data) {
+    data[0] = word >> 24;
+    data[1] = word >> 16;
+    data[2] = word >> 8;
+    data[3] = word;
+}
+
+// Process the given number of consecutive 64-octet blocks into the
+// intermediate hash.  Instead of the 80 words of the message schedule this
+// version only keeps the last 16, and instead of moving the working
+// variables around in each round, it rotates their roles in the arguments
+// of the round macro.
+void
+processBlocksGeneric(uint32_t hash[5], const uint8_t* data, size_t blocks) {
+    /* Constants defined in FIPS-180-2, section 4.2.1 */
+    const uint32_t K0 = 0x5A827999;
+    const uint32_t K1 = 0x6ED9EBA1;
+    const uint32_t K2 = 0x8F1BBCDC;
+    const uint32_t K3 = 0xCA62C1D6;
+
+#define SHA1_W(t) ((t) < 16 ? W[(t)] : \
+                   (W[(t) & 15] = rotateLeft(W[((t) - 3) & 15] ^ \
+                                             W[((t) - 8) & 15] ^ \
+                                             W[((t) - 14) & 15] ^ \
+                                             W[(t) & 15], 1)))
+#define SHA1_ROUND(a, b, c, d, e, f, k, t) \
+    e += rotateLeft(a, 5) + f(b, c, d) + k + SHA1_W(t); \
+    b = rotateLeft(b, 30)
+#define SHA1_5ROUNDS(f, k, t) \
+    SHA1_ROUND(A, B, C, D, E, f, k, (t)); \
+    SHA1_ROUND(E, A, B, C, D, f, k, (t) + 1); \
+    SHA1_ROUND(D, E, A, B, C, f, k, (t) + 2); \
+    SHA1_ROUND(C, D, E, A, B, f, k, (t) + 3); \
+    SHA1_ROUND(B, C, D, E, A, f, k, (t) + 4)
+
+    for (; blocks > 0; --blocks, data += SHA1_BLOCKSIZE) {
+        uint32_t W[16];
+        for (int t = 0; t < 16; ++t) {
+            W[t] = loadBigEndian(data + t * 4);
+        }
+
+        uint32_t A = hash[0];
+        uint32_t B = hash[1];
+        uint32_t C = hash[2];
+        uint32_t D = hash[3];
+        uint32_t E = hash[4];
+
+        SHA1_5ROUNDS(SHA_Ch, K0, 0);
+        SHA1_5ROUNDS(SHA_Ch, K0, 5);
+        SHA1_5ROUNDS(SHA_Ch, K0, 10);
+        SHA1_5ROUNDS(SHA_Ch, K0, 15);
+        SHA1_5ROUNDS(SHA_Parity, K1, 20);
+        SHA1_5ROUNDS(SHA_Parity, K1, 25);
+        SHA1_5ROUNDS(SHA_Parity, K1, 30);
+        SHA1_5ROUNDS(SHA_Parity, K1, 35);
+        SHA1_5ROUNDS(SHA_Maj, K2, 40);
+        SHA1_5ROUNDS(SHA_Maj, K2, 45);
+        SHA1_5ROUNDS(SHA_Maj, K2, 50);
+        SHA1_5ROUNDS(SHA_Maj, K2, 55);
+        SHA1_5ROUNDS(SHA_Parity, K3, 60);
+        SHA1_5ROUNDS(SHA_Parity, K3, 65);
+        SHA1_5ROUNDS(SHA_Parity, K3, 70);
+        SHA1_5ROUNDS(SHA_Parity, K3, 75);
+
+        hash[0] += A;
+        hash[1] += B;
+        hash[2] += C;
+        hash[3] += D;
+        hash[4] += E;
+    }
+
+#undef SHA1_5ROUNDS
+#undef SHA1_ROUND
+#undef SHA1_W
+}
+
+#ifdef SHA1_USE_SHANI
+// The same with the SHA extensions.  Each sha1rnds4 does four rounds (the
+// last argument selects the function and constant of the rounds), sha1nexte
+// computes E for the next four rounds from the current A and adds the
+// message words to it, and sha1msg1/sha1msg2 (and an XOR) compute the next
+// four message words from the previous 16.  The four XMM registers for the
+// message words are used in turn.
+#define SHA1_SHANI_ROUNDS(e_this, e_next, msg, f) \
+    e_this = _mm_sha1nexte_epu32(e_this, msg); \
+    e_next = abcd; \
+    abcd = _mm_sha1rnds4_epu32(abcd, e_this, f)
+
+__attribute__((target("sha,sse4.1,ssse3"))) void
+processBlocksSHANI(uint32_t hash[5], const uint8_t* data, size_t blocks) {
+    // For converting the big endian message words, and the order of the
+    // words in the register.
+    const __m128i byte_swap = _mm_set_epi64x(0x0001020304050607ULL,
+                                             0x08090a0b0c0d0e0fULL);
+
+    __m128i abcd = _mm_shuffle_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(hash)), 0x1b);
+    __m128i e0 = _mm_set_epi32(hash[4], 0, 0, 0);
+    __m128i e1;
+
+    for (; blocks > 0; --blocks, data += SHA1_BLOCKSIZE) {
+        const __m128i abcd_save = abcd;
+        const __m128i e0_save = e0;
+        const __m128i* const words = reinterpret_cast<const __m128i*>(data);
+        __m128i msg0 = _mm_shuffle_epi8(_mm_loadu_si128(words), byte_swap);
+        __m128i msg1 = _mm_shuffle_epi8(_mm_loadu_si128(words + 1),
+                                        byte_swap);
+        __m128i msg2 = _mm_shuffle_epi8(_mm_loadu_si128(words + 2),
+                                        byte_swap);
+        __m128i msg3 = _mm_shuffle_epi8(_mm_loadu_si128(words + 3),
+                                        byte_swap);
+
+        // Rounds 0-3
+        e0 = _mm_add_epi32(e0, msg0);
+        e1 = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+        // Rounds 4-7
+        SHA1_SHANI_ROUNDS(e1, e0, msg1, 0);
+        msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+        // Rounds 8-11
+        SHA1_SHANI_ROUNDS(e0, e1, msg2, 0);
+        msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+        msg0 = _mm_xor_si128(msg0, msg2);
+        // Rounds 12-15
+        SHA1_SHANI_ROUNDS(e1, e0, msg3, 0);
+        msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+        msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+        msg1 = _mm_xor_si128(msg1, msg3);
+        // Rounds 16-19
+        SHA1_SHANI_ROUNDS(e0, e1, msg0, 0);
+        msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+        msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+        msg2 = _mm_xor_si128(msg2, msg0);
+        // Rounds 20-23
+        SHA1_SHANI_ROUNDS(e1, e0, msg1, 1);
+        msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+        msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+        msg3 = _mm_xor_si128(msg3, msg1);
+        // Rounds 24-27
+        SHA1_SHANI_ROUNDS(e0, e1, msg2, 1);
+        msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+        msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+        msg0 = _mm_xor_si128(msg0, msg2);
+        // Rounds 28-31
+        SHA1_SHANI_ROUNDS(e1, e0, msg3, 1);
+        msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+        msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+        msg1 = _mm_xor_si128(msg1, msg3);
+        // Rounds 32-35
+        SHA1_SHANI_ROUNDS(e0, e1, msg0, 1);
+        msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+        msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+        msg2 = _mm_xor_si128(msg2, msg0);
+        // Rounds 36-39
+        SHA1_SHANI_ROUNDS(e1, e0, msg1, 1);
+        msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+        msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+        msg3 = _mm_xor_si128(msg3, msg1);
+        // Rounds 40-43
+        SHA1_SHANI_ROUNDS(e0, e1, msg2, 2);
+        msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+        msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+        msg0 = _mm_xor_si128(msg0, msg2);
+        // Rounds 44-47
+        SHA1_SHANI_ROUNDS(e1, e0, msg3, 2);
+        msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+        msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+        msg1 = _mm_xor_si128(msg1, msg3);
+        // Rounds 48-51
+        SHA1_SHANI_ROUNDS(e0, e1, msg0, 2);
+        msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+        msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+        msg2 = _mm_xor_si128(msg2, msg0);
+        // Rounds 52-55
+        SHA1_SHANI_ROUNDS(e1, e0, msg1, 2);
+        msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+        msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+        msg3 = _mm_xor_si128(msg3, msg1);
+        // Rounds 56-59
+        SHA1_SHANI_ROUNDS(e0, e1, msg2, 2);
+        msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+        msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+        msg0 = _mm_xor_si128(msg0, msg2);
+        // Rounds 60-63
+        SHA1_SHANI_ROUNDS(e1, e0, msg3, 3);
+        msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+        msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+        msg1 = _mm_xor_si128(msg1, msg3);
+        // Rounds 64-67
+        SHA1_SHANI_ROUNDS(e0, e1, msg0, 3);
+        msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+        msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+        msg2 = _mm_xor_si128(msg2, msg0);
+        // Rounds 68-71
+        SHA1_SHANI_ROUNDS(e1, e0, msg1, 3);
+        msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+        msg3 = _mm_xor_si128(msg3, msg1);
+        // Rounds 72-75
+        SHA1_SHANI_ROUNDS(e0, e1, msg2, 3);
+        msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+        // Rounds 76-79
+        SHA1_SHANI_ROUNDS(e1, e0, msg3, 3);
+
+        // Add the result to the intermediate hash
+        e0 = _mm_sha1nexte_epu32(e0, e0_save);
+        abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(hash),
+                     _mm_shuffle_epi32(abcd, 0x1b));
+    hash[4] = _mm_extract_epi32(e0, 3);
+}
+
+#undef SHA1_SHANI_ROUNDS
+#endif
+
+typedef void (*BlockFunction)(uint32_t hash[5], const uint8_t* data,
+                              size_t blocks);
+
+BlockFunction
+selectBlockFunction() {
+#ifdef SHA1_USE_SHANI
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, NULL) >= 7) {
+        __cpuid(1, eax, ebx, ecx, edx);
+        const bool has_sse = (ecx & bit_SSE4_1) != 0 && (ecx & bit_SSSE3) != 0;
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        if (has_sse && (ebx & bit_SHA) != 0) {
+            return (processBlocksSHANI);
+        }
+    }
+#endif
+    return (processBlocksGeneric);
+}
+
+inline void
+processBlocks(uint32_t hash[5], const uint8_t* data, size_t blocks) {
+    static const BlockFunction function = selectBlockFunction();
+    function(hash, data, blocks);
+}
+}
+
 static inline bool
 SHA1AddLength(SHA1Context *context, uint32_t length) {
     uint32_t addTemp = context->Length_Low;
@@ -171,17 +442,41 @@ SHA1Input(SHA1Context *context, const uint8_t *message_array, unsigned length) {
          return (context->Corrupted);
     }
 
-    while(length-- && !context->Corrupted) {
-        context->Message_Block[context->Message_Block_Index++] =
-                                                    (*message_array & 0xFF);
-
-        if (!SHA1AddLength(context, 8) &&
-            (context->Message_Block_Index == SHA1_BLOCKSIZE))
-        {
+    // Add the length in bits of the whole data at once (the message length
+    // is limited to 2^64 bits, so we don't care about overflow).
+    const uint64_t bit_length =
+        ((static_cast<uint64_t>(context->Length_High) << 32) |
+         context->Length_Low) + static_cast<uint64_t>(length) * 8;
+    context->Length_High = bit_length >> 32;
+    context->Length_Low = bit_length & 0xffffffff;
+
+    // Complete the pending block, if any, then process whole blocks
+    // directly from the data, and keep the rest for the next call.
+    if (context->Message_Block_Index > 0) {
+        unsigned int copy_length =
+            SHA1_BLOCKSIZE - context->Message_Block_Index;
+        if (copy_length > length) {
+            copy_length = length;
+        }
+        std::memcpy(context->Message_Block + context->Message_Block_Index,
+                    message_array, copy_length);
+        context->Message_Block_Index += copy_length;
+        message_array += copy_length;
+        length -= copy_length;
+        if (context->Message_Block_Index == SHA1_BLOCKSIZE) {
             SHA1ProcessMessageBlock(context);
         }
-
-        message_array++;
+    }
+    if (length >= SHA1_BLOCKSIZE) {
+        const unsigned int blocks = length / SHA1_BLOCKSIZE;
+        processBlocks(context->Intermediate_Hash, message_array, blocks);
+        message_array += blocks * SHA1_BLOCKSIZE;
+        length -= blocks * SHA1_BLOCKSIZE;
+    }
+    if (length > 0) {
+        std::memcpy(context->Message_Block + context->Message_Block_Index,
+                    message_array, length);
+        context->Message_Block_Index += length;
     }
 
     return (SHA_SUCCESS);
@@ -410,81 +705,82 @@ static void SHA1PadMessage(SHA1Context *context, uint8_t Pad_Byte) {
  */
 static void
 SHA1ProcessMessageBlock(SHA1Context *context) {
-    /* Constants defined in FIPS-180-2, section 4.2.1 */
-    const uint32_t K[] = {
-        0x5A827999,
-        0x6ED9EBA1,
-        0x8F1BBCDC,
-        0xCA62C1D6
-    };
-    int           t;                 /* Loop counter                */
-    uint32_t      temp;              /* Temporary word value        */
-    uint32_t      W[80];             /* Word sequence               */
-    uint32_t      A, B, C, D, E;     /* Word buffers                */
-
-    /*
-     * Initialize the first 16 words in the array W
-     */
-    for (t = 0; t < 16; t++) {
-        W[t]  = ((uint32_t)context->Message_Block[t * 4]) << 24;
-        W[t] |= ((uint32_t)context->Message_Block[t * 4 + 1]) << 16;
-        W[t] |= ((uint32_t)context->Message_Block[t * 4 + 2]) << 8;
-        W[t] |= ((uint32_t)context->Message_Block[t * 4 + 3]);
-    }
-
-    for (t = 16; t < 80; t++) {
-        W[t] = SHA1CircularShift(1, W[t-3] ^ W[t-8] ^ W[t-14] ^ W[t-16]);
-    }
-
-    A = context->Intermediate_Hash[0];
-    B = context->Intermediate_Hash[1];
-    C = context->Intermediate_Hash[2];
-    D = context->Intermediate_Hash[3];
-    E = context->Intermediate_Hash[4];
-
-    for (t = 0; t < 20; t++) {
-        temp = SHA1CircularShift(5,A) + SHA_Ch(B, C, D) + E + W[t] + K[0];
-        E = D;
-        D = C;
-        C = SHA1CircularShift(30,B);
-        B = A;
-        A = temp;
-    }
+    processBlocks(context->Intermediate_Hash, context->Message_Block, 1);
+    context->Message_Block_Index = 0;
+}
 
-    for (t = 20; t < 40; t++) {
-        temp = SHA1CircularShift(5,A) + SHA_Parity(B, C, D) + E + W[t] + K[1];
-        E = D;
-        D = C;
-        C = SHA1CircularShift(30,B);
-        B = A;
-        A = temp;
+/*
+ *  SHA1IteratedHash
+ *
+ *  Description:
+ *      This function computes the iterated and salted hash of RFC 5155
+ *      (NSEC3): the digest of the input followed by the salt, and then
+ *      "iterations" more times that of the previous digest followed by
+ *      the salt.
+ *
+ *  Parameters:
+ *      input: [in]
+ *          The data to hash.
+ *      inlength: [in]
+ *          The length of the input.
+ *      salt: [in]
+ *          The salt (may be NULL if saltlength is 0).
+ *      saltlength: [in]
+ *          The length of the salt.
+ *      iterations: [in]
+ *          The number of additional iterations.
+ *      Message_Digest: [out]
+ *          Where the digest is returned.
+ *
+ *  Comments:
+ *      If the digest and the salt fit in a single block with the padding
+ *      (i.e., the salt is no longer than 35 octets, which is the common
+ *      case), the padded block is built once, and only the digest part of
+ *      it is updated in each iteration, without going through a context.
+ *
+ */
+void
+SHA1IteratedHash(const uint8_t *input, unsigned int inlength,
+                 const uint8_t *salt, unsigned int saltlength,
+                 unsigned int iterations,
+                 uint8_t Message_Digest[SHA1_HASHSIZE])
+{
+    SHA1Context context;
+    SHA1Reset(&context);
+    SHA1Input(&context, input, inlength);
+    SHA1Input(&context, salt, saltlength);
+    SHA1Result(&context, Message_Digest);
+
+    const unsigned int length = SHA1_HASHSIZE + saltlength;
+    if (length + 9 > SHA1_BLOCKSIZE) {
+        for (unsigned int n = 0; n < iterations; ++n) {
+            SHA1Reset(&context);
+            SHA1Input(&context, Message_Digest, SHA1_HASHSIZE);
+            SHA1Input(&context, salt, saltlength);
+            SHA1Result(&context, Message_Digest);
+        }
+        return;
     }
 
-    for (t = 40; t < 60; t++) {
-        temp = SHA1CircularShift(5,A) + SHA_Maj(B, C, D) + E + W[t] + K[2];
-        E = D;
-        D = C;
-        C = SHA1CircularShift(30,B);
-        B = A;
-        A = temp;
+    uint8_t block[SHA1_BLOCKSIZE];
+    std::memcpy(block, Message_Digest, SHA1_HASHSIZE);
+    if (saltlength > 0) {
+        std::memcpy(block + SHA1_HASHSIZE, salt, saltlength);
     }
-
-    for (t = 60; t < 80; t++) {
-        temp = SHA1CircularShift(5,A) + SHA_Parity(B, C, D) + E + W[t] + K[3];
-        E = D;
-        D = C;
-        C = SHA1CircularShift(30,B);
-        B = A;
-        A = temp;
+    block[length] = 0x80;
+    std::memset(block + length + 1, 0, SHA1_BLOCKSIZE - 4 - length - 1);
+    storeBigEndian(length * 8, block + SHA1_BLOCKSIZE - 4);
+
+    for (unsigned int n = 0; n < iterations; ++n) {
+        uint32_t hash[SHA1_HASHSIZE / 4] = {
+            0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+        };
+        processBlocks(hash, block, 1);
+        for (int i = 0; i < SHA1_HASHSIZE / 4; ++i) {
+            storeBigEndian(hash[i], block + i * 4);
+        }
     }
-
-    context->Intermediate_Hash[0] += A;
-    context->Intermediate_Hash[1] += B;
-    context->Intermediate_Hash[2] += C;
-    context->Intermediate_Hash[3] += D;
-    context->Intermediate_Hash[4] += E;
-
-    context->Message_Block_Index = 0;
+    std::memcpy(Message_Digest, block, SHA1_HASHSIZE);
 }
 
 } // namespace hash
@@ -85,6 +85,17 @@ extern int SHA1FinalBits(SHA1Context *, const uint8_t bits,
                          unsigned int bitcount);
 extern int SHA1Result(SHA1Context *, uint8_t Message_Digest[SHA1_HASHSIZE]);
 
+/*
+ *  Compute the iterated and salted hash of RFC 5155 (NSEC3): the digest
+ *  of (input || salt), then "iterations" times that of (the previous
+ *  digest || salt).  With a salt of up to 35 octets each iteration fits
+ *  in a single block, which is hashed directly without a context.
+ */
+extern void SHA1IteratedHash(const uint8_t *input, unsigned int inlength,
+                             const uint8_t *salt, unsigned int saltlength,
+                             unsigned int iterations,
+                             uint8_t Message_Digest[SHA1_HASHSIZE]);
+
 } // namespace hash
 } // namespace util
 } // namespace isc
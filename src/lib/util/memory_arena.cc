@@ -0,0 +1,127 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <util/memory_arena.h>
+
+#include <exceptions/exceptions.h>
+
+#include <functional>
+
+namespace isc {
+namespace util {
+
+namespace {
+// Every allocation is rounded up to a multiple of this, which is large
+// enough for the alignment of any fundamental type on the platforms we
+// support.  The chunks themselves come from operator new and are aligned
+// this way.
+const size_t ALIGNMENT = 2 * sizeof(void*);
+
+size_t
+alignedSize(size_t size) {
+    return ((size + ALIGNMENT - 1) & ~(ALIGNMENT - 1));
+}
+
+// Whether p is in [begin, begin + len).  std::less gives a total order
+// even for pointers to different objects.
+bool
+inRange(const void* p, const uint8_t* begin, size_t len) {
+    const std::less<const void*> less;
+    return (!less(p, begin) && less(p, begin + len));
+}
+}
+
+MemoryArena::MemoryArena(size_t chunk_size) :
+    chunk_size_(alignedSize(chunk_size)), current_(0), used_(0), allocated_(0)
+{}
+
+MemoryArena::~MemoryArena() {
+    releaseLargeBlocks();
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+        ::operator delete(chunks_[i]);
+    }
+}
+
+void*
+MemoryArena::allocate(size_t size) {
+    size = alignedSize(size);
+    if (size > chunk_size_) {
+        // Make sure the block can be recorded before allocating it, so it
+        // won't leak if push_back() throws.
+        large_blocks_.reserve(large_blocks_.size() + 1);
+        uint8_t* block = static_cast<uint8_t*>(::operator new(size));
+        large_blocks_.push_back(std::make_pair(block, size));
+        ++allocated_;
+        return (block);
+    }
+
+    if (chunks_.empty() || used_ + size > chunk_size_) {
+        // Move to the next chunk, allocating it unless it's already there.
+        const size_t next = chunks_.empty() ? 0 : current_ + 1;
+        if (next == chunks_.size()) {
+            chunks_.reserve(chunks_.size() + 1);
+            chunks_.push_back(static_cast<uint8_t*>(
+                                  ::operator new(chunk_size_)));
+        }
+        current_ = next;
+        used_ = 0;
+    }
+    void* p = chunks_[current_] + used_;
+    used_ += size;
+    ++allocated_;
+    return (p);
+}
+
+void
+MemoryArena::reset() {
+    if (allocated_ != 0) {
+        isc_throw(isc::InvalidOperation, "memory arena reset with "
+                  << allocated_ << " allocation(s) still in use");
+    }
+    releaseLargeBlocks();
+    current_ = 0;
+    used_ = 0;
+}
+
+bool
+MemoryArena::contains(const void* p) const {
+    if (!chunks_.empty()) {
+        // Chunks after the current one are unused since the last reset.
+        for (size_t i = 0; i < current_; ++i) {
+            if (inRange(p, chunks_[i], chunk_size_)) {
+                return (true);
+            }
+        }
+        if (inRange(p, chunks_[current_], used_)) {
+            return (true);
+        }
+    }
+    for (size_t i = 0; i < large_blocks_.size(); ++i) {
+        if (inRange(p, large_blocks_[i].first, large_blocks_[i].second)) {
+            return (true);
+        }
+    }
+    return (false);
+}
+
+void
+MemoryArena::releaseLargeBlocks() {
+    for (size_t i = 0; i < large_blocks_.size(); ++i) {
+        ::operator delete(large_blocks_[i].first);
+    }
+    large_blocks_.clear();
+}
+
+} // namespace util
+} // namespace isc
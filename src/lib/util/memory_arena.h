@@ -0,0 +1,212 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef MEMORY_ARENA_H
+#define MEMORY_ARENA_H 1
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+namespace isc {
+namespace util {
+
+/// \brief A region-based memory allocator.
+///
+/// \c MemoryArena hands out memory from large chunks by simply advancing
+/// a pointer.  Memory is never released individually; \c reset() releases
+/// everything allocated from the arena at once.  The chunks themselves are
+/// kept for reuse, so once an arena has grown to fit the typical workload,
+/// allocating from it involves no call to the global \c operator \c new.
+///
+/// This is intended for many small, short-lived objects whose lifetime is
+/// bound to some larger unit of work, such as the objects created for
+/// a single DNS message.  The destructors of the objects are not called
+/// by the arena; the user is responsible for destroying them before
+/// resetting the arena.  To catch objects that outlive the unit of work,
+/// the arena counts allocations that have not been passed back to
+/// \c deallocate(), and \c reset() refuses to run while any remain.
+///
+/// \c ArenaAllocator adapts an arena to the standard allocator interface
+/// so that it can be used with containers and \c boost::allocate_shared().
+/// It shares the ownership of the arena, so the arena is kept as long as
+/// any allocator (and so any container or object allocated by it) exists.
+class MemoryArena : boost::noncopyable {
+public:
+    /// \brief The default size of the chunks of an arena in bytes.
+    static const size_t DEFAULT_CHUNK_SIZE = 4096;
+
+    /// \brief Constructor.
+    ///
+    /// No memory is allocated until the first call to \c allocate().
+    ///
+    /// \param chunk_size The size of each chunk in bytes.  Requests larger
+    /// than this are satisfied by separate blocks.
+    explicit MemoryArena(size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    /// \brief Destructor.  All memory of the arena is released.
+    ~MemoryArena();
+
+    /// \brief Allocate memory from the arena.
+    ///
+    /// The returned memory is suitably aligned for any fundamental type.
+    ///
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param size The size of the memory requested in bytes.
+    /// \return A pointer to the allocated memory.
+    void* allocate(size_t size);
+
+    /// \brief Mark memory allocated from the arena as no longer in use.
+    ///
+    /// The memory itself is not reused until \c reset(); this only
+    /// decrements the count of outstanding allocations.  It must be called
+    /// exactly once for each allocation.
+    ///
+    /// \throw none
+    void deallocate(void*, size_t) {
+        assert(allocated_ > 0);
+        --allocated_;
+    }
+
+    /// \brief Release all memory allocated from the arena.
+    ///
+    /// The chunks are kept for subsequent allocations; only the blocks
+    /// for large requests are returned to the system.
+    ///
+    /// \throw isc::InvalidOperation Some allocations have not been
+    /// deallocated yet.  The arena is left intact in that case.
+    void reset();
+
+    /// \brief Return the number of allocations not yet deallocated.
+    size_t getAllocationCount() const { return (allocated_); }
+
+    /// \brief Return whether the given address is in memory of the arena.
+    ///
+    /// It's true for any address within memory returned by \c allocate()
+    /// since the last \c reset() (and possibly for some other addresses in
+    /// the chunks).  The cost is linear in the number of chunks and large
+    /// blocks.
+    ///
+    /// \throw none
+    bool contains(const void* p) const;
+
+    /// \brief Return the number of chunks the arena currently holds.
+    ///
+    /// This is mainly for tests and statistics.
+    size_t getChunkCount() const { return (chunks_.size()); }
+
+private:
+    void releaseLargeBlocks();
+
+    const size_t chunk_size_;
+    std::vector<uint8_t*> chunks_;
+    std::vector<std::pair<uint8_t*, size_t> > large_blocks_; // with sizes
+    size_t current_;            // index of the chunk in use
+    size_t used_;               // bytes used in the current chunk
+    size_t allocated_;          // allocations not yet deallocated
+};
+
+/// \brief A standard allocator using a \c MemoryArena.
+///
+/// \c deallocate() only updates the allocation count of the arena; the
+/// memory is reclaimed when the arena is reset.  All allocators using the
+/// same arena compare equal.
+///
+/// The allocator holds a shared pointer to the arena.  A container or an
+/// object created by \c boost::allocate_shared() keeps a copy of the
+/// allocator, so the arena can't be destroyed while it still refers to
+/// the memory of the arena.
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind {
+        typedef ArenaAllocator<U> other;
+    };
+
+    /// \brief Constructor.
+    ///
+    /// \param arena The arena to allocate memory from.  Must not be NULL.
+    explicit ArenaAllocator(const boost::shared_ptr<MemoryArena>& arena) :
+        arena_(arena)
+    {
+        assert(arena_);
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) :
+        arena_(other.getArena())
+    {}
+
+    const boost::shared_ptr<MemoryArena>& getArena() const {
+        return (arena_);
+    }
+
+    pointer address(reference x) const { return (&x); }
+    const_pointer address(const_reference x) const { return (&x); }
+
+    pointer allocate(size_type n, const void* = 0) {
+        return (static_cast<pointer>(arena_->allocate(n * sizeof(T))));
+    }
+    void deallocate(pointer p, size_type n) {
+        arena_->deallocate(p, n * sizeof(T));
+    }
+
+    size_type max_size() const {
+        return (static_cast<size_type>(-1) / sizeof(T));
+    }
+
+    void construct(pointer p, const T& val) { new(p) T(val); }
+    void destroy(pointer p) { p->~T(); }
+
+private:
+    boost::shared_ptr<MemoryArena> arena_;
+};
+
+template <typename T, typename U>
+bool
+operator==(const ArenaAllocator<T>& a1, const ArenaAllocator<U>& a2) {
+    return (a1.getArena() == a2.getArena());
+}
+
+template <typename T, typename U>
+bool
+operator!=(const ArenaAllocator<T>& a1, const ArenaAllocator<U>& a2) {
+    return (!(a1 == a2));
+}
+
+} // namespace util
+} // namespace isc
+
+#endif // MEMORY_ARENA_H
+
+// Local Variables:
+// mode: c++
+// End:
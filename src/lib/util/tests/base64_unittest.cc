@@ -88,6 +88,42 @@ TEST_F(Base64Test, decode) {
     EXPECT_THROW(decodeBase64("Zm==", decoded_data), BadValue);
 }
 
+// Longer data is converted in larger blocks (possibly with vector
+// instructions), but the result and error detection should be the same.
+TEST_F(Base64Test, longData) {
+    for (size_t len = 0; len < 100; ++len) {
+        vector<uint8_t> data;
+        for (size_t i = 0; i < len; ++i) {
+            data.push_back((i * 37 + len) & 0xff);
+        }
+        const string encoded = encodeBase64(data);
+        EXPECT_EQ((len + 2) / 3 * 4, encoded.size());
+        decodeBase64(encoded, decoded_data);
+        EXPECT_TRUE(data == decoded_data);
+
+        // Spaces can be anywhere other than between the data and padding
+        string spaced;
+        for (size_t i = 0; i < encoded.size(); ++i) {
+            if (i % 7 == 6 && encoded[i] != '=') {
+                spaced.push_back(' ');
+            }
+            spaced.push_back(encoded[i]);
+        }
+        decodeBase64(spaced, decoded_data);
+        EXPECT_TRUE(data == decoded_data);
+
+        // An invalid character is found wherever it is.
+        for (size_t i = 0; i < encoded.size() && encoded[i] != '='; ++i) {
+            string invalid(encoded);
+            invalid[i] = '.';
+            EXPECT_THROW(decodeBase64(invalid, decoded_data), BadValue);
+        }
+    }
+
+    // But not between the data and padding.
+    EXPECT_THROW(decodeBase64("Zm9vYmE =", decoded_data), BadValue);
+}
+
 TEST_F(Base64Test, encode) {
     for (vector<StringPair>::const_iterator it = test_sequence.begin();
          it != test_sequence.end();
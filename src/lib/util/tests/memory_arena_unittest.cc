@@ -0,0 +1,178 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <util/memory_arena.h>
+
+#include <exceptions/exceptions.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace isc::util;
+
+namespace {
+
+bool
+isAligned(const void* p) {
+    return ((reinterpret_cast<uintptr_t>(p) % (2 * sizeof(void*))) == 0);
+}
+
+TEST(MemoryArenaTest, allocate) {
+    MemoryArena arena(64);
+    EXPECT_EQ(0, arena.getChunkCount());
+
+    // Allocations are aligned and don't overlap.
+    uint8_t* p1 = static_cast<uint8_t*>(arena.allocate(1));
+    uint8_t* p2 = static_cast<uint8_t*>(arena.allocate(3));
+    EXPECT_TRUE(isAligned(p1));
+    EXPECT_TRUE(isAligned(p2));
+    EXPECT_NE(p1, p2);
+    std::memset(p1, 1, 1);
+    std::memset(p2, 2, 3);
+    EXPECT_EQ(1, *p1);
+    EXPECT_EQ(1, arena.getChunkCount());
+
+    // Exhausting the chunk creates a new one.
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(isAligned(arena.allocate(16)));
+    }
+    EXPECT_EQ(2, arena.getChunkCount());
+
+    // Large requests don't use the chunks.
+    void* large = arena.allocate(1000);
+    EXPECT_TRUE(isAligned(large));
+    std::memset(large, 0, 1000);
+    EXPECT_EQ(2, arena.getChunkCount());
+}
+
+TEST(MemoryArenaTest, reset) {
+    MemoryArena arena(64);
+    void* first = arena.allocate(32);
+    void* second = arena.allocate(32);
+    void* third = arena.allocate(64);
+    void* large = arena.allocate(1000);
+    EXPECT_EQ(2, arena.getChunkCount());
+    EXPECT_EQ(4, arena.getAllocationCount());
+
+    // Reset is refused while any of the allocations is in use, and the
+    // arena is left intact.
+    arena.deallocate(first, 32);
+    arena.deallocate(second, 32);
+    arena.deallocate(third, 64);
+    EXPECT_EQ(1, arena.getAllocationCount());
+    EXPECT_THROW(arena.reset(), isc::InvalidOperation);
+    std::memset(large, 0, 1000);
+    EXPECT_EQ(1, arena.getAllocationCount());
+    arena.deallocate(large, 1000);
+    EXPECT_EQ(0, arena.getAllocationCount());
+
+    // After reset the same memory is handed out again, and no new chunk
+    // is needed for the same amount of allocations.
+    arena.reset();
+    EXPECT_EQ(first, arena.allocate(32));
+    arena.allocate(32);
+    arena.allocate(64);
+    EXPECT_EQ(2, arena.getChunkCount());
+}
+
+TEST(MemoryArenaTest, contains) {
+    MemoryArena arena(64);
+    int i;
+    EXPECT_FALSE(arena.contains(&i));
+
+    uint8_t* p1 = static_cast<uint8_t*>(arena.allocate(16));
+    uint8_t* p2 = static_cast<uint8_t*>(arena.allocate(64));
+    uint8_t* large = static_cast<uint8_t*>(arena.allocate(1000));
+    EXPECT_TRUE(arena.contains(p1));
+    EXPECT_TRUE(arena.contains(p1 + 15));
+    EXPECT_TRUE(arena.contains(p2 + 63));
+    EXPECT_FALSE(arena.contains(p2 + 64)); // unused part of the chunk
+    EXPECT_TRUE(arena.contains(large));
+    EXPECT_TRUE(arena.contains(large + 999));
+    EXPECT_FALSE(arena.contains(&i));
+
+    // Nothing is in the arena after reset.
+    arena.deallocate(p1, 16);
+    arena.deallocate(p2, 64);
+    arena.deallocate(large, 1000);
+    arena.reset();
+    EXPECT_FALSE(arena.contains(p1));
+    EXPECT_FALSE(arena.contains(p2));
+    EXPECT_FALSE(arena.contains(large));
+}
+
+TEST(MemoryArenaTest, allocator) {
+    const boost::shared_ptr<MemoryArena> arena_ptr(new MemoryArena);
+    MemoryArena& arena = *arena_ptr;
+
+    // With a standard container.
+    std::vector<int, ArenaAllocator<int> > ints(
+        (ArenaAllocator<int>(arena_ptr)));
+    for (int i = 0; i < 100; ++i) {
+        ints.push_back(i);
+    }
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(i, ints[i]);
+    }
+    // The container gives back all but its current storage.
+    EXPECT_EQ(1, arena.getAllocationCount());
+    std::vector<int, ArenaAllocator<int> >(
+        ArenaAllocator<int>(arena_ptr)).swap(ints);
+    EXPECT_EQ(0, arena.getAllocationCount());
+
+    // With allocate_shared.  The object is destroyed with the last
+    // reference as usual.
+    boost::shared_ptr<std::string> str =
+        boost::allocate_shared<std::string>(
+            ArenaAllocator<std::string>(arena_ptr), "test");
+    EXPECT_EQ("test", *str);
+    EXPECT_EQ(1, arena.getAllocationCount());
+    EXPECT_THROW(arena.reset(), isc::InvalidOperation);
+    str.reset();
+    EXPECT_EQ(0, arena.getAllocationCount());
+    arena.reset();
+
+    // Allocators of the same arena are equal.
+    const boost::shared_ptr<MemoryArena> other_arena(new MemoryArena);
+    EXPECT_TRUE(ArenaAllocator<int>(arena_ptr) ==
+                ArenaAllocator<char>(arena_ptr));
+    EXPECT_TRUE(ArenaAllocator<int>(arena_ptr) !=
+                ArenaAllocator<int>(other_arena));
+}
+
+TEST(MemoryArenaTest, allocatorKeepsArena) {
+    // An object allocated by the allocator keeps the arena alive even if
+    // the original owner releases it.
+    boost::shared_ptr<MemoryArena> arena(new MemoryArena);
+    boost::shared_ptr<std::string> str =
+        boost::allocate_shared<std::string>(
+            ArenaAllocator<std::string>(arena), "test");
+    const boost::weak_ptr<MemoryArena> weak_arena(arena);
+    arena.reset();
+    EXPECT_FALSE(weak_arena.expired());
+    EXPECT_EQ("test", *str);
+
+    // The arena is destroyed with the last object.
+    str.reset();
+    EXPECT_TRUE(weak_arena.expired());
+}
+
+}
@@ -13,6 +13,7 @@
 // PERFORMANCE OF THIS SOFTWARE.
 
 #include <stdint.h>
+#include <cstring>
 #include <string>
 
 #include <util/hash/sha1.h>
@@ -103,6 +104,40 @@ TEST_F(Sha1Test, Test4) {
     }
 }
 
+// Compare SHA1IteratedHash with the straightforward iteration, both with
+// salts fitting in a single block with the digest and longer ones.
+TEST_F(Sha1Test, IteratedHash) {
+    const string input("\x07" "example" "\x03" "com");
+    const string salt("0123456789abcdef0123456789abcdef0123456789");
+    for (size_t salt_len = 0; salt_len <= salt.size(); ++salt_len) {
+        const uint8_t* const salt_data = salt_len == 0 ? NULL :
+            reinterpret_cast<const uint8_t*>(salt.c_str());
+        for (unsigned int iterations = 0; iterations < 5; ++iterations) {
+            SHA1Context sha;
+            uint8_t expected[SHA1_HASHSIZE];
+            SHA1Reset(&sha);
+            SHA1Input(&sha, reinterpret_cast<const uint8_t*>(input.c_str()),
+                      input.size());
+            SHA1Input(&sha, salt_data, salt_len);
+            SHA1Result(&sha, expected);
+            for (unsigned int n = 0; n < iterations; ++n) {
+                SHA1Reset(&sha);
+                SHA1Input(&sha, expected, SHA1_HASHSIZE);
+                SHA1Input(&sha, salt_data, salt_len);
+                SHA1Result(&sha, expected);
+            }
+
+            uint8_t digest[SHA1_HASHSIZE];
+            SHA1IteratedHash(reinterpret_cast<const uint8_t*>(input.c_str()),
+                             input.size(), salt_data, salt_len, iterations,
+                             digest);
+            EXPECT_EQ(0, memcmp(expected, digest, SHA1_HASHSIZE))
+                << "salt length " << salt_len << ", iterations "
+                << iterations;
+        }
+    }
+}
+
 } // namespace hash
 } // namespace util
 } // namespace isc
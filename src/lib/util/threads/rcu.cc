@@ -0,0 +1,143 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <util/threads/rcu.h>
+
+#include <exceptions/exceptions.h>
+
+#include <cstring>
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+namespace isc {
+namespace util {
+namespace thread {
+
+// The grace period detection is the classic "two counters" scheme: readers
+// increment the counter selected by current_ when entering a region, and
+// decrement the same counter when leaving.  The writer flips current_ and
+// waits for the other counter to drain, twice; a reader that read the old
+// index just before the first flip but incremented the counter after the
+// writer checked it is still caught by the second round.
+//
+// Each thread increments and decrements the counters of its own slot, and
+// the writer checks the slots one by one.  That's as good as a single
+// counter: if the writer sees a counter at zero, any reader that
+// increments it later reads the published pointers after that, so it
+// can't see what was unpublished before the check.
+//
+// The atomic builtins used here are full memory barriers, which makes
+// the reader's increment and its subsequent read of exclusive_ (or of
+// a published pointer) pair with the writer's updates followed by its
+// reads of the counters.
+
+namespace {
+// Each thread gets a small number on its first read-side region, which
+// selects its reader slot (in all RCU objects).  It's stored as
+// thread-specific data, plus 1 so that NULL means "not assigned yet".
+pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+pthread_key_t thread_key;
+bool thread_key_created = false;
+volatile unsigned int thread_count = 0;
+
+void
+createThreadKey() {
+    thread_key_created = (pthread_key_create(&thread_key, NULL) == 0);
+}
+
+unsigned int
+getThreadNumber() {
+    void* value = pthread_getspecific(thread_key);
+    if (value == NULL) {
+        value = reinterpret_cast<void*>(static_cast<uintptr_t>(
+            __sync_add_and_fetch(&thread_count, 1)));
+        // If this fails, we'll simply try again next time.
+        pthread_setspecific(thread_key, value);
+    }
+    return (reinterpret_cast<uintptr_t>(value) - 1);
+}
+}
+
+const size_t RCU::NUM_SLOTS;
+const size_t RCU::CACHE_LINE_SIZE;
+
+RCU::RCU() :
+    current_(0), exclusive_(0)
+{
+    pthread_once(&thread_key_once, createThreadKey);
+    if (!thread_key_created) {
+        isc_throw(isc::InvalidOperation,
+                  "Failed to create the thread key for RCU");
+    }
+    std::memset(slots_, 0, sizeof(slots_));
+}
+
+volatile unsigned int*
+RCU::readLock() {
+    ReaderSlot& slot = slots_[getThreadNumber() % NUM_SLOTS];
+    while (true) {
+        volatile unsigned int* counter = &slot.readers[current_ & 1];
+        __sync_fetch_and_add(counter, 1);
+        if (exclusive_ == 0) {
+            return (counter);
+        }
+        // A writer is (about to be) updating the data in place.  Back off
+        // and wait for it by acquiring the mutex it holds.
+        __sync_fetch_and_sub(counter, 1);
+        Mutex::Locker locker(mutex_);
+    }
+}
+
+void
+RCU::waitForReaders() {
+    for (int i = 0; i < 2; ++i) {
+        const unsigned int old = current_ & 1;
+        current_ = old ^ 1;
+        __sync_synchronize();
+        // Read-side regions are short, so we simply yield the processor
+        // until they finish.
+        for (size_t j = 0; j < NUM_SLOTS; ++j) {
+            while (slots_[j].readers[old] != 0) {
+                sched_yield();
+            }
+        }
+    }
+    __sync_synchronize();
+}
+
+void
+RCU::synchronize() {
+    Mutex::Locker locker(mutex_);
+    waitForReaders();
+}
+
+RCU::ExclusiveLocker::ExclusiveLocker(RCU& rcu) :
+    rcu_(rcu), locker_(rcu.mutex_)
+{
+    rcu_.exclusive_ = 1;
+    __sync_synchronize();
+    rcu_.waitForReaders();
+}
+
+RCU::ExclusiveLocker::~ExclusiveLocker() {
+    __sync_synchronize();
+    rcu_.exclusive_ = 0;
+    __sync_synchronize();
+}
+
+} // namespace thread
+} // namespace util
+} // namespace isc
@@ -0,0 +1,181 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef B10_THREAD_RCU_H
+#define B10_THREAD_RCU_H
+
+#include <util/threads/sync.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+
+namespace isc {
+namespace util {
+namespace thread {
+
+/// \brief Read-copy-update style protection of shared data
+///
+/// This class allows many reader threads to get access to some shared data
+/// without taking any lock, while an (infrequent) writer replaces the data.
+/// The writer publishes a new version of the data with \c assign(), then
+/// calls \c synchronize(), which waits until all readers that could still
+/// see the old version have finished (a "grace period").  After that the
+/// old version can be safely destroyed.
+///
+/// Readers mark the region where they get access to the protected data by
+/// a \c ReadLocker object, and get the published pointers in it with
+/// \c dereference().  Entering and leaving the region is a single atomic
+/// operation each, and never blocks unless a writer holds an
+/// \c ExclusiveLocker.  The readers are counted in a number of slots, each
+/// in its own cache line, and a thread always uses the same slot; so as
+/// long as there are not more reader threads than slots, the readers don't
+/// write to any cache line shared with other threads.  The writer scans all
+/// slots instead.
+///
+/// Some updates can't be done by replacing a pointer, e.g. resetting a
+/// memory segment that is mapped in place.  For such updates, the writer
+/// can create an \c ExclusiveLocker; it waits for all current readers to
+/// finish and makes new readers wait until it's destroyed, so it works
+/// just like a traditional lock (and is as expensive for the readers).
+///
+/// The read-side regions must not be nested, and a reader must not call
+/// \c synchronize() or create an \c ExclusiveLocker within its region;
+/// it could wait for itself forever.  The writer side operations
+/// (\c synchronize() and \c ExclusiveLocker) are serialized internally.
+///
+/// The current implementation relies on the GCC atomic builtins (which
+/// are also supported by clang), as we can't assume the availability of
+/// C++11 or Boost atomic operations.
+class RCU : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw std::bad_alloc or isc::InvalidOperation, see \c Mutex.
+    RCU();
+
+    /// \brief Mark a read-side region.
+    ///
+    /// The data protected by the \c RCU object can be used while this
+    /// object is alive.  As it delays writers, it's expected to have a
+    /// short lifetime.
+    class ReadLocker : boost::noncopyable {
+    public:
+        /// \brief Enter the read-side region.
+        ///
+        /// \throw None unless an \c ExclusiveLocker exists, in which case
+        ///     it may throw like \c Mutex::Locker (which is unlikely).
+        ReadLocker(RCU& rcu) :
+            counter_(rcu.readLock())
+        {}
+
+        /// \brief Leave the read-side region.
+        ~ReadLocker() {
+            __sync_fetch_and_sub(counter_, 1);
+        }
+    private:
+        volatile unsigned int* const counter_;
+    };
+
+    /// \brief Block the readers while updating the data in place.
+    ///
+    /// The constructor waits until all current readers leave their regions;
+    /// the readers that try to enter a region while this object exists
+    /// wait until it's destroyed.
+    class ExclusiveLocker : boost::noncopyable {
+    public:
+        /// \brief Wait for the readers and block new ones.
+        ///
+        /// \throw Same as \c Mutex::Locker.
+        ExclusiveLocker(RCU& rcu);
+
+        /// \brief Let the readers in again.
+        ~ExclusiveLocker();
+    private:
+        RCU& rcu_;
+        Mutex::Locker locker_;
+    };
+
+    /// \brief Wait for a grace period.
+    ///
+    /// It returns once all readers that were in their read-side regions at
+    /// the time of the call have left them.  Therefore any data that
+    /// were unpublished before the call are no longer referenced by any
+    /// reader on return.
+    ///
+    /// \throw Same as \c Mutex::Locker.
+    void synchronize();
+
+    /// \brief Get a pointer published by \c assign().
+    ///
+    /// This must be called in a read-side region (or by the writer), and
+    /// the pointed data must not be used outside of the region.
+    template <typename T>
+    static T* dereference(T* const volatile& ptr) {
+        return (ptr);
+    }
+
+    /// \brief Publish a new pointer.
+    ///
+    /// The pointed data must be fully initialized before the call.
+    /// Readers see either the old or the new pointer until the next
+    /// \c synchronize().  Different writers that publish to the same
+    /// pointer must be serialized by the caller.
+    template <typename T>
+    static void assign(T* volatile& ptr, T* value) {
+        __sync_synchronize();   // make the data visible before the pointer
+        ptr = value;
+        __sync_synchronize();
+    }
+
+private:
+    // The number of reader slots, and the size of each (to keep them in
+    // different cache lines).
+    static const size_t NUM_SLOTS = 16;
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    // The reader counters of a slot.  A reader increments one of them and
+    // decrements it when leaving the region.
+    struct ReaderSlot {
+        volatile unsigned int readers[2];
+        char padding[CACHE_LINE_SIZE - 2 * sizeof(unsigned int)];
+    };
+
+    // Return the counter that needs to be decremented when leaving the
+    // region.
+    volatile unsigned int* readLock();
+
+    // Wait until the reader counters drain in all slots.  Must be called
+    // with mutex_ held.
+    void waitForReaders();
+
+    // Serializes the writers, and blocks readers while exclusive_ is set.
+    Mutex mutex_;
+    // The index of the counter new readers increment.
+    volatile unsigned int current_;
+    // Set while an ExclusiveLocker exists.
+    volatile int exclusive_;
+    // The number of readers in their regions, per slot and index.
+    ReaderSlot slots_[NUM_SLOTS];
+};
+
+} // namespace thread
+} // namespace util
+} // namespace isc
+
+#endif
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,125 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <gtest/gtest.h>
+
+#include <util/threads/rcu.h>
+#include <util/threads/thread.h>
+#include <util/unittests/check_valgrind.h>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+using namespace isc::util::thread;
+
+namespace {
+
+const size_t iterations = 10000;
+const size_t num_readers = 2;
+
+// The data protected by the RCU.  A reader must never see it retired.
+struct Data {
+    Data() : alive(true), first(0), second(0) {}
+    volatile bool alive;
+    volatile size_t first;
+    volatile size_t second;
+};
+
+// Without readers, the writer never waits.
+TEST(RCUTest, synchronizeNoReaders) {
+    RCU rcu;
+    rcu.synchronize();
+    rcu.synchronize();
+    {
+        RCU::ReadLocker reader(rcu);
+    }
+    rcu.synchronize();
+    {
+        RCU::ExclusiveLocker writer(rcu);
+    }
+    RCU::ReadLocker reader(rcu);
+}
+
+TEST(RCUTest, assign) {
+    Data data1, data2;
+    Data* volatile ptr = &data1;
+
+    EXPECT_EQ(&data1, RCU::dereference(ptr));
+    RCU::assign(ptr, &data2);
+    EXPECT_EQ(&data2, RCU::dereference(ptr));
+}
+
+void
+performRead(RCU* rcu, Data* volatile* ptr, volatile bool* done,
+            size_t* errors)
+{
+    while (!*done) {
+        RCU::ReadLocker reader(*rcu);
+        const Data* data = RCU::dereference(*ptr);
+        // Keep using the data for a while to give the writer a chance to
+        // break things.
+        for (size_t i = 0; i < 100; ++i) {
+            if (!data->alive || data->first != data->second) {
+                ++*errors;
+            }
+        }
+    }
+}
+
+// Reader threads keep reading the data while we replace it, retire the
+// old versions after the grace period, and update it in place with the
+// exclusive lock held.  The readers must never see a retired or half
+// updated version.  The readers use different reader slots, which the
+// writer has to check.
+TEST(RCUTest, swarm) {
+    if (isc::util::unittests::runningOnValgrind()) {
+        return;
+    }
+
+    RCU rcu;
+    std::vector<Data> versions(iterations + 1);
+    Data* volatile ptr = &versions[0];
+    volatile bool done = false;
+    std::vector<size_t> errors(num_readers);
+
+    std::vector<boost::shared_ptr<Thread> > threads;
+    for (size_t i = 0; i < num_readers; ++i) {
+        threads.push_back(boost::shared_ptr<Thread>(
+            new Thread(boost::bind(&performRead, &rcu, &ptr, &done,
+                                   &errors[i]))));
+    }
+    for (size_t i = 1; i <= iterations; ++i) {
+        Data* old = RCU::dereference(ptr);
+        RCU::assign(ptr, &versions[i]);
+        rcu.synchronize();
+        old->alive = false;
+
+        if (i % 100 == 0) {
+            RCU::ExclusiveLocker writer(rcu);
+            versions[i].first = i;
+            versions[i].second = i;
+        }
+    }
+    done = true;
+    for (size_t i = 0; i < num_readers; ++i) {
+        threads[i]->wait();
+        EXPECT_EQ(0, errors[i]);
+    }
+}
+
+}